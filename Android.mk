@@ -136,7 +136,7 @@ test-art-host: test-art-host-gtest test-art-host-oat test-art-host-run-test
 	@echo test-art-host PASSED
 
 .PHONY: test-art-host-interpreter
-test-art-host-interpreter: test-art-host-oat-interpreter test-art-host-run-test-interpreter
+test-art-host-interpreter: test-art-host-oat-interpreter test-art-host-run-test-interpreter test-art-host-run-test-goto-interpreter
 	@echo test-art-host-interpreter PASSED
 
 .PHONY: test-art-host-dependencies
@@ -183,8 +183,15 @@ test-art-host-run-test-interpreter-$(1): test-art-host-dependencies
 
 TEST_ART_HOST_RUN_TEST_INTERPRETER_TARGETS += test-art-host-run-test-interpreter-$(1)
 
+.PHONY: test-art-host-run-test-goto-interpreter-$(1)
+test-art-host-run-test-goto-interpreter-$(1): test-art-host-dependencies
+	art/test/run-test --host --goto-interpreter $(1)
+	@echo test-art-host-run-test-goto-interpreter-$(1) PASSED
+
+TEST_ART_HOST_RUN_TEST_GOTO_INTERPRETER_TARGETS += test-art-host-run-test-goto-interpreter-$(1)
+
 .PHONY: test-art-host-run-test-$(1)
-test-art-host-run-test-$(1): test-art-host-run-test-default-$(1) test-art-host-run-test-interpreter-$(1)
+test-art-host-run-test-$(1): test-art-host-run-test-default-$(1) test-art-host-run-test-interpreter-$(1) test-art-host-run-test-goto-interpreter-$(1)
 
 endef
 
@@ -198,8 +205,14 @@ test-art-host-run-test-default: $(TEST_ART_HOST_RUN_TEST_DEFAULT_TARGETS)
 test-art-host-run-test-interpreter: $(TEST_ART_HOST_RUN_TEST_INTERPRETER_TARGETS)
 	@echo test-art-host-run-test-interpreter PASSED
 
+# Runs the run-tests through the goto table implementation of the interpreter, which the build
+# does not pick unless ART_USE_GOTO_INTERPRETER is set.
+.PHONY: test-art-host-run-test-goto-interpreter
+test-art-host-run-test-goto-interpreter: $(TEST_ART_HOST_RUN_TEST_GOTO_INTERPRETER_TARGETS)
+	@echo test-art-host-run-test-goto-interpreter PASSED
+
 .PHONY: test-art-host-run-test
-test-art-host-run-test: test-art-host-run-test-default test-art-host-run-test-interpreter
+test-art-host-run-test: test-art-host-run-test-default test-art-host-run-test-interpreter test-art-host-run-test-goto-interpreter
 	@echo test-art-host-run-test PASSED
 
 ########################################################################
@@ -125,6 +125,10 @@ ifeq ($(ART_SEA_IR_MODE),true)
   art_cflags += -DART_SEA_IR_MODE=1
 endif
 
+ifeq ($(ART_USE_GOTO_INTERPRETER),true)
+  art_cflags += -DART_USE_GOTO_INTERPRETER=1
+endif
+
 ifeq ($(HOST_OS),linux)
   art_non_debug_cflags := \
 	-Wframe-larger-than=1728
@@ -17,6 +17,7 @@
 LOCAL_PATH := art
 
 TEST_COMMON_SRC_FILES := \
+	compiler/driver/compilation_cache_test.cc \
 	compiler/driver/compiler_driver_test.cc \
 	compiler/elf_writer_test.cc \
 	compiler/image_test.cc \
@@ -26,6 +27,7 @@ TEST_COMMON_SRC_FILES := \
 	compiler/utils/dedupe_set_test.cc \
 	compiler/utils/arm/managed_register_arm_test.cc \
 	compiler/utils/x86/managed_register_x86_test.cc \
+	runtime/array_copy_test.cc \
 	runtime/barrier_test.cc \
 	runtime/base/histogram_test.cc \
 	runtime/base/mutex_test.cc \
@@ -36,22 +38,30 @@ TEST_COMMON_SRC_FILES := \
 	runtime/base/unix_file/random_access_file_utils_test.cc \
 	runtime/base/unix_file/string_file_test.cc \
 	runtime/class_linker_test.cc \
+	runtime/class_table_test.cc \
 	runtime/dex_file_test.cc \
 	runtime/dex_instruction_visitor_test.cc \
 	runtime/dex_method_iterator_test.cc \
 	runtime/entrypoints/math_entrypoints_test.cc \
 	runtime/exception_test.cc \
+	runtime/gc/accounting/card_table_test.cc \
+	runtime/gc/accounting/mod_union_table_test.cc \
+	runtime/gc/accounting/remembered_set_test.cc \
 	runtime/gc/accounting/space_bitmap_test.cc \
+	runtime/gc/accounting/work_stealing_deque_test.cc \
 	runtime/gc/heap_test.cc \
+	runtime/gc/space/large_object_space_test.cc \
 	runtime/gc/space/space_test.cc \
 	runtime/gtest_test.cc \
 	runtime/indenter_test.cc \
 	runtime/indirect_reference_table_test.cc \
+	runtime/interpreter/interpreter_test.cc \
 	runtime/intern_table_test.cc \
 	runtime/jni_internal_test.cc \
 	runtime/mem_map_test.cc \
 	runtime/mirror/dex_cache_test.cc \
 	runtime/mirror/object_test.cc \
+	runtime/monitor_test.cc \
 	runtime/reference_table_test.cc \
 	runtime/runtime_test.cc \
 	runtime/thread_pool_test.cc \
@@ -57,6 +57,7 @@ LIBART_COMPILER_SRC_FILES := \
 	dex/mir_analysis.cc \
 	dex/vreg_analysis.cc \
 	dex/ssa_transformation.cc \
+	driver/compilation_cache.cc \
 	driver/compiler_driver.cc \
 	driver/dex_compilation_unit.cc \
 	jni/portable/jni_compiler.cc \
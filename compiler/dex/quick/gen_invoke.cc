@@ -1126,6 +1126,26 @@ bool Mir2Lir::GenInlinedStringCompareTo(CallInfo* info) {
   return true;
 }
 
+/*
+ * System.arraycopy straight to the runtime, without the JNI transition. Its five arguments don't
+ * fit in the argument registers, so they're stored in the outs area, which the invoke guarantees
+ * is large enough, and the helper is passed a pointer to them.
+ */
+bool Mir2Lir::GenInlinedArrayCopy(CallInfo* info) {
+  // The helper may throw or suspend for GC, so everything must be in its home location.
+  FlushAllRegs();
+  LockCallTemps();  // Using fixed registers
+  DCHECK_EQ(info->num_arg_words, 5);
+  for (int i = 0; i < info->num_arg_words; i++) {
+    LoadValueDirectFixed(info->args[i], TargetReg(kArg1));
+    StoreBaseDisp(TargetReg(kSp), (i + 1) * 4, TargetReg(kArg1), kWord);
+  }
+  OpRegRegImm(kOpAdd, TargetReg(kArg0), TargetReg(kSp), 4);
+  CallRuntimeHelperReg(QUICK_ENTRYPOINT_OFFSET(pArrayCopy), TargetReg(kArg0), true);
+  FreeCallTemps();
+  return true;
+}
+
 bool Mir2Lir::GenInlinedCurrentThread(CallInfo* info) {
   RegLocation rl_dest = InlineTarget(info);
   RegLocation rl_result = EvalLoc(rl_dest, kCoreReg, true);
@@ -1281,6 +1301,11 @@ bool Mir2Lir::GenIntrinsic(CallInfo* info) {
     if (tgt_method == "int java.lang.String.length()") {
       return GenInlinedStringIsEmptyOrLength(info, false /* is_empty */);
     }
+  } else if (tgt_methods_declaring_class.starts_with("Ljava/lang/System;")) {
+    std::string tgt_method(PrettyMethod(info->index, *cu_->dex_file));
+    if (tgt_method == "void java.lang.System.arraycopy(java.lang.Object, int, java.lang.Object, int, int)") {
+      return GenInlinedArrayCopy(info);
+    }
   } else if (tgt_methods_declaring_class.starts_with("Ljava/lang/Thread;")) {
     std::string tgt_method(PrettyMethod(info->index, *cu_->dex_file));
     if (tgt_method == "java.lang.Thread java.lang.Thread.currentThread()") {
@@ -0,0 +1,645 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compilation_cache.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <vector>
+
+#include "base/stringprintf.h"
+#include "base/unix_file/fd_file.h"
+#include "class_linker.h"
+#include "compiled_method.h"
+#include "dex_instruction.h"
+#include "driver/compiler_driver.h"
+#include "gc/heap.h"
+#include "gc/space/image_space.h"
+#include "leb128.h"
+#include "mirror/art_field-inl.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/dex_cache-inl.h"
+#include "mirror/iftable-inl.h"
+#include "mirror/object_array-inl.h"
+#include "oat.h"
+#include "object_utils.h"
+#include "os.h"
+#include "runtime.h"
+#include "scoped_thread_state_change.h"
+#include "UniquePtr.h"
+#include "utils.h"
+
+namespace art {
+
+static const char kEntryMagic[] = { 'a', 'c', 'c', '\n' };
+// Bump when the key or the entry layout changes.
+static const uint32_t kEntryVersion = 1;
+
+// Marks a reference that didn't resolve, the compiler then emits the slow path.
+static const uint32_t kUnresolved = 0xffffffff;
+
+static void AppendU32(std::string* out, uint32_t value) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void AppendBytes(std::string* out, const void* data, size_t length) {
+  AppendU32(out, length);
+  out->append(reinterpret_cast<const char*>(data), length);
+}
+
+static void AppendString(std::string* out, const char* s) {
+  AppendBytes(out, s, strlen(s));
+}
+
+static void AppendVector(std::string* out, const std::vector<uint8_t>& data) {
+  AppendBytes(out, data.empty() ? NULL : &data[0], data.size());
+}
+
+// FNV-1a, only used to name entries, the whole key is stored in the entry and compared on lookup.
+static uint64_t Hash64(const char* data, size_t length) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < length; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(data[i])) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// Reads back what the Append functions wrote, failing rather than reading past the end.
+class EntryReader {
+ public:
+  EntryReader(const uint8_t* begin, const uint8_t* end) : pos_(begin), end_(end) {}
+
+  bool ReadU32(uint32_t* value) {
+    if (static_cast<size_t>(end_ - pos_) < sizeof(*value)) {
+      return false;
+    }
+    memcpy(value, pos_, sizeof(*value));
+    pos_ += sizeof(*value);
+    return true;
+  }
+
+  bool ReadBytes(const uint8_t** data, uint32_t* length) {
+    if (!ReadU32(length) || static_cast<size_t>(end_ - pos_) < *length) {
+      return false;
+    }
+    *data = pos_;
+    pos_ += *length;
+    return true;
+  }
+
+  bool ReadVector(std::vector<uint8_t>* out) {
+    const uint8_t* data;
+    uint32_t length;
+    if (!ReadBytes(&data, &length)) {
+      return false;
+    }
+    out->assign(data, data + length);
+    return true;
+  }
+
+  bool AtEnd() const {
+    return pos_ == end_;
+  }
+
+ private:
+  const uint8_t* pos_;
+  const uint8_t* const end_;
+};
+
+static InvokeType InvokeTypeOf(Instruction::Code opcode) {
+  switch (opcode) {
+    case Instruction::INVOKE_DIRECT:
+    case Instruction::INVOKE_DIRECT_RANGE:
+      return kDirect;
+    case Instruction::INVOKE_STATIC:
+    case Instruction::INVOKE_STATIC_RANGE:
+      return kStatic;
+    case Instruction::INVOKE_SUPER:
+    case Instruction::INVOKE_SUPER_RANGE:
+      return kSuper;
+    case Instruction::INVOKE_INTERFACE:
+    case Instruction::INVOKE_INTERFACE_RANGE:
+      return kInterface;
+    default:
+      return kVirtual;
+  }
+}
+
+// Finds the class a descriptor resolves to among the loaded classes, without loading, linking or
+// creating anything. Resolution delegates to the boot class path first, whose classes and arrays
+// of them are registered without a loader.
+static mirror::Class* LookupClass(ClassLinker* class_linker, const char* descriptor,
+                                  mirror::ClassLoader* class_loader)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  if (descriptor[0] != '\0' && descriptor[1] == '\0') {
+    return class_linker->FindPrimitiveClass(descriptor[0]);
+  }
+  mirror::Class* klass = class_linker->LookupClass(descriptor, NULL);
+  if (klass == NULL && class_loader != NULL) {
+    klass = class_linker->LookupClass(descriptor, class_loader);
+  }
+  return klass;
+}
+
+// The read-only counterpart of ClassLinker::ResolveType.
+static mirror::Class* LookupType(ClassLinker* class_linker, const DexFile& dex_file,
+                                 uint16_t type_idx, mirror::DexCache* dex_cache,
+                                 mirror::ClassLoader* class_loader)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  mirror::Class* klass = dex_cache->GetResolvedType(type_idx);
+  if (klass == NULL) {
+    klass = LookupClass(class_linker, dex_file.StringByTypeIdx(type_idx), class_loader);
+  }
+  return klass;
+}
+
+// The read-only counterpart of ClassLinker::ResolveField, returns NULL where resolving would
+// throw.
+static mirror::ArtField* LookupField(ClassLinker* class_linker, const DexFile& dex_file,
+                                     uint32_t field_idx, mirror::DexCache* dex_cache,
+                                     mirror::ClassLoader* class_loader, bool is_static)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  mirror::ArtField* resolved = dex_cache->GetResolvedField(field_idx);
+  if (resolved != NULL) {
+    return resolved;
+  }
+  const DexFile::FieldId& field_id = dex_file.GetFieldId(field_idx);
+  mirror::Class* klass = LookupType(class_linker, dex_file, field_id.class_idx_, dex_cache,
+                                    class_loader);
+  if (klass == NULL || !klass->IsResolved()) {
+    return NULL;
+  }
+  if (is_static) {
+    resolved = klass->FindStaticField(dex_cache, field_idx);
+  } else {
+    resolved = klass->FindInstanceField(dex_cache, field_idx);
+  }
+  if (resolved == NULL) {
+    const char* name = dex_file.GetFieldName(field_id);
+    const char* type = dex_file.GetFieldTypeDescriptor(field_id);
+    if (is_static) {
+      resolved = klass->FindStaticField(name, type);
+    } else {
+      resolved = klass->FindInstanceField(name, type);
+    }
+  }
+  return resolved;
+}
+
+// The read-only counterpart of ClassLinker::ResolveMethod, returns NULL where resolving would
+// throw.
+static mirror::ArtMethod* LookupMethod(ClassLinker* class_linker, const DexFile& dex_file,
+                                       uint32_t method_idx, mirror::DexCache* dex_cache,
+                                       mirror::ClassLoader* class_loader, InvokeType type)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  mirror::ArtMethod* resolved = dex_cache->GetResolvedMethod(method_idx);
+  if (resolved != NULL) {
+    return resolved;
+  }
+  const DexFile::MethodId& method_id = dex_file.GetMethodId(method_idx);
+  mirror::Class* klass = LookupType(class_linker, dex_file, method_id.class_idx_, dex_cache,
+                                    class_loader);
+  if (klass == NULL) {
+    // An array class is created on first use, until then its methods are those of
+    // java.lang.Object, provided its element class is there.
+    const char* descriptor = dex_file.StringByTypeIdx(method_id.class_idx_);
+    if (descriptor[0] == '[') {
+      mirror::Class* element_class =
+          LookupClass(class_linker, descriptor + strspn(descriptor, "["), class_loader);
+      if (element_class != NULL && element_class->IsResolved()) {
+        klass = LookupClass(class_linker, "Ljava/lang/Object;", NULL);
+      }
+    }
+  }
+  if (klass == NULL || !klass->IsResolved()) {
+    return NULL;
+  }
+  switch (type) {
+    case kDirect:  // Fall-through.
+    case kStatic:
+      resolved = klass->FindDirectMethod(dex_cache, method_idx);
+      break;
+    case kInterface:
+      resolved = klass->FindInterfaceMethod(dex_cache, method_idx);
+      break;
+    case kSuper:  // Fall-through.
+    case kVirtual:
+      resolved = klass->FindVirtualMethod(dex_cache, method_idx);
+      break;
+    default:
+      LOG(FATAL) << "Unreachable - invocation type: " << type;
+  }
+  if (resolved == NULL) {
+    const char* name = dex_file.StringDataByIdx(method_id.name_idx_);
+    std::string signature(dex_file.CreateMethodSignature(method_id.proto_idx_, NULL));
+    switch (type) {
+      case kDirect:  // Fall-through.
+      case kStatic:
+        resolved = klass->FindDirectMethod(name, signature);
+        break;
+      case kInterface:
+        resolved = klass->FindInterfaceMethod(name, signature);
+        break;
+      case kSuper:  // Fall-through.
+      case kVirtual:
+        resolved = klass->FindVirtualMethod(name, signature);
+        break;
+    }
+  }
+  if (resolved != NULL && resolved->CheckIncompatibleClassChange(type)) {
+    resolved = NULL;
+  }
+  return resolved;
+}
+
+CompilationCache* CompilationCache::Create(const CompilerDriver& driver,
+                                           const std::string& directory) {
+  if (driver.GetCompilerBackend() != kQuick || driver.IsImage()) {
+    LOG(WARNING) << "Not using compilation cache " << directory
+                 << ", only quick compiles of apps are cached";
+    return NULL;
+  }
+  if (!OS::DirectoryExists(directory.c_str())) {
+    LOG(WARNING) << "Not using compilation cache " << directory << ", it isn't a directory";
+    return NULL;
+  }
+  // Code for an app calls straight into the boot image, so it is only valid with the boot image
+  // it was compiled against. The checksum also changes with any change to the compiler that
+  // affects the boot image's code.
+  Runtime* runtime = Runtime::Current();
+  gc::space::ImageSpace* image_space = runtime->GetHeap()->GetImageSpace();
+  CHECK(image_space != NULL);
+  std::string configuration(kEntryMagic, sizeof(kEntryMagic));
+  AppendU32(&configuration, kEntryVersion);
+  AppendBytes(&configuration, OatHeader::kOatVersion, sizeof(OatHeader::kOatVersion));
+  AppendU32(&configuration, image_space->GetImageHeader().GetOatChecksum());
+  AppendU32(&configuration, driver.GetInstructionSet());
+  AppendU32(&configuration, driver.GetSupportBootImageFixup());
+  AppendU32(&configuration, runtime->GetCompilerFilter());
+  AppendU32(&configuration, runtime->GetHugeMethodThreshold());
+  AppendU32(&configuration, runtime->GetLargeMethodThreshold());
+  AppendU32(&configuration, runtime->GetSmallMethodThreshold());
+  AppendU32(&configuration, runtime->GetTinyMethodThreshold());
+  AppendU32(&configuration, runtime->GetNumDexMethodsThreshold());
+  return new CompilationCache(directory, configuration);
+}
+
+CompilationCache::CompilationCache(const std::string& directory, const std::string& configuration)
+    : directory_(directory),
+      configuration_(configuration),
+      digest_lock_("compilation cache digest lock") {
+}
+
+void CompilationCache::ComputeKey(CompilerDriver& driver, const DexFile::CodeItem* code_item,
+                                  uint32_t access_flags, InvokeType invoke_type,
+                                  uint16_t class_def_idx, uint32_t method_idx,
+                                  jobject class_loader, const DexFile& dex_file,
+                                  std::string* key) {
+  key->assign(configuration_);
+  Thread* self = Thread::Current();
+  AppendU32(key, access_flags);
+  AppendU32(key, invoke_type);
+  AppendU32(key, method_idx);
+  AppendU32(key, driver.RequiresConstructorBarrier(self, &dex_file, class_def_idx));
+
+  // The code item without its debug info offset, which moves whenever anything before it in the
+  // dex file changes and doesn't affect the code.
+  AppendU32(key, code_item->registers_size_);
+  AppendU32(key, code_item->ins_size_);
+  AppendU32(key, code_item->outs_size_);
+  AppendU32(key, code_item->tries_size_);
+  const uint8_t* code_begin = reinterpret_cast<const uint8_t*>(code_item->insns_);
+  const uint8_t* code_end =
+      reinterpret_cast<const uint8_t*>(code_item->insns_ + code_item->insns_size_in_code_units_);
+  std::vector<uint16_t> catch_types;
+  if (code_item->tries_size_ != 0) {
+    const uint8_t* handlers = DexFile::GetCatchHandlerData(*code_item, 0);
+    uint32_t handlers_size = DecodeUnsignedLeb128(&handlers);
+    for (uint32_t i = 0; i < handlers_size; ++i) {
+      CatchHandlerIterator iterator(handlers);
+      for (; iterator.HasNext(); iterator.Next()) {
+        catch_types.push_back(iterator.GetHandlerTypeIndex());
+      }
+      handlers = iterator.EndDataPointer();
+    }
+    code_end = handlers;
+  }
+  AppendBytes(key, code_begin, code_end - code_begin);
+
+  ScopedObjectAccess soa(self);
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  mirror::DexCache* dex_cache = class_linker->FindDexCache(dex_file);
+  mirror::ClassLoader* loader = soa.Decode<mirror::ClassLoader*>(class_loader);
+
+  // What the method's own class, signature and catch types resolve to determine the types the
+  // verifier inferred, which the compiler uses to devirtualize calls and drop casts.
+  const DexFile::MethodId& method_id = dex_file.GetMethodId(method_idx);
+  AddType(dex_file, method_id.class_idx_, dex_cache, loader, key);
+  AddProto(dex_file, method_id.proto_idx_, dex_cache, loader, key);
+  for (size_t i = 0; i < catch_types.size(); ++i) {
+    if (catch_types[i] != DexFile::kDexNoIndex16) {
+      AddType(dex_file, catch_types[i], dex_cache, loader, key);
+    }
+  }
+
+  // Everything the instructions refer to. Static field accesses keep the field index in vB,
+  // instance ones in vC.
+  const Instruction* inst = Instruction::At(code_item->insns_);
+  const Instruction* end =
+      Instruction::At(code_item->insns_ + code_item->insns_size_in_code_units_);
+  for (; inst < end; inst = inst->Next()) {
+    switch (inst->GetVerifyTypeArgumentB()) {
+      case Instruction::kVerifyRegBField: {
+        const DexFile::FieldId& field_id = dex_file.GetFieldId(inst->VRegB());
+        AddType(dex_file, field_id.class_idx_, dex_cache, loader, key);
+        mirror::ArtField* field =
+            LookupField(class_linker, dex_file, inst->VRegB(), dex_cache, loader, true);
+        AddField(dex_file, field, key);
+        break;
+      }
+      case Instruction::kVerifyRegBMethod: {
+        const DexFile::MethodId& callee_id = dex_file.GetMethodId(inst->VRegB());
+        AddType(dex_file, callee_id.class_idx_, dex_cache, loader, key);
+        AddProto(dex_file, callee_id.proto_idx_, dex_cache, loader, key);
+        mirror::ArtMethod* method =
+            LookupMethod(class_linker, dex_file, inst->VRegB(), dex_cache, loader,
+                         InvokeTypeOf(inst->Opcode()));
+        AddMethod(method, key);
+        break;
+      }
+      case Instruction::kVerifyRegBNewInstance:
+      case Instruction::kVerifyRegBType:
+        AddType(dex_file, inst->VRegB(), dex_cache, loader, key);
+        break;
+      default:
+        break;
+    }
+    switch (inst->GetVerifyTypeArgumentC()) {
+      case Instruction::kVerifyRegCField: {
+        const DexFile::FieldId& field_id = dex_file.GetFieldId(inst->VRegC());
+        AddType(dex_file, field_id.class_idx_, dex_cache, loader, key);
+        mirror::ArtField* field =
+            LookupField(class_linker, dex_file, inst->VRegC(), dex_cache, loader, false);
+        AddField(dex_file, field, key);
+        break;
+      }
+      case Instruction::kVerifyRegCNewArray:
+      case Instruction::kVerifyRegCType:
+        AddType(dex_file, inst->VRegC(), dex_cache, loader, key);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+void CompilationCache::AddType(const DexFile& dex_file, uint16_t type_idx,
+                               mirror::DexCache* dex_cache, mirror::ClassLoader* class_loader,
+                               std::string* key) {
+  const char* descriptor = dex_file.StringByTypeIdx(type_idx);
+  AppendString(key, descriptor);
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  mirror::Class* klass;
+  if (descriptor[0] == '[') {
+    // An array class only depends on its element class, which is added instead so that the key
+    // doesn't change with whether something created the array class already.
+    klass = LookupClass(class_linker, descriptor + strspn(descriptor, "["), class_loader);
+  } else {
+    klass = LookupType(class_linker, dex_file, type_idx, dex_cache, class_loader);
+  }
+  if (klass == NULL) {
+    AppendU32(key, kUnresolved);
+    return;
+  }
+  AddClass(klass, key);
+}
+
+void CompilationCache::AddProto(const DexFile& dex_file, uint16_t proto_idx,
+                                mirror::DexCache* dex_cache, mirror::ClassLoader* class_loader,
+                                std::string* key) {
+  const DexFile::ProtoId& proto_id = dex_file.GetProtoId(proto_idx);
+  AddType(dex_file, proto_id.return_type_idx_, dex_cache, class_loader, key);
+  const DexFile::TypeList* parameters = dex_file.GetProtoParameters(proto_id);
+  if (parameters != NULL) {
+    for (size_t i = 0; i < parameters->Size(); ++i) {
+      AddType(dex_file, parameters->GetTypeItem(i).type_idx_, dex_cache, class_loader, key);
+    }
+  }
+}
+
+void CompilationCache::AddClass(mirror::Class* klass, std::string* key) {
+  AppendU32(key, klass->GetStatus());
+  uint64_t digest;
+  if (!klass->IsResolved()) {
+    // Still being loaded, or erroneous, so don't remember anything about it.
+    digest = ComputeClassDigest(klass);
+  } else {
+    Thread* self = Thread::Current();
+    {
+      MutexLock mu(self, digest_lock_);
+      SafeMap<const mirror::Class*, uint64_t>::const_iterator it = class_digests_.find(klass);
+      if (it != class_digests_.end()) {
+        AppendBytes(key, &it->second, sizeof(it->second));
+        return;
+      }
+    }
+    digest = ComputeClassDigest(klass);
+    MutexLock mu(self, digest_lock_);
+    class_digests_.Overwrite(klass, digest);
+  }
+  AppendBytes(key, &digest, sizeof(digest));
+}
+
+// Summarizes the parts of a class that compiled code can depend on: its hierarchy, size and the
+// layout of its vtable, which sharpened and devirtualized calls index.
+uint64_t CompilationCache::ComputeClassDigest(mirror::Class* klass) {
+  std::string layout;
+  AppendString(&layout, ClassHelper(klass).GetDescriptor());
+  AppendU32(&layout, klass->GetAccessFlags());
+  AppendU32(&layout, klass->GetClassLoader() == NULL);
+  AppendU32(&layout, klass->IsVariableSize() ? 0 : klass->GetObjectSize());
+  for (mirror::Class* super = klass->GetSuperClass(); super != NULL;
+       super = super->GetSuperClass()) {
+    AppendString(&layout, ClassHelper(super).GetDescriptor());
+  }
+  if (klass->GetIfTable() != NULL) {
+    for (int32_t i = 0; i < klass->GetIfTableCount(); ++i) {
+      AppendString(&layout, ClassHelper(klass->GetIfTable()->GetInterface(i)).GetDescriptor());
+    }
+  }
+  mirror::ObjectArray<mirror::ArtMethod>* vtable = klass->GetVTable();
+  if (vtable != NULL) {
+    for (int32_t i = 0; i < vtable->GetLength(); ++i) {
+      mirror::ArtMethod* method = vtable->Get(i);
+      AppendString(&layout, MethodHelper(method).GetDeclaringClassDescriptor());
+      AppendU32(&layout, method->GetDexMethodIndex());
+      AppendU32(&layout, method->GetAccessFlags());
+    }
+  }
+  return Hash64(layout.data(), layout.size());
+}
+
+void CompilationCache::AddField(const DexFile& dex_file, mirror::ArtField* field,
+                                std::string* key) {
+  if (field == NULL) {
+    AppendU32(key, kUnresolved);
+    return;
+  }
+  mirror::Class* declaring_class = field->GetDeclaringClass();
+  AddClass(declaring_class, key);
+  AppendU32(key, field->GetOffset().Uint32Value());
+  AppendU32(key, field->GetAccessFlags());
+  // Static fields are reached through the storage base of the declaring class, which is indexed
+  // by the class's type index in the referring dex file.
+  AppendU32(key, declaring_class->GetDexTypeIndex());
+  AppendU32(key, declaring_class->GetDexCache()->GetDexFile() == &dex_file);
+  uint32_t local_type_idx = kUnresolved;
+  const DexFile::StringId* string_id =
+      dex_file.FindStringId(FieldHelper(field).GetDeclaringClassDescriptor());
+  if (string_id != NULL) {
+    const DexFile::TypeId* type_id = dex_file.FindTypeId(dex_file.GetIndexForStringId(*string_id));
+    if (type_id != NULL) {
+      local_type_idx = dex_file.GetIndexForTypeId(*type_id);
+    }
+  }
+  AppendU32(key, local_type_idx);
+}
+
+void CompilationCache::AddMethod(mirror::ArtMethod* method, std::string* key) {
+  if (method == NULL) {
+    AppendU32(key, kUnresolved);
+    return;
+  }
+  mirror::Class* declaring_class = method->GetDeclaringClass();
+  AddClass(declaring_class, key);
+  AppendU32(key, method->GetDexMethodIndex());
+  AppendU32(key, method->GetMethodIndex());
+  AppendU32(key, method->GetAccessFlags());
+  if (declaring_class->GetClassLoader() == NULL) {
+    // Calls into the boot class path may branch straight to the method's code.
+    AppendU32(key, reinterpret_cast<uintptr_t>(method));
+    AppendU32(key, reinterpret_cast<uintptr_t>(method->GetEntryPointFromCompiledCode()));
+  }
+}
+
+std::string CompilationCache::GetEntryPath(const std::string& key) const {
+  uint64_t hash = Hash64(key.data(), key.size());
+  return StringPrintf("%s/%08x%08x", directory_.c_str(), static_cast<uint32_t>(hash >> 32),
+                      static_cast<uint32_t>(hash));
+}
+
+CompiledMethod* CompilationCache::Lookup(CompilerDriver& driver, const std::string& key) {
+  UniquePtr<File> file(OS::OpenFileForReading(GetEntryPath(key).c_str()));
+  if (file.get() == NULL) {
+    misses_++;
+    return NULL;
+  }
+  int64_t length = file->GetLength();
+  std::vector<uint8_t> data(length > 0 ? length : 0);
+  if (data.size() < sizeof(uint32_t) || !file->ReadFully(&data[0], data.size())) {
+    misses_++;
+    return NULL;
+  }
+  // The checksum catches entries left half written by a crash, renaming them into place is
+  // otherwise atomic.
+  size_t body_length = data.size() - sizeof(uint32_t);
+  uint32_t checksum;
+  memcpy(&checksum, &data[body_length], sizeof(checksum));
+  if (checksum != adler32(adler32(0L, Z_NULL, 0), &data[0], body_length)) {
+    LOG(WARNING) << "Ignoring corrupt compilation cache entry " << file->GetPath();
+    misses_++;
+    return NULL;
+  }
+  EntryReader reader(&data[0], &data[body_length]);
+  const uint8_t* stored_key;
+  uint32_t stored_key_length;
+  uint32_t frame_size_in_bytes;
+  uint32_t core_spill_mask;
+  uint32_t fp_spill_mask;
+  std::vector<uint8_t> code;
+  std::vector<uint8_t> mapping_table;
+  std::vector<uint8_t> vmap_table;
+  std::vector<uint8_t> gc_map;
+  if (!reader.ReadBytes(&stored_key, &stored_key_length) ||
+      stored_key_length != key.size() || memcmp(stored_key, key.data(), key.size()) != 0 ||
+      !reader.ReadU32(&frame_size_in_bytes) ||
+      !reader.ReadU32(&core_spill_mask) ||
+      !reader.ReadU32(&fp_spill_mask) ||
+      !reader.ReadVector(&code) ||
+      !reader.ReadVector(&mapping_table) ||
+      !reader.ReadVector(&vmap_table) ||
+      !reader.ReadVector(&gc_map) ||
+      !reader.AtEnd()) {
+    misses_++;
+    return NULL;
+  }
+  hits_++;
+  return new CompiledMethod(driver, driver.GetInstructionSet(), code, frame_size_in_bytes,
+                            core_spill_mask, fp_spill_mask, mapping_table, vmap_table, gc_map);
+}
+
+void CompilationCache::Store(const std::string& key, const CompiledMethod& compiled_method) {
+  std::string entry;
+  AppendBytes(&entry, key.data(), key.size());
+  AppendU32(&entry, compiled_method.GetFrameSizeInBytes());
+  AppendU32(&entry, compiled_method.GetCoreSpillMask());
+  AppendU32(&entry, compiled_method.GetFpSpillMask());
+  AppendVector(&entry, compiled_method.GetCode());
+  AppendVector(&entry, compiled_method.GetMappingTable());
+  AppendVector(&entry, compiled_method.GetVmapTable());
+  AppendVector(&entry, compiled_method.GetGcMap());
+  AppendU32(&entry, adler32(adler32(0L, Z_NULL, 0),
+                            reinterpret_cast<const Bytef*>(entry.data()), entry.size()));
+
+  // Write to a name no other thread or process uses and rename it into place, so that readers
+  // only ever see complete entries. Racing writers of one key write the same entry.
+  std::string path(GetEntryPath(key));
+  std::string temp_path(StringPrintf("%s.%d.%d.tmp", path.c_str(), getpid(), GetTid()));
+  UniquePtr<File> file(OS::OpenFileWithFlags(temp_path.c_str(), O_WRONLY | O_CREAT | O_EXCL));
+  if (file.get() == NULL) {
+    PLOG(WARNING) << "Failed to create " << temp_path;
+    failed_stores_++;
+    return;
+  }
+  bool written = file->WriteFully(entry.data(), entry.size());
+  written = (file->Close() == 0) && written;
+  if (!written || rename(temp_path.c_str(), path.c_str()) != 0) {
+    PLOG(WARNING) << "Failed to write compilation cache entry " << path;
+    unlink(temp_path.c_str());
+    failed_stores_++;
+    return;
+  }
+  stores_++;
+}
+
+void CompilationCache::Dump(std::ostream& os) const {
+  int32_t hits = hits_;
+  int32_t misses = misses_;
+  int32_t lookups = hits + misses;
+  os << "Compilation cache " << directory_ << ": " << hits << " hits, " << misses << " misses ("
+     << (lookups == 0 ? 0 : static_cast<int64_t>(hits) * 100 / lookups) << "% hit rate), "
+     << stores_ << " stores";
+  if (failed_stores_ != 0) {
+    os << ", " << failed_stores_ << " failed stores";
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_DRIVER_COMPILATION_CACHE_H_
+#define ART_COMPILER_DRIVER_COMPILATION_CACHE_H_
+
+#include <ostream>
+#include <string>
+
+#include "atomic_integer.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "dex_file.h"
+#include "invoke_type.h"
+#include "jni.h"
+#include "safe_map.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtField;
+  class ArtMethod;
+  class Class;
+  class ClassLoader;
+  class DexCache;
+}  // namespace mirror
+class CompiledMethod;
+class CompilerDriver;
+
+// A directory of methods compiled by earlier dex2oat runs, so that recompiling an app that has
+// mostly stayed the same only runs the backend on the methods that changed.
+//
+// An entry is keyed by everything its code was derived from: the code item, what each class,
+// field and method it refers to resolves to, and the compiler configuration. The resolution part
+// covers the class hierarchy, field offsets, vtable layouts and boot image addresses that the
+// backend bakes into the code. Entries are written to a temporary file and renamed into place,
+// so any number of dex2oat processes may share a directory.
+//
+// Keys are computed from the classes already loaded and never resolve anything, as filling the
+// dex caches would change the fast paths the backend picks for the methods compiled afterwards.
+// The app's classes are all loaded by then, so a class that isn't loaded yet comes from the boot
+// class path, which the boot image checksum in every key covers.
+class CompilationCache {
+ public:
+  // Returns NULL if the cache can't be used with the driver's configuration. Only quick code for
+  // apps is cached, an image compile also records patches for the image writer that an entry
+  // can't replay.
+  static CompilationCache* Create(const CompilerDriver& driver, const std::string& directory);
+
+  // Computes the key of a method from what the classes, fields and methods it refers to would
+  // resolve to.
+  void ComputeKey(CompilerDriver& driver, const DexFile::CodeItem* code_item,
+                  uint32_t access_flags, InvokeType invoke_type, uint16_t class_def_idx,
+                  uint32_t method_idx, jobject class_loader, const DexFile& dex_file,
+                  std::string* key)
+      LOCKS_EXCLUDED(Locks::mutator_lock_, digest_lock_);
+
+  // Returns the method stored under key, or NULL if there isn't one.
+  CompiledMethod* Lookup(CompilerDriver& driver, const std::string& key);
+
+  void Store(const std::string& key, const CompiledMethod& compiled_method);
+
+  void Dump(std::ostream& os) const;
+
+ private:
+  CompilationCache(const std::string& directory, const std::string& configuration);
+
+  void AddType(const DexFile& dex_file, uint16_t type_idx, mirror::DexCache* dex_cache,
+               mirror::ClassLoader* class_loader, std::string* key)
+      LOCKS_EXCLUDED(digest_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void AddProto(const DexFile& dex_file, uint16_t proto_idx, mirror::DexCache* dex_cache,
+                mirror::ClassLoader* class_loader, std::string* key)
+      LOCKS_EXCLUDED(digest_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void AddClass(mirror::Class* klass, std::string* key)
+      LOCKS_EXCLUDED(digest_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  uint64_t ComputeClassDigest(mirror::Class* klass)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void AddField(const DexFile& dex_file, mirror::ArtField* field, std::string* key)
+      LOCKS_EXCLUDED(digest_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void AddMethod(mirror::ArtMethod* method, std::string* key)
+      LOCKS_EXCLUDED(digest_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  std::string GetEntryPath(const std::string& key) const;
+
+  const std::string directory_;
+
+  // The compiler options, target and boot image every key starts with.
+  const std::string configuration_;
+
+  // Digests of the layout of linked classes, which doesn't change for the rest of the run.
+  Mutex digest_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  SafeMap<const mirror::Class*, uint64_t> class_digests_ GUARDED_BY(digest_lock_);
+
+  AtomicInteger hits_;
+  AtomicInteger misses_;
+  AtomicInteger stores_;
+  AtomicInteger failed_stores_;
+
+  friend class CompilationCacheTest;
+  DISALLOW_COPY_AND_ASSIGN(CompilationCache);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_DRIVER_COMPILATION_CACHE_H_
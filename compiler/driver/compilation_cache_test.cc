@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "driver/compilation_cache.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "class_linker.h"
+#include "common_test.h"
+#include "compiled_method.h"
+#include "driver/compiler_driver.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/dex_cache-inl.h"
+#include "object_utils.h"
+#include "scoped_thread_state_change.h"
+#include "UniquePtr.h"
+
+namespace art {
+
+// The classes of the CompilationCache test dex files, which the driver's resolve phase would have
+// loaded before the first key is computed.
+static const char* const kClassDescriptors[] = {
+  "LCompilationCache;", "LData;", "LBase1;", "LBase2;", "LSub;", "LSame;",
+};
+
+class CompilationCacheTest : public CommonTest {
+ protected:
+  virtual void SetUp() {
+    CommonTest::SetUp();
+    cache_directory_ = android_data_ + "/compilation-cache";
+    ASSERT_EQ(0, mkdir(cache_directory_.c_str(), 0700));
+  }
+
+  virtual void TearDown() {
+    std::vector<std::string> entries(ListCacheDirectory());
+    for (size_t i = 0; i < entries.size(); ++i) {
+      ASSERT_EQ(0, unlink((cache_directory_ + "/" + entries[i]).c_str()));
+    }
+    ASSERT_EQ(0, rmdir(cache_directory_.c_str()));
+    CommonTest::TearDown();
+  }
+
+  std::vector<std::string> ListCacheDirectory() {
+    std::vector<std::string> entries;
+    DIR* dir = opendir(cache_directory_.c_str());
+    CHECK(dir != NULL);
+    dirent* e;
+    while ((e = readdir(dir)) != NULL) {
+      if (strcmp(e->d_name, ".") != 0 && strcmp(e->d_name, "..") != 0) {
+        entries.push_back(e->d_name);
+      }
+    }
+    closedir(dir);
+    return entries;
+  }
+
+  CompilationCache* CreateCache() {
+    return new CompilationCache(cache_directory_, "test configuration");
+  }
+
+  jobject LoadClasses(const char* dex_name) LOCKS_EXCLUDED(Locks::mutator_lock_) {
+    ScopedObjectAccess soa(Thread::Current());
+    jobject class_loader = LoadDex(dex_name);
+    mirror::ClassLoader* loader = soa.Decode<mirror::ClassLoader*>(class_loader);
+    for (size_t i = 0; i < arraysize(kClassDescriptors); ++i) {
+      mirror::Class* klass = class_linker_->FindClass(kClassDescriptors[i], loader);
+      CHECK(klass != NULL) << kClassDescriptors[i];
+    }
+    return class_loader;
+  }
+
+  mirror::ArtMethod* FindMethod(jobject class_loader, const char* name)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    ScopedObjectAccessUnchecked soa(Thread::Current());
+    mirror::Class* klass = class_linker_->FindClass("LCompilationCache;",
+                                                    soa.Decode<mirror::ClassLoader*>(class_loader));
+    CHECK(klass != NULL);
+    std::string signature(StringPrintf("(L%s;)I", name + strlen("read")));
+    mirror::ArtMethod* method = klass->FindDirectMethod(name, signature);
+    CHECK(method != NULL) << name << signature;
+    return method;
+  }
+
+  // Returns the key of CompilationCache.<name>, whose only argument is of the type named after it.
+  std::string ComputeKey(CompilationCache* cache, jobject class_loader, const char* name)
+      LOCKS_EXCLUDED(Locks::mutator_lock_) {
+    const DexFile* dex_file;
+    const DexFile::CodeItem* code_item;
+    uint32_t access_flags;
+    uint16_t class_def_idx;
+    uint32_t method_idx;
+    {
+      ScopedObjectAccess soa(Thread::Current());
+      mirror::ArtMethod* method = FindMethod(class_loader, name);
+      MethodHelper mh(method);
+      dex_file = &mh.GetDexFile();
+      code_item = mh.GetCodeItem();
+      access_flags = method->GetAccessFlags() & kAccJavaFlagsMask;
+      class_def_idx = mh.GetClassDefIndex();
+      method_idx = method->GetDexMethodIndex();
+    }
+    std::string key;
+    cache->ComputeKey(*compiler_driver_, code_item, access_flags, kStatic, class_def_idx,
+                      method_idx, class_loader, *dex_file, &key);
+    return key;
+  }
+
+  std::vector<uint16_t> GetInstructions(jobject class_loader, const char* name)
+      LOCKS_EXCLUDED(Locks::mutator_lock_) {
+    ScopedObjectAccess soa(Thread::Current());
+    const DexFile::CodeItem* code_item = MethodHelper(FindMethod(class_loader, name)).GetCodeItem();
+    return std::vector<uint16_t>(code_item->insns_,
+                                 code_item->insns_ + code_item->insns_size_in_code_units_);
+  }
+
+  // Counts the resolved types, fields and methods in the dex cache of the test dex file.
+  size_t CountResolved(jobject class_loader) LOCKS_EXCLUDED(Locks::mutator_lock_) {
+    ScopedObjectAccess soa(Thread::Current());
+    mirror::DexCache* dex_cache =
+        FindMethod(class_loader, "readData")->GetDeclaringClass()->GetDexCache();
+    size_t resolved = 0;
+    for (size_t i = 0; i < dex_cache->NumResolvedTypes(); ++i) {
+      resolved += dex_cache->GetResolvedType(i) != NULL;
+    }
+    for (size_t i = 0; i < dex_cache->NumResolvedFields(); ++i) {
+      resolved += dex_cache->GetResolvedField(i) != NULL;
+    }
+    for (size_t i = 0; i < dex_cache->NumResolvedMethods(); ++i) {
+      resolved += dex_cache->GetResolvedMethod(i) != NULL;
+    }
+    return resolved;
+  }
+
+  CompiledMethod* Compile(jobject class_loader, const char* name)
+      LOCKS_EXCLUDED(Locks::mutator_lock_) {
+    ScopedObjectAccess soa(Thread::Current());
+    mirror::ArtMethod* method = FindMethod(class_loader, name);
+    base::TimingLogger timings("CompilationCacheTest::Compile", false, false);
+    timings.StartSplit("CompileOne");
+    compiler_driver_->CompileOne(method, timings);
+    return compiler_driver_->GetCompiledMethod(
+        MethodReference(&MethodHelper(method).GetDexFile(), method->GetDexMethodIndex()));
+  }
+
+  std::string cache_directory_;
+};
+
+TEST_F(CompilationCacheTest, UnchangedMethodHits) {
+  jobject class_loader = LoadClasses("CompilationCache");
+  UniquePtr<CompilationCache> cache(CreateCache());
+
+  // Computing a key doesn't resolve anything.
+  size_t resolved = CountResolved(class_loader);
+  std::string key(ComputeKey(cache.get(), class_loader, "readData"));
+  EXPECT_EQ(resolved, CountResolved(class_loader));
+  EXPECT_TRUE(cache->Lookup(*compiler_driver_, key) == NULL);
+
+  CompiledMethod* compiled_method = Compile(class_loader, "readData");
+  ASSERT_TRUE(compiled_method != NULL);
+  cache->Store(key, *compiled_method);
+
+  // Compiling resolved what the method refers to, which doesn't change its key.
+  EXPECT_EQ(key, ComputeKey(cache.get(), class_loader, "readData"));
+  UniquePtr<CompiledMethod> cached_method(cache->Lookup(*compiler_driver_, key));
+  ASSERT_TRUE(cached_method.get() != NULL);
+  EXPECT_EQ(compiled_method->GetInstructionSet(), cached_method->GetInstructionSet());
+  EXPECT_EQ(compiled_method->GetCode(), cached_method->GetCode());
+  EXPECT_EQ(compiled_method->GetFrameSizeInBytes(), cached_method->GetFrameSizeInBytes());
+  EXPECT_EQ(compiled_method->GetCoreSpillMask(), cached_method->GetCoreSpillMask());
+  EXPECT_EQ(compiled_method->GetFpSpillMask(), cached_method->GetFpSpillMask());
+  EXPECT_EQ(compiled_method->GetMappingTable(), cached_method->GetMappingTable());
+  EXPECT_EQ(compiled_method->GetVmapTable(), cached_method->GetVmapTable());
+  EXPECT_EQ(compiled_method->GetGcMap(), cached_method->GetGcMap());
+
+  // Another method misses.
+  EXPECT_TRUE(cache->Lookup(*compiler_driver_,
+                            ComputeKey(cache.get(), class_loader, "readSame")) == NULL);
+}
+
+TEST_F(CompilationCacheTest, ChangedDependencyMisses) {
+  jobject class_loader = LoadClasses("CompilationCache");
+  jobject changed_class_loader = LoadClasses("CompilationCache2");
+  UniquePtr<CompilationCache> cache(CreateCache());
+
+  // The two dex files only differ in the classes the methods refer to.
+  const char* const kMethods[] = { "readData", "readSub", "readSame" };
+  for (size_t i = 0; i < arraysize(kMethods); ++i) {
+    EXPECT_EQ(GetInstructions(class_loader, kMethods[i]),
+              GetInstructions(changed_class_loader, kMethods[i])) << kMethods[i];
+  }
+
+  // A method whose dependencies are the same in both dex files has the same key.
+  EXPECT_EQ(ComputeKey(cache.get(), class_loader, "readSame"),
+            ComputeKey(cache.get(), changed_class_loader, "readSame"));
+  // Data.wide is static in the changed dex file, which moves Data.value.
+  EXPECT_NE(ComputeKey(cache.get(), class_loader, "readData"),
+            ComputeKey(cache.get(), changed_class_loader, "readData"));
+  // Sub has another superclass.
+  EXPECT_NE(ComputeKey(cache.get(), class_loader, "readSub"),
+            ComputeKey(cache.get(), changed_class_loader, "readSub"));
+
+  // An entry stored for the original layout isn't found for the changed one.
+  CompiledMethod* compiled_method = Compile(class_loader, "readData");
+  ASSERT_TRUE(compiled_method != NULL);
+  cache->Store(ComputeKey(cache.get(), class_loader, "readData"), *compiled_method);
+  EXPECT_TRUE(cache->Lookup(*compiler_driver_,
+                            ComputeKey(cache.get(), changed_class_loader, "readData")) == NULL);
+}
+
+TEST_F(CompilationCacheTest, ConcurrentStores) {
+  jobject class_loader = LoadClasses("CompilationCache");
+  UniquePtr<CompilationCache> cache(CreateCache());
+  std::string key(ComputeKey(cache.get(), class_loader, "readData"));
+  CompiledMethod* compiled_method = Compile(class_loader, "readData");
+  ASSERT_TRUE(compiled_method != NULL);
+
+  // Another process stores the same entry while this one does, as dex2oat processes sharing the
+  // directory would.
+  static const size_t kStores = 200;
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    for (size_t i = 0; i < kStores; ++i) {
+      cache->Store(key, *compiled_method);
+    }
+    _exit(0);
+  }
+  for (size_t i = 0; i < kStores; ++i) {
+    cache->Store(key, *compiled_method);
+    UniquePtr<CompiledMethod> cached_method(cache->Lookup(*compiler_driver_, key));
+    ASSERT_TRUE(cached_method.get() != NULL);
+    EXPECT_EQ(compiled_method->GetCode(), cached_method->GetCode());
+  }
+  int status;
+  ASSERT_EQ(pid, TEMP_FAILURE_RETRY(waitpid(pid, &status, 0)));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+
+  // One complete entry is left, without temporary files.
+  EXPECT_EQ(1U, ListCacheDirectory().size());
+  UniquePtr<CompiledMethod> cached_method(cache->Lookup(*compiler_driver_, key));
+  ASSERT_TRUE(cached_method.get() != NULL);
+  EXPECT_EQ(compiled_method->GetCode(), cached_method->GetCode());
+  EXPECT_EQ(compiled_method->GetMappingTable(), cached_method->GetMappingTable());
+  EXPECT_EQ(compiled_method->GetVmapTable(), cached_method->GetVmapTable());
+  EXPECT_EQ(compiled_method->GetGcMap(), cached_method->GetGcMap());
+}
+
+}  // namespace art
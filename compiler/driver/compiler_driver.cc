@@ -19,12 +19,14 @@
 #define ATRACE_TAG ATRACE_TAG_DALVIK
 #include <utils/Trace.h>
 
+#include <algorithm>
 #include <vector>
 #include <unistd.h>
 
 #include "base/stl_util.h"
 #include "base/timing_logger.h"
 #include "class_linker.h"
+#include "compilation_cache.h"
 #include "dex_compilation_unit.h"
 #include "dex_file-inl.h"
 #include "jni_internal.h"
@@ -355,7 +357,11 @@ CompilerDriver::CompilerDriver(CompilerBackend compiler_backend, InstructionSet
       jni_compiler_(NULL),
       compiler_enable_auto_elf_loading_(NULL),
       compiler_get_method_code_addr_(NULL),
-      support_boot_image_fixup_(true) {
+      support_boot_image_fixup_(true),
+      dedupe_code_("dedupe code"),
+      dedupe_mapping_table_("dedupe mapping table"),
+      dedupe_vmap_table_("dedupe vmap table"),
+      dedupe_gc_map_("dedupe gc map") {
 
   CHECK_PTHREAD_CALL(pthread_key_create, (&tls_key_, NULL), "compiler tls key");
 
@@ -410,6 +416,35 @@ std::vector<uint8_t>* CompilerDriver::DeduplicateGCMap(const std::vector<uint8_t
   return dedupe_gc_map_.Add(Thread::Current(), code);
 }
 
+void CompilerDriver::RecordPhaseUtilization(const char* phase, uint64_t wall_ns, uint64_t cpu_ns,
+                                            const std::vector<uint64_t>& busy_ns) {
+  PhaseUtilization utilization;
+  utilization.phase = phase;
+  utilization.wall_ns = wall_ns;
+  utilization.cpu_ns = cpu_ns;
+  utilization.busy_ns = busy_ns;
+  phase_utilization_.push_back(utilization);
+}
+
+void CompilerDriver::DumpPhaseUtilization(std::ostream& os) const {
+  for (size_t i = 0; i < phase_utilization_.size(); ++i) {
+    const PhaseUtilization& utilization = phase_utilization_[i];
+    const size_t thread_count = utilization.busy_ns.size();
+    // The CPU time the threads could have used had none of them been idle.
+    uint64_t available_ns = std::max<uint64_t>(utilization.wall_ns * thread_count, 1);
+    os << utilization.phase << ": " << PrettyDuration(utilization.wall_ns) << " wall, "
+       << PrettyDuration(utilization.cpu_ns) << " cpu, "
+       << (utilization.cpu_ns * 100 / available_ns) << "% utilization of "
+       << thread_count << " threads\n";
+    // A worker is idle from the start of the phase until it picks up work and once it runs out.
+    for (size_t j = 0; j < thread_count; ++j) {
+      uint64_t busy_ns = std::min(utilization.busy_ns[j], utilization.wall_ns);
+      os << "  worker " << j << ": " << PrettyDuration(busy_ns) << " busy, "
+         << PrettyDuration(utilization.wall_ns - busy_ns) << " idle\n";
+    }
+  }
+}
+
 CompilerDriver::~CompilerDriver() {
   Thread* self = Thread::Current();
   {
@@ -494,9 +529,23 @@ void CompilerDriver::CompileAll(jobject class_loader,
   Compile(class_loader, dex_files, *thread_pool.get(), timings);
   if (dump_stats_) {
     stats_->Dump();
+    DumpDedupeStats();
   }
 }
 
+void CompilerDriver::DumpDedupeStats() const {
+  Thread* self = Thread::Current();
+  std::ostringstream oss;
+  dedupe_code_.DumpStats(self, oss);
+  oss << "\n";
+  dedupe_mapping_table_.DumpStats(self, oss);
+  oss << "\n";
+  dedupe_vmap_table_.DumpStats(self, oss);
+  oss << "\n";
+  dedupe_gc_map_.DumpStats(self, oss);
+  LOG(INFO) << oss.str();
+}
+
 static DexToDexCompilationLevel GetDexToDexCompilationlevel(mirror::ClassLoader* class_loader,
                                                             const DexFile& dex_file,
                                                             const DexFile::ClassDef& class_def)
@@ -574,14 +623,6 @@ void CompilerDriver::CompileOne(const mirror::ArtMethod* method, base::TimingLog
   self->TransitionFromSuspendedToRunnable();
 }
 
-void CompilerDriver::Resolve(jobject class_loader, const std::vector<const DexFile*>& dex_files,
-                             ThreadPool& thread_pool, base::TimingLogger& timings) {
-  for (size_t i = 0; i != dex_files.size(); ++i) {
-    const DexFile* dex_file = dex_files[i];
-    CHECK(dex_file != NULL);
-    ResolveDexFile(class_loader, *dex_file, thread_pool, timings);
-  }
-}
 
 void CompilerDriver::PreCompile(jobject class_loader, const std::vector<const DexFile*>& dex_files,
                                 ThreadPool& thread_pool, base::TimingLogger& timings) {
@@ -1333,21 +1374,35 @@ void CompilerDriver::AddMethodPatch(const DexFile* dex_file,
                                                    literal_offset));
 }
 
+// Runs a callback over the items, such as class definitions, of all the dex files being compiled.
+// The items of every dex file are handed out from one queue, so threads don't wait for each other
+// at the end of a dex file, only at the end of the phase.
+//
+// Items are handed out in batches to keep the threads off the shared counter. When the cost of
+// the items can be estimated the most expensive ones go first, each in a batch of its own, so
+// that the phase doesn't end waiting on one thread that picked up a huge class last.
 class ParallelCompilationManager {
  public:
-  typedef void Callback(const ParallelCompilationManager* manager, size_t index);
+  typedef void Callback(const ParallelCompilationManager* manager, const DexFile& dex_file,
+                        size_t index);
+  // The number of items a dex file holds, such as DexFile::NumClassDefs.
+  typedef size_t (DexFile::*CountFn)() const;
+  // An estimate of the work an item takes, only compared with the estimates of other items.
+  typedef size_t CostFn(const DexFile& dex_file, size_t index);
 
   ParallelCompilationManager(ClassLinker* class_linker,
                              jobject class_loader,
                              CompilerDriver* compiler,
-                             const DexFile* dex_file,
+                             const std::vector<const DexFile*>& dex_files,
                              ThreadPool& thread_pool)
-    : index_(0),
+    : batch_index_(0),
       class_linker_(class_linker),
       class_loader_(class_loader),
       compiler_(compiler),
-      dex_file_(dex_file),
-      thread_pool_(&thread_pool) {}
+      dex_files_(dex_files),
+      thread_pool_(&thread_pool),
+      workers_lock_("parallel compilation workers lock"),
+      cpu_ns_(0) {}
 
   ClassLinker* GetClassLinker() const {
     CHECK(class_linker_ != NULL);
@@ -1363,20 +1418,35 @@ class ParallelCompilationManager {
     return compiler_;
   }
 
-  const DexFile* GetDexFile() const {
-    CHECK(dex_file_ != NULL);
-    return dex_file_;
-  }
-
-  void ForAll(size_t begin, size_t end, Callback callback, size_t work_units) {
+  // Calls callback for every item of every dex file and records how busy the threads were under
+  // the name of the phase. Without a cost function the items are taken in order.
+  void ForAll(const char* phase, CountFn count, Callback callback, size_t work_units,
+              CostFn* cost = NULL) {
     Thread* self = Thread::Current();
     self->AssertNoPendingException();
     CHECK_GT(work_units, 0U);
 
+    // The first global index of each dex file, the last entry is the total.
+    starts_.clear();
+    size_t end = 0;
+    for (size_t i = 0; i < dex_files_.size(); ++i) {
+      CHECK(dex_files_[i] != NULL);
+      starts_.push_back(end);
+      end += (dex_files_[i]->*count)();
+    }
+    starts_.push_back(end);
+
+    uint64_t start_ns = NanoTime();
+    PlanBatches(end, work_units, cost);
+    {
+      MutexLock mu(self, workers_lock_);
+      cpu_ns_ = 0;
+      busy_ns_.clear();
+    }
     std::vector<ForAllClosure*> closures(work_units);
-    index_ = begin;
+    batch_index_ = 0;
     for (size_t i = 0; i < work_units; ++i) {
-      closures[i] = new ForAllClosure(this, end, callback);
+      closures[i] = new ForAllClosure(this, callback);
       thread_pool_->AddTask(self, closures[i]);
     }
     thread_pool_->StartWorkers(self);
@@ -1387,29 +1457,93 @@ class ParallelCompilationManager {
 
     // Wait for all the worker threads to finish.
     thread_pool_->Wait(self, true, false);
-  }
 
-  size_t NextIndex() {
-    return index_.fetch_add(1);
+    MutexLock mu(self, workers_lock_);
+    compiler_->RecordPhaseUtilization(phase, NanoTime() - start_ns, cpu_ns_, busy_ns_);
   }
 
  private:
+  // Each thread should take about this many batches so that they finish close together.
+  static const size_t kBatchesPerWorker = 16;
+
+  // Fills in order_ and batch_starts_ for the items [0, end).
+  void PlanBatches(size_t end, size_t work_units, CostFn* cost) {
+    order_.clear();
+    batch_starts_.clear();
+    std::vector<size_t> costs;
+    size_t total_cost = end;
+    if (cost != NULL) {
+      costs.resize(end);
+      total_cost = 0;
+      for (size_t i = 0; i + 1 < starts_.size(); ++i) {
+        for (size_t index = starts_[i]; index < starts_[i + 1]; ++index) {
+          costs[index] = cost(*dex_files_[i], index - starts_[i]);
+          total_cost += costs[index];
+        }
+      }
+      order_.resize(end);
+      for (size_t i = 0; i < end; ++i) {
+        order_[i] = i;
+      }
+      // Largest first, ties keep the dex file order.
+      std::stable_sort(order_.begin(), order_.end(), CostGreater(costs));
+    }
+    const size_t batch_cost = std::max<size_t>(total_cost / (work_units * kBatchesPerWorker), 1);
+    size_t current_cost = batch_cost;
+    for (size_t i = 0; i < end; ++i) {
+      if (current_cost >= batch_cost) {
+        batch_starts_.push_back(i);
+        current_cost = 0;
+      }
+      current_cost += costs.empty() ? 1 : costs[order_[i]];
+    }
+    batch_starts_.push_back(end);
+  }
+
+  class CostGreater {
+   public:
+    explicit CostGreater(const std::vector<size_t>& costs) : costs_(costs) {}
+
+    bool operator()(size_t lhs, size_t rhs) const {
+      return costs_[lhs] > costs_[rhs];
+    }
+
+   private:
+    const std::vector<size_t>& costs_;
+  };
+
   class ForAllClosure : public Task {
    public:
-    ForAllClosure(ParallelCompilationManager* manager, size_t end, Callback* callback)
+    ForAllClosure(ParallelCompilationManager* manager, Callback* callback)
         : manager_(manager),
-          end_(end),
           callback_(callback) {}
 
     virtual void Run(Thread* self) {
+      uint64_t start_ns = NanoTime();
+      uint64_t start_cpu_ns = ThreadCpuNanoTime();
+      const std::vector<size_t>& starts = manager_->starts_;
+      const std::vector<size_t>& order = manager_->order_;
+      const std::vector<size_t>& batch_starts = manager_->batch_starts_;
       while (true) {
-        const size_t index = manager_->NextIndex();
-        if (UNLIKELY(index >= end_)) {
+        const size_t batch = manager_->batch_index_.fetch_add(1);
+        if (UNLIKELY(batch + 1 >= batch_starts.size())) {
           break;
         }
-        callback_(manager_, index);
-        self->AssertNoPendingException();
+        for (size_t i = batch_starts[batch]; i < batch_starts[batch + 1]; ++i) {
+          const size_t index = order.empty() ? i : order[i];
+          // Find the dex file holding the index, skipping any without items.
+          size_t dex_file_index =
+              std::upper_bound(starts.begin(), starts.end(), index) - starts.begin() - 1;
+          callback_(manager_, *manager_->dex_files_[dex_file_index],
+                    index - starts[dex_file_index]);
+          self->AssertNoPendingException();
+        }
       }
+      uint64_t cpu_ns = ThreadCpuNanoTime() - start_cpu_ns;
+      uint64_t busy_ns = NanoTime() - start_ns;
+      MutexLock mu(self, manager_->workers_lock_);
+      manager_->cpu_ns_ += cpu_ns;
+      manager_->busy_ns_.push_back(busy_ns);
     }
 
     virtual void Finalize() {
@@ -1418,20 +1552,50 @@ class ParallelCompilationManager {
 
    private:
     ParallelCompilationManager* const manager_;
-    const size_t end_;
     const Callback* const callback_;
   };
 
-  AtomicInteger index_;
+  AtomicInteger batch_index_;
   ClassLinker* const class_linker_;
   const jobject class_loader_;
   CompilerDriver* const compiler_;
-  const DexFile* const dex_file_;
+  const std::vector<const DexFile*>& dex_files_;
   ThreadPool* const thread_pool_;
+  std::vector<size_t> starts_;
+  // The global indices in the order they're handed out, empty when that's index order.
+  std::vector<size_t> order_;
+  // The position in order_ each batch starts at, the last entry is the number of items.
+  std::vector<size_t> batch_starts_;
+
+  // CPU time and time from starting to running out of work, of the threads running the current
+  // phase.
+  Mutex workers_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  uint64_t cpu_ns_ GUARDED_BY(workers_lock_);
+  std::vector<uint64_t> busy_ns_ GUARDED_BY(workers_lock_);
 
   DISALLOW_COPY_AND_ASSIGN(ParallelCompilationManager);
 };
 
+// Estimates the work of verifying or compiling a class from the size of its methods' code, with
+// a little added for each method and for the class itself.
+static size_t ClassCodeSize(const DexFile& dex_file, size_t class_def_index) {
+  size_t cost = 1;
+  const byte* class_data = dex_file.GetClassData(dex_file.GetClassDef(class_def_index));
+  if (class_data == NULL) {
+    return cost;
+  }
+  ClassDataItemIterator it(dex_file, class_data);
+  while (it.HasNextStaticField() || it.HasNextInstanceField()) {
+    it.Next();
+  }
+  while (it.HasNext()) {
+    const DexFile::CodeItem* code_item = it.GetMethodCodeItem();
+    cost += 1 + ((code_item != NULL) ? code_item->insns_size_in_code_units_ : 0);
+    it.Next();
+  }
+  return cost;
+}
+
 // Return true if the class should be skipped during compilation.
 //
 // The first case where we skip is for redundant class definitions in
@@ -1474,12 +1638,11 @@ static bool SkipClass(jobject class_loader, const DexFile& dex_file, mirror::Cla
 }
 
 static void ResolveClassFieldsAndMethods(const ParallelCompilationManager* manager,
-                                         size_t class_def_index)
+                                         const DexFile& dex_file, size_t class_def_index)
     LOCKS_EXCLUDED(Locks::mutator_lock_) {
   ATRACE_CALL();
   Thread* self = Thread::Current();
   jobject jclass_loader = manager->GetClassLoader();
-  const DexFile& dex_file = *manager->GetDexFile();
   ClassLinker* class_linker = manager->GetClassLinker();
 
   // If an instance field is final then we need to have a barrier on the return, static final
@@ -1580,12 +1743,12 @@ static void ResolveClassFieldsAndMethods(const ParallelCompilationManager* manag
   }
 }
 
-static void ResolveType(const ParallelCompilationManager* manager, size_t type_idx)
+static void ResolveType(const ParallelCompilationManager* manager, const DexFile& dex_file,
+                        size_t type_idx)
     LOCKS_EXCLUDED(Locks::mutator_lock_) {
   // Class derived values are more complicated, they require the linker and loader.
   ScopedObjectAccess soa(Thread::Current());
   ClassLinker* class_linker = manager->GetClassLinker();
-  const DexFile& dex_file = *manager->GetDexFile();
   mirror::DexCache* dex_cache = class_linker->FindDexCache(dex_file);
   mirror::ClassLoader* class_loader = soa.Decode<mirror::ClassLoader*>(manager->GetClassLoader());
   mirror::Class* klass = class_linker->ResolveType(dex_file, type_idx, dex_cache, class_loader);
@@ -1603,41 +1766,31 @@ static void ResolveType(const ParallelCompilationManager* manager, size_t type_i
   }
 }
 
-void CompilerDriver::ResolveDexFile(jobject class_loader, const DexFile& dex_file,
-                                    ThreadPool& thread_pool, base::TimingLogger& timings) {
+void CompilerDriver::Resolve(jobject class_loader, const std::vector<const DexFile*>& dex_files,
+                             ThreadPool& thread_pool, base::TimingLogger& timings) {
   ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
 
   // TODO: we could resolve strings here, although the string table is largely filled with class
   //       and method names.
 
-  ParallelCompilationManager context(class_linker, class_loader, this, &dex_file, thread_pool);
+  ParallelCompilationManager context(class_linker, class_loader, this, dex_files, thread_pool);
   if (IsImage()) {
     // For images we resolve all types, such as array, whereas for applications just those with
     // classdefs are resolved by ResolveClassFieldsAndMethods.
-    // TODO: strdup memory leak.
-    timings.NewSplit(strdup(("Resolve " + dex_file.GetLocation() + " Types").c_str()));
-    context.ForAll(0, dex_file.NumTypeIds(), ResolveType, thread_count_);
+    timings.NewSplit("Resolve Types");
+    context.ForAll("Resolve Types", &DexFile::NumTypeIds, ResolveType, thread_count_);
   }
 
-  // TODO: strdup memory leak.
-  timings.NewSplit(strdup(("Resolve " + dex_file.GetLocation() + " MethodsAndFields").c_str()));
-  context.ForAll(0, dex_file.NumClassDefs(), ResolveClassFieldsAndMethods, thread_count_);
+  timings.NewSplit("Resolve MethodsAndFields");
+  context.ForAll("Resolve MethodsAndFields", &DexFile::NumClassDefs, ResolveClassFieldsAndMethods,
+                 thread_count_);
 }
 
-void CompilerDriver::Verify(jobject class_loader, const std::vector<const DexFile*>& dex_files,
-                            ThreadPool& thread_pool, base::TimingLogger& timings) {
-  for (size_t i = 0; i != dex_files.size(); ++i) {
-    const DexFile* dex_file = dex_files[i];
-    CHECK(dex_file != NULL);
-    VerifyDexFile(class_loader, *dex_file, thread_pool, timings);
-  }
-}
-
-static void VerifyClass(const ParallelCompilationManager* manager, size_t class_def_index)
+static void VerifyClass(const ParallelCompilationManager* manager, const DexFile& dex_file,
+                        size_t class_def_index)
     LOCKS_EXCLUDED(Locks::mutator_lock_) {
   ATRACE_CALL();
   ScopedObjectAccess soa(Thread::Current());
-  const DexFile& dex_file = *manager->GetDexFile();
   const DexFile::ClassDef& class_def = dex_file.GetClassDef(class_def_index);
   const char* descriptor = dex_file.GetClassDescriptor(class_def);
   ClassLinker* class_linker = manager->GetClassLinker();
@@ -1678,13 +1831,12 @@ static void VerifyClass(const ParallelCompilationManager* manager, size_t class_
   soa.Self()->AssertNoPendingException();
 }
 
-void CompilerDriver::VerifyDexFile(jobject class_loader, const DexFile& dex_file,
-                                   ThreadPool& thread_pool, base::TimingLogger& timings) {
-  // TODO: strdup memory leak.
-  timings.NewSplit(strdup(("Verify " + dex_file.GetLocation()).c_str()));
+void CompilerDriver::Verify(jobject class_loader, const std::vector<const DexFile*>& dex_files,
+                            ThreadPool& thread_pool, base::TimingLogger& timings) {
+  timings.NewSplit("Verify");
   ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
-  ParallelCompilationManager context(class_linker, class_loader, this, &dex_file, thread_pool);
-  context.ForAll(0, dex_file.NumClassDefs(), VerifyClass, thread_count_);
+  ParallelCompilationManager context(class_linker, class_loader, this, dex_files, thread_pool);
+  context.ForAll("Verify", &DexFile::NumClassDefs, VerifyClass, thread_count_, ClassCodeSize);
 }
 
 static const char* class_initializer_black_list[] = {
@@ -2105,11 +2257,11 @@ static const char* class_initializer_black_list[] = {
   "Lorg/apache/http/conn/util/InetAddressUtils;",  // Calls regex.Pattern.compile -..-> regex.Pattern.compileImpl.
 };
 
-static void InitializeClass(const ParallelCompilationManager* manager, size_t class_def_index)
+static void InitializeClass(const ParallelCompilationManager* manager, const DexFile& dex_file,
+                            size_t class_def_index)
     LOCKS_EXCLUDED(Locks::mutator_lock_) {
   ATRACE_CALL();
   jobject jclass_loader = manager->GetClassLoader();
-  const DexFile& dex_file = *manager->GetDexFile();
   const DexFile::ClassDef& class_def = dex_file.GetClassDef(class_def_index);
   const char* descriptor = dex_file.GetClassDescriptor(class_def);
   ClassLinker* class_linker = manager->GetClassLinker();
@@ -2176,17 +2328,17 @@ static void InitializeClass(const ParallelCompilationManager* manager, size_t cl
       }
     }
     // Record the final class status if necessary.
-    ClassReference ref(manager->GetDexFile(), class_def_index);
+    ClassReference ref(&dex_file, class_def_index);
     manager->GetCompiler()->RecordClassStatus(ref, klass->GetStatus());
   }
   // Clear any class not found or verification exceptions.
   soa.Self()->ClearException();
 }
 
-void CompilerDriver::InitializeClasses(jobject jni_class_loader, const DexFile& dex_file,
+void CompilerDriver::InitializeClasses(jobject jni_class_loader,
+                                       const std::vector<const DexFile*>& dex_files,
                                        ThreadPool& thread_pool, base::TimingLogger& timings) {
-  // TODO: strdup memory leak.
-  timings.NewSplit(strdup(("InitializeNoClinit " + dex_file.GetLocation()).c_str()));
+  timings.NewSplit("InitializeNoClinit");
 #ifndef NDEBUG
   // Sanity check blacklist descriptors.
   if (IsImage()) {
@@ -2197,33 +2349,24 @@ void CompilerDriver::InitializeClasses(jobject jni_class_loader, const DexFile&
   }
 #endif
   ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
-  ParallelCompilationManager context(class_linker, jni_class_loader, this, &dex_file, thread_pool);
-  context.ForAll(0, dex_file.NumClassDefs(), InitializeClass, thread_count_);
-}
-
-void CompilerDriver::InitializeClasses(jobject class_loader,
-                                       const std::vector<const DexFile*>& dex_files,
-                                       ThreadPool& thread_pool, base::TimingLogger& timings) {
-  for (size_t i = 0; i != dex_files.size(); ++i) {
-    const DexFile* dex_file = dex_files[i];
-    CHECK(dex_file != NULL);
-    InitializeClasses(class_loader, *dex_file, thread_pool, timings);
-  }
+  ParallelCompilationManager context(class_linker, jni_class_loader, this, dex_files,
+                                     thread_pool);
+  context.ForAll("InitializeNoClinit", &DexFile::NumClassDefs, InitializeClass, thread_count_);
 }
 
 void CompilerDriver::Compile(jobject class_loader, const std::vector<const DexFile*>& dex_files,
-                       ThreadPool& thread_pool, base::TimingLogger& timings) {
-  for (size_t i = 0; i != dex_files.size(); ++i) {
-    const DexFile* dex_file = dex_files[i];
-    CHECK(dex_file != NULL);
-    CompileDexFile(class_loader, *dex_file, thread_pool, timings);
-  }
+                             ThreadPool& thread_pool, base::TimingLogger& timings) {
+  timings.NewSplit("Compile");
+  ParallelCompilationManager context(Runtime::Current()->GetClassLinker(), class_loader, this,
+                                     dex_files, thread_pool);
+  context.ForAll("Compile", &DexFile::NumClassDefs, CompilerDriver::CompileClass, thread_count_,
+                 ClassCodeSize);
 }
 
-void CompilerDriver::CompileClass(const ParallelCompilationManager* manager, size_t class_def_index) {
+void CompilerDriver::CompileClass(const ParallelCompilationManager* manager,
+                                  const DexFile& dex_file, size_t class_def_index) {
   ATRACE_CALL();
   jobject jclass_loader = manager->GetClassLoader();
-  const DexFile& dex_file = *manager->GetDexFile();
   const DexFile::ClassDef& class_def = dex_file.GetClassDef(class_def_index);
   ClassLinker* class_linker = manager->GetClassLinker();
   if (SkipClass(class_linker, jclass_loader, dex_file, class_def)) {
@@ -2291,15 +2434,6 @@ void CompilerDriver::CompileClass(const ParallelCompilationManager* manager, siz
   DCHECK(!it.HasNext());
 }
 
-void CompilerDriver::CompileDexFile(jobject class_loader, const DexFile& dex_file,
-                                    ThreadPool& thread_pool, base::TimingLogger& timings) {
-  // TODO: strdup memory leak.
-  timings.NewSplit(strdup(("Compile " + dex_file.GetLocation()).c_str()));
-  ParallelCompilationManager context(Runtime::Current()->GetClassLinker(), class_loader, this,
-                                     &dex_file, thread_pool);
-  context.ForAll(0, dex_file.NumClassDefs(), CompilerDriver::CompileClass, thread_count_);
-}
-
 void CompilerDriver::CompileMethod(const DexFile::CodeItem* code_item, uint32_t access_flags,
                                    InvokeType invoke_type, uint16_t class_def_idx,
                                    uint32_t method_idx, jobject class_loader,
@@ -2327,9 +2461,22 @@ void CompilerDriver::CompileMethod(const DexFile::CodeItem* code_item, uint32_t
         LOG(INFO) << "Using SEA IR to compile..." << std::endl;
       }
 #endif
-      // NOTE: if compiler declines to compile this method, it will return NULL.
-      compiled_method = (*compiler)(*this, code_item, access_flags, invoke_type, class_def_idx,
-                                    method_idx, class_loader, dex_file);
+      // Only code from the regular backend is cached.
+      std::string cache_key;
+      bool use_cache = compilation_cache_.get() != NULL && compiler == compiler_;
+      if (use_cache) {
+        compilation_cache_->ComputeKey(*this, code_item, access_flags, invoke_type, class_def_idx,
+                                       method_idx, class_loader, dex_file, &cache_key);
+        compiled_method = compilation_cache_->Lookup(*this, cache_key);
+      }
+      if (compiled_method == NULL) {
+        // NOTE: if compiler declines to compile this method, it will return NULL.
+        compiled_method = (*compiler)(*this, code_item, access_flags, invoke_type, class_def_idx,
+                                      method_idx, class_loader, dex_file);
+        if (use_cache && compiled_method != NULL) {
+          compilation_cache_->Store(cache_key, *compiled_method);
+        }
+      }
     } else if (dex_to_dex_compilation_level != kDontDexToDexCompile) {
       // TODO: add a mode to disable DEX-to-DEX compilation ?
       (*dex_to_dex_compiler_)(*this, code_item, access_flags,
@@ -2422,6 +2569,11 @@ void CompilerDriver::SetBitcodeFileName(std::string const& filename) {
   set_bitcode_file_name(*this, filename);
 }
 
+bool CompilerDriver::SetCompilationCacheDirectory(const std::string& directory) {
+  compilation_cache_.reset(CompilationCache::Create(*this, directory));
+  return compilation_cache_.get() != NULL;
+}
+
 
 void CompilerDriver::AddRequiresConstructorBarrier(Thread* self, const DexFile* dex_file,
                                                    uint16_t class_def_index) {
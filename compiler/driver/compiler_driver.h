@@ -39,6 +39,7 @@
 namespace art {
 
 class AOTCompilationStats;
+class CompilationCache;
 class ParallelCompilationManager;
 class DexCompilationUnit;
 class OatWriter;
@@ -210,6 +211,14 @@ class CompilerDriver {
 
   void SetBitcodeFileName(std::string const& filename);
 
+  // Reuses code compiled by earlier runs that is kept in directory, and adds newly compiled code
+  // to it. Returns false if the cache can't be used for this compile, see CompilationCache.
+  bool SetCompilationCacheDirectory(const std::string& directory);
+
+  const CompilationCache* GetCompilationCache() const {
+    return compilation_cache_.get();
+  }
+
   bool GetSupportBootImageFixup() const {
     return support_boot_image_fixup_;
   }
@@ -318,6 +327,14 @@ class CompilerDriver {
   std::vector<uint8_t>* DeduplicateVMapTable(const std::vector<uint8_t>& code);
   std::vector<uint8_t>* DeduplicateGCMap(const std::vector<uint8_t>& code);
 
+  // Records the wall and CPU time of a parallel phase, along with the time each of its workers
+  // spent before running out of work.
+  void RecordPhaseUtilization(const char* phase, uint64_t wall_ns, uint64_t cpu_ns,
+                              const std::vector<uint64_t>& busy_ns);
+
+  // Reports how busy the threads were during each parallel phase, as with dex2oat --dump-timing.
+  void DumpPhaseUtilization(std::ostream& os) const;
+
  private:
   // Compute constant code and method pointers when possible
   void GetCodeAndMethodForDirectCall(InvokeType type, InvokeType sharp_type,
@@ -339,21 +356,13 @@ class CompilerDriver {
   void Resolve(jobject class_loader, const std::vector<const DexFile*>& dex_files,
                ThreadPool& thread_pool, base::TimingLogger& timings)
       LOCKS_EXCLUDED(Locks::mutator_lock_);
-  void ResolveDexFile(jobject class_loader, const DexFile& dex_file,
-                      ThreadPool& thread_pool, base::TimingLogger& timings)
-      LOCKS_EXCLUDED(Locks::mutator_lock_);
 
   void Verify(jobject class_loader, const std::vector<const DexFile*>& dex_files,
-              ThreadPool& thread_pool, base::TimingLogger& timings);
-  void VerifyDexFile(jobject class_loader, const DexFile& dex_file,
-                     ThreadPool& thread_pool, base::TimingLogger& timings)
+              ThreadPool& thread_pool, base::TimingLogger& timings)
       LOCKS_EXCLUDED(Locks::mutator_lock_);
 
   void InitializeClasses(jobject class_loader, const std::vector<const DexFile*>& dex_files,
                          ThreadPool& thread_pool, base::TimingLogger& timings)
-      LOCKS_EXCLUDED(Locks::mutator_lock_);
-  void InitializeClasses(jobject class_loader, const DexFile& dex_file,
-                         ThreadPool& thread_pool, base::TimingLogger& timings)
       LOCKS_EXCLUDED(Locks::mutator_lock_, compiled_classes_lock_);
 
   void UpdateImageClasses(base::TimingLogger& timings);
@@ -361,9 +370,7 @@ class CompilerDriver {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   void Compile(jobject class_loader, const std::vector<const DexFile*>& dex_files,
-               ThreadPool& thread_pool, base::TimingLogger& timings);
-  void CompileDexFile(jobject class_loader, const DexFile& dex_file,
-                      ThreadPool& thread_pool, base::TimingLogger& timings)
+               ThreadPool& thread_pool, base::TimingLogger& timings)
       LOCKS_EXCLUDED(Locks::mutator_lock_);
   void CompileMethod(const DexFile::CodeItem* code_item, uint32_t access_flags,
                      InvokeType invoke_type, uint16_t class_def_idx, uint32_t method_idx,
@@ -371,9 +378,13 @@ class CompilerDriver {
                      DexToDexCompilationLevel dex_to_dex_compilation_level)
       LOCKS_EXCLUDED(compiled_methods_lock_);
 
-  static void CompileClass(const ParallelCompilationManager* context, size_t class_def_index)
+  static void CompileClass(const ParallelCompilationManager* context, const DexFile& dex_file,
+                           size_t class_def_index)
       LOCKS_EXCLUDED(Locks::mutator_lock_);
 
+  // Logs how well each kind of compiled data deduplicated, with the AOT compilation statistics.
+  void DumpDedupeStats() const;
+
   std::vector<const PatchInformation*> code_to_patch_;
   std::vector<const PatchInformation*> methods_to_patch_;
 
@@ -407,6 +418,18 @@ class CompilerDriver {
 
   UniquePtr<AOTCompilationStats> stats_;
 
+  // Code compiled by earlier runs, NULL unless the caller asked for it.
+  UniquePtr<CompilationCache> compilation_cache_;
+
+  struct PhaseUtilization {
+    const char* phase;
+    uint64_t wall_ns;
+    uint64_t cpu_ns;
+    std::vector<uint64_t> busy_ns;
+  };
+  // The parallel phases in the order they ran, only touched by the thread driving compilation.
+  std::vector<PhaseUtilization> phase_utilization_;
+
   bool dump_stats_;
 
   typedef void (*CompilerCallbackFn)(CompilerDriver& driver);
@@ -464,12 +487,12 @@ class CompilerDriver {
       size_t hash = 0;
       if (array.size() < kSmallArrayThreshold) {
         for (auto c : array) {
-          hash = hash * 54 + c;
+          hash = hash * 53 + c;
         }
       } else {
         for (size_t i = 0; i < kRandomHashCount; ++i) {
           size_t r = i * 1103515245 + 12345;
-          hash = hash * 54 + array[r % array.size()];
+          hash = hash * 53 + array[r % array.size()];
         }
       }
       return hash;
@@ -23,6 +23,7 @@
 #include "compiler/oat_writer.h"
 #include "gc/space/image_space.h"
 #include "image.h"
+#include "scoped_thread_state_change.h"
 #include "signal_catcher.h"
 #include "UniquePtr.h"
 #include "utils.h"
@@ -35,6 +36,28 @@ class ImageTest : public CommonTest {
   virtual void SetUp() {
     ReserveImageSpace();
     CommonTest::SetUp();
+    // Let calls between boot classes go straight to their code, which the image writer patches.
+    compiler_driver_->SetSupportBootImageFixup(true);
+  }
+
+  // Runs the passes copying the objects and computing the patches of writer again on a single
+  // thread, and checks that they give the same image and patches as the threaded passes did.
+  void CheckSerialPasses(ImageWriter& writer) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    ASSERT_GT(compiler_driver_->GetThreadCount(), 1U);
+    // Without patches, a bug in computing them would go unnoticed.
+    ASSERT_FALSE(writer.patch_locations_.empty());
+    ASSERT_EQ(writer.patch_locations_.size(), writer.patch_values_.size());
+    const byte* image_begin = writer.image_->Begin();
+    std::vector<byte> image(image_begin, image_begin + writer.image_end_);
+    std::vector<uint32_t*> patch_locations(writer.patch_locations_);
+    std::vector<uint32_t> patch_values(writer.patch_values_);
+    size_t objects_begin = RoundUp(sizeof(ImageHeader), 8);
+    memset(writer.image_->Begin() + objects_begin, 0, writer.image_end_ - objects_begin);
+    writer.CopyAndFixupObjects(1);
+    writer.ComputePatches(1);
+    EXPECT_EQ(0, memcmp(&image[0], image_begin, image.size()));
+    EXPECT_TRUE(patch_locations == writer.patch_locations_);
+    EXPECT_TRUE(patch_values == writer.patch_values_);
   }
 };
 
@@ -80,6 +103,10 @@ TEST_F(ImageTest, WriteRead) {
     ASSERT_TRUE(success_image);
     bool success_fixup = ElfFixup::Fixup(tmp_oat.get(), writer.GetOatDataBegin());
     ASSERT_TRUE(success_fixup);
+
+    // The image and patches come out the same when the passes run on a single thread.
+    ScopedObjectAccess soa(Thread::Current());
+    CheckSerialPasses(writer);
   }
 
   {
@@ -96,8 +123,23 @@ TEST_F(ImageTest, WriteRead) {
     gc::space::ContinuousSpace* space = heap->GetContinuousSpaces().front();
     ASSERT_FALSE(space->IsImageSpace());
     ASSERT_TRUE(space != NULL);
-    ASSERT_TRUE(space->IsDlMallocSpace());
-    ASSERT_GE(sizeof(image_header) + space->Size(), static_cast<size_t>(file->GetLength()));
+    ASSERT_TRUE(space->IsMallocSpace());
+    // Bins after the first are page aligned.
+    ASSERT_GE(sizeof(image_header) + space->Size() + ImageHeader::kImageBinCount * kPageSize,
+              static_cast<size_t>(file->GetLength()));
+
+    // The bins are laid out in order and cover the image.
+    size_t bin_end = sizeof(image_header);
+    for (size_t i = 0; i < ImageHeader::kImageBinCount; ++i) {
+      ImageHeader::ImageBin bin = static_cast<ImageHeader::ImageBin>(i);
+      ASSERT_LE(bin_end, image_header.GetBinBegin(bin));
+      ASSERT_LE(image_header.GetBinBegin(bin), image_header.GetBinEnd(bin));
+      if (i != 0) {
+        ASSERT_TRUE(IsAligned<kPageSize>(image_header.GetBinBegin(bin)));
+      }
+      bin_end = image_header.GetBinEnd(bin);
+    }
+    ASSERT_EQ(image_header.GetImageSize(), bin_end);
   }
 
   ASSERT_TRUE(compiler_driver_->GetImageClasses() != NULL);
@@ -136,9 +178,9 @@ TEST_F(ImageTest, WriteRead) {
   gc::Heap* heap = Runtime::Current()->GetHeap();
   ASSERT_EQ(2U, heap->GetContinuousSpaces().size());
   ASSERT_TRUE(heap->GetContinuousSpaces()[0]->IsImageSpace());
-  ASSERT_FALSE(heap->GetContinuousSpaces()[0]->IsDlMallocSpace());
+  ASSERT_FALSE(heap->GetContinuousSpaces()[0]->IsMallocSpace());
   ASSERT_FALSE(heap->GetContinuousSpaces()[1]->IsImageSpace());
-  ASSERT_TRUE(heap->GetContinuousSpaces()[1]->IsDlMallocSpace());
+  ASSERT_TRUE(heap->GetContinuousSpaces()[1]->IsMallocSpace());
 
   gc::space::ImageSpace* image_space = heap->GetImageSpace();
   image_space->VerifyImageAllocations();
@@ -50,6 +50,7 @@
 #include "runtime.h"
 #include "scoped_thread_state_change.h"
 #include "sirt_ref.h"
+#include "thread_pool.h"
 #include "UniquePtr.h"
 #include "utils.h"
 
@@ -116,8 +117,8 @@ bool ImageWriter::Write(const std::string& image_filename,
   heap->CollectGarbage(false);  // Remove garbage.
   // Trim size of alloc spaces.
   for (const auto& space : heap->GetContinuousSpaces()) {
-    if (space->IsDlMallocSpace()) {
-      space->AsDlMallocSpace()->Trim();
+    if (space->IsMallocSpace()) {
+      space->AsMallocSpace()->Trim();
     }
   }
 
@@ -135,8 +136,8 @@ bool ImageWriter::Write(const std::string& image_filename,
   size_t oat_data_offset = 0;
   ElfWriter::GetOatElfInformation(oat_file.get(), oat_loaded_size, oat_data_offset);
   CalculateNewObjectOffsets(oat_loaded_size, oat_data_offset);
-  CopyAndFixupObjects();
-  PatchOatCodeAndMethods();
+  CopyAndFixupObjects(compiler_driver_.GetThreadCount());
+  PatchOatCodeAndMethods(compiler_driver_.GetThreadCount());
   // Record allocations into the image bitmap.
   RecordImageAllocations();
   Thread::Current()->TransitionFromRunnableToSuspended(kNative);
@@ -185,11 +186,14 @@ void ImageWriter::RecordImageAllocations() {
 bool ImageWriter::AllocMemory() {
   size_t size = 0;
   for (const auto& space : Runtime::Current()->GetHeap()->GetContinuousSpaces()) {
-    if (space->IsDlMallocSpace()) {
+    if (space->IsMallocSpace()) {
       size += space->Size();
     }
   }
 
+  // Bins after the first start on a new page.
+  size += ImageHeader::kImageBinCount * kPageSize;
+
   int prot = PROT_READ | PROT_WRITE;
   size_t length = RoundUp(size, kPageSize);
   image_.reset(MemMap::MapAnonymous("image writer image", NULL, length, prot));
@@ -346,25 +350,86 @@ void ImageWriter::CalculateNewObjectOffsetsCallback(Object* obj, void* arg) {
 
   // if it is a string, we want to intern it if its not interned.
   if (obj->GetClass()->IsStringClass()) {
-    // we must be an interned string that was forward referenced and already assigned
-    if (image_writer->IsImageOffsetAssigned(obj)) {
-      DCHECK_EQ(obj, obj->AsString()->Intern());
-      return;
-    }
-    SirtRef<String> interned(Thread::Current(), obj->AsString()->Intern());
-    if (obj != interned.get()) {
-      if (!image_writer->IsImageOffsetAssigned(interned.get())) {
-        // interned obj is after us, allocate its location early
-        image_writer->AssignImageOffset(interned.get());
-      }
-      // point those looking for this object to the interned version.
-      image_writer->SetImageOffset(obj, image_writer->GetImageOffset(interned.get()));
+    // Compute the hash code now rather than in every process that uses the string. Copies of
+    // the string share the interned one's place in the image, so they need it too.
+    obj->AsString()->GetHashCode();
+    String* interned = obj->AsString()->Intern();
+    if (obj != interned) {
+      // point those looking for this object to the interned version, which is put in a bin when
+      // the walk reaches it.
+      image_writer->string_aliases_.push_back(std::make_pair(obj, interned));
       return;
     }
     // else (obj == interned), nothing to do but fall through to the normal case
   }
 
-  image_writer->AssignImageOffset(obj);
+  image_writer->bins_[image_writer->GetBin(obj)].push_back(obj);
+}
+
+ImageHeader::ImageBin ImageWriter::GetBin(Object* object) const {
+  if (dex_cache_objects_.find(object) != dex_cache_objects_.end()) {
+    return ImageHeader::kBinDexCache;
+  }
+  Class* klass = object->GetClass();
+  if (klass->IsStringClass()) {
+    return ImageHeader::kBinString;
+  }
+  if (object->IsClass()) {
+    Class* as_class = object->AsClass();
+    if (IsStartupClass(as_class)) {
+      return ImageHeader::kBinStartup;
+    }
+    return IsClassWritten(as_class) ? ImageHeader::kBinClassDirty : ImageHeader::kBinClean;
+  }
+  if (object->IsArtMethod()) {
+    ArtMethod* method = object->AsArtMethod();
+    if (IsStartupClass(method->GetDeclaringClass())) {
+      return ImageHeader::kBinStartup;
+    }
+    return IsMethodWritten(method) ? ImageHeader::kBinArtMethodDirty : ImageHeader::kBinClean;
+  }
+  if (object->IsArtField()) {
+    return ImageHeader::kBinClean;
+  }
+  if (klass->IsArrayClass()) {
+    Class* component_type = klass->GetComponentType();
+    // Mostly the contents of strings, and the field and method arrays of classes.
+    if (component_type->IsPrimitiveChar() || component_type->IsArtFieldClass() ||
+        component_type->IsArtMethodClass()) {
+      return ImageHeader::kBinClean;
+    }
+  }
+  return ImageHeader::kBinMisc;
+}
+
+bool ImageWriter::IsStartupClass(Class* klass) const {
+  if (startup_classes_ == NULL) {
+    return false;
+  }
+  return startup_classes_->find(ClassHelper(klass).GetDescriptor()) != startup_classes_->end();
+}
+
+bool ImageWriter::IsClassWritten(Class* klass) {
+  // Initializing a class writes its status and static fields.
+  if (!klass->IsInitialized()) {
+    return true;
+  }
+  for (size_t i = 0; i < klass->NumStaticFields(); ++i) {
+    if (!klass->GetStaticField(i)->IsFinal()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ImageWriter::IsMethodWritten(ArtMethod* method) {
+  // Native methods are bound when they are registered or first called, static methods get
+  // their code once their class is initialized.
+  if (method->IsNative()) {
+    return true;
+  }
+  return method->IsStatic() && !method->IsConstructor() &&
+      !method->GetDeclaringClass()->IsInitialized();
 }
 
 ObjectArray<Object>* ImageWriter::CreateImageRoots() const {
@@ -419,6 +484,17 @@ void ImageWriter::CalculateNewObjectOffsets(size_t oat_loaded_size, size_t oat_d
   // know where image_roots is going to end up
   image_end_ += RoundUp(sizeof(ImageHeader), 8);  // 64-bit-alignment
 
+  for (DexCache* dex_cache : dex_caches_) {
+    dex_cache_objects_.insert(dex_cache);
+    dex_cache_objects_.insert(dex_cache->GetStrings());
+    dex_cache_objects_.insert(dex_cache->GetResolvedTypes());
+    dex_cache_objects_.insert(dex_cache->GetResolvedMethods());
+    dex_cache_objects_.insert(dex_cache->GetResolvedFields());
+    dex_cache_objects_.insert(dex_cache->GetInitializedStaticStorage());
+  }
+
+  uint32_t bin_begin[ImageHeader::kImageBinCount];
+  uint32_t bin_end[ImageHeader::kImageBinCount];
   {
     WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
     heap->FlushAllocStack();
@@ -428,10 +504,29 @@ void ImageWriter::CalculateNewObjectOffsets(size_t oat_loaded_size, size_t oat_d
     DCHECK(heap->GetLargeObjectsSpace()->GetLiveObjects()->IsEmpty());
     for (const auto& space : spaces) {
       space->GetLiveBitmap()->InOrderWalk(CalculateNewObjectOffsetsCallback, this);
-      DCHECK_LT(image_end_, image_->Size());
     }
     self->EndAssertNoThreadSuspension(old);
   }
+  for (size_t i = 0; i < ImageHeader::kImageBinCount; ++i) {
+    if (i != 0) {
+      image_end_ = RoundUp(image_end_, kPageSize);
+    }
+    bin_begin[i] = image_end_;
+    for (Object* obj : bins_[i]) {
+      AssignImageOffset(obj);
+    }
+    image_objects_.insert(image_objects_.end(), bins_[i].begin(), bins_[i].end());
+    bin_end[i] = image_end_;
+    VLOG(compiler) << "Image bin " << i << ": " << bins_[i].size() << " objects, "
+                   << PrettySize(bin_end[i] - bin_begin[i]);
+    std::vector<Object*>().swap(bins_[i]);
+  }
+  DCHECK_LT(image_end_, image_->Size());
+  for (const auto& alias : string_aliases_) {
+    CHECK(IsImageOffsetAssigned(alias.second)) << PrettyTypeOf(alias.first);
+    SetImageOffset(alias.first, GetImageOffset(alias.second));
+  }
+  string_aliases_.clear();
 
   // Create the image bitmap.
   image_bitmap_.reset(gc::accounting::SpaceBitmap::Create("image bitmap", image_->Begin(),
@@ -453,41 +548,104 @@ void ImageWriter::CalculateNewObjectOffsets(size_t oat_loaded_size, size_t oat_d
                            reinterpret_cast<uint32_t>(oat_data_begin_),
                            reinterpret_cast<uint32_t>(oat_data_end),
                            reinterpret_cast<uint32_t>(oat_file_end));
+  memcpy(image_header.bin_begin_, bin_begin, sizeof(bin_begin));
+  memcpy(image_header.bin_end_, bin_end, sizeof(bin_end));
   memcpy(image_->Begin(), &image_header, sizeof(image_header));
 
   // Note that image_end_ is left at end of used space
 }
 
-void ImageWriter::CopyAndFixupObjects()
-    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+class ImageWriter::RangeTask : public Task {
+ public:
+  RangeTask(ImageWriter* image_writer, RangeVisitor visitor, size_t begin, size_t end)
+      : image_writer_(image_writer), visitor_(visitor), begin_(begin), end_(end) {}
+
+  virtual void Run(Thread* self) {
+    ScopedObjectAccess soa(self);
+    const char* old_cause = self->StartAssertNoThreadSuspension("ImageWriter");
+    (image_writer_->*visitor_)(begin_, end_);
+    self->EndAssertNoThreadSuspension(old_cause);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  ImageWriter* const image_writer_;
+  const RangeVisitor visitor_;
+  const size_t begin_;
+  const size_t end_;
+};
+
+void ImageWriter::ForAllRanges(const char* name, const std::vector<size_t>& starts,
+                               RangeVisitor visitor, size_t thread_count) {
+  CHECK_GT(thread_count, 0U);
+  uint64_t start_ns = NanoTime();
   Thread* self = Thread::Current();
-  const char* old_cause = self->StartAssertNoThreadSuspension("ImageWriter");
+  // The workers share the mutator lock with us, but we mustn't be runnable while we wait for them.
+  ScopedThreadStateChange tsc(self, kNative);
+  ThreadPool thread_pool(thread_count - 1);
+  for (size_t i = 0; i + 1 < starts.size(); ++i) {
+    if (starts[i] != starts[i + 1]) {
+      thread_pool.AddTask(self, new RangeTask(this, visitor, starts[i], starts[i + 1]));
+    }
+  }
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, true, false);
+  VLOG(compiler) << name << " took " << PrettyDuration(NanoTime() - start_ns) << " on "
+                 << thread_count << " threads";
+}
+
+// Each thread should take about this many ranges so that they finish close together.
+static const size_t kRangesPerThread = 8;
+
+void ImageWriter::CopyAndFixupObjects(size_t thread_count) {
   gc::Heap* heap = Runtime::Current()->GetHeap();
   // TODO: heap validation can't handle this fix up pass
   heap->DisableObjectValidation();
-  // TODO: Image spaces only?
-  WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
-  heap->FlushAllocStack();
-  heap->GetLiveBitmap()->Walk(CopyAndFixupObjectsCallback, this);
-  self->EndAssertNoThreadSuspension(old_cause);
+  // Split the image into ranges of about the same size.
+  size_t range_count = thread_count * kRangesPerThread;
+  std::vector<size_t> starts;
+  starts.push_back(0);
+  size_t begin = 0;
+  for (size_t i = 1; i < range_count; ++i) {
+    size_t range_begin_offset = image_end_ / range_count * i;
+    size_t end = image_objects_.size();
+    // The first object at or after range_begin_offset.
+    while (begin < end) {
+      size_t mid = begin + (end - begin) / 2;
+      if (GetImageOffset(image_objects_[mid]) < range_begin_offset) {
+        begin = mid + 1;
+      } else {
+        end = mid;
+      }
+    }
+    starts.push_back(begin);
+  }
+  starts.push_back(image_objects_.size());
+  ForAllRanges("CopyAndFixupObjects", starts, &ImageWriter::CopyAndFixupObjectRange,
+               thread_count);
 }
 
-void ImageWriter::CopyAndFixupObjectsCallback(Object* object, void* arg) {
-  DCHECK(object != NULL);
-  DCHECK(arg != NULL);
-  const Object* obj = object;
-  ImageWriter* image_writer = reinterpret_cast<ImageWriter*>(arg);
+void ImageWriter::CopyAndFixupObjectRange(size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    CopyAndFixupObject(image_objects_[i]);
+  }
+}
 
+void ImageWriter::CopyAndFixupObject(const Object* obj) {
+  DCHECK(obj != NULL);
   // see GetLocalAddress for similar computation
-  size_t offset = image_writer->GetImageOffset(obj);
-  byte* dst = image_writer->image_->Begin() + offset;
+  size_t offset = GetImageOffset(obj);
+  byte* dst = image_->Begin() + offset;
   const byte* src = reinterpret_cast<const byte*>(obj);
   size_t n = obj->SizeOf();
-  DCHECK_LT(offset + n, image_writer->image_->Size());
+  DCHECK_LT(offset + n, image_->Size());
   memcpy(dst, src, n);
   Object* copy = reinterpret_cast<Object*>(dst);
   copy->SetField32(Object::MonitorOffset(), 0, false);  // We may have inflated the lock during compilation.
-  image_writer->FixupObject(obj, copy);
+  FixupObject(obj, copy);
 }
 
 void ImageWriter::FixupObject(const Object* orig, Object* copy) {
@@ -667,55 +825,81 @@ static ArtMethod* GetTargetMethod(const CompilerDriver::PatchInformation* patch)
   return method;
 }
 
-void ImageWriter::PatchOatCodeAndMethods() {
-  Thread* self = Thread::Current();
-  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
-  const char* old_cause = self->StartAssertNoThreadSuspension("ImageWriter");
-
-  typedef std::vector<const CompilerDriver::PatchInformation*> Patches;
-  const Patches& code_to_patch = compiler_driver_.GetCodeToPatch();
-  for (size_t i = 0; i < code_to_patch.size(); i++) {
-    const CompilerDriver::PatchInformation* patch = code_to_patch[i];
-    ArtMethod* target = GetTargetMethod(patch);
-    uint32_t code = reinterpret_cast<uint32_t>(class_linker->GetOatCodeFor(target));
-    uint32_t code_base = reinterpret_cast<uint32_t>(&oat_file_->GetOatHeader());
-    uint32_t code_offset = code - code_base;
-    SetPatchLocation(patch, reinterpret_cast<uint32_t>(GetOatAddress(code_offset)));
-  }
+void ImageWriter::PatchOatCodeAndMethods(size_t thread_count) {
+  ComputePatches(thread_count);
 
-  const Patches& methods_to_patch = compiler_driver_.GetMethodsToPatch();
-  for (size_t i = 0; i < methods_to_patch.size(); i++) {
-    const CompilerDriver::PatchInformation* patch = methods_to_patch[i];
-    ArtMethod* target = GetTargetMethod(patch);
-    SetPatchLocation(patch, reinterpret_cast<uint32_t>(GetImageAddress(target)));
+  OatHeader& oat_header = const_cast<OatHeader&>(oat_file_->GetOatHeader());
+  for (size_t i = 0; i < patch_locations_.size(); ++i) {
+    uint32_t* patch_location = patch_locations_[i];
+    uint32_t value = patch_values_[i];
+#ifndef NDEBUG
+    const CompilerDriver::PatchInformation* patch = GetPatch(i);
+    const DexFile::MethodId& id = patch->GetDexFile().GetMethodId(patch->GetTargetMethodIdx());
+    uint32_t expected = reinterpret_cast<uint32_t>(&id);
+    uint32_t actual = *patch_location;
+    CHECK(actual == expected || actual == value) << std::hex
+      << "actual=" << actual
+      << "expected=" << expected
+      << "value=" << value;
+#endif
+    *patch_location = value;
+    oat_header.UpdateChecksum(patch_location, sizeof(value));
   }
 
   // Update the image header with the new checksum after patching
   ImageHeader* image_header = reinterpret_cast<ImageHeader*>(image_->Begin());
   image_header->SetOatChecksum(oat_file_->GetOatHeader().GetChecksum());
-  self->EndAssertNoThreadSuspension(old_cause);
 }
 
-void ImageWriter::SetPatchLocation(const CompilerDriver::PatchInformation* patch, uint32_t value) {
+void ImageWriter::ComputePatches(size_t thread_count) {
+  size_t patch_count = compiler_driver_.GetCodeToPatch().size() +
+      compiler_driver_.GetMethodsToPatch().size();
+  patch_locations_.assign(patch_count, NULL);
+  patch_values_.assign(patch_count, 0);
+  size_t range_count = thread_count * kRangesPerThread;
+  std::vector<size_t> starts;
+  for (size_t i = 0; i < range_count; ++i) {
+    starts.push_back(patch_count / range_count * i);
+  }
+  starts.push_back(patch_count);
+  ForAllRanges("ComputePatches", starts, &ImageWriter::ComputePatchRange, thread_count);
+}
+
+const CompilerDriver::PatchInformation* ImageWriter::GetPatch(size_t index) const {
+  const std::vector<const CompilerDriver::PatchInformation*>& code_to_patch =
+      compiler_driver_.GetCodeToPatch();
+  if (index < code_to_patch.size()) {
+    return code_to_patch[index];
+  }
+  return compiler_driver_.GetMethodsToPatch()[index - code_to_patch.size()];
+}
+
+void ImageWriter::ComputePatchRange(size_t begin, size_t end) {
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  size_t code_patch_count = compiler_driver_.GetCodeToPatch().size();
+  for (size_t i = begin; i < end; ++i) {
+    const CompilerDriver::PatchInformation* patch = GetPatch(i);
+    ArtMethod* target = GetTargetMethod(patch);
+    if (i < code_patch_count) {
+      uint32_t code = reinterpret_cast<uint32_t>(class_linker->GetOatCodeFor(target));
+      uint32_t code_base = reinterpret_cast<uint32_t>(&oat_file_->GetOatHeader());
+      uint32_t code_offset = code - code_base;
+      patch_values_[i] = reinterpret_cast<uint32_t>(GetOatAddress(code_offset));
+    } else {
+      patch_values_[i] = reinterpret_cast<uint32_t>(GetImageAddress(target));
+    }
+    patch_locations_[i] = GetPatchLocation(patch);
+  }
+}
+
+uint32_t* ImageWriter::GetPatchLocation(const CompilerDriver::PatchInformation* patch) {
   ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
   const void* oat_code = class_linker->GetOatCodeFor(patch->GetDexFile(),
                                                      patch->GetReferrerClassDefIdx(),
                                                      patch->GetReferrerMethodIdx());
-  OatHeader& oat_header = const_cast<OatHeader&>(oat_file_->GetOatHeader());
   // TODO: make this Thumb2 specific
   uint8_t* base = reinterpret_cast<uint8_t*>(reinterpret_cast<uint32_t>(oat_code) & ~0x1);
-  uint32_t* patch_location = reinterpret_cast<uint32_t*>(base + patch->GetLiteralOffset());
-#ifndef NDEBUG
-  const DexFile::MethodId& id = patch->GetDexFile().GetMethodId(patch->GetTargetMethodIdx());
-  uint32_t expected = reinterpret_cast<uint32_t>(&id);
-  uint32_t actual = *patch_location;
-  CHECK(actual == expected || actual == value) << std::hex
-    << "actual=" << actual
-    << "expected=" << expected
-    << "value=" << value;
-#endif
-  *patch_location = value;
-  oat_header.UpdateChecksum(patch_location, sizeof(value));
+  return reinterpret_cast<uint32_t*>(base + patch->GetLiteralOffset());
 }
 
 }  // namespace art
@@ -22,8 +22,11 @@
 #include <cstddef>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "driver/compiler_driver.h"
+#include "image.h"
 #include "mem_map.h"
 #include "oat_file.h"
 #include "mirror/dex_cache.h"
@@ -37,8 +40,12 @@ namespace art {
 // Write a Space built during compilation for use during execution.
 class ImageWriter {
  public:
-  explicit ImageWriter(const CompilerDriver& compiler_driver)
-      : compiler_driver_(compiler_driver), oat_file_(NULL), image_end_(0), image_begin_(NULL),
+  // The startup classes, if given, are the descriptors of the classes an app touches while it
+  // starts. Their Class and ArtMethod objects are kept together in the image.
+  explicit ImageWriter(const CompilerDriver& compiler_driver,
+                       const CompilerDriver::DescriptorSet* startup_classes = NULL)
+      : compiler_driver_(compiler_driver), startup_classes_(startup_classes), oat_file_(NULL),
+        image_end_(0), image_begin_(NULL),
         oat_data_begin_(NULL), interpreter_to_interpreter_bridge_offset_(0),
         interpreter_to_compiled_code_bridge_offset_(0), portable_resolution_trampoline_offset_(0),
         quick_resolution_trampoline_offset_(0) {}
@@ -149,9 +156,28 @@ class ImageWriter {
   static void CalculateNewObjectOffsetsCallback(mirror::Object* obj, void* arg)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  // Creates the contiguous image in memory and adjusts pointers.
-  void CopyAndFixupObjects();
-  static void CopyAndFixupObjectsCallback(mirror::Object* obj, void* arg)
+  // Picks the bin an object is laid out in.
+  ImageHeader::ImageBin GetBin(mirror::Object* object) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  bool IsStartupClass(mirror::Class* klass) const SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static bool IsClassWritten(mirror::Class* klass) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static bool IsMethodWritten(mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Calls visitor on each of the ranges [starts[i], starts[i + 1]) using thread_count threads,
+  // the calling one included.
+  typedef void (ImageWriter::*RangeVisitor)(size_t begin, size_t end);
+  void ForAllRanges(const char* name, const std::vector<size_t>& starts, RangeVisitor visitor,
+                    size_t thread_count)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  class RangeTask;
+
+  // Creates the contiguous image in memory and adjusts pointers. Objects are independent of each
+  // other, so threads copy ranges of image offsets in any order.
+  void CopyAndFixupObjects(size_t thread_count) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void CopyAndFixupObjectRange(size_t begin, size_t end)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void CopyAndFixupObject(const mirror::Object* obj)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void FixupClass(const mirror::Class* orig, mirror::Class* copy)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -170,15 +196,22 @@ class ImageWriter {
                    bool is_static)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  // Patches references in OatFile to expect runtime addresses.
-  void PatchOatCodeAndMethods()
+  // Patches references in OatFile to expect runtime addresses. Looking up the targets is spread
+  // over the threads, the patches are applied in order as each one updates the oat checksum.
+  void PatchOatCodeAndMethods(size_t thread_count)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-  void SetPatchLocation(const CompilerDriver::PatchInformation* patch, uint32_t value)
+  void ComputePatches(size_t thread_count) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void ComputePatchRange(size_t begin, size_t end) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  const CompilerDriver::PatchInformation* GetPatch(size_t index) const;
+  uint32_t* GetPatchLocation(const CompilerDriver::PatchInformation* patch)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
 
   const CompilerDriver& compiler_driver_;
 
+  // Descriptors of the classes touched at startup, or NULL.
+  const CompilerDriver::DescriptorSet* const startup_classes_;
+
   // Map of Object to where it will be at runtime.
   SafeMap<const mirror::Object*, size_t> offsets_;
 
@@ -211,6 +244,24 @@ class ImageWriter {
 
   // DexCaches seen while scanning for fixing up CodeAndDirectMethods
   std::set<mirror::DexCache*> dex_caches_;
+
+  // The DexCaches and the arrays they resolve into.
+  std::set<const mirror::Object*> dex_cache_objects_;
+
+  // The objects of each bin in the order they are laid out, while offsets are being calculated.
+  std::vector<mirror::Object*> bins_[ImageHeader::kImageBinCount];
+
+  // Strings and the interned string with the same contents that they are replaced by.
+  std::vector<std::pair<mirror::Object*, mirror::Object*> > string_aliases_;
+
+  // The objects copied into the image in offset order, without the strings replaced by others.
+  std::vector<const mirror::Object*> image_objects_;
+
+  // Where each patch goes in the oat file and the value it writes there, code patches first.
+  std::vector<uint32_t*> patch_locations_;
+  std::vector<uint32_t> patch_values_;
+
+  friend class ImageTest;  // For checking the threaded passes against serial ones.
 };
 
 }  // namespace art
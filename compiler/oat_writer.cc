@@ -31,6 +31,7 @@
 #include "output_stream.h"
 #include "safe_map.h"
 #include "scoped_thread_state_change.h"
+#include "thread_pool.h"
 #include "verifier/method_verifier.h"
 
 namespace art {
@@ -46,6 +47,7 @@ OatWriter::OatWriter(const std::vector<const DexFile*>& dex_files,
     image_file_location_oat_begin_(image_file_location_oat_begin),
     image_file_location_(image_file_location),
     oat_header_(NULL),
+    written_size_(0),
     size_dex_file_alignment_(0),
     size_executable_offset_alignment_(0),
     size_oat_header_(0),
@@ -161,7 +163,7 @@ size_t OatWriter::InitOatClasses(size_t offset) {
         status = mirror::Class::kStatusNotReady;
       }
 
-      OatClass* oat_class = new OatClass(offset, status, num_methods);
+      OatClass* oat_class = new OatClass(offset, *dex_file, class_def_index, status, num_methods);
       oat_classes_.push_back(oat_class);
       offset += oat_class->SizeOf();
     }
@@ -208,75 +210,123 @@ size_t OatWriter::InitOatCode(size_t offset) {
 }
 
 size_t OatWriter::InitOatCodeDexFiles(size_t offset) {
-  size_t oat_class_index = 0;
-  for (size_t i = 0; i != dex_files_->size(); ++i) {
-    const DexFile* dex_file = (*dex_files_)[i];
-    CHECK(dex_file != NULL);
-    offset = InitOatCodeDexFile(offset, oat_class_index, *dex_file);
+  // Finding the compiled methods doesn't depend on the layout, so it is done in parallel.
+  ForAllClasses("FindCompiledMethods", &OatWriter::FindCompiledMethods);
+  // Offsets are assigned in file order, so the first method to use shared code or tables is the
+  // one they are written with.
+  for (size_t i = 0; i != oat_classes_.size(); ++i) {
+    offset = InitOatCodeClass(offset, oat_classes_[i]);
+  }
+  // Once the offsets are known each class can be checksummed on its own. Combining the results
+  // in file order gives the same checksum as updating it with every class in turn.
+  ForAllClasses("FinishOatClasses", &OatWriter::FinishOatClasses);
+  for (size_t i = 0; i != oat_classes_.size(); ++i) {
+    oat_header_->CombineChecksum(oat_classes_[i]->checksum_, oat_classes_[i]->checksum_length_);
   }
   return offset;
 }
 
-size_t OatWriter::InitOatCodeDexFile(size_t offset,
-                                     size_t& oat_class_index,
-                                     const DexFile& dex_file) {
-  for (size_t class_def_index = 0;
-       class_def_index < dex_file.NumClassDefs();
-       class_def_index++, oat_class_index++) {
-    const DexFile::ClassDef& class_def = dex_file.GetClassDef(class_def_index);
-    offset = InitOatCodeClassDef(offset, oat_class_index, class_def_index, dex_file, class_def);
-    oat_classes_[oat_class_index]->UpdateChecksum(*oat_header_);
+class OatWriter::ClassRangeTask : public Task {
+ public:
+  ClassRangeTask(OatWriter* oat_writer, ClassRangeVisitor visitor, size_t begin, size_t end)
+      : oat_writer_(oat_writer), visitor_(visitor), begin_(begin), end_(end) {}
+
+  virtual void Run(Thread* self) {
+    ScopedObjectAccess soa(self);
+    (oat_writer_->*visitor_)(begin_, end_);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  OatWriter* const oat_writer_;
+  const ClassRangeVisitor visitor_;
+  const size_t begin_;
+  const size_t end_;
+};
+
+// Classes differ a lot in how many methods they have, so each thread takes several ranges.
+static const size_t kClassRangesPerThread = 8;
+
+void OatWriter::ForAllClasses(const char* name, ClassRangeVisitor visitor) {
+  uint64_t start_ns = NanoTime();
+  size_t thread_count = compiler_driver_->GetThreadCount();
+  CHECK_GT(thread_count, 0U);
+  size_t range_count = thread_count * kClassRangesPerThread;
+  size_t class_count = oat_classes_.size();
+  Thread* self = Thread::Current();
+  // The tasks take the mutator lock themselves, including the ones this thread runs.
+  ScopedThreadStateChange tsc(self, kNative);
+  ThreadPool thread_pool(thread_count - 1);
+  for (size_t i = 0; i != range_count; ++i) {
+    size_t begin = class_count * i / range_count;
+    size_t end = class_count * (i + 1) / range_count;
+    if (begin != end) {
+      thread_pool.AddTask(self, new ClassRangeTask(this, visitor, begin, end));
+    }
   }
-  return offset;
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, true, false);
+  VLOG(compiler) << name << " took " << PrettyDuration(NanoTime() - start_ns) << " on "
+                 << thread_count << " threads";
 }
 
-size_t OatWriter::InitOatCodeClassDef(size_t offset,
-                                      size_t oat_class_index, size_t class_def_index,
-                                      const DexFile& dex_file,
-                                      const DexFile::ClassDef& class_def) {
-  const byte* class_data = dex_file.GetClassData(class_def);
-  if (class_data == NULL) {
-    // empty class, such as a marker interface
-    return offset;
-  }
-  ClassDataItemIterator it(dex_file, class_data);
-  CHECK_EQ(oat_classes_[oat_class_index]->method_offsets_.size(),
-           it.NumDirectMethods() + it.NumVirtualMethods());
-  // Skip fields
-  while (it.HasNextStaticField()) {
-    it.Next();
-  }
-  while (it.HasNextInstanceField()) {
-    it.Next();
-  }
-  // Process methods
-  size_t class_def_method_index = 0;
-  while (it.HasNextDirectMethod()) {
-    bool is_native = (it.GetMemberAccessFlags() & kAccNative) != 0;
-    offset = InitOatCodeMethod(offset, oat_class_index, class_def_index, class_def_method_index,
-                               is_native, it.GetMethodInvokeType(class_def), it.GetMemberIndex(),
-                               &dex_file);
-    class_def_method_index++;
-    it.Next();
+void OatWriter::FindCompiledMethods(size_t begin, size_t end) {
+  for (size_t i = begin; i != end; ++i) {
+    OatClass* oat_class = oat_classes_[i];
+    const DexFile& dex_file = *oat_class->dex_file_;
+    const DexFile::ClassDef& class_def = dex_file.GetClassDef(oat_class->class_def_index_);
+    const byte* class_data = dex_file.GetClassData(class_def);
+    if (class_data == NULL) {
+      // empty class, such as a marker interface
+      continue;
+    }
+    ClassDataItemIterator it(dex_file, class_data);
+    CHECK_EQ(oat_class->method_offsets_.size(), it.NumDirectMethods() + it.NumVirtualMethods());
+    // Skip fields
+    while (it.HasNextStaticField()) {
+      it.Next();
+    }
+    while (it.HasNextInstanceField()) {
+      it.Next();
+    }
+    // Process methods
+    oat_class->compiled_methods_.reserve(oat_class->method_offsets_.size());
+    while (it.HasNextDirectMethod() || it.HasNextVirtualMethod()) {
+      uint32_t method_idx = it.GetMemberIndex();
+      CompiledMethod* compiled_method =
+          compiler_driver_->GetCompiledMethod(MethodReference(&dex_file, method_idx));
+#if !defined(NDEBUG)
+      // We expect GC maps except when the class hasn't been verified or the method is native
+      if (compiled_method != NULL) {
+        bool is_native = (it.GetMemberAccessFlags() & kAccNative) != 0;
+        const std::vector<uint8_t>& gc_map = compiled_method->GetGcMap();
+        size_t gc_map_size = gc_map.size() * sizeof(gc_map[0]);
+        mirror::Class::Status status = oat_class->status_;
+        CHECK(gc_map_size != 0 || is_native || status < mirror::Class::kStatusVerified)
+            << &gc_map << " " << gc_map_size << " " << (is_native ? "true" : "false") << " "
+            << (status < mirror::Class::kStatusVerified) << " " << status << " "
+            << PrettyMethod(method_idx, dex_file);
+      }
+#endif
+      oat_class->compiled_methods_.push_back(compiled_method);
+      it.Next();
+    }
+    DCHECK(!it.HasNext());
   }
-  while (it.HasNextVirtualMethod()) {
-    bool is_native = (it.GetMemberAccessFlags() & kAccNative) != 0;
-    offset = InitOatCodeMethod(offset, oat_class_index, class_def_index, class_def_method_index,
-                               is_native, it.GetMethodInvokeType(class_def), it.GetMemberIndex(),
-                               &dex_file);
-    class_def_method_index++;
-    it.Next();
+}
+
+size_t OatWriter::InitOatCodeClass(size_t offset, OatClass* oat_class) {
+  for (size_t i = 0; i != oat_class->compiled_methods_.size(); ++i) {
+    offset = InitOatCodeMethod(offset, oat_class, i);
   }
-  DCHECK(!it.HasNext());
   return offset;
 }
 
-size_t OatWriter::InitOatCodeMethod(size_t offset, size_t oat_class_index,
-                                    size_t __attribute__((unused)) class_def_index,
-                                    size_t class_def_method_index,
-                                    bool __attribute__((unused)) is_native,
-                                    InvokeType invoke_type,
-                                    uint32_t method_idx, const DexFile* dex_file) {
+size_t OatWriter::InitOatCodeMethod(size_t offset, OatClass* oat_class,
+                                    size_t class_def_method_index) {
   // derived from CompiledMethod if available
   uint32_t code_offset = 0;
   uint32_t frame_size_in_bytes = kStackAlignment;
@@ -286,14 +336,12 @@ size_t OatWriter::InitOatCodeMethod(size_t offset, size_t oat_class_index,
   uint32_t vmap_table_offset = 0;
   uint32_t gc_map_offset = 0;
 
-  OatClass* oat_class = oat_classes_[oat_class_index];
 #if defined(ART_USE_PORTABLE_COMPILER)
   size_t oat_method_offsets_offset =
       oat_class->GetOatMethodOffsetsOffsetFromOatHeader(class_def_method_index);
 #endif
 
-  CompiledMethod* compiled_method =
-      compiler_driver_->GetCompiledMethod(MethodReference(dex_file, method_idx));
+  CompiledMethod* compiled_method = oat_class->compiled_methods_[class_def_method_index];
   if (compiled_method != NULL) {
 #if defined(ART_USE_PORTABLE_COMPILER)
     compiled_method->AddOatdataOffsetToCompliledCodeOffset(
@@ -315,7 +363,7 @@ size_t OatWriter::InitOatCodeMethod(size_t offset, size_t oat_class_index,
       code_offsets_.Put(&code, code_offset);
       offset += sizeof(code_size);  // code size is prepended before code
       offset += code_size;
-      oat_header_->UpdateChecksum(&code[0], code_size);
+      oat_class->new_blobs_.push_back(&code);
     }
 #endif
     frame_size_in_bytes = compiled_method->GetFrameSizeInBytes();
@@ -334,7 +382,9 @@ size_t OatWriter::InitOatCodeMethod(size_t offset, size_t oat_class_index,
     } else {
       mapping_table_offsets_.Put(&mapping_table, mapping_table_offset);
       offset += mapping_table_size;
-      oat_header_->UpdateChecksum(&mapping_table[0], mapping_table_size);
+      if (mapping_table_size != 0) {
+        oat_class->new_blobs_.push_back(&mapping_table);
+      }
     }
 
     const std::vector<uint8_t>& vmap_table = compiled_method->GetVmapTable();
@@ -349,31 +399,15 @@ size_t OatWriter::InitOatCodeMethod(size_t offset, size_t oat_class_index,
     } else {
       vmap_table_offsets_.Put(&vmap_table, vmap_table_offset);
       offset += vmap_table_size;
-      oat_header_->UpdateChecksum(&vmap_table[0], vmap_table_size);
+      if (vmap_table_size != 0) {
+        oat_class->new_blobs_.push_back(&vmap_table);
+      }
     }
 
     const std::vector<uint8_t>& gc_map = compiled_method->GetGcMap();
     size_t gc_map_size = gc_map.size() * sizeof(gc_map[0]);
     gc_map_offset = (gc_map_size == 0) ? 0 : offset;
 
-#if !defined(NDEBUG)
-    // We expect GC maps except when the class hasn't been verified or the method is native
-    ClassReference class_ref(dex_file, class_def_index);
-    CompiledClass* compiled_class = compiler_driver_->GetCompiledClass(class_ref);
-    mirror::Class::Status status;
-    if (compiled_class != NULL) {
-      status = compiled_class->GetStatus();
-    } else if (verifier::MethodVerifier::IsClassRejected(class_ref)) {
-      status = mirror::Class::kStatusError;
-    } else {
-      status = mirror::Class::kStatusNotReady;
-    }
-    CHECK(gc_map_size != 0 || is_native || status < mirror::Class::kStatusVerified)
-        << &gc_map << " " << gc_map_size << " " << (is_native ? "true" : "false") << " "
-        << (status < mirror::Class::kStatusVerified) << " " << status << " "
-        << PrettyMethod(method_idx, *dex_file);
-#endif
-
     // Deduplicate GC maps
     SafeMap<const std::vector<uint8_t>*, uint32_t>::iterator gc_map_iter =
         gc_map_offsets_.find(&gc_map);
@@ -382,7 +416,9 @@ size_t OatWriter::InitOatCodeMethod(size_t offset, size_t oat_class_index,
     } else {
       gc_map_offsets_.Put(&gc_map, gc_map_offset);
       offset += gc_map_size;
-      oat_header_->UpdateChecksum(&gc_map[0], gc_map_size);
+      if (gc_map_size != 0) {
+        oat_class->new_blobs_.push_back(&gc_map);
+      }
     }
   }
 
@@ -395,72 +431,109 @@ size_t OatWriter::InitOatCodeMethod(size_t offset, size_t oat_class_index,
                        vmap_table_offset,
                        gc_map_offset);
 
-  if (compiler_driver_->IsImage()) {
-    ClassLinker* linker = Runtime::Current()->GetClassLinker();
-    mirror::DexCache* dex_cache = linker->FindDexCache(*dex_file);
-    // Unchecked as we hold mutator_lock_ on entry.
-    ScopedObjectAccessUnchecked soa(Thread::Current());
-    mirror::ArtMethod* method = linker->ResolveMethod(*dex_file, method_idx, dex_cache,
-                                                           NULL, NULL, invoke_type);
+  return offset;
+}
+
+void OatWriter::FinishOatClasses(size_t begin, size_t end) {
+  for (size_t i = begin; i != end; ++i) {
+    oat_classes_[i]->ComputeChecksum();
+    if (compiler_driver_->IsImage()) {
+      UpdateMethods(*oat_classes_[i]);
+    }
+  }
+}
+
+void OatWriter::UpdateMethods(const OatClass& oat_class) {
+  const DexFile& dex_file = *oat_class.dex_file_;
+  const DexFile::ClassDef& class_def = dex_file.GetClassDef(oat_class.class_def_index_);
+  const byte* class_data = dex_file.GetClassData(class_def);
+  if (class_data == NULL) {
+    // empty class, such as a marker interface
+    return;
+  }
+  ClassLinker* linker = Runtime::Current()->GetClassLinker();
+  mirror::DexCache* dex_cache = linker->FindDexCache(dex_file);
+  ClassDataItemIterator it(dex_file, class_data);
+  // Skip fields
+  while (it.HasNextStaticField()) {
+    it.Next();
+  }
+  while (it.HasNextInstanceField()) {
+    it.Next();
+  }
+  // Process methods
+  size_t class_def_method_index = 0;
+  while (it.HasNextDirectMethod() || it.HasNextVirtualMethod()) {
+    const OatMethodOffsets& method_offsets = oat_class.method_offsets_[class_def_method_index];
+    InvokeType invoke_type = it.GetMethodInvokeType(class_def);
+    mirror::ArtMethod* method = linker->ResolveMethod(dex_file, it.GetMemberIndex(), dex_cache,
+                                                      NULL, NULL, invoke_type);
     CHECK(method != NULL);
-    method->SetFrameSizeInBytes(frame_size_in_bytes);
-    method->SetCoreSpillMask(core_spill_mask);
-    method->SetFpSpillMask(fp_spill_mask);
-    method->SetOatMappingTableOffset(mapping_table_offset);
+    method->SetFrameSizeInBytes(method_offsets.frame_size_in_bytes_);
+    method->SetCoreSpillMask(method_offsets.core_spill_mask_);
+    method->SetFpSpillMask(method_offsets.fp_spill_mask_);
+    method->SetOatMappingTableOffset(method_offsets.mapping_table_offset_);
     // Don't overwrite static method trampoline
     if (!method->IsStatic() || method->IsConstructor() ||
         method->GetDeclaringClass()->IsInitialized()) {
-      method->SetOatCodeOffset(code_offset);
+      method->SetOatCodeOffset(method_offsets.code_offset_);
     } else {
       method->SetEntryPointFromCompiledCode(NULL);
     }
-    method->SetOatVmapTableOffset(vmap_table_offset);
-    method->SetOatNativeGcMapOffset(gc_map_offset);
+    method->SetOatVmapTableOffset(method_offsets.vmap_table_offset_);
+    method->SetOatNativeGcMapOffset(method_offsets.gc_map_offset_);
+    class_def_method_index++;
+    it.Next();
   }
-
-  return offset;
 }
 
 #define DCHECK_OFFSET() \
-  DCHECK_EQ(static_cast<off_t>(file_offset + relative_offset), out.Seek(0, kSeekCurrent)) \
-    << "file_offset=" << file_offset << " relative_offset=" << relative_offset
+  DCHECK_EQ(relative_offset, written_size_)
 
 #define DCHECK_OFFSET_() \
-  DCHECK_EQ(static_cast<off_t>(file_offset + offset_), out.Seek(0, kSeekCurrent)) \
-    << "file_offset=" << file_offset << " offset_=" << offset_
+  DCHECK_EQ(offset_, oat_writer->written_size_)
 
 bool OatWriter::Write(OutputStream& out) {
+  uint64_t start_ns = NanoTime();
   const size_t file_offset = out.Seek(0, kSeekCurrent);
+  chunk_.reserve(kChunkSize);
+  written_size_ = 0;
 
-  if (!out.WriteFully(oat_header_, sizeof(*oat_header_))) {
+  if (!WriteData(out, oat_header_, sizeof(*oat_header_))) {
     PLOG(ERROR) << "Failed to write oat header to " << out.GetLocation();
     return false;
   }
   size_oat_header_ += sizeof(*oat_header_);
 
-  if (!out.WriteFully(image_file_location_.data(), image_file_location_.size())) {
+  if (!WriteData(out, image_file_location_.data(), image_file_location_.size())) {
     PLOG(ERROR) << "Failed to write oat header image file location to " << out.GetLocation();
     return false;
   }
   size_oat_header_image_file_location_ += image_file_location_.size();
 
-  if (!WriteTables(out, file_offset)) {
+  if (!WriteTables(out)) {
     LOG(ERROR) << "Failed to write oat tables to " << out.GetLocation();
     return false;
   }
 
-  size_t relative_offset = WriteCode(out, file_offset);
+  size_t relative_offset = WriteCode(out);
   if (relative_offset == 0) {
     LOG(ERROR) << "Failed to write oat code to " << out.GetLocation();
     return false;
   }
 
-  relative_offset = WriteCodeDexFiles(out, file_offset, relative_offset);
+  relative_offset = WriteCodeDexFiles(out, relative_offset);
   if (relative_offset == 0) {
     LOG(ERROR) << "Failed to write oat code for dex files to " << out.GetLocation();
     return false;
   }
 
+  if (!FlushChunk(out)) {
+    PLOG(ERROR) << "Failed to write oat data to " << out.GetLocation();
+    return false;
+  }
+  std::vector<uint8_t>().swap(chunk_);
+
   if (kIsDebugBuild) {
     uint32_t size_total = 0;
     #define DO_STAT(x) \
@@ -502,28 +575,61 @@ bool OatWriter::Write(OutputStream& out) {
 
   CHECK_EQ(file_offset + size_, static_cast<uint32_t>(out.Seek(0, kSeekCurrent)));
   CHECK_EQ(size_, relative_offset);
+  CHECK_EQ(size_, written_size_);
+
+  VLOG(compiler) << "Wrote " << PrettySize(size_) << " of oat data to " << out.GetLocation()
+                 << " in " << PrettyDuration(NanoTime() - start_ns);
+  return true;
+}
+
+bool OatWriter::WriteData(OutputStream& out, const void* data, size_t size) {
+  written_size_ += size;
+  if (chunk_.size() + size > kChunkSize) {
+    if (!FlushChunk(out)) {
+      return false;
+    }
+    if (size >= kChunkSize) {
+      // Large enough to go out on its own, such as a dex file.
+      return out.WriteFully(data, size);
+    }
+  }
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  chunk_.insert(chunk_.end(), bytes, bytes + size);
+  return true;
+}
 
+bool OatWriter::WritePadding(OutputStream& out, size_t size) {
+  written_size_ += size;
+  if (chunk_.size() + size > kChunkSize && !FlushChunk(out)) {
+    return false;
+  }
+  chunk_.resize(chunk_.size() + size, 0);
   return true;
 }
 
-bool OatWriter::WriteTables(OutputStream& out, const size_t file_offset) {
+bool OatWriter::FlushChunk(OutputStream& out) {
+  bool success = chunk_.empty() || out.WriteFully(&chunk_[0], chunk_.size());
+  chunk_.clear();
+  return success;
+}
+
+bool OatWriter::WriteTables(OutputStream& out) {
   for (size_t i = 0; i != oat_dex_files_.size(); ++i) {
-    if (!oat_dex_files_[i]->Write(this, out, file_offset)) {
+    if (!oat_dex_files_[i]->Write(this, out)) {
       PLOG(ERROR) << "Failed to write oat dex information to " << out.GetLocation();
       return false;
     }
   }
   for (size_t i = 0; i != oat_dex_files_.size(); ++i) {
-    uint32_t expected_offset = file_offset + oat_dex_files_[i]->dex_file_offset_;
-    off_t actual_offset = out.Seek(expected_offset, kSeekSet);
-    if (static_cast<uint32_t>(actual_offset) != expected_offset) {
-      const DexFile* dex_file = (*dex_files_)[i];
-      PLOG(ERROR) << "Failed to seek to dex file section. Actual: " << actual_offset
-                  << " Expected: " << expected_offset << " File: " << dex_file->GetLocation();
+    const DexFile* dex_file = (*dex_files_)[i];
+    // dex files are required to be 4 byte aligned
+    DCHECK_LE(written_size_, oat_dex_files_[i]->dex_file_offset_);
+    if (!WritePadding(out, oat_dex_files_[i]->dex_file_offset_ - written_size_)) {
+      PLOG(ERROR) << "Failed to align dex file section for " << dex_file->GetLocation()
+                  << " in " << out.GetLocation();
       return false;
     }
-    const DexFile* dex_file = (*dex_files_)[i];
-    if (!out.WriteFully(&dex_file->GetHeader(), dex_file->GetHeader().file_size_)) {
+    if (!WriteData(out, &dex_file->GetHeader(), dex_file->GetHeader().file_size_)) {
       PLOG(ERROR) << "Failed to write dex file " << dex_file->GetLocation()
                   << " to " << out.GetLocation();
       return false;
@@ -531,7 +637,7 @@ bool OatWriter::WriteTables(OutputStream& out, const size_t file_offset) {
     size_dex_file_ += dex_file->GetHeader().file_size_;
   }
   for (size_t i = 0; i != oat_classes_.size(); ++i) {
-    if (!oat_classes_[i]->Write(this, out, file_offset)) {
+    if (!oat_classes_[i]->Write(this, out)) {
       PLOG(ERROR) << "Failed to write oat methods information to " << out.GetLocation();
       return false;
     }
@@ -539,13 +645,10 @@ bool OatWriter::WriteTables(OutputStream& out, const size_t file_offset) {
   return true;
 }
 
-size_t OatWriter::WriteCode(OutputStream& out, const size_t file_offset) {
+size_t OatWriter::WriteCode(OutputStream& out) {
   size_t relative_offset = oat_header_->GetExecutableOffset();
-  off_t new_offset = out.Seek(size_executable_offset_alignment_, kSeekCurrent);
-  size_t expected_file_offset = file_offset + relative_offset;
-  if (static_cast<uint32_t>(new_offset) != expected_file_offset) {
-    PLOG(ERROR) << "Failed to seek to oat code section. Actual: " << new_offset
-                << " Expected: " << expected_file_offset << " File: " << out.GetLocation();
+  if (!WritePadding(out, size_executable_offset_alignment_)) {
+    PLOG(ERROR) << "Failed to align oat code section in " << out.GetLocation();
     return 0;
   }
   DCHECK_OFFSET();
@@ -556,11 +659,14 @@ size_t OatWriter::WriteCode(OutputStream& out, const size_t file_offset) {
       do { \
         uint32_t aligned_offset = CompiledCode::AlignCode(relative_offset, instruction_set); \
         uint32_t alignment_padding = aligned_offset - relative_offset; \
-        out.Seek(alignment_padding, kSeekCurrent); \
+        if (!WritePadding(out, alignment_padding)) { \
+          PLOG(ERROR) << "Failed to align " # field " in " << out.GetLocation(); \
+          return 0; \
+        } \
         size_trampoline_alignment_ += alignment_padding; \
-        if (!out.WriteFully(&(*field)[0], field->size())) { \
+        if (!WriteData(out, &(*field)[0], field->size())) { \
           PLOG(ERROR) << "Failed to write " # field " to " << out.GetLocation(); \
-          return false; \
+          return 0; \
         } \
         size_ ## field += field->size(); \
         relative_offset += alignment_padding + field->size(); \
@@ -579,30 +685,9 @@ size_t OatWriter::WriteCode(OutputStream& out, const size_t file_offset) {
   return relative_offset;
 }
 
-size_t OatWriter::WriteCodeDexFiles(OutputStream& out,
-                                    const size_t file_offset,
-                                    size_t relative_offset) {
-  size_t oat_class_index = 0;
-  for (size_t i = 0; i != oat_dex_files_.size(); ++i) {
-    const DexFile* dex_file = (*dex_files_)[i];
-    CHECK(dex_file != NULL);
-    relative_offset = WriteCodeDexFile(out, file_offset, relative_offset, oat_class_index,
-                                       *dex_file);
-    if (relative_offset == 0) {
-      return 0;
-    }
-  }
-  return relative_offset;
-}
-
-size_t OatWriter::WriteCodeDexFile(OutputStream& out, const size_t file_offset,
-                                   size_t relative_offset, size_t& oat_class_index,
-                                   const DexFile& dex_file) {
-  for (size_t class_def_index = 0; class_def_index < dex_file.NumClassDefs();
-      class_def_index++, oat_class_index++) {
-    const DexFile::ClassDef& class_def = dex_file.GetClassDef(class_def_index);
-    relative_offset = WriteCodeClassDef(out, file_offset, relative_offset, oat_class_index,
-                                        dex_file, class_def);
+size_t OatWriter::WriteCodeDexFiles(OutputStream& out, size_t relative_offset) {
+  for (size_t i = 0; i != oat_classes_.size(); ++i) {
+    relative_offset = WriteCodeClassDef(out, relative_offset, *oat_classes_[i]);
     if (relative_offset == 0) {
       return 0;
     }
@@ -616,12 +701,10 @@ void OatWriter::ReportWriteFailure(const char* what, uint32_t method_idx,
       << " to " << out.GetLocation();
 }
 
-size_t OatWriter::WriteCodeClassDef(OutputStream& out,
-                                    const size_t file_offset,
-                                    size_t relative_offset,
-                                    size_t oat_class_index,
-                                    const DexFile& dex_file,
-                                    const DexFile::ClassDef& class_def) {
+size_t OatWriter::WriteCodeClassDef(OutputStream& out, size_t relative_offset,
+                                    const OatClass& oat_class) {
+  const DexFile& dex_file = *oat_class.dex_file_;
+  const DexFile::ClassDef& class_def = dex_file.GetClassDef(oat_class.class_def_index_);
   const byte* class_data = dex_file.GetClassData(class_def);
   if (class_data == NULL) {
     // ie. an empty class such as a marker interface
@@ -637,20 +720,9 @@ size_t OatWriter::WriteCodeClassDef(OutputStream& out,
   }
   // Process methods
   size_t class_def_method_index = 0;
-  while (it.HasNextDirectMethod()) {
-    bool is_static = (it.GetMemberAccessFlags() & kAccStatic) != 0;
-    relative_offset = WriteCodeMethod(out, file_offset, relative_offset, oat_class_index,
-                                      class_def_method_index, is_static, it.GetMemberIndex(),
-                                      dex_file);
-    if (relative_offset == 0) {
-      return 0;
-    }
-    class_def_method_index++;
-    it.Next();
-  }
-  while (it.HasNextVirtualMethod()) {
-    relative_offset = WriteCodeMethod(out, file_offset, relative_offset, oat_class_index,
-                                      class_def_method_index, false, it.GetMemberIndex(), dex_file);
+  while (it.HasNextDirectMethod() || it.HasNextVirtualMethod()) {
+    relative_offset = WriteCodeMethod(out, relative_offset, oat_class, class_def_method_index,
+                                      it.GetMemberIndex());
     if (relative_offset == 0) {
       return 0;
     }
@@ -660,15 +732,13 @@ size_t OatWriter::WriteCodeClassDef(OutputStream& out,
   return relative_offset;
 }
 
-size_t OatWriter::WriteCodeMethod(OutputStream& out, const size_t file_offset,
-                                  size_t relative_offset, size_t oat_class_index,
-                                  size_t class_def_method_index, bool is_static,
-                                  uint32_t method_idx, const DexFile& dex_file) {
-  const CompiledMethod* compiled_method =
-      compiler_driver_->GetCompiledMethod(MethodReference(&dex_file, method_idx));
+size_t OatWriter::WriteCodeMethod(OutputStream& out, size_t relative_offset,
+                                  const OatClass& oat_class, size_t class_def_method_index,
+                                  uint32_t method_idx) {
+  const DexFile& dex_file = *oat_class.dex_file_;
+  const CompiledMethod* compiled_method = oat_class.compiled_methods_[class_def_method_index];
 
-  OatMethodOffsets method_offsets =
-      oat_classes_[oat_class_index]->method_offsets_[class_def_method_index];
+  OatMethodOffsets method_offsets = oat_class.method_offsets_[class_def_method_index];
 
 
   if (compiled_method != NULL) {  // ie. not an abstract method
@@ -676,14 +746,11 @@ size_t OatWriter::WriteCodeMethod(OutputStream& out, const size_t file_offset,
     uint32_t aligned_offset = compiled_method->AlignCode(relative_offset);
     uint32_t aligned_code_delta = aligned_offset - relative_offset;
     if (aligned_code_delta != 0) {
-      off_t new_offset = out.Seek(aligned_code_delta, kSeekCurrent);
-      size_code_alignment_ += aligned_code_delta;
-      uint32_t expected_offset = file_offset + aligned_offset;
-      if (static_cast<uint32_t>(new_offset) != expected_offset) {
-        PLOG(ERROR) << "Failed to seek to align oat code. Actual: " << new_offset
-                    << " Expected: " << expected_offset << " File: " << out.GetLocation();
+      if (!WritePadding(out, aligned_code_delta)) {
+        ReportWriteFailure("code alignment", method_idx, dex_file, out);
         return 0;
       }
+      size_code_alignment_ += aligned_code_delta;
       relative_offset += aligned_code_delta;
       DCHECK_OFFSET();
     }
@@ -700,14 +767,14 @@ size_t OatWriter::WriteCodeMethod(OutputStream& out, const size_t file_offset,
           << PrettyMethod(method_idx, dex_file);
     } else {
       DCHECK(code_offset == method_offsets.code_offset_) << PrettyMethod(method_idx, dex_file);
-      if (!out.WriteFully(&code_size, sizeof(code_size))) {
+      if (!WriteData(out, &code_size, sizeof(code_size))) {
         ReportWriteFailure("method code size", method_idx, dex_file, out);
         return 0;
       }
       size_code_size_ += sizeof(code_size);
       relative_offset += sizeof(code_size);
       DCHECK_OFFSET();
-      if (!out.WriteFully(&code[0], code_size)) {
+      if (!WriteData(out, &code[0], code_size)) {
         ReportWriteFailure("method code", method_idx, dex_file, out);
         return 0;
       }
@@ -732,7 +799,7 @@ size_t OatWriter::WriteCodeMethod(OutputStream& out, const size_t file_offset,
       DCHECK((mapping_table_size == 0 && method_offsets.mapping_table_offset_ == 0)
           || relative_offset == method_offsets.mapping_table_offset_)
           << PrettyMethod(method_idx, dex_file);
-      if (!out.WriteFully(&mapping_table[0], mapping_table_size)) {
+      if (!WriteData(out, &mapping_table[0], mapping_table_size)) {
         ReportWriteFailure("mapping table", method_idx, dex_file, out);
         return 0;
       }
@@ -756,7 +823,7 @@ size_t OatWriter::WriteCodeMethod(OutputStream& out, const size_t file_offset,
       DCHECK((vmap_table_size == 0 && method_offsets.vmap_table_offset_ == 0)
           || relative_offset == method_offsets.vmap_table_offset_)
           << PrettyMethod(method_idx, dex_file);
-      if (!out.WriteFully(&vmap_table[0], vmap_table_size)) {
+      if (!WriteData(out, &vmap_table[0], vmap_table_size)) {
         ReportWriteFailure("vmap table", method_idx, dex_file, out);
         return 0;
       }
@@ -780,7 +847,7 @@ size_t OatWriter::WriteCodeMethod(OutputStream& out, const size_t file_offset,
       DCHECK((gc_map_size == 0 && method_offsets.gc_map_offset_ == 0)
           || relative_offset == method_offsets.gc_map_offset_)
           << PrettyMethod(method_idx, dex_file);
-      if (!out.WriteFully(&gc_map[0], gc_map_size)) {
+      if (!WriteData(out, &gc_map[0], gc_map_size)) {
         ReportWriteFailure("GC map", method_idx, dex_file, out);
         return 0;
       }
@@ -820,32 +887,31 @@ void OatWriter::OatDexFile::UpdateChecksum(OatHeader& oat_header) const {
                             sizeof(methods_offsets_[0]) * methods_offsets_.size());
 }
 
-bool OatWriter::OatDexFile::Write(OatWriter* oat_writer,
-                                  OutputStream& out,
-                                  const size_t file_offset) const {
+bool OatWriter::OatDexFile::Write(OatWriter* oat_writer, OutputStream& out) const {
   DCHECK_OFFSET_();
-  if (!out.WriteFully(&dex_file_location_size_, sizeof(dex_file_location_size_))) {
+  if (!oat_writer->WriteData(out, &dex_file_location_size_, sizeof(dex_file_location_size_))) {
     PLOG(ERROR) << "Failed to write dex file location length to " << out.GetLocation();
     return false;
   }
   oat_writer->size_oat_dex_file_location_size_ += sizeof(dex_file_location_size_);
-  if (!out.WriteFully(dex_file_location_data_, dex_file_location_size_)) {
+  if (!oat_writer->WriteData(out, dex_file_location_data_, dex_file_location_size_)) {
     PLOG(ERROR) << "Failed to write dex file location data to " << out.GetLocation();
     return false;
   }
   oat_writer->size_oat_dex_file_location_data_ += dex_file_location_size_;
-  if (!out.WriteFully(&dex_file_location_checksum_, sizeof(dex_file_location_checksum_))) {
+  if (!oat_writer->WriteData(out, &dex_file_location_checksum_,
+                             sizeof(dex_file_location_checksum_))) {
     PLOG(ERROR) << "Failed to write dex file location checksum to " << out.GetLocation();
     return false;
   }
   oat_writer->size_oat_dex_file_location_checksum_ += sizeof(dex_file_location_checksum_);
-  if (!out.WriteFully(&dex_file_offset_, sizeof(dex_file_offset_))) {
+  if (!oat_writer->WriteData(out, &dex_file_offset_, sizeof(dex_file_offset_))) {
     PLOG(ERROR) << "Failed to write dex file offset to " << out.GetLocation();
     return false;
   }
   oat_writer->size_oat_dex_file_offset_ += sizeof(dex_file_offset_);
-  if (!out.WriteFully(&methods_offsets_[0],
-                      sizeof(methods_offsets_[0]) * methods_offsets_.size())) {
+  if (!oat_writer->WriteData(out, &methods_offsets_[0],
+                             sizeof(methods_offsets_[0]) * methods_offsets_.size())) {
     PLOG(ERROR) << "Failed to write methods offsets to " << out.GetLocation();
     return false;
   }
@@ -854,7 +920,9 @@ bool OatWriter::OatDexFile::Write(OatWriter* oat_writer,
   return true;
 }
 
-OatWriter::OatClass::OatClass(size_t offset, mirror::Class::Status status, uint32_t methods_count) {
+OatWriter::OatClass::OatClass(size_t offset, const DexFile& dex_file, uint16_t class_def_index,
+                              mirror::Class::Status status, uint32_t methods_count)
+    : dex_file_(&dex_file), class_def_index_(class_def_index), checksum_(0), checksum_length_(0) {
   offset_ = offset;
   status_ = status;
   method_offsets_.resize(methods_count);
@@ -875,32 +943,42 @@ size_t OatWriter::OatClass::SizeOf() const {
   return GetOatMethodOffsetsOffsetFromOatClass(method_offsets_.size());
 }
 
-void OatWriter::OatClass::UpdateChecksum(OatHeader& oat_header) const {
-  oat_header.UpdateChecksum(&status_, sizeof(status_));
-  oat_header.UpdateChecksum(&method_offsets_[0],
-                            sizeof(method_offsets_[0]) * method_offsets_.size());
+void OatWriter::OatClass::ComputeChecksum() {
+  uint32_t checksum = adler32(0L, Z_NULL, 0);
+  size_t length = 0;
+  for (size_t i = 0; i != new_blobs_.size(); ++i) {
+    const std::vector<uint8_t>& blob = *new_blobs_[i];
+    checksum = adler32(checksum, &blob[0], blob.size());
+    length += blob.size();
+  }
+  checksum = adler32(checksum, reinterpret_cast<const uint8_t*>(&status_), sizeof(status_));
+  length += sizeof(status_);
+  if (!method_offsets_.empty()) {
+    size_t method_offsets_size = sizeof(method_offsets_[0]) * method_offsets_.size();
+    checksum = adler32(checksum, reinterpret_cast<const uint8_t*>(&method_offsets_[0]),
+                       method_offsets_size);
+    length += method_offsets_size;
+  }
+  checksum_ = checksum;
+  checksum_length_ = length;
 }
 
-bool OatWriter::OatClass::Write(OatWriter* oat_writer,
-                                OutputStream& out,
-                                const size_t file_offset) const {
+bool OatWriter::OatClass::Write(OatWriter* oat_writer, OutputStream& out) const {
   DCHECK_OFFSET_();
-  if (!out.WriteFully(&status_, sizeof(status_))) {
+  if (!oat_writer->WriteData(out, &status_, sizeof(status_))) {
     PLOG(ERROR) << "Failed to write class status to " << out.GetLocation();
     return false;
   }
   oat_writer->size_oat_class_status_ += sizeof(status_);
-  DCHECK_EQ(static_cast<off_t>(file_offset + GetOatMethodOffsetsOffsetFromOatHeader(0)),
-            out.Seek(0, kSeekCurrent));
-  if (!out.WriteFully(&method_offsets_[0],
-                      sizeof(method_offsets_[0]) * method_offsets_.size())) {
+  DCHECK_EQ(GetOatMethodOffsetsOffsetFromOatHeader(0), oat_writer->written_size_);
+  if (!oat_writer->WriteData(out, &method_offsets_[0],
+                             sizeof(method_offsets_[0]) * method_offsets_.size())) {
     PLOG(ERROR) << "Failed to write method offsets to " << out.GetLocation();
     return false;
   }
   oat_writer->size_oat_class_method_offsets_ += sizeof(method_offsets_[0]) * method_offsets_.size();
-  DCHECK_EQ(static_cast<off_t>(file_offset +
-                               GetOatMethodOffsetsOffsetFromOatHeader(method_offsets_.size())),
-            out.Seek(0, kSeekCurrent));
+  DCHECK_EQ(GetOatMethodOffsetsOffsetFromOatHeader(method_offsets_.size()),
+            oat_writer->written_size_);
   return true;
 }
 
@@ -81,6 +81,8 @@ class OatWriter {
   ~OatWriter();
 
  private:
+  class OatClass;
+
   size_t InitOatHeader();
   size_t InitOatDexFiles(size_t offset);
   size_t InitDexFiles(size_t offset);
@@ -89,31 +91,32 @@ class OatWriter {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   size_t InitOatCodeDexFiles(size_t offset)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-  size_t InitOatCodeDexFile(size_t offset,
-                            size_t& oat_class_index,
-                            const DexFile& dex_file)
+  size_t InitOatCodeClass(size_t offset, OatClass* oat_class);
+  size_t InitOatCodeMethod(size_t offset, OatClass* oat_class, size_t class_def_method_index);
+
+  // Runs visitor over ranges of oat_classes_ on the compiler driver's threads.
+  typedef void (OatWriter::*ClassRangeVisitor)(size_t begin, size_t end);
+  void ForAllClasses(const char* name, ClassRangeVisitor visitor)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  class ClassRangeTask;
+  void FindCompiledMethods(size_t begin, size_t end)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-  size_t InitOatCodeClassDef(size_t offset,
-                             size_t oat_class_index, size_t class_def_index,
-                             const DexFile& dex_file,
-                             const DexFile::ClassDef& class_def)
+  void FinishOatClasses(size_t begin, size_t end)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-  size_t InitOatCodeMethod(size_t offset, size_t oat_class_index, size_t class_def_index,
-                           size_t class_def_method_index, bool is_native, InvokeType type,
-                           uint32_t method_idx, const DexFile*)
+  void UpdateMethods(const OatClass& oat_class)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  bool WriteTables(OutputStream& out, const size_t file_offset);
-  size_t WriteCode(OutputStream& out, const size_t file_offset);
-  size_t WriteCodeDexFiles(OutputStream& out, const size_t file_offset, size_t relative_offset);
-  size_t WriteCodeDexFile(OutputStream& out, const size_t file_offset, size_t relative_offset,
-                          size_t& oat_class_index, const DexFile& dex_file);
-  size_t WriteCodeClassDef(OutputStream& out, const size_t file_offset, size_t relative_offset,
-                           size_t oat_class_index, const DexFile& dex_file,
-                           const DexFile::ClassDef& class_def);
-  size_t WriteCodeMethod(OutputStream& out, const size_t file_offset, size_t relative_offset,
-                         size_t oat_class_index, size_t class_def_method_index, bool is_static,
-                         uint32_t method_idx, const DexFile& dex_file);
+  // The file is written front to back through chunk_, nothing is seeked over.
+  bool WriteData(OutputStream& out, const void* data, size_t size);
+  bool WritePadding(OutputStream& out, size_t size);
+  bool FlushChunk(OutputStream& out);
+
+  bool WriteTables(OutputStream& out);
+  size_t WriteCode(OutputStream& out);
+  size_t WriteCodeDexFiles(OutputStream& out, size_t relative_offset);
+  size_t WriteCodeClassDef(OutputStream& out, size_t relative_offset, const OatClass& oat_class);
+  size_t WriteCodeMethod(OutputStream& out, size_t relative_offset, const OatClass& oat_class,
+                         size_t class_def_method_index, uint32_t method_idx);
 
   void ReportWriteFailure(const char* what, uint32_t method_idx, const DexFile& dex_file,
                           OutputStream& out) const;
@@ -123,7 +126,7 @@ class OatWriter {
     explicit OatDexFile(size_t offset, const DexFile& dex_file);
     size_t SizeOf() const;
     void UpdateChecksum(OatHeader& oat_header) const;
-    bool Write(OatWriter* oat_writer, OutputStream& out, const size_t file_offset) const;
+    bool Write(OatWriter* oat_writer, OutputStream& out) const;
 
     // Offset of start of OatDexFile from beginning of OatHeader. It is
     // used to validate file position when writing.
@@ -142,12 +145,13 @@ class OatWriter {
 
   class OatClass {
    public:
-    explicit OatClass(size_t offset, mirror::Class::Status status, uint32_t methods_count);
+    OatClass(size_t offset, const DexFile& dex_file, uint16_t class_def_index,
+             mirror::Class::Status status, uint32_t methods_count);
     size_t GetOatMethodOffsetsOffsetFromOatHeader(size_t class_def_method_index_) const;
     size_t GetOatMethodOffsetsOffsetFromOatClass(size_t class_def_method_index_) const;
     size_t SizeOf() const;
-    void UpdateChecksum(OatHeader& oat_header) const;
-    bool Write(OatWriter* oat_writer, OutputStream& out, const size_t file_offset) const;
+    void ComputeChecksum();
+    bool Write(OatWriter* oat_writer, OutputStream& out) const;
 
     // Offset of start of OatClass from beginning of OatHeader. It is
     // used to validate file position when writing. For Portable, it
@@ -160,6 +164,18 @@ class OatWriter {
     mirror::Class::Status status_;
     std::vector<OatMethodOffsets> method_offsets_;
 
+    // layout state, not written
+    const DexFile* const dex_file_;
+    const uint16_t class_def_index_;
+    // NULL for methods without code, such as abstract methods.
+    std::vector<CompiledMethod*> compiled_methods_;
+    // Code and tables this class is the first to use, in file order. Only these are checksummed
+    // and written with the class, the others are shared with an earlier method.
+    std::vector<const std::vector<uint8_t>*> new_blobs_;
+    // Adler-32 of new_blobs_ and the data to write, and how many bytes it covers.
+    uint32_t checksum_;
+    size_t checksum_length_;
+
    private:
     DISALLOW_COPY_AND_ASSIGN(OatClass);
   };
@@ -189,6 +205,12 @@ class OatWriter {
   UniquePtr<const std::vector<uint8_t> > quick_resolution_trampoline_;
   UniquePtr<const std::vector<uint8_t> > quick_to_interpreter_bridge_;
 
+  // Writes are gathered here and handed to the OutputStream in chunks of up to kChunkSize.
+  static const size_t kChunkSize = 1 * MB;
+  std::vector<uint8_t> chunk_;
+  // Bytes passed to WriteData and WritePadding since the start of the oat data.
+  size_t written_size_;
+
   // output stats
   uint32_t size_dex_file_alignment_;
   uint32_t size_executable_offset_alignment_;
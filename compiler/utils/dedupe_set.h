@@ -17,63 +17,165 @@
 #ifndef ART_COMPILER_UTILS_DEDUPE_SET_H_
 #define ART_COMPILER_UTILS_DEDUPE_SET_H_
 
-#include <set>
+#include <algorithm>
+#include <new>
+#include <ostream>
+#include <vector>
 
+#include "base/logging.h"
+#include "base/macros.h"
 #include "base/mutex.h"
-#include "base/stl_util.h"
+#include "utils.h"
 
 namespace art {
 
-// A simple data structure to handle hashed deduplication. Add is thread safe.
-template <typename Key, typename HashType, typename HashFunc>
+// A data structure to handle hashed deduplication. Add is thread safe.
+//
+// The keys are spread over kShards independently locked open addressing tables, so that threads
+// adding keys with different hashes rarely wait for each other. A key is hashed and compared
+// against the stored ones in place, it is only copied when it isn't in the set yet. The copies
+// are constructed in blocks owned by their shard and live as long as the set.
+template <typename Key, typename HashType, typename HashFunc, size_t kShards = 16>
 class DedupeSet {
-  typedef std::pair<HashType, Key*> HashedKey;
+ public:
+  explicit DedupeSet(const char* set_name) : name_(set_name) {
+    COMPILE_ASSERT((kShards & (kShards - 1)) == 0, shard_count_must_be_a_power_of_two);
+  }
 
-  class Comparator {
+  // Returns the stored copy equal to key, making one first if there isn't one.
+  Key* Add(Thread* self, const Key& key) {
+    // The low bits pick the shard, so mix them with the others. A hash function that is poor in
+    // its low bits, such as one multiplying by an even number, would otherwise leave most shards
+    // unused.
+    HashType hash = MixHash(HashFunc()(key));
+    Shard& shard = shards_[hash & (kShards - 1)];
+    if (!shard.lock_.ExclusiveTryLock(self)) {
+      shard.lock_.ExclusiveLock(self);
+      shard.contended_++;
+    }
+    Key* result = shard.Add(hash / kShards, key);
+    shard.lock_.ExclusiveUnlock(self);
+    return result;
+  }
+
+  // Reports how many adds found a duplicate and how often threads waited for a shard.
+  void DumpStats(Thread* self, std::ostream& os) const {
+    size_t adds = 0;
+    size_t hits = 0;
+    size_t contended = 0;
+    size_t busiest = 0;
+    for (size_t i = 0; i < kShards; ++i) {
+      MutexLock mu(self, shards_[i].lock_);
+      adds += shards_[i].adds_;
+      hits += shards_[i].hits_;
+      contended += shards_[i].contended_;
+      busiest = std::max(busiest, shards_[i].adds_);
+    }
+    os << name_ << ": " << adds << " adds, " << hits << " duplicates ("
+       << (adds == 0 ? 0 : hits * 100 / adds) << "%), " << (adds - hits) << " unique, "
+       << contended << " contended (" << (adds == 0 ? 0 : contended * 100 / adds)
+       << "%), busiest shard " << busiest << " adds";
+  }
+
+ private:
+  class Shard {
    public:
-    bool operator()(const HashedKey& a, const HashedKey& b) const {
-      if (a.first < b.first) return true;
-      if (a.first > b.first) return true;
-      return *a.second < *b.second;
+    Shard()
+        : lock_("dedupe lock"), size_(0), last_block_used_(0), adds_(0), hits_(0), contended_(0) {
+      table_.resize(kInitialCapacity);
     }
-  };
 
-  typedef std::set<HashedKey, Comparator> Keys;
+    ~Shard() {
+      for (size_t i = 0; i < blocks_.size(); ++i) {
+        size_t used = kKeysPerBlock;
+        if (i + 1 == blocks_.size()) {
+          used = last_block_used_;
+        }
+        for (size_t j = 0; j < used; ++j) {
+          blocks_[i][j].~Key();
+        }
+        operator delete(blocks_[i]);
+      }
+    }
 
- public:
-  typedef typename Keys::iterator iterator;
-  typedef typename Keys::const_iterator const_iterator;
-  typedef typename Keys::size_type size_type;
-  typedef typename Keys::value_type value_type;
+    // Linear probing from the slot the hash picks, the table is never more than 3/4 full.
+    Key* Add(HashType hash, const Key& key) EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+      adds_++;
+      size_t mask = table_.size() - 1;
+      size_t index = hash & mask;
+      for (; table_[index].key != NULL; index = (index + 1) & mask) {
+        if (table_[index].hash == hash && *table_[index].key == key) {
+          hits_++;
+          return table_[index].key;
+        }
+      }
+      Entry entry;
+      entry.hash = hash;
+      entry.key = NewKey(key);
+      if ((size_ + 1) * 4 > table_.size() * 3) {
+        Grow();
+        Insert(entry);
+      } else {
+        table_[index] = entry;
+      }
+      size_++;
+      return entry.key;
+    }
 
-  iterator begin() { return keys_.begin(); }
-  const_iterator begin() const { return keys_.begin(); }
-  iterator end() { return keys_.end(); }
-  const_iterator end() const { return keys_.end(); }
+   private:
+    struct Entry {
+      Entry() : hash(0), key(NULL) {}
+      HashType hash;
+      Key* key;
+    };
 
-  Key* Add(Thread* self, const Key& key) {
-    HashType hash = HashFunc()(key);
-    HashedKey hashed_key(hash, const_cast<Key*>(&key));
-    MutexLock lock(self, lock_);
-    auto it = keys_.find(hashed_key);
-    if (it != keys_.end()) {
-      return it->second;
+    static const size_t kInitialCapacity = 64;
+    static const size_t kKeysPerBlock = 64;
+
+    Key* NewKey(const Key& key) EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+      if (blocks_.empty() || last_block_used_ == kKeysPerBlock) {
+        blocks_.push_back(static_cast<Key*>(operator new(sizeof(Key) * kKeysPerBlock)));
+        last_block_used_ = 0;
+      }
+      return new (&blocks_.back()[last_block_used_++]) Key(key);
     }
-    hashed_key.second = new Key(key);
-    keys_.insert(hashed_key);
-    return hashed_key.second;
-  }
 
-  DedupeSet() : lock_("dedupe lock") {
-  }
+    void Insert(const Entry& entry) EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+      size_t mask = table_.size() - 1;
+      size_t index = entry.hash & mask;
+      while (table_[index].key != NULL) {
+        index = (index + 1) & mask;
+      }
+      table_[index] = entry;
+    }
 
-  ~DedupeSet() {
-    STLDeleteValues(&keys_);
-  }
+    void Grow() EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+      std::vector<Entry> old_table(table_.size() * 2);
+      old_table.swap(table_);
+      for (size_t i = 0; i < old_table.size(); ++i) {
+        if (old_table[i].key != NULL) {
+          Insert(old_table[i]);
+        }
+      }
+    }
+
+    mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+    std::vector<Entry> table_ GUARDED_BY(lock_);
+    size_t size_ GUARDED_BY(lock_);
+    // The copies of the keys, all blocks but the last are full.
+    std::vector<Key*> blocks_ GUARDED_BY(lock_);
+    size_t last_block_used_ GUARDED_BY(lock_);
+    size_t adds_ GUARDED_BY(lock_);
+    size_t hits_ GUARDED_BY(lock_);
+    size_t contended_ GUARDED_BY(lock_);
+
+    friend class DedupeSet;
+    DISALLOW_COPY_AND_ASSIGN(Shard);
+  };
+
+  const char* const name_;
+  Shard shards_[kShards];
 
- private:
-  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
-  Keys keys_;
   DISALLOW_COPY_AND_ASSIGN(DedupeSet);
 };
 
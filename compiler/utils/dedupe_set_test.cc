@@ -14,6 +14,11 @@
  * limitations under the License.
  */
 
+#include <pthread.h>
+#include <stdio.h>
+
+#include <sstream>
+
 #include "common_test.h"
 #include "dedupe_set.h"
 
@@ -38,7 +43,7 @@ class DedupeHashFunc {
 TEST_F(DedupeSetTest, Test) {
   Thread* self = Thread::Current();
   typedef std::vector<uint8_t> ByteArray;
-  DedupeSet<ByteArray, size_t, DedupeHashFunc> deduplicator;
+  DedupeSet<ByteArray, size_t, DedupeHashFunc> deduplicator("test");
   ByteArray* array1;
   {
     ByteArray test1;
@@ -75,4 +80,121 @@ TEST_F(DedupeSetTest, Test) {
   }
 }
 
+typedef DedupeSet<std::vector<uint8_t>, size_t, DedupeHashFunc> ByteArraySet;
+
+static std::vector<uint8_t> MakeArray(size_t n) {
+  std::vector<uint8_t> array;
+  for (size_t i = 0; i <= n % 37; ++i) {
+    array.push_back(static_cast<uint8_t>(n >> (8 * (i % 4))));
+  }
+  return array;
+}
+
+// Enough distinct keys to grow every shard's table several times over.
+TEST_F(DedupeSetTest, ManyKeys) {
+  Thread* self = Thread::Current();
+  ByteArraySet deduplicator("test");
+  static const size_t kKeys = 20000;
+  std::vector<std::vector<uint8_t>*> first(kKeys);
+  for (size_t i = 0; i < kKeys; ++i) {
+    std::vector<uint8_t> array(MakeArray(i));
+    first[i] = deduplicator.Add(self, array);
+    ASSERT_EQ(array, *first[i]);
+  }
+  for (size_t i = 0; i < kKeys; ++i) {
+    ASSERT_EQ(first[i], deduplicator.Add(self, MakeArray(i)));
+  }
+  std::ostringstream oss;
+  deduplicator.DumpStats(self, oss);
+  EXPECT_NE(std::string::npos, oss.str().find(StringPrintf("%zd adds, %zd duplicates", 2 * kKeys,
+                                                            kKeys)));
+}
+
+// Only sets the bits above those picking the shard, like a hash multiplying by an even number.
+class HighBitsHashFunc {
+ public:
+  size_t operator()(const std::vector<uint8_t>& array) const {
+    size_t hash = 0;
+    for (uint8_t c : array) {
+      hash = hash * 256 + c;
+    }
+    return hash << 8;
+  }
+};
+
+TEST_F(DedupeSetTest, SpreadsKeysOverShards) {
+  Thread* self = Thread::Current();
+  DedupeSet<std::vector<uint8_t>, size_t, HighBitsHashFunc> deduplicator("test");
+  static const size_t kKeys = 1024;
+  for (size_t i = 0; i < kKeys; ++i) {
+    std::vector<uint8_t> array;
+    array.push_back(static_cast<uint8_t>(i >> 8));
+    array.push_back(static_cast<uint8_t>(i));
+    deduplicator.Add(self, array);
+  }
+  std::ostringstream oss;
+  deduplicator.DumpStats(self, oss);
+  size_t busiest;
+  size_t pos = oss.str().find("busiest shard ");
+  ASSERT_NE(std::string::npos, pos);
+  ASSERT_EQ(1, sscanf(oss.str().c_str() + pos, "busiest shard %zd adds", &busiest));
+  // The 16 shards get 64 keys each on average.
+  EXPECT_LT(busiest, kKeys / 8) << oss.str();
+}
+
+struct StressArgs {
+  ByteArraySet* deduplicator;
+  const std::vector<std::vector<uint8_t> >* arrays;
+  size_t offset;
+  std::vector<std::vector<uint8_t>*> results;
+};
+
+static void* StressAdd(void* arg) {
+  StressArgs* args = reinterpret_cast<StressArgs*>(arg);
+  const std::vector<std::vector<uint8_t> >& arrays = *args->arrays;
+  args->results.resize(arrays.size());
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    size_t index = (i + args->offset) % arrays.size();
+    args->results[index] = args->deduplicator->Add(NULL, arrays[index]);
+  }
+  return NULL;
+}
+
+// Adds the same mix of keys from several threads at once, each starting at a different point,
+// checks that they all got the same copies and reports the throughput.
+TEST_F(DedupeSetTest, StressBenchmark) {
+  static const size_t kThreads = 8;
+  static const size_t kArrays = 200000;
+  // Most arrays are duplicates, like the mapping tables and GC maps of small methods.
+  std::vector<std::vector<uint8_t> > arrays;
+  for (size_t i = 0; i < kArrays; ++i) {
+    arrays.push_back(MakeArray((i % 5 == 0) ? i : i % 1000));
+  }
+  ByteArraySet deduplicator("stress");
+  std::vector<StressArgs> args(kThreads);
+  std::vector<pthread_t> threads(kThreads);
+  uint64_t start_ns = NanoTime();
+  for (size_t i = 0; i < kThreads; ++i) {
+    args[i].deduplicator = &deduplicator;
+    args[i].arrays = &arrays;
+    args[i].offset = i * kArrays / kThreads;
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, StressAdd, &args[i]));
+  }
+  for (size_t i = 0; i < kThreads; ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+  }
+  uint64_t duration_ns = std::max<uint64_t>(NanoTime() - start_ns, 1);
+  for (size_t i = 0; i < kArrays; ++i) {
+    ASSERT_EQ(arrays[i], *args[0].results[i]);
+    for (size_t j = 1; j < kThreads; ++j) {
+      ASSERT_EQ(args[0].results[i], args[j].results[i]);
+    }
+  }
+  std::ostringstream oss;
+  deduplicator.DumpStats(NULL, oss);
+  LOG(INFO) << oss.str() << ", " << PrettyDuration(duration_ns) << ", "
+            << (static_cast<uint64_t>(kThreads * kArrays) * 1000000000 / duration_ns)
+            << " adds/s";
+}
+
 }  // namespace art
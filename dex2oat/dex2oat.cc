@@ -31,6 +31,7 @@
 #include "base/unix_file/fd_file.h"
 #include "class_linker.h"
 #include "dex_file-inl.h"
+#include "driver/compilation_cache.h"
 #include "driver/compiler_driver.h"
 #include "elf_fixup.h"
 #include "elf_stripper.h"
@@ -110,6 +111,10 @@ static void Usage(const char* fmt, ...) {
   UsageError("  --image-classes=<classname-file>: specifies classes to include in an image.");
   UsageError("      Example: --image=frameworks/base/preloaded-classes");
   UsageError("");
+  UsageError("  --startup-classes=<classname-file>: specifies classes touched while apps start,");
+  UsageError("      which are laid out together in the image.");
+  UsageError("      Example: --startup-classes=frameworks/base/startup-classes");
+  UsageError("");
   UsageError("  --base=<hex-address>: specifies the base address when creating a boot image.");
   UsageError("      Example: --base=0x50000000");
   UsageError("");
@@ -140,6 +145,11 @@ static void Usage(const char* fmt, ...) {
   UsageError("");
   UsageError("  --dump-timing: display a breakdown of where time was spent");
   UsageError("");
+  UsageError("  --compilation-cache=<directory>: reuse code compiled for unchanged methods by");
+  UsageError("      earlier runs, and keep newly compiled code there for later ones. Only used");
+  UsageError("      when compiling apps with the Quick backend.");
+  UsageError("      Example: --compilation-cache=/data/local/tmp/dex2oat-cache");
+  UsageError("");
   UsageError("  --runtime-arg <argument>: used to specify various arguments for the runtime,");
   UsageError("      such as initial heap size, maximum heap size, and verbose output.");
   UsageError("      Use a separate --runtime-arg switch for each argument.");
@@ -230,6 +240,7 @@ class Dex2Oat {
                                       const std::vector<const DexFile*>& dex_files,
                                       File* oat_file,
                                       const std::string& bitcode_filename,
+                                      const std::string& compilation_cache_dir,
                                       bool image,
                                       UniquePtr<CompilerDriver::DescriptorSet>& image_classes,
                                       bool dump_stats,
@@ -263,8 +274,16 @@ class Dex2Oat {
       driver->SetBitcodeFileName(bitcode_filename);
     }
 
+    if (!compilation_cache_dir.empty()) {
+      driver->SetCompilationCacheDirectory(compilation_cache_dir);
+    }
+
     driver->CompileAll(class_loader, dex_files, timings);
 
+    if (driver->GetCompilationCache() != NULL) {
+      driver->GetCompilationCache()->Dump(LOG(INFO));
+    }
+
     timings.NewSplit("dex2oat OatWriter");
     std::string image_file_location;
     uint32_t image_file_location_oat_checksum = 0;
@@ -286,6 +305,7 @@ class Dex2Oat {
                          image_file_location,
                          driver.get());
 
+    timings.NewSplit("dex2oat ElfWriter");
     if (!driver->WriteElf(android_root, is_host, dex_files, oat_writer, oat_file)) {
       LOG(ERROR) << "Failed to write ELF file " << oat_file->GetPath();
       return NULL;
@@ -298,12 +318,13 @@ class Dex2Oat {
                        uintptr_t image_base,
                        const std::string& oat_filename,
                        const std::string& oat_location,
-                       const CompilerDriver& compiler)
+                       const CompilerDriver& compiler,
+                       const CompilerDriver::DescriptorSet* startup_classes)
       LOCKS_EXCLUDED(Locks::mutator_lock_) {
     uintptr_t oat_data_begin;
     {
       // ImageWriter is scoped so it can free memory before doing FixupElf
-      ImageWriter image_writer(compiler);
+      ImageWriter image_writer(compiler, startup_classes);
       if (!image_writer.Write(image_filename, image_base, oat_filename, oat_location)) {
         LOG(ERROR) << "Failed to create image file " << image_filename;
         return false;
@@ -563,6 +584,13 @@ class WatchDog {
 const unsigned int WatchDog::kWatchDogWarningSeconds;
 const unsigned int WatchDog::kWatchDogTimeoutSeconds;
 
+static void DumpTiming(base::TimingLogger& timings, const CompilerDriver& compiler) {
+  LOG(INFO) << Dumpable<base::TimingLogger>(timings);
+  std::ostringstream utilization;
+  compiler.DumpPhaseUtilization(utilization);
+  LOG(INFO) << "Thread utilization:\n" << utilization.str();
+}
+
 static int dex2oat(int argc, char** argv) {
   base::TimingLogger timings("compiler", false, false);
 
@@ -585,8 +613,10 @@ static int dex2oat(int argc, char** argv) {
   std::string oat_location;
   int oat_fd = -1;
   std::string bitcode_filename;
+  std::string compilation_cache_dir;
   const char* image_classes_zip_filename = NULL;
   const char* image_classes_filename = NULL;
+  const char* startup_classes_filename = NULL;
   std::string image_filename;
   std::string boot_image_filename;
   uintptr_t image_base = 0;
@@ -660,6 +690,8 @@ static int dex2oat(int argc, char** argv) {
       image_classes_filename = option.substr(strlen("--image-classes=")).data();
     } else if (option.starts_with("--image-classes-zip=")) {
       image_classes_zip_filename = option.substr(strlen("--image-classes-zip=")).data();
+    } else if (option.starts_with("--startup-classes=")) {
+      startup_classes_filename = option.substr(strlen("--startup-classes=")).data();
     } else if (option.starts_with("--base=")) {
       const char* image_base_str = option.substr(strlen("--base=")).data();
       char* end;
@@ -701,6 +733,8 @@ static int dex2oat(int argc, char** argv) {
       runtime_args.push_back(argv[i]);
     } else if (option == "--dump-timing") {
       dump_timing = true;
+    } else if (option.starts_with("--compilation-cache=")) {
+      compilation_cache_dir = option.substr(strlen("--compilation-cache=")).data();
     } else {
       Usage("Unknown argument %s", option.data());
     }
@@ -769,6 +803,10 @@ static int dex2oat(int argc, char** argv) {
     Usage("--image-classes-zip should be used with --image-classes");
   }
 
+  if (startup_classes_filename != NULL && !image) {
+    Usage("--startup-classes should only be used with --image");
+  }
+
   if (dex_filenames.empty() && zip_fd == -1) {
     Usage("Input must be supplied with either --dex-file or --zip-fd");
   }
@@ -902,6 +940,15 @@ static int dex2oat(int argc, char** argv) {
     }
   }
 
+  UniquePtr<CompilerDriver::DescriptorSet> startup_classes(NULL);
+  if (startup_classes_filename != NULL) {
+    startup_classes.reset(dex2oat->ReadImageClassesFromFile(startup_classes_filename));
+    if (startup_classes.get() == NULL) {
+      LOG(ERROR) << "Failed to create list of startup classes from " << startup_classes_filename;
+      return EXIT_FAILURE;
+    }
+  }
+
   std::vector<const DexFile*> dex_files;
   if (boot_image_option.empty()) {
     dex_files = Runtime::Current()->GetClassLinker()->GetBootClassPath();
@@ -958,6 +1005,7 @@ static int dex2oat(int argc, char** argv) {
                                                                   dex_files,
                                                                   oat_file.get(),
                                                                   bitcode_filename,
+                                                                  compilation_cache_dir,
                                                                   image,
                                                                   image_classes,
                                                                   dump_stats,
@@ -1026,7 +1074,8 @@ static int dex2oat(int argc, char** argv) {
                                                            image_base,
                                                            oat_unstripped,
                                                            oat_location,
-                                                           *compiler.get());
+                                                           *compiler.get(),
+                                                           startup_classes.get());
     if (!image_creation_success) {
       return EXIT_FAILURE;
     }
@@ -1035,7 +1084,7 @@ static int dex2oat(int argc, char** argv) {
 
   if (is_host) {
     if (dump_timing || (dump_slow_timing && timings.GetTotalNs() > MsToNs(1000))) {
-      LOG(INFO) << Dumpable<base::TimingLogger>(timings);
+      DumpTiming(timings, *compiler.get());
     }
     return EXIT_SUCCESS;
   }
@@ -1076,7 +1125,7 @@ static int dex2oat(int argc, char** argv) {
   timings.EndSplit();
 
   if (dump_timing || (dump_slow_timing && timings.GetTotalNs() > MsToNs(1000))) {
-    LOG(INFO) << Dumpable<base::TimingLogger>(timings);
+    DumpTiming(timings, *compiler.get());
   }
 
   // Everything was successfully written, do an explicit exit here to avoid running Runtime
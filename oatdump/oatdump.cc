@@ -14,8 +14,10 @@
  * limitations under the License.
  */
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <fstream>
 #include <iostream>
@@ -71,6 +73,11 @@ static void usage() {
           "  --boot-image=<file.art>: provide the image file for the boot class path.\n"
           "      Example: --boot-image=/system/framework/boot.art\n"
           "\n");
+  fprintf(stderr,
+          "  --dirty-pages-pid=<pid>: with --image, reports which pages of each bin of the image\n"
+          "      the process has written, by comparing its mapping of the image with the file.\n"
+          "      Example: --dirty-pages-pid=$(pidof zygote)\n"
+          "\n");
   fprintf(stderr,
           "  --host-prefix may be used to translate host paths to target paths during\n"
           "      cross compilation.\n"
@@ -94,6 +101,16 @@ const char* image_roots_descriptions_[] = {
   "kClassRoots",
 };
 
+const char* image_bins_descriptions_[] = {
+  "kBinClean",
+  "kBinString",
+  "kBinMisc",
+  "kBinStartup",
+  "kBinClassDirty",
+  "kBinArtMethodDirty",
+  "kBinDexCache",
+};
+
 class OatDumper {
  public:
   explicit OatDumper(const std::string& host_prefix, const OatFile& oat_file)
@@ -664,9 +681,10 @@ class ImageDumper {
  public:
   explicit ImageDumper(std::ostream* os, const std::string& image_filename,
                        const std::string& host_prefix, gc::space::ImageSpace& image_space,
-                       const ImageHeader& image_header)
+                       const ImageHeader& image_header, pid_t dirty_pages_pid)
       : os_(os), image_filename_(image_filename), host_prefix_(host_prefix),
-        image_space_(image_space), image_header_(image_header) {}
+        image_space_(image_space), image_header_(image_header),
+        dirty_pages_pid_(dirty_pages_pid) {}
 
   void Dump() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     std::ostream& os = *os_;
@@ -687,6 +705,21 @@ class ImageDumper {
 
     os << "OAT FILE END:" << reinterpret_cast<void*>(image_header_.GetOatFileEnd()) << "\n\n";
 
+    {
+      os << "BINS:\n";
+      Indenter indent1_filter(os.rdbuf(), kIndentChar, kIndentBy1Count);
+      std::ostream indent1_os(&indent1_filter);
+      CHECK_EQ(arraysize(image_bins_descriptions_), size_t(ImageHeader::kImageBinCount));
+      for (int i = 0; i < ImageHeader::kImageBinCount; i++) {
+        ImageHeader::ImageBin bin = static_cast<ImageHeader::ImageBin>(i);
+        size_t begin = image_header_.GetBinBegin(bin);
+        size_t end = image_header_.GetBinEnd(bin);
+        indent1_os << StringPrintf("%s: 0x%08zx-0x%08zx %zd bytes\n", image_bins_descriptions_[i],
+                                   begin, end, end - begin);
+      }
+    }
+    os << "\n";
+
     {
       os << "ROOTS: " << reinterpret_cast<void*>(image_header_.GetImageRoots()) << "\n";
       Indenter indent1_filter(os.rdbuf(), kIndentChar, kIndentBy1Count);
@@ -794,6 +827,11 @@ class ImageDumper {
     stats_.Dump(os);
     os << "\n";
 
+    if (dirty_pages_pid_ != -1 && file.get() != NULL) {
+      DumpDirtyPages(os, *file.get());
+      os << "\n";
+    }
+
     os << std::flush;
 
     oat_dumper_->Dump(os);
@@ -1338,12 +1376,75 @@ class ImageDumper {
     // threshold, we assume 2 bytes per instruction and 2 instructions per block.
     kLargeMethodDexBytes = 16000
   };
+  // A page of the image that another process maps privately reads the same as the file until the
+  // process writes to it, so comparing the two shows what the process dirtied. Writes that leave a
+  // page as it was aren't counted.
+  void DumpDirtyPages(std::ostream& os, const File& image_file) {
+    os << "DIRTY PAGES OF PROCESS " << dirty_pages_pid_ << ":\n";
+    std::string mem_filename(StringPrintf("/proc/%d/mem", dirty_pages_pid_));
+    UniquePtr<File> mem_file(OS::OpenFileForReading(mem_filename.c_str()));
+    if (mem_file.get() == NULL) {
+      os << "Failed to open " << mem_filename << ": " << strerror(errno) << "\n";
+      return;
+    }
+    const size_t page_size = kPageSize;
+    std::vector<char> file_page(page_size);
+    std::vector<char> process_page(page_size);
+    size_t pages[ImageHeader::kImageBinCount] = {};
+    size_t dirty_pages[ImageHeader::kImageBinCount] = {};
+    int bin = 0;
+    size_t image_size = image_header_.GetImageSize();
+    uintptr_t image_begin = reinterpret_cast<uintptr_t>(image_header_.GetImageBegin());
+    for (size_t offset = 0; offset < image_size; offset += page_size) {
+      while (bin + 1 < ImageHeader::kImageBinCount &&
+             image_header_.GetBinBegin(static_cast<ImageHeader::ImageBin>(bin + 1)) <= offset) {
+        bin++;
+      }
+      size_t length = std::min(page_size, image_size - offset);
+      if (image_file.Read(&file_page[0], length, offset) != static_cast<int64_t>(length)) {
+        os << "Failed to read " << image_file.GetPath() << " at " << offset << "\n";
+        return;
+      }
+      if (mem_file->Read(&process_page[0], length, image_begin + offset) !=
+          static_cast<int64_t>(length)) {
+        os << "Failed to read " << mem_filename << " at "
+           << reinterpret_cast<void*>(image_begin + offset) << ": " << strerror(errno) << "\n";
+        return;
+      }
+      pages[bin]++;
+      if (memcmp(&file_page[0], &process_page[0], length) != 0) {
+        dirty_pages[bin]++;
+      }
+    }
+    Indenter indent1_filter(os.rdbuf(), kIndentChar, kIndentBy1Count);
+    std::ostream indent1_os(&indent1_filter);
+    size_t total_pages = 0;
+    size_t total_dirty_pages = 0;
+    for (int i = 0; i < ImageHeader::kImageBinCount; i++) {
+      indent1_os << StringPrintf("%-20s %6zd of %6zd pages dirty (%3.0f%%)\n",
+                                 image_bins_descriptions_[i], dirty_pages[i], pages[i],
+                                 PercentOfPages(dirty_pages[i], pages[i]));
+      total_pages += pages[i];
+      total_dirty_pages += dirty_pages[i];
+    }
+    indent1_os << StringPrintf("%-20s %6zd of %6zd pages dirty (%3.0f%%), %zd KB\n", "total",
+                               total_dirty_pages, total_pages,
+                               PercentOfPages(total_dirty_pages, total_pages),
+                               total_dirty_pages * page_size / KB);
+  }
+
+  static double PercentOfPages(size_t part, size_t whole) {
+    return whole == 0 ? 0.0 : part * 100.0 / whole;
+  }
+
   UniquePtr<OatDumper> oat_dumper_;
   std::ostream* os_;
   const std::string image_filename_;
   const std::string host_prefix_;
   gc::space::ImageSpace& image_space_;
   const ImageHeader& image_header_;
+  // The process whose dirty image pages are reported, or -1.
+  const pid_t dirty_pages_pid_;
 
   DISALLOW_COPY_AND_ASSIGN(ImageDumper);
 };
@@ -1363,6 +1464,7 @@ static int oatdump(int argc, char** argv) {
   const char* oat_filename = NULL;
   const char* image_filename = NULL;
   const char* boot_image_filename = NULL;
+  pid_t dirty_pages_pid = -1;
   std::string elf_filename_prefix;
   UniquePtr<std::string> host_prefix;
   std::ostream* os = &std::cout;
@@ -1376,6 +1478,15 @@ static int oatdump(int argc, char** argv) {
       image_filename = option.substr(strlen("--image=")).data();
     } else if (option.starts_with("--boot-image=")) {
       boot_image_filename = option.substr(strlen("--boot-image=")).data();
+    } else if (option.starts_with("--dirty-pages-pid=")) {
+      const char* pid_str = option.substr(strlen("--dirty-pages-pid=")).data();
+      char* end;
+      dirty_pages_pid = strtol(pid_str, &end, 10);
+      if (*pid_str == '\0' || *end != '\0' || dirty_pages_pid <= 0) {
+        fprintf(stderr, "Failed to parse --dirty-pages-pid argument '%s' as a process id\n",
+                pid_str);
+        usage();
+      }
     } else if (option.starts_with("--host-prefix=")) {
       host_prefix.reset(new std::string(option.substr(strlen("--host-prefix=")).data()));
     } else if (option.starts_with("--output=")) {
@@ -1402,6 +1513,11 @@ static int oatdump(int argc, char** argv) {
     return EXIT_FAILURE;
   }
 
+  if (dirty_pages_pid != -1 && image_filename == NULL) {
+    fprintf(stderr, "--dirty-pages-pid requires --image\n");
+    return EXIT_FAILURE;
+  }
+
   if (host_prefix.get() == NULL) {
     const char* android_product_out = getenv("ANDROID_PRODUCT_OUT");
     if (android_product_out != NULL) {
@@ -1465,7 +1581,8 @@ static int oatdump(int argc, char** argv) {
     fprintf(stderr, "Invalid image header %s\n", image_filename);
     return EXIT_FAILURE;
   }
-  ImageDumper image_dumper(os, image_filename, *host_prefix.get(), *image_space, image_header);
+  ImageDumper image_dumper(os, image_filename, *host_prefix.get(), *image_space, image_header,
+                           dirty_pages_pid);
   image_dumper.Dump();
   return EXIT_SUCCESS;
 }
@@ -19,6 +19,7 @@ LOCAL_PATH := $(call my-dir)
 include art/build/Android.common.mk
 
 LIBART_COMMON_SRC_FILES := \
+	array_copy.cc \
 	atomic.cc.arm \
 	barrier.cc \
 	base/logging.cc \
@@ -33,6 +34,7 @@ LIBART_COMMON_SRC_FILES := \
 	base/unix_file/string_file.cc \
 	check_jni.cc \
 	class_linker.cc \
+	class_table.cc \
 	common_throws.cc \
 	debugger.cc \
 	dex_file.cc \
@@ -44,19 +46,25 @@ LIBART_COMMON_SRC_FILES := \
 	disassembler_x86.cc \
 	elf_file.cc \
 	gc/allocator/dlmalloc.cc \
+	gc/allocator/rosalloc.cc \
 	gc/accounting/card_table.cc \
 	gc/accounting/gc_allocator.cc \
 	gc/accounting/heap_bitmap.cc \
 	gc/accounting/mod_union_table.cc \
+	gc/accounting/remembered_set.cc \
 	gc/accounting/space_bitmap.cc \
 	gc/collector/garbage_collector.cc \
 	gc/collector/mark_sweep.cc \
 	gc/collector/partial_mark_sweep.cc \
+	gc/collector/semi_space.cc \
 	gc/collector/sticky_mark_sweep.cc \
 	gc/heap.cc \
+	gc/space/bump_pointer_space.cc \
 	gc/space/dlmalloc_space.cc \
 	gc/space/image_space.cc \
 	gc/space/large_object_space.cc \
+	gc/space/malloc_space.cc \
+	gc/space/rosalloc_space.cc \
 	gc/space/space.cc \
 	hprof/hprof.cc \
 	image.cc \
@@ -64,6 +72,9 @@ LIBART_COMMON_SRC_FILES := \
 	instrumentation.cc \
 	intern_table.cc \
 	interpreter/interpreter.cc \
+	interpreter/interpreter_common.cc \
+	interpreter/interpreter_goto_table_impl.cc \
+	interpreter/interpreter_switch_impl.cc \
 	jdwp/jdwp_event.cc \
 	jdwp/jdwp_expand_buf.cc \
 	jdwp/jdwp_handler.cc \
@@ -156,6 +167,7 @@ LIBART_COMMON_SRC_FILES += \
 	entrypoints/portable/portable_throw_entrypoints.cc \
 	entrypoints/portable/portable_trampoline_entrypoints.cc \
 	entrypoints/quick/quick_alloc_entrypoints.cc \
+	entrypoints/quick/quick_arraycopy_entrypoints.cc \
 	entrypoints/quick/quick_cast_entrypoints.cc \
 	entrypoints/quick/quick_deoptimization_entrypoints.cc \
 	entrypoints/quick/quick_dexcache_entrypoints.cc \
@@ -110,6 +110,7 @@ extern "C" uint64_t art_quick_ushr_long(uint64_t, uint32_t);
 extern "C" int32_t __memcmp16(void*, void*, int32_t);
 extern "C" int32_t art_quick_indexof(void*, uint32_t, uint32_t, uint32_t);
 extern "C" int32_t art_quick_string_compareto(void*, void*);
+extern "C" int32_t art_quick_array_copy(const int32_t*);
 
 // Invoke entrypoints.
 extern "C" void art_quick_resolution_trampoline(mirror::ArtMethod*);
@@ -221,6 +222,7 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   qpoints->pMemcmp16 = __memcmp16;
   qpoints->pStringCompareTo = art_quick_string_compareto;
   qpoints->pMemcpy = memcpy;
+  qpoints->pArrayCopy = art_quick_array_copy;
 
   // Invocation
   qpoints->pQuickResolutionTrampoline = art_quick_resolution_trampoline;
@@ -93,6 +93,7 @@ extern "C" int32_t art_quick_memcmp16(void*, void*, int32_t);
 extern "C" int32_t art_quick_indexof(void*, uint32_t, uint32_t, uint32_t);
 extern "C" int32_t art_quick_string_compareto(void*, void*);
 extern "C" void* art_quick_memcpy(void*, const void*, size_t);
+extern "C" int32_t art_quick_array_copy(const int32_t*);
 
 // Invoke entrypoints.
 extern "C" void art_quick_resolution_trampoline(mirror::ArtMethod*);
@@ -203,6 +204,7 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   qpoints->pMemcmp16 = art_quick_memcmp16;
   qpoints->pStringCompareTo = art_quick_string_compareto;
   qpoints->pMemcpy = art_quick_memcpy;
+  qpoints->pArrayCopy = art_quick_array_copy;
 
   // Invocation
   qpoints->pQuickResolutionTrampoline = art_quick_resolution_trampoline;
@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "array_copy.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include <string.h>
+
+#include "common_throws.h"
+#include "gc/heap.h"
+#include "mirror/array.h"
+#include "mirror/class.h"
+#include "mirror/class-inl.h"
+#include "mirror/object-inl.h"
+#include "runtime.h"
+#include "thread.h"
+#include "utils.h"
+
+namespace art {
+
+/*
+ * We make guarantees about the atomicity of accesses to primitive
+ * variables.  These guarantees also apply to elements of arrays.
+ * In particular, 8-bit, 16-bit, and 32-bit accesses must be atomic and
+ * must not cause "word tearing".  Accesses to 64-bit array elements must
+ * either be atomic or treated as two 32-bit operations.  References are
+ * always read and written atomically, regardless of the number of bits
+ * used to represent them.
+ *
+ * We can't rely on standard libc functions like memcpy(3) and memmove(3)
+ * in our implementation of System.arraycopy, because they may copy
+ * byte-by-byte (either for the full run or for "unaligned" parts at the
+ * start or end).  The kernels below move the bulk of an array with 16-byte
+ * vector loads and stores, which access each naturally aligned element of
+ * the vector with a single access, and the ends an element at a time.
+ */
+
+// Number of bytes moved by each vector load and store.
+static const size_t kVectorSize = 16;
+
+#if defined(__SSE2__)
+template <typename T>
+static inline void MoveVector(T* dst, const T* src) {
+  __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), v);
+}
+#elif defined(__ARM_NEON__)
+// The element size of the NEON access is what keeps the elements from tearing, a byte sized one
+// could split them.
+static inline void MoveVector(uint16_t* dst, const uint16_t* src) {
+  vst1q_u16(dst, vld1q_u16(src));
+}
+
+static inline void MoveVector(uint32_t* dst, const uint32_t* src) {
+  vst1q_u32(dst, vld1q_u32(src));
+}
+
+static inline void MoveVector(uint64_t* dst, const uint64_t* src) {
+  vst1q_u32(reinterpret_cast<uint32_t*>(dst), vld1q_u32(reinterpret_cast<const uint32_t*>(src)));
+}
+#else
+template <typename T>
+static inline void MoveVector(T* dst, const T* src) {
+  // Load the whole block before storing any of it, the same as a vector would, so that blocks
+  // overlapping by less than their size are still moved correctly in either direction.
+  T block[kVectorSize / sizeof(T)];
+  for (size_t i = 0; i < kVectorSize / sizeof(T); ++i) {
+    block[i] = src[i];
+  }
+  for (size_t i = 0; i < kVectorSize / sizeof(T); ++i) {
+    dst[i] = block[i];
+  }
+}
+#endif
+
+template <typename T>
+static void MoveElements(T* dst, const T* src, size_t count) {
+  const size_t elements_per_vector = kVectorSize / sizeof(T);
+  DCHECK(IsAligned<sizeof(T)>(dst)) << dst;
+  DCHECK(IsAligned<sizeof(T)>(src)) << src;
+  if (count == 0 || dst == src) {
+    return;
+  }
+  // Copying forward is fine when the destination starts before the source, even if they overlap,
+  // since the reader stays ahead of the writer. Each vector is loaded before it is stored, so this
+  // also holds when they are less than a vector apart.
+  if (LIKELY(dst < src || static_cast<size_t>(dst - src) >= count)) {
+    // Align the destination so that the vector stores don't straddle cache lines.
+    while (count != 0 && !IsAligned<kVectorSize>(dst)) {
+      *dst++ = *src++;
+      --count;
+    }
+    for (; count >= elements_per_vector; count -= elements_per_vector) {
+      MoveVector(dst, src);
+      dst += elements_per_vector;
+      src += elements_per_vector;
+    }
+    while (count != 0) {
+      *dst++ = *src++;
+      --count;
+    }
+  } else {
+    // Copy backward, starting at the end.
+    dst += count;
+    src += count;
+    while (count != 0 && !IsAligned<kVectorSize>(dst)) {
+      *--dst = *--src;
+      --count;
+    }
+    for (; count >= elements_per_vector; count -= elements_per_vector) {
+      dst -= elements_per_vector;
+      src -= elements_per_vector;
+      MoveVector(dst, src);
+    }
+    while (count != 0) {
+      *--dst = *--src;
+      --count;
+    }
+  }
+}
+
+void MoveElements16(uint16_t* dst, const uint16_t* src, size_t count) {
+  MoveElements(dst, src, count);
+}
+
+void MoveElements32(uint32_t* dst, const uint32_t* src, size_t count) {
+  MoveElements(dst, src, count);
+}
+
+void MoveElements64(uint64_t* dst, const uint64_t* src, size_t count) {
+  MoveElements(dst, src, count);
+}
+
+static void ThrowArrayStoreException_NotAnArray(Thread* self, const char* identifier,
+                                                mirror::Object* array)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  std::string actualType(PrettyTypeOf(array));
+  ThrowLocation throw_location = self->GetCurrentLocationForThrow();
+  self->ThrowNewExceptionF(throw_location, "Ljava/lang/ArrayStoreException;",
+                           "%s of type %s is not an array", identifier, actualType.c_str());
+}
+
+void ArrayCopy(Thread* self, mirror::Object* srcObject, int32_t srcPos, mirror::Object* dstObject,
+               int32_t dstPos, int32_t length) {
+  // Null pointer checks.
+  if (UNLIKELY(srcObject == NULL)) {
+    ThrowNullPointerException(NULL, "src == null");
+    return;
+  }
+  if (UNLIKELY(dstObject == NULL)) {
+    ThrowNullPointerException(NULL, "dst == null");
+    return;
+  }
+
+  // Make sure source and destination are both arrays.
+  if (UNLIKELY(!srcObject->IsArrayInstance())) {
+    ThrowArrayStoreException_NotAnArray(self, "source", srcObject);
+    return;
+  }
+  if (UNLIKELY(!dstObject->IsArrayInstance())) {
+    ThrowArrayStoreException_NotAnArray(self, "destination", dstObject);
+    return;
+  }
+  mirror::Array* srcArray = srcObject->AsArray();
+  mirror::Array* dstArray = dstObject->AsArray();
+  mirror::Class* srcComponentType = srcArray->GetClass()->GetComponentType();
+  mirror::Class* dstComponentType = dstArray->GetClass()->GetComponentType();
+
+  // Bounds checking.
+  if (UNLIKELY(srcPos < 0 || dstPos < 0 || length < 0 ||
+               srcPos > srcArray->GetLength() - length ||
+               dstPos > dstArray->GetLength() - length)) {
+    ThrowLocation throw_location = self->GetCurrentLocationForThrow();
+    self->ThrowNewExceptionF(throw_location, "Ljava/lang/ArrayIndexOutOfBoundsException;",
+                             "src.length=%d srcPos=%d dst.length=%d dstPos=%d length=%d",
+                             srcArray->GetLength(), srcPos, dstArray->GetLength(), dstPos,
+                             length);
+    return;
+  }
+
+  // Handle primitive arrays.
+  if (srcComponentType->IsPrimitive() || dstComponentType->IsPrimitive()) {
+    // If one of the arrays holds a primitive type the other array must hold the exact same type.
+    if (UNLIKELY(srcComponentType != dstComponentType)) {
+      std::string srcType(PrettyTypeOf(srcArray));
+      std::string dstType(PrettyTypeOf(dstArray));
+      ThrowLocation throw_location = self->GetCurrentLocationForThrow();
+      self->ThrowNewExceptionF(throw_location, "Ljava/lang/ArrayStoreException;",
+                               "Incompatible types: src=%s, dst=%s",
+                               srcType.c_str(), dstType.c_str());
+      return;
+    }
+
+    size_t width = srcArray->GetClass()->GetComponentSize();
+    void* dstBytes = dstArray->GetRawData(width);
+    const void* srcBytes = srcArray->GetRawData(width);
+
+    switch (width) {
+    case 1:
+      memmove(reinterpret_cast<uint8_t*>(dstBytes) + dstPos,
+              reinterpret_cast<const uint8_t*>(srcBytes) + srcPos, length);
+      break;
+    case 2:
+      MoveElements16(reinterpret_cast<uint16_t*>(dstBytes) + dstPos,
+                     reinterpret_cast<const uint16_t*>(srcBytes) + srcPos, length);
+      break;
+    case 4:
+      MoveElements32(reinterpret_cast<uint32_t*>(dstBytes) + dstPos,
+                     reinterpret_cast<const uint32_t*>(srcBytes) + srcPos, length);
+      break;
+    case 8:
+      MoveElements64(reinterpret_cast<uint64_t*>(dstBytes) + dstPos,
+                     reinterpret_cast<const uint64_t*>(srcBytes) + srcPos, length);
+      break;
+    default:
+      LOG(FATAL) << "Unknown primitive array type: " << PrettyTypeOf(srcArray);
+    }
+
+    return;
+  }
+
+  // Neither class is primitive. Are the types trivially compatible?
+  COMPILE_ASSERT(sizeof(mirror::Object*) == sizeof(uint32_t), references_are_32_bit);
+  mirror::Object** dstObjects =
+      reinterpret_cast<mirror::Object**>(dstArray->GetRawData(sizeof(mirror::Object*))) + dstPos;
+  mirror::Object* const * srcObjects =
+      reinterpret_cast<mirror::Object* const *>(srcArray->GetRawData(sizeof(mirror::Object*))) +
+      srcPos;
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  if (dstArray == srcArray || dstComponentType->IsAssignableFrom(srcComponentType)) {
+    // Yes. One type check covers every element, so bulk copy and dirty the destination's card.
+    MoveElements32(reinterpret_cast<uint32_t*>(dstObjects),
+                   reinterpret_cast<const uint32_t*>(srcObjects), length);
+    heap->WriteBarrierArray(dstArray, dstPos, length);
+    return;
+  }
+
+  // The arrays are not trivially compatible. However, we may still be able to copy some or all of
+  // the elements if the source objects are compatible (for example, copying an Object[] to
+  // String[], the Objects being copied might actually be Strings).
+  // We can't do a bulk move because that would introduce a check-use race condition, so we copy
+  // elements one by one.
+
+  // We already dealt with overlapping copies, so we don't need to cope with that case below.
+  CHECK_NE(dstArray, srcArray);
+
+  // We want to avoid redundant IsAssignableFrom checks where possible, so we cache a class that
+  // we know is assignable to the destination array's component type.
+  mirror::Class* lastAssignableElementClass = dstComponentType;
+
+  mirror::Object* o = NULL;
+  int i = 0;
+  for (; i < length; ++i) {
+    o = srcObjects[i];
+    if (o != NULL) {
+      mirror::Class* oClass = o->GetClass();
+      if (lastAssignableElementClass == oClass) {
+        dstObjects[i] = o;
+      } else if (dstComponentType->IsAssignableFrom(oClass)) {
+        lastAssignableElementClass = oClass;
+        dstObjects[i] = o;
+      } else {
+        // Can't put this element into the array.
+        break;
+      }
+    } else {
+      dstObjects[i] = NULL;
+    }
+  }
+
+  // The card of the array covers all of its elements, so one mark is enough for the whole copy.
+  heap->WriteBarrierArray(dstArray, dstPos, length);
+  if (UNLIKELY(i != length)) {
+    std::string actualSrcType(PrettyTypeOf(o));
+    std::string dstType(PrettyTypeOf(dstArray));
+    ThrowLocation throw_location = self->GetCurrentLocationForThrow();
+    self->ThrowNewExceptionF(throw_location, "Ljava/lang/ArrayStoreException;",
+                             "source[%d] of type %s cannot be stored in destination array of "
+                             "type %s", srcPos + i, actualSrcType.c_str(), dstType.c_str());
+    return;
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_ARRAY_COPY_H_
+#define ART_RUNTIME_ARRAY_COPY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/mutex.h"
+
+namespace art {
+
+namespace mirror {
+  class Object;
+}  // namespace mirror
+class Thread;
+
+// Move count elements from src to dst like memmove(3), except that every element is read and
+// written with a single access so that concurrent readers never see a torn value. 64-bit elements
+// may be moved as two 32-bit halves, which is all the Java memory model asks for. The arrays must
+// be aligned to their element size and may overlap.
+void MoveElements16(uint16_t* dst, const uint16_t* src, size_t count);
+void MoveElements32(uint32_t* dst, const uint32_t* src, size_t count);
+void MoveElements64(uint64_t* dst, const uint64_t* src, size_t count);
+
+// Implements System.arraycopy, leaving the NullPointerException, ArrayStoreException or
+// ArrayIndexOutOfBoundsException pending on self when the copy isn't allowed.
+void ArrayCopy(Thread* self, mirror::Object* src, int32_t src_pos, mirror::Object* dst,
+               int32_t dst_pos, int32_t length)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_ARRAY_COPY_H_
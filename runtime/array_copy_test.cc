@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "array_copy.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "common_test.h"
+#include "mirror/array-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/object-inl.h"
+#include "mirror/object_array-inl.h"
+#include "mirror/string.h"
+#include "scoped_thread_state_change.h"
+#include "sirt_ref.h"
+
+namespace art {
+
+class ArrayCopyTest : public CommonTest {};
+
+// Moves every combination of source offset, destination offset and length within one buffer,
+// so that both directions and overlaps of less than a vector are covered, and checks the result
+// against memmove.
+template <typename T>
+static void TestMoveElements(void (*move)(T*, const T*, size_t)) {
+  static const size_t kLength = 80;
+  std::vector<T> buffer(kLength);
+  std::vector<T> expected(kLength);
+  for (size_t src = 0; src < kLength; ++src) {
+    for (size_t dst = 0; dst < kLength; ++dst) {
+      for (size_t count = 0; count <= kLength - std::max(src, dst); count += 3) {
+        for (size_t i = 0; i < kLength; ++i) {
+          buffer[i] = static_cast<T>(i + 1);
+          expected[i] = static_cast<T>(i + 1);
+        }
+        memmove(&expected[dst], &expected[src], count * sizeof(T));
+        move(&buffer[dst], &buffer[src], count);
+        ASSERT_TRUE(buffer == expected) << "src=" << src << " dst=" << dst << " count=" << count;
+      }
+    }
+  }
+}
+
+TEST_F(ArrayCopyTest, MoveElements) {
+  TestMoveElements<uint16_t>(MoveElements16);
+  TestMoveElements<uint32_t>(MoveElements32);
+  TestMoveElements<uint64_t>(MoveElements64);
+}
+
+TEST_F(ArrayCopyTest, PrimitiveArrays) {
+  ScopedObjectAccess soa(Thread::Current());
+  SirtRef<mirror::CharArray> chars(soa.Self(), mirror::CharArray::Alloc(soa.Self(), 40));
+  for (int32_t i = 0; i < chars->GetLength(); ++i) {
+    chars->Set(i, i);
+  }
+  // Overlapping copy within the same array.
+  ArrayCopy(soa.Self(), chars.get(), 3, chars.get(), 5, 30);
+  ASSERT_FALSE(soa.Self()->IsExceptionPending());
+  EXPECT_EQ(4, chars->Get(4));
+  EXPECT_EQ(3, chars->Get(5));
+  EXPECT_EQ(32, chars->Get(34));
+  EXPECT_EQ(35, chars->Get(35));
+
+  // The element types of primitive arrays must match exactly.
+  SirtRef<mirror::IntArray> ints(soa.Self(), mirror::IntArray::Alloc(soa.Self(), 40));
+  mirror::Class* ase = class_linker_->FindSystemClass("Ljava/lang/ArrayStoreException;");
+  ArrayCopy(soa.Self(), chars.get(), 0, ints.get(), 0, 1);
+  ASSERT_TRUE(soa.Self()->IsExceptionPending());
+  EXPECT_EQ(ase, soa.Self()->GetException(NULL)->GetClass());
+  soa.Self()->ClearException();
+
+  mirror::Class* aioobe =
+      class_linker_->FindSystemClass("Ljava/lang/ArrayIndexOutOfBoundsException;");
+  ArrayCopy(soa.Self(), ints.get(), 1, ints.get(), 0, 40);
+  ASSERT_TRUE(soa.Self()->IsExceptionPending());
+  EXPECT_EQ(aioobe, soa.Self()->GetException(NULL)->GetClass());
+  soa.Self()->ClearException();
+
+  mirror::Class* npe = class_linker_->FindSystemClass("Ljava/lang/NullPointerException;");
+  ArrayCopy(soa.Self(), NULL, 0, ints.get(), 0, 0);
+  ASSERT_TRUE(soa.Self()->IsExceptionPending());
+  EXPECT_EQ(npe, soa.Self()->GetException(NULL)->GetClass());
+  soa.Self()->ClearException();
+}
+
+TEST_F(ArrayCopyTest, ReferenceArrays) {
+  ScopedObjectAccess soa(Thread::Current());
+  mirror::Class* string_array_class = class_linker_->FindSystemClass("[Ljava/lang/String;");
+  SirtRef<mirror::ObjectArray<mirror::Object> > objects(soa.Self(),
+      class_linker_->AllocObjectArray<mirror::Object>(soa.Self(), 4));
+  SirtRef<mirror::ObjectArray<mirror::String> > strings(soa.Self(),
+      mirror::ObjectArray<mirror::String>::Alloc(soa.Self(), string_array_class, 4));
+  SirtRef<mirror::String> string(soa.Self(),
+                                 mirror::String::AllocFromModifiedUtf8(soa.Self(), "a"));
+  objects->Set(0, string.get());
+  objects->Set(2, string.get());
+  objects->Set(3, objects.get());
+
+  // The elements of an Object[] can be stored in a String[] when they are all strings or null.
+  ArrayCopy(soa.Self(), objects.get(), 0, strings.get(), 0, 3);
+  ASSERT_FALSE(soa.Self()->IsExceptionPending());
+  EXPECT_TRUE(strings->Get(0) == string.get());
+  EXPECT_TRUE(strings->Get(1) == NULL);
+  EXPECT_TRUE(strings->Get(2) == string.get());
+
+  // Elements are copied until one can't be stored.
+  ArrayCopy(soa.Self(), objects.get(), 2, strings.get(), 0, 2);
+  ASSERT_TRUE(soa.Self()->IsExceptionPending());
+  mirror::Class* ase = class_linker_->FindSystemClass("Ljava/lang/ArrayStoreException;");
+  EXPECT_EQ(ase, soa.Self()->GetException(NULL)->GetClass());
+  soa.Self()->ClearException();
+  EXPECT_TRUE(strings->Get(0) == string.get());
+  EXPECT_TRUE(strings->Get(1) == NULL);
+
+  // A String[] can always be copied to an Object[].
+  ArrayCopy(soa.Self(), strings.get(), 0, objects.get(), 1, 3);
+  ASSERT_FALSE(soa.Self()->IsExceptionPending());
+  EXPECT_TRUE(objects->Get(1) == string.get());
+  EXPECT_TRUE(objects->Get(2) == NULL);
+  EXPECT_TRUE(objects->Get(3) == string.get());
+}
+
+}  // namespace art
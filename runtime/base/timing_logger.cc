@@ -17,6 +17,7 @@
 
 #define ATRACE_TAG ATRACE_TAG_DALVIK
 #include <stdio.h>
+#include <string.h>
 #include <cutils/trace.h>
 
 #include "timing_logger.h"
@@ -58,6 +59,7 @@ void CumulativeLogger::Reset() {
   MutexLock mu(Thread::Current(), lock_);
   iterations_ = 0;
   STLDeleteValues(&histograms_);
+  counters_.clear();
 }
 
 uint64_t CumulativeLogger::GetTotalNs() const {
@@ -84,11 +86,17 @@ void CumulativeLogger::AddLogger(const base::TimingLogger &logger) {
     const char* split_name = split.second;
     AddPair(split_name, split_time);
   }
+  const base::TimingLogger::Counters& counters = logger.GetCounters();
+  for (base::TimingLogger::Counters::const_iterator it = counters.begin(), end = counters.end();
+       it != end; ++it) {
+    counters_[it->second] += it->first;
+  }
 }
 
 void CumulativeLogger::Dump(std::ostream &os) {
   MutexLock mu(Thread::Current(), lock_);
   DumpHistogram(os);
+  DumpCounters(os);
 }
 
 void CumulativeLogger::AddPair(const std::string &label, uint64_t delta_time) {
@@ -118,6 +126,17 @@ void CumulativeLogger::DumpHistogram(std::ostream &os) {
   os << "Done Dumping histograms \n";
 }
 
+void CumulativeLogger::DumpCounters(std::ostream &os) {
+  for (std::map<std::string, uint64_t>::const_iterator it = counters_.begin(),
+       end = counters_.end(); it != end; ++it) {
+    os << name_ << " " << it->first << ": " << it->second;
+    if (iterations_ != 0) {
+      os << " (" << it->second / iterations_ << " per iteration)";
+    }
+    os << "\n";
+  }
+}
+
 
 namespace base {
 
@@ -128,6 +147,7 @@ TimingLogger::TimingLogger(const char* name, bool precise, bool verbose)
 void TimingLogger::Reset() {
   current_split_ = NULL;
   splits_.clear();
+  counters_.clear();
 }
 
 void TimingLogger::StartSplit(const char* new_split_label) {
@@ -144,6 +164,17 @@ void TimingLogger::EndSplit() {
   delete current_split_;
 }
 
+void TimingLogger::AddCounter(const char* label, uint64_t value) {
+  DCHECK(label != NULL);
+  for (Counters::iterator it = counters_.begin(), end = counters_.end(); it != end; ++it) {
+    if (strcmp(it->second, label) == 0) {
+      it->first += value;
+      return;
+    }
+  }
+  counters_.push_back(Counter(value, label));
+}
+
 // Ends the current split and starts the one given by the label.
 void TimingLogger::NewSplit(const char* new_split_label) {
   CHECK(current_split_ != NULL) << "Inserting a new split (" << new_split_label
@@ -189,6 +220,9 @@ void TimingLogger::Dump(std::ostream &os) const {
        << split.second << "\n";
   }
   os << name_ << ": end, " << NsToMs(total_ns) << " ms\n";
+  for (Counters::const_iterator it = counters_.begin(), end = counters_.end(); it != end; ++it) {
+    os << name_ << ": " << it->first << " " << it->second << "\n";
+  }
 }
 
 
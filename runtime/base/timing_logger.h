@@ -53,9 +53,12 @@ class CumulativeLogger {
   void AddPair(const std::string &label, uint64_t delta_time)
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
   void DumpHistogram(std::ostream &os) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void DumpCounters(std::ostream &os) EXCLUSIVE_LOCKS_REQUIRED(lock_);
   uint64_t GetTotalTime() const;
   static const uint64_t kAdjust = 1000;
   Histograms histograms_ GUARDED_BY(lock_);
+  // Sums of the counters of the added loggers.
+  std::map<std::string, uint64_t> counters_ GUARDED_BY(lock_);
   std::string name_;
   const std::string lock_name_;
   mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
@@ -74,6 +77,9 @@ class TimingLogger {
   typedef std::pair<uint64_t, const char*> SplitTiming;
   typedef std::vector<SplitTiming> SplitTimings;
   typedef std::vector<SplitTiming>::const_iterator SplitTimingsIterator;
+  // Counters are values and counter names, for events which aren't measured in time.
+  typedef std::pair<uint64_t, const char*> Counter;
+  typedef std::vector<Counter> Counters;
 
   explicit TimingLogger(const char* name, bool precise, bool verbose);
 
@@ -89,6 +95,9 @@ class TimingLogger {
   // Ends the current split and records the end time.
   void EndSplit();
 
+  // Adds value to the counter of the given name.
+  void AddCounter(const char* label, uint64_t value);
+
   uint64_t GetTotalNs() const;
 
   void Dump(std::ostream& os) const;
@@ -139,6 +148,10 @@ class TimingLogger {
     return splits_;
   }
 
+  const Counters& GetCounters() const {
+    return counters_;
+  }
+
   friend class ScopedSplit;
  protected:
   // The name of the timing logger.
@@ -157,6 +170,9 @@ class TimingLogger {
   // Splits that have ended.
   SplitTimings splits_;
 
+  // Counters in the order they were first added.
+  Counters counters_;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(TimingLogger);
 };
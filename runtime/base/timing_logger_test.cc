@@ -157,4 +157,25 @@ TEST_F(TimingLoggerTest, ScopedAndExplicit) {
   EXPECT_STREQ(splits[3].second, outersplit);
 }
 
+TEST_F(TimingLoggerTest, Counters) {
+  const char* counter1name = "First Counter";
+  const char* counter2name = "Second Counter";
+  base::TimingLogger timings("Counters", true, false);
+
+  timings.AddCounter(counter1name, 3);
+  timings.AddCounter(counter2name, 5);
+  timings.AddCounter(counter1name, 4);
+
+  const base::TimingLogger::Counters& counters = timings.GetCounters();
+
+  EXPECT_EQ(2U, counters.size());
+  EXPECT_STREQ(counters[0].second, counter1name);
+  EXPECT_EQ(7U, counters[0].first);
+  EXPECT_STREQ(counters[1].second, counter2name);
+  EXPECT_EQ(5U, counters[1].first);
+
+  timings.Reset();
+  EXPECT_TRUE(timings.GetCounters().empty());
+}
+
 }  // namespace art
@@ -64,6 +64,7 @@
 #include "stack_indirect_reference_table.h"
 #include "thread.h"
 #include "UniquePtr.h"
+#include "utf.h"
 #include "utils.h"
 #include "verifier/method_verifier.h"
 #include "well_known_classes.h"
@@ -123,15 +124,6 @@ static void WrapExceptionInInitializer() SHARED_LOCKS_REQUIRED(Locks::mutator_lo
   }
 }
 
-static size_t Hash(const char* s) {
-  // This is the java.lang.String hashcode for convenience, not interoperability.
-  size_t hash = 0;
-  for (; *s != '\0'; ++s) {
-    hash = hash * 31 + *s;
-  }
-  return hash;
-}
-
 const char* ClassLinker::class_roots_descriptors_[] = {
   "Ljava/lang/Class;",
   "Ljava/lang/Object;",
@@ -187,8 +179,6 @@ ClassLinker* ClassLinker::CreateFromImage(InternTable* intern_table) {
 ClassLinker::ClassLinker(InternTable* intern_table)
     // dex_lock_ is recursive as it may be used in stack dumping.
     : dex_lock_("ClassLinker dex lock", kDefaultMutexLevel),
-      dex_cache_image_class_lookup_required_(false),
-      failed_dex_cache_class_lookups_(0),
       class_roots_(NULL),
       array_iftable_(NULL),
       init_done_(false),
@@ -1015,7 +1005,6 @@ void ClassLinker::InitFromImage() {
 
   gc::Heap* heap = Runtime::Current()->GetHeap();
   gc::space::ImageSpace* space = heap->GetImageSpace();
-  dex_cache_image_class_lookup_required_ = true;
   CHECK(space != NULL);
   OatFile& oat_file = GetImageOatFile(space);
   CHECK_EQ(oat_file.GetOatHeader().GetImageFileLocationOatChecksum(), 0U);
@@ -1085,6 +1074,8 @@ void ClassLinker::InitFromImage() {
   mirror::Throwable::SetClass(GetClassRoot(kJavaLangThrowable));
   mirror::StackTraceElement::SetClass(GetClassRoot(kJavaLangStackTraceElement));
 
+  AddImageClassesToClassTable();
+
   FinishInit();
 
   VLOG(startup) << "ClassLinker::InitFromImage exiting";
@@ -1094,13 +1085,13 @@ void ClassLinker::InitFromImage() {
 // reinit references to when reinitializing a ClassLinker from a
 // mapped image.
 void ClassLinker::VisitRoots(RootVisitor* visitor, void* arg, bool only_dirty, bool clean_dirty) {
-  visitor(class_roots_, arg);
+  class_roots_ = down_cast<mirror::ObjectArray<mirror::Class>*>(visitor(class_roots_, arg));
   Thread* self = Thread::Current();
   {
     ReaderMutexLock mu(self, dex_lock_);
     if (!only_dirty || dex_caches_dirty_) {
-      for (mirror::DexCache* dex_cache : dex_caches_) {
-        visitor(dex_cache, arg);
+      for (mirror::DexCache*& dex_cache : dex_caches_) {
+        dex_cache = down_cast<mirror::DexCache*>(visitor(dex_cache, arg));
       }
       if (clean_dirty) {
         dex_caches_dirty_ = false;
@@ -1111,31 +1102,28 @@ void ClassLinker::VisitRoots(RootVisitor* visitor, void* arg, bool only_dirty, b
   {
     ReaderMutexLock mu(self, *Locks::classlinker_classes_lock_);
     if (!only_dirty || class_table_dirty_) {
-      for (const std::pair<size_t, mirror::Class*>& it : class_table_) {
-        visitor(it.second, arg);
-      }
+      class_table_.VisitRoots(visitor, arg);
       if (clean_dirty) {
         class_table_dirty_ = false;
       }
     }
+    // In a pause no thread can still be probing the slot arrays replaced by a resize.
+    if (Locks::mutator_lock_->IsExclusiveHeld(self)) {
+      class_table_.DeleteOldSlots();
+    }
 
     // We deliberately ignore the class roots in the image since we
     // handle image roots by using the MS/CMS rescanning of dirty cards.
   }
 
-  visitor(array_iftable_, arg);
+  array_iftable_ = down_cast<mirror::IfTable*>(visitor(array_iftable_, arg));
 }
 
 void ClassLinker::VisitClasses(ClassVisitor* visitor, void* arg) {
-  if (dex_cache_image_class_lookup_required_) {
-    MoveImageClassesToClassTable();
-  }
   ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  for (const std::pair<size_t, mirror::Class*>& it : class_table_) {
-    if (!visitor(it.second, arg)) {
-      return;
-    }
-  }
+  class_table_.VisitClasses([visitor, arg](mirror::Class* klass) {
+    return visitor(klass, arg);
+  });
 }
 
 static bool GetClassesVisitor(mirror::Class* c, void* arg) {
@@ -1384,6 +1372,11 @@ mirror::Class* ClassLinker::DefineClass(const char* descriptor,
                                         const DexFile& dex_file,
                                         const DexFile::ClassDef& dex_class_def) {
   Thread* self = Thread::Current();
+  if (UNLIKELY(!dex_file.VerifyClassDef(dex_class_def))) {
+    ThrowClassFormatError(NULL, "Malformed class data for %s in %s", descriptor,
+                          dex_file.GetLocation().c_str());
+    return NULL;
+  }
   SirtRef<mirror::Class> klass(self, NULL);
   // Load the class from the dex file.
   if (UNLIKELY(!init_done_)) {
@@ -1421,7 +1414,8 @@ mirror::Class* ClassLinker::DefineClass(const char* descriptor,
   klass->SetClinitThreadId(self->GetTid());
   {
     // Add the newly loaded class to the loaded classes table.
-    mirror::Class* existing = InsertClass(descriptor, klass.get(), Hash(descriptor));
+    mirror::Class* existing = InsertClass(descriptor, klass.get(),
+                                          ComputeModifiedUtf8Hash(descriptor));
     if (existing != NULL) {
       // We failed to insert because we raced with another thread. Calling EnsureResolved may cause
       // this thread to block.
@@ -2022,7 +2016,8 @@ mirror::Class* ClassLinker::InitializePrimitiveClass(mirror::Class* primitive_cl
   primitive_class->SetPrimitiveType(type);
   primitive_class->SetStatus(mirror::Class::kStatusInitialized, self);
   const char* descriptor = Primitive::Descriptor(type);
-  mirror::Class* existing = InsertClass(descriptor, primitive_class, Hash(descriptor));
+  mirror::Class* existing = InsertClass(descriptor, primitive_class,
+                                        ComputeModifiedUtf8Hash(descriptor));
   CHECK(existing == NULL) << "InitPrimitiveClass(" << type << ") failed";
   return primitive_class;
 }
@@ -2149,7 +2144,8 @@ mirror::Class* ClassLinker::CreateArrayClass(const char* descriptor,
 
   new_class->SetAccessFlags(access_flags);
 
-  mirror::Class* existing = InsertClass(descriptor, new_class.get(), Hash(descriptor));
+  mirror::Class* existing = InsertClass(descriptor, new_class.get(),
+                                        ComputeModifiedUtf8Hash(descriptor));
   if (existing == NULL) {
     return new_class.get();
   }
@@ -2207,89 +2203,46 @@ mirror::Class* ClassLinker::InsertClass(const char* descriptor, mirror::Class* k
   if (existing != NULL) {
     return existing;
   }
-  if (kIsDebugBuild && klass->GetClassLoader() == NULL && dex_cache_image_class_lookup_required_) {
-    // Check a class loaded with the system class loader matches one in the image if the class
-    // is in the image.
-    existing = LookupClassFromImage(descriptor);
-    if (existing != NULL) {
-      CHECK(klass == existing);
-    }
-  }
   Runtime::Current()->GetHeap()->VerifyObject(klass);
-  class_table_.insert(std::make_pair(hash, klass));
+  class_table_.Insert(klass, hash);
   class_table_dirty_ = true;
   return NULL;
 }
 
 bool ClassLinker::RemoveClass(const char* descriptor, const mirror::ClassLoader* class_loader) {
-  size_t hash = Hash(descriptor);
+  size_t hash = ComputeModifiedUtf8Hash(descriptor);
   WriterMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  ClassHelper kh;
-  for (auto it = class_table_.lower_bound(hash), end = class_table_.end(); it != end && it->first == hash;
-       ++it) {
-    mirror::Class* klass = it->second;
-    kh.ChangeClass(klass);
-    if (strcmp(kh.GetDescriptor(), descriptor) == 0 && klass->GetClassLoader() == class_loader) {
-      class_table_.erase(it);
-      return true;
-    }
-  }
-  return false;
+  return class_table_.Remove(descriptor, class_loader, hash);
 }
 
 mirror::Class* ClassLinker::LookupClass(const char* descriptor,
                                         const mirror::ClassLoader* class_loader) {
-  size_t hash = Hash(descriptor);
-  {
-    ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-    mirror::Class* result = LookupClassFromTableLocked(descriptor, class_loader, hash);
-    if (result != NULL) {
-      return result;
-    }
-  }
-  if (class_loader != NULL || !dex_cache_image_class_lookup_required_) {
-    return NULL;
-  } else {
-    // Lookup failed but need to search dex_caches_.
-    mirror::Class* result = LookupClassFromImage(descriptor);
-    if (result != NULL) {
-      InsertClass(descriptor, result, hash);
-    } else {
-      // Searching the image dex files/caches failed, we don't want to get into this situation
-      // often as map searches are faster, so after kMaxFailedDexCacheLookups move all image
-      // classes into the class table.
-      const int32_t kMaxFailedDexCacheLookups = 1000;
-      if (++failed_dex_cache_class_lookups_ > kMaxFailedDexCacheLookups) {
-        MoveImageClassesToClassTable();
-      }
-    }
+  size_t hash = ComputeModifiedUtf8Hash(descriptor);
+  // Most lookups hit, try without the lock first.
+  mirror::Class* result = class_table_.Lookup(descriptor, class_loader, hash);
+  if (result != NULL) {
     return result;
   }
+  // The unlocked lookup may miss a class being inserted.
+  ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
+  return LookupClassFromTableLocked(descriptor, class_loader, hash);
 }
 
 mirror::Class* ClassLinker::LookupClassFromTableLocked(const char* descriptor,
                                                        const mirror::ClassLoader* class_loader,
                                                        size_t hash) {
-  ClassHelper kh(NULL, this);
-  auto end = class_table_.end();
-  for (auto it = class_table_.lower_bound(hash); it != end && it->first == hash; ++it) {
-    mirror::Class* klass = it->second;
-    kh.ChangeClass(klass);
-    if (klass->GetClassLoader() == class_loader && strcmp(descriptor, kh.GetDescriptor()) == 0) {
-      if (kIsDebugBuild) {
-        // Check for duplicates in the table.
-        for (++it; it != end && it->first == hash; ++it) {
-          mirror::Class* klass2 = it->second;
-          kh.ChangeClass(klass2);
-          CHECK(!(strcmp(descriptor, kh.GetDescriptor()) == 0 && klass2->GetClassLoader() == class_loader))
+  mirror::Class* klass = class_table_.Lookup(descriptor, class_loader, hash);
+  if (kIsDebugBuild && klass != NULL) {
+    // Check for duplicates in the table.
+    std::vector<mirror::Class*> classes;
+    class_table_.LookupAll(descriptor, hash, classes);
+    for (mirror::Class* klass2 : classes) {
+      CHECK(klass2 == klass || klass2->GetClassLoader() != class_loader)
           << PrettyClass(klass) << " " << klass << " " << klass->GetClassLoader() << " "
           << PrettyClass(klass2) << " " << klass2 << " " << klass2->GetClassLoader();
-        }
-      }
-      return klass;
     }
   }
-  return NULL;
+  return klass;
 }
 
 static mirror::ObjectArray<mirror::DexCache>* GetImageDexCaches()
@@ -2300,15 +2253,26 @@ static mirror::ObjectArray<mirror::DexCache>* GetImageDexCaches()
   return root->AsObjectArray<mirror::DexCache>();
 }
 
-void ClassLinker::MoveImageClassesToClassTable() {
+void ClassLinker::AddImageClassesToClassTable() {
   Thread* self = Thread::Current();
   WriterMutexLock mu(self, *Locks::classlinker_classes_lock_);
-  if (!dex_cache_image_class_lookup_required_) {
-    return;  // All dex cache classes are already in the class table.
-  }
   const char* old_no_suspend_cause =
-      self->StartAssertNoThreadSuspension("Moving image classes to class table");
+      self->StartAssertNoThreadSuspension("Adding image classes to class table");
   mirror::ObjectArray<mirror::DexCache>* dex_caches = GetImageDexCaches();
+  // Size the table up front. A class may be among the resolved types of several dex caches, but it
+  // is defined by only one of them.
+  size_t class_count = 0;
+  for (int32_t i = 0; i < dex_caches->GetLength(); i++) {
+    mirror::DexCache* dex_cache = dex_caches->Get(i);
+    mirror::ObjectArray<mirror::Class>* types = dex_cache->GetResolvedTypes();
+    for (int32_t j = 0; j < types->GetLength(); j++) {
+      mirror::Class* klass = types->Get(j);
+      if (klass != NULL && klass->GetDexCache() == dex_cache) {
+        ++class_count;
+      }
+    }
+  }
+  class_table_.Reserve(class_count);
   ClassHelper kh(NULL, this);
   for (int32_t i = 0; i < dex_caches->GetLength(); i++) {
     mirror::DexCache* dex_cache = dex_caches->Get(i);
@@ -2319,80 +2283,27 @@ void ClassLinker::MoveImageClassesToClassTable() {
         kh.ChangeClass(klass);
         DCHECK(klass->GetClassLoader() == NULL);
         const char* descriptor = kh.GetDescriptor();
-        size_t hash = Hash(descriptor);
-        mirror::Class* existing = LookupClassFromTableLocked(descriptor, NULL, hash);
+        size_t hash = ComputeModifiedUtf8Hash(descriptor);
+        mirror::Class* existing = class_table_.Lookup(descriptor, NULL, hash);
         if (existing != NULL) {
           CHECK(existing == klass) << PrettyClassAndClassLoader(existing) << " != "
               << PrettyClassAndClassLoader(klass);
         } else {
-          class_table_.insert(std::make_pair(hash, klass));
+          class_table_.Insert(klass, hash);
         }
       }
     }
   }
   class_table_dirty_ = true;
-  dex_cache_image_class_lookup_required_ = false;
-  self->EndAssertNoThreadSuspension(old_no_suspend_cause);
-}
-
-mirror::Class* ClassLinker::LookupClassFromImage(const char* descriptor) {
-  Thread* self = Thread::Current();
-  const char* old_no_suspend_cause =
-      self->StartAssertNoThreadSuspension("Image class lookup");
-  mirror::ObjectArray<mirror::DexCache>* dex_caches = GetImageDexCaches();
-  for (int32_t i = 0; i < dex_caches->GetLength(); ++i) {
-    mirror::DexCache* dex_cache = dex_caches->Get(i);
-    const DexFile* dex_file = dex_cache->GetDexFile();
-    // First search using the class def map, but don't bother for non-class types.
-    if (descriptor[0] == 'L') {
-      const DexFile::StringId* descriptor_string_id = dex_file->FindStringId(descriptor);
-      if (descriptor_string_id != NULL) {
-        const DexFile::TypeId* type_id =
-            dex_file->FindTypeId(dex_file->GetIndexForStringId(*descriptor_string_id));
-        if (type_id != NULL) {
-          mirror::Class* klass = dex_cache->GetResolvedType(dex_file->GetIndexForTypeId(*type_id));
-          if (klass != NULL) {
-            self->EndAssertNoThreadSuspension(old_no_suspend_cause);
-            return klass;
-          }
-        }
-      }
-    }
-    // Now try binary searching the string/type index.
-    const DexFile::StringId* string_id = dex_file->FindStringId(descriptor);
-    if (string_id != NULL) {
-      const DexFile::TypeId* type_id =
-          dex_file->FindTypeId(dex_file->GetIndexForStringId(*string_id));
-      if (type_id != NULL) {
-        uint16_t type_idx = dex_file->GetIndexForTypeId(*type_id);
-        mirror::Class* klass = dex_cache->GetResolvedType(type_idx);
-        if (klass != NULL) {
-          self->EndAssertNoThreadSuspension(old_no_suspend_cause);
-          return klass;
-        }
-      }
-    }
-  }
   self->EndAssertNoThreadSuspension(old_no_suspend_cause);
-  return NULL;
+  VLOG(startup) << "Added " << class_table_.Size() << " image classes to the class table";
 }
 
 void ClassLinker::LookupClasses(const char* descriptor, std::vector<mirror::Class*>& result) {
   result.clear();
-  if (dex_cache_image_class_lookup_required_) {
-    MoveImageClassesToClassTable();
-  }
-  size_t hash = Hash(descriptor);
+  size_t hash = ComputeModifiedUtf8Hash(descriptor);
   ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  ClassHelper kh(NULL, this);
-  for (auto it = class_table_.lower_bound(hash), end = class_table_.end();
-      it != end && it->first == hash; ++it) {
-    mirror::Class* klass = it->second;
-    kh.ChangeClass(klass);
-    if (strcmp(descriptor, kh.GetDescriptor()) == 0) {
-      result.push_back(klass);
-    }
-  }
+  class_table_.LookupAll(descriptor, hash, result);
 }
 
 void ClassLinker::VerifyClass(mirror::Class* klass) {
@@ -2772,7 +2683,8 @@ mirror::Class* ClassLinker::CreateProxyClass(mirror::String* name,
     CHECK_EQ(synth_proxy_class->GetThrows(), throws);
   }
   std::string descriptor(GetDescriptorForProxy(klass.get()));
-  mirror::Class* existing = InsertClass(descriptor.c_str(), klass.get(), Hash(descriptor.c_str()));
+  mirror::Class* existing = InsertClass(descriptor.c_str(), klass.get(),
+                                        ComputeModifiedUtf8Hash(descriptor.c_str()));
   CHECK(existing == nullptr);
   return klass.get();
 }
@@ -4225,17 +4137,15 @@ const char* ClassLinker::MethodShorty(uint32_t method_idx, mirror::ArtMethod* re
 }
 
 void ClassLinker::DumpAllClasses(int flags) {
-  if (dex_cache_image_class_lookup_required_) {
-    MoveImageClassesToClassTable();
-  }
   // TODO: at the time this was written, it wasn't safe to call PrettyField with the ClassLinker
   // lock held, because it might need to resolve a field's type, which would try to take the lock.
   std::vector<mirror::Class*> all_classes;
   {
     ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-    for (const std::pair<size_t, mirror::Class*>& it : class_table_) {
-      all_classes.push_back(it.second);
-    }
+    class_table_.VisitClasses([&all_classes](mirror::Class* klass) {
+      all_classes.push_back(klass);
+      return true;
+    });
   }
 
   for (size_t i = 0; i < all_classes.size(); ++i) {
@@ -4244,19 +4154,13 @@ void ClassLinker::DumpAllClasses(int flags) {
 }
 
 void ClassLinker::DumpForSigQuit(std::ostream& os) {
-  if (dex_cache_image_class_lookup_required_) {
-    MoveImageClassesToClassTable();
-  }
   ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  os << "Loaded classes: " << class_table_.size() << " allocated classes\n";
+  os << "Loaded classes: " << class_table_.Size() << " allocated classes\n";
 }
 
 size_t ClassLinker::NumLoadedClasses() {
-  if (dex_cache_image_class_lookup_required_) {
-    MoveImageClassesToClassTable();
-  }
   ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  return class_table_.size();
+  return class_table_.Size();
 }
 
 pid_t ClassLinker::GetClassesLockOwner() {
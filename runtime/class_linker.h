@@ -23,6 +23,7 @@
 
 #include "base/macros.h"
 #include "base/mutex.h"
+#include "class_table.h"
 #include "dex_file.h"
 #include "gtest/gtest.h"
 #include "root_visitor.h"
@@ -528,26 +529,18 @@ class ClassLinker {
   std::vector<const OatFile*> oat_files_ GUARDED_BY(dex_lock_);
 
 
-  // multimap from a string hash code of a class descriptor to
-  // mirror::Class* instances. Results should be compared for a matching
-  // Class::descriptor_ and Class::class_loader_.
-  typedef std::multimap<size_t, mirror::Class*> Table;
-  Table class_table_ GUARDED_BY(Locks::classlinker_classes_lock_);
-
-  // Do we need to search dex caches to find image classes?
-  bool dex_cache_image_class_lookup_required_;
-  // Number of times we've searched dex caches for a class. After a certain number of misses we move
-  // the classes into the class_table_ to avoid dex cache based searches.
-  AtomicInteger failed_dex_cache_class_lookups_;
+  // The loaded classes, keyed by the hash code of their descriptor. Modified with
+  // classlinker_classes_lock_ held exclusively, but LookupClass first probes it without the lock.
+  ClassTable class_table_;
 
   mirror::Class* LookupClassFromTableLocked(const char* descriptor,
                                             const mirror::ClassLoader* class_loader,
                                             size_t hash)
       SHARED_LOCKS_REQUIRED(Locks::classlinker_classes_lock_, Locks::mutator_lock_);
 
-  void MoveImageClassesToClassTable() LOCKS_EXCLUDED(Locks::classlinker_classes_lock_)
-      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-  mirror::Class* LookupClassFromImage(const char* descriptor)
+  // Adds the classes of the image dex caches to the class table, so that they are found without
+  // searching the dex caches.
+  void AddImageClassesToClassTable() LOCKS_EXCLUDED(Locks::classlinker_classes_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // indexes into class_roots_.
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "class_table.h"
+
+#include <string.h>
+
+#include "base/casts.h"
+#include "base/stl_util.h"
+#include "cutils/atomic-inline.h"
+#include "mirror/class.h"
+#include "mirror/class-inl.h"
+#include "object_utils.h"
+#include "utils.h"
+
+namespace art {
+
+mirror::Class* const ClassTable::kRemoved = reinterpret_cast<mirror::Class*>(1);
+
+ClassTable::Slots::Slots(size_t capacity) : capacity(capacity), slots(new Slot[capacity]) {
+  DCHECK(IsPowerOfTwo(capacity));
+  memset(slots, 0, sizeof(Slot) * capacity);
+}
+
+ClassTable::Slots::~Slots() {
+  delete[] slots;
+}
+
+ClassTable::ClassTable() : slots_(new Slots(kMinimumCapacity)), size_(0), used_(0) {
+}
+
+ClassTable::~ClassTable() {
+  delete slots_;
+  STLDeleteElements(&old_slots_);
+}
+
+mirror::Class* ClassTable::Lookup(const char* descriptor, const mirror::ClassLoader* class_loader,
+                                  size_t hash) const {
+  const Slots* slots = slots_;
+  const size_t mask = slots->capacity - 1;
+  ClassHelper kh;
+  for (size_t i = FirstIndex(hash, slots->capacity); ; i = (i + 1) & mask) {
+    const Slot& slot = slots->slots[i];
+    mirror::Class* klass = slot.klass;
+    if (klass == NULL) {
+      return NULL;
+    }
+    // The hash is only a filter, a stale one seen by an unlocked reader just causes a miss.
+    if (klass != kRemoved && slot.hash == hash && klass->GetClassLoader() == class_loader) {
+      kh.ChangeClass(klass);
+      if (strcmp(descriptor, kh.GetDescriptor()) == 0) {
+        return klass;
+      }
+    }
+  }
+}
+
+void ClassTable::LookupAll(const char* descriptor, size_t hash,
+                           std::vector<mirror::Class*>& result) const {
+  const Slots* slots = slots_;
+  const size_t mask = slots->capacity - 1;
+  ClassHelper kh;
+  for (size_t i = FirstIndex(hash, slots->capacity); ; i = (i + 1) & mask) {
+    const Slot& slot = slots->slots[i];
+    mirror::Class* klass = slot.klass;
+    if (klass == NULL) {
+      return;
+    }
+    if (klass != kRemoved && slot.hash == hash) {
+      kh.ChangeClass(klass);
+      if (strcmp(descriptor, kh.GetDescriptor()) == 0) {
+        result.push_back(klass);
+      }
+    }
+  }
+}
+
+void ClassTable::InsertInto(Slots* slots, mirror::Class* klass, size_t hash) {
+  const size_t mask = slots->capacity - 1;
+  size_t i = FirstIndex(hash, slots->capacity);
+  // Removed slots aren't reused, an unlocked reader could pair the new class with the old hash.
+  while (slots->slots[i].klass != NULL) {
+    i = (i + 1) & mask;
+  }
+  Slot& slot = slots->slots[i];
+  slot.hash = hash;
+  // The hash must be visible before the class which makes the slot used.
+  ANDROID_MEMBAR_STORE();
+  slot.klass = klass;
+}
+
+void ClassTable::Insert(mirror::Class* klass, size_t hash) {
+  DCHECK(IsLive(klass));
+  Reserve(1);
+  InsertInto(slots_, klass, hash);
+  ++size_;
+  ++used_;
+}
+
+bool ClassTable::Remove(const char* descriptor, const mirror::ClassLoader* class_loader,
+                        size_t hash) {
+  Slots* slots = slots_;
+  const size_t mask = slots->capacity - 1;
+  ClassHelper kh;
+  for (size_t i = FirstIndex(hash, slots->capacity); ; i = (i + 1) & mask) {
+    Slot& slot = slots->slots[i];
+    mirror::Class* klass = slot.klass;
+    if (klass == NULL) {
+      return false;
+    }
+    if (klass != kRemoved && slot.hash == hash && klass->GetClassLoader() == class_loader) {
+      kh.ChangeClass(klass);
+      if (strcmp(descriptor, kh.GetDescriptor()) == 0) {
+        // Keep the slot used so that the probe sequences running through it stay intact.
+        slot.klass = kRemoved;
+        --size_;
+        return true;
+      }
+    }
+  }
+}
+
+void ClassTable::Reserve(size_t count) {
+  const size_t capacity = slots_->capacity;
+  if ((used_ + count) * kMaxLoadDenominator <= capacity * kMaxLoadNumerator) {
+    return;
+  }
+  // Removed classes don't survive the resize, so only the live ones count. Leave the table at most
+  // half full so that it doesn't need resizing again soon.
+  size_t new_capacity = capacity;
+  while ((size_ + count) * 2 > new_capacity) {
+    new_capacity *= 2;
+  }
+  Resize(new_capacity);
+}
+
+void ClassTable::Resize(size_t capacity) {
+  Slots* old_slots = slots_;
+  Slots* new_slots = new Slots(capacity);
+  for (size_t i = 0; i < old_slots->capacity; ++i) {
+    const Slot& slot = old_slots->slots[i];
+    if (IsLive(slot.klass)) {
+      InsertInto(new_slots, slot.klass, slot.hash);
+    }
+  }
+  // Unlocked readers must see the filled in slots before the new array.
+  ANDROID_MEMBAR_STORE();
+  slots_ = new_slots;
+  old_slots_.push_back(old_slots);
+  used_ = size_;
+}
+
+void ClassTable::DeleteOldSlots() {
+  STLDeleteElements(&old_slots_);
+}
+
+void ClassTable::VisitRoots(RootVisitor* visitor, void* arg) {
+  Slots* slots = slots_;
+  for (size_t i = 0; i < slots->capacity; ++i) {
+    Slot& slot = slots->slots[i];
+    if (IsLive(slot.klass)) {
+      slot.klass = down_cast<mirror::Class*>(visitor(slot.klass, arg));
+    }
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_CLASS_TABLE_H_
+#define ART_RUNTIME_CLASS_TABLE_H_
+
+#include <vector>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "root_visitor.h"
+#include "utils.h"
+
+namespace art {
+
+namespace mirror {
+  class Class;
+  class ClassLoader;
+}  // namespace mirror
+
+// The loaded classes, keyed by the hash of their descriptor. An open-addressed table with linear
+// probing, where each slot holds the hash next to the class so that probing rarely touches the
+// classes themselves.
+//
+// Writers must hold the class linker's classes lock exclusively. Lookup may also be called without
+// the lock, in which case it can miss a class inserted concurrently; callers confirm a miss under
+// the lock. The slot arrays replaced by a resize are kept since unlocked readers may still be
+// probing them, until DeleteOldSlots is called while no reader can be.
+class ClassTable {
+ public:
+  ClassTable();
+  ~ClassTable();
+
+  // Returns the class with the descriptor and class loader, or NULL if there is none.
+  mirror::Class* Lookup(const char* descriptor, const mirror::ClassLoader* class_loader,
+                        size_t hash) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Adds the classes with the descriptor to result, whatever their class loader.
+  void LookupAll(const char* descriptor, size_t hash, std::vector<mirror::Class*>& result) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Adds klass, which must not be in the table yet.
+  void Insert(mirror::Class* klass, size_t hash);
+
+  // Removes the class with the descriptor and class loader, returns false if there is none.
+  bool Remove(const char* descriptor, const mirror::ClassLoader* class_loader, size_t hash)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Makes room for count more classes without resizing.
+  void Reserve(size_t count);
+
+  // Replaces each class with the address returned by the visitor.
+  void VisitRoots(RootVisitor* visitor, void* arg);
+
+  // Frees the slot arrays replaced by resizes. Unlocked readers hold the mutator lock, so the
+  // caller must hold it exclusively.
+  void DeleteOldSlots();
+
+  // Calls the visitor on each class until it returns false.
+  template <typename Visitor>
+  void VisitClasses(const Visitor& visitor) const {
+    const Slots* slots = slots_;
+    for (size_t i = 0; i < slots->capacity; ++i) {
+      mirror::Class* klass = slots->slots[i].klass;
+      if (IsLive(klass) && !visitor(klass)) {
+        return;
+      }
+    }
+  }
+
+  size_t Size() const {
+    return size_;
+  }
+
+ private:
+  struct Slot {
+    // Only meaningful when klass is live.
+    size_t hash;
+    // NULL for a slot which was never used, kRemoved for a class which was removed.
+    mirror::Class* volatile klass;
+  };
+
+  struct Slots {
+    explicit Slots(size_t capacity);
+    ~Slots();
+
+    const size_t capacity;
+    Slot* const slots;
+
+    DISALLOW_COPY_AND_ASSIGN(Slots);
+  };
+
+  static const size_t kMinimumCapacity = 1024;
+
+  // The table grows when used slots, including the ones of removed classes, exceed this fraction.
+  static const size_t kMaxLoadNumerator = 2;
+  static const size_t kMaxLoadDenominator = 3;
+
+  static mirror::Class* const kRemoved;
+
+  static bool IsLive(const mirror::Class* klass) {
+    return klass != NULL && klass != kRemoved;
+  }
+
+  // Spreads the bits of the descriptor hash, which is a string hash code and so poorly mixed in its
+  // low bits.
+  static size_t FirstIndex(size_t hash, size_t capacity) {
+    return MixHash(hash) & (capacity - 1);
+  }
+
+  static void InsertInto(Slots* slots, mirror::Class* klass, size_t hash);
+
+  // Moves the live classes into new slots of the given capacity.
+  void Resize(size_t capacity);
+
+  // Published with a store barrier once filled in, so that unlocked readers see complete slots.
+  Slots* volatile slots_;
+  std::vector<Slots*> old_slots_;
+
+  // Number of live classes.
+  size_t size_;
+  // Number of live classes plus the removed ones still occupying slots.
+  size_t used_;
+
+  DISALLOW_COPY_AND_ASSIGN(ClassTable);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_CLASS_TABLE_H_
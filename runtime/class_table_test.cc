@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "class_table.h"
+
+#include <vector>
+
+#include "class_linker.h"
+#include "common_test.h"
+#include "mirror/class-inl.h"
+#include "object_utils.h"
+#include "scoped_thread_state_change.h"
+#include "utils.h"
+
+namespace art {
+
+class ClassTableTest : public CommonTest {};
+
+TEST_F(ClassTableTest, InsertLookupRemove) {
+  ScopedObjectAccess soa(Thread::Current());
+  static const char* kDescriptors[] = {
+    "Ljava/lang/Object;",
+    "Ljava/lang/String;",
+    "Ljava/lang/Class;",
+    "[I",
+  };
+  const mirror::ClassLoader* kOtherLoader = reinterpret_cast<const mirror::ClassLoader*>(8);
+  ClassTable table;
+  for (size_t i = 0; i < arraysize(kDescriptors); ++i) {
+    mirror::Class* klass = class_linker_->FindSystemClass(kDescriptors[i]);
+    ASSERT_TRUE(klass != NULL);
+    // Use the same hash for every class so that they all probe the same slots.
+    table.Insert(klass, 0);
+  }
+  EXPECT_EQ(arraysize(kDescriptors), table.Size());
+  for (size_t i = 0; i < arraysize(kDescriptors); ++i) {
+    mirror::Class* klass = table.Lookup(kDescriptors[i], NULL, 0);
+    ASSERT_TRUE(klass != NULL);
+    EXPECT_STREQ(kDescriptors[i], ClassHelper(klass).GetDescriptor());
+    // A different hash or class loader doesn't match.
+    EXPECT_TRUE(table.Lookup(kDescriptors[i], NULL, 1) == NULL);
+    EXPECT_TRUE(table.Lookup(kDescriptors[i], kOtherLoader, 0) == NULL);
+  }
+
+  // Removing a class in the middle of the probe sequence keeps the later ones reachable.
+  EXPECT_TRUE(table.Remove(kDescriptors[1], NULL, 0));
+  EXPECT_FALSE(table.Remove(kDescriptors[1], NULL, 0));
+  EXPECT_EQ(arraysize(kDescriptors) - 1, table.Size());
+  EXPECT_TRUE(table.Lookup(kDescriptors[1], NULL, 0) == NULL);
+  for (size_t i = 2; i < arraysize(kDescriptors); ++i) {
+    EXPECT_TRUE(table.Lookup(kDescriptors[i], NULL, 0) != NULL);
+  }
+
+  std::vector<mirror::Class*> all;
+  table.LookupAll(kDescriptors[0], 0, all);
+  EXPECT_EQ(1U, all.size());
+}
+
+TEST_F(ClassTableTest, Resize) {
+  ScopedObjectAccess soa(Thread::Current());
+  mirror::Class* object_class = class_linker_->FindSystemClass("Ljava/lang/Object;");
+  mirror::Class* string_class = class_linker_->FindSystemClass("Ljava/lang/String;");
+  ClassTable table;
+  table.Insert(object_class, 1);
+  table.Insert(string_class, 2);
+  // Force several resizes, the classes must stay reachable through each of them.
+  table.Reserve(100000);
+  EXPECT_EQ(2U, table.Size());
+  EXPECT_EQ(object_class, table.Lookup("Ljava/lang/Object;", NULL, 1));
+  EXPECT_EQ(string_class, table.Lookup("Ljava/lang/String;", NULL, 2));
+
+  // Freeing the replaced slot arrays leaves the classes in the current one.
+  table.DeleteOldSlots();
+  EXPECT_EQ(object_class, table.Lookup("Ljava/lang/Object;", NULL, 1));
+  EXPECT_EQ(string_class, table.Lookup("Ljava/lang/String;", NULL, 2));
+
+  size_t visited = 0;
+  table.VisitClasses([&visited](mirror::Class*) {
+    ++visited;
+    return true;
+  });
+  EXPECT_EQ(2U, visited);
+}
+
+}  // namespace art
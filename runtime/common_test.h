@@ -275,6 +275,9 @@ class CommonTest : public testing::Test {
     return (getenv("ANDROID_BUILD_TOP") != NULL);
   }
 
+  // Lets tests add to the options the runtime is created with.
+  virtual void SetUpRuntimeOptions(Runtime::Options* options) {}
+
   virtual void SetUp() {
     SetEnvironmentVariables(android_data_);
     dalvik_cache_.append(android_data_.c_str());
@@ -302,6 +305,7 @@ class CommonTest : public testing::Test {
     options.push_back(std::make_pair("-Xcheck:jni", reinterpret_cast<void*>(NULL)));
     options.push_back(std::make_pair(min_heap_string.c_str(), reinterpret_cast<void*>(NULL)));
     options.push_back(std::make_pair(max_heap_string.c_str(), reinterpret_cast<void*>(NULL)));
+    SetUpRuntimeOptions(&options);
     if (!Runtime::Create(options, false)) {
       LOG(FATAL) << "Failed to create runtime";
       return;
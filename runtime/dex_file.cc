@@ -27,6 +27,8 @@
 #include "base/logging.h"
 #include "base/stringprintf.h"
 #include "class_linker.h"
+#include "cutils/atomic.h"
+#include "cutils/atomic-inline.h"
 #include "dex_file-inl.h"
 #include "dex_file_verifier.h"
 #include "globals.h"
@@ -48,11 +50,30 @@ namespace art {
 const byte DexFile::kDexMagic[] = { 'd', 'e', 'x', '\n' };
 const byte DexFile::kDexMagicVersion[] = { '0', '3', '5', '\0' };
 
+bool DexFile::verify_class_data_lazily_ = false;
+
+// Dex files at least this large have the time taken to open them logged.
+static const size_t kLargeDexFileSize = 4 * MB;
+
+static void LogOpenTime(const DexFile& dex_file, uint64_t start_ns, bool class_data_deferred) {
+  uint64_t duration_ns = NanoTime() - start_ns;
+  if (dex_file.Size() >= kLargeDexFileSize || VLOG_IS_ON(startup)) {
+    LOG(INFO) << "Opened " << PrettySize(dex_file.Size()) << " dex file '"
+              << dex_file.GetLocation() << "' in " << PrettyDuration(duration_ns)
+              << (class_data_deferred ? " leaving class data to be verified on first use" : "");
+  }
+}
+
 DexFile::ClassPathEntry DexFile::FindInClassPath(const char* descriptor,
                                                  const ClassPath& class_path) {
+  return FindInClassPath(descriptor, ComputeModifiedUtf8Hash(descriptor), class_path);
+}
+
+DexFile::ClassPathEntry DexFile::FindInClassPath(const char* descriptor, size_t hash,
+                                                 const ClassPath& class_path) {
   for (size_t i = 0; i != class_path.size(); ++i) {
     const DexFile* dex_file = class_path[i];
-    const DexFile::ClassDef* dex_class_def = dex_file->FindClassDef(descriptor);
+    const DexFile::ClassDef* dex_class_def = dex_file->FindClassDef(descriptor, hash);
     if (dex_class_def != NULL) {
       return ClassPathEntry(dex_file, dex_class_def);
     }
@@ -164,6 +185,7 @@ const DexFile* DexFile::OpenFile(int fd,
                                  const std::string& location,
                                  bool verify) {
   CHECK(!location.empty());
+  uint64_t start_ns = NanoTime();
   struct stat sbuf;
   memset(&sbuf, 0, sizeof(sbuf));
   if (fstat(fd, &sbuf) == -1) {
@@ -197,14 +219,53 @@ const DexFile* DexFile::OpenFile(int fd,
     return NULL;
   }
 
-  if (verify && !DexFileVerifier::Verify(dex_file, dex_file->Begin(), dex_file->Size())) {
+  if (verify && !dex_file->Verify()) {
     LOG(ERROR) << "Failed to verify dex file '" << location << "'";
     return NULL;
   }
 
+  LogOpenTime(*dex_file, start_ns, verify && verify_class_data_lazily_);
   return dex_file;
 }
 
+void DexFile::SetVerifyClassDataLazily(bool lazily) {
+  verify_class_data_lazily_ = lazily;
+}
+
+bool DexFile::Verify() const {
+  if (!verify_class_data_lazily_) {
+    return DexFileVerifier::Verify(this, begin_, size_);
+  }
+  if (!DexFileVerifier::VerifyDeferringClassData(this, begin_, size_, &class_data_item_offsets_,
+                                                 &code_item_offsets_)) {
+    return false;
+  }
+  size_t num_class_defs = NumClassDefs();
+  class_def_verification_.reset(new uint8_t[num_class_defs]);
+  memset(class_def_verification_.get(), kClassDefUnverified, num_class_defs);
+  return true;
+}
+
+bool DexFile::VerifyClassDef(const ClassDef& class_def) const {
+  if (class_def_verification_.get() == NULL) {
+    return true;
+  }
+  uint16_t class_def_idx = GetIndexForClassDef(class_def);
+  uint8_t state = class_def_verification_[class_def_idx];
+  if (state == kClassDefUnverified) {
+    if (DexFileVerifier::VerifyClassDef(this, class_def_idx, class_data_item_offsets_,
+                                        code_item_offsets_)) {
+      state = kClassDefVerified;
+    } else {
+      LOG(ERROR) << "Failed to verify class data of " << GetClassDescriptor(class_def)
+                 << " in dex file '" << GetLocation() << "'";
+      state = kClassDefMalformed;
+    }
+    class_def_verification_[class_def_idx] = state;
+  }
+  return state == kClassDefVerified;
+}
+
 const char* DexFile::kClassesDex = "classes.dex";
 
 const DexFile* DexFile::OpenZip(int fd, const std::string& location) {
@@ -228,22 +289,26 @@ const DexFile* DexFile::OpenMemory(const std::string& location,
 
 const DexFile* DexFile::Open(const ZipArchive& zip_archive, const std::string& location) {
   CHECK(!location.empty());
+  uint64_t start_ns = NanoTime();
   UniquePtr<ZipEntry> zip_entry(zip_archive.Find(kClassesDex));
   if (zip_entry.get() == NULL) {
     LOG(ERROR) << "Failed to find classes.dex within '" << location << "'";
     return NULL;
   }
-  UniquePtr<MemMap> map(zip_entry->ExtractToMemMap(kClassesDex));
+  UniquePtr<MemMap> map(zip_entry->MapDirectlyFromFile(kClassesDex));
   if (map.get() == NULL) {
-    LOG(ERROR) << "Failed to extract '" << kClassesDex << "' from '" << location << "'";
-    return NULL;
+    map.reset(zip_entry->ExtractToMemMap(kClassesDex));
+    if (map.get() == NULL) {
+      LOG(ERROR) << "Failed to extract '" << kClassesDex << "' from '" << location << "'";
+      return NULL;
+    }
   }
   UniquePtr<const DexFile> dex_file(OpenMemory(location, zip_entry->GetCrc32(), map.release()));
   if (dex_file.get() == NULL) {
     LOG(ERROR) << "Failed to open dex file '" << location << "' from memory";
     return NULL;
   }
-  if (!DexFileVerifier::Verify(dex_file.get(), dex_file->Begin(), dex_file->Size())) {
+  if (!dex_file->Verify()) {
     LOG(ERROR) << "Failed to verify dex file '" << location << "'";
     return NULL;
   }
@@ -252,6 +317,7 @@ const DexFile* DexFile::Open(const ZipArchive& zip_archive, const std::string& l
     return NULL;
   }
   CHECK(dex_file->IsReadOnly()) << location;
+  LogOpenTime(*dex_file, start_ns, verify_class_data_lazily_);
   return dex_file.release();
 }
 
@@ -269,11 +335,33 @@ const DexFile* DexFile::OpenMemory(const byte* base,
   }
 }
 
+struct DexFile::ClassDefIndex {
+  // An open-addressed table entry, class_def_idx is kDexNoIndex16 for an empty slot.
+  struct Entry {
+    uint32_t hash;
+    uint16_t class_def_idx;
+  };
+
+  explicit ClassDefIndex(const DexFile& dex_file);
+
+  static size_t FirstIndex(uint32_t hash, size_t mask) {
+    // The descriptor hash is poorly mixed in its low bits.
+    return MixHash(hash) & mask;
+  }
+
+  // The class definition index of each type index, kDexNoIndex16 for types defined elsewhere.
+  std::vector<uint16_t> type_to_class_def;
+  // Class definition indexes keyed by descriptor hash, at most half full.
+  std::vector<Entry> entries;
+  size_t mask;
+};
+
 DexFile::~DexFile() {
   // We don't call DeleteGlobalRef on dex_object_ because we're only called by DestroyJavaVM, and
   // that's only called after DetachCurrentThread, which means there's no JNIEnv. We could
   // re-attach, but cleaning up these global references is not obviously useful. It's not as if
   // the global reference table is otherwise empty!
+  delete class_def_index_;
 }
 
 bool DexFile::Init() {
@@ -331,38 +419,77 @@ uint32_t DexFile::GetVersion() const {
   return atoi(version);
 }
 
-const DexFile::ClassDef* DexFile::FindClassDef(const char* descriptor) const {
-  size_t num_class_defs = NumClassDefs();
-  if (num_class_defs == 0) {
-    return NULL;
+DexFile::ClassDefIndex::ClassDefIndex(const DexFile& dex_file)
+    : type_to_class_def(dex_file.NumTypeIds(), DexFile::kDexNoIndex16) {
+  const size_t num_class_defs = dex_file.NumClassDefs();
+  // Class definitions are indexed by a type index, so there can't be more than 64K of them.
+  CHECK_LT(num_class_defs, static_cast<size_t>(DexFile::kDexNoIndex16)) << dex_file.GetLocation();
+  size_t capacity = 16;
+  while (capacity < num_class_defs * 2) {
+    capacity *= 2;
+  }
+  Entry empty = { 0, DexFile::kDexNoIndex16 };
+  entries.resize(capacity, empty);
+  mask = capacity - 1;
+  for (size_t i = 0; i < num_class_defs; ++i) {
+    const ClassDef& class_def = dex_file.GetClassDef(i);
+    type_to_class_def[class_def.class_idx_] = i;
+    uint32_t hash = ComputeModifiedUtf8Hash(dex_file.GetClassDescriptor(class_def));
+    size_t index = FirstIndex(hash, mask);
+    while (entries[index].class_def_idx != DexFile::kDexNoIndex16) {
+      index = (index + 1) & mask;
+    }
+    entries[index].hash = hash;
+    entries[index].class_def_idx = i;
   }
-  const StringId* string_id = FindStringId(descriptor);
-  if (string_id == NULL) {
-    return NULL;
+}
+
+const DexFile::ClassDefIndex* DexFile::GetClassDefIndex() const {
+  const ClassDefIndex* index = class_def_index_;
+  if (LIKELY(index != NULL)) {
+    return index;
+  }
+  ClassDefIndex* new_index = new ClassDefIndex(*this);
+  // The release CAS makes the filled in index visible before the pointer to it.
+  if (android_atomic_release_cas(0, reinterpret_cast<int32_t>(new_index),
+                                 reinterpret_cast<volatile int32_t*>(&class_def_index_)) != 0) {
+    // Another thread published its index first.
+    delete new_index;
   }
-  const TypeId* type_id = FindTypeId(GetIndexForStringId(*string_id));
-  if (type_id == NULL) {
+  return class_def_index_;
+}
+
+const DexFile::ClassDef* DexFile::FindClassDef(const char* descriptor) const {
+  return FindClassDef(descriptor, ComputeModifiedUtf8Hash(descriptor));
+}
+
+const DexFile::ClassDef* DexFile::FindClassDef(const char* descriptor, size_t hash) const {
+  if (NumClassDefs() == 0) {
     return NULL;
   }
-  uint16_t type_idx = GetIndexForTypeId(*type_id);
-  for (size_t i = 0; i < num_class_defs; ++i) {
-    const ClassDef& class_def = GetClassDef(i);
-    if (class_def.class_idx_ == type_idx) {
-      return &class_def;
+  const ClassDefIndex* index = GetClassDefIndex();
+  const uint32_t hash32 = static_cast<uint32_t>(hash);
+  for (size_t i = ClassDefIndex::FirstIndex(hash32, index->mask); ; i = (i + 1) & index->mask) {
+    const ClassDefIndex::Entry& entry = index->entries[i];
+    if (entry.class_def_idx == kDexNoIndex16) {
+      return NULL;
+    }
+    if (entry.hash == hash32) {
+      const ClassDef& class_def = GetClassDef(entry.class_def_idx);
+      if (strcmp(descriptor, GetClassDescriptor(class_def)) == 0) {
+        return &class_def;
+      }
     }
   }
-  return NULL;
 }
 
 const DexFile::ClassDef* DexFile::FindClassDef(uint16_t type_idx) const {
-  size_t num_class_defs = NumClassDefs();
-  for (size_t i = 0; i < num_class_defs; ++i) {
-    const ClassDef& class_def = GetClassDef(i);
-    if (class_def.class_idx_ == type_idx) {
-      return &class_def;
-    }
+  if (NumClassDefs() == 0) {
+    return NULL;
   }
-  return NULL;
+  DCHECK_LT(type_idx, NumTypeIds()) << GetLocation();
+  uint16_t class_def_idx = GetClassDefIndex()->type_to_class_def[type_idx];
+  return class_def_idx != kDexNoIndex16 ? &GetClassDef(class_def_idx) : NULL;
 }
 
 const DexFile::FieldId* DexFile::FindFieldId(const DexFile::TypeId& declaring_klass,
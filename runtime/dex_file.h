@@ -342,6 +342,10 @@ class DexFile {
   static ClassPathEntry FindInClassPath(const char* descriptor,
                                         const ClassPath& class_path);
 
+  // As above, with the descriptor's ComputeModifiedUtf8Hash, which is shared by every DexFile.
+  static ClassPathEntry FindInClassPath(const char* descriptor, size_t hash,
+                                        const ClassPath& class_path);
+
   // Returns the checksum of a file for comparison with GetLocationChecksum().
   // For .dex files, this is the header checksum.
   // For zip files, this is the classes.dex zip entry CRC32 checksum.
@@ -363,6 +367,10 @@ class DexFile {
   // Opens .dex file from the classes.dex in a zip archive
   static const DexFile* Open(const ZipArchive& zip_archive, const std::string& location);
 
+  // Sets whether .dex files opened from now on leave checking the class data and code of a class
+  // definition until the class is defined, so that classes which are never loaded aren't checked.
+  static void SetVerifyClassDataLazily(bool lazily);
+
   // Closes a .dex file.
   virtual ~DexFile();
 
@@ -599,9 +607,17 @@ class DexFile {
   // Looks up a class definition by its class descriptor.
   const ClassDef* FindClassDef(const char* descriptor) const;
 
+  // Looks up a class definition by its class descriptor and the descriptor's
+  // ComputeModifiedUtf8Hash.
+  const ClassDef* FindClassDef(const char* descriptor, size_t hash) const;
+
   // Looks up a class definition by its type index.
   const ClassDef* FindClassDef(uint16_t type_idx) const;
 
+  // Checks the class data and code of a class definition if that was left until first use when
+  // the file was opened, remembering the result. Returns false if they are malformed.
+  bool VerifyClassDef(const ClassDef& class_def) const;
+
   const TypeList* GetInterfacesList(const ClassDef& class_def) const {
     if (class_def.interfaces_off_ == 0) {
         return NULL;
@@ -814,6 +830,15 @@ class DexFile {
   }
 
  private:
+  struct ClassDefIndex;
+
+  // Verification states of a class definition whose class data wasn't checked at open.
+  enum ClassDefVerification {
+    kClassDefUnverified = 0,
+    kClassDefVerified,
+    kClassDefMalformed,
+  };
+
   // Opens a .dex file
   static const DexFile* OpenFile(int fd,
                                  const std::string& location,
@@ -850,7 +875,9 @@ class DexFile {
         field_ids_(0),
         method_ids_(0),
         proto_ids_(0),
-        class_defs_(0) {
+        class_defs_(0),
+        class_def_index_(NULL),
+        class_def_verification_(NULL) {
     CHECK(begin_ != NULL) << GetLocation();
     CHECK_GT(size_, 0U) << GetLocation();
   }
@@ -861,6 +888,13 @@ class DexFile {
   // Caches pointers into to the various file sections.
   void InitMembers();
 
+  // Returns the class definition index, building it on first use.
+  const ClassDefIndex* GetClassDefIndex() const;
+
+  // Verifies a freshly opened file, leaving the class data for VerifyClassDef if
+  // verify_class_data_lazily_ is set.
+  bool Verify() const;
+
   // Returns true if the header magic and version numbers are of the expected values.
   bool CheckMagicAndVersion() const;
 
@@ -910,6 +944,23 @@ class DexFile {
 
   // Points to the base of the class definition list.
   const ClassDef* class_defs_;
+
+  // Finds class definitions by type index or descriptor hash without searching the string and
+  // type ids. Built on first use since many dex files are never searched for classes, and
+  // published with a CAS so that racing lookups agree on a single index.
+  mutable const ClassDefIndex* volatile class_def_index_;
+
+  // The ClassDefVerification of each class definition if the class data was left unverified at
+  // open, NULL otherwise. Threads racing to check a class definition reach the same state, so a
+  // plain byte store publishes it.
+  mutable UniquePtr<uint8_t[]> class_def_verification_;
+
+  // The offsets of the class_data_items and code_items, in order, if the class data was left
+  // unverified at open. Class definitions may only refer to these item starts.
+  mutable std::vector<uint32_t> class_data_item_offsets_;
+  mutable std::vector<uint32_t> code_item_offsets_;
+
+  static bool verify_class_data_lazily_;
 };
 
 // Iterate over a dex file's ProtoId's paramters
@@ -16,6 +16,11 @@
 
 #include "dex_file.h"
 
+#include <zlib.h>
+
+#include <string>
+#include <vector>
+
 #include "UniquePtr.h"
 #include "common_test.h"
 
@@ -137,6 +142,77 @@ TEST_F(DexFileTest, ClassDefs) {
   EXPECT_STREQ("LNested;", raw->GetClassDescriptor(c1));
 }
 
+TEST_F(DexFileTest, VerifyClassDataLazily) {
+  ScratchFile tmp;
+  UniquePtr<const DexFile> raw(OpenDexFileBase64(kRawDex, tmp.GetFilename()));
+  ASSERT_TRUE(raw.get() != NULL);
+  EXPECT_TRUE(raw->VerifyClassDef(raw->GetClassDef(0)));
+
+  // Find the code of the constructor of Nested$Inner.
+  ClassDataItemIterator it(*raw, raw->GetClassData(raw->GetClassDef(0)));
+  while (it.HasNextStaticField() || it.HasNextInstanceField()) {
+    it.Next();
+  }
+  ASSERT_TRUE(it.HasNextDirectMethod());
+  uint32_t code_off = it.GetMethodCodeItemOffset();
+  ASSERT_NE(0U, code_off);
+
+  // Give it more ins than registers, which only checking the code_item notices.
+  size_t length;
+  UniquePtr<byte[]> dex_bytes(DecodeBase64(kRawDex, &length));
+  ASSERT_TRUE(dex_bytes.get() != NULL);
+  DexFile::CodeItem* code_item = reinterpret_cast<DexFile::CodeItem*>(&dex_bytes[code_off]);
+  code_item->ins_size_ = code_item->registers_size_ + 1;
+  DexFile::Header* header = reinterpret_cast<DexFile::Header*>(dex_bytes.get());
+  const size_t non_sum = sizeof(header->magic_) + sizeof(header->checksum_);
+  header->checksum_ = adler32(adler32(0L, Z_NULL, 0), &dex_bytes[non_sum], length - non_sum);
+  ScratchFile malformed;
+  ASSERT_TRUE(malformed.GetFile()->WriteFully(dex_bytes.get(), length));
+
+  ScopedObjectAccess soa(Thread::Current());
+  const std::string& location = malformed.GetFilename();
+  UniquePtr<const DexFile> eager(DexFile::Open(location, location));
+  EXPECT_TRUE(eager.get() == NULL);
+
+  DexFile::SetVerifyClassDataLazily(true);
+  UniquePtr<const DexFile> lazy(DexFile::Open(location, location));
+  DexFile::SetVerifyClassDataLazily(false);
+  ASSERT_TRUE(lazy.get() != NULL);
+  EXPECT_FALSE(lazy->VerifyClassDef(lazy->GetClassDef(0)));
+  EXPECT_TRUE(lazy->VerifyClassDef(lazy->GetClassDef(1)));
+  // The result is remembered.
+  EXPECT_FALSE(lazy->VerifyClassDef(lazy->GetClassDef(0)));
+}
+
+TEST_F(DexFileTest, VerifyClassDataLazilyChecksMap) {
+  size_t length;
+  UniquePtr<byte[]> dex_bytes(DecodeBase64(kRawDex, &length));
+  ASSERT_TRUE(dex_bytes.get() != NULL);
+
+  // Claim one more code_item than there is, the walk then runs into the next section.
+  DexFile::Header* header = reinterpret_cast<DexFile::Header*>(dex_bytes.get());
+  DexFile::MapList* map = reinterpret_cast<DexFile::MapList*>(&dex_bytes[header->map_off_]);
+  bool found = false;
+  for (uint32_t i = 0; i < map->size_; i++) {
+    if (map->list_[i].type_ == DexFile::kDexTypeCodeItem) {
+      map->list_[i].size_++;
+      found = true;
+    }
+  }
+  ASSERT_TRUE(found);
+  const size_t non_sum = sizeof(header->magic_) + sizeof(header->checksum_);
+  header->checksum_ = adler32(adler32(0L, Z_NULL, 0), &dex_bytes[non_sum], length - non_sum);
+  ScratchFile malformed;
+  ASSERT_TRUE(malformed.GetFile()->WriteFully(dex_bytes.get(), length));
+
+  ScopedObjectAccess soa(Thread::Current());
+  const std::string& location = malformed.GetFilename();
+  DexFile::SetVerifyClassDataLazily(true);
+  UniquePtr<const DexFile> lazy(DexFile::Open(location, location));
+  DexFile::SetVerifyClassDataLazily(false);
+  EXPECT_TRUE(lazy.get() == NULL);
+}
+
 TEST_F(DexFileTest, CreateMethodSignature) {
   ScopedObjectAccess soa(Thread::Current());
   const DexFile* raw(OpenTestDexFile("CreateMethodSignature"));
@@ -269,4 +345,61 @@ TEST_F(DexFileTest, FindFieldId) {
   }
 }
 
+TEST_F(DexFileTest, FindClassDef) {
+  for (size_t i = 0; i < java_lang_dex_file_->NumClassDefs(); i++) {
+    const DexFile::ClassDef& class_def = java_lang_dex_file_->GetClassDef(i);
+    const char* descriptor = java_lang_dex_file_->GetClassDescriptor(class_def);
+    EXPECT_EQ(&class_def, java_lang_dex_file_->FindClassDef(descriptor)) << descriptor;
+    EXPECT_EQ(&class_def, java_lang_dex_file_->FindClassDef(class_def.class_idx_)) << descriptor;
+  }
+  // Array types and the types of other dex files have ids but no class definitions.
+  EXPECT_TRUE(java_lang_dex_file_->FindClassDef("[Ljava/lang/Object;") == NULL);
+  EXPECT_TRUE(java_lang_dex_file_->FindClassDef("LNoSuchClass;") == NULL);
+  for (size_t i = 0; i < java_lang_dex_file_->NumTypeIds(); i++) {
+    const char* descriptor = java_lang_dex_file_->StringByTypeIdx(i);
+    if (descriptor[0] == '[') {
+      EXPECT_TRUE(java_lang_dex_file_->FindClassDef(static_cast<uint16_t>(i)) == NULL);
+    }
+  }
+}
+
+// Times class path lookups of every class in core.jar, as done by the class linker for classes
+// which aren't loaded yet, along with misses which have to search every dex file.
+TEST_F(DexFileTest, FindInClassPathBenchmark) {
+  static const size_t kIterations = 10;
+  const DexFile::ClassPath& class_path = boot_class_path_;
+  std::vector<std::string> misses;
+  for (size_t i = 0; i < java_lang_dex_file_->NumClassDefs(); i++) {
+    const DexFile::ClassDef& class_def = java_lang_dex_file_->GetClassDef(i);
+    const char* descriptor = java_lang_dex_file_->GetClassDescriptor(class_def);
+    DexFile::ClassPathEntry entry = DexFile::FindInClassPath(descriptor, class_path);
+    ASSERT_EQ(java_lang_dex_file_, entry.first) << descriptor;
+    ASSERT_EQ(&class_def, entry.second) << descriptor;
+    misses.push_back(std::string(descriptor, strlen(descriptor) - 1) + "$Missing;");
+  }
+  size_t num_class_defs = java_lang_dex_file_->NumClassDefs();
+  uint64_t start_ns = NanoTime();
+  for (size_t iteration = 0; iteration < kIterations; ++iteration) {
+    for (size_t i = 0; i < num_class_defs; i++) {
+      const DexFile::ClassDef& class_def = java_lang_dex_file_->GetClassDef(i);
+      const char* descriptor = java_lang_dex_file_->GetClassDescriptor(class_def);
+      EXPECT_TRUE(DexFile::FindInClassPath(descriptor, class_path).second != NULL);
+    }
+  }
+  uint64_t hits_ns = NanoTime() - start_ns;
+  start_ns = NanoTime();
+  for (size_t iteration = 0; iteration < kIterations; ++iteration) {
+    for (size_t i = 0; i < misses.size(); i++) {
+      EXPECT_TRUE(DexFile::FindInClassPath(misses[i].c_str(), class_path).second == NULL);
+    }
+  }
+  uint64_t misses_ns = NanoTime() - start_ns;
+  size_t lookups = kIterations * num_class_defs;
+  LOG(INFO) << "FindInClassPath over " << class_path.size() << " dex files: "
+            << lookups << " hits in " << PrettyDuration(hits_ns)
+            << " (" << hits_ns / lookups << "ns each), "
+            << lookups << " misses in " << PrettyDuration(misses_ns)
+            << " (" << misses_ns / lookups << "ns each)";
+}
+
 }  // namespace art
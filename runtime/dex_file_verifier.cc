@@ -16,6 +16,8 @@
 
 #include "dex_file_verifier.h"
 
+#include <algorithm>
+
 #include "base/stringprintf.h"
 #include "dex_file-inl.h"
 #include "leb128.h"
@@ -65,6 +67,11 @@ static bool IsDataSectionType(uint32_t map_type) {
   return true;
 }
 
+// The sections whose items VerifyDeferringClassData leaves for VerifyClassDef.
+static bool IsDeferredSectionType(uint32_t map_type) {
+  return map_type == DexFile::kDexTypeClassDataItem || map_type == DexFile::kDexTypeCodeItem;
+}
+
 static bool CheckShortyDescriptorMatch(char shorty_char, const char* descriptor,
     bool is_return_type) {
   switch (shorty_char) {
@@ -101,10 +108,39 @@ static bool CheckShortyDescriptorMatch(char shorty_char, const char* descriptor,
 }
 
 bool DexFileVerifier::Verify(const DexFile* dex_file, const byte* begin, size_t size) {
-  UniquePtr<DexFileVerifier> verifier(new DexFileVerifier(dex_file, begin, size));
+  UniquePtr<DexFileVerifier> verifier(new DexFileVerifier(dex_file, begin, size, false));
   return verifier->Verify();
 }
 
+bool DexFileVerifier::VerifyDeferringClassData(const DexFile* dex_file, const byte* begin,
+                                               size_t size,
+                                               std::vector<uint32_t>* class_data_item_offsets,
+                                               std::vector<uint32_t>* code_item_offsets) {
+  UniquePtr<DexFileVerifier> verifier(new DexFileVerifier(dex_file, begin, size, true));
+  if (!verifier->Verify()) {
+    return false;
+  }
+  // The map is ordered by offset, so the offsets come out sorted.
+  for (const auto& it : verifier->offset_to_type_map_) {
+    if (it.second == DexFile::kDexTypeClassDataItem) {
+      class_data_item_offsets->push_back(it.first);
+    } else if (it.second == DexFile::kDexTypeCodeItem) {
+      code_item_offsets->push_back(it.first);
+    }
+  }
+  return true;
+}
+
+bool DexFileVerifier::VerifyClassDef(const DexFile* dex_file, uint16_t class_def_idx,
+                                     const std::vector<uint32_t>& class_data_item_offsets,
+                                     const std::vector<uint32_t>& code_item_offsets) {
+  UniquePtr<DexFileVerifier> verifier(
+      new DexFileVerifier(dex_file, dex_file->Begin(), dex_file->Size(), true));
+  verifier->class_data_item_offsets_ = &class_data_item_offsets;
+  verifier->code_item_offsets_ = &code_item_offsets;
+  return verifier->CheckClassDefData(&dex_file->GetClassDef(class_def_idx));
+}
+
 bool DexFileVerifier::CheckPointerRange(const void* start, const void* end, const char* label) const {
   uint32_t range_start = reinterpret_cast<uint32_t>(start);
   uint32_t range_end = reinterpret_cast<uint32_t>(end);
@@ -688,6 +724,65 @@ bool DexFileVerifier::CheckIntraCodeItem() {
   return true;
 }
 
+// Moves past a class_data_item without checking its members, for VerifyDeferringClassData.
+bool DexFileVerifier::SkipClassDataItem() {
+  ClassDataItemIterator it(*dex_file_, ptr_);
+  while (it.HasNext()) {
+    it.Next();
+  }
+  ptr_ = it.EndDataPointer();
+  return true;
+}
+
+// Moves past a code_item the way CheckIntraCodeItem does, checking only what is needed to find
+// its end.
+bool DexFileVerifier::SkipCodeItem() {
+  const DexFile::CodeItem* code_item = reinterpret_cast<const DexFile::CodeItem*>(ptr_);
+  if (!CheckPointerRange(code_item, code_item + 1, "code")) {
+    return false;
+  }
+
+  const uint16_t* insns = code_item->insns_;
+  uint32_t insns_size = code_item->insns_size_in_code_units_;
+  if (!CheckListSize(insns, insns_size, sizeof(uint16_t), "insns size")) {
+    return false;
+  }
+
+  uint32_t try_items_size = code_item->tries_size_;
+  if (try_items_size == 0) {
+    ptr_ = reinterpret_cast<const byte*>(&insns[insns_size]);
+    return true;
+  }
+
+  const DexFile::TryItem* try_items = DexFile::GetTryItems(*code_item, 0);
+  if (!CheckListSize(try_items, try_items_size, sizeof(DexFile::TryItem), "try_items size")) {
+    return false;
+  }
+
+  ptr_ = DexFile::GetCatchHandlerData(*code_item, 0);
+  uint32_t handlers_size = DecodeUnsignedLeb128(&ptr_);
+  if ((handlers_size == 0) || (handlers_size >= 65536)) {
+    LOG(ERROR) << "Invalid handlers_size: " << handlers_size;
+    return false;
+  }
+
+  for (uint32_t i = 0; i < handlers_size; i++) {
+    int32_t size = DecodeSignedLeb128(&ptr_);
+    if ((size < -65536) || (size > 65536)) {
+      LOG(ERROR) << "Invalid exception handler size: " << size;
+      return false;
+    }
+
+    // A type_idx and an addr per handler, then the catch_all_addr if there is one.
+    uint32_t num_values = (size <= 0) ? (-size * 2) + 1 : size * 2;
+    while (num_values-- > 0) {
+      DecodeUnsignedLeb128(&ptr_);
+    }
+  }
+
+  return true;
+}
+
 bool DexFileVerifier::CheckIntraStringDataItem() {
   uint32_t size = DecodeUnsignedLeb128(&ptr_);
   const byte* file_end = begin_ + size_;
@@ -1079,13 +1174,13 @@ bool DexFileVerifier::CheckIntraSectionIterate(uint32_t offset, uint32_t count,
         break;
       }
       case DexFile::kDexTypeClassDataItem: {
-        if (!CheckIntraClassDataItem()) {
+        if (defer_class_data_ ? !SkipClassDataItem() : !CheckIntraClassDataItem()) {
           return false;
         }
         break;
       }
       case DexFile::kDexTypeCodeItem: {
-        if (!CheckIntraCodeItem()) {
+        if (defer_class_data_ ? !SkipCodeItem() : !CheckIntraCodeItem()) {
           return false;
         }
         break;
@@ -1298,7 +1393,38 @@ bool DexFileVerifier::CheckIntraSection() {
   return true;
 }
 
+// Checks a class_data_item or code_item when a class definition refers to it. The walk of
+// VerifyDeferringClassData has already found where the items start and end, so an offset
+// must be one of the starts, and checking the item ends where the walk did.
+bool DexFileVerifier::CheckDeferredItem(uint32_t offset, uint16_t type) {
+  const std::vector<uint32_t>* item_offsets =
+      (type == DexFile::kDexTypeClassDataItem) ? class_data_item_offsets_ : code_item_offsets_;
+  if (!std::binary_search(item_offsets->begin(), item_offsets->end(), offset)) {
+    LOG(ERROR) << StringPrintf("No data map entry found @ %x; expected %x", offset, type);
+    return false;
+  }
+
+  // Code items are checked while CheckInterClassDataItem walks a class_data_item.
+  const byte* saved_ptr = ptr_;
+  ptr_ = begin_ + offset;
+  bool result;
+  if (type == DexFile::kDexTypeClassDataItem) {
+    result = CheckIntraClassDataItem();
+    if (result) {
+      ptr_ = begin_ + offset;
+      result = CheckInterClassDataItem();
+    }
+  } else {
+    result = CheckIntraCodeItem();
+  }
+  ptr_ = saved_ptr;
+  return result;
+}
+
 bool DexFileVerifier::CheckOffsetToTypeMap(uint32_t offset, uint16_t type) {
+  if (defer_class_data_ && IsDeferredSectionType(type)) {
+    return CheckDeferredItem(offset, type);
+  }
   auto it = offset_to_type_map_.find(offset);
   if (it == offset_to_type_map_.end()) {
     LOG(ERROR) << StringPrintf("No data map entry found @ %x; expected %x", offset, type);
@@ -1552,6 +1678,24 @@ bool DexFileVerifier::CheckInterMethodIdItem() {
   return true;
 }
 
+bool DexFileVerifier::CheckClassDefData(const DexFile::ClassDef* item) {
+  if (item->class_data_off_ == 0) {
+    return true;
+  }
+  if (!CheckOffsetToTypeMap(item->class_data_off_, DexFile::kDexTypeClassDataItem)) {
+    return false;
+  }
+
+  // Check that references in class_data_item are to the right class.
+  const byte* data = begin_ + item->class_data_off_;
+  uint16_t data_definer = FindFirstClassDataDefiner(data);
+  if ((data_definer != item->class_idx_) && (data_definer != DexFile::kDexNoIndex16)) {
+    LOG(ERROR) << "Invalid class_data_item";
+    return false;
+  }
+  return true;
+}
+
 bool DexFileVerifier::CheckInterClassDefItem() {
   const DexFile::ClassDef* item = reinterpret_cast<const DexFile::ClassDef*>(ptr_);
   uint32_t class_idx = item->class_idx_;
@@ -1570,10 +1714,6 @@ bool DexFileVerifier::CheckInterClassDefItem() {
       !CheckOffsetToTypeMap(item->annotations_off_, DexFile::kDexTypeAnnotationsDirectoryItem)) {
     return false;
   }
-  if (item->class_data_off_ != 0 &&
-      !CheckOffsetToTypeMap(item->class_data_off_, DexFile::kDexTypeClassDataItem)) {
-    return false;
-  }
   if (item->static_values_off_ != 0 &&
       !CheckOffsetToTypeMap(item->static_values_off_, DexFile::kDexTypeEncodedArrayItem)) {
     return false;
@@ -1616,14 +1756,8 @@ bool DexFileVerifier::CheckInterClassDefItem() {
     }
   }
 
-  // Check that references in class_data_item are to the right class.
-  if (item->class_data_off_ != 0) {
-    const byte* data = begin_ + item->class_data_off_;
-    uint16_t data_definer = FindFirstClassDataDefiner(data);
-    if ((data_definer != item->class_idx_) && (data_definer != DexFile::kDexNoIndex16)) {
-      LOG(ERROR) << "Invalid class_data_item";
-      return false;
-    }
+  if (!defer_class_data_ && !CheckClassDefData(item)) {
+    return false;
   }
 
   // Check that references in annotations_directory_item are to right class.
@@ -1900,13 +2034,19 @@ bool DexFileVerifier::CheckInterSection() {
       case DexFile::kDexTypeClassDefItem:
       case DexFile::kDexTypeAnnotationSetRefList:
       case DexFile::kDexTypeAnnotationSetItem:
-      case DexFile::kDexTypeClassDataItem:
       case DexFile::kDexTypeAnnotationsDirectoryItem: {
         if (!CheckInterSectionIterate(section_offset, section_count, type)) {
           return false;
         }
         break;
       }
+      case DexFile::kDexTypeClassDataItem: {
+        // Deferred class_data_items are checked through the class definitions.
+        if (!defer_class_data_ && !CheckInterSectionIterate(section_offset, section_count, type)) {
+          return false;
+        }
+        break;
+      }
       default:
         LOG(ERROR) << StringPrintf("Unknown map item type %x", type);
         return false;
@@ -17,6 +17,8 @@
 #ifndef ART_RUNTIME_DEX_FILE_VERIFIER_H_
 #define ART_RUNTIME_DEX_FILE_VERIFIER_H_
 
+#include <vector>
+
 #include "dex_file.h"
 #include "safe_map.h"
 
@@ -26,10 +28,25 @@ class DexFileVerifier {
  public:
   static bool Verify(const DexFile* dex_file, const byte* begin, size_t size);
 
+  // As Verify, except that the class_data_items and code_items are only walked to find where
+  // they start and end. The starts are returned in order, their contents are left to
+  // VerifyClassDef.
+  static bool VerifyDeferringClassData(const DexFile* dex_file, const byte* begin, size_t size,
+                                       std::vector<uint32_t>* class_data_item_offsets,
+                                       std::vector<uint32_t>* code_item_offsets);
+
+  // Checks the class_data_item of a class definition and the code_items of its methods the way
+  // Verify does, given the item starts found by VerifyDeferringClassData.
+  static bool VerifyClassDef(const DexFile* dex_file, uint16_t class_def_idx,
+                             const std::vector<uint32_t>& class_data_item_offsets,
+                             const std::vector<uint32_t>& code_item_offsets);
+
  private:
-  DexFileVerifier(const DexFile* dex_file, const byte* begin, size_t size)
+  DexFileVerifier(const DexFile* dex_file, const byte* begin, size_t size, bool defer_class_data)
       : dex_file_(dex_file), begin_(begin), size_(size),
-        header_(&dex_file->GetHeader()), ptr_(NULL), previous_item_(NULL)  {
+        header_(&dex_file->GetHeader()), defer_class_data_(defer_class_data),
+        class_data_item_offsets_(NULL), code_item_offsets_(NULL), ptr_(NULL),
+        previous_item_(NULL)  {
   }
 
   bool Verify();
@@ -54,6 +71,8 @@ class DexFileVerifier {
 
   bool CheckIntraClassDataItem();
   bool CheckIntraCodeItem();
+  bool SkipClassDataItem();
+  bool SkipCodeItem();
   bool CheckIntraStringDataItem();
   bool CheckIntraDebugInfoItem();
   bool CheckIntraAnnotationItem();
@@ -64,6 +83,7 @@ class DexFileVerifier {
   bool CheckIntraDataSection(uint32_t offset, uint32_t count, uint16_t type);
   bool CheckIntraSection();
 
+  bool CheckDeferredItem(uint32_t offset, uint16_t type);
   bool CheckOffsetToTypeMap(uint32_t offset, uint16_t type);
   uint16_t FindFirstClassDataDefiner(const byte* ptr) const;
   uint16_t FindFirstAnnotationsDirectoryDefiner(const byte* ptr) const;
@@ -73,6 +93,7 @@ class DexFileVerifier {
   bool CheckInterProtoIdItem();
   bool CheckInterFieldIdItem();
   bool CheckInterMethodIdItem();
+  bool CheckClassDefData(const DexFile::ClassDef* item);
   bool CheckInterClassDefItem();
   bool CheckInterAnnotationSetRefList();
   bool CheckInterAnnotationSetItem();
@@ -87,6 +108,14 @@ class DexFileVerifier {
   size_t size_;
   const DexFile::Header* header_;
 
+  // Whether the contents of class_data_items and code_items are checked from the class
+  // definitions using them rather than while walking their sections.
+  const bool defer_class_data_;
+
+  // The item starts found by VerifyDeferringClassData, in order, when checking a class definition.
+  const std::vector<uint32_t>* class_data_item_offsets_;
+  const std::vector<uint32_t>* code_item_offsets_;
+
   SafeMap<uint32_t, uint16_t> offset_to_type_map_;
   const byte* ptr_;
   const void* previous_item_;
@@ -320,13 +320,13 @@ static inline void CheckReferenceResult(mirror::Object* o, Thread* self)
   }
 }
 
-static inline void CheckSuspend(Thread* thread) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+static inline void CheckSuspend(Thread* thread, bool at_moving_gc_safe_point = false)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   for (;;) {
     if (thread->ReadFlag(kCheckpointRequest)) {
       thread->RunCheckpointFunction();
-      thread->AtomicClearFlag(kCheckpointRequest);
     } else if (thread->ReadFlag(kSuspendRequest)) {
-      thread->FullSuspendCheck();
+      thread->FullSuspendCheck(at_moving_gc_safe_point);
     } else {
       break;
     }
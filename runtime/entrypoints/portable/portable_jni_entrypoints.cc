@@ -27,6 +27,8 @@ extern "C" uint32_t art_portable_jni_method_start(Thread* self)
   JNIEnvExt* env = self->GetJniEnv();
   uint32_t saved_local_ref_cookie = env->local_ref_cookie;
   env->local_ref_cookie = env->locals.GetSegmentState();
+  // Native code only refers to objects through JNI references and pins critical arrays.
+  self->SetAtMovingGcSafePoint(true);
   self->TransitionFromRunnableToSuspended(kNative);
   return saved_local_ref_cookie;
 }
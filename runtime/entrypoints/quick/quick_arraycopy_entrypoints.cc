@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "array_copy.h"
+#include "callee_save_frame.h"
+#include "mirror/object-inl.h"
+
+namespace art {
+
+/*
+ * System.arraycopy called from compiled code without the JNI transition. The five arguments
+ * don't fit in the argument registers, so the caller stores them in its outs area and passes a
+ * pointer to them:
+ *  args[0] src
+ *  args[1] srcPos
+ *  args[2] dst
+ *  args[3] dstPos
+ *  args[4] length
+ */
+extern "C" int artArrayCopyFromCode(const int32_t* args, Thread* self, mirror::ArtMethod** sp)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  FinishCalleeSaveFrameSetup(self, sp, Runtime::kRefsOnly);
+  ArrayCopy(self, reinterpret_cast<mirror::Object*>(args[0]), args[1],
+            reinterpret_cast<mirror::Object*>(args[2]), args[3], args[4]);
+  return UNLIKELY(self->IsExceptionPending()) ? -1 : 0;  // Error or success
+}
+
+}  // namespace art
@@ -114,6 +114,7 @@ struct PACKED(4) QuickEntryPoints {
   int32_t (*pMemcmp16)(void*, void*, int32_t);
   int32_t (*pStringCompareTo)(void*, void*);
   void* (*pMemcpy)(void*, const void*, size_t);
+  int32_t (*pArrayCopy)(const int32_t*);
 
   // Invocation
   void (*pQuickResolutionTrampoline)(mirror::ArtMethod*);
@@ -33,6 +33,8 @@ extern uint32_t JniMethodStart(Thread* self) {
   DCHECK(env != NULL);
   uint32_t saved_local_ref_cookie = env->local_ref_cookie;
   env->local_ref_cookie = env->locals.GetSegmentState();
+  // Native code only refers to objects through JNI references and pins critical arrays.
+  self->SetAtMovingGcSafePoint(true);
   self->TransitionFromRunnableToSuspended(kNative);
   return saved_local_ref_cookie;
 }
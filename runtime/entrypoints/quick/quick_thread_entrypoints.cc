@@ -32,7 +32,8 @@ extern "C" void artTestSuspendFromCode(Thread* thread, mirror::ArtMethod** sp)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   // Called when suspend count check value is 0 and thread->suspend_count_ != 0
   FinishCalleeSaveFrameSetup(thread, sp, Runtime::kRefsOnly);
-  CheckSuspend(thread);
+  // The compiled code's references are all in its frames, which a moving collector updates.
+  CheckSuspend(thread, true);
 }
 
 }  // namespace art
@@ -17,6 +17,7 @@
 #ifndef ART_RUNTIME_GC_ACCOUNTING_ATOMIC_STACK_H_
 #define ART_RUNTIME_GC_ACCOUNTING_ATOMIC_STACK_H_
 
+#include <algorithm>
 #include <string>
 
 #include "atomic_integer.h"
@@ -73,6 +74,30 @@ class AtomicStack {
     return true;
   }
 
+  // Atomically reserves num_slots consecutive slots at the back of the stack and stores their
+  // bounds in start_address and end_address. The reserved slots are cleared to T() so that
+  // slots the reserver has not yet filled in can be told apart. Returns false if we would
+  // overflow the stack.
+  bool AtomicBumpBack(size_t num_slots, T** start_address, T** end_address) {
+    if (kIsDebugBuild) {
+      debug_is_sorted_ = false;
+    }
+    int32_t index;
+    int32_t new_index;
+    do {
+      index = back_index_;
+      new_index = index + num_slots;
+      if (UNLIKELY(static_cast<size_t>(new_index) > capacity_)) {
+        // Stack overflow.
+        return false;
+      }
+    } while (!back_index_.compare_and_swap(index, new_index));
+    *start_address = &begin_[index];
+    *end_address = &begin_[new_index];
+    std::fill(*start_address, *end_address, T());
+    return true;
+  }
+
   void PushBack(const T& value) {
     if (kIsDebugBuild) {
       debug_is_sorted_ = false;
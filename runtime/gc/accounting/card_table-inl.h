@@ -17,6 +17,12 @@
 #ifndef ART_RUNTIME_GC_ACCOUNTING_CARD_TABLE_INL_H_
 #define ART_RUNTIME_GC_ACCOUNTING_CARD_TABLE_INL_H_
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #include "base/logging.h"
 #include "card_table.h"
 #include "cutils/atomic-inline.h"
@@ -27,6 +33,9 @@ namespace art {
 namespace gc {
 namespace accounting {
 
+// Number of cards checked at once when scanning, the width of a vector register.
+static const size_t kCardsPerBlock = 16;
+
 static inline bool byte_cas(byte old_value, byte new_value, byte* address) {
   // Little endian means most significant byte is on the left.
   const size_t shift = reinterpret_cast<uintptr_t>(address) % sizeof(uintptr_t);
@@ -41,6 +50,57 @@ static inline bool byte_cas(byte old_value, byte new_value, byte* address) {
   return success;
 }
 
+// Returns a mask with bit i set iff card i of the kCardsPerBlock cards starting at cards is at
+// least minimum_age. The cards must be aligned to kCardsPerBlock.
+static inline uint32_t CardBlockMask(const byte* cards, byte minimum_age) {
+  DCHECK(IsAligned<kCardsPerBlock>(cards));
+#if defined(__SSE2__)
+  const __m128i block = _mm_load_si128(reinterpret_cast<const __m128i*>(cards));
+  // There is no unsigned byte comparison, a card is at least minimum_age iff it is the maximum of
+  // the two.
+  const __m128i age = _mm_set1_epi8(static_cast<char>(minimum_age));
+  const __m128i at_least = _mm_cmpeq_epi8(_mm_max_epu8(block, age), block);
+  return _mm_movemask_epi8(at_least);
+#elif defined(__ARM_NEON__)
+  static const uint8_t kLaneBits[kCardsPerBlock] = {
+    1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128
+  };
+  const uint8x16_t at_least = vcgeq_u8(vld1q_u8(cards), vdupq_n_u8(minimum_age));
+  const uint8x16_t bits = vandq_u8(at_least, vld1q_u8(kLaneBits));
+  // Pairwise adds fold the bits of each half into a byte, lane 0 holds the low half's mask and lane
+  // 1 the high half's.
+  uint8x8_t sum = vpadd_u8(vget_low_u8(bits), vget_high_u8(bits));
+  sum = vpadd_u8(sum, sum);
+  sum = vpadd_u8(sum, sum);
+  return vget_lane_u8(sum, 0) | (static_cast<uint32_t>(vget_lane_u8(sum, 1)) << 8);
+#else
+  const uintptr_t* words = reinterpret_cast<const uintptr_t*>(cards);
+  uint32_t mask = 0;
+  for (size_t i = 0; i < kCardsPerBlock / sizeof(uintptr_t); ++i) {
+    // Clean cards are below any minimum age but zero, skip words of them.
+    if (words[i] != 0 || minimum_age == CardTable::kCardClean) {
+      for (size_t j = 0; j < sizeof(uintptr_t); ++j) {
+        const size_t index = i * sizeof(uintptr_t) + j;
+        if (cards[index] >= minimum_age) {
+          mask |= 1U << index;
+        }
+      }
+    }
+  }
+  return mask;
+#endif
+}
+
+template <typename Visitor>
+inline size_t CardTable::VisitCardRange(SpaceBitmap* bitmap, byte* card_begin, byte* card_end,
+                                        const Visitor& visitor) const {
+  DCHECK_LT(card_begin, card_end);
+  uintptr_t start = reinterpret_cast<uintptr_t>(AddrFromCard(card_begin));
+  uintptr_t end = reinterpret_cast<uintptr_t>(AddrFromCard(card_end));
+  bitmap->VisitMarkedRange(start, end, visitor);
+  return card_end - card_begin;
+}
+
 template <typename Visitor>
 inline size_t CardTable::Scan(SpaceBitmap* bitmap, byte* scan_begin, byte* scan_end,
                               const Visitor& visitor, const byte minimum_age) const {
@@ -52,57 +112,46 @@ inline size_t CardTable::Scan(SpaceBitmap* bitmap, byte* scan_begin, byte* scan_
   CheckCardValid(card_end);
   size_t cards_scanned = 0;
 
-  // Handle any unaligned cards at the start.
-  while (!IsAligned<sizeof(word)>(card_cur) && card_cur < card_end) {
-    if (*card_cur >= minimum_age) {
-      uintptr_t start = reinterpret_cast<uintptr_t>(AddrFromCard(card_cur));
-      bitmap->VisitMarkedRange(start, start + kCardSize, visitor);
-      ++cards_scanned;
+  // Adjacent cards to visit are gathered into a run which is visited with a single bitmap walk.
+  // NULL when the last card seen wasn't one to visit.
+  byte* run_begin = NULL;
+  while (card_cur < card_end) {
+    // Check blocks of cards at once, single cards at the unaligned start and end.
+    size_t count;
+    uint32_t mask;
+    if (IsAligned<kCardsPerBlock>(card_cur) &&
+        static_cast<size_t>(card_end - card_cur) >= kCardsPerBlock) {
+      count = kCardsPerBlock;
+      mask = CardBlockMask(card_cur, minimum_age);
+    } else {
+      count = 1;
+      mask = (*card_cur >= minimum_age) ? 1U : 0U;
     }
-    ++card_cur;
-  }
-
-  byte* aligned_end = card_end -
-      (reinterpret_cast<uintptr_t>(card_end) & (sizeof(uintptr_t) - 1));
-
-  uintptr_t* word_end = reinterpret_cast<uintptr_t*>(aligned_end);
-  for (uintptr_t* word_cur = reinterpret_cast<uintptr_t*>(card_cur); word_cur < word_end;
-      ++word_cur) {
-    while (LIKELY(*word_cur == 0)) {
-      ++word_cur;
-      if (UNLIKELY(word_cur >= word_end)) {
-        goto exit_for;
+    if (mask == 0) {
+      if (run_begin != NULL) {
+        cards_scanned += VisitCardRange(bitmap, run_begin, card_cur, visitor);
+        run_begin = NULL;
       }
-    }
-
-    // Find the first dirty card.
-    uintptr_t start_word = *word_cur;
-    uintptr_t start = reinterpret_cast<uintptr_t>(AddrFromCard(reinterpret_cast<byte*>(word_cur)));
-    // TODO: Investigate if processing continuous runs of dirty cards with a single bitmap visit is
-    // more efficient.
-    for (size_t i = 0; i < sizeof(uintptr_t); ++i) {
-      if (static_cast<byte>(start_word) >= minimum_age) {
-        auto* card = reinterpret_cast<byte*>(word_cur) + i;
-        DCHECK(*card == static_cast<byte>(start_word) || *card == kCardDirty)
-            << "card " << static_cast<size_t>(*card) << " word " << (start_word & 0xFF);
-        bitmap->VisitMarkedRange(start, start + kCardSize, visitor);
-        ++cards_scanned;
+    } else if (mask == (1U << count) - 1) {
+      if (run_begin == NULL) {
+        run_begin = card_cur;
+      }
+    } else {
+      for (size_t i = 0; i < count; ++i, mask >>= 1) {
+        if ((mask & 1) != 0) {
+          if (run_begin == NULL) {
+            run_begin = card_cur + i;
+          }
+        } else if (run_begin != NULL) {
+          cards_scanned += VisitCardRange(bitmap, run_begin, card_cur + i, visitor);
+          run_begin = NULL;
+        }
       }
-      start_word >>= 8;
-      start += kCardSize;
     }
+    card_cur += count;
   }
-  exit_for:
-
-  // Handle any unaligned cards at the end.
-  card_cur = reinterpret_cast<byte*>(word_end);
-  while (card_cur < card_end) {
-    if (*card_cur >= minimum_age) {
-      uintptr_t start = reinterpret_cast<uintptr_t>(AddrFromCard(card_cur));
-      bitmap->VisitMarkedRange(start, start + kCardSize, visitor);
-      ++cards_scanned;
-    }
-    ++card_cur;
+  if (run_begin != NULL) {
+    cards_scanned += VisitCardRange(bitmap, run_begin, card_end, visitor);
   }
 
   return cards_scanned;
@@ -146,7 +195,7 @@ inline void CardTable::ModifyCardsAtomic(byte* scan_begin, byte* scan_end, const
       new_value = visitor(expected);
     } while (expected != new_value && UNLIKELY(!byte_cas(expected, new_value, card_end)));
     if (expected != new_value) {
-      modified(card_cur, expected, new_value);
+      modified(card_end, expected, new_value);
     }
   }
 
@@ -156,8 +205,15 @@ inline void CardTable::ModifyCardsAtomic(byte* scan_begin, byte* scan_end, const
   uintptr_t expected_word;
   uintptr_t new_word;
 
-  // TODO: Parallelize.
+  // Clean cards are left alone, so blocks of them are skipped without looking at each word.
+  DCHECK(visitor(kCardClean) == kCardClean);
   while (word_cur < word_end) {
+    if (IsAligned<kCardsPerBlock>(word_cur) &&
+        static_cast<size_t>(word_end - word_cur) >= kCardsPerBlock / sizeof(uintptr_t) &&
+        CardBlockMask(reinterpret_cast<byte*>(word_cur), kCardClean + 1) == 0) {
+      word_cur += kCardsPerBlock / sizeof(uintptr_t);
+      continue;
+    }
     while ((expected_word = *word_cur) != 0) {
       new_word =
           (visitor((expected_word >> 0) & 0xFF) << 0) |
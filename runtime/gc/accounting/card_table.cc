@@ -87,8 +87,13 @@ CardTable::CardTable(MemMap* mem_map, byte* biased_begin, size_t offset)
 
 void CardTable::ClearSpaceCards(space::ContinuousSpace* space) {
   // TODO: clear just the range of the table that has been modified
-  byte* card_start = CardFromAddr(space->Begin());
-  byte* card_end = CardFromAddr(space->End());  // Make sure to round up.
+  ClearCardRange(space->Begin(), space->End());
+}
+
+void CardTable::ClearCardRange(const byte* start, const byte* end) {
+  byte* card_start = CardFromAddr(start);
+  byte* card_end = CardFromAddr(end);  // Make sure to round up.
+  // memset is vectorized already, there is nothing to gain from doing it by hand.
   memset(reinterpret_cast<void*>(card_start), kCardClean, card_end - card_start);
 }
 
@@ -100,7 +100,8 @@ class CardTable {
                          const ModifiedVisitor& modified);
 
   // For every dirty at least minumum age between begin and end invoke the visitor with the
-  // specified argument. Returns how many cards the visitor was run on.
+  // specified argument. Runs of adjacent cards are visited with a single bitmap walk. Returns how
+  // many cards the visitor was run on.
   template <typename Visitor>
   size_t Scan(SpaceBitmap* bitmap, byte* scan_begin, byte* scan_end, const Visitor& visitor,
               const byte minimum_age = kCardDirty) const
@@ -116,6 +117,9 @@ class CardTable {
   // Resets all of the bytes in the card table which do not map to the image space.
   void ClearSpaceCards(space::ContinuousSpace* space);
 
+  // Resets the cards covering the heap addresses [start, end).
+  void ClearCardRange(const byte* start, const byte* end);
+
   // Returns the first address in the heap which maps to this card.
   void* AddrFromCard(const byte *card_addr) const ALWAYS_INLINE;
 
@@ -136,6 +140,13 @@ class CardTable {
 
   void CheckCardValid(byte* card) const ALWAYS_INLINE;
 
+  // Visits the marked objects on the cards [card_begin, card_end), returns the number of cards.
+  template <typename Visitor>
+  size_t VisitCardRange(SpaceBitmap* bitmap, byte* card_begin, byte* card_end,
+                        const Visitor& visitor) const
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Verifies that all gray objects are on a dirty card.
   void VerifyCardTable();
 
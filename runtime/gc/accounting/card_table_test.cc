@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "card_table.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "card_table-inl.h"
+#include "common_test.h"
+#include "gc/heap.h"
+#include "scoped_thread_state_change.h"
+#include "space_bitmap-inl.h"
+#include "UniquePtr.h"
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+class CardTableTest : public CommonTest {
+ public:
+  static byte* const kHeapBegin;
+};
+
+byte* const CardTableTest::kHeapBegin = reinterpret_cast<byte*>(0x10000000);
+
+class CountingVisitor {
+ public:
+  explicit CountingVisitor(size_t* count) : count_(count) {}
+
+  void operator()(const mirror::Object* obj) const {
+    ++*count_;
+  }
+
+ private:
+  size_t* const count_;
+};
+
+class RecordModifiedVisitor {
+ public:
+  explicit RecordModifiedVisitor(std::vector<byte*>* cards) : cards_(cards) {}
+
+  void operator()(byte* card, byte expected_value, byte new_value) const {
+    EXPECT_TRUE(expected_value == CardTable::kCardDirty);
+    EXPECT_TRUE(new_value == CardTable::kCardDirty - 1);
+    EXPECT_EQ(new_value, *card);
+    cards_->push_back(card);
+  }
+
+ private:
+  std::vector<byte*>* const cards_;
+};
+
+// Dirty cards in runs of every length up to a few blocks, separated by clean and aged cards, so
+// that runs start and end at every offset within a block.
+static size_t DirtyCards(CardTable* card_table, SpaceBitmap* bitmap, size_t num_cards) {
+  size_t dirty = 0;
+  size_t card = 0;
+  for (size_t run = 1; card < num_cards; ++run) {
+    for (size_t i = 0; i < run % 50 && card < num_cards; ++i, ++card) {
+      byte* addr = CardTableTest::kHeapBegin + card * CardTable::kCardSize;
+      card_table->MarkCard(addr);
+      bitmap->Set(reinterpret_cast<mirror::Object*>(addr + SpaceBitmap::kAlignment));
+      ++dirty;
+    }
+    for (size_t i = 0; i < run % 7 && card < num_cards; ++i, ++card) {
+      byte* addr = CardTableTest::kHeapBegin + card * CardTable::kCardSize;
+      if ((i % 2) != 0) {
+        *card_table->CardFromAddr(addr) = CardTable::kCardDirty - 1;
+      }
+      bitmap->Set(reinterpret_cast<mirror::Object*>(addr));
+    }
+  }
+  return dirty;
+}
+
+TEST_F(CardTableTest, Scan) {
+  ScopedObjectAccess soa(Thread::Current());
+  WriterMutexLock mu(soa.Self(), *Locks::heap_bitmap_lock_);
+  const size_t heap_capacity = 4 * MB;
+  const size_t num_cards = heap_capacity / CardTable::kCardSize;
+  UniquePtr<CardTable> card_table(CardTable::Create(kHeapBegin, heap_capacity));
+  UniquePtr<SpaceBitmap> bitmap(SpaceBitmap::Create("test bitmap", kHeapBegin, heap_capacity));
+  ASSERT_TRUE(card_table.get() != NULL);
+  ASSERT_TRUE(bitmap.get() != NULL);
+  const size_t dirty = DirtyCards(card_table.get(), bitmap.get(), num_cards);
+
+  // Every marked object is on its own card, so objects visited and cards scanned match.
+  size_t visited = 0;
+  size_t scanned = card_table->Scan(bitmap.get(), kHeapBegin, kHeapBegin + heap_capacity,
+                                    CountingVisitor(&visited));
+  EXPECT_EQ(dirty, scanned);
+  EXPECT_EQ(dirty, visited);
+
+  size_t aged = 0;
+  for (size_t i = 0; i < num_cards; ++i) {
+    aged += (*card_table->CardFromAddr(kHeapBegin + i * CardTable::kCardSize) != 0) ? 1 : 0;
+  }
+  visited = 0;
+  scanned = card_table->Scan(bitmap.get(), kHeapBegin, kHeapBegin + heap_capacity,
+                             CountingVisitor(&visited), CardTable::kCardDirty - 1);
+  EXPECT_EQ(aged, scanned);
+  EXPECT_EQ(aged, visited);
+
+  // Ranges which aren't aligned to a block of cards.
+  for (size_t begin_card = 0; begin_card < 40; begin_card += 3) {
+    const size_t end_card = num_cards - begin_card * 5;
+    size_t expected = 0;
+    for (size_t i = begin_card; i < end_card; ++i) {
+      expected += card_table->IsDirty(
+          reinterpret_cast<mirror::Object*>(kHeapBegin + i * CardTable::kCardSize)) ? 1 : 0;
+    }
+    visited = 0;
+    scanned = card_table->Scan(bitmap.get(), kHeapBegin + begin_card * CardTable::kCardSize,
+                               kHeapBegin + end_card * CardTable::kCardSize,
+                               CountingVisitor(&visited));
+    EXPECT_EQ(expected, scanned);
+    EXPECT_EQ(expected, visited);
+  }
+}
+
+TEST_F(CardTableTest, ModifyCardsAtomic) {
+  ScopedObjectAccess soa(Thread::Current());
+  WriterMutexLock mu(soa.Self(), *Locks::heap_bitmap_lock_);
+  const size_t heap_capacity = 1 * MB;
+  const size_t num_cards = heap_capacity / CardTable::kCardSize;
+  UniquePtr<CardTable> card_table(CardTable::Create(kHeapBegin, heap_capacity));
+  UniquePtr<SpaceBitmap> bitmap(SpaceBitmap::Create("test bitmap", kHeapBegin, heap_capacity));
+  ASSERT_TRUE(card_table.get() != NULL);
+  ASSERT_TRUE(bitmap.get() != NULL);
+  // The aged cards of DirtyCards would be cleaned, leave only the dirty ones.
+  const size_t dirty = DirtyCards(card_table.get(), bitmap.get(), num_cards);
+  for (size_t i = 0; i < num_cards; ++i) {
+    byte* card = card_table->CardFromAddr(kHeapBegin + i * CardTable::kCardSize);
+    if (*card != CardTable::kCardDirty) {
+      *card = CardTable::kCardClean;
+    }
+  }
+
+  // Start and end in the middle of a word so that every part of the range is exercised.
+  const size_t begin_card = 3;
+  const size_t end_card = num_cards - 5;
+  size_t expected = 0;
+  for (size_t i = begin_card; i < end_card; ++i) {
+    expected += card_table->IsDirty(
+        reinterpret_cast<mirror::Object*>(kHeapBegin + i * CardTable::kCardSize)) ? 1 : 0;
+  }
+  std::vector<byte*> modified;
+  card_table->ModifyCardsAtomic(kHeapBegin + begin_card * CardTable::kCardSize,
+                                kHeapBegin + end_card * CardTable::kCardSize, AgeCardVisitor(),
+                                RecordModifiedVisitor(&modified));
+  EXPECT_EQ(expected, modified.size());
+  size_t still_dirty = 0;
+  for (size_t i = 0; i < num_cards; ++i) {
+    still_dirty += card_table->IsDirty(
+        reinterpret_cast<mirror::Object*>(kHeapBegin + i * CardTable::kCardSize)) ? 1 : 0;
+  }
+  EXPECT_EQ(dirty - expected, still_dirty);
+}
+
+// Reports the card scanning throughput over a heap with a few percent of its cards dirty, roughly
+// what a sticky collection sees.
+TEST_F(CardTableTest, ScanBenchmark) {
+  ScopedObjectAccess soa(Thread::Current());
+  WriterMutexLock mu(soa.Self(), *Locks::heap_bitmap_lock_);
+  const size_t heap_capacity = 64 * MB;
+  const size_t num_cards = heap_capacity / CardTable::kCardSize;
+  UniquePtr<CardTable> card_table(CardTable::Create(kHeapBegin, heap_capacity));
+  UniquePtr<SpaceBitmap> bitmap(SpaceBitmap::Create("test bitmap", kHeapBegin, heap_capacity));
+  ASSERT_TRUE(card_table.get() != NULL);
+  ASSERT_TRUE(bitmap.get() != NULL);
+  for (size_t i = 0; i < num_cards; i += 37) {
+    for (size_t j = i; j < std::min(i + (i % 3), num_cards); ++j) {
+      byte* addr = kHeapBegin + j * CardTable::kCardSize;
+      card_table->MarkCard(addr);
+      bitmap->Set(reinterpret_cast<mirror::Object*>(addr));
+    }
+  }
+
+  static const size_t kIterations = 20;
+  size_t visited = 0;
+  size_t scanned = 0;
+  uint64_t start_ns = NanoTime();
+  for (size_t i = 0; i < kIterations; ++i) {
+    scanned += card_table->Scan(bitmap.get(), kHeapBegin, kHeapBegin + heap_capacity,
+                                CountingVisitor(&visited));
+  }
+  uint64_t duration_ns = std::max<uint64_t>(NanoTime() - start_ns, 1);
+  EXPECT_EQ(scanned, visited);
+  LOG(INFO) << "Scanned " << kIterations * num_cards << " cards (" << scanned << " dirty) in "
+            << PrettyDuration(duration_ns) << ", "
+            << (static_cast<uint64_t>(kIterations * num_cards) * 1000000000 / duration_ns)
+            << " cards/s";
+}
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
@@ -25,22 +25,38 @@ namespace art {
 namespace gc {
 namespace accounting {
 
+// Returns true if ref is in the Zygote or alloc space.
+static inline bool IsZygoteOrAllocSpaceReference(Heap* heap, const mirror::Object* ref) {
+  const std::vector<space::ContinuousSpace*>& spaces = heap->GetContinuousSpaces();
+  typedef std::vector<space::ContinuousSpace*>::const_iterator It;
+  for (It it = spaces.begin(); it != spaces.end(); ++it) {
+    if ((*it)->Contains(ref)) {
+      return (*it)->IsContinuousMemMapAllocSpace();
+    }
+  }
+  // Assume it points to a large object.
+  // TODO: Check.
+  return true;
+}
+
 // A mod-union table to record image references to the Zygote and alloc space.
 class ModUnionTableToZygoteAllocspace : public ModUnionTableReferenceCache {
  public:
   explicit ModUnionTableToZygoteAllocspace(Heap* heap) : ModUnionTableReferenceCache(heap) {}
 
   bool AddReference(const mirror::Object* /* obj */, const mirror::Object* ref) {
-    const std::vector<space::ContinuousSpace*>& spaces = GetHeap()->GetContinuousSpaces();
-    typedef std::vector<space::ContinuousSpace*>::const_iterator It;
-    for (It it = spaces.begin(); it != spaces.end(); ++it) {
-      if ((*it)->Contains(ref)) {
-        return (*it)->IsDlMallocSpace();
-      }
-    }
-    // Assume it points to a large object.
-    // TODO: Check.
-    return true;
+    return IsZygoteOrAllocSpaceReference(GetHeap(), ref);
+  }
+};
+
+// Same as ModUnionTableToZygoteAllocspace, with the references kept in flat arrays.
+class ModUnionTableCompactToZygoteAllocspace : public ModUnionTableCompactReferenceCache {
+ public:
+  explicit ModUnionTableCompactToZygoteAllocspace(Heap* heap)
+      : ModUnionTableCompactReferenceCache(heap) {}
+
+  bool AddReference(const mirror::Object* /* obj */, const mirror::Object* ref) {
+    return IsZygoteOrAllocSpaceReference(GetHeap(), ref);
   }
 };
 
@@ -16,6 +16,8 @@
 
 #include "mod_union_table.h"
 
+#include <algorithm>
+
 #include "base/stl_util.h"
 #include "card_table-inl.h"
 #include "heap_bitmap.h"
@@ -36,6 +38,13 @@ namespace art {
 namespace gc {
 namespace accounting {
 
+// Approximate size of the bookkeeping of a std::set or std::map node: the parent and child pointers
+// and the color.
+static const size_t kTreeNodeOverhead = 4 * sizeof(void*);
+
+// Number of cards per word of the cleared card bitmaps of ModUnionTableCompactReferenceCache.
+static const size_t kCardsPerClearedWord = sizeof(uint32_t) * kBitsPerByte;
+
 class ModUnionClearCardSetVisitor {
  public:
   explicit ModUnionClearCardSetVisitor(ModUnionTable::CardSet* const cleared_cards)
@@ -67,6 +76,24 @@ class ModUnionClearCardVisitor {
   std::vector<byte*>* const cleared_cards_;
 };
 
+class ModUnionClearCardBitmapVisitor {
+ public:
+  ModUnionClearCardBitmapVisitor(const byte* first_card, uint32_t* cleared_cards)
+    : first_card_(first_card), cleared_cards_(cleared_cards) {
+  }
+
+  void operator()(byte* card, byte expected_card, byte new_card) const {
+    if (expected_card == CardTable::kCardDirty) {
+      const size_t index = card - first_card_;
+      cleared_cards_[index / kCardsPerClearedWord] |= 1U << (index % kCardsPerClearedWord);
+    }
+  }
+
+ private:
+  const byte* const first_card_;
+  uint32_t* const cleared_cards_;
+};
+
 class ModUnionScanImageRootVisitor {
  public:
   explicit ModUnionScanImageRootVisitor(collector::MarkSweep* const mark_sweep)
@@ -90,9 +117,10 @@ void ModUnionTableReferenceCache::ClearCards(space::ContinuousSpace* space) {
   card_table->ModifyCardsAtomic(space->Begin(), space->End(), AgeCardVisitor(), visitor);
 }
 
+template <typename ModUnionTableType>
 class AddToReferenceArrayVisitor {
  public:
-  explicit AddToReferenceArrayVisitor(ModUnionTableReferenceCache* mod_union_table,
+  explicit AddToReferenceArrayVisitor(ModUnionTableType* mod_union_table,
                                       std::vector<const Object*>* references)
     : mod_union_table_(mod_union_table),
       references_(references) {
@@ -108,13 +136,14 @@ class AddToReferenceArrayVisitor {
   }
 
  private:
-  ModUnionTableReferenceCache* const mod_union_table_;
+  ModUnionTableType* const mod_union_table_;
   std::vector<const Object*>* const references_;
 };
 
+template <typename ModUnionTableType>
 class ModUnionReferenceVisitor {
  public:
-  explicit ModUnionReferenceVisitor(ModUnionTableReferenceCache* const mod_union_table,
+  explicit ModUnionReferenceVisitor(ModUnionTableType* const mod_union_table,
                                     std::vector<const Object*>* references)
     : mod_union_table_(mod_union_table),
       references_(references) {
@@ -125,17 +154,18 @@ class ModUnionReferenceVisitor {
     DCHECK(obj != NULL);
     // We don't have an early exit since we use the visitor pattern, an early
     // exit should significantly speed this up.
-    AddToReferenceArrayVisitor visitor(mod_union_table_, references_);
+    AddToReferenceArrayVisitor<ModUnionTableType> visitor(mod_union_table_, references_);
     collector::MarkSweep::VisitObjectReferences(obj, visitor);
   }
  private:
-  ModUnionTableReferenceCache* const mod_union_table_;
+  ModUnionTableType* const mod_union_table_;
   std::vector<const Object*>* const references_;
 };
 
+template <typename ModUnionTableType>
 class CheckReferenceVisitor {
  public:
-  explicit CheckReferenceVisitor(ModUnionTableReferenceCache* mod_union_table,
+  explicit CheckReferenceVisitor(ModUnionTableType* mod_union_table,
                                  const std::set<const Object*>& references)
     : mod_union_table_(mod_union_table),
       references_(references) {
@@ -162,13 +192,14 @@ class CheckReferenceVisitor {
   }
 
  private:
-  ModUnionTableReferenceCache* const mod_union_table_;
+  ModUnionTableType* const mod_union_table_;
   const std::set<const Object*>& references_;
 };
 
+template <typename ModUnionTableType>
 class ModUnionCheckReferences {
  public:
-  explicit ModUnionCheckReferences(ModUnionTableReferenceCache* mod_union_table,
+  explicit ModUnionCheckReferences(ModUnionTableType* mod_union_table,
                                    const std::set<const Object*>& references)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_)
       : mod_union_table_(mod_union_table), references_(references) {
@@ -177,12 +208,12 @@ class ModUnionCheckReferences {
   void operator()(const Object* obj) const NO_THREAD_SAFETY_ANALYSIS {
     Locks::heap_bitmap_lock_->AssertSharedHeld(Thread::Current());
     DCHECK(obj != NULL);
-    CheckReferenceVisitor visitor(mod_union_table_, references_);
+    CheckReferenceVisitor<ModUnionTableType> visitor(mod_union_table_, references_);
     collector::MarkSweep::VisitObjectReferences(obj, visitor);
   }
 
  private:
-  ModUnionTableReferenceCache* const mod_union_table_;
+  ModUnionTableType* const mod_union_table_;
   const std::set<const Object*>& references_;
 };
 
@@ -201,7 +232,7 @@ void ModUnionTableReferenceCache::Verify() {
     const byte* card = it.first;
     if (*card == CardTable::kCardClean) {
       std::set<const Object*> reference_set(it.second.begin(), it.second.end());
-      ModUnionCheckReferences visitor(this, reference_set);
+      ModUnionCheckReferences<ModUnionTableReferenceCache> visitor(this, reference_set);
       uintptr_t start = reinterpret_cast<uintptr_t>(card_table->AddrFromCard(card));
       uintptr_t end = start + CardTable::kCardSize;
       auto* space = heap->FindContinuousSpaceFromObject(reinterpret_cast<Object*>(start), false);
@@ -238,7 +269,7 @@ void ModUnionTableReferenceCache::Update() {
   CardTable* card_table = heap->GetCardTable();
 
   std::vector<const Object*> cards_references;
-  ModUnionReferenceVisitor visitor(this, &cards_references);
+  ModUnionReferenceVisitor<ModUnionTableReferenceCache> visitor(this, &cards_references);
 
   for (const auto& card : cleared_cards_) {
     // Clear and re-compute alloc space references associated with this card.
@@ -279,6 +310,14 @@ void ModUnionTableReferenceCache::MarkReferences(collector::MarkSweep* mark_swee
   }
 }
 
+size_t ModUnionTableReferenceCache::GetMemoryUsage() const {
+  size_t bytes = cleared_cards_.size() * (kTreeNodeOverhead + sizeof(byte*));
+  for (const std::pair<const byte*, std::vector<const Object*> >& it : references_) {
+    bytes += kTreeNodeOverhead + sizeof(it) + it.second.capacity() * sizeof(const Object*);
+  }
+  return bytes;
+}
+
 void ModUnionTableCardCache::ClearCards(space::ContinuousSpace* space) {
   CardTable* card_table = GetHeap()->GetCardTable();
   ModUnionClearCardSetVisitor visitor(&cleared_cards_);
@@ -317,6 +356,214 @@ void ModUnionTableCardCache::Dump(std::ostream& os) {
   os << "]";
 }
 
+size_t ModUnionTableCardCache::GetMemoryUsage() const {
+  return cleared_cards_.size() * (kTreeNodeOverhead + sizeof(byte*));
+}
+
+ModUnionTableCompactReferenceCache::~ModUnionTableCompactReferenceCache() {
+  STLDeleteElements(&space_cards_);
+}
+
+ModUnionTableCompactReferenceCache::SpaceCards* ModUnionTableCompactReferenceCache::GetSpaceCards(
+    space::ContinuousSpace* space) {
+  SpaceCards* space_cards = NULL;
+  for (SpaceCards* cur : space_cards_) {
+    if (cur->space == space) {
+      space_cards = cur;
+      break;
+    }
+  }
+  if (space_cards == NULL) {
+    space_cards = new SpaceCards(space, GetHeap()->GetCardTable()->CardFromAddr(space->Begin()));
+    space_cards_.push_back(space_cards);
+  }
+  const size_t num_cards = RoundUp(space->Size(), CardTable::kCardSize) / CardTable::kCardSize;
+  if (space_cards->card_slots.size() < num_cards) {
+    space_cards->card_slots.resize(num_cards, 0);
+    space_cards->cleared_cards.resize(RoundUp(num_cards, kCardsPerClearedWord) /
+                                      kCardsPerClearedWord, 0);
+  }
+  return space_cards;
+}
+
+void ModUnionTableCompactReferenceCache::ClearCards(space::ContinuousSpace* space) {
+  CardTable* card_table = GetHeap()->GetCardTable();
+  SpaceCards* space_cards = GetSpaceCards(space);
+  ModUnionClearCardBitmapVisitor visitor(space_cards->first_card, &space_cards->cleared_cards[0]);
+  // Clear dirty cards in the this space and update the corresponding mod-union bits.
+  card_table->ModifyCardsAtomic(space->Begin(), space->End(), AgeCardVisitor(), visitor);
+}
+
+void ModUnionTableCompactReferenceCache::SetCardReferences(
+    SpaceCards* space_cards, uint32_t card, const std::vector<const Object*>& references) {
+  const uint32_t slot_index = space_cards->card_slots[card];
+  if (slot_index != 0) {
+    Slot& slot = space_cards->slots[slot_index - 1];
+    if (references.size() <= slot.capacity) {
+      std::copy(references.begin(), references.end(),
+                space_cards->references.begin() + slot.begin);
+      slot.count = references.size();
+      return;
+    }
+    // The references outgrew the slot, abandon it until the next compaction.
+    slot.card = kNoCard;
+    slot.count = 0;
+    space_cards->unused_references += slot.capacity;
+    space_cards->card_slots[card] = 0;
+  }
+  if (references.empty()) {
+    // No reason to add an empty slot.
+    return;
+  }
+  Slot slot;
+  slot.card = card;
+  slot.begin = space_cards->references.size();
+  slot.count = references.size();
+  slot.capacity = references.size();
+  space_cards->references.insert(space_cards->references.end(), references.begin(),
+                                 references.end());
+  space_cards->slots.push_back(slot);
+  space_cards->card_slots[card] = space_cards->slots.size();
+}
+
+void ModUnionTableCompactReferenceCache::Compact(SpaceCards* space_cards) {
+  size_t num_slots = 0;
+  size_t num_references = 0;
+  for (size_t i = 0; i < space_cards->slots.size(); ++i) {
+    Slot slot = space_cards->slots[i];
+    if (slot.card == kNoCard) {
+      continue;
+    }
+    if (slot.count == 0) {
+      space_cards->card_slots[slot.card] = 0;
+      continue;
+    }
+    // Slots only move towards the start of the buffer, so copying forwards is safe.
+    std::copy(space_cards->references.begin() + slot.begin,
+              space_cards->references.begin() + slot.begin + slot.count,
+              space_cards->references.begin() + num_references);
+    slot.begin = num_references;
+    slot.capacity = slot.count;
+    num_references += slot.count;
+    space_cards->slots[num_slots++] = slot;
+    space_cards->card_slots[slot.card] = num_slots;
+  }
+  space_cards->slots.resize(num_slots);
+  space_cards->references.resize(num_references);
+  space_cards->unused_references = 0;
+}
+
+void ModUnionTableCompactReferenceCache::Update() {
+  CardTable* card_table = GetHeap()->GetCardTable();
+  std::vector<const Object*> card_references;
+  ModUnionReferenceVisitor<ModUnionTableCompactReferenceCache> visitor(this, &card_references);
+  for (SpaceCards* space_cards : space_cards_) {
+    SpaceBitmap* live_bitmap = space_cards->space->GetLiveBitmap();
+    WordVector& cleared_cards = space_cards->cleared_cards;
+    for (size_t i = 0; i < cleared_cards.size(); ++i) {
+      for (uint32_t word = cleared_cards[i]; word != 0; word &= word - 1) {
+        const uint32_t card = i * kCardsPerClearedWord + CTZ(word);
+        // Clear and re-compute alloc space references associated with this card.
+        card_references.clear();
+        uintptr_t start = reinterpret_cast<uintptr_t>(
+            card_table->AddrFromCard(space_cards->first_card + card));
+        live_bitmap->VisitMarkedRange(start, start + CardTable::kCardSize, visitor);
+        SetCardReferences(space_cards, card, card_references);
+      }
+      cleared_cards[i] = 0;
+    }
+    if (space_cards->unused_references * 2 > space_cards->references.size()) {
+      Compact(space_cards);
+    }
+  }
+}
+
+void ModUnionTableCompactReferenceCache::MarkReferences(collector::MarkSweep* mark_sweep) {
+  size_t count = 0;
+  for (SpaceCards* space_cards : space_cards_) {
+    // Abandoned slots are empty, so the buffer is walked in order without looking at the cards.
+    for (const Slot& slot : space_cards->slots) {
+      for (uint32_t i = slot.begin; i < slot.begin + slot.count; ++i) {
+        mark_sweep->MarkRoot(space_cards->references[i]);
+      }
+      count += slot.count;
+    }
+  }
+  if (VLOG_IS_ON(heap)) {
+    VLOG(gc) << "Marked " << count << " references in mod union table";
+  }
+}
+
+void ModUnionTableCompactReferenceCache::Verify() {
+  Heap* heap = GetHeap();
+  CardTable* card_table = heap->GetCardTable();
+  for (SpaceCards* space_cards : space_cards_) {
+    for (const Slot& slot : space_cards->slots) {
+      if (slot.card == kNoCard) {
+        continue;
+      }
+      auto references_begin = space_cards->references.begin() + slot.begin;
+      auto references_end = references_begin + slot.count;
+      // Everything in the mod union table must be marked.
+      for (auto it = references_begin; it != references_end; ++it) {
+        CHECK(heap->IsLiveObjectLocked(*it));
+      }
+      // Check the references of each clean card which is also in the mod union table.
+      const byte* card = space_cards->first_card + slot.card;
+      if (*card == CardTable::kCardClean) {
+        std::set<const Object*> reference_set(references_begin, references_end);
+        ModUnionCheckReferences<ModUnionTableCompactReferenceCache> visitor(this, reference_set);
+        uintptr_t start = reinterpret_cast<uintptr_t>(card_table->AddrFromCard(card));
+        uintptr_t end = start + CardTable::kCardSize;
+        space_cards->space->GetLiveBitmap()->VisitMarkedRange(start, end, visitor);
+      }
+    }
+  }
+}
+
+void ModUnionTableCompactReferenceCache::Dump(std::ostream& os) {
+  CardTable* card_table = heap_->GetCardTable();
+  os << "ModUnionTable cleared cards: [";
+  for (SpaceCards* space_cards : space_cards_) {
+    for (size_t i = 0; i < space_cards->cleared_cards.size(); ++i) {
+      for (uint32_t word = space_cards->cleared_cards[i]; word != 0; word &= word - 1) {
+        const byte* card = space_cards->first_card + i * kCardsPerClearedWord + CTZ(word);
+        uintptr_t start = reinterpret_cast<uintptr_t>(card_table->AddrFromCard(card));
+        uintptr_t end = start + CardTable::kCardSize;
+        os << reinterpret_cast<void*>(start) << "-" << reinterpret_cast<void*>(end) << ",";
+      }
+    }
+  }
+  os << "]\nModUnionTable references: [";
+  for (SpaceCards* space_cards : space_cards_) {
+    for (const Slot& slot : space_cards->slots) {
+      if (slot.card == kNoCard) {
+        continue;
+      }
+      const byte* card = space_cards->first_card + slot.card;
+      uintptr_t start = reinterpret_cast<uintptr_t>(card_table->AddrFromCard(card));
+      uintptr_t end = start + CardTable::kCardSize;
+      os << reinterpret_cast<void*>(start) << "-" << reinterpret_cast<void*>(end) << "->{";
+      for (uint32_t i = slot.begin; i < slot.begin + slot.count; ++i) {
+        os << reinterpret_cast<const void*>(space_cards->references[i]) << ",";
+      }
+      os << "},";
+    }
+  }
+}
+
+size_t ModUnionTableCompactReferenceCache::GetMemoryUsage() const {
+  size_t bytes = 0;
+  for (const SpaceCards* space_cards : space_cards_) {
+    bytes += sizeof(*space_cards) +
+        space_cards->cleared_cards.capacity() * sizeof(uint32_t) +
+        space_cards->card_slots.capacity() * sizeof(uint32_t) +
+        space_cards->slots.capacity() * sizeof(Slot) +
+        space_cards->references.capacity() * sizeof(const Object*);
+  }
+  return bytes;
+}
+
 }  // namespace accounting
 }  // namespace gc
 }  // namespace art
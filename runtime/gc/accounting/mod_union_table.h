@@ -21,6 +21,7 @@
 #include "globals.h"
 #include "safe_map.h"
 
+#include <stdint.h>
 #include <set>
 #include <vector>
 
@@ -76,6 +77,11 @@ class ModUnionTable {
 
   virtual void Dump(std::ostream& os) = 0;
 
+  // Approximate number of bytes used by the table's data structures.
+  virtual size_t GetMemoryUsage() const = 0;
+
+  virtual const char* GetName() const = 0;
+
   Heap* GetHeap() const {
     return heap_;
   }
@@ -112,7 +118,15 @@ class ModUnionTableReferenceCache : public ModUnionTable {
 
   void Dump(std::ostream& os);
 
+  size_t GetMemoryUsage() const;
+
+  const char* GetName() const {
+    return "ReferenceCache";
+  }
+
  protected:
+  friend class ModUnionTableTest;
+
   // Cleared card array, used to update the mod-union table.
   ModUnionTable::CardSet cleared_cards_;
 
@@ -143,11 +157,100 @@ class ModUnionTableCardCache : public ModUnionTable {
 
   void Dump(std::ostream& os);
 
+  size_t GetMemoryUsage() const;
+
+  const char* GetName() const {
+    return "CardCache";
+  }
+
  protected:
   // Cleared card array, used to update the mod-union table.
   CardSet cleared_cards_;
 };
 
+// Reference caching implementation which keeps the same information as ModUnionTableReferenceCache
+// in flat arrays rather than node based containers. Each space has a bitmap of the cleared cards,
+// the references of all its cards packed into one buffer and, per card, the index of the slot of
+// the buffer holding the card's references. Cards whose references outgrow their slot get a new
+// one at the end of the buffer, which is compacted once half of it is unused.
+class ModUnionTableCompactReferenceCache : public ModUnionTable {
+ public:
+  explicit ModUnionTableCompactReferenceCache(Heap* heap) : ModUnionTable(heap) {}
+  virtual ~ModUnionTableCompactReferenceCache();
+
+  // Clear and store cards for a space.
+  void ClearCards(space::ContinuousSpace* space);
+
+  // Update table based on cleared cards.
+  void Update()
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Mark all references to the alloc space(s).
+  void MarkReferences(collector::MarkSweep* mark_sweep)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
+
+  // Exclusive lock is required since verify uses SpaceBitmap::VisitMarkedRange and
+  // VisitMarkedRange can't know if the callback will modify the bitmap or not.
+  void Verify() EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
+
+  // Function that tells whether or not to add a reference to the table.
+  virtual bool AddReference(const mirror::Object* obj, const mirror::Object* ref) = 0;
+
+  void Dump(std::ostream& os);
+
+  size_t GetMemoryUsage() const;
+
+  const char* GetName() const {
+    return "CompactReferenceCache";
+  }
+
+ private:
+  friend class ModUnionTableTest;
+
+  // A range of the reference buffer of a space.
+  struct Slot {
+    // Index of the card the references belong to, kNoCard once the slot has been replaced.
+    uint32_t card;
+    uint32_t begin;
+    uint32_t count;
+    uint32_t capacity;
+  };
+
+  static const uint32_t kNoCard = 0xFFFFFFFF;
+
+  typedef std::vector<uint32_t, GCAllocator<uint32_t> > WordVector;
+
+  struct SpaceCards {
+    SpaceCards(space::ContinuousSpace* space, byte* first_card)
+        : space(space), first_card(first_card), unused_references(0) {}
+
+    space::ContinuousSpace* const space;
+    byte* const first_card;
+    // Bit per card, set when the card was cleared since the last update.
+    WordVector cleared_cards;
+    // Per card index of its slot plus one, 0 for cards without references.
+    WordVector card_slots;
+    std::vector<Slot, GCAllocator<Slot> > slots;
+    std::vector<const mirror::Object*, GCAllocator<const mirror::Object*> > references;
+    // Number of entries of references which belong to replaced slots.
+    size_t unused_references;
+  };
+
+  // Returns the cards of the space, creating them or growing them to cover the whole space.
+  SpaceCards* GetSpaceCards(space::ContinuousSpace* space);
+
+  // Replaces the references of a card.
+  static void SetCardReferences(SpaceCards* space_cards, uint32_t card,
+                                const std::vector<const mirror::Object*>& references);
+
+  // Moves the references of the live slots to the start of the buffer.
+  static void Compact(SpaceCards* space_cards);
+
+  std::vector<SpaceCards*> space_cards_;
+};
+
 }  // namespace accounting
 }  // namespace gc
 }  // namespace art
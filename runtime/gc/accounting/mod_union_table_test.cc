@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mod_union_table.h"
+
+#include <map>
+#include <vector>
+
+#include "card_table-inl.h"
+#include "common_test.h"
+#include "gc/heap.h"
+#include "gc/space/bump_pointer_space-inl.h"
+#include "gc/space/malloc_space.h"
+#include "mirror/object_array-inl.h"
+#include "scoped_thread_state_change.h"
+#include "sirt_ref.h"
+#include "space_bitmap-inl.h"
+#include "UniquePtr.h"
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+// Tables caching the references into a target space of the test.
+class TestReferenceCache : public ModUnionTableReferenceCache {
+ public:
+  TestReferenceCache(Heap* heap, space::ContinuousSpace* target_space)
+      : ModUnionTableReferenceCache(heap), target_space_(target_space) {}
+
+  bool AddReference(const mirror::Object* /* obj */, const mirror::Object* ref) {
+    return target_space_->Contains(ref);
+  }
+
+ private:
+  space::ContinuousSpace* const target_space_;
+};
+
+class TestCompactReferenceCache : public ModUnionTableCompactReferenceCache {
+ public:
+  TestCompactReferenceCache(Heap* heap, space::ContinuousSpace* target_space)
+      : ModUnionTableCompactReferenceCache(heap), target_space_(target_space) {}
+
+  bool AddReference(const mirror::Object* /* obj */, const mirror::Object* ref) {
+    return target_space_->Contains(ref);
+  }
+
+ private:
+  space::ContinuousSpace* const target_space_;
+};
+
+class ModUnionTableTest : public CommonTest {
+ public:
+  typedef std::map<const byte*, std::vector<const mirror::Object*> > CardReferences;
+
+  // Returns the references cached for each card, leaving out the cards without references.
+  static CardReferences GetReferences(const ModUnionTableReferenceCache& table) {
+    CardReferences result;
+    for (const auto& it : table.references_) {
+      if (!it.second.empty()) {
+        result[it.first] = it.second;
+      }
+    }
+    return result;
+  }
+
+  static CardReferences GetReferences(const ModUnionTableCompactReferenceCache& table) {
+    CardReferences result;
+    for (const ModUnionTableCompactReferenceCache::SpaceCards* space_cards : table.space_cards_) {
+      for (const ModUnionTableCompactReferenceCache::Slot& slot : space_cards->slots) {
+        if (slot.card == ModUnionTableCompactReferenceCache::kNoCard || slot.count == 0) {
+          continue;
+        }
+        std::vector<const mirror::Object*>& references =
+            result[space_cards->first_card + slot.card];
+        EXPECT_TRUE(references.empty()) << "card " << slot.card << " has two live slots";
+        references.assign(space_cards->references.begin() + slot.begin,
+                          space_cards->references.begin() + slot.begin + slot.count);
+      }
+    }
+    return result;
+  }
+};
+
+// Number of elements of each source array, the last array spans several cards.
+static const int32_t kArrayLengths[] = { 1, 2, 3, 4, 1, 2, 3, 4, 1, 2, 3, 4, 1, 2, 3, 512 };
+static const size_t kNumArrays = arraysize(kArrayLengths);
+static const size_t kNumTargets = 64;
+// Per round, every kPeriods[round]-th element of the arrays references the target space, none of
+// them for 0. Repeating a period clears the cards without changing their references, a smaller
+// period than the previous round's makes the cards outgrow their slots.
+static const size_t kPeriods[] = { 3, 3, 1, 5, 2, 1, 0 };
+
+TEST_F(ModUnionTableTest, CompactReferenceCacheMatchesReferenceCache) {
+  ScopedObjectAccess soa(Thread::Current());
+  Heap* heap = Runtime::Current()->GetHeap();
+  CardTable* card_table = heap->GetCardTable();
+  space::MallocSpace* alloc_space = heap->GetAllocSpace();
+  // A target space of its own, so that no other object in the heap references it.
+  UniquePtr<space::BumpPointerSpace> target_space(
+      space::BumpPointerSpace::Create("mod union table target space", MB, NULL));
+  ASSERT_TRUE(target_space.get() != NULL);
+
+  mirror::Class* object_class = class_linker_->FindSystemClass("Ljava/lang/Object;");
+  ASSERT_TRUE(object_class != NULL);
+  std::vector<mirror::Object*> targets;
+  for (size_t i = 0; i < kNumTargets; ++i) {
+    mirror::Object* target = target_space->AllocNonvirtual(object_class->GetObjectSize());
+    ASSERT_TRUE(target != NULL);
+    target->SetClass(object_class);
+    targets.push_back(target);
+  }
+
+  // The source arrays are kept alive by the holder, which only references the alloc space.
+  mirror::Class* c = class_linker_->FindSystemClass("[Ljava/lang/Object;");
+  ASSERT_TRUE(c != NULL);
+  SirtRef<mirror::ObjectArray<mirror::Object> > holder(soa.Self(),
+      mirror::ObjectArray<mirror::Object>::Alloc(soa.Self(), c, kNumArrays));
+  ASSERT_TRUE(holder.get() != NULL);
+  for (size_t i = 0; i < kNumArrays; ++i) {
+    mirror::ObjectArray<mirror::Object>* array =
+        mirror::ObjectArray<mirror::Object>::Alloc(soa.Self(), c, kArrayLengths[i]);
+    ASSERT_TRUE(array != NULL);
+    ASSERT_TRUE(alloc_space->Contains(array));
+    holder->Set(i, array);
+  }
+  ASSERT_TRUE(alloc_space->Contains(holder.get()));
+
+  TestReferenceCache reference_cache(heap, target_space.get());
+  TestCompactReferenceCache compact_cache(heap, target_space.get());
+  WriterMutexLock mu(soa.Self(), *Locks::heap_bitmap_lock_);
+  // The tables only visit live objects, there was no GC to mark the arrays since their
+  // allocation.
+  SpaceBitmap* live_bitmap = alloc_space->GetLiveBitmap();
+  live_bitmap->Set(holder.get());
+  for (size_t i = 0; i < kNumArrays; ++i) {
+    live_bitmap->Set(holder->Get(i));
+  }
+
+  for (size_t round = 0; round < arraysize(kPeriods); ++round) {
+    const size_t period = kPeriods[round];
+    size_t num_references = 0;
+    for (size_t i = 0; i < kNumArrays; ++i) {
+      mirror::ObjectArray<mirror::Object>* array = holder->Get(i)->AsObjectArray<mirror::Object>();
+      for (int32_t j = 0; j < array->GetLength(); ++j) {
+        if (period != 0 && (i + j) % period == 0) {
+          array->Set(j, targets[(i * 7 + j + round) % kNumTargets]);
+          ++num_references;
+        } else {
+          // References outside of the target space are not cached.
+          array->Set(j, j % 3 == 0 ? holder.get() : NULL);
+        }
+      }
+    }
+
+    // Clearing ages the dirty cards, so they are dirtied again for the second table. Storing null
+    // doesn't dirty the cards, the cards of the arrays are dirtied whether or not they changed.
+    card_table->MarkCard(holder.get());
+    for (size_t i = 0; i < kNumArrays; ++i) {
+      card_table->MarkCard(holder->Get(i));
+    }
+    reference_cache.ClearCards(alloc_space);
+    card_table->MarkCard(holder.get());
+    for (size_t i = 0; i < kNumArrays; ++i) {
+      card_table->MarkCard(holder->Get(i));
+    }
+    compact_cache.ClearCards(alloc_space);
+    reference_cache.Update();
+    compact_cache.Update();
+
+    CardReferences references = GetReferences(reference_cache);
+    EXPECT_EQ(references, GetReferences(compact_cache)) << "round " << round;
+    size_t num_cached_references = 0;
+    for (const auto& it : references) {
+      num_cached_references += it.second.size();
+    }
+    EXPECT_EQ(num_references, num_cached_references) << "round " << round;
+  }
+}
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
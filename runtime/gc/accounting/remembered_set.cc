@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "remembered_set.h"
+
+#include <vector>
+
+#include "card_table-inl.h"
+#include "gc/collector/mark_sweep-inl.h"
+#include "gc/heap.h"
+#include "gc/space/space.h"
+#include "mirror/class-inl.h"
+#include "mirror/object-inl.h"
+#include "space_bitmap-inl.h"
+#include "utils.h"
+
+using ::art::mirror::Object;
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+void RememberedSet::RecordDirtyCards() {
+  CardTable* card_table = GetHeap()->GetCardTable();
+  // Aged cards were dirty when the last GC processed the cards, they have not been seen by the
+  // remembered set if they were dirtied while it was recording.
+  const byte kMinimumAge = CardTable::kCardDirty - 1;
+  byte* card_cur = card_table->CardFromAddr(space_->Begin());
+  byte* const card_end = card_table->CardFromAddr(reinterpret_cast<byte*>(
+      RoundUp(reinterpret_cast<uintptr_t>(space_->End()), CardTable::kCardSize)));
+  while (card_cur < card_end) {
+    // Skip whole words of clean cards.
+    if (IsAligned<sizeof(uintptr_t)>(card_cur) && card_cur + sizeof(uintptr_t) <= card_end &&
+        *reinterpret_cast<uintptr_t*>(card_cur) == 0) {
+      card_cur += sizeof(uintptr_t);
+      continue;
+    }
+    if (*card_cur >= kMinimumAge) {
+      dirty_cards_.insert(card_cur);
+    }
+    ++card_cur;
+  }
+}
+
+class RememberedSetReferenceVisitor {
+ public:
+  RememberedSetReferenceVisitor(CardTable* card_table, RootVisitor* visitor, void* arg,
+                                space::ContinuousSpace* target_space,
+                                bool* const contains_reference_to_target_space)
+      : card_table_(card_table), visitor_(visitor), arg_(arg), target_space_(target_space),
+        contains_reference_to_target_space_(contains_reference_to_target_space) {}
+
+  void operator()(const Object* obj, const Object* ref, const MemberOffset& offset,
+                  bool /* is_static */) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (ref == NULL || !target_space_->Contains(ref)) {
+      return;
+    }
+    Object* new_ref = visitor_(const_cast<Object*>(ref), arg_);
+    if (new_ref != ref) {
+      const_cast<Object*>(obj)->SetField32(offset, reinterpret_cast<uint32_t>(new_ref), false,
+                                           false);
+      // Have the mod-union tables recompute the references they cached for the card.
+      card_table_->MarkCard(obj);
+    }
+    if (target_space_->Contains(new_ref)) {
+      *contains_reference_to_target_space_ = true;
+    }
+  }
+
+ private:
+  CardTable* const card_table_;
+  RootVisitor* const visitor_;
+  void* const arg_;
+  space::ContinuousSpace* const target_space_;
+  bool* const contains_reference_to_target_space_;
+};
+
+class RememberedSetObjectVisitor {
+ public:
+  RememberedSetObjectVisitor(Heap* heap, RootVisitor* visitor, void* arg,
+                             space::ContinuousSpace* target_space,
+                             bool* const contains_reference_to_target_space)
+      : heap_(heap), visitor_(visitor), arg_(arg), target_space_(target_space),
+        contains_reference_to_target_space_(contains_reference_to_target_space) {}
+
+  void operator()(const Object* obj) const
+      SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_) {
+    DCHECK(obj != NULL);
+    RememberedSetReferenceVisitor ref_visitor(heap_->GetCardTable(), visitor_, arg_,
+                                              target_space_, contains_reference_to_target_space_);
+    collector::MarkSweep::VisitObjectReferences(obj, ref_visitor);
+    // The referent isn't among the reference offsets, it needs updating all the same.
+    if (UNLIKELY(obj->GetClass()->IsReferenceClass())) {
+      Object* reference = const_cast<Object*>(obj);
+      ref_visitor(obj, heap_->GetReferenceReferent(reference), heap_->GetReferenceReferentOffset(),
+                  false);
+    }
+  }
+
+ private:
+  Heap* const heap_;
+  RootVisitor* const visitor_;
+  void* const arg_;
+  space::ContinuousSpace* const target_space_;
+  bool* const contains_reference_to_target_space_;
+};
+
+void RememberedSet::UpdateAndMarkReferences(RootVisitor* visitor, void* arg,
+                                            space::ContinuousSpace* target_space) {
+  CardTable* card_table = GetHeap()->GetCardTable();
+  SpaceBitmap* live_bitmap = space_->GetLiveBitmap();
+  std::vector<byte*> remove_card_set;
+  for (byte* const card_addr : dirty_cards_) {
+    bool contains_reference_to_target_space = false;
+    RememberedSetObjectVisitor obj_visitor(GetHeap(), visitor, arg, target_space,
+                                           &contains_reference_to_target_space);
+    uintptr_t start = reinterpret_cast<uintptr_t>(card_table->AddrFromCard(card_addr));
+    live_bitmap->VisitMarkedRange(start, start + CardTable::kCardSize, obj_visitor);
+    if (!contains_reference_to_target_space) {
+      remove_card_set.push_back(card_addr);
+    }
+  }
+  for (byte* const card_addr : remove_card_set) {
+    dirty_cards_.erase(card_addr);
+  }
+}
+
+void RememberedSet::Dump(std::ostream& os) {
+  CardTable* card_table = GetHeap()->GetCardTable();
+  os << "RememberedSet " << name_ << " dirty cards: [";
+  for (const byte* card_addr : dirty_cards_) {
+    uintptr_t start = reinterpret_cast<uintptr_t>(card_table->AddrFromCard(card_addr));
+    uintptr_t end = start + CardTable::kCardSize;
+    os << reinterpret_cast<void*>(start) << "-" << reinterpret_cast<void*>(end) << ",";
+  }
+  os << "]";
+}
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
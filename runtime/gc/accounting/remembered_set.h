@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_ACCOUNTING_REMEMBERED_SET_H_
+#define ART_RUNTIME_GC_ACCOUNTING_REMEMBERED_SET_H_
+
+#include <iosfwd>
+#include <set>
+#include <string>
+
+#include "gc_allocator.h"
+#include "globals.h"
+#include "locks.h"
+#include "root_visitor.h"
+
+namespace art {
+namespace gc {
+
+namespace space {
+  class ContinuousSpace;
+}  // namespace space
+
+class Heap;
+
+namespace accounting {
+
+// The remembered set of a space holding old objects is the set of its cards which may hold
+// references into the nursery. It lets a minor collection find the old-to-young references
+// without scanning the space. The cards are only recorded, never cleared, since the mark sweep
+// collectors and the mod-union tables rely upon the card table too.
+class RememberedSet {
+ public:
+  typedef std::set<byte*, std::less<byte*>, GCAllocator<byte*> > CardSet;
+
+  RememberedSet(const std::string& name, Heap* heap, space::ContinuousSpace* space)
+      : name_(name), heap_(heap), space_(space) {}
+
+  // Adds the dirty and aged cards of the space to the set. Must be called before the cards are
+  // aged, after which a second aging would clear them.
+  void RecordDirtyCards();
+
+  // Calls the visitor on the references into target_space held by the live objects on the
+  // recorded cards, and replaces them with the address the visitor returns. Cards which are left
+  // without references into target_space are removed from the set.
+  void UpdateAndMarkReferences(RootVisitor* visitor, void* arg,
+                               space::ContinuousSpace* target_space)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  void Dump(std::ostream& os);
+
+  space::ContinuousSpace* GetSpace() {
+    return space_;
+  }
+
+  Heap* GetHeap() const {
+    return heap_;
+  }
+
+  const std::string& GetName() const {
+    return name_;
+  }
+
+ private:
+  const std::string name_;
+  Heap* const heap_;
+  space::ContinuousSpace* const space_;
+
+  CardSet dirty_cards_;
+};
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_ACCOUNTING_REMEMBERED_SET_H_
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "remembered_set.h"
+
+#include <sstream>
+#include <vector>
+
+#include "card_table-inl.h"
+#include "common_test.h"
+#include "gc/heap.h"
+#include "gc/space/bump_pointer_space-inl.h"
+#include "gc/space/malloc_space.h"
+#include "mirror/object_array-inl.h"
+#include "scoped_thread_state_change.h"
+#include "sirt_ref.h"
+#include "space_bitmap-inl.h"
+#include "UniquePtr.h"
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+class RememberedSetTest : public CommonTest {
+ public:
+  // Records the references it is called on and forwards from_ to to_.
+  static mirror::Object* ForwardingVisitor(mirror::Object* root, void* arg) {
+    RememberedSetTest* test = reinterpret_cast<RememberedSetTest*>(arg);
+    test->visited_.push_back(root);
+    return root == test->from_ ? test->to_ : root;
+  }
+
+  // Returns whether the dump of the remembered set lists the card of obj.
+  static bool HasCard(RememberedSet* remembered_set, const mirror::Object* obj) {
+    CardTable* card_table = remembered_set->GetHeap()->GetCardTable();
+    std::ostringstream card;
+    card << reinterpret_cast<void*>(card_table->AddrFromCard(card_table->CardFromAddr(obj)))
+         << "-";
+    std::ostringstream dump;
+    remembered_set->Dump(dump);
+    return dump.str().find(card.str()) != std::string::npos;
+  }
+
+ protected:
+  mirror::Object* from_;
+  mirror::Object* to_;
+  std::vector<mirror::Object*> visited_;
+};
+
+TEST_F(RememberedSetTest, UpdatesAndDropsCards) {
+  ScopedObjectAccess soa(Thread::Current());
+  Heap* heap = Runtime::Current()->GetHeap();
+  space::MallocSpace* alloc_space = heap->GetAllocSpace();
+  // A target space of its own, so that no other object in the heap references it.
+  UniquePtr<space::BumpPointerSpace> target_space(
+      space::BumpPointerSpace::Create("remembered set target space", MB, NULL));
+  ASSERT_TRUE(target_space.get() != NULL);
+
+  mirror::Class* object_class = class_linker_->FindSystemClass("Ljava/lang/Object;");
+  ASSERT_TRUE(object_class != NULL);
+  from_ = target_space->AllocNonvirtual(object_class->GetObjectSize());
+  to_ = target_space->AllocNonvirtual(object_class->GetObjectSize());
+  ASSERT_TRUE(from_ != NULL);
+  ASSERT_TRUE(to_ != NULL);
+  from_->SetClass(object_class);
+  to_->SetClass(object_class);
+
+  mirror::Class* c = class_linker_->FindSystemClass("[Ljava/lang/Object;");
+  SirtRef<mirror::ObjectArray<mirror::Object> > array(soa.Self(),
+      mirror::ObjectArray<mirror::Object>::Alloc(soa.Self(), c, 1));
+  ASSERT_TRUE(array.get() != NULL);
+  ASSERT_TRUE(alloc_space->Contains(array.get()));
+  array->Set(0, from_);
+
+  RememberedSet remembered_set("test remembered set", heap, alloc_space);
+  WriterMutexLock mu(soa.Self(), *Locks::heap_bitmap_lock_);
+  // The remembered set only visits live objects, there was no GC to mark the array since its
+  // allocation.
+  alloc_space->GetLiveBitmap()->Set(array.get());
+  remembered_set.RecordDirtyCards();
+  EXPECT_TRUE(HasCard(&remembered_set, array.get()));
+
+  // The reference is handed to the visitor and replaced, the card stays since it still references
+  // the target space.
+  remembered_set.UpdateAndMarkReferences(ForwardingVisitor, static_cast<RememberedSetTest*>(this),
+                                         target_space.get());
+  ASSERT_EQ(1U, visited_.size());
+  EXPECT_EQ(from_, visited_[0]);
+  EXPECT_EQ(to_, array->Get(0));
+  EXPECT_TRUE(heap->GetCardTable()->IsDirty(array.get()));
+  EXPECT_TRUE(HasCard(&remembered_set, array.get()));
+
+  // Once the reference is gone the card is dropped.
+  array->Set(0, NULL);
+  visited_.clear();
+  remembered_set.RecordDirtyCards();
+  remembered_set.UpdateAndMarkReferences(ForwardingVisitor, static_cast<RememberedSetTest*>(this),
+                                         target_space.get());
+  EXPECT_TRUE(visited_.empty());
+  EXPECT_FALSE(HasCard(&remembered_set, array.get()));
+}
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_ACCOUNTING_WORK_STEALING_DEQUE_H_
+#define ART_RUNTIME_GC_ACCOUNTING_WORK_STEALING_DEQUE_H_
+
+#include "atomic_integer.h"
+#include "base/logging.h"
+#include "base/macros.h"
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+// A bounded Chase-Lev work stealing deque. The owning thread pushes and pops at the bottom
+// without atomic operations except when it races for the last element, while any number of
+// other threads steal from the top with a CAS. Since the deque never grows, PushBottom fails
+// when it is full and the owner has to keep the element somewhere else.
+template <typename T, size_t kCapacity>
+class WorkStealingDeque {
+ public:
+  WorkStealingDeque() : top_(0), bottom_(0) {
+    COMPILE_ASSERT((kCapacity & (kCapacity - 1)) == 0, capacity_must_be_a_power_of_two);
+  }
+
+  // Only called by the owner. Returns false if the deque is full.
+  bool PushBottom(const T& value) {
+    const int32_t bottom = bottom_;
+    // A stale top only makes the deque look fuller than it is.
+    if (UNLIKELY(static_cast<size_t>(bottom - top_.load()) >= kCapacity)) {
+      return false;
+    }
+    elements_[bottom & kMask] = value;
+    // Publish the element before the new bottom which lets thieves see it.
+    ANDROID_MEMBAR_STORE();
+    bottom_ = bottom + 1;
+    return true;
+  }
+
+  // Only called by the owner. Returns false if the deque is empty or a thief took the last
+  // element.
+  bool PopBottom(T* value) {
+    const int32_t bottom = bottom_ - 1;
+    bottom_ = bottom;
+    // The new bottom has to be visible to thieves before we read top, otherwise a thief and the
+    // owner could both take the last element.
+    ANDROID_MEMBAR_FULL();
+    const int32_t top = top_.load();
+    if (UNLIKELY(top > bottom)) {
+      // Empty.
+      bottom_ = top;
+      return false;
+    }
+    *value = elements_[bottom & kMask];
+    if (LIKELY(top != bottom)) {
+      return true;
+    }
+    // Last element, race the thieves for it.
+    const bool won = top_.compare_and_swap(top, top + 1);
+    bottom_ = top + 1;
+    return won;
+  }
+
+  // Called by any thread other than the owner. Returns false if the deque is empty or another
+  // thread took the top element first.
+  bool Steal(T* value) {
+    const int32_t top = top_.load();
+    ANDROID_MEMBAR_FULL();
+    const int32_t bottom = bottom_;
+    if (top >= bottom) {
+      return false;
+    }
+    // Read the element before claiming it, once top moves past it the owner may overwrite it.
+    T element = elements_[top & kMask];
+    if (!top_.compare_and_swap(top, top + 1)) {
+      return false;
+    }
+    *value = element;
+    return true;
+  }
+
+  // Racy when called by a thread other than the owner.
+  size_t Size() const {
+    const int32_t size = bottom_ - top_.load();
+    return size > 0 ? static_cast<size_t>(size) : 0;
+  }
+
+  bool IsEmpty() const {
+    return Size() == 0;
+  }
+
+  static size_t Capacity() {
+    return kCapacity;
+  }
+
+ private:
+  static const int32_t kMask = kCapacity - 1;
+
+  // Index of the oldest element, only advanced by CAS.
+  AtomicInteger top_;
+  // Index one past the newest element, only written by the owner.
+  volatile int32_t bottom_;
+
+  T elements_[kCapacity];
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingDeque);
+};
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_ACCOUNTING_WORK_STEALING_DEQUE_H_
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "work_stealing_deque.h"
+
+#include <vector>
+
+#include "atomic_integer.h"
+#include "common_test.h"
+#include "thread_pool.h"
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+class WorkStealingDequeTest : public CommonTest {
+ public:
+  static const size_t kCapacity = 64;
+  typedef WorkStealingDeque<size_t, kCapacity> Deque;
+};
+
+const size_t WorkStealingDequeTest::kCapacity;
+
+TEST_F(WorkStealingDequeTest, PushPopSteal) {
+  Deque deque;
+  size_t value;
+  EXPECT_TRUE(deque.IsEmpty());
+  EXPECT_FALSE(deque.PopBottom(&value));
+  EXPECT_FALSE(deque.Steal(&value));
+  for (size_t i = 0; i < kCapacity; ++i) {
+    EXPECT_TRUE(deque.PushBottom(i));
+  }
+  // Full.
+  EXPECT_FALSE(deque.PushBottom(kCapacity));
+  EXPECT_EQ(kCapacity, deque.Size());
+  // The owner pops the newest elements, thieves take the oldest.
+  EXPECT_TRUE(deque.PopBottom(&value));
+  EXPECT_EQ(kCapacity - 1, value);
+  EXPECT_TRUE(deque.Steal(&value));
+  EXPECT_EQ(0U, value);
+  // Room for one more element at the bottom, wrapping around the slot which was stolen.
+  EXPECT_TRUE(deque.PushBottom(kCapacity));
+  EXPECT_TRUE(deque.PushBottom(kCapacity + 1));
+  EXPECT_FALSE(deque.PushBottom(kCapacity + 2));
+  for (size_t i = kCapacity + 1; i > 0; --i) {
+    EXPECT_TRUE(deque.PopBottom(&value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_TRUE(deque.IsEmpty());
+  EXPECT_FALSE(deque.PopBottom(&value));
+}
+
+class StealTask : public Task {
+ public:
+  StealTask(WorkStealingDequeTest::Deque* deque, AtomicInteger* done, AtomicInteger* sum)
+      : deque_(deque), done_(done), sum_(sum) {}
+
+  void Run(Thread* self) {
+    size_t value;
+    while (done_->load() == 0 || !deque_->IsEmpty()) {
+      if (deque_->Steal(&value)) {
+        sum_->fetch_add(value);
+      }
+    }
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  WorkStealingDequeTest::Deque* const deque_;
+  AtomicInteger* const done_;
+  AtomicInteger* const sum_;
+};
+
+// Check that every element is taken exactly once when thieves race with the owner.
+TEST_F(WorkStealingDequeTest, ConcurrentSteal) {
+  Thread* self = Thread::Current();
+  static const size_t kThreads = 4;
+  static const size_t kElements = 10000;
+  ThreadPool thread_pool(kThreads);
+  Deque deque;
+  AtomicInteger done(0);
+  AtomicInteger sum(0);
+  for (size_t i = 0; i < kThreads; ++i) {
+    thread_pool.AddTask(self, new StealTask(&deque, &done, &sum));
+  }
+  thread_pool.StartWorkers(self);
+  size_t owner_sum = 0;
+  size_t value;
+  for (size_t i = 1; i <= kElements; ++i) {
+    while (!deque.PushBottom(i)) {
+      if (deque.PopBottom(&value)) {
+        owner_sum += value;
+      }
+    }
+    // Pop every other element ourselves so that we race the thieves for the last element.
+    if ((i % 2) == 0 && deque.PopBottom(&value)) {
+      owner_sum += value;
+    }
+  }
+  while (deque.PopBottom(&value)) {
+    owner_sum += value;
+  }
+  done.store(1);
+  thread_pool.Wait(self, false, false);
+  EXPECT_EQ(kElements * (kElements + 1) / 2, owner_sum + static_cast<size_t>(sum.load()));
+}
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
@@ -0,0 +1,680 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rosalloc.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+
+#include "base/stringprintf.h"
+#include "thread.h"
+#include "utils.h"
+
+namespace art {
+namespace gc {
+namespace allocator {
+
+// Callback from RosAlloc when it needs to change the footprint, implemented by the space that
+// owns the allocator.
+extern "C" void* art_heap_rosalloc_morecore(RosAlloc* rosalloc, intptr_t increment);
+
+// Minimum number of bytes the footprint grows by at a time.
+static constexpr size_t kMinFootprintIncrement = 256 * KB;
+
+size_t RosAlloc::bracketSizes[kNumOfSizeBrackets];
+size_t RosAlloc::numOfPages[kNumOfSizeBrackets];
+size_t RosAlloc::numOfSlots[kNumOfSizeBrackets];
+size_t RosAlloc::headerSizes[kNumOfSizeBrackets];
+size_t RosAlloc::threadLocalFreeBitMapOffsets[kNumOfSizeBrackets];
+bool RosAlloc::initialized_ = false;
+
+RosAlloc::RosAlloc(void* base, size_t capacity, size_t max_capacity)
+    : base_(reinterpret_cast<byte*>(base)), footprint_(capacity), capacity_(capacity),
+      capacity_max_(max_capacity),
+      lock_("rosalloc global lock", kRosAllocGlobalLock) {
+  DCHECK(IsAligned<kPageSize>(base_));
+  DCHECK_EQ(RoundUp(capacity, kPageSize), capacity);
+  DCHECK_EQ(RoundUp(max_capacity, kPageSize), max_capacity);
+  CHECK_LE(capacity, max_capacity);
+  COMPILE_ASSERT(kNumThreadLocalSizeBrackets == Thread::kRosAllocNumThreadLocalSizeBrackets,
+                 thread_rosalloc_runs_must_cover_thread_local_brackets);
+  if (!initialized_) {
+    Initialize();
+  }
+  for (size_t i = 0; i < kNumOfSizeBrackets; ++i) {
+    current_runs_[i] = NULL;
+    size_bracket_lock_names_[i] = StringPrintf("rosalloc bracket lock %zu", i);
+    size_bracket_locks_[i] = new Mutex(size_bracket_lock_names_[i].c_str(), kRosAllocBracketLock);
+  }
+  const size_t num_of_pages = max_capacity / kPageSize;
+  page_map_.resize(num_of_pages, kPageMapEmpty);
+  free_page_run_size_map_.resize(num_of_pages, 0);
+  // The whole initial footprint is one free page run.
+  if (capacity > 0) {
+    FreePageRun* free_pages = reinterpret_cast<FreePageRun*>(base_);
+    free_pages->SetByteSize(this, capacity);
+    free_page_runs_.insert(free_pages);
+  }
+}
+
+RosAlloc::~RosAlloc() {
+  for (size_t i = 0; i < kNumOfSizeBrackets; ++i) {
+    delete size_bracket_locks_[i];
+  }
+}
+
+void RosAlloc::Initialize() {
+  // Compute the size brackets and the number of pages of a run of each bracket.
+  for (size_t i = 0; i < kNumOfSizeBrackets; ++i) {
+    if (i < kNumOfQuantumSizeBrackets) {
+      bracketSizes[i] = kBracketQuantumSize * (i + 1);
+    } else if (i == kNumOfSizeBrackets - 2) {
+      bracketSizes[i] = 1 * KB;
+    } else {
+      bracketSizes[i] = 2 * KB;
+    }
+    if (i < 4) {
+      numOfPages[i] = 1;
+    } else if (i < 8) {
+      numOfPages[i] = 2;
+    } else if (i < 16) {
+      numOfPages[i] = 4;
+    } else if (i < 32) {
+      numOfPages[i] = 8;
+    } else if (i == kNumOfSizeBrackets - 2) {
+      numOfPages[i] = 16;
+    } else {
+      numOfPages[i] = 32;
+    }
+  }
+  // Compute the number of slots and the header layout. The header is the fixed part followed by
+  // the two bitmaps, and the slots are 8-byte aligned after it.
+  const size_t fixed_header_size = RoundUp(sizeof(Run), sizeof(uint32_t));
+  for (size_t i = 0; i < kNumOfSizeBrackets; ++i) {
+    const size_t run_size = kPageSize * numOfPages[i];
+    const size_t bracket_size = bracketSizes[i];
+    size_t num_of_slots = (run_size - fixed_header_size) / bracket_size;
+    size_t header_size;
+    while (true) {
+      const size_t bit_map_size = RoundUp(num_of_slots, 32) / 8;
+      header_size = RoundUp(fixed_header_size + 2 * bit_map_size, kObjectAlignment);
+      if (header_size + num_of_slots * bracket_size <= run_size) {
+        break;
+      }
+      --num_of_slots;
+    }
+    const size_t bit_map_size = RoundUp(num_of_slots, 32) / 8;
+    numOfSlots[i] = num_of_slots;
+    headerSizes[i] = header_size;
+    threadLocalFreeBitMapOffsets[i] = fixed_header_size + bit_map_size;
+  }
+  initialized_ = true;
+}
+
+void* RosAlloc::Alloc(Thread* self, size_t size, size_t* bytes_allocated) {
+  if (UNLIKELY(size > kLargeSizeThreshold)) {
+    return AllocLargeObject(self, size, bytes_allocated);
+  }
+  return AllocFromRun(self, size, bytes_allocated);
+}
+
+void* RosAlloc::AllocPages(Thread* self, size_t num_pages, byte page_map_type) {
+  const size_t req_byte_size = num_pages * kPageSize;
+  FreePageRun* res = NULL;
+  // First fit, which favors lower addresses.
+  for (auto it = free_page_runs_.begin(); it != free_page_runs_.end(); ++it) {
+    FreePageRun* fpr = *it;
+    const size_t fpr_byte_size = fpr->ByteSize(this);
+    if (req_byte_size <= fpr_byte_size) {
+      free_page_runs_.erase(it);
+      if (req_byte_size < fpr_byte_size) {
+        // Split off the remainder.
+        FreePageRun* remainder = reinterpret_cast<FreePageRun*>(
+            reinterpret_cast<byte*>(fpr) + req_byte_size);
+        remainder->SetByteSize(this, fpr_byte_size - req_byte_size);
+        free_page_runs_.insert(remainder);
+      }
+      fpr->SetByteSize(this, 0);
+      res = fpr;
+      break;
+    }
+  }
+
+  // Failing that, grow the footprint.
+  if (res == NULL && capacity_ > footprint_) {
+    FreePageRun* last_free_page_run = NULL;
+    size_t last_free_page_run_size = 0;
+    if (!free_page_runs_.empty()) {
+      FreePageRun* last = *free_page_runs_.rbegin();
+      if (last->End(this) == base_ + footprint_) {
+        last_free_page_run = last;
+        last_free_page_run_size = last->ByteSize(this);
+      }
+    }
+    DCHECK_LT(last_free_page_run_size, req_byte_size);
+    if (footprint_ + req_byte_size - last_free_page_run_size <= capacity_) {
+      const size_t increment = std::min(
+          std::max(kMinFootprintIncrement, req_byte_size - last_free_page_run_size),
+          capacity_ - footprint_);
+      art_heap_rosalloc_morecore(this, increment);
+      if (last_free_page_run != NULL) {
+        free_page_runs_.erase(last_free_page_run);
+      } else {
+        last_free_page_run = reinterpret_cast<FreePageRun*>(base_ + footprint_);
+      }
+      footprint_ += increment;
+      const size_t fpr_byte_size = last_free_page_run_size + increment;
+      if (req_byte_size < fpr_byte_size) {
+        FreePageRun* remainder = reinterpret_cast<FreePageRun*>(
+            reinterpret_cast<byte*>(last_free_page_run) + req_byte_size);
+        remainder->SetByteSize(this, fpr_byte_size - req_byte_size);
+        free_page_runs_.insert(remainder);
+      }
+      last_free_page_run->SetByteSize(this, 0);
+      res = last_free_page_run;
+    }
+  }
+
+  if (res == NULL) {
+    return NULL;
+  }
+  const size_t page_map_idx = ToPageMapIndex(res);
+  const byte part_type =
+      page_map_type == kPageMapRun ? kPageMapRunPart : kPageMapLargeObjectPart;
+  DCHECK(page_map_type == kPageMapRun || page_map_type == kPageMapLargeObject);
+  page_map_[page_map_idx] = page_map_type;
+  for (size_t i = 1; i < num_pages; ++i) {
+    DCHECK_EQ(page_map_[page_map_idx + i], kPageMapEmpty);
+    page_map_[page_map_idx + i] = part_type;
+  }
+  return res;
+}
+
+size_t RosAlloc::FreePages(Thread* self, void* ptr) {
+  const size_t pm_idx = ToPageMapIndex(ptr);
+  const byte pm_type = page_map_[pm_idx];
+  byte pm_part_type;
+  if (pm_type == kPageMapRun) {
+    pm_part_type = kPageMapRunPart;
+  } else if (pm_type == kPageMapLargeObject) {
+    pm_part_type = kPageMapLargeObjectPart;
+  } else {
+    LOG(FATAL) << "Unexpected page map type " << static_cast<int>(pm_type) << " for " << ptr;
+    return 0;
+  }
+  size_t num_pages = 1;
+  page_map_[pm_idx] = kPageMapEmpty;
+  const size_t end = footprint_ / kPageSize;
+  for (size_t idx = pm_idx + 1; idx < end && page_map_[idx] == pm_part_type; ++idx) {
+    page_map_[idx] = kPageMapEmpty;
+    ++num_pages;
+  }
+  const size_t byte_size = num_pages * kPageSize;
+
+  // Coalesce with the neighboring free page runs.
+  FreePageRun* fpr = reinterpret_cast<FreePageRun*>(ptr);
+  fpr->SetByteSize(this, byte_size);
+  auto higher_it = free_page_runs_.upper_bound(fpr);
+  if (higher_it != free_page_runs_.end() && *higher_it == fpr->End(this)) {
+    FreePageRun* higher = *higher_it;
+    fpr->SetByteSize(this, fpr->ByteSize(this) + higher->ByteSize(this));
+    higher->SetByteSize(this, 0);
+    free_page_runs_.erase(higher_it);
+  }
+  auto lower_it = free_page_runs_.lower_bound(fpr);
+  if (lower_it != free_page_runs_.begin()) {
+    --lower_it;
+    FreePageRun* lower = *lower_it;
+    if (lower->End(this) == fpr) {
+      lower->SetByteSize(this, lower->ByteSize(this) + fpr->ByteSize(this));
+      fpr->SetByteSize(this, 0);
+      free_page_runs_.erase(lower_it);
+      fpr = lower;
+    }
+  }
+  free_page_runs_.insert(fpr);
+  return byte_size;
+}
+
+void* RosAlloc::AllocLargeObject(Thread* self, size_t size, size_t* bytes_allocated) {
+  const size_t num_pages = RoundUp(size, kPageSize) / kPageSize;
+  void* r;
+  {
+    MutexLock mu(self, lock_);
+    r = AllocPages(self, num_pages, kPageMapLargeObject);
+  }
+  if (r != NULL) {
+    *bytes_allocated = num_pages * kPageSize;
+  }
+  return r;
+}
+
+RosAlloc::Run* RosAlloc::AllocRun(Thread* self, size_t idx) {
+  Run* new_run;
+  {
+    MutexLock mu(self, lock_);
+    new_run = reinterpret_cast<Run*>(AllocPages(self, numOfPages[idx], kPageMapRun));
+  }
+  if (LIKELY(new_run != NULL)) {
+    // The pages may have been used before, clear the header including the bitmaps.
+    memset(new_run, 0, headerSizes[idx]);
+    new_run->magic_num_ = kMagicNum;
+    new_run->size_bracket_idx_ = idx;
+  }
+  return new_run;
+}
+
+RosAlloc::Run* RosAlloc::RefillRun(Thread* self, size_t idx) {
+  // Prefer the lowest addressed run with free slots to keep the heap compact.
+  std::set<Run*>& runs = non_full_runs_[idx];
+  if (!runs.empty()) {
+    auto it = runs.begin();
+    Run* run = *it;
+    runs.erase(it);
+    return run;
+  }
+  return AllocRun(self, idx);
+}
+
+void* RosAlloc::AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated) {
+  const size_t idx = SizeToIndex(size);
+  void* slot_addr;
+  if (LIKELY(idx < kNumThreadLocalSizeBrackets)) {
+    // Use the thread-local run, only the owning thread allocates from it so no lock is needed.
+    Run* thread_local_run = reinterpret_cast<Run*>(self->GetRosAllocRun(idx));
+    slot_addr = thread_local_run != NULL ? thread_local_run->AllocSlot() : NULL;
+    if (UNLIKELY(slot_addr == NULL)) {
+      MutexLock mu(self, *size_bracket_locks_[idx]);
+      if (thread_local_run != NULL) {
+        DCHECK(thread_local_run->is_thread_local_);
+        if (!thread_local_run->MergeThreadLocalFreeBitMapToAllocBitMap()) {
+          // The run is full and nobody freed a slot in it. Retire it, it goes back into the
+          // non-full runs once one of its slots is freed.
+          thread_local_run->is_thread_local_ = 0;
+          thread_local_run = NULL;
+        }
+      }
+      if (thread_local_run == NULL) {
+        thread_local_run = RefillRun(self, idx);
+        if (UNLIKELY(thread_local_run == NULL)) {
+          self->SetRosAllocRun(idx, NULL);
+          return NULL;
+        }
+        DCHECK(!thread_local_run->is_thread_local_);
+        thread_local_run->is_thread_local_ = 1;
+        self->SetRosAllocRun(idx, thread_local_run);
+      }
+      slot_addr = thread_local_run->AllocSlot();
+      DCHECK(slot_addr != NULL);
+    }
+  } else {
+    MutexLock mu(self, *size_bracket_locks_[idx]);
+    Run* current_run = current_runs_[idx];
+    slot_addr = current_run != NULL ? current_run->AllocSlot() : NULL;
+    if (UNLIKELY(slot_addr == NULL)) {
+      // The full run is no longer tracked until one of its slots is freed.
+      current_run = RefillRun(self, idx);
+      current_runs_[idx] = current_run;
+      if (UNLIKELY(current_run == NULL)) {
+        return NULL;
+      }
+      slot_addr = current_run->AllocSlot();
+      DCHECK(slot_addr != NULL);
+    }
+  }
+  *bytes_allocated = bracketSizes[idx];
+  return slot_addr;
+}
+
+RosAlloc::Run* RosAlloc::RunForPageMapIndex(size_t pm_idx) {
+  // The page map entries of allocated memory don't change under us, so no lock is needed.
+  while (page_map_[pm_idx] == kPageMapRunPart) {
+    DCHECK_GT(pm_idx, 0U);
+    --pm_idx;
+  }
+  DCHECK_EQ(page_map_[pm_idx], kPageMapRun);
+  Run* run = reinterpret_cast<Run*>(base_ + pm_idx * kPageSize);
+  DCHECK_EQ(run->magic_num_, kMagicNum);
+  return run;
+}
+
+size_t RosAlloc::Free(Thread* self, void* ptr) {
+  const size_t pm_idx = ToPageMapIndex(ptr);
+  const byte pm_type = page_map_[pm_idx];
+  if (pm_type == kPageMapLargeObject) {
+    MutexLock mu(self, lock_);
+    return FreePages(self, ptr);
+  }
+  if (UNLIKELY(pm_type != kPageMapRun && pm_type != kPageMapRunPart)) {
+    LOG(FATAL) << "Unexpected page map type " << static_cast<int>(pm_type) << " for " << ptr;
+  }
+  return FreeFromRun(self, ptr, RunForPageMapIndex(pm_idx));
+}
+
+size_t RosAlloc::FreeFromRun(Thread* self, void* ptr, Run* run) {
+  const size_t idx = run->size_bracket_idx_;
+  MutexLock mu(self, *size_bracket_locks_[idx]);
+  if (run->is_thread_local_) {
+    // The owning thread merges this when it runs out of slots.
+    run->MarkThreadLocalFreeBitMap(ptr);
+  } else {
+    run->FreeSlot(ptr);
+    OnRunSlotsFreed(self, run);
+  }
+  return bracketSizes[idx];
+}
+
+void RosAlloc::OnRunSlotsFreed(Thread* self, Run* run) {
+  const size_t idx = run->size_bracket_idx_;
+  size_bracket_locks_[idx]->AssertHeld(self);
+  DCHECK(!run->is_thread_local_);
+  if (run == current_runs_[idx]) {
+    return;
+  }
+  if (run->IsAllFree()) {
+    non_full_runs_[idx].erase(run);
+    MutexLock mu(self, lock_);
+    FreePages(self, run);
+  } else {
+    non_full_runs_[idx].insert(run);
+  }
+}
+
+size_t RosAlloc::BulkFree(Thread* self, void** ptrs, size_t num_ptrs) {
+  // Sorting brings the slots of each run together. Sweeping mostly hands them over in address
+  // order already.
+  std::sort(ptrs, ptrs + num_ptrs);
+  size_t freed_bytes = 0;
+  size_t i = 0;
+  while (i < num_ptrs) {
+    const size_t pm_idx = ToPageMapIndex(ptrs[i]);
+    const byte pm_type = page_map_[pm_idx];
+    if (pm_type == kPageMapLargeObject) {
+      // Free the adjacent large objects under one acquisition of the global lock.
+      MutexLock mu(self, lock_);
+      do {
+        freed_bytes += FreePages(self, ptrs[i]);
+        ++i;
+      } while (i < num_ptrs && page_map_[ToPageMapIndex(ptrs[i])] == kPageMapLargeObject);
+      continue;
+    }
+    if (UNLIKELY(pm_type != kPageMapRun && pm_type != kPageMapRunPart)) {
+      LOG(FATAL) << "Unexpected page map type " << static_cast<int>(pm_type) << " for "
+                 << ptrs[i];
+    }
+    // Free all the slots of this run with its bracket lock taken once.
+    Run* run = RunForPageMapIndex(pm_idx);
+    const size_t idx = run->size_bracket_idx_;
+    void* const run_end = run->End();
+    MutexLock mu(self, *size_bracket_locks_[idx]);
+    const bool is_thread_local = run->is_thread_local_ != 0;
+    for (; i < num_ptrs && ptrs[i] < run_end; ++i) {
+      if (is_thread_local) {
+        // The owning thread merges this when it runs out of slots.
+        run->MarkThreadLocalFreeBitMap(ptrs[i]);
+      } else {
+        run->FreeSlot(ptrs[i]);
+      }
+      freed_bytes += bracketSizes[idx];
+    }
+    if (!is_thread_local) {
+      OnRunSlotsFreed(self, run);
+    }
+  }
+  return freed_bytes;
+}
+
+size_t RosAlloc::UsableSize(void* ptr) {
+  const size_t pm_idx = ToPageMapIndex(ptr);
+  switch (page_map_[pm_idx]) {
+    case kPageMapLargeObject: {
+      MutexLock mu(Thread::Current(), lock_);
+      size_t num_pages = 1;
+      const size_t end = footprint_ / kPageSize;
+      for (size_t idx = pm_idx + 1; idx < end && page_map_[idx] == kPageMapLargeObjectPart;
+           ++idx) {
+        ++num_pages;
+      }
+      return num_pages * kPageSize;
+    }
+    case kPageMapRun:
+    case kPageMapRunPart:
+      return bracketSizes[RunForPageMapIndex(pm_idx)->size_bracket_idx_];
+    default:
+      LOG(FATAL) << "Unexpected page map type " << static_cast<int>(page_map_[pm_idx])
+                 << " for " << ptr;
+      return 0;
+  }
+}
+
+size_t RosAlloc::Trim() {
+  MutexLock mu(Thread::Current(), lock_);
+  size_t reclaimed = 0;
+  // Give back the free pages at the end of the footprint.
+  if (!free_page_runs_.empty()) {
+    FreePageRun* last = *free_page_runs_.rbegin();
+    if (last->End(this) == base_ + footprint_) {
+      size_t decrement = last->ByteSize(this);
+      if (reinterpret_cast<byte*>(last) == base_) {
+        // Keep the first page, the space can't shrink to nothing.
+        decrement -= kPageSize;
+      }
+      if (decrement > 0) {
+        free_page_runs_.erase(last);
+        last->SetByteSize(this, 0);
+        if (reinterpret_cast<byte*>(last) == base_) {
+          last->SetByteSize(this, kPageSize);
+          free_page_runs_.insert(last);
+        }
+        footprint_ -= decrement;
+        art_heap_rosalloc_morecore(this, -static_cast<intptr_t>(decrement));
+        reclaimed += decrement;
+      }
+    }
+  }
+  // Advise the kernel that the remaining free pages are not needed.
+  for (FreePageRun* fpr : free_page_runs_) {
+    const size_t byte_size = fpr->ByteSize(this);
+    if (madvise(fpr, byte_size, MADV_DONTNEED) == -1) {
+      PLOG(WARNING) << "madvise failed";
+    }
+    reclaimed += byte_size;
+  }
+  return reclaimed;
+}
+
+void RosAlloc::InspectAll(void (*handler)(void* start, void* end, size_t used_bytes,
+                                          void* callback_arg),
+                          void* arg) {
+  MutexLock mu(Thread::Current(), lock_);
+  const size_t pm_end = footprint_ / kPageSize;
+  for (size_t i = 0; i < pm_end; ) {
+    byte* start = base_ + i * kPageSize;
+    switch (page_map_[i]) {
+      case kPageMapEmpty: {
+        FreePageRun* fpr = reinterpret_cast<FreePageRun*>(start);
+        const size_t byte_size = fpr->ByteSize(this);
+        DCHECK_GT(byte_size, 0U);
+        handler(start, start + byte_size, 0, arg);
+        i += byte_size / kPageSize;
+        break;
+      }
+      case kPageMapLargeObject: {
+        size_t num_pages = 1;
+        while (i + num_pages < pm_end && page_map_[i + num_pages] == kPageMapLargeObjectPart) {
+          ++num_pages;
+        }
+        handler(start, start + num_pages * kPageSize, num_pages * kPageSize, arg);
+        i += num_pages;
+        break;
+      }
+      case kPageMapRun: {
+        Run* run = reinterpret_cast<Run*>(start);
+        run->InspectAllSlots(handler, arg);
+        i += numOfPages[run->size_bracket_idx_];
+        break;
+      }
+      default:
+        LOG(FATAL) << "Unexpected page map type " << static_cast<int>(page_map_[i])
+                   << " at page " << i;
+        return;
+    }
+  }
+}
+
+size_t RosAlloc::Footprint() {
+  MutexLock mu(Thread::Current(), lock_);
+  return footprint_;
+}
+
+size_t RosAlloc::FootprintLimit() {
+  MutexLock mu(Thread::Current(), lock_);
+  return capacity_;
+}
+
+void RosAlloc::SetFootprintLimit(size_t new_capacity) {
+  MutexLock mu(Thread::Current(), lock_);
+  DCHECK_EQ(RoundUp(new_capacity, kPageSize), new_capacity);
+  // Only growth of the limit is restricted, the footprint never shrinks here.
+  capacity_ = std::min(std::max(new_capacity, footprint_), capacity_max_);
+}
+
+void RosAlloc::RevokeThreadLocalRuns(Thread* thread) {
+  Thread* self = Thread::Current();
+  for (size_t idx = 0; idx < kNumThreadLocalSizeBrackets; ++idx) {
+    Run* run = reinterpret_cast<Run*>(thread->GetRosAllocRun(idx));
+    if (run == NULL) {
+      continue;
+    }
+    MutexLock mu(self, *size_bracket_locks_[idx]);
+    DCHECK(run->is_thread_local_);
+    run->MergeThreadLocalFreeBitMapToAllocBitMap();
+    run->is_thread_local_ = 0;
+    thread->SetRosAllocRun(idx, NULL);
+    if (!run->IsFull()) {
+      OnRunSlotsFreed(self, run);
+    }
+  }
+}
+
+void* RosAlloc::Run::AllocSlot() {
+  const size_t idx = size_bracket_idx_;
+  const size_t num_slots = numOfSlots[idx];
+  const size_t num_vec = RoundUp(num_slots, 32) / 32;
+  for (size_t v = 0; v < num_vec; ++v) {
+    const uint32_t vec = alloc_bit_map_[v];
+    const int ffz = __builtin_ffs(~vec);
+    if (ffz != 0) {
+      const size_t slot_idx = v * 32 + (ffz - 1);
+      if (UNLIKELY(slot_idx >= num_slots)) {
+        // Only the padding bits of the last word are left.
+        return NULL;
+      }
+      alloc_bit_map_[v] = vec | (1U << (ffz - 1));
+      return reinterpret_cast<byte*>(this) + headerSizes[idx] + slot_idx * bracketSizes[idx];
+    }
+  }
+  return NULL;
+}
+
+size_t RosAlloc::Run::SlotIndex(void* ptr) {
+  const size_t idx = size_bracket_idx_;
+  const size_t offset_from_slot_base =
+      reinterpret_cast<byte*>(ptr) - (reinterpret_cast<byte*>(this) + headerSizes[idx]);
+  DCHECK_EQ(offset_from_slot_base % bracketSizes[idx], static_cast<size_t>(0));
+  const size_t slot_idx = offset_from_slot_base / bracketSizes[idx];
+  DCHECK_LT(slot_idx, numOfSlots[idx]);
+  return slot_idx;
+}
+
+void RosAlloc::Run::FreeSlot(void* ptr) {
+  DCHECK(!is_thread_local_);
+  const size_t slot_idx = SlotIndex(ptr);
+  const uint32_t mask = 1U << (slot_idx % 32);
+  DCHECK_NE(alloc_bit_map_[slot_idx / 32] & mask, 0U);
+  alloc_bit_map_[slot_idx / 32] &= ~mask;
+}
+
+void RosAlloc::Run::MarkThreadLocalFreeBitMap(void* ptr) {
+  DCHECK(is_thread_local_);
+  const size_t slot_idx = SlotIndex(ptr);
+  const uint32_t mask = 1U << (slot_idx % 32);
+  uint32_t* thread_local_free_bit_map = ThreadLocalFreeBitMap();
+  DCHECK_EQ(thread_local_free_bit_map[slot_idx / 32] & mask, 0U);
+  thread_local_free_bit_map[slot_idx / 32] |= mask;
+}
+
+bool RosAlloc::Run::MergeThreadLocalFreeBitMapToAllocBitMap() {
+  const size_t num_vec = RoundUp(numOfSlots[size_bracket_idx_], 32) / 32;
+  uint32_t* thread_local_free_bit_map = ThreadLocalFreeBitMap();
+  bool changed = false;
+  for (size_t v = 0; v < num_vec; ++v) {
+    const uint32_t tl_free_vec = thread_local_free_bit_map[v];
+    if (tl_free_vec != 0) {
+      DCHECK_EQ(alloc_bit_map_[v] & tl_free_vec, tl_free_vec);
+      alloc_bit_map_[v] &= ~tl_free_vec;
+      thread_local_free_bit_map[v] = 0;
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+bool RosAlloc::Run::IsAllFree() {
+  const size_t num_vec = RoundUp(numOfSlots[size_bracket_idx_], 32) / 32;
+  for (size_t v = 0; v < num_vec; ++v) {
+    if (alloc_bit_map_[v] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool RosAlloc::Run::IsFull() {
+  const size_t num_slots = numOfSlots[size_bracket_idx_];
+  const size_t num_full_vec = num_slots / 32;
+  for (size_t v = 0; v < num_full_vec; ++v) {
+    if (~alloc_bit_map_[v] != 0) {
+      return false;
+    }
+  }
+  const size_t remaining = num_slots % 32;
+  if (remaining != 0) {
+    const uint32_t mask = (1U << remaining) - 1;
+    if ((alloc_bit_map_[num_full_vec] & mask) != mask) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void RosAlloc::Run::InspectAllSlots(void (*handler)(void* start, void* end, size_t used_bytes,
+                                                    void* arg),
+                                    void* arg) {
+  const size_t idx = size_bracket_idx_;
+  const size_t bracket_size = bracketSizes[idx];
+  byte* slot_base = reinterpret_cast<byte*>(this) + headerSizes[idx];
+  for (size_t i = 0; i < numOfSlots[idx]; ++i) {
+    byte* slot_addr = slot_base + i * bracket_size;
+    const bool is_allocated = (alloc_bit_map_[i / 32] & (1U << (i % 32))) != 0;
+    handler(slot_addr, slot_addr + bracket_size, is_allocated ? bracket_size : 0, arg);
+  }
+}
+
+}  // namespace allocator
+}  // namespace gc
+}  // namespace art
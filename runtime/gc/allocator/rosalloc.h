@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_ALLOCATOR_ROSALLOC_H_
+#define ART_RUNTIME_GC_ALLOCATOR_ROSALLOC_H_
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "globals.h"
+
+namespace art {
+
+class Thread;
+
+namespace gc {
+namespace allocator {
+
+// A runs-of-slots memory allocator. Small allocations are served from runs, which are groups of
+// pages split into equally sized slots of one size bracket and tracked with allocation bitmaps.
+// Large allocations are whole page runs. Each size bracket has its own lock, and threads own
+// private runs for the smallest brackets so that the common allocation path takes no lock.
+class RosAlloc {
+ private:
+  // A run of free pages. Its size is kept in free_page_run_size_map_ rather than in the pages
+  // themselves so that free pages can be released to the kernel.
+  class FreePageRun {
+   public:
+    size_t ByteSize(RosAlloc* rosalloc) const {
+      return rosalloc->free_page_run_size_map_[rosalloc->ToPageMapIndex(this)];
+    }
+    void SetByteSize(RosAlloc* rosalloc, size_t byte_size) {
+      DCHECK_EQ(byte_size % kPageSize, static_cast<size_t>(0));
+      rosalloc->free_page_run_size_map_[rosalloc->ToPageMapIndex(this)] = byte_size;
+    }
+    void* Begin() {
+      return reinterpret_cast<void*>(this);
+    }
+    void* End(RosAlloc* rosalloc) {
+      return reinterpret_cast<byte*>(this) + ByteSize(rosalloc);
+    }
+  };
+
+  // A run of pages holding slots of one size bracket. The header is followed by two bitmaps: the
+  // allocation bitmap and the thread-local free bitmap which records frees from other threads
+  // while the run is owned by a thread. Only the owning thread touches the allocation bitmap of a
+  // thread-local run.
+  class Run {
+   public:
+    byte magic_num_;
+    byte size_bracket_idx_;
+    byte is_thread_local_;
+    byte padding_;
+    uint32_t alloc_bit_map_[0];
+
+    uint32_t* ThreadLocalFreeBitMap() {
+      return reinterpret_cast<uint32_t*>(reinterpret_cast<byte*>(this) +
+                                         threadLocalFreeBitMapOffsets[size_bracket_idx_]);
+    }
+    void* End() {
+      return reinterpret_cast<byte*>(this) + kPageSize * numOfPages[size_bracket_idx_];
+    }
+
+    // Returns a free slot or NULL if the run is full.
+    void* AllocSlot();
+    void FreeSlot(void* ptr);
+    // Records a free of a slot in a thread-local run.
+    void MarkThreadLocalFreeBitMap(void* ptr);
+    // Applies the thread-local frees to the allocation bitmap. Returns true if any slot was freed.
+    bool MergeThreadLocalFreeBitMapToAllocBitMap();
+    bool IsAllFree();
+    bool IsFull();
+    // Calls the handler for each slot, passing the slot size as used bytes for allocated slots.
+    void InspectAllSlots(void (*handler)(void* start, void* end, size_t used_bytes, void* arg),
+                         void* arg);
+
+   private:
+    size_t SlotIndex(void* ptr);
+  };
+
+  // The magic number for a run.
+  static const byte kMagicNum = 42;
+
+ public:
+  // The number of size brackets.
+  static const size_t kNumOfSizeBrackets = 34;
+  // The number of smaller size brackets that are quantum-size apart.
+  static const size_t kNumOfQuantumSizeBrackets = 32;
+  // The quantum size. For example, the size brackets are 16, 32, 48, .., 512 bytes.
+  static const size_t kBracketQuantumSize = 16;
+  // The largest allocation served from a run, larger ones get their own pages.
+  static const size_t kLargeSizeThreshold = 2 * KB;
+  // Brackets below this index use thread-local runs, that is up to 176 bytes. Sync this with
+  // Thread::kRosAllocNumThreadLocalSizeBrackets.
+  static const size_t kNumThreadLocalSizeBrackets = 11;
+
+  // Kinds of pages in the page map.
+  enum {
+    kPageMapEmpty = 0,            // Not allocated.
+    kPageMapRun = 1,              // The beginning of a run.
+    kPageMapRunPart = 2,          // The non-beginning part of a run.
+    kPageMapLargeObject = 3,      // The beginning of a large object.
+    kPageMapLargeObjectPart = 4,  // The non-beginning part of a large object.
+  };
+
+  // base is the beginning of the managed memory, capacity the initial footprint limit and
+  // max_capacity the size of the reserved range the allocator may eventually grow into.
+  RosAlloc(void* base, size_t capacity, size_t max_capacity);
+  ~RosAlloc();
+
+  void* Alloc(Thread* self, size_t size, size_t* bytes_allocated)
+      LOCKS_EXCLUDED(lock_);
+  size_t Free(Thread* self, void* ptr)
+      LOCKS_EXCLUDED(lock_);
+  // Frees a batch of pointers, taking each run's bracket lock only once. Sorts ptrs. Concurrent
+  // bulk frees only contend on the bracket locks of the runs they share.
+  size_t BulkFree(Thread* self, void** ptrs, size_t num_ptrs)
+      LOCKS_EXCLUDED(lock_);
+  // Returns the size of the allocated slot or page run for ptr.
+  size_t UsableSize(void* ptr);
+
+  // Releases the free pages at the end of the footprint and advises the kernel about the other
+  // free pages. Returns the number of bytes released.
+  size_t Trim() LOCKS_EXCLUDED(lock_);
+  // Calls the handler for each slot and each page run, allocated or free.
+  void InspectAll(void (*handler)(void* start, void* end, size_t used_bytes, void* callback_arg),
+                  void* arg)
+      LOCKS_EXCLUDED(lock_);
+
+  size_t Footprint() LOCKS_EXCLUDED(lock_);
+  size_t FootprintLimit() LOCKS_EXCLUDED(lock_);
+  void SetFootprintLimit(size_t bytes) LOCKS_EXCLUDED(lock_);
+
+  // Hands the thread-local runs of thread back to the shared run sets. The caller must be thread
+  // or have it suspended.
+  void RevokeThreadLocalRuns(Thread* thread);
+
+  static size_t IndexToBracketSize(size_t idx) {
+    DCHECK_LT(idx, kNumOfSizeBrackets);
+    return bracketSizes[idx];
+  }
+
+  static size_t SizeToIndex(size_t size) {
+    DCHECK_LE(size, kLargeSizeThreshold);
+    if (LIKELY(size <= kNumOfQuantumSizeBrackets * kBracketQuantumSize)) {
+      return size == 0 ? 0 : (size - 1) / kBracketQuantumSize;
+    } else if (size <= 1 * KB) {
+      return kNumOfSizeBrackets - 2;
+    } else {
+      return kNumOfSizeBrackets - 1;
+    }
+  }
+
+ private:
+  size_t ToPageMapIndex(const void* addr) const {
+    DCHECK_LE(base_, addr);
+    DCHECK_LT(addr, base_ + capacity_max_);
+    return (reinterpret_cast<const byte*>(addr) - base_) / kPageSize;
+  }
+
+  // Returns the run containing the page at pm_idx, which must be part of a run.
+  Run* RunForPageMapIndex(size_t pm_idx);
+
+  // Allocates num_pages pages marking the first as page_map_type. Returns NULL on failure.
+  void* AllocPages(Thread* self, size_t num_pages, byte page_map_type)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Frees the pages starting at ptr and returns the number of bytes freed.
+  size_t FreePages(Thread* self, void* ptr) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  void* AllocLargeObject(Thread* self, size_t size, size_t* bytes_allocated)
+      LOCKS_EXCLUDED(lock_);
+  void* AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated);
+  size_t FreeFromRun(Thread* self, void* ptr, Run* run);
+  // Returns the run to use once the current run of a bracket is full. The bracket lock must be
+  // held.
+  Run* RefillRun(Thread* self, size_t idx);
+  Run* AllocRun(Thread* self, size_t idx);
+  // Called with the bracket lock held when a run that isn't thread-local has had slots freed.
+  void OnRunSlotsFreed(Thread* self, Run* run);
+
+  // Computes the run layout of each size bracket.
+  static void Initialize();
+
+  // The size of each bracket.
+  static size_t bracketSizes[kNumOfSizeBrackets];
+  // The number of pages in a run of each bracket.
+  static size_t numOfPages[kNumOfSizeBrackets];
+  // The number of slots in a run of each bracket.
+  static size_t numOfSlots[kNumOfSizeBrackets];
+  // The run header size, which is also the offset of the first slot, of each bracket.
+  static size_t headerSizes[kNumOfSizeBrackets];
+  // The offset of the thread-local free bitmap of each bracket.
+  static size_t threadLocalFreeBitMapOffsets[kNumOfSizeBrackets];
+  static bool initialized_;
+
+  // The beginning of the managed memory.
+  byte* const base_;
+  // The footprint in bytes of the currently allocated portion of the memory.
+  size_t footprint_ GUARDED_BY(lock_);
+  // The maximum footprint, analogous to dlmalloc's footprint limit.
+  size_t capacity_ GUARDED_BY(lock_);
+  // The size of the reserved memory range.
+  const size_t capacity_max_;
+
+  // Runs of each bracket with free slots which are not the current run.
+  std::set<Run*> non_full_runs_[kNumOfSizeBrackets];
+  // The run shared by all threads for each bracket, NULL if there is none.
+  Run* current_runs_[kNumOfSizeBrackets];
+  // Guard the shared runs of each bracket and the run sets above.
+  Mutex* size_bracket_locks_[kNumOfSizeBrackets];
+  // The names of the bracket locks, which the mutexes don't copy.
+  std::string size_bracket_lock_names_[kNumOfSizeBrackets];
+
+  // One byte per page describing what the page holds.
+  std::vector<byte> page_map_;
+  // The byte size of the free page run starting at each page.
+  std::vector<size_t> free_page_run_size_map_ GUARDED_BY(lock_);
+  // The free page runs ordered by address.
+  std::set<FreePageRun*> free_page_runs_ GUARDED_BY(lock_);
+
+  // Guards the page map, the free page runs and the footprint.
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+
+  DISALLOW_COPY_AND_ASSIGN(RosAlloc);
+};
+
+}  // namespace allocator
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_ALLOCATOR_ROSALLOC_H_
@@ -28,6 +28,7 @@
 #include "gc/space/space-inl.h"
 #include "thread.h"
 #include "thread_list.h"
+#include "utils.h"
 
 namespace art {
 namespace gc {
@@ -58,6 +59,29 @@ void GarbageCollector::ResetCumulativeStatistics() {
   total_paused_time_ns_ = 0;
   total_freed_objects_ = 0;
   total_freed_bytes_ = 0;
+  sweep_statistics_.clear();
+}
+
+void GarbageCollector::RecordSweep(const std::string& phase, uint64_t duration_ns,
+                                   uint64_t freed_objects, uint64_t freed_bytes) {
+  SweepStatistics& statistics = sweep_statistics_[phase];
+  statistics.duration_ns += duration_ns;
+  statistics.freed_objects += freed_objects;
+  statistics.freed_bytes += freed_bytes;
+}
+
+void GarbageCollector::DumpSweepThroughput(std::ostream& os) const {
+  for (const auto& it : sweep_statistics_) {
+    const SweepStatistics& statistics = it.second;
+    if (statistics.duration_ns == 0) {
+      continue;
+    }
+    const double seconds = static_cast<double>(statistics.duration_ns) / 1000000000.0;
+    os << GetName() << " " << it.first << " sweep time: "
+       << PrettyDuration(statistics.duration_ns) << " throughput: "
+       << statistics.freed_objects / seconds << " objects/s / "
+       << PrettySize(statistics.freed_bytes / seconds) << "/s\n";
+  }
 }
 
 void GarbageCollector::Run() {
@@ -127,7 +151,7 @@ void GarbageCollector::SwapBitmaps() {
       if (live_bitmap != mark_bitmap) {
         heap_->GetLiveBitmap()->ReplaceBitmap(live_bitmap, mark_bitmap);
         heap_->GetMarkBitmap()->ReplaceBitmap(mark_bitmap, live_bitmap);
-        space->AsDlMallocSpace()->SwapBitmaps();
+        space->AsContinuousMemMapAllocSpace()->SwapBitmaps();
       }
     }
   }
@@ -22,6 +22,9 @@
 #include "base/timing_logger.h"
 
 #include <stdint.h>
+#include <map>
+#include <ostream>
+#include <string>
 #include <vector>
 
 namespace art {
@@ -74,6 +77,29 @@ class GarbageCollector {
 
   void ResetCumulativeStatistics();
 
+  uint64_t GetTotalTimeNs() const {
+    return total_time_ns_;
+  }
+
+  uint64_t GetTotalPausedTimeNs() const {
+    return total_paused_time_ns_;
+  }
+
+  uint64_t GetTotalFreedObjects() const {
+    return total_freed_objects_;
+  }
+
+  uint64_t GetTotalFreedBytes() const {
+    return total_freed_bytes_;
+  }
+
+  // Adds a run of the given sweep phase to the cumulative sweep statistics.
+  void RecordSweep(const std::string& phase, uint64_t duration_ns, uint64_t freed_objects,
+                   uint64_t freed_bytes);
+
+  // Dumps how fast each sweep phase freed objects and bytes.
+  void DumpSweepThroughput(std::ostream& os) const;
+
   // Swap the live and mark bitmaps of spaces that are active for the collector. For partial GC,
   // this is the allocation space, for full GC then we swap the zygote bitmaps too.
   void SwapBitmaps() EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
@@ -111,6 +137,15 @@ class GarbageCollector {
 
   CumulativeLogger cumulative_timings_;
 
+  // Cumulative time spent in and memory freed by a sweep phase.
+  struct SweepStatistics {
+    SweepStatistics() : duration_ns(0), freed_objects(0), freed_bytes(0) {}
+    uint64_t duration_ns;
+    uint64_t freed_objects;
+    uint64_t freed_bytes;
+  };
+  std::map<std::string, SweepStatistics> sweep_statistics_;
+
   std::vector<uint64_t> pause_times_;
 };
 
@@ -22,13 +22,16 @@
 #include <vector>
 
 #include "base/bounded_fifo.h"
+#include "base/casts.h"
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/mutex-inl.h"
+#include "base/stl_util.h"
 #include "base/timing_logger.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/accounting/heap_bitmap.h"
 #include "gc/accounting/space_bitmap-inl.h"
+#include "gc/accounting/work_stealing_deque.h"
 #include "gc/heap.h"
 #include "gc/space/image_space.h"
 #include "gc/space/large_object_space.h"
@@ -49,6 +52,7 @@
 #include "runtime.h"
 #include "thread-inl.h"
 #include "thread_list.h"
+#include "thread_pool.h"
 #include "verifier/method_verifier.h"
 
 using ::art::mirror::ArtField;
@@ -74,6 +78,14 @@ constexpr bool kParallelRecursiveMark = true;
 // ProcessMarkStack with very small mark stacks.
 constexpr size_t kMinimumParallelMarkStackSize = 128;
 constexpr bool kParallelProcessMarkStack = true;
+constexpr bool kParallelSweep = true;
+// Sweep tasks per GC thread, more tasks balance the load better when the garbage isn't spread
+// evenly over the space.
+constexpr size_t kSweepTasksPerThread = 4;
+// Keeps the sweep ranges from sharing bitmap words.
+constexpr size_t kSweepRangeAlignment = 64 * KB;
+// Freeing fewer large objects isn't worth starting the workers.
+constexpr size_t kMinimumParallelLargeObjectSweepSize = 16;
 
 // Profiling and information flags.
 constexpr bool kCountClassesMarked = false;
@@ -174,6 +186,7 @@ void MarkSweep::InitializePhase() {
   work_chunks_created_ = 0;
   work_chunks_deleted_ = 0;
   reference_count_ = 0;
+  root_threads_.clear();
   java_lang_Class_ = Class::GetJavaLangClass();
   CHECK(java_lang_Class_ != nullptr);
 
@@ -208,6 +221,11 @@ bool MarkSweep::HandleDirtyObjectsPhase() {
 
   ProcessReferences(self);
 
+  // Idle monitors can only be deflated while the mutators are suspended.
+  timings_.StartSplit("DeflateMonitors");
+  Runtime::Current()->GetMonitorList()->DeflateMonitors();
+  timings_.EndSplit();
+
   // Only need to do this if we have the card mark verification on, and only during concurrent GC.
   if (GetHeap()->verify_missing_card_marks_ || GetHeap()->verify_pre_gc_heap_||
       GetHeap()->verify_post_gc_heap_) {
@@ -247,6 +265,13 @@ void MarkSweep::MarkingPhase() {
   // Process dirty cards and add dirty cards to mod union tables.
   heap_->ProcessCards(timings_);
 
+  if (Locks::mutator_lock_->IsExclusiveHeld(self)) {
+    // All mutators are suspended, retire their allocation caches and reserved allocation stack
+    // slots now. Otherwise this is done by the thread roots checkpoint.
+    timings_.NewSplit("RevokeThreadLocalBuffers");
+    heap_->RevokeAllThreadLocalBuffers();
+  }
+
   // Need to do this before the checkpoint since we don't want any threads to add references to
   // the live stack during the recursive mark.
   timings_.NewSplit("SwapStacks");
@@ -298,6 +323,13 @@ void MarkSweep::ReclaimPhase() {
     SweepSystemWeaks();
   }
 
+  if (!IsConcurrent()) {
+    // Concurrent collections deflate the idle monitors while handling the dirty objects.
+    timings_.StartSplit("DeflateMonitors");
+    Runtime::Current()->GetMonitorList()->DeflateMonitors();
+    timings_.EndSplit();
+  }
+
   if (IsConcurrent()) {
     Runtime::Current()->AllowNewSystemWeaks();
 
@@ -382,15 +414,13 @@ void MarkSweep::ResizeMarkStack(size_t new_size) {
   }
 }
 
-inline void MarkSweep::MarkObjectNonNullParallel(const Object* obj) {
-  DCHECK(obj != NULL);
-  if (MarkObjectParallel(obj)) {
-    MutexLock mu(Thread::Current(), mark_stack_lock_);
+void MarkSweep::PushOnMarkStackParallel(const Object** objs, size_t count) {
+  MutexLock mu(Thread::Current(), mark_stack_lock_);
+  for (size_t i = 0; i < count; ++i) {
     if (UNLIKELY(mark_stack_->Size() >= mark_stack_->Capacity())) {
       ExpandMarkStack();
     }
-    // The object must be pushed on to the mark stack.
-    mark_stack_->PushBack(const_cast<Object*>(obj));
+    mark_stack_->PushBack(const_cast<Object*>(objs[i]));
   }
 }
 
@@ -519,24 +549,20 @@ void MarkSweep::MarkRoot(const Object* obj) {
   }
 }
 
-void MarkSweep::MarkRootParallelCallback(const Object* root, void* arg) {
-  DCHECK(root != NULL);
-  DCHECK(arg != NULL);
-  reinterpret_cast<MarkSweep*>(arg)->MarkObjectNonNullParallel(root);
-}
-
-void MarkSweep::MarkObjectCallback(const Object* root, void* arg) {
+Object* MarkSweep::MarkObjectCallback(Object* root, void* arg) {
   DCHECK(root != NULL);
   DCHECK(arg != NULL);
   MarkSweep* mark_sweep = reinterpret_cast<MarkSweep*>(arg);
   mark_sweep->MarkObjectNonNull(root);
+  return root;
 }
 
-void MarkSweep::ReMarkObjectVisitor(const Object* root, void* arg) {
+Object* MarkSweep::ReMarkObjectVisitor(Object* root, void* arg) {
   DCHECK(root != NULL);
   DCHECK(arg != NULL);
   MarkSweep* mark_sweep = reinterpret_cast<MarkSweep*>(arg);
   mark_sweep->MarkObjectNonNull(root);
+  return root;
 }
 
 void MarkSweep::VerifyRootCallback(const Object* root, void* arg, size_t vreg,
@@ -564,7 +590,17 @@ void MarkSweep::VerifyRoots() {
 // Marks all objects in the root set.
 void MarkSweep::MarkRoots() {
   timings_.StartSplit("MarkRoots");
-  Runtime::Current()->VisitNonConcurrentRoots(MarkObjectCallback, this);
+  if (kParallelProcessMarkStack && GetThreadCount(true) > 1) {
+    // The mutators stay suspended until the marking is done. Have the work stealing tasks mark
+    // the roots of the threads straight into their deques, rather than serially marking them here
+    // and splitting the mark stack afterwards.
+    MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
+    const std::list<Thread*>& threads = Runtime::Current()->GetThreadList()->GetList();
+    root_threads_.assign(threads.begin(), threads.end());
+    Runtime::Current()->VisitNonThreadRoots(MarkObjectCallback, this);
+  } else {
+    Runtime::Current()->VisitNonConcurrentRoots(MarkObjectCallback, this);
+  }
   timings_.EndSplit();
 }
 
@@ -599,8 +635,8 @@ void MarkSweep::VerifyImageRootVisitor(Object* root, void* arg) {
 }
 
 void MarkSweep::BindLiveToMarkBitmap(space::ContinuousSpace* space) {
-  CHECK(space->IsDlMallocSpace());
-  space::DlMallocSpace* alloc_space = space->AsDlMallocSpace();
+  CHECK(space->IsContinuousMemMapAllocSpace());
+  space::ContinuousMemMapAllocSpace* alloc_space = space->AsContinuousMemMapAllocSpace();
   accounting::SpaceBitmap* live_bitmap = space->GetLiveBitmap();
   accounting::SpaceBitmap* mark_bitmap = alloc_space->mark_bitmap_.release();
   GetHeap()->GetMarkBitmap()->ReplaceBitmap(mark_bitmap, live_bitmap);
@@ -990,8 +1026,8 @@ void MarkSweep::RecursiveMark() {
   ProcessMarkStack(false);
 }
 
-bool MarkSweep::IsMarkedCallback(const Object* object, void* arg) {
-  return reinterpret_cast<MarkSweep*>(arg)->IsMarked(object);
+Object* MarkSweep::IsMarkedCallback(Object* object, void* arg) {
+  return reinterpret_cast<MarkSweep*>(arg)->IsMarked(object) ? object : NULL;
 }
 
 void MarkSweep::RecursiveMarkDirtyObjects(bool paused, byte minimum_age) {
@@ -1005,8 +1041,8 @@ void MarkSweep::ReMarkRoots() {
   timings_.EndSplit();
 }
 
-void MarkSweep::SweepJniWeakGlobals(IsMarkedTester is_marked, void* arg) {
-  Runtime::Current()->GetJavaVM()->SweepWeakGlobals(is_marked, arg);
+void MarkSweep::SweepJniWeakGlobals(RootVisitor* visitor, void* arg) {
+  Runtime::Current()->GetJavaVM()->SweepWeakGlobals(visitor, arg);
 }
 
 struct ArrayMarkedCheck {
@@ -1015,31 +1051,70 @@ struct ArrayMarkedCheck {
 };
 
 // Either marked or not live.
-bool MarkSweep::IsMarkedArrayCallback(const Object* object, void* arg) {
+Object* MarkSweep::IsMarkedArrayCallback(Object* object, void* arg) {
   ArrayMarkedCheck* array_check = reinterpret_cast<ArrayMarkedCheck*>(arg);
   if (array_check->mark_sweep->IsMarked(object)) {
-    return true;
+    return object;
   }
   accounting::ObjectStack* live_stack = array_check->live_stack;
   if (std::find(live_stack->Begin(), live_stack->End(), object) == live_stack->End()) {
-    return true;
+    return object;
   }
-  return false;
+  return NULL;
 }
 
+// Sweeps the weak interns of one intern table stripe.
+class InternTableSweepTask : public Task {
+ public:
+  InternTableSweepTask(MarkSweep* mark_sweep, InternTable* intern_table, size_t stripe)
+      : mark_sweep_(mark_sweep), intern_table_(intern_table), stripe_(stripe) {
+  }
+
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    intern_table_->SweepInternTableWeaks(MarkSweep::IsMarkedCallback, mark_sweep_, stripe_);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  MarkSweep* const mark_sweep_;
+  InternTable* const intern_table_;
+  const size_t stripe_;
+};
+
 void MarkSweep::SweepSystemWeaks() {
   Runtime* runtime = Runtime::Current();
   timings_.StartSplit("SweepSystemWeaks");
-  runtime->GetInternTable()->SweepInternTableWeaks(IsMarkedCallback, this);
-  runtime->GetMonitorList()->SweepMonitorList(IsMarkedCallback, this);
-  SweepJniWeakGlobals(IsMarkedCallback, this);
+  Thread* self = Thread::Current();
+  InternTable* intern_table = runtime->GetInternTable();
+  const size_t thread_count = GetThreadCount(!IsConcurrent());
+  if (kParallelSweep && thread_count > 1) {
+    // The workers sweep the intern table stripes while we sweep the monitors and JNI weak
+    // globals, then we help with whatever stripes are left.
+    ThreadPool* thread_pool = GetHeap()->GetThreadPool();
+    for (size_t i = 0; i < InternTable::kStripeCount; ++i) {
+      thread_pool->AddTask(self, new InternTableSweepTask(this, intern_table, i));
+    }
+    thread_pool->SetMaxActiveWorkers(thread_count - 1);
+    thread_pool->StartWorkers(self);
+    runtime->GetMonitorList()->SweepMonitorList(IsMarkedCallback, this);
+    SweepJniWeakGlobals(IsMarkedCallback, this);
+    thread_pool->Wait(self, true, true);
+    thread_pool->StopWorkers(self);
+  } else {
+    intern_table->SweepInternTableWeaks(IsMarkedCallback, this);
+    runtime->GetMonitorList()->SweepMonitorList(IsMarkedCallback, this);
+    SweepJniWeakGlobals(IsMarkedCallback, this);
+  }
   timings_.EndSplit();
 }
 
-bool MarkSweep::VerifyIsLiveCallback(const Object* obj, void* arg) {
+Object* MarkSweep::VerifyIsLiveCallback(Object* obj, void* arg) {
   reinterpret_cast<MarkSweep*>(arg)->VerifyIsLive(obj);
   // We don't actually want to sweep the object, so lets return "marked"
-  return true;
+  return obj;
 }
 
 void MarkSweep::VerifyIsLive(const Object* obj) {
@@ -1065,10 +1140,48 @@ void MarkSweep::VerifySystemWeaks() {
   runtime->GetJavaVM()->SweepWeakGlobals(VerifyIsLiveCallback, this);
 }
 
-struct SweepCallbackContext {
-  MarkSweep* mark_sweep;
-  space::AllocSpace* space;
-  Thread* self;
+// Marks the roots of a thread from a checkpoint. The roots which need scanning are pushed on the
+// mark stack in batches, so that the threads running the checkpoint at the same time don't
+// serialize on the mark stack lock.
+class ParallelRootMarker {
+ public:
+  explicit ParallelRootMarker(MarkSweep* mark_sweep) : mark_sweep_(mark_sweep), count_(0) {}
+
+  ~ParallelRootMarker() {
+    Flush();
+  }
+
+  static Object* MarkRootCallback(Object* root, void* arg) {
+    DCHECK(root != NULL);
+    DCHECK(arg != NULL);
+    reinterpret_cast<ParallelRootMarker*>(arg)->MarkRoot(root);
+    return root;
+  }
+
+ private:
+  static const size_t kBufferSize = 128;
+
+  void MarkRoot(const Object* root) NO_THREAD_SAFETY_ANALYSIS {
+    if (mark_sweep_->MarkObjectParallel(root)) {
+      if (UNLIKELY(count_ == kBufferSize)) {
+        Flush();
+      }
+      buffer_[count_++] = root;
+    }
+  }
+
+  void Flush() {
+    if (count_ != 0) {
+      mark_sweep_->PushOnMarkStackParallel(buffer_, count_);
+      count_ = 0;
+    }
+  }
+
+  MarkSweep* const mark_sweep_;
+  const Object* buffer_[kBufferSize];
+  size_t count_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelRootMarker);
 };
 
 class CheckpointMarkThreadRoots : public Closure {
@@ -1081,7 +1194,12 @@ class CheckpointMarkThreadRoots : public Closure {
     Thread* self = Thread::Current();
     CHECK(thread == self || thread->IsSuspended() || thread->GetState() == kWaitingPerformingGc)
         << thread->GetState() << " thread " << thread << " self " << self;
-    thread->VisitRoots(MarkSweep::MarkRootParallelCallback, mark_sweep_);
+    {
+      ParallelRootMarker root_marker(mark_sweep_);
+      thread->VisitRoots(ParallelRootMarker::MarkRootCallback, &root_marker);
+    }
+    // Stop the thread from filling in slots of what is now the live stack.
+    mark_sweep_->GetHeap()->RevokeThreadLocalBuffers(thread);
     ATRACE_END();
     mark_sweep_->GetBarrier().Pass(self);
   }
@@ -1110,39 +1228,10 @@ void MarkSweep::MarkRootsCheckpoint(Thread* self) {
   timings_.EndSplit();
 }
 
-void MarkSweep::SweepCallback(size_t num_ptrs, Object** ptrs, void* arg) {
-  SweepCallbackContext* context = static_cast<SweepCallbackContext*>(arg);
-  MarkSweep* mark_sweep = context->mark_sweep;
-  Heap* heap = mark_sweep->GetHeap();
-  space::AllocSpace* space = context->space;
-  Thread* self = context->self;
-  Locks::heap_bitmap_lock_->AssertExclusiveHeld(self);
-  // Use a bulk free, that merges consecutive objects before freeing or free per object?
-  // Documentation suggests better free performance with merging, but this may be at the expensive
-  // of allocation.
-  size_t freed_objects = num_ptrs;
-  // AllocSpace::FreeList clears the value in ptrs, so perform after clearing the live bit
-  size_t freed_bytes = space->FreeList(self, num_ptrs, ptrs);
-  heap->RecordFree(freed_objects, freed_bytes);
-  mark_sweep->freed_objects_.fetch_add(freed_objects);
-  mark_sweep->freed_bytes_.fetch_add(freed_bytes);
-}
-
-void MarkSweep::ZygoteSweepCallback(size_t num_ptrs, Object** ptrs, void* arg) {
-  SweepCallbackContext* context = static_cast<SweepCallbackContext*>(arg);
-  Locks::heap_bitmap_lock_->AssertExclusiveHeld(context->self);
-  Heap* heap = context->mark_sweep->GetHeap();
-  // We don't free any actual memory to avoid dirtying the shared zygote pages.
-  for (size_t i = 0; i < num_ptrs; ++i) {
-    Object* obj = static_cast<Object*>(ptrs[i]);
-    heap->GetLiveBitmap()->Clear(obj);
-    heap->GetCardTable()->MarkCard(obj);
-  }
-}
-
 void MarkSweep::SweepArray(accounting::ObjectStack* allocations, bool swap_bitmaps) {
-  space::DlMallocSpace* space = heap_->GetAllocSpace();
+  space::MallocSpace* space = heap_->GetAllocSpace();
   timings_.StartSplit("SweepArray");
+  const uint64_t start_time = NanoTime();
   // Newly allocated objects MUST be in the alloc space and those are the only objects which we are
   // going to free.
   accounting::SpaceBitmap* live_bitmap = space->GetLiveBitmap();
@@ -1168,6 +1257,10 @@ void MarkSweep::SweepArray(accounting::ObjectStack* allocations, bool swap_bitma
   Thread* self = Thread::Current();
   for (size_t i = 0; i < count; ++i) {
     Object* obj = objects[i];
+    // Reserved allocation stack slots which were never filled in are NULL.
+    if (UNLIKELY(obj == NULL)) {
+      continue;
+    }
     // There should only be objects in the AllocSpace/LargeObjectSpace in the allocation stack.
     if (LIKELY(mark_bitmap->HasAddress(obj))) {
       if (!mark_bitmap->Test(obj)) {
@@ -1185,9 +1278,23 @@ void MarkSweep::SweepArray(accounting::ObjectStack* allocations, bool swap_bitma
           timings_.EndSplit();
         }
       }
-    } else if (!large_mark_objects->Test(obj)) {
-      ++freed_large_objects;
-      freed_large_object_bytes += large_object_space->Free(self, obj);
+    } else {
+      space::ContinuousSpace* other_space = heap_->FindContinuousSpaceFromObject(obj, true);
+      if (other_space == NULL) {
+        if (!large_mark_objects->Test(obj)) {
+          ++freed_large_objects;
+          freed_large_object_bytes += large_object_space->Free(self, obj);
+        }
+      } else if (other_space->IsMallocSpace()) {
+        // Allocated into the non-moving space.
+        accounting::SpaceBitmap* other_mark_bitmap =
+            swap_bitmaps ? other_space->GetLiveBitmap() : other_space->GetMarkBitmap();
+        if (!other_mark_bitmap->Test(obj)) {
+          ++freed_objects;
+          freed_bytes += other_space->AsMallocSpace()->Free(self, obj);
+        }
+      }
+      // Objects in bump pointer spaces are only reclaimed by compacting the space.
     }
   }
   // Free the remaining objects in chunks.
@@ -1211,6 +1318,8 @@ void MarkSweep::SweepArray(accounting::ObjectStack* allocations, bool swap_bitma
   freed_large_objects_.fetch_add(freed_large_objects);
   freed_bytes_.fetch_add(freed_bytes);
   freed_large_object_bytes_.fetch_add(freed_large_object_bytes);
+  RecordSweep("allocation stack", NanoTime() - start_time, freed_objects + freed_large_objects,
+              freed_bytes + freed_large_object_bytes);
   timings_.EndSplit();
 
   timings_.StartSplit("ResetStack");
@@ -1218,14 +1327,94 @@ void MarkSweep::SweepArray(accounting::ObjectStack* allocations, bool swap_bitma
   timings_.EndSplit();
 }
 
+// Sweeps a range of a malloc space. The garbage is gathered into a buffer which is freed in one
+// go, so that the space lock and the freed counters are taken once per batch rather than once per
+// bitmap word. Ranges are aligned so that no two tasks share a bitmap word.
+class SweepTask : public Task {
+ public:
+  SweepTask(MarkSweep* mark_sweep, space::MallocSpace* space, accounting::SpaceBitmap* live_bitmap,
+            accounting::SpaceBitmap* mark_bitmap, uintptr_t begin, uintptr_t end)
+      : mark_sweep_(mark_sweep),
+        space_(space),
+        live_bitmap_(live_bitmap),
+        mark_bitmap_(mark_bitmap),
+        begin_(begin),
+        end_(end),
+        self_(NULL),
+        count_(0),
+        freed_objects_(0),
+        freed_bytes_(0) {
+  }
+
+  virtual void Run(Thread* self) {
+    self_ = self;
+    accounting::SpaceBitmap::SweepWalk(*live_bitmap_, *mark_bitmap_, begin_, end_, &SweepCallback,
+                                       this);
+    Flush();
+    // The heap is told about the freed memory by the GC thread once the tasks are done, since
+    // RecordFree updates the runtime stats non atomically.
+    if (freed_objects_ != 0) {
+      mark_sweep_->freed_objects_.fetch_add(freed_objects_);
+      mark_sweep_->freed_bytes_.fetch_add(freed_bytes_);
+    }
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  static void SweepCallback(size_t num_ptrs, Object** ptrs, void* arg) {
+    SweepTask* task = reinterpret_cast<SweepTask*>(arg);
+    DCHECK_LE(num_ptrs, kSweepArrayChunkFreeSize);
+    if (task->count_ + num_ptrs > kSweepArrayChunkFreeSize) {
+      task->Flush();
+    }
+    std::copy(ptrs, ptrs + num_ptrs, task->buffer_ + task->count_);
+    task->count_ += num_ptrs;
+  }
+
+  void Flush() {
+    if (count_ == 0) {
+      return;
+    }
+    if (space_->IsZygoteSpace()) {
+      // We don't free any actual memory to avoid dirtying the shared zygote pages.
+      Heap* heap = mark_sweep_->GetHeap();
+      for (size_t i = 0; i < count_; ++i) {
+        heap->GetLiveBitmap()->Clear(buffer_[i]);
+        heap->GetCardTable()->MarkCard(buffer_[i]);
+      }
+    } else {
+      freed_objects_ += count_;
+      freed_bytes_ += space_->FreeList(self_, count_, buffer_);
+    }
+    count_ = 0;
+  }
+
+  MarkSweep* const mark_sweep_;
+  space::MallocSpace* const space_;
+  accounting::SpaceBitmap* const live_bitmap_;
+  accounting::SpaceBitmap* const mark_bitmap_;
+  const uintptr_t begin_;
+  const uintptr_t end_;
+  Thread* self_;
+
+  Object* buffer_[kSweepArrayChunkFreeSize];
+  size_t count_;
+  size_t freed_objects_;
+  size_t freed_bytes_;
+};
+
 void MarkSweep::Sweep(bool swap_bitmaps) {
   DCHECK(mark_stack_->IsEmpty());
   base::TimingLogger::ScopedSplit("Sweep", &timings_);
 
   const bool partial = (GetGcType() == kGcTypePartial);
-  SweepCallbackContext scc;
-  scc.mark_sweep = this;
-  scc.self = Thread::Current();
+  Thread* self = Thread::Current();
+  ThreadPool* thread_pool = GetHeap()->GetThreadPool();
+  const size_t thread_count = GetThreadCount(!IsConcurrent());
+  const bool parallel = kParallelSweep && thread_count > 1;
   for (const auto& space : GetHeap()->GetContinuousSpaces()) {
     // We always sweep always collect spaces.
     bool sweep_space = (space->GetGcRetentionPolicy() == space::kGcRetentionPolicyAlwaysCollect);
@@ -1233,26 +1422,46 @@ void MarkSweep::Sweep(bool swap_bitmaps) {
       // We sweep full collect spaces when the GC isn't a partial GC (ie its full).
       sweep_space = (space->GetGcRetentionPolicy() == space::kGcRetentionPolicyFullCollect);
     }
-    if (sweep_space) {
+    // Bump pointer spaces can't free individual objects, they are emptied by compaction.
+    if (sweep_space && space->IsMallocSpace()) {
+      const bool zygote = space->IsZygoteSpace();
+      // Zygote sweep takes care of dirtying cards and clearing live bits, does not free actual
+      // memory.
+      base::TimingLogger::ScopedSplit split(zygote ? "SweepZygote" : "SweepAllocSpace",
+                                            &timings_);
+      const uint64_t start_time = NanoTime();
+      const size_t freed_objects_before = freed_objects_;
+      const size_t freed_bytes_before = freed_bytes_;
       uintptr_t begin = reinterpret_cast<uintptr_t>(space->Begin());
       uintptr_t end = reinterpret_cast<uintptr_t>(space->End());
-      scc.space = space->AsDlMallocSpace();
       accounting::SpaceBitmap* live_bitmap = space->GetLiveBitmap();
       accounting::SpaceBitmap* mark_bitmap = space->GetMarkBitmap();
       if (swap_bitmaps) {
         std::swap(live_bitmap, mark_bitmap);
       }
-      if (!space->IsZygoteSpace()) {
-        base::TimingLogger::ScopedSplit split("SweepAllocSpace", &timings_);
-        // Bitmaps are pre-swapped for optimization which enables sweeping with the heap unlocked.
-        accounting::SpaceBitmap::SweepWalk(*live_bitmap, *mark_bitmap, begin, end,
-                                           &SweepCallback, reinterpret_cast<void*>(&scc));
+      // Bitmaps are pre-swapped for optimization which enables sweeping with the heap unlocked.
+      if (parallel) {
+        const size_t delta = RoundUp((end - begin) / (thread_count * kSweepTasksPerThread) + 1,
+                                     kSweepRangeAlignment);
+        while (begin < end) {
+          const uintptr_t range_end = std::min(begin + delta, end);
+          thread_pool->AddTask(self, new SweepTask(this, space->AsMallocSpace(), live_bitmap,
+                                                   mark_bitmap, begin, range_end));
+          begin = range_end;
+        }
+        thread_pool->SetMaxActiveWorkers(thread_count - 1);
+        thread_pool->StartWorkers(self);
+        thread_pool->Wait(self, true, true);
+        thread_pool->StopWorkers(self);
       } else {
-        base::TimingLogger::ScopedSplit split("SweepZygote", &timings_);
-        // Zygote sweep takes care of dirtying cards and clearing live bits, does not free actual
-        // memory.
-        accounting::SpaceBitmap::SweepWalk(*live_bitmap, *mark_bitmap, begin, end,
-                                           &ZygoteSweepCallback, reinterpret_cast<void*>(&scc));
+        SweepTask task(this, space->AsMallocSpace(), live_bitmap, mark_bitmap, begin, end);
+        task.Run(self);
+      }
+      if (!zygote) {
+        const size_t freed_objects = freed_objects_ - freed_objects_before;
+        const size_t freed_bytes = freed_bytes_ - freed_bytes_before;
+        heap_->RecordFree(freed_objects, freed_bytes);
+        RecordSweep("alloc space", NanoTime() - start_time, freed_objects, freed_bytes);
       }
     }
   }
@@ -1260,8 +1469,37 @@ void MarkSweep::Sweep(bool swap_bitmaps) {
   SweepLargeObjects(swap_bitmaps);
 }
 
+// Frees a share of the unmarked large objects.
+class LargeObjectSweepTask : public Task {
+ public:
+  LargeObjectSweepTask(MarkSweep* mark_sweep, space::LargeObjectSpace* space, Object** objects,
+                       size_t count)
+      : mark_sweep_(mark_sweep), space_(space), objects_(objects), count_(count) {
+  }
+
+  virtual void Run(Thread* self) {
+    // The space frees the whole batch under a single acquisition of its lock.
+    size_t freed_bytes = space_->FreeList(self, count_, objects_);
+    mark_sweep_->freed_large_objects_.fetch_add(count_);
+    mark_sweep_->freed_large_object_bytes_.fetch_add(freed_bytes);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  MarkSweep* const mark_sweep_;
+  space::LargeObjectSpace* const space_;
+  Object** const objects_;
+  const size_t count_;
+};
+
 void MarkSweep::SweepLargeObjects(bool swap_bitmaps) {
   base::TimingLogger::ScopedSplit("SweepLargeObjects", &timings_);
+  const uint64_t start_time = NanoTime();
+  const size_t freed_objects_before = freed_large_objects_;
+  const size_t freed_bytes_before = freed_large_object_bytes_;
   // Sweep large objects
   space::LargeObjectSpace* large_object_space = GetHeap()->GetLargeObjectsSpace();
   accounting::SpaceSetMap* large_live_objects = large_object_space->GetLiveObjects();
@@ -1270,23 +1508,42 @@ void MarkSweep::SweepLargeObjects(bool swap_bitmaps) {
     std::swap(large_live_objects, large_mark_objects);
   }
   // O(n*log(n)) but hopefully there are not too many large objects.
-  size_t freed_objects = 0;
-  size_t freed_bytes = 0;
-  Thread* self = Thread::Current();
+  std::vector<Object*> garbage;
   for (const Object* obj : large_live_objects->GetObjects()) {
     if (!large_mark_objects->Test(obj)) {
-      freed_bytes += large_object_space->Free(self, const_cast<Object*>(obj));
-      ++freed_objects;
+      garbage.push_back(const_cast<Object*>(obj));
+    }
+  }
+  Thread* self = Thread::Current();
+  const size_t thread_count = GetThreadCount(!IsConcurrent());
+  if (kParallelSweep && thread_count > 1 &&
+      garbage.size() >= kMinimumParallelLargeObjectSweepSize) {
+    // Most of the cost is in unmapping or madvising the memory, which the spaces do in parallel
+    // for separate batches.
+    ThreadPool* thread_pool = GetHeap()->GetThreadPool();
+    const size_t chunk_size = garbage.size() / thread_count + 1;
+    for (size_t i = 0; i < garbage.size(); i += chunk_size) {
+      const size_t count = std::min(chunk_size, garbage.size() - i);
+      thread_pool->AddTask(self, new LargeObjectSweepTask(this, large_object_space, &garbage[i],
+                                                          count));
     }
+    thread_pool->SetMaxActiveWorkers(thread_count - 1);
+    thread_pool->StartWorkers(self);
+    thread_pool->Wait(self, true, true);
+    thread_pool->StopWorkers(self);
+  } else if (!garbage.empty()) {
+    LargeObjectSweepTask task(this, large_object_space, &garbage[0], garbage.size());
+    task.Run(self);
   }
-  freed_large_objects_.fetch_add(freed_objects);
-  freed_large_object_bytes_.fetch_add(freed_bytes);
-  GetHeap()->RecordFree(freed_objects, freed_bytes);
+  const size_t freed_objects = freed_large_objects_ - freed_objects_before;
+  const size_t freed_bytes = freed_large_object_bytes_ - freed_bytes_before;
+  heap_->RecordFree(freed_objects, freed_bytes);
+  RecordSweep("large objects", NanoTime() - start_time, freed_objects, freed_bytes);
 }
 
 void MarkSweep::CheckReference(const Object* obj, const Object* ref, MemberOffset offset, bool is_static) {
   for (const auto& space : GetHeap()->GetContinuousSpaces()) {
-    if (space->IsDlMallocSpace() && space->Contains(ref)) {
+    if (space->IsMallocSpace() && space->Contains(ref)) {
       DCHECK(IsMarked(obj));
 
       bool is_marked = IsMarked(ref);
@@ -1399,25 +1656,260 @@ void MarkSweep::ScanObject(const Object* obj) {
   ScanObjectVisit(obj, visitor);
 }
 
+// Marks the objects reachable from the objects in its deque, one task per GC thread. The owner
+// works at the bottom of the deque, depth first. A task which runs out of work steals from the
+// top of the deques of the other tasks, where the oldest entries are, which tend to lead to the
+// largest unscanned subgraphs.
+class WorkStealingMarkTask : public WorkStealingTask {
+ public:
+  static const size_t kDequeSize = 4 * KB;
+  // A thief takes at most half of the deque of its victim, up to this many objects.
+  static const size_t kMaxStealCount = 64;
+  // How many times an idle task yields before it starts sleeping between steal attempts.
+  static const size_t kYieldCount = 16;
+  static const uint64_t kSleepNs = 10 * 1000;
+
+  WorkStealingMarkTask(MarkSweep* mark_sweep, const std::vector<WorkStealingMarkTask*>* tasks,
+                       size_t index, AtomicInteger* active_tasks)
+      : mark_sweep_(mark_sweep),
+        tasks_(tasks),
+        index_(index),
+        active_tasks_(active_tasks),
+        scanned_objects_(0),
+        steals_(0),
+        stolen_objects_(0),
+        failed_steals_(0) {
+  }
+
+  // Only called by the thread running the task, or before the task is started.
+  void Push(const Object* obj) ALWAYS_INLINE {
+    DCHECK(obj != nullptr);
+    if (UNLIKELY(!deque_.PushBottom(obj))) {
+      // The deque is full, keep the object where only we can reach it until there is room.
+      overflow_.push_back(obj);
+    }
+  }
+
+  // Only called before the task is started.
+  void AddRootThread(Thread* thread) {
+    root_threads_.push_back(thread);
+  }
+
+  // Marks until there is no work left in any of the tasks.
+  virtual void Run(Thread* self) {
+    MarkRootThreads();
+    do {
+      ProcessLocalWork();
+    } while (StealWork(self));
+  }
+
+  // Moves some of the objects of source to our deque, source must be another mark task.
+  virtual void StealFrom(Thread* self, WorkStealingTask* source) {
+    WorkStealingMarkTask* victim = down_cast<WorkStealingMarkTask*>(source);
+    DCHECK_NE(victim, this);
+    const size_t count = std::min(victim->deque_.Size() / 2 + 1, kMaxStealCount);
+    size_t stolen = 0;
+    const Object* obj;
+    while (stolen < count && victim->deque_.Steal(&obj)) {
+      Push(obj);
+      ++stolen;
+    }
+    if (stolen != 0) {
+      ++steals_;
+      stolen_objects_ += stolen;
+    } else {
+      ++failed_steals_;
+    }
+  }
+
+  virtual void Finalize() {
+    // Deleted by ProcessMarkStackParallel once every task is done, since the other tasks may
+    // still be looking at our deque.
+  }
+
+  size_t GetScannedObjects() const {
+    return scanned_objects_;
+  }
+
+  size_t GetSteals() const {
+    return steals_;
+  }
+
+  size_t GetStolenObjects() const {
+    return stolen_objects_;
+  }
+
+  size_t GetFailedSteals() const {
+    return failed_steals_;
+  }
+
+ private:
+  // The mutators are suspended, so their roots can be visited from the GC threads.
+  void MarkRootThreads() NO_THREAD_SAFETY_ANALYSIS {
+    for (Thread* thread : root_threads_) {
+      thread->VisitRoots(MarkRootCallback, this);
+    }
+  }
+
+  static Object* MarkRootCallback(Object* root, void* arg) NO_THREAD_SAFETY_ANALYSIS {
+    DCHECK(root != NULL);
+    WorkStealingMarkTask* task = reinterpret_cast<WorkStealingMarkTask*>(arg);
+    if (task->mark_sweep_->MarkObjectParallel(root)) {
+      task->Push(root);
+    }
+    return root;
+  }
+
+  bool Pop(const Object** obj) ALWAYS_INLINE {
+    if (LIKELY(deque_.PopBottom(obj))) {
+      return true;
+    }
+    if (overflow_.empty()) {
+      return false;
+    }
+    // Move some of the overflowed objects back to the deque, where the other tasks can steal
+    // them.
+    const size_t count = std::min(overflow_.size(), kDequeSize / 2);
+    for (size_t i = 1; i < count; ++i) {
+      CHECK(deque_.PushBottom(overflow_.back()));
+      overflow_.pop_back();
+    }
+    *obj = overflow_.back();
+    overflow_.pop_back();
+    return true;
+  }
+
+  void ProcessLocalWork() NO_THREAD_SAFETY_ANALYSIS {
+    MarkSweep* mark_sweep = mark_sweep_;
+    const Object* obj;
+    while (Pop(&obj)) {
+      mark_sweep->ScanObjectVisit(obj,
+          [mark_sweep, this](const Object* /* obj */, const Object* ref,
+              const MemberOffset& /* offset */, bool /* is_static */) ALWAYS_INLINE {
+        if (ref != nullptr && mark_sweep->MarkObjectParallel(ref)) {
+          Push(ref);
+        }
+      });
+      ++scanned_objects_;
+    }
+  }
+
+  bool IsWorkAvailable() const {
+    for (WorkStealingMarkTask* task : *tasks_) {
+      if (task != this && !task->deque_.IsEmpty()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Returns true once there is work in our deque again, false once every task is out of work.
+  // A task only counts as active while it may push objects, so when there are no active tasks
+  // left the deques are empty for good.
+  bool StealWork(Thread* self) {
+    const size_t task_count = tasks_->size();
+    --*active_tasks_;
+    for (size_t attempt = 0; ; ++attempt) {
+      if (IsWorkAvailable()) {
+        ++*active_tasks_;
+        // Start with a different victim each time to spread the thieves out.
+        for (size_t i = 1; i < task_count; ++i) {
+          WorkStealingMarkTask* victim = (*tasks_)[(index_ + attempt + i) % task_count];
+          if (victim != this) {
+            StealFrom(self, victim);
+            if (!deque_.IsEmpty()) {
+              return true;
+            }
+          }
+        }
+        --*active_tasks_;
+      }
+      if (active_tasks_->load() == 0) {
+        return false;
+      }
+      if (attempt < kYieldCount) {
+        sched_yield();
+      } else {
+        NanoSleep(kSleepNs);
+      }
+    }
+  }
+
+  MarkSweep* const mark_sweep_;
+  const std::vector<WorkStealingMarkTask*>* const tasks_;
+  const size_t index_;
+  AtomicInteger* const active_tasks_;
+
+  accounting::WorkStealingDeque<const Object*, kDequeSize> deque_;
+  std::vector<const Object*> overflow_;
+  // The threads whose roots this task marks before it starts scanning.
+  std::vector<Thread*> root_threads_;
+
+  // Load balancing statistics.
+  size_t scanned_objects_;
+  size_t steals_;
+  size_t stolen_objects_;
+  size_t failed_steals_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingMarkTask);
+};
+
 void MarkSweep::ProcessMarkStackParallel(size_t thread_count) {
+  base::TimingLogger::ScopedSplit split("ProcessMarkStackParallel", &timings_);
   Thread* self = Thread::Current();
   ThreadPool* thread_pool = GetHeap()->GetThreadPool();
-  const size_t chunk_size = std::min(mark_stack_->Size() / thread_count + 1,
-                                     static_cast<size_t>(MarkStackTask<false>::kMaxSize));
-  CHECK_GT(chunk_size, 0U);
-  // Split the current mark stack up into work tasks.
+  // Every task counts as active until it first runs out of work, so that the tasks which are
+  // already running don't finish while the others still hold their share of the mark stack.
+  AtomicInteger active_tasks(thread_count);
+  std::vector<WorkStealingMarkTask*> tasks;
+  for (size_t i = 0; i < thread_count; ++i) {
+    tasks.push_back(new WorkStealingMarkTask(this, &tasks, i, &active_tasks));
+  }
+  // Split the current mark stack between the deques of the tasks.
+  const size_t chunk_size = mark_stack_->Size() / thread_count + 1;
+  size_t index = 0;
   for (mirror::Object **it = mark_stack_->Begin(), **end = mark_stack_->End(); it < end; ) {
     const size_t delta = std::min(static_cast<size_t>(end - it), chunk_size);
-    thread_pool->AddTask(self, new MarkStackTask<false>(thread_pool, this, delta,
-                                                        const_cast<const mirror::Object**>(it)));
-    it += delta;
+    for (mirror::Object** const chunk_end = it + delta; it < chunk_end; ++it) {
+      tasks[index]->Push(*it);
+    }
+    ++index;
+  }
+  // Deal out the threads whose roots still need marking.
+  for (size_t i = 0; i < root_threads_.size(); ++i) {
+    tasks[i % thread_count]->AddRootThread(root_threads_[i]);
   }
+  root_threads_.clear();
+  for (WorkStealingMarkTask* task : tasks) {
+    thread_pool->AddTask(self, task);
+  }
+  // There must be a thread for each task: the workers and us.
   thread_pool->SetMaxActiveWorkers(thread_count - 1);
   thread_pool->StartWorkers(self);
   thread_pool->Wait(self, true, true);
   thread_pool->StopWorkers(self);
   mark_stack_->Reset();
-  CHECK_EQ(work_chunks_created_, work_chunks_deleted_) << " some of the work chunks were leaked";
+
+  // How evenly the work was spread: the busiest task against the average of total / tasks.
+  size_t max_scanned = 0;
+  size_t total_scanned = 0;
+  size_t steals = 0;
+  size_t stolen_objects = 0;
+  size_t failed_steals = 0;
+  for (WorkStealingMarkTask* task : tasks) {
+    max_scanned = std::max(max_scanned, task->GetScannedObjects());
+    total_scanned += task->GetScannedObjects();
+    steals += task->GetSteals();
+    stolen_objects += task->GetStolenObjects();
+    failed_steals += task->GetFailedSteals();
+  }
+  STLDeleteElements(&tasks);
+  timings_.AddCounter("ParallelMarkTasks", thread_count);
+  timings_.AddCounter("ParallelMarkScannedObjects", total_scanned);
+  timings_.AddCounter("ParallelMarkBusiestTaskScannedObjects", max_scanned);
+  timings_.AddCounter("ParallelMarkSteals", steals);
+  timings_.AddCounter("ParallelMarkStolenObjects", stolen_objects);
+  timings_.AddCounter("ParallelMarkFailedSteals", failed_steals);
 }
 
 // Scan anything that's on the mark stack.
@@ -1425,9 +1917,13 @@ void MarkSweep::ProcessMarkStack(bool paused) {
   timings_.StartSplit("ProcessMarkStack");
   size_t thread_count = GetThreadCount(paused);
   if (kParallelProcessMarkStack && thread_count > 1 &&
-      mark_stack_->Size() >= kMinimumParallelMarkStackSize) {
+      (mark_stack_->Size() >= kMinimumParallelMarkStackSize || !root_threads_.empty())) {
     ProcessMarkStackParallel(thread_count);
   } else {
+    for (Thread* thread : root_threads_) {
+      thread->VisitRoots(MarkObjectCallback, this);
+    }
+    root_threads_.clear();
     // TODO: Tune this.
     static const size_t kFifoSize = 4;
     BoundedFifoPowerOfTwo<const Object*, kFifoSize> prefetch_fifo;
@@ -1602,8 +2098,8 @@ void MarkSweep::ProcessReferences(Object** soft_references, bool clear_soft,
 void MarkSweep::UnBindBitmaps() {
   base::TimingLogger::ScopedSplit split("UnBindBitmaps", &timings_);
   for (const auto& space : GetHeap()->GetContinuousSpaces()) {
-    if (space->IsDlMallocSpace()) {
-      space::DlMallocSpace* alloc_space = space->AsDlMallocSpace();
+    if (space->IsContinuousMemMapAllocSpace()) {
+      space::ContinuousMemMapAllocSpace* alloc_space = space->AsContinuousMemMapAllocSpace();
       if (alloc_space->temp_bitmap_.get() != NULL) {
         // At this point, the temp_bitmap holds our old mark bitmap.
         accounting::SpaceBitmap* new_bitmap = alloc_space->temp_bitmap_.release();
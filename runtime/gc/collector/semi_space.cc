@@ -0,0 +1,571 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "semi_space.h"
+
+#include <functional>
+#include <numeric>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/mutex-inl.h"
+#include "base/timing_logger.h"
+#include "gc/accounting/atomic_stack.h"
+#include "gc/accounting/card_table-inl.h"
+#include "gc/accounting/heap_bitmap.h"
+#include "gc/accounting/remembered_set.h"
+#include "gc/accounting/space_bitmap-inl.h"
+#include "gc/heap.h"
+#include "gc/space/bump_pointer_space-inl.h"
+#include "gc/space/large_object_space.h"
+#include "gc/space/malloc_space.h"
+#include "gc/space/space-inl.h"
+#include "intern_table.h"
+#include "jni_internal.h"
+#include "mark_sweep-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/object-inl.h"
+#include "monitor.h"
+#include "runtime.h"
+#include "thread-inl.h"
+#include "thread_list.h"
+
+using ::art::mirror::Class;
+using ::art::mirror::Object;
+
+namespace art {
+namespace gc {
+namespace collector {
+
+// Number of dead objects freed at a time when sweeping the malloc spaces.
+static constexpr size_t kSweepChunkFreeSize = 256;
+
+SemiSpace::SemiSpace(Heap* heap, bool minor)
+    : GarbageCollector(heap, minor ? "minor semi space" : "semi space"),
+      minor_(minor),
+      from_space_(NULL),
+      to_space_(NULL),
+      alloc_space_(NULL),
+      mark_stack_(NULL),
+      immune_begin_(NULL),
+      immune_end_(NULL),
+      move_objects_(false),
+      scan_(NULL),
+      freed_objects_(0),
+      freed_bytes_(0),
+      moved_objects_(0),
+      moved_bytes_(0),
+      promoted_objects_(0),
+      promoted_bytes_(0),
+      promotion_failed_(false),
+      freed_malloc_objects_(0),
+      freed_malloc_bytes_(0) {
+}
+
+void SemiSpace::InitializePhase() {
+  timings_.Reset();
+  base::TimingLogger::ScopedSplit split("InitializePhase", &timings_);
+  mark_stack_ = heap_->mark_stack_.get();
+  DCHECK(mark_stack_ != NULL);
+  from_space_ = heap_->bump_pointer_space_;
+  to_space_ = heap_->temp_space_;
+  alloc_space_ = heap_->alloc_space_;
+  CHECK(from_space_ != NULL && to_space_ != NULL);
+  CHECK_EQ(to_space_->Size(), 0U) << "To-space " << *to_space_ << " is not empty";
+  immune_begin_ = NULL;
+  immune_end_ = NULL;
+  for (const auto& space : heap_->GetContinuousSpaces()) {
+    if (space->IsImageSpace() || space->IsZygoteSpace()) {
+      Object* begin = reinterpret_cast<Object*>(space->Begin());
+      Object* end = reinterpret_cast<Object*>(space->End());
+      if (immune_begin_ == NULL || begin < immune_begin_) {
+        immune_begin_ = begin;
+      }
+      if (end > immune_end_) {
+        immune_end_ = end;
+      }
+    }
+  }
+  move_objects_ = true;
+  pinned_objects_.clear();
+  scan_ = to_space_->Begin();
+  freed_objects_ = 0;
+  freed_bytes_ = 0;
+  moved_objects_ = 0;
+  moved_bytes_ = 0;
+  promoted_objects_ = 0;
+  promoted_bytes_ = 0;
+  promotion_failed_ = false;
+  freed_malloc_objects_ = 0;
+  freed_malloc_bytes_ = 0;
+
+  timings_.NewSplit("PreGcVerification");
+  heap_->PreGcVerification(this);
+}
+
+bool SemiSpace::CanMoveObjects(Thread* self) {
+  MutexLock mu(self, *Locks::thread_list_lock_);
+  for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+    if (thread == self) {
+      continue;
+    }
+    // Runtime code may hold object pointers in any state, even native or suspended, so only a
+    // thread which stopped where its stack, SIRT and JNI references are all it refers to is safe.
+    const ThreadState state = thread->GetState();
+    if (state != kTerminated && (state == kRunnable || !thread->IsAtMovingGcSafePoint())) {
+      VLOG(heap) << "Not moving objects since " << *thread << " is in state " << state
+                 << " outside of a moving GC safe point";
+      return false;
+    }
+  }
+  return true;
+}
+
+Object* SemiSpace::PinRootCallback(Object* root, void* arg) {
+  reinterpret_cast<SemiSpace*>(arg)->pinned_objects_.insert(root);
+  return root;
+}
+
+void SemiSpace::PinObjects(Thread* self) {
+  {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+      Object* monitor_enter_object = thread->GetMonitorEnterObject();
+      if (monitor_enter_object != NULL) {
+        pinned_objects_.insert(monitor_enter_object);
+      }
+    }
+  }
+  JavaVMExt* vm = Runtime::Current()->GetJavaVM();
+  {
+    MutexLock mu(self, vm->pins_lock);
+    vm->pin_table.VisitRoots(PinRootCallback, this);
+  }
+  // The from-space is released as a whole, so nothing moves if one of its objects must stay.
+  for (const Object* obj : pinned_objects_) {
+    if (from_space_->Contains(obj)) {
+      VLOG(heap) << "Not moving objects since " << obj << " is pinned in " << *from_space_;
+      move_objects_ = false;
+      break;
+    }
+  }
+}
+
+void SemiSpace::MarkingPhase() {
+  base::TimingLogger::ScopedSplit split("MarkingPhase", &timings_);
+  Thread* self = Thread::Current();
+
+  timings_.NewSplit("PinObjects");
+  move_objects_ = CanMoveObjects(self);
+  PinObjects(self);
+  if (minor_) {
+    // Promotion must not fail half way, malloc overhead may make the copies larger.
+    if (move_objects_ &&
+        alloc_space_->Capacity() - alloc_space_->Size() < 2 * from_space_->Size()) {
+      VLOG(heap) << "Not promoting objects since " << *alloc_space_ << " is close to full";
+      move_objects_ = false;
+      promotion_failed_ = true;
+    }
+    // The nursery can only be emptied as a whole.
+    if (!move_objects_) {
+      return;
+    }
+  }
+
+  WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
+  // Everything allocated since the last GC needs to be in the live bitmaps for the sweep.
+  timings_.NewSplit("FlushAllocStack");
+  heap_->FlushAllocStack();
+  accounting::ObjectStack* live_stack = heap_->GetLiveStack();
+  heap_->MarkAllocStack(alloc_space_->GetLiveBitmap(),
+                        heap_->GetLargeObjectsSpace()->GetLiveObjects(), live_stack);
+  live_stack->Reset();
+
+  timings_.NewSplit("MarkRoots");
+  Runtime::Current()->VisitRoots(MarkRootCallback, this, false, true);
+
+  if (minor_) {
+    // The remembered sets hold all of the references from the other spaces into the nursery.
+    timings_.NewSplit("UpdateAndMarkRememberedSets");
+    for (const auto& space : heap_->GetContinuousSpaces()) {
+      accounting::RememberedSet* remembered_set = heap_->FindRememberedSetFromSpace(space);
+      if (remembered_set != NULL) {
+        remembered_set->RecordDirtyCards();
+        remembered_set->UpdateAndMarkReferences(MarkRootCallback, this, from_space_);
+      }
+    }
+  } else {
+    // Rather than relying on the mod-union tables, scan all of the image and zygote objects,
+    // their references to moved objects need updating.
+    timings_.NewSplit("ScanImmuneSpaces");
+    for (const auto& space : heap_->GetContinuousSpaces()) {
+      if (space->IsImageSpace() || space->IsZygoteSpace()) {
+        space->GetLiveBitmap()->VisitMarkedRange(reinterpret_cast<uintptr_t>(space->Begin()),
+                                                 reinterpret_cast<uintptr_t>(space->End()),
+                                                 [this](const Object* obj) {
+          ScanObject(const_cast<Object*>(obj));
+        });
+      }
+    }
+  }
+
+  timings_.NewSplit("ProcessMarkStack");
+  ProcessMarkStack();
+}
+
+Object* SemiSpace::MarkRootCallback(Object* root, void* arg) {
+  return reinterpret_cast<SemiSpace*>(arg)->MarkObject(root);
+}
+
+inline bool SemiSpace::ShouldMove(const Object* obj) const {
+  if (!move_objects_ || (!from_space_->Contains(obj) && !alloc_space_->Contains(obj)) ||
+      !Heap::IsMovableClass(obj->GetClass())) {
+    return false;
+  }
+  return pinned_objects_.empty() || pinned_objects_.find(obj) == pinned_objects_.end();
+}
+
+inline Object* SemiSpace::GetForwardingAddress(const Object* obj) {
+  // Copied objects have their lock word replaced by their new address.
+  return reinterpret_cast<Object*>(obj->GetField32(Object::MonitorOffset(), false));
+}
+
+inline void SemiSpace::PushOnMarkStack(Object* obj) {
+  if (UNLIKELY(mark_stack_->Size() >= mark_stack_->Capacity())) {
+    std::vector<Object*> temp(mark_stack_->Begin(), mark_stack_->End());
+    mark_stack_->Resize(mark_stack_->Capacity() * 2);
+    for (const auto& pushed : temp) {
+      mark_stack_->PushBack(pushed);
+    }
+  }
+  mark_stack_->PushBack(obj);
+}
+
+Object* SemiSpace::Copy(Object* obj) {
+  const size_t object_size = obj->SizeOf();
+  const uint32_t lock_word = obj->GetField32(Object::MonitorOffset(), false);
+  // An object whose identity hash code is its address takes the address along in an extra word.
+  // Objects which moved before already have the word, it is copied along with them.
+  const bool hashed = LW_HASH_STATE(lock_word) == LW_HASH_STATE_HASHED;
+  const size_t hash_code_offset = RoundUp(object_size, sizeof(int32_t));
+  const size_t copy_size = obj->SizeOfWithHashCode();
+  const size_t alloc_size = hashed ? hash_code_offset + sizeof(int32_t) : copy_size;
+  const bool in_from_space = from_space_->Contains(obj);
+  Object* forward = NULL;
+  size_t bytes_allocated = RoundUp(alloc_size, space::BumpPointerSpace::kAlignment);
+  // Objects of the alloc space may stay where they are, keep enough room in the to-space for the
+  // objects of the from-space which may not.
+  if (!minor_ && (in_from_space ||
+      to_space_->Size() + bytes_allocated + from_space_->Size() <= to_space_->Capacity())) {
+    forward = to_space_->AllocNonvirtual(alloc_size);
+  }
+  if (forward != NULL) {
+    to_space_->GetMarkBitmap()->Set(forward);
+  } else if (!in_from_space) {
+    return NULL;
+  } else if (minor_) {
+    // Promote the object. The alloc space isn't swept by minor collections, so the copy is live
+    // right away.
+    if (!promotion_failed_) {
+      forward = alloc_space_->AllocWithGrowth(Thread::Current(), alloc_size, &bytes_allocated);
+    }
+    if (LIKELY(forward != NULL)) {
+      alloc_space_->GetLiveBitmap()->Set(forward);
+      PushOnMarkStack(forward);
+      ++promoted_objects_;
+      promoted_bytes_ += bytes_allocated;
+    } else {
+      // The alloc space is full. The to-space is as large as the nursery, evacuate the rest of the
+      // nursery to it and leave making room in the alloc space to a full collection. The copies
+      // are scanned in address order like those of a major collection.
+      promotion_failed_ = true;
+      bytes_allocated = RoundUp(alloc_size, space::BumpPointerSpace::kAlignment);
+      forward = to_space_->AllocNonvirtual(alloc_size);
+      CHECK(forward != NULL) << "Failed to allocate " << PrettySize(alloc_size)
+                             << " for an object evacuated from " << *from_space_
+                             << " after promotion failed";
+      to_space_->GetLiveBitmap()->Set(forward);
+    }
+  } else {
+    // Only possible if objects grew by their hash code word. Pinning the copy keeps it from being
+    // treated as a from-space object, it is scanned through the mark stack.
+    forward = alloc_space_->Alloc(Thread::Current(), alloc_size, &bytes_allocated);
+    CHECK(forward != NULL) << "Failed to allocate " << PrettySize(alloc_size)
+                           << " for an object evacuated from " << *from_space_;
+    alloc_space_->GetMarkBitmap()->Set(forward);
+    pinned_objects_.insert(forward);
+    PushOnMarkStack(forward);
+    ++promoted_objects_;
+    promoted_bytes_ += bytes_allocated;
+  }
+  memcpy(forward, obj, copy_size);
+  if (hashed) {
+    byte* hash_code_address = reinterpret_cast<byte*>(forward) + hash_code_offset;
+    *reinterpret_cast<int32_t*>(hash_code_address) = reinterpret_cast<int32_t>(obj);
+    forward->SetField32(Object::MonitorOffset(),
+                        lock_word | (LW_HASH_STATE_HASHED_AND_MOVED << LW_HASH_STATE_SHIFT),
+                        false, false);
+  }
+  obj->SetField32(Object::MonitorOffset(), reinterpret_cast<uint32_t>(forward), false, false);
+  ++moved_objects_;
+  moved_bytes_ += bytes_allocated;
+  return forward;
+}
+
+Object* SemiSpace::MarkObject(Object* obj) {
+  if (obj == NULL || IsImmune(obj) || to_space_->Contains(obj)) {
+    return obj;
+  }
+  // Minor collections leave the objects outside of the nursery alone.
+  if (minor_ && !from_space_->Contains(obj)) {
+    return obj;
+  }
+  accounting::SpaceBitmap* mark_bitmap = heap_->GetMarkBitmap()->GetContinuousSpaceBitmap(obj);
+  if (UNLIKELY(mark_bitmap == NULL)) {
+    // Only primitive arrays are allocated in the large object space, there is nothing to scan.
+    space::LargeObjectSpace* large_object_space = heap_->GetLargeObjectsSpace();
+    DCHECK(large_object_space->GetLiveObjects()->Test(obj)) << "Object " << obj
+                                                            << " is not in any space";
+    large_object_space->GetMarkObjects()->Set(obj);
+    return obj;
+  }
+  if (mark_bitmap->Test(obj)) {
+    return ShouldMove(obj) ? GetForwardingAddress(obj) : obj;
+  }
+  mark_bitmap->Set(obj);
+  if (ShouldMove(obj)) {
+    Object* forward = Copy(obj);
+    if (forward != NULL) {
+      return forward;
+    }
+    // There is no room left in the to-space, leave the object where it is.
+    pinned_objects_.insert(obj);
+  }
+  PushOnMarkStack(obj);
+  return obj;
+}
+
+void SemiSpace::ScanObject(Object* obj) {
+  accounting::CardTable* card_table = heap_->GetCardTable();
+  MarkSweep::VisitObjectReferences(obj, [this, card_table](const Object* obj, const Object* ref,
+                                                           const MemberOffset& offset,
+                                                           bool /* is_static */) {
+    Object* new_ref = MarkObject(const_cast<Object*>(ref));
+    if (new_ref != ref) {
+      // No write barrier, but dirty the card so that the mod-union tables recompute the cached
+      // references of image and zygote objects.
+      const_cast<Object*>(obj)->SetField32(offset, reinterpret_cast<uint32_t>(new_ref), false,
+                                           false);
+      card_table->MarkCard(obj);
+    }
+  });
+  Class* klass = obj->GetClass();
+  if (UNLIKELY(klass->IsReferenceClass())) {
+    // The referent isn't among the reference offsets, treat it as a strong reference.
+    const MemberOffset referent_offset = heap_->reference_referent_offset_;
+    Object* referent = heap_->GetReferenceReferent(obj);
+    Object* new_referent = MarkObject(referent);
+    if (new_referent != referent) {
+      obj->SetField32(referent_offset, reinterpret_cast<uint32_t>(new_referent), false, false);
+      card_table->MarkCard(obj);
+    }
+  }
+}
+
+void SemiSpace::ProcessMarkStack() {
+  while (true) {
+    if (scan_ < to_space_->End()) {
+      Object* obj = reinterpret_cast<Object*>(scan_);
+      ScanObject(obj);
+      scan_ += to_space_->AllocationSizeNonvirtual(obj);
+    } else if (!mark_stack_->IsEmpty()) {
+      ScanObject(mark_stack_->PopBack());
+    } else {
+      break;
+    }
+  }
+}
+
+Object* SemiSpace::ForwardingAddressCallback(Object* obj, void* arg) {
+  SemiSpace* semi_space = reinterpret_cast<SemiSpace*>(arg);
+  if (semi_space->IsImmune(obj) ||
+      (semi_space->minor_ && !semi_space->from_space_->Contains(obj))) {
+    return obj;
+  }
+  accounting::SpaceBitmap* mark_bitmap =
+      semi_space->GetHeap()->GetMarkBitmap()->GetContinuousSpaceBitmap(obj);
+  if (mark_bitmap == NULL) {
+    return semi_space->GetHeap()->GetLargeObjectsSpace()->GetMarkObjects()->Test(obj) ? obj : NULL;
+  }
+  if (!mark_bitmap->Test(obj)) {
+    return NULL;
+  }
+  return semi_space->ShouldMove(obj) ? GetForwardingAddress(obj) : obj;
+}
+
+void SemiSpace::SweepSystemWeaks() {
+  timings_.NewSplit("SweepSystemWeaks");
+  Runtime* runtime = Runtime::Current();
+  runtime->GetInternTable()->SweepInternTableWeaks(ForwardingAddressCallback, this);
+  runtime->GetMonitorList()->SweepMonitorList(ForwardingAddressCallback, this);
+  runtime->GetJavaVM()->SweepWeakGlobals(ForwardingAddressCallback, this);
+}
+
+void SemiSpace::SweepMallocSpace(space::MallocSpace* space) {
+  accounting::SpaceBitmap* live_bitmap = space->GetLiveBitmap();
+  accounting::SpaceBitmap* mark_bitmap = space->GetMarkBitmap();
+  Thread* self = Thread::Current();
+  Object* chunk_free_buffer[kSweepChunkFreeSize];
+  size_t chunk_free_pos = 0;
+  size_t freed_objects = 0;
+  size_t freed_bytes = 0;
+  // Objects copied during marking aren't in the live bitmap yet, so they are not visited.
+  live_bitmap->VisitMarkedRange(reinterpret_cast<uintptr_t>(space->Begin()),
+                                reinterpret_cast<uintptr_t>(space->End()),
+                                [&](const Object* obj) {
+    if (mark_bitmap->Test(obj)) {
+      if (!ShouldMove(obj)) {
+        return;
+      }
+      // Only the forwarding address of the object is left here.
+      mark_bitmap->Clear(obj);
+    }
+    chunk_free_buffer[chunk_free_pos++] = const_cast<Object*>(obj);
+    if (chunk_free_pos == kSweepChunkFreeSize) {
+      freed_bytes += space->FreeList(self, chunk_free_pos, chunk_free_buffer);
+      freed_objects += chunk_free_pos;
+      chunk_free_pos = 0;
+    }
+  });
+  if (chunk_free_pos != 0) {
+    freed_bytes += space->FreeList(self, chunk_free_pos, chunk_free_buffer);
+    freed_objects += chunk_free_pos;
+  }
+  freed_malloc_objects_ += freed_objects;
+  freed_malloc_bytes_ += freed_bytes;
+}
+
+void SemiSpace::SweepLargeObjects() {
+  space::LargeObjectSpace* large_object_space = heap_->GetLargeObjectsSpace();
+  accounting::SpaceSetMap* large_live_objects = large_object_space->GetLiveObjects();
+  accounting::SpaceSetMap* large_mark_objects = large_object_space->GetMarkObjects();
+  Thread* self = Thread::Current();
+  for (const Object* obj : large_live_objects->GetObjects()) {
+    if (!large_mark_objects->Test(obj)) {
+      freed_malloc_bytes_ += large_object_space->Free(self, const_cast<Object*>(obj));
+      ++freed_malloc_objects_;
+    }
+  }
+}
+
+void SemiSpace::ReclaimPhase() {
+  base::TimingLogger::ScopedSplit split("ReclaimPhase", &timings_);
+  if (minor_ && !move_objects_) {
+    // Nothing was marked.
+    return;
+  }
+  Thread* self = Thread::Current();
+  WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
+  // Needs the mark bits of the moved objects, which the sweep clears.
+  SweepSystemWeaks();
+
+  // Minor collections don't mark the objects outside of the nursery, there is nothing to sweep.
+  if (!minor_) {
+    timings_.NewSplit("SweepMallocSpaces");
+    for (const auto& space : heap_->GetContinuousSpaces()) {
+      if (space->IsMallocSpace() &&
+          space->GetGcRetentionPolicy() == space::kGcRetentionPolicyAlwaysCollect) {
+        SweepMallocSpace(space->AsMallocSpace());
+      }
+    }
+    timings_.NewSplit("SweepLargeObjects");
+    SweepLargeObjects();
+  }
+
+  size_t freed_objects = freed_malloc_objects_;
+  size_t freed_bytes = freed_malloc_bytes_;
+  if (move_objects_) {
+    // Every reachable object of the from-space was copied.
+    timings_.NewSplit("ClearFromSpace");
+    freed_objects += from_space_->GetObjectsAllocated();
+    freed_bytes += from_space_->Size();
+    from_space_->Clear();
+  }
+
+  if (!minor_) {
+    timings_.NewSplit("SwapBitmaps");
+    SwapBitmaps();
+    if (move_objects_) {
+      // Allocation continues in the space the objects were copied to.
+      std::swap(heap_->bump_pointer_space_, heap_->temp_space_);
+    }
+  } else if (promotion_failed_) {
+    // The objects which could not be promoted are live in the to-space, it is the new nursery.
+    std::swap(heap_->bump_pointer_space_, heap_->temp_space_);
+  }
+
+  // The copies are new allocations, only account for the difference.
+  DCHECK_GE(freed_objects, moved_objects_);
+  freed_objects_ = freed_objects - moved_objects_;
+  if (LIKELY(freed_bytes >= moved_bytes_)) {
+    freed_bytes_ = freed_bytes - moved_bytes_;
+    heap_->RecordFree(freed_objects_, freed_bytes_);
+  } else {
+    // The hash code words of the moved objects took more than the garbage freed.
+    freed_bytes_ = 0;
+    heap_->RecordFree(freed_objects_, 0);
+    heap_->num_bytes_allocated_.fetch_add(moved_bytes_ - freed_bytes);
+  }
+}
+
+void SemiSpace::FinishPhase() {
+  base::TimingLogger::ScopedSplit split("FinishPhase", &timings_);
+  timings_.NewSplit("GrowForUtilization");
+  heap_->GrowForUtilization(GetGcType(), GetDurationNs());
+
+  // Update the cumulative statistics.
+  total_time_ns_ += GetDurationNs();
+  total_paused_time_ns_ += std::accumulate(GetPauseTimes().begin(), GetPauseTimes().end(), 0,
+                                           std::plus<uint64_t>());
+  total_freed_objects_ += freed_objects_;
+  total_freed_bytes_ += freed_bytes_;
+
+  // Ensure that the mark stack is empty.
+  CHECK(mark_stack_->IsEmpty());
+  pinned_objects_.clear();
+
+  // Update the cumulative loggers.
+  cumulative_timings_.Start();
+  cumulative_timings_.AddLogger(timings_);
+  cumulative_timings_.End();
+
+  mark_stack_->Reset();
+  // Minor collections only mark in the nursery, whose mark bitmap was cleared with it.
+  if (minor_) {
+    return;
+  }
+  // Clear all of the spaces' mark bitmaps.
+  for (const auto& space : heap_->GetContinuousSpaces()) {
+    if (space->GetGcRetentionPolicy() != space::kGcRetentionPolicyNeverCollect) {
+      space->GetMarkBitmap()->Clear();
+    }
+  }
+  heap_->GetLargeObjectsSpace()->GetMarkObjects()->Clear();
+}
+
+}  // namespace collector
+}  // namespace gc
+}  // namespace art
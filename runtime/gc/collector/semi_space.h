@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_COLLECTOR_SEMI_SPACE_H_
+#define ART_RUNTIME_GC_COLLECTOR_SEMI_SPACE_H_
+
+#include <set>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "garbage_collector.h"
+#include "offsets.h"
+#include "root_visitor.h"
+
+namespace art {
+
+namespace mirror {
+  class Object;
+}  // namespace mirror
+
+class Thread;
+
+namespace gc {
+
+namespace accounting {
+  template <typename T> class AtomicStack;
+  typedef AtomicStack<mirror::Object*> ObjectStack;
+}  // namespace accounting
+
+namespace space {
+  class BumpPointerSpace;
+  class MallocSpace;
+}  // namespace space
+
+class Heap;
+
+namespace collector {
+
+// A stop-the-world copying collector which evacuates the reachable objects of the bump pointer
+// space and the alloc space into the empty bump pointer space, updating every reference to them.
+// Objects which can't be moved safely are marked in place, so it also sweeps the malloc spaces.
+// References are treated as strong, they are processed by the next mark sweep collection.
+//
+// A minor collection only evacuates the bump pointer space, used as a nursery, promoting the
+// objects which survive into the alloc space. It finds the references into the nursery through
+// the roots and the remembered sets of the other spaces, so its cost depends on the live nursery
+// objects and the dirty cards rather than on the size of the heap.
+class SemiSpace : public GarbageCollector {
+ public:
+  SemiSpace(Heap* heap, bool minor);
+  ~SemiSpace() {}
+
+  virtual bool IsConcurrent() const {
+    return false;
+  }
+
+  virtual GcType GetGcType() const {
+    return minor_ ? kGcTypeSticky : kGcTypePartial;
+  }
+
+  virtual void InitializePhase();
+  virtual void MarkingPhase()
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
+      LOCKS_EXCLUDED(Locks::heap_bitmap_lock_);
+  virtual void ReclaimPhase()
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
+      LOCKS_EXCLUDED(Locks::heap_bitmap_lock_);
+  virtual void FinishPhase();
+
+  bool IsMinor() const {
+    return minor_;
+  }
+
+  // Net number of objects and bytes freed, that is without the copies of the moved objects.
+  size_t GetFreedObjects() const {
+    return freed_objects_;
+  }
+
+  size_t GetFreedBytes() const {
+    return freed_bytes_;
+  }
+
+  size_t GetMovedObjects() const {
+    return moved_objects_;
+  }
+
+  size_t GetMovedBytes() const {
+    return moved_bytes_;
+  }
+
+  // Whether the last minor collection ran out of room in the alloc space, in which case a full
+  // collection should follow.
+  bool PromotionFailed() const {
+    return promotion_failed_;
+  }
+
+ private:
+  // Marks obj and returns its new address, copying it to the to-space if it should move and was
+  // not copied yet.
+  mirror::Object* MarkObject(mirror::Object* obj)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+
+  static mirror::Object* MarkRootCallback(mirror::Object* root, void* arg)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+
+  // Returns the new address of a marked object, or NULL for an object which is not reachable.
+  static mirror::Object* ForwardingAddressCallback(mirror::Object* obj, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+
+  static mirror::Object* PinRootCallback(mirror::Object* root, void* arg);
+
+  // Whether a reachable obj is moved by this collection.
+  bool ShouldMove(const mirror::Object* obj) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Copies obj to the to-space, or to the alloc space if the to-space is full and obj is in the
+  // bump pointer space. Minor collections copy to the alloc space, and to the to-space once the
+  // alloc space is full. Returns NULL if obj can't be copied.
+  mirror::Object* Copy(mirror::Object* obj)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+
+  // Returns the address obj was copied to.
+  static mirror::Object* GetForwardingAddress(const mirror::Object* obj)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  bool IsImmune(const mirror::Object* obj) const {
+    return obj >= immune_begin_ && obj < immune_end_;
+  }
+
+  // Moving objects is only safe if no thread is in the middle of runtime code which holds object
+  // pointers the collector doesn't know of.
+  bool CanMoveObjects(Thread* self) LOCKS_EXCLUDED(Locks::thread_list_lock_);
+
+  // Collects the objects which must stay where they are: the objects pinned by JNI and the
+  // objects threads are blocked on trying to lock.
+  void PinObjects(Thread* self)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_);
+
+  // Updates the references of obj, marking the objects they refer to.
+  void ScanObject(mirror::Object* obj)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+
+  // Scans the copied objects in address order and the objects on the mark stack until there are
+  // no unscanned objects left.
+  void ProcessMarkStack()
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+
+  void PushOnMarkStack(mirror::Object* obj);
+
+  // Frees the objects of the malloc spaces which are unmarked or were moved.
+  void SweepMallocSpace(space::MallocSpace* space)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+
+  void SweepLargeObjects()
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+
+  void SweepSystemWeaks()
+      SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+
+  // Whether this collects the nursery only.
+  const bool minor_;
+
+  // The space the collection evacuates, and the empty space objects are copied to.
+  space::BumpPointerSpace* from_space_;
+  space::BumpPointerSpace* to_space_;
+
+  // The alloc space is evacuated too, unless there is no room left in the to-space. Minor
+  // collections promote the objects of the nursery to it instead.
+  space::MallocSpace* alloc_space_;
+
+  accounting::ObjectStack* mark_stack_;
+
+  // Objects in the image and zygote spaces are never moved or freed.
+  mirror::Object* immune_begin_;
+  mirror::Object* immune_end_;
+
+  // False if some thread may hold object pointers the collector can't update, in which case
+  // nothing moves and the collection degrades to a full mark sweep of the malloc spaces.
+  bool move_objects_;
+
+  // Objects which must not move.
+  std::set<const mirror::Object*> pinned_objects_;
+
+  // The next copied object to scan.
+  byte* scan_;
+
+  size_t freed_objects_;
+  size_t freed_bytes_;
+  size_t moved_objects_;
+  size_t moved_bytes_;
+
+  // Objects and bytes which were copied to the alloc space rather than the to-space.
+  size_t promoted_objects_;
+  size_t promoted_bytes_;
+
+  // Set by a minor collection which could not promote every object. The objects left are
+  // evacuated to the to-space, which becomes the nursery.
+  bool promotion_failed_;
+
+  // Objects and bytes freed from the malloc spaces and the large object space.
+  size_t freed_malloc_objects_;
+  size_t freed_malloc_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(SemiSpace);
+};
+
+}  // namespace collector
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_COLLECTOR_SEMI_SPACE_H_
@@ -31,13 +31,17 @@
 #include "gc/accounting/card_table-inl.h"
 #include "gc/accounting/heap_bitmap-inl.h"
 #include "gc/accounting/mod_union_table-inl.h"
+#include "gc/accounting/remembered_set.h"
 #include "gc/accounting/space_bitmap-inl.h"
 #include "gc/collector/mark_sweep-inl.h"
 #include "gc/collector/partial_mark_sweep.h"
+#include "gc/collector/semi_space.h"
 #include "gc/collector/sticky_mark_sweep.h"
+#include "gc/space/bump_pointer_space-inl.h"
 #include "gc/space/dlmalloc_space-inl.h"
 #include "gc/space/image_space.h"
 #include "gc/space/large_object_space.h"
+#include "gc/space/rosalloc_space-inl.h"
 #include "gc/space/space-inl.h"
 #include "image.h"
 #include "invoke_arg_array_builder.h"
@@ -65,13 +69,45 @@ static constexpr bool kDumpGcPerformanceOnShutdown = false;
 static constexpr size_t kMinConcurrentRemainingBytes = 128 * KB;
 // If true, measure the total allocation time.
 static constexpr bool kMeasureAllocationTime = false;
+// If true, small allocations are served from per-thread caches of alloc space chunks which are
+// refilled in batches, see Heap::AllocateThreadLocal.
+static constexpr bool kUseThreadLocalAllocCache = true;
+// Granularity of the thread-local allocation cache size brackets.
+static constexpr size_t kThreadLocalAllocBracketSize = 8;
+// Largest allocation served from the thread-local allocation cache.
+static constexpr size_t kMaxThreadLocalAllocSize =
+    kThreadLocalAllocBracketSize * Thread::kNumThreadLocalAllocBrackets;
+// Number of bytes taken from the alloc space per thread-local allocation cache refill.
+static constexpr size_t kThreadLocalAllocRefillBytes = KB;
+static constexpr size_t kMaxThreadLocalAllocRefillCount =
+    kThreadLocalAllocRefillBytes / kThreadLocalAllocBracketSize;
+// Number of allocation stack slots a thread reserves at a time.
+static constexpr size_t kThreadLocalAllocStackSlots = 128;
+// Capacity of the space holding the objects compaction may not move.
+static constexpr size_t kNonMovingSpaceCapacity = 32 * MB;
+// Capacity of each of the two bump pointer spaces used by compaction.
+static constexpr size_t kBumpPointerSpaceCapacity = 16 * MB;
+// Minimum time between two compactions.
+static constexpr uint64_t kMinCompactionIntervalMs = 10 * 1000;
+// Compact when the alloc space utilization drops below these, depending on whether or not the
+// process currently cares about pause times.
+static constexpr float kBackgroundCompactionUtilization = 0.75f;
+static constexpr float kForegroundCompactionUtilization = 0.25f;
+// Don't bother compacting an alloc space smaller than this.
+static constexpr size_t kMinCompactionAllocSpaceSize = 1 * MB;
+// Request a nursery collection once this fraction of the free nursery space is allocated.
+static constexpr float kNurseryCollectionStartFraction = 0.75f;
 
 Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max_free,
            double target_utilization, size_t capacity, const std::string& original_image_file_name,
            bool concurrent_gc, size_t parallel_gc_threads, size_t conc_gc_threads,
            bool low_memory_mode, size_t long_pause_log_threshold, size_t long_gc_log_threshold,
-           bool ignore_max_footprint)
+           bool ignore_max_footprint, bool use_rosalloc, bool background_compaction,
+           bool nursery_collection, ModUnionTableKind image_mod_union_table_kind)
     : alloc_space_(NULL),
+      non_moving_space_(NULL),
+      bump_pointer_space_(NULL),
+      temp_space_(NULL),
       card_table_(NULL),
       concurrent_gc_(concurrent_gc),
       parallel_gc_threads_(parallel_gc_threads),
@@ -80,6 +116,15 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
       long_pause_log_threshold_(long_pause_log_threshold),
       long_gc_log_threshold_(long_gc_log_threshold),
       ignore_max_footprint_(ignore_max_footprint),
+      use_rosalloc_(use_rosalloc),
+      // The nursery is the bump pointer space used by compaction.
+      background_compaction_(background_compaction || nursery_collection),
+      compaction_spaces_begin_(NULL),
+      last_compaction_time_ms_(0),
+      bump_pointer_space_size_after_compaction_(0),
+      nursery_collection_(nursery_collection && concurrent_gc),
+      nursery_collection_start_bytes_(std::numeric_limits<size_t>::max()),
+      nursery_collection_pending_(0),
       have_zygote_space_(false),
       soft_ref_queue_lock_(NULL),
       weak_ref_queue_lock_(NULL),
@@ -88,6 +133,8 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
       is_gc_running_(false),
       last_gc_type_(collector::kGcTypeNone),
       next_gc_type_(collector::kGcTypePartial),
+      semi_space_collector_(NULL),
+      minor_collector_(NULL),
       capacity_(capacity),
       growth_limit_(growth_limit),
       max_allowed_footprint_(initial_size),
@@ -162,14 +209,29 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
     }
   }
 
-  alloc_space_ = space::DlMallocSpace::Create(Runtime::Current()->IsZygote() ? "zygote space" : "alloc space",
-                                              initial_size,
-                                              growth_limit, capacity,
-                                              requested_alloc_space_begin);
+  const char* alloc_space_name = Runtime::Current()->IsZygote() ? "zygote space" : "alloc space";
+  if (use_rosalloc_) {
+    alloc_space_ = space::RosAllocSpace::Create(alloc_space_name, initial_size, growth_limit,
+                                                capacity, requested_alloc_space_begin);
+  } else {
+    alloc_space_ = space::DlMallocSpace::Create(alloc_space_name, initial_size, growth_limit,
+                                                capacity, requested_alloc_space_begin);
+  }
   CHECK(alloc_space_ != NULL) << "Failed to create alloc space";
   alloc_space_->SetFootprintLimit(alloc_space_->Capacity());
   AddContinuousSpace(alloc_space_);
 
+  // The spaces used by compaction follow the whole reservation of the alloc space. The zygote
+  // never compacts, its children create the spaces when the zygote space is split off.
+  if (background_compaction_) {
+    compaction_spaces_begin_ =
+        reinterpret_cast<byte*>(RoundUp(reinterpret_cast<uintptr_t>(alloc_space_->Begin()) +
+                                        alloc_space_->NonGrowthLimitCapacity(), kPageSize));
+    if (!Runtime::Current()->IsZygote()) {
+      CreateCompactionSpaces();
+    }
+  }
+
   // Allocate the large object space.
   const bool kUseFreeListSpaceForLOS = false;
   if (kUseFreeListSpaceForLOS) {
@@ -183,15 +245,30 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
   // Compute heap capacity. Continuous spaces are sorted in order of Begin().
   byte* heap_begin = continuous_spaces_.front()->Begin();
   size_t heap_capacity = continuous_spaces_.back()->End() - continuous_spaces_.front()->Begin();
-  if (continuous_spaces_.back()->IsDlMallocSpace()) {
-    heap_capacity += continuous_spaces_.back()->AsDlMallocSpace()->NonGrowthLimitCapacity();
+  if (continuous_spaces_.back()->IsMallocSpace()) {
+    heap_capacity += continuous_spaces_.back()->AsMallocSpace()->NonGrowthLimitCapacity();
+  }
+  if (background_compaction_) {
+    // Cover the compaction spaces even if they are only created after the zygote fork.
+    heap_capacity = compaction_spaces_begin_ + kNonMovingSpaceCapacity +
+        2 * kBumpPointerSpaceCapacity - heap_begin;
   }
 
   // Allocate the card table.
   card_table_.reset(accounting::CardTable::Create(heap_begin, heap_capacity));
   CHECK(card_table_.get() != NULL) << "Failed to create card table";
 
-  image_mod_union_table_.reset(new accounting::ModUnionTableToZygoteAllocspace(this));
+  switch (image_mod_union_table_kind) {
+    case kModUnionTableReferenceCache:
+      image_mod_union_table_.reset(new accounting::ModUnionTableToZygoteAllocspace(this));
+      break;
+    case kModUnionTableCompactReferenceCache:
+      image_mod_union_table_.reset(new accounting::ModUnionTableCompactToZygoteAllocspace(this));
+      break;
+    case kModUnionTableCardCache:
+      image_mod_union_table_.reset(new accounting::ModUnionTableCardCache(this));
+      break;
+  }
   CHECK(image_mod_union_table_.get() != NULL) << "Failed to create image mod-union table";
 
   zygote_mod_union_table_.reset(new accounting::ModUnionTableCardCache(this));
@@ -236,6 +313,8 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
     mark_sweep_collectors_.push_back(new collector::PartialMarkSweep(this, concurrent));
     mark_sweep_collectors_.push_back(new collector::StickyMarkSweep(this, concurrent));
   }
+  semi_space_collector_ = new collector::SemiSpace(this, false);
+  minor_collector_ = new collector::SemiSpace(this, true);
 
   CHECK_NE(max_allowed_footprint_, 0U);
   if (VLOG_IS_ON(heap) || VLOG_IS_ON(startup)) {
@@ -372,6 +451,71 @@ void Heap::ListenForProcessStateChange() {
   }
 }
 
+void Heap::CreateCompactionSpaces() {
+  DCHECK(background_compaction_);
+  DCHECK(non_moving_space_ == NULL);
+  // The spaces are laid out back to back after the alloc space reservation, in the range the card
+  // table was sized to cover.
+  byte* non_moving_begin = compaction_spaces_begin_;
+  byte* bump_pointer_begin = non_moving_begin + kNonMovingSpaceCapacity;
+  byte* temp_begin = bump_pointer_begin + kBumpPointerSpaceCapacity;
+  space::MallocSpace* non_moving_space;
+  if (use_rosalloc_) {
+    non_moving_space = space::RosAllocSpace::Create("non moving space", MB,
+                                                    kNonMovingSpaceCapacity,
+                                                    kNonMovingSpaceCapacity, non_moving_begin);
+  } else {
+    non_moving_space = space::DlMallocSpace::Create("non moving space", MB,
+                                                    kNonMovingSpaceCapacity,
+                                                    kNonMovingSpaceCapacity, non_moving_begin);
+  }
+  space::BumpPointerSpace* bump_pointer_space =
+      space::BumpPointerSpace::Create("bump pointer space", kBumpPointerSpaceCapacity,
+                                      bump_pointer_begin);
+  space::BumpPointerSpace* temp_space =
+      space::BumpPointerSpace::Create("bump pointer space 2", kBumpPointerSpaceCapacity,
+                                      temp_begin);
+  if (non_moving_space == NULL || non_moving_space->Begin() != non_moving_begin ||
+      bump_pointer_space == NULL || bump_pointer_space->Begin() != bump_pointer_begin ||
+      temp_space == NULL || temp_space->Begin() != temp_begin) {
+    LOG(WARNING) << "Failed to map the compaction spaces at "
+                 << reinterpret_cast<void*>(compaction_spaces_begin_)
+                 << ", background compaction is disabled";
+    delete non_moving_space;
+    delete bump_pointer_space;
+    delete temp_space;
+    background_compaction_ = false;
+    return;
+  }
+  non_moving_space->SetFootprintLimit(non_moving_space->Capacity());
+  non_moving_space_ = non_moving_space;
+  bump_pointer_space_ = bump_pointer_space;
+  temp_space_ = temp_space;
+  AddContinuousSpace(non_moving_space_);
+  AddContinuousSpace(bump_pointer_space_);
+  AddContinuousSpace(temp_space_);
+  last_compaction_time_ms_ = MilliTime();
+  if (nursery_collection_) {
+    // Every space but the two bump pointer spaces holds old objects, the large object space only
+    // holds primitive arrays.
+    for (const auto& space : continuous_spaces_) {
+      if (!space->IsBumpPointerSpace()) {
+        remembered_sets_.Put(space, new accounting::RememberedSet(
+            std::string(space->GetName()) + " remembered set", this, space));
+      }
+    }
+    UpdateNurseryCollectionStartBytes();
+  }
+}
+
+accounting::RememberedSet* Heap::FindRememberedSetFromSpace(space::Space* space) {
+  auto it = remembered_sets_.find(space);
+  if (it == remembered_sets_.end()) {
+    return NULL;
+  }
+  return it->second;
+}
+
 void Heap::AddContinuousSpace(space::ContinuousSpace* space) {
   WriterMutexLock mu(Thread::Current(), *Locks::heap_bitmap_lock_);
   DCHECK(space != NULL);
@@ -380,9 +524,6 @@ void Heap::AddContinuousSpace(space::ContinuousSpace* space) {
   DCHECK(space->GetMarkBitmap() != NULL);
   mark_bitmap_->AddContinuousSpaceBitmap(space->GetMarkBitmap());
   continuous_spaces_.push_back(space);
-  if (space->IsDlMallocSpace() && !space->IsLargeObjectSpace()) {
-    alloc_space_ = space->AsDlMallocSpace();
-  }
 
   // Ensure that spaces remain sorted in increasing order of start address (required for CMS finger)
   std::sort(continuous_spaces_.begin(), continuous_spaces_.end(),
@@ -400,7 +541,7 @@ void Heap::AddContinuousSpace(space::ContinuousSpace* space) {
     } else if (space->IsZygoteSpace()) {
       DCHECK(!seen_alloc);
       seen_zygote = true;
-    } else if (space->IsDlMallocSpace()) {
+    } else if (space->IsMallocSpace()) {
       seen_alloc = true;
     }
   }
@@ -435,7 +576,11 @@ void Heap::DumpGcPerformanceInfo(std::ostream& os) {
 
   // Dump cumulative loggers for each GC type.
   uint64_t total_paused_time = 0;
-  for (const auto& collector : mark_sweep_collectors_) {
+  std::vector<collector::GarbageCollector*> collectors(mark_sweep_collectors_.begin(),
+                                                       mark_sweep_collectors_.end());
+  collectors.push_back(semi_space_collector_);
+  collectors.push_back(minor_collector_);
+  for (const auto& collector : collectors) {
     CumulativeLogger& logger = collector->GetCumulativeTimings();
     if (logger.GetTotalNs() != 0) {
       os << Dumpable<CumulativeLogger>(logger);
@@ -450,6 +595,7 @@ void Heap::DumpGcPerformanceInfo(std::ostream& os) {
          << " objects with total size " << PrettySize(freed_bytes) << "\n"
          << collector->GetName() << " throughput: " << freed_objects / seconds << "/s / "
          << PrettySize(freed_bytes / seconds) << "/s\n";
+      collector->DumpSweepThroughput(os);
       total_duration += total_ns;
       total_paused_time += total_pause_ns;
     }
@@ -474,7 +620,11 @@ void Heap::DumpGcPerformanceInfo(std::ostream& os) {
   }
   os << "Total mutator paused time: " << PrettyDuration(total_paused_time) << "\n";
   os << "Total time waiting for GC to complete: " << PrettyDuration(total_wait_time_) << "\n";
-  os << "Approximate GC data structures memory overhead: " << gc_memory_overhead_;
+  os << "Approximate GC data structures memory overhead: " << gc_memory_overhead_ << "\n";
+  os << "Image mod-union table (" << image_mod_union_table_->GetName() << ") memory usage: "
+     << PrettySize(image_mod_union_table_->GetMemoryUsage()) << "\n";
+  os << "Zygote mod-union table (" << zygote_mod_union_table_->GetName() << ") memory usage: "
+     << PrettySize(zygote_mod_union_table_->GetMemoryUsage());
 }
 
 Heap::~Heap() {
@@ -483,6 +633,9 @@ Heap::~Heap() {
   }
 
   STLDeleteElements(&mark_sweep_collectors_);
+  delete semi_space_collector_;
+  delete minor_collector_;
+  STLDeleteValues(&remembered_sets_);
 
   // If we don't reset then the mark stack complains in it's destructor.
   allocation_stack_->Reset();
@@ -554,7 +707,27 @@ static void MSpaceChunkCallback(void* start, void* end, size_t used_bytes, void*
   }
 }
 
+bool Heap::IsMovableClass(const mirror::Class* klass) {
+  // Classes, methods and fields are referenced by address from native code and compiled code.
+  return klass != NULL && !klass->IsClassClass() && !klass->IsArtMethodClass() &&
+      !klass->IsArtFieldClass();
+}
+
+bool Heap::IsMovableObject(const mirror::Object* obj) const {
+  return IsCompactionEnabled() && (bump_pointer_space_->Contains(obj) ||
+                                   alloc_space_->Contains(obj));
+}
+
 mirror::Object* Heap::AllocObject(Thread* self, mirror::Class* c, size_t byte_count) {
+  return AllocObjectInternal(self, c, byte_count, IsMovableClass(c));
+}
+
+mirror::Object* Heap::AllocNonMovableObject(Thread* self, mirror::Class* c, size_t byte_count) {
+  return AllocObjectInternal(self, c, byte_count, false);
+}
+
+mirror::Object* Heap::AllocObjectInternal(Thread* self, mirror::Class* c, size_t byte_count,
+                                          bool movable) {
   DCHECK(c == NULL || (c->IsClassClass() && byte_count >= sizeof(mirror::Class)) ||
          (c->IsVariableSize() || c->GetObjectSize() == byte_count) ||
          strlen(ClassHelper(c).GetDescriptor()) == 0);
@@ -562,6 +735,7 @@ mirror::Object* Heap::AllocObject(Thread* self, mirror::Class* c, size_t byte_co
 
   mirror::Object* obj = NULL;
   size_t bytes_allocated = 0;
+  bool thread_local_allocation = false;
   uint64_t allocation_start = 0;
   if (UNLIKELY(kMeasureAllocationTime)) {
     allocation_start = NanoTime() / kTimeAdjust;
@@ -580,8 +754,25 @@ mirror::Object* Heap::AllocObject(Thread* self, mirror::Class* c, size_t byte_co
     DCHECK(obj == NULL ||
            reinterpret_cast<byte*>(obj) < continuous_spaces_.front()->Begin() ||
            reinterpret_cast<byte*>(obj) >= continuous_spaces_.back()->End());
+  } else if (non_moving_space_ != NULL && !movable) {
+    obj = Allocate(self, non_moving_space_, byte_count, &bytes_allocated);
   } else {
-    obj = Allocate(self, alloc_space_, byte_count, &bytes_allocated);
+    if (bump_pointer_space_ != NULL && !IsOutOfMemoryOnAllocation(byte_count, false)) {
+      // Movable objects are bump allocated until the bump pointer space is full, the next
+      // compaction evacuates them.
+      obj = bump_pointer_space_->AllocNonvirtual(byte_count);
+      if (obj != NULL) {
+        bytes_allocated = RoundUp(byte_count, space::BumpPointerSpace::kAlignment);
+      }
+    }
+    if (obj == NULL) {
+      obj = AllocateThreadLocal(self, byte_count);
+      if (LIKELY(obj != NULL)) {
+        thread_local_allocation = true;
+      } else {
+        obj = Allocate(self, alloc_space_, byte_count, &bytes_allocated);
+      }
+    }
     // Ensure that we did not allocate into a zygote space.
     DCHECK(obj == NULL || !have_zygote_space_ || !FindSpaceFromObject(obj, false)->IsZygoteSpace());
   }
@@ -589,9 +780,26 @@ mirror::Object* Heap::AllocObject(Thread* self, mirror::Class* c, size_t byte_co
   if (LIKELY(obj != NULL)) {
     obj->SetClass(c);
 
-    // Record allocation after since we want to use the atomic add for the atomic fence to guard
-    // the SetClass since we do not want the class to appear NULL in another thread.
-    RecordAllocation(bytes_allocated, obj);
+    if (thread_local_allocation) {
+      // The bytes were already accounted for when the cache was refilled. Fence so that the class
+      // does not appear NULL in another thread.
+      ANDROID_MEMBAR_STORE();
+      bool pushed = self->PushOnThreadLocalAllocationStack(obj);
+      DCHECK(pushed);
+      if (Runtime::Current()->HasStatsEnabled()) {
+        size_t size = down_cast<space::DlMallocSpace*>(alloc_space_)->AllocationSizeNonvirtual(obj);
+        RuntimeStats* thread_stats = self->GetStats();
+        ++thread_stats->allocated_objects;
+        thread_stats->allocated_bytes += size;
+        RuntimeStats* global_stats = Runtime::Current()->GetStats();
+        ++global_stats->allocated_objects;
+        global_stats->allocated_bytes += size;
+      }
+    } else {
+      // Record allocation after since we want to use the atomic add for the atomic fence to guard
+      // the SetClass since we do not want the class to appear NULL in another thread.
+      RecordAllocation(bytes_allocated, obj);
+    }
 
     if (Dbg::IsAllocTrackingEnabled()) {
       Dbg::RecordAllocation(c, byte_count);
@@ -600,6 +808,11 @@ mirror::Object* Heap::AllocObject(Thread* self, mirror::Class* c, size_t byte_co
       // The SirtRef is necessary since the calls in RequestConcurrentGC are a safepoint.
       SirtRef<mirror::Object> ref(self, obj);
       RequestConcurrentGC(self);
+    } else if (UNLIKELY(bump_pointer_space_ != NULL && bump_pointer_space_->Contains(obj) &&
+                        bump_pointer_space_->Size() >= nursery_collection_start_bytes_)) {
+      // The SirtRef is necessary since the calls in RequestNurseryCollection are a safepoint.
+      SirtRef<mirror::Object> ref(self, obj);
+      RequestNurseryCollection(self);
     }
     if (kDesiredHeapVerification > kNoHeapVerification) {
       VerifyObject(obj);
@@ -619,8 +832,8 @@ mirror::Object* Heap::AllocObject(Thread* self, mirror::Class* c, size_t byte_co
     if (!large_object_allocation && total_bytes_free >= byte_count) {
       size_t max_contiguous_allocation = 0;
       for (const auto& space : continuous_spaces_) {
-        if (space->IsDlMallocSpace()) {
-          space->AsDlMallocSpace()->Walk(MSpaceChunkCallback, &max_contiguous_allocation);
+        if (space->IsMallocSpace()) {
+          space->AsMallocSpace()->Walk(MSpaceChunkCallback, &max_contiguous_allocation);
         }
       }
       oss << "; failed due to fragmentation (largest possible contiguous allocation "
@@ -835,16 +1048,119 @@ inline mirror::Object* Heap::TryToAllocate(Thread* self, space::AllocSpace* spac
   return space->Alloc(self, alloc_size, bytes_allocated);
 }
 
-// DlMallocSpace-specific version.
-inline mirror::Object* Heap::TryToAllocate(Thread* self, space::DlMallocSpace* space, size_t alloc_size,
+// MallocSpace-specific version.
+inline mirror::Object* Heap::TryToAllocate(Thread* self, space::MallocSpace* space, size_t alloc_size,
                                            bool grow, size_t* bytes_allocated) {
   if (UNLIKELY(IsOutOfMemoryOnAllocation(alloc_size, grow))) {
     return NULL;
   }
-  if (LIKELY(!running_on_valgrind_)) {
-    return space->AllocNonvirtual(self, alloc_size, bytes_allocated);
-  } else {
+  if (UNLIKELY(running_on_valgrind_)) {
     return space->Alloc(self, alloc_size, bytes_allocated);
+  } else if (use_rosalloc_) {
+    return down_cast<space::RosAllocSpace*>(space)->AllocNonvirtual(self, alloc_size,
+                                                                    bytes_allocated);
+  } else {
+    return down_cast<space::DlMallocSpace*>(space)->AllocNonvirtual(self, alloc_size,
+                                                                    bytes_allocated);
+  }
+}
+
+inline mirror::Object* Heap::AllocateThreadLocal(Thread* self, size_t num_bytes) {
+  // RosAlloc has thread-local runs of its own.
+  if (!kUseThreadLocalAllocCache || use_rosalloc_ || num_bytes > kMaxThreadLocalAllocSize ||
+      UNLIKELY(running_on_valgrind_)) {
+    return NULL;
+  }
+  // Every object handed out from the cache needs an allocation stack slot so that the GC treats
+  // it as allocated.
+  if (UNLIKELY(!self->HasThreadLocalAllocationStackSlots()) &&
+      !RefillThreadLocalAllocationStack(self)) {
+    return NULL;
+  }
+  const size_t bracket = (num_bytes - 1) / kThreadLocalAllocBracketSize;
+  mirror::Object* obj = self->PopThreadLocalAlloc(bracket);
+  if (UNLIKELY(obj == NULL)) {
+    obj = RefillThreadLocalAllocCache(self, bracket);
+    if (obj == NULL) {
+      return NULL;
+    }
+  }
+  // Zero the chunk, this also clears the free list link.
+  memset(obj, 0, num_bytes);
+  return obj;
+}
+
+mirror::Object* Heap::RefillThreadLocalAllocCache(Thread* self, size_t bracket) {
+  const size_t chunk_size = (bracket + 1) * kThreadLocalAllocBracketSize;
+  const size_t count = kThreadLocalAllocRefillBytes / chunk_size;
+  if (UNLIKELY(IsOutOfMemoryOnAllocation(count * chunk_size, false))) {
+    return NULL;
+  }
+  mirror::Object* chunks[kMaxThreadLocalAllocRefillCount];
+  size_t bytes_allocated;
+  size_t allocated = down_cast<space::DlMallocSpace*>(alloc_space_)->AllocBatchNonvirtual(
+      self, chunk_size, count, chunks, &bytes_allocated);
+  if (allocated == 0) {
+    return NULL;
+  }
+  // Account for the whole batch at once, unused chunks are subtracted again when revoked.
+  num_bytes_allocated_.fetch_add(bytes_allocated);
+  for (size_t i = 1; i < allocated; ++i) {
+    self->PushThreadLocalAlloc(bracket, chunks[i]);
+  }
+  return chunks[0];
+}
+
+bool Heap::RefillThreadLocalAllocationStack(Thread* self) {
+  mirror::Object** start;
+  mirror::Object** end;
+  if (!allocation_stack_->AtomicBumpBack(kThreadLocalAllocStackSlots, &start, &end)) {
+    // Let the regular path deal with the full allocation stack.
+    return false;
+  }
+  self->SetThreadLocalAllocationStack(start, end);
+  return true;
+}
+
+void Heap::RevokeThreadLocalBuffers(Thread* thread) {
+  // Slots the thread did not fill in yet are NULL and skipped by users of the allocation stack.
+  thread->SetThreadLocalAllocationStack(NULL, NULL);
+  Thread* self = Thread::Current();
+  mirror::Object* chunks[kMaxThreadLocalAllocRefillCount];
+  size_t count = 0;
+  size_t freed_bytes = 0;
+  for (size_t bracket = 0; bracket < Thread::kNumThreadLocalAllocBrackets; ++bracket) {
+    mirror::Object* chunk = thread->TakeThreadLocalAllocs(bracket);
+    while (chunk != NULL) {
+      mirror::Object* next = *reinterpret_cast<mirror::Object**>(chunk);
+      chunks[count++] = chunk;
+      if (count == arraysize(chunks)) {
+        freed_bytes += alloc_space_->FreeList(self, count, chunks);
+        count = 0;
+      }
+      chunk = next;
+    }
+  }
+  if (count != 0) {
+    freed_bytes += alloc_space_->FreeList(self, count, chunks);
+  }
+  if (freed_bytes != 0) {
+    // Not a RecordFree since these chunks never became objects.
+    num_bytes_allocated_.fetch_sub(freed_bytes);
+  }
+  if (use_rosalloc_) {
+    for (const auto& space : continuous_spaces_) {
+      if (space->IsRosAllocSpace()) {
+        space->AsRosAllocSpace()->RevokeThreadLocalBuffers(thread);
+      }
+    }
+  }
+}
+
+void Heap::RevokeAllThreadLocalBuffers() {
+  MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
+  for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+    RevokeThreadLocalBuffers(thread);
   }
 }
 
@@ -945,8 +1261,8 @@ size_t Heap::GetObjectsAllocated() const {
   typedef std::vector<space::ContinuousSpace*>::const_iterator It;
   for (It it = continuous_spaces_.begin(), end = continuous_spaces_.end(); it != end; ++it) {
     space::ContinuousSpace* space = *it;
-    if (space->IsDlMallocSpace()) {
-      total += space->AsDlMallocSpace()->GetObjectsAllocated();
+    if (space->IsContinuousMemMapAllocSpace()) {
+      total += space->AsContinuousMemMapAllocSpace()->GetObjectsAllocated();
     }
   }
   typedef std::vector<space::DiscontinuousSpace*>::const_iterator It2;
@@ -962,8 +1278,8 @@ size_t Heap::GetObjectsAllocatedEver() const {
   typedef std::vector<space::ContinuousSpace*>::const_iterator It;
   for (It it = continuous_spaces_.begin(), end = continuous_spaces_.end(); it != end; ++it) {
     space::ContinuousSpace* space = *it;
-    if (space->IsDlMallocSpace()) {
-      total += space->AsDlMallocSpace()->GetTotalObjectsAllocated();
+    if (space->IsContinuousMemMapAllocSpace()) {
+      total += space->AsContinuousMemMapAllocSpace()->GetTotalObjectsAllocated();
     }
   }
   typedef std::vector<space::DiscontinuousSpace*>::const_iterator It2;
@@ -979,8 +1295,8 @@ size_t Heap::GetBytesAllocatedEver() const {
   typedef std::vector<space::ContinuousSpace*>::const_iterator It;
   for (It it = continuous_spaces_.begin(), end = continuous_spaces_.end(); it != end; ++it) {
     space::ContinuousSpace* space = *it;
-    if (space->IsDlMallocSpace()) {
-      total += space->AsDlMallocSpace()->GetTotalBytesAllocated();
+    if (space->IsContinuousMemMapAllocSpace()) {
+      total += space->AsContinuousMemMapAllocSpace()->GetTotalBytesAllocated();
     }
   }
   typedef std::vector<space::DiscontinuousSpace*>::const_iterator It2;
@@ -1148,7 +1464,7 @@ void Heap::PreZygoteFork() {
 
   // Turns the current alloc space into a Zygote space and obtain the new alloc space composed
   // of the remaining available heap memory.
-  space::DlMallocSpace* zygote_space = alloc_space_;
+  space::MallocSpace* zygote_space = alloc_space_;
   alloc_space_ = zygote_space->CreateZygoteSpace("alloc space");
   alloc_space_->SetFootprintLimit(alloc_space_->Capacity());
 
@@ -1157,6 +1473,11 @@ void Heap::PreZygoteFork() {
   AddContinuousSpace(alloc_space_);
   have_zygote_space_ = true;
 
+  // The processes forked from the zygote inherit the compaction spaces.
+  if (background_compaction_) {
+    CreateCompactionSpaces();
+  }
+
   // Reset the cumulative loggers since we now have a few additional timing phases.
   for (const auto& collector : mark_sweep_collectors_) {
     collector->ResetCumulativeStatistics();
@@ -1164,6 +1485,7 @@ void Heap::PreZygoteFork() {
 }
 
 void Heap::FlushAllocStack() {
+  RevokeAllThreadLocalBuffers();
   MarkAllocStack(alloc_space_->GetLiveBitmap(), large_object_space_->GetLiveObjects(),
                  allocation_stack_.get());
   allocation_stack_->Reset();
@@ -1174,11 +1496,21 @@ void Heap::MarkAllocStack(accounting::SpaceBitmap* bitmap, accounting::SpaceSetM
   mirror::Object** limit = stack->End();
   for (mirror::Object** it = stack->Begin(); it != limit; ++it) {
     const mirror::Object* obj = *it;
-    DCHECK(obj != NULL);
+    // Skip allocation stack slots reserved by threads which were never filled in.
+    if (UNLIKELY(obj == NULL)) {
+      continue;
+    }
     if (LIKELY(bitmap->HasAddress(obj))) {
       bitmap->Set(obj);
     } else {
-      large_objects->Set(obj);
+      // Objects outside of the alloc space were allocated in one of the spaces used by
+      // compaction, or in the large object space.
+      accounting::SpaceBitmap* space_bitmap = live_bitmap_->GetContinuousSpaceBitmap(obj);
+      if (space_bitmap != NULL) {
+        space_bitmap->Set(obj);
+      } else {
+        large_objects->Set(obj);
+      }
     }
   }
 }
@@ -1200,25 +1532,7 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type, GcCaus
     LOG(WARNING) << "Performing GC on a thread that is handling a stack overflow.";
   }
 
-  // Ensure there is only one GC at a time.
-  bool start_collect = false;
-  while (!start_collect) {
-    {
-      MutexLock mu(self, *gc_complete_lock_);
-      if (!is_gc_running_) {
-        is_gc_running_ = true;
-        start_collect = true;
-      }
-    }
-    if (!start_collect) {
-      // TODO: timinglog this.
-      WaitForConcurrentGcToComplete(self);
-
-      // TODO: if another thread beat this one to do the GC, perhaps we should just return here?
-      //       Not doing at the moment to ensure soft references are cleared.
-    }
-  }
-  gc_complete_lock_->AssertNotHeld(self);
+  StartGC(self);
 
   if (gc_cause == kGcCauseForAlloc && Runtime::Current()->HasStatsEnabled()) {
     ++Runtime::Current()->GetStats()->gc_for_alloc_count;
@@ -1298,6 +1612,35 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type, GcCaus
     }
   }
 
+  ATRACE_END();
+
+  FinishGC(self, gc_type);
+  return gc_type;
+}
+
+void Heap::StartGC(Thread* self) {
+  // Ensure there is only one GC at a time.
+  bool start_collect = false;
+  while (!start_collect) {
+    {
+      MutexLock mu(self, *gc_complete_lock_);
+      if (!is_gc_running_) {
+        is_gc_running_ = true;
+        start_collect = true;
+      }
+    }
+    if (!start_collect) {
+      // TODO: timinglog this.
+      WaitForConcurrentGcToComplete(self);
+
+      // TODO: if another thread beat this one to do the GC, perhaps we should just return here?
+      //       Not doing at the moment to ensure soft references are cleared.
+    }
+  }
+  gc_complete_lock_->AssertNotHeld(self);
+}
+
+void Heap::FinishGC(Thread* self, collector::GcType gc_type) {
   {
       MutexLock mu(self, *gc_complete_lock_);
       is_gc_running_ = false;
@@ -1306,11 +1649,56 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type, GcCaus
       gc_complete_cond_->Broadcast(self);
   }
 
-  ATRACE_END();
-
   // Inform DDMS that a GC completed.
   Dbg::GcDidFinish();
-  return gc_type;
+}
+
+bool Heap::IsCompactionWorthwhile() const {
+  if (non_moving_space_ == NULL) {
+    return false;
+  }
+  // Whatever was bump allocated since the last compaction may be garbage which only compaction
+  // reclaims.
+  const size_t bump_pointer_space_growth =
+      bump_pointer_space_->Size() - bump_pointer_space_size_after_compaction_;
+  const size_t alloc_space_size = alloc_space_->Size();
+  const float utilization = alloc_space_size == 0 ? 1.0f :
+      static_cast<float>(alloc_space_->GetBytesAllocated()) / alloc_space_size;
+  if (care_about_pause_times_) {
+    // Only pause a process the user may notice when the alloc space is badly fragmented or the
+    // bump pointer space is close to full.
+    return (alloc_space_size >= kMinCompactionAllocSpaceSize &&
+            utilization < kForegroundCompactionUtilization) ||
+        bump_pointer_space_growth >= kBumpPointerSpaceCapacity / 2;
+  }
+  return (alloc_space_size >= kMinCompactionAllocSpaceSize &&
+          utilization < kBackgroundCompactionUtilization) ||
+      bump_pointer_space_growth >= kBumpPointerSpaceCapacity / 4;
+}
+
+void Heap::Compact(Thread* self) {
+  ScopedThreadStateChange tsc(self, kWaitingPerformingGc);
+  Locks::mutator_lock_->AssertNotHeld(self);
+  StartGC(self);
+  ATRACE_BEGIN("GC Background Compaction");
+  const size_t alloc_space_bytes_before = alloc_space_->GetBytesAllocated();
+  semi_space_collector_->Run();
+  total_objects_freed_ever_ += semi_space_collector_->GetFreedObjects();
+  total_bytes_freed_ever_ += semi_space_collector_->GetFreedBytes();
+  bump_pointer_space_size_after_compaction_ = bump_pointer_space_->Size();
+  last_compaction_time_ms_ = MilliTime();
+  UpdateNurseryCollectionStartBytes();
+  if (semi_space_collector_->GetMovedObjects() != 0 || VLOG_IS_ON(heap)) {
+    LOG(INFO) << "Background compaction moved " << semi_space_collector_->GetMovedObjects()
+              << "(" << PrettySize(semi_space_collector_->GetMovedBytes()) << ") objects, freed "
+              << semi_space_collector_->GetFreedObjects() << "("
+              << PrettySize(semi_space_collector_->GetFreedBytes()) << ") objects, alloc space "
+              << PrettySize(alloc_space_bytes_before) << " -> "
+              << PrettySize(alloc_space_->GetBytesAllocated())
+              << ", paused " << PrettyDuration(semi_space_collector_->GetDurationNs());
+  }
+  ATRACE_END();
+  FinishGC(self, collector::kGcTypePartial);
 }
 
 void Heap::UpdateAndMarkModUnion(collector::MarkSweep* mark_sweep, base::TimingLogger& timings,
@@ -1340,11 +1728,12 @@ void Heap::UpdateAndMarkModUnion(collector::MarkSweep* mark_sweep, base::TimingL
   image_mod_union_table_->MarkReferences(mark_sweep);
 }
 
-static void RootMatchesObjectVisitor(const mirror::Object* root, void* arg) {
+static mirror::Object* RootMatchesObjectVisitor(mirror::Object* root, void* arg) {
   mirror::Object* obj = reinterpret_cast<mirror::Object*>(arg);
   if (root == obj) {
     LOG(INFO) << "Object " << obj << " is a root";
   }
+  return root;
 }
 
 class ScanVisitor {
@@ -1393,8 +1782,8 @@ class VerifyReferenceVisitor {
 
         // Attmept to find the class inside of the recently freed objects.
         space::ContinuousSpace* ref_space = heap_->FindContinuousSpaceFromObject(ref, true);
-        if (ref_space->IsDlMallocSpace()) {
-          space::DlMallocSpace* space = ref_space->AsDlMallocSpace();
+        if (ref_space->IsMallocSpace()) {
+          space::MallocSpace* space = ref_space->AsMallocSpace();
           mirror::Class* ref_class = space->FindRecentFreedObject(ref);
           if (ref_class != nullptr) {
             LOG(ERROR) << "Reference " << ref << " found as a recently freed object with class "
@@ -1459,9 +1848,10 @@ class VerifyReferenceVisitor {
     return heap_->IsLiveObjectLocked(obj, true, false, true);
   }
 
-  static void VerifyRoots(const mirror::Object* root, void* arg) {
+  static mirror::Object* VerifyRoots(mirror::Object* root, void* arg) {
     VerifyReferenceVisitor* visitor = reinterpret_cast<VerifyReferenceVisitor*>(arg);
     (*visitor)(NULL, root, MemberOffset(0), true);
+    return root;
   }
 
  private:
@@ -1497,6 +1887,8 @@ class VerifyObjectVisitor {
 // Must do this with mutators suspended since we are directly accessing the allocation stacks.
 bool Heap::VerifyHeapReferences() {
   Locks::mutator_lock_->AssertExclusiveHeld(Thread::Current());
+  // Threads must not fill in reserved slots while we sort the stacks.
+  RevokeAllThreadLocalBuffers();
   // Lets sort our allocation stacks so that we can efficiently binary search them.
   allocation_stack_->Sort();
   live_stack_->Sort();
@@ -1508,7 +1900,9 @@ bool Heap::VerifyHeapReferences() {
   // 1. Allocated prior to the GC (pre GC verification).
   // 2. Allocated during the GC (pre sweep GC verification).
   for (mirror::Object** it = allocation_stack_->Begin(); it != allocation_stack_->End(); ++it) {
-    visitor(*it);
+    if (*it != NULL) {
+      visitor(*it);
+    }
   }
   // We don't want to verify the objects in the live stack since they themselves may be
   // pointing to dead objects if they are not reachable.
@@ -1616,6 +2010,7 @@ class VerifyLiveStackReferences {
 
 bool Heap::VerifyMissingCardMarks() {
   Locks::mutator_lock_->AssertExclusiveHeld(Thread::Current());
+  RevokeAllThreadLocalBuffers();
 
   // We need to sort the live stack since we binary search it.
   live_stack_->Sort();
@@ -1624,7 +2019,9 @@ bool Heap::VerifyMissingCardMarks() {
 
   // We can verify objects in the live stack since none of these should reference dead objects.
   for (mirror::Object** it = live_stack_->Begin(); it != live_stack_->End(); ++it) {
-    visitor(*it);
+    if (*it != NULL) {
+      visitor(*it);
+    }
   }
 
   if (visitor.Failed()) {
@@ -1641,6 +2038,12 @@ void Heap::SwapStacks() {
 void Heap::ProcessCards(base::TimingLogger& timings) {
   // Clear cards and keep track of cards cleared in the mod-union table.
   for (const auto& space : continuous_spaces_) {
+    accounting::RememberedSet* remembered_set = FindRememberedSetFromSpace(space);
+    if (remembered_set != NULL) {
+      // Aging the cards twice clears them, the remembered set needs to see them first.
+      base::TimingLogger::ScopedSplit split("RememberedSetRecordDirtyCards", &timings);
+      remembered_set->RecordDirtyCards();
+    }
     if (space->IsImageSpace()) {
       base::TimingLogger::ScopedSplit split("ImageModUnionClearCards", &timings);
       image_mod_union_table_->ClearCards(space);
@@ -2012,7 +2415,58 @@ void Heap::ConcurrentGC(Thread* self) {
 
   // Wait for any GCs currently running to finish.
   if (WaitForConcurrentGcToComplete(self) == collector::kGcTypeNone) {
-    CollectGarbageInternal(next_gc_type_, kGcCauseBackground, false);
+    if (nursery_collection_pending_.compare_and_swap(1, 0)) {
+      CollectNursery(self);
+    } else {
+      CollectGarbageInternal(next_gc_type_, kGcCauseBackground, false);
+    }
+  }
+}
+
+void Heap::RequestNurseryCollection(Thread* self) {
+  // Only one request at a time, the next is scheduled once the nursery has been collected.
+  nursery_collection_start_bytes_ = std::numeric_limits<size_t>::max();
+  if (Runtime::Current()->IsZygote()) {
+    return;
+  }
+  nursery_collection_pending_.compare_and_swap(0, 1);
+  RequestConcurrentGC(self);
+}
+
+void Heap::UpdateNurseryCollectionStartBytes() {
+  if (!IsNurseryCollectionEnabled()) {
+    return;
+  }
+  // If the last collection could not empty the nursery, retry once most of what is left is used.
+  const size_t size = bump_pointer_space_->Size();
+  nursery_collection_start_bytes_ =
+      size + static_cast<size_t>((bump_pointer_space_->Capacity() - size) *
+                                 kNurseryCollectionStartFraction);
+}
+
+void Heap::CollectNursery(Thread* self) {
+  ScopedThreadStateChange tsc(self, kWaitingPerformingGc);
+  Locks::mutator_lock_->AssertNotHeld(self);
+  StartGC(self);
+  ATRACE_BEGIN("GC Nursery Collection");
+  minor_collector_->Run();
+  total_objects_freed_ever_ += minor_collector_->GetFreedObjects();
+  total_bytes_freed_ever_ += minor_collector_->GetFreedBytes();
+  // Whatever the collection freed from the nursery no longer needs compacting.
+  bump_pointer_space_size_after_compaction_ =
+      std::min(bump_pointer_space_size_after_compaction_, bump_pointer_space_->Size());
+  UpdateNurseryCollectionStartBytes();
+  VLOG(heap) << "Nursery collection promoted " << minor_collector_->GetMovedObjects() << "("
+             << PrettySize(minor_collector_->GetMovedBytes()) << ") objects, freed "
+             << minor_collector_->GetFreedObjects() << "("
+             << PrettySize(minor_collector_->GetFreedBytes()) << ") objects, paused "
+             << PrettyDuration(minor_collector_->GetDurationNs());
+  ATRACE_END();
+  FinishGC(self, collector::kGcTypeSticky);
+  if (minor_collector_->PromotionFailed()) {
+    // Make room in the alloc space for the next nursery collection to promote into.
+    VLOG(heap) << "Nursery promotion failed, running a full collection";
+    CollectGarbageInternal(collector::kGcTypeFull, kGcCauseBackground, false);
   }
 }
 
@@ -2032,9 +2486,12 @@ void Heap::RequestHeapTrim() {
   uint64_t ms_time = MilliTime();
   float utilization =
       static_cast<float>(alloc_space_->GetBytesAllocated()) / alloc_space_->Size();
-  if ((utilization > 0.75f && !IsLowMemoryMode()) || ((ms_time - last_trim_time_ms_) < 2 * 1000)) {
+  const bool compaction_worthwhile = IsCompactionWorthwhile();
+  if ((utilization > 0.75f && !IsLowMemoryMode() && !compaction_worthwhile) ||
+      ((ms_time - last_trim_time_ms_) < 2 * 1000)) {
     // Don't bother trimming the alloc space if it's more than 75% utilized and low memory mode is
-    // not enabled, or if a heap trim occurred in the last two seconds.
+    // not enabled, or if a heap trim occurred in the last two seconds. The trim also compacts,
+    // so it is still worth requesting if the heap needs compacting.
     return;
   }
 
@@ -2053,8 +2510,9 @@ void Heap::RequestHeapTrim() {
   last_trim_time_ms_ = ms_time;
   ListenForProcessStateChange();
 
-  // Trim only if we do not currently care about pause times.
-  if (!care_about_pause_times_) {
+  // Trim only if we do not currently care about pause times, or if the heap is fragmented enough
+  // to be worth a compaction pause anyway.
+  if (!care_about_pause_times_ || compaction_worthwhile) {
     JNIEnv* env = self->GetJniEnv();
     DCHECK(WellKnownClasses::java_lang_Daemons != NULL);
     DCHECK(WellKnownClasses::java_lang_Daemons_requestHeapTrim != NULL);
@@ -2066,7 +2524,16 @@ void Heap::RequestHeapTrim() {
 
 size_t Heap::Trim() {
   // Handle a requested heap trim on a thread outside of the main GC thread.
-  return alloc_space_->Trim();
+  Thread* self = Thread::Current();
+  if (IsCompactionWorthwhile() && !Runtime::Current()->IsZygote() && !Dbg::IsDebuggerActive() &&
+      MilliTime() - last_compaction_time_ms_ >= kMinCompactionIntervalMs) {
+    Compact(self);
+  }
+  size_t reclaimed = alloc_space_->Trim();
+  if (non_moving_space_ != NULL) {
+    reclaimed += non_moving_space_->Trim();
+  }
+  return reclaimed;
 }
 
 bool Heap::IsGCRequestPending() const {
@@ -2133,9 +2600,11 @@ int64_t Heap::GetTotalMemory() const {
   for (const auto& space : continuous_spaces_) {
     if (space->IsImageSpace()) {
       // Currently don't include the image space.
-    } else if (space->IsDlMallocSpace()) {
+    } else if (space->IsMallocSpace()) {
       // Zygote or alloc space
-      ret += space->AsDlMallocSpace()->GetFootprint();
+      ret += space->AsMallocSpace()->GetFootprint();
+    } else if (space->IsBumpPointerSpace()) {
+      ret += space->AsBumpPointerSpace()->Size();
     }
   }
   for (const auto& space : discontinuous_spaces_) {
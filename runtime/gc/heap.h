@@ -51,20 +51,25 @@ namespace gc {
 namespace accounting {
   class HeapBitmap;
   class ModUnionTable;
+  class RememberedSet;
   class SpaceSetMap;
 }  // namespace accounting
 
 namespace collector {
   class GarbageCollector;
   class MarkSweep;
+  class SemiSpace;
 }  // namespace collector
 
 namespace space {
   class AllocSpace;
+  class BumpPointerSpace;
   class DiscontinuousSpace;
   class DlMallocSpace;
   class ImageSpace;
   class LargeObjectSpace;
+  class MallocSpace;
+  class RosAllocSpace;
   class Space;
   class SpaceTest;
 }  // namespace space
@@ -101,6 +106,15 @@ enum HeapVerificationMode {
 };
 static constexpr HeapVerificationMode kDesiredHeapVerification = kNoHeapVerification;
 
+// The kinds of mod-union table which can record the image space's references to the Zygote and
+// alloc spaces.
+enum ModUnionTableKind {
+  kModUnionTableReferenceCache,  // The references of each card, in a map of vectors.
+  kModUnionTableCompactReferenceCache,  // The same references, in flat arrays.
+  kModUnionTableCardCache,  // Only the cleared cards, whose objects are scanned when marking.
+};
+std::ostream& operator<<(std::ostream& os, const ModUnionTableKind& kind);
+
 class Heap {
  public:
   static constexpr size_t kDefaultInitialSize = 2 * MB;
@@ -113,6 +127,9 @@ class Heap {
   // Default target utilization.
   static constexpr double kDefaultTargetUtilization = 0.5;
 
+  static constexpr ModUnionTableKind kDefaultImageModUnionTableKind =
+      kModUnionTableCompactReferenceCache;
+
   // Used so that we don't overflow the allocation time atomic integer.
   static constexpr size_t kTimeAdjust = 1024;
 
@@ -123,7 +140,9 @@ class Heap {
                 size_t max_free, double target_utilization, size_t capacity,
                 const std::string& original_image_file_name, bool concurrent_gc,
                 size_t parallel_gc_threads, size_t conc_gc_threads, bool low_memory_mode,
-                size_t long_pause_threshold, size_t long_gc_threshold, bool ignore_max_footprint);
+                size_t long_pause_threshold, size_t long_gc_threshold, bool ignore_max_footprint,
+                bool use_rosalloc, bool background_compaction, bool nursery_collection,
+                ModUnionTableKind image_mod_union_table_kind);
 
   ~Heap();
 
@@ -131,6 +150,34 @@ class Heap {
   mirror::Object* AllocObject(Thread* self, mirror::Class* klass, size_t num_bytes)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Allocates and initializes storage for an object instance that compaction will never move,
+  // such as an array whose address is handed out to native code.
+  mirror::Object* AllocNonMovableObject(Thread* self, mirror::Class* klass, size_t num_bytes)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Returns false for the classes whose instances are referenced by address from the runtime and
+  // compiled code, these are allocated in the non-moving space when compaction is enabled.
+  static bool IsMovableClass(const mirror::Class* klass)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Whether objects may be moved by background compaction, in which case identity hash codes
+  // need to be remembered across moves.
+  bool IsCompactionEnabled() const {
+    return non_moving_space_ != NULL;
+  }
+
+  // Whether obj may be moved by a later compaction.
+  bool IsMovableObject(const mirror::Object* obj) const;
+
+  // Whether the bump pointer space is a nursery, emptied by minor collections which promote the
+  // objects that survive into the alloc space.
+  bool IsNurseryCollectionEnabled() const {
+    return nursery_collection_ && bump_pointer_space_ != NULL;
+  }
+
+  // Returns the remembered set of the given space, or NULL if it has none.
+  accounting::RememberedSet* FindRememberedSetFromSpace(space::Space* space);
+
   void RegisterNativeAllocation(int bytes)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void RegisterNativeFree(int bytes) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -226,6 +273,9 @@ class Heap {
                            MemberOffset finalizer_reference_zombie_offset);
 
   mirror::Object* GetReferenceReferent(mirror::Object* reference);
+  MemberOffset GetReferenceReferentOffset() const {
+    return reference_referent_offset_;
+  }
   void ClearReferenceReferent(mirror::Object* reference) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // Returns true if the reference object has not yet been enqueued.
@@ -343,6 +393,8 @@ class Heap {
 
   void DumpForSigQuit(std::ostream& os);
 
+  // Returns the pages of the alloc spaces which no longer hold objects to the kernel, first
+  // compacting the heap if that is enabled and worthwhile.
   size_t Trim();
 
   accounting::HeapBitmap* GetLiveBitmap() SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_) {
@@ -359,10 +411,18 @@ class Heap {
 
   void PreZygoteFork() LOCKS_EXCLUDED(Locks::heap_bitmap_lock_);
 
-  // Mark and empty stack.
+  // Mark and empty stack. Also revokes the thread-local buffers of all threads, so no other
+  // thread may be allocating.
   void FlushAllocStack()
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
 
+  // Gives the alloc space chunks cached by thread back to the alloc space and retires its
+  // reserved allocation stack slots. The caller must be thread or have it suspended.
+  void RevokeThreadLocalBuffers(Thread* thread);
+
+  // Revokes the thread-local buffers of every thread, other mutators must be suspended.
+  void RevokeAllThreadLocalBuffers() LOCKS_EXCLUDED(Locks::thread_list_lock_);
+
   // Mark all the objects in the allocation stack in the specified bitmap.
   void MarkAllocStack(accounting::SpaceBitmap* bitmap, accounting::SpaceSetMap* large_objects,
                       accounting::ObjectStack* stack)
@@ -380,7 +440,7 @@ class Heap {
   // Assumes there is only one image space.
   space::ImageSpace* GetImageSpace() const;
 
-  space::DlMallocSpace* GetAllocSpace() const {
+  space::MallocSpace* GetAllocSpace() const {
     return alloc_space_;
   }
 
@@ -388,6 +448,14 @@ class Heap {
     return large_object_space_;
   }
 
+  space::MallocSpace* GetNonMovingSpace() const {
+    return non_moving_space_;
+  }
+
+  space::BumpPointerSpace* GetBumpPointerSpace() const {
+    return bump_pointer_space_;
+  }
+
   Mutex* GetSoftRefQueueLock() {
     return soft_ref_queue_lock_;
   }
@@ -428,6 +496,12 @@ class Heap {
   }
 
  private:
+  // Allocates and initializes storage for an object instance, in the non-moving space if the
+  // object must not be moved and compaction is enabled.
+  mirror::Object* AllocObjectInternal(Thread* self, mirror::Class* klass, size_t num_bytes,
+                                      bool movable)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Allocates uninitialized storage. Passing in a null space tries to place the object in the
   // large object space.
   template <class T> mirror::Object* Allocate(Thread* self, T* space, size_t num_bytes, size_t* bytes_allocated)
@@ -447,18 +521,68 @@ class Heap {
       LOCKS_EXCLUDED(Locks::thread_suspend_count_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  // Try to allocate a number of bytes, this function never does any GCs. DlMallocSpace-specialized version.
-  mirror::Object* TryToAllocate(Thread* self, space::DlMallocSpace* space, size_t alloc_size, bool grow,
+  // Try to allocate a number of bytes, this function never does any GCs. MallocSpace-specialized
+  // version which avoids the virtual call for the allocator in use.
+  mirror::Object* TryToAllocate(Thread* self, space::MallocSpace* space, size_t alloc_size, bool grow,
                                 size_t* bytes_allocated)
       LOCKS_EXCLUDED(Locks::thread_suspend_count_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   bool IsOutOfMemoryOnAllocation(size_t alloc_size, bool grow);
 
+  // Try to allocate a small object from the calling thread's allocation cache without taking the
+  // alloc space lock, refilling the cache if needed. Returns NULL if the allocation has to take
+  // the regular path. The returned object already has a reserved allocation stack slot and is
+  // accounted for in num_bytes_allocated_.
+  mirror::Object* AllocateThreadLocal(Thread* self, size_t num_bytes)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Allocates a batch of chunks for the given bracket into the thread's cache, returning one of
+  // them or NULL on failure.
+  mirror::Object* RefillThreadLocalAllocCache(Thread* self, size_t bracket)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Reserves a new range of allocation stack slots for the thread.
+  bool RefillThreadLocalAllocationStack(Thread* self)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Pushes a list of cleared references out to the managed heap.
   void EnqueueClearedReferences(mirror::Object** cleared_references);
 
   void RequestHeapTrim() LOCKS_EXCLUDED(Locks::runtime_shutdown_lock_);
+
+  // Blocks until no other GC is running and then marks the calling thread as running one.
+  void StartGC(Thread* self) LOCKS_EXCLUDED(gc_complete_lock_);
+
+  // Marks the end of the GC started by StartGC and wakes up the threads waiting for it.
+  void FinishGC(Thread* self, collector::GcType gc_type) LOCKS_EXCLUDED(gc_complete_lock_);
+
+  // Creates the non-moving and bump pointer spaces used by compaction in the address range
+  // reserved for them after the alloc space. Compaction stays disabled if that fails.
+  void CreateCompactionSpaces();
+
+  // Whether compacting the heap now would noticeably reduce its footprint.
+  bool IsCompactionWorthwhile() const;
+
+  // Evacuates the alloc space and the bump pointer space into the empty bump pointer space with
+  // the semi-space collector.
+  void Compact(Thread* self)
+      LOCKS_EXCLUDED(gc_complete_lock_,
+                     Locks::heap_bitmap_lock_,
+                     Locks::thread_suspend_count_lock_);
+  // Promotes the reachable objects of the nursery into the alloc space with the minor collector.
+  void CollectNursery(Thread* self)
+      LOCKS_EXCLUDED(gc_complete_lock_,
+                     Locks::heap_bitmap_lock_,
+                     Locks::thread_suspend_count_lock_);
+
+  // Asks the GC daemon to collect the nursery, minor collections need a thread which holds no
+  // object pointers of its own.
+  void RequestNurseryCollection(Thread* self) LOCKS_EXCLUDED(Locks::runtime_shutdown_lock_);
+
+  // Schedules the next nursery collection depending on how full the nursery is.
+  void UpdateNurseryCollectionStartBytes();
+
   void RequestConcurrentGC(Thread* self) LOCKS_EXCLUDED(Locks::runtime_shutdown_lock_);
   bool IsGCRequestPending() const;
 
@@ -513,8 +637,18 @@ class Heap {
   // All-known discontinuous spaces, where objects may be placed throughout virtual memory.
   std::vector<space::DiscontinuousSpace*> discontinuous_spaces_;
 
-  // The allocation space we are currently allocating into.
-  space::DlMallocSpace* alloc_space_;
+  // The allocation space we are currently allocating into. Assigned where the heap creates it, it
+  // is a RosAllocSpace exactly when use_rosalloc_ is set.
+  space::MallocSpace* alloc_space_;
+
+  // When compaction is enabled, the space holding the objects which may never move, see
+  // IsMovableClass.
+  space::MallocSpace* non_moving_space_;
+
+  // When compaction is enabled, the bump pointer space movable objects are allocated into while
+  // it has room, and the empty bump pointer space the next compaction copies objects into.
+  space::BumpPointerSpace* bump_pointer_space_;
+  space::BumpPointerSpace* temp_space_;
 
   // The large object space we are currently allocating into.
   space::LargeObjectSpace* large_object_space_;
@@ -553,6 +687,37 @@ class Heap {
   // useful for benchmarking since it reduces time spent in GC to a low %.
   const bool ignore_max_footprint_;
 
+  // Whether the alloc space is a RosAllocSpace rather than a DlMallocSpace.
+  const bool use_rosalloc_;
+
+  // Whether the heap compacts itself when the process is idle or the alloc space is fragmented.
+  // Cleared if the spaces compaction requires can't be created.
+  bool background_compaction_;
+
+  // Start of the address range reserved for the spaces used by compaction.
+  byte* compaction_spaces_begin_;
+
+  // The last time a compaction occurred.
+  uint64_t last_compaction_time_ms_;
+
+  // Bytes in the bump pointer space after the last compaction, what was allocated since then is
+  // the most garbage the next compaction can reclaim from it.
+  size_t bump_pointer_space_size_after_compaction_;
+
+  // Whether the bump pointer space is used as a nursery, requires a concurrent GC daemon to run
+  // the minor collections.
+  const bool nursery_collection_;
+
+  // A nursery collection is requested once this many bytes are allocated in the nursery.
+  size_t nursery_collection_start_bytes_;
+
+  // Non-zero if the next background GC the daemon runs should be a nursery collection. Set by the
+  // allocating thread and cleared by the daemon.
+  AtomicInteger nursery_collection_pending_;
+
+  // The remembered sets of the spaces which may hold references into the nursery.
+  SafeMap<space::Space*, accounting::RememberedSet*> remembered_sets_;
+
   // If we have a zygote space.
   bool have_zygote_space_;
 
@@ -709,15 +874,20 @@ class Heap {
   HeapVerificationMode verify_object_mode_;
 
   std::vector<collector::MarkSweep*> mark_sweep_collectors_;
+  collector::SemiSpace* semi_space_collector_;
+  collector::SemiSpace* minor_collector_;
 
   const bool running_on_valgrind_;
 
   friend class collector::MarkSweep;
+  friend class collector::SemiSpace;
   friend class VerifyReferenceCardVisitor;
   friend class VerifyReferenceVisitor;
   friend class VerifyObjectVisitor;
   friend class ScopedHeapLock;
   friend class space::SpaceTest;
+  friend class CompactionTest;
+  friend class NurseryCollectionTest;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(Heap);
 };
@@ -17,10 +17,13 @@
 #include "common_test.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/accounting/space_bitmap-inl.h"
+#include "gc/space/bump_pointer_space.h"
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
 #include "mirror/object_array-inl.h"
+#include "signal_catcher.h"
 #include "sirt_ref.h"
+#include "thread_list.h"
 
 namespace art {
 namespace gc {
@@ -55,6 +58,162 @@ TEST_F(HeapTest, GarbageCollectClassLinkerInit) {
   Runtime::Current()->GetHeap()->CollectGarbage(false);
 }
 
+TEST_F(HeapTest, ThreadLocalAllocationSurvivesGc) {
+  ScopedObjectAccess soa(Thread::Current());
+  Heap* heap = Runtime::Current()->GetHeap();
+  mirror::Class* c = class_linker_->FindSystemClass("[Ljava/lang/Object;");
+  SirtRef<mirror::ObjectArray<mirror::Object> > array(soa.Self(),
+      mirror::ObjectArray<mirror::Object>::Alloc(soa.Self(), c, 1024));
+  for (size_t i = 0; i < 1024; ++i) {
+    // Interleave live and garbage small objects so both end up in the same cached batches.
+    mirror::String::AllocFromModifiedUtf8(soa.Self(), "garbage");
+    array->Set(i, mirror::String::AllocFromModifiedUtf8(soa.Self(), "hello, world!"));
+  }
+  {
+    ScopedThreadStateChange tsc(soa.Self(), kNative);
+    heap->CollectGarbage(false);
+  }
+  for (size_t i = 0; i < 1024; ++i) {
+    mirror::String* string = array->Get(i)->AsString();
+    EXPECT_TRUE(string->Equals("hello, world!"));
+  }
+  // Revoking returns the unused cached chunks to the alloc space.
+  mirror::String::AllocFromModifiedUtf8(soa.Self(), "refill");
+  const size_t bytes_before_revoke = heap->GetBytesAllocated();
+  heap->RevokeThreadLocalBuffers(soa.Self());
+  EXPECT_LE(heap->GetBytesAllocated(), bytes_before_revoke);
+}
+
+TEST_F(HeapTest, ParallelSweepFreesGarbage) {
+  ScopedObjectAccess soa(Thread::Current());
+  Heap* heap = Runtime::Current()->GetHeap();
+  ASSERT_TRUE(heap->GetThreadPool() != NULL);
+  // Enough objects to spread the garbage over many of the ranges given to the sweep tasks.
+  const size_t kLiveObjects = 16 * KB;
+  mirror::Class* c = class_linker_->FindSystemClass("[Ljava/lang/Object;");
+  SirtRef<mirror::ObjectArray<mirror::Object> > array(soa.Self(),
+      mirror::ObjectArray<mirror::Object>::Alloc(soa.Self(), c, kLiveObjects));
+  for (size_t i = 0; i < kLiveObjects; ++i) {
+    mirror::String::AllocFromModifiedUtf8(soa.Self(), "garbage");
+    array->Set(i, mirror::String::AllocFromModifiedUtf8(soa.Self(), "hello, world!"));
+  }
+  const size_t objects_before = heap->GetObjectsAllocated();
+  {
+    ScopedThreadStateChange tsc(soa.Self(), kNative);
+    heap->CollectGarbage(false);
+  }
+  // Each garbage string held a char array too.
+  EXPECT_LE(heap->GetObjectsAllocated() + 2 * kLiveObjects, objects_before);
+  for (size_t i = 0; i < kLiveObjects; ++i) {
+    mirror::String* string = array->Get(i)->AsString();
+    EXPECT_TRUE(string->Equals("hello, world!"));
+  }
+  heap->VerifyHeap();
+}
+
+class NurseryCollectionTest : public CommonTest {
+ protected:
+  virtual void SetUpRuntimeOptions(Runtime::Options* options) {
+    options->push_back(std::make_pair("-XX:NurseryCollection", reinterpret_cast<void*>(NULL)));
+  }
+
+  void CollectNursery(Heap* heap, Thread* self) {
+    heap->CollectNursery(self);
+  }
+};
+
+TEST_F(NurseryCollectionTest, PromotesReachableObjects) {
+  ScopedObjectAccess soa(Thread::Current());
+  Heap* heap = Runtime::Current()->GetHeap();
+  if (!heap->IsNurseryCollectionEnabled()) {
+    LOG(WARNING) << "Nursery collection is disabled, skipping the test";
+    return;
+  }
+  space::BumpPointerSpace* nursery = heap->GetBumpPointerSpace();
+  mirror::Class* c = class_linker_->FindSystemClass("[Ljava/lang/Object;");
+  SirtRef<mirror::ObjectArray<mirror::Object> > array(soa.Self(),
+      mirror::ObjectArray<mirror::Object>::Alloc(soa.Self(), c, 256));
+  for (size_t i = 0; i < 256; ++i) {
+    mirror::String::AllocFromModifiedUtf8(soa.Self(), "garbage");
+    array->Set(i, mirror::String::AllocFromModifiedUtf8(soa.Self(), "hello, world!"));
+  }
+  EXPECT_TRUE(nursery->Contains(array.get()));
+  {
+    ScopedThreadStateChange tsc(soa.Self(), kNative);
+    CollectNursery(heap, soa.Self());
+  }
+  // The reachable objects were promoted out of the emptied nursery.
+  EXPECT_EQ(0U, nursery->Size());
+  EXPECT_FALSE(nursery->Contains(array.get()));
+  for (size_t i = 0; i < 256; ++i) {
+    mirror::String* string = array->Get(i)->AsString();
+    EXPECT_FALSE(nursery->Contains(string));
+    EXPECT_TRUE(string->Equals("hello, world!"));
+  }
+
+  // The promoted array is only found to reference the new nursery objects through the remembered
+  // set of the space it was promoted into.
+  for (size_t i = 0; i < 256; i += 2) {
+    array->Set(i, mirror::String::AllocFromModifiedUtf8(soa.Self(), "young"));
+  }
+  {
+    ScopedThreadStateChange tsc(soa.Self(), kNative);
+    CollectNursery(heap, soa.Self());
+  }
+  EXPECT_EQ(0U, nursery->Size());
+  for (size_t i = 0; i < 256; ++i) {
+    mirror::String* string = array->Get(i)->AsString();
+    EXPECT_FALSE(nursery->Contains(string));
+    EXPECT_TRUE(string->Equals(i % 2 == 0 ? "young" : "hello, world!"));
+  }
+}
+
+class CompactionTest : public CommonTest {
+ protected:
+  virtual void SetUpRuntimeOptions(Runtime::Options* options) {
+    options->push_back(std::make_pair("-XX:BackgroundCompaction", reinterpret_cast<void*>(NULL)));
+  }
+
+  void Compact(Heap* heap, Thread* self) {
+    heap->Compact(self);
+  }
+};
+
+// Whether the signal catcher thread is blocked waiting for a signal.
+static bool IsSignalCatcherWaiting(Thread* self) {
+  MutexLock mu(self, *Locks::thread_list_lock_);
+  for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+    if (thread->GetState() == kWaitingInMainSignalCatcherLoop) {
+      return thread->IsAtMovingGcSafePoint();
+    }
+  }
+  return false;
+}
+
+TEST_F(CompactionTest, MovesObjectsWhileSignalCatcherWaits) {
+  Thread* self = Thread::Current();
+  Heap* heap = Runtime::Current()->GetHeap();
+  if (!heap->IsCompactionEnabled()) {
+    LOG(WARNING) << "Compaction is disabled, skipping the test";
+    return;
+  }
+  // Every process forked from the zygote has a signal catcher, which must not stop compaction.
+  UniquePtr<SignalCatcher> signal_catcher(new SignalCatcher(""));
+  while (!IsSignalCatcherWaiting(self)) {
+    usleep(1000);
+  }
+
+  ScopedObjectAccess soa(self);
+  SirtRef<mirror::String> string(self,
+                                 mirror::String::AllocFromModifiedUtf8(self, "hello, world!"));
+  ASSERT_TRUE(string.get() != NULL);
+  ASSERT_TRUE(heap->IsMovableObject(string.get()));
+  const mirror::String* old_string = string.get();
+  Compact(heap, self);
+  EXPECT_NE(old_string, string.get());
+  EXPECT_TRUE(string->Equals("hello, world!"));
+}
+
 TEST_F(HeapTest, HeapBitmapCapacityTest) {
   byte* heap_begin = reinterpret_cast<byte*>(0x1000);
   const size_t heap_capacity = accounting::SpaceBitmap::kAlignment * (sizeof(intptr_t) * 8 + 1);
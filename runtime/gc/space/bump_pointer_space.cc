@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bump_pointer_space.h"
+#include "bump_pointer_space-inl.h"
+
+#include <sys/mman.h>
+
+#include "gc/accounting/card_table.h"
+#include "mirror/object-inl.h"
+#include "utils.h"
+
+namespace art {
+namespace gc {
+namespace space {
+
+size_t BumpPointerSpace::bitmap_index_ = 0;
+
+BumpPointerSpace* BumpPointerSpace::Create(const std::string& name, size_t capacity,
+                                           byte* requested_begin) {
+  capacity = RoundUp(capacity, kPageSize);
+  MemMap* mem_map = MemMap::MapAnonymous(name.c_str(), requested_begin, capacity,
+                                         PROT_READ | PROT_WRITE);
+  if (mem_map == NULL) {
+    LOG(ERROR) << "Failed to allocate pages for bump pointer space (" << name << ") of size "
+        << PrettySize(capacity);
+    return NULL;
+  }
+  BumpPointerSpace* space = new BumpPointerSpace(name, mem_map);
+  VLOG(heap) << "BumpPointerSpace::Create " << *space;
+  return space;
+}
+
+BumpPointerSpace::BumpPointerSpace(const std::string& name, MemMap* mem_map)
+    : ContinuousMemMapAllocSpace(name, mem_map, 0, kGcRetentionPolicyAlwaysCollect) {
+  size_t bitmap_index = bitmap_index_++;
+  static const uintptr_t kGcCardSize = static_cast<uintptr_t>(accounting::CardTable::kCardSize);
+  CHECK(IsAligned<kGcCardSize>(reinterpret_cast<uintptr_t>(mem_map->Begin())));
+  CHECK(IsAligned<kGcCardSize>(reinterpret_cast<uintptr_t>(mem_map->End())));
+  live_bitmap_.reset(accounting::SpaceBitmap::Create(
+      StringPrintf("bump pointer space %s live-bitmap %d", name.c_str(),
+                   static_cast<int>(bitmap_index)),
+      Begin(), Capacity()));
+  CHECK(live_bitmap_.get() != NULL) << "could not create bump pointer space live bitmap #"
+                                    << bitmap_index;
+  mark_bitmap_.reset(accounting::SpaceBitmap::Create(
+      StringPrintf("bump pointer space %s mark-bitmap %d", name.c_str(),
+                   static_cast<int>(bitmap_index)),
+      Begin(), Capacity()));
+  CHECK(mark_bitmap_.get() != NULL) << "could not create bump pointer space mark bitmap #"
+                                    << bitmap_index;
+}
+
+mirror::Object* BumpPointerSpace::Alloc(Thread*, size_t num_bytes, size_t* bytes_allocated) {
+  mirror::Object* obj = AllocNonvirtual(num_bytes);
+  if (LIKELY(obj != NULL)) {
+    *bytes_allocated = RoundUp(num_bytes, kAlignment);
+  }
+  return obj;
+}
+
+size_t BumpPointerSpace::AllocationSizeNonvirtual(const mirror::Object* obj) {
+  return RoundUp(obj->SizeOfWithHashCode(), kAlignment);
+}
+
+void BumpPointerSpace::Clear() {
+  // Release the pages, they read back as zero which is what allocation relies upon.
+  CHECK_NE(madvise(Begin(), Limit() - Begin(), MADV_DONTNEED), -1) << "madvise failed";
+  end_ = Begin();
+  objects_allocated_ = 0;
+  live_bitmap_->Clear();
+  mark_bitmap_->Clear();
+}
+
+void BumpPointerSpace::Walk(accounting::SpaceBitmap::Callback* callback, void* arg) {
+  byte* pos = Begin();
+  byte* end = End();
+  while (pos < end) {
+    mirror::Object* obj = reinterpret_cast<mirror::Object*>(pos);
+    // A NULL class means the allocation hasn't been initialized yet, nothing follows it.
+    if (obj->GetClass() == NULL) {
+      break;
+    }
+    callback(obj, arg);
+    pos += AllocationSizeNonvirtual(obj);
+  }
+}
+
+void BumpPointerSpace::Dump(std::ostream& os) const {
+  os << GetType()
+      << " begin=" << reinterpret_cast<void*>(Begin())
+      << ",end=" << reinterpret_cast<void*>(End())
+      << ",limit=" << reinterpret_cast<void*>(Limit())
+      << ",name=\"" << GetName() << "\"]";
+}
+
+}  // namespace space
+}  // namespace gc
+}  // namespace art
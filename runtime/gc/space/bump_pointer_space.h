@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_SPACE_BUMP_POINTER_SPACE_H_
+#define ART_RUNTIME_GC_SPACE_BUMP_POINTER_SPACE_H_
+
+#include "atomic_integer.h"
+#include "space.h"
+
+namespace art {
+namespace gc {
+namespace space {
+
+// A bump pointer space allocates by atomically advancing the end of the space and can't free
+// individual objects. It is the destination of compacting collections, which copy the reachable
+// objects into an empty bump pointer space and then release the space they were evacuated from
+// as a whole.
+class BumpPointerSpace : public ContinuousMemMapAllocSpace {
+ public:
+  // Objects are allocated at this alignment, the same as the malloc spaces.
+  static constexpr size_t kAlignment = 8;
+
+  // Create a bump pointer space with the requested capacity. The requested base address is not
+  // guaranteed to be granted, if it is required, the caller should call Begin on the returned
+  // space to confirm the request was granted.
+  static BumpPointerSpace* Create(const std::string& name, size_t capacity, byte* requested_begin);
+
+  SpaceType GetType() const {
+    return kSpaceTypeBumpPointerSpace;
+  }
+
+  // Allocate num_bytes, returns NULL if the space is full.
+  virtual mirror::Object* Alloc(Thread* self, size_t num_bytes, size_t* bytes_allocated);
+  mirror::Object* AllocNonvirtual(size_t num_bytes);
+
+  // Return the storage space required by obj.
+  virtual size_t AllocationSize(const mirror::Object* obj)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    return AllocationSizeNonvirtual(obj);
+  }
+
+  size_t AllocationSizeNonvirtual(const mirror::Object* obj)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Individual objects can't be freed, the space is only ever cleared as a whole.
+  virtual size_t Free(Thread*, mirror::Object*) {
+    LOG(FATAL) << "Unimplemented";
+    return 0;
+  }
+
+  virtual size_t FreeList(Thread*, size_t, mirror::Object**) {
+    LOG(FATAL) << "Unimplemented";
+    return 0;
+  }
+
+  // The address past which nothing may be allocated.
+  byte* Limit() const {
+    return Begin() + Capacity();
+  }
+
+  // Release all of the pages of the space back to the system and reset it to be empty.
+  void Clear();
+
+  // Visit every object in the space in address order. Must not race with allocation.
+  void Walk(accounting::SpaceBitmap::Callback* callback, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  uint64_t GetBytesAllocated() const {
+    return Size();
+  }
+
+  uint64_t GetObjectsAllocated() const {
+    return static_cast<uint32_t>(objects_allocated_.load());
+  }
+
+  uint64_t GetTotalBytesAllocated() const {
+    return static_cast<uint32_t>(total_bytes_allocated_.load());
+  }
+
+  uint64_t GetTotalObjectsAllocated() const {
+    return static_cast<uint32_t>(total_objects_allocated_.load());
+  }
+
+  virtual void Dump(std::ostream& os) const;
+
+ protected:
+  BumpPointerSpace(const std::string& name, MemMap* mem_map);
+
+ private:
+  // Allocations are counted atomically as they happen concurrently.
+  AtomicInteger objects_allocated_;
+  AtomicInteger total_bytes_allocated_;
+  AtomicInteger total_objects_allocated_;
+
+  static size_t bitmap_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(BumpPointerSpace);
+};
+
+}  // namespace space
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_SPACE_BUMP_POINTER_SPACE_H_
@@ -37,6 +37,24 @@ inline mirror::Object* DlMallocSpace::AllocNonvirtual(Thread* self, size_t num_b
   return obj;
 }
 
+inline size_t DlMallocSpace::AllocBatchNonvirtual(Thread* self, size_t num_bytes, size_t max_count,
+                                                  mirror::Object** ptrs, size_t* bytes_allocated) {
+  size_t count = 0;
+  size_t total_bytes = 0;
+  MutexLock mu(self, lock_);
+  for (; count < max_count; ++count) {
+    size_t chunk_bytes;
+    mirror::Object* obj = AllocWithoutGrowthLocked(num_bytes, &chunk_bytes);
+    if (obj == NULL) {
+      break;
+    }
+    ptrs[count] = obj;
+    total_bytes += chunk_bytes;
+  }
+  *bytes_allocated = total_bytes;
+  return count;
+}
+
 inline mirror::Object* DlMallocSpace::AllocWithoutGrowthLocked(size_t num_bytes, size_t* bytes_allocated) {
   mirror::Object* result = reinterpret_cast<mirror::Object*>(mspace_malloc(mspace_, num_bytes));
   if (result != NULL) {
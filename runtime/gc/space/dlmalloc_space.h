@@ -18,30 +18,15 @@
 #define ART_RUNTIME_GC_SPACE_DLMALLOC_SPACE_H_
 
 #include "gc/allocator/dlmalloc.h"
-#include "space.h"
+#include "malloc_space.h"
 
 namespace art {
 namespace gc {
-
-namespace collector {
-  class MarkSweep;
-}  // namespace collector
-
 namespace space {
 
-// An alloc space is a space where objects may be allocated and garbage collected.
-class DlMallocSpace : public MemMapSpace, public AllocSpace {
+// An alloc space backed by a dlmalloc mspace.
+class DlMallocSpace : public MallocSpace {
  public:
-  typedef void(*WalkCallback)(void *start, void *end, size_t num_bytes, void* callback_arg);
-
-  SpaceType GetType() const {
-    if (GetGcRetentionPolicy() == kGcRetentionPolicyFullCollect) {
-      return kSpaceTypeZygoteSpace;
-    } else {
-      return kSpaceTypeAllocSpace;
-    }
-  }
-
   // Create a AllocSpace with the requested sizes. The requested
   // base address is not guaranteed to be granted, if it is required,
   // the caller should call Begin on the returned space to confirm
@@ -49,11 +34,11 @@ class DlMallocSpace : public MemMapSpace, public AllocSpace {
   static DlMallocSpace* Create(const std::string& name, size_t initial_size, size_t growth_limit,
                                size_t capacity, byte* requested_begin);
 
-  // Allocate num_bytes without allowing the underlying mspace to grow.
+  // Allocate num_bytes allowing the underlying mspace to grow.
   virtual mirror::Object* AllocWithGrowth(Thread* self, size_t num_bytes,
                                           size_t* bytes_allocated) LOCKS_EXCLUDED(lock_);
 
-  // Allocate num_bytes allowing the underlying mspace to grow.
+  // Allocate num_bytes without allowing the underlying mspace to grow.
   virtual mirror::Object* Alloc(Thread* self, size_t num_bytes, size_t* bytes_allocated);
 
   // Return the storage space required by obj.
@@ -63,70 +48,34 @@ class DlMallocSpace : public MemMapSpace, public AllocSpace {
 
   mirror::Object* AllocNonvirtual(Thread* self, size_t num_bytes, size_t* bytes_allocated);
 
+  // Allocate up to max_count chunks of num_bytes each while only acquiring the space's lock once,
+  // storing them in ptrs. Unlike AllocNonvirtual, the returned memory is not zeroed. Returns the
+  // number of chunks allocated and their total storage size in bytes_allocated.
+  size_t AllocBatchNonvirtual(Thread* self, size_t num_bytes, size_t max_count,
+                              mirror::Object** ptrs, size_t* bytes_allocated)
+      LOCKS_EXCLUDED(lock_);
+
   size_t AllocationSizeNonvirtual(const mirror::Object* obj) {
     return mspace_usable_size(const_cast<void*>(reinterpret_cast<const void*>(obj))) +
         kChunkOverhead;
   }
 
-  void* MoreCore(intptr_t increment);
-
   void* GetMspace() const {
     return mspace_;
   }
 
-  // Hands unused pages back to the system.
-  size_t Trim();
-
-  // Perform a mspace_inspect_all which calls back for each allocation chunk. The chunk may not be
-  // in use, indicated by num_bytes equaling zero.
-  void Walk(WalkCallback callback, void* arg) LOCKS_EXCLUDED(lock_);
-
-  // Returns the number of bytes that the space has currently obtained from the system. This is
-  // greater or equal to the amount of live data in the space.
-  size_t GetFootprint();
+  virtual size_t Trim();
 
-  // Returns the number of bytes that the heap is allowed to obtain from the system via MoreCore.
-  size_t GetFootprintLimit();
+  virtual void Walk(WalkCallback callback, void* arg) LOCKS_EXCLUDED(lock_);
 
-  // Set the maximum number of bytes that the heap is allowed to obtain from the system via
-  // MoreCore. Note this is used to stop the mspace growing beyond the limit to Capacity. When
-  // allocations fail we GC before increasing the footprint limit and allowing the mspace to grow.
-  void SetFootprintLimit(size_t limit);
-
-  // Removes the fork time growth limit on capacity, allowing the application to allocate up to the
-  // maximum reserved size of the heap.
-  void ClearGrowthLimit() {
-    growth_limit_ = NonGrowthLimitCapacity();
-  }
-
-  // Override capacity so that we only return the possibly limited capacity
-  size_t Capacity() const {
-    return growth_limit_;
-  }
-
-  // The total amount of memory reserved for the alloc space.
-  size_t NonGrowthLimitCapacity() const {
-    return GetMemMap()->Size();
-  }
+  virtual size_t GetFootprint();
+  virtual size_t GetFootprintLimit();
+  virtual void SetFootprintLimit(size_t limit);
 
-  accounting::SpaceBitmap* GetLiveBitmap() const {
-    return live_bitmap_.get();
+  virtual bool IsDlMallocSpace() const {
+    return true;
   }
 
-  accounting::SpaceBitmap* GetMarkBitmap() const {
-    return mark_bitmap_.get();
-  }
-
-  void Dump(std::ostream& os) const;
-
-  void SetGrowthLimit(size_t growth_limit);
-
-  // Swap the live and mark bitmaps of this space. This is used by the GC for concurrent sweeping.
-  void SwapBitmaps();
-
-  // Turn ourself into a zygote space and return a new alloc space which has our unused memory.
-  DlMallocSpace* CreateZygoteSpace(const char* alloc_space_name);
-
   uint64_t GetBytesAllocated() const {
     return num_bytes_allocated_;
   }
@@ -143,30 +92,25 @@ class DlMallocSpace : public MemMapSpace, public AllocSpace {
     return total_objects_allocated_;
   }
 
-  // Returns the class of a recently freed object.
-  mirror::Class* FindRecentFreedObject(const mirror::Object* obj);
-
  protected:
   DlMallocSpace(const std::string& name, MemMap* mem_map, void* mspace, byte* begin, byte* end,
                 size_t growth_limit);
 
+  virtual void* CreateAllocator(void* base, size_t morecore_start, size_t initial_size,
+                                size_t /*maximum_size*/) {
+    return CreateMspace(base, morecore_start, initial_size);
+  }
+
+  virtual MallocSpace* CreateInstance(const std::string& name, MemMap* mem_map, void* allocator,
+                                      byte* begin, byte* end, size_t growth_limit) {
+    return new DlMallocSpace(name, mem_map, allocator, begin, end, growth_limit);
+  }
+
  private:
   size_t InternalAllocationSize(const mirror::Object* obj);
   mirror::Object* AllocWithoutGrowthLocked(size_t num_bytes, size_t* bytes_allocated)
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
-  bool Init(size_t initial_size, size_t maximum_size, size_t growth_size, byte* requested_base);
-  void RegisterRecentFree(mirror::Object* ptr);
-  static void* CreateMallocSpace(void* base, size_t morecore_start, size_t initial_size);
-
-  UniquePtr<accounting::SpaceBitmap> live_bitmap_;
-  UniquePtr<accounting::SpaceBitmap> mark_bitmap_;
-  UniquePtr<accounting::SpaceBitmap> temp_bitmap_;
-
-  // Recent allocation buffer.
-  static constexpr size_t kRecentFreeCount = kDebugSpaces ? (1 << 16) : 0;
-  static constexpr size_t kRecentFreeMask = kRecentFreeCount - 1;
-  std::pair<const mirror::Object*, mirror::Class*> recent_freed_objects_[kRecentFreeCount];
-  size_t recent_free_pos_;
+  static void* CreateMspace(void* base, size_t morecore_start, size_t initial_size);
 
   // Approximate number of bytes which have been allocated into the space.
   size_t num_bytes_allocated_;
@@ -174,28 +118,12 @@ class DlMallocSpace : public MemMapSpace, public AllocSpace {
   size_t total_bytes_allocated_;
   size_t total_objects_allocated_;
 
-  static size_t bitmap_index_;
-
   // The boundary tag overhead.
   static const size_t kChunkOverhead = kWordSize;
 
-  // Used to ensure mutual exclusion when the allocation spaces data structures are being modified.
-  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
-
   // Underlying malloc space
   void* const mspace_;
 
-  // The capacity of the alloc space until such time that ClearGrowthLimit is called.
-  // The underlying mem_map_ controls the maximum size we allow the heap to grow to. The growth
-  // limit is a value <= to the mem_map_ capacity used for ergonomic reasons because of the zygote.
-  // Prior to forking the zygote the heap will have a maximally sized mem_map_ but the growth_limit_
-  // will be set to a lower value. The growth_limit_ is used as the capacity of the alloc_space_,
-  // however, capacity normally can't vary. In the case of the growth_limit_ it can be cleared
-  // one time by a call to ClearGrowthLimit.
-  size_t growth_limit_;
-
-  friend class collector::MarkSweep;
-
   DISALLOW_COPY_AND_ASSIGN(DlMallocSpace);
 };
 
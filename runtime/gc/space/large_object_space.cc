@@ -88,6 +88,29 @@ size_t LargeObjectMapSpace::Free(Thread* self, mirror::Object* ptr) {
   return allocation_size;
 }
 
+size_t LargeObjectMapSpace::FreeList(Thread* self, size_t num_ptrs, mirror::Object** ptrs) {
+  std::vector<MemMap*> freed_mem_maps;
+  freed_mem_maps.reserve(num_ptrs);
+  size_t total = 0;
+  {
+    MutexLock mu(self, lock_);
+    for (size_t i = 0; i < num_ptrs; ++i) {
+      MemMaps::iterator found = mem_maps_.find(ptrs[i]);
+      CHECK(found != mem_maps_.end()) << "Attempted to free large object which was not live";
+      const size_t allocation_size = found->second->Size();
+      DCHECK_GE(num_bytes_allocated_, allocation_size);
+      num_bytes_allocated_ -= allocation_size;
+      --num_objects_allocated_;
+      total += allocation_size;
+      freed_mem_maps.push_back(found->second);
+      mem_maps_.erase(found);
+    }
+  }
+  // Nobody else can reach the memory any more, so unmap it without holding the lock.
+  STLDeleteElements(&freed_mem_maps);
+  return total;
+}
+
 size_t LargeObjectMapSpace::AllocationSize(const mirror::Object* obj) {
   MutexLock mu(Thread::Current(), lock_);
   MemMaps::iterator found = mem_maps_.find(const_cast<mirror::Object*>(obj));
@@ -106,7 +129,7 @@ size_t LargeObjectSpace::FreeList(Thread* self, size_t num_ptrs, mirror::Object*
   return total;
 }
 
-void LargeObjectMapSpace::Walk(DlMallocSpace::WalkCallback callback, void* arg) {
+void LargeObjectMapSpace::Walk(MallocSpace::WalkCallback callback, void* arg) {
   MutexLock mu(Thread::Current(), lock_);
   for (MemMaps::iterator it = mem_maps_.begin(); it != mem_maps_.end(); ++it) {
     MemMap* mem_map = it->second;
@@ -145,7 +168,7 @@ FreeListSpace::FreeListSpace(const std::string& name, MemMap* mem_map, byte* beg
 
 FreeListSpace::~FreeListSpace() {}
 
-void FreeListSpace::Walk(DlMallocSpace::WalkCallback callback, void* arg) {
+void FreeListSpace::Walk(MallocSpace::WalkCallback callback, void* arg) {
   MutexLock mu(Thread::Current(), lock_);
   uintptr_t free_end_start = reinterpret_cast<uintptr_t>(end_) - free_end_;
   AllocationHeader* cur_header = reinterpret_cast<AllocationHeader*>(Begin());
@@ -185,8 +208,38 @@ FreeListSpace::AllocationHeader* FreeListSpace::AllocationHeader::GetNextNonFree
   }
 }
 
+void FreeListSpace::ReleaseTrailingPages(mirror::Object* obj) {
+  // The object is still allocated, so only the thread freeing it can touch its memory. The header
+  // page is left alone: until the lock is taken the header must keep telling the other threads
+  // that the block is in use.
+  AllocationHeader* header = GetAllocationHeader(obj);
+  size_t allocation_size = header->AllocationSize();
+  DCHECK(IsAligned<kAlignment>(allocation_size));
+  if (allocation_size > kAlignment) {
+    madvise(reinterpret_cast<byte*>(header) + kAlignment, allocation_size - kAlignment,
+            MADV_DONTNEED);
+  }
+}
+
 size_t FreeListSpace::Free(Thread* self, mirror::Object* obj) {
+  ReleaseTrailingPages(obj);
+  MutexLock mu(self, lock_);
+  return FreeLocked(obj);
+}
+
+size_t FreeListSpace::FreeList(Thread* self, size_t num_ptrs, mirror::Object** ptrs) {
+  for (size_t i = 0; i < num_ptrs; ++i) {
+    ReleaseTrailingPages(ptrs[i]);
+  }
   MutexLock mu(self, lock_);
+  size_t total = 0;
+  for (size_t i = 0; i < num_ptrs; ++i) {
+    total += FreeLocked(ptrs[i]);
+  }
+  return total;
+}
+
+size_t FreeListSpace::FreeLocked(mirror::Object* obj) {
   DCHECK(Contains(obj));
   AllocationHeader* header = GetAllocationHeader(obj);
   CHECK(IsAligned<kAlignment>(header));
@@ -227,7 +280,9 @@ size_t FreeListSpace::Free(Thread* self, mirror::Object* obj) {
   --num_objects_allocated_;
   DCHECK_LE(allocation_size, num_bytes_allocated_);
   num_bytes_allocated_ -= allocation_size;
-  madvise(header, allocation_size, MADV_DONTNEED);
+  // The rest of the block was released before the lock was taken. Zeroing the header page marks
+  // the block free for GetNextNonFree and hands out zeroed memory on the next allocation.
+  madvise(header, kAlignment, MADV_DONTNEED);
   if (kIsDebugBuild) {
     // Can't disallow reads since we use them to find next chunks during coalescing.
     mprotect(header, allocation_size, PROT_READ);
@@ -18,7 +18,7 @@
 #define ART_RUNTIME_GC_SPACE_LARGE_OBJECT_SPACE_H_
 
 #include "gc/accounting/gc_allocator.h"
-#include "dlmalloc_space.h"
+#include "malloc_space.h"
 #include "safe_map.h"
 #include "space.h"
 
@@ -38,7 +38,7 @@ class LargeObjectSpace : public DiscontinuousSpace, public AllocSpace {
 
   virtual void SwapBitmaps();
   virtual void CopyLiveToMarked();
-  virtual void Walk(DlMallocSpace::WalkCallback, void* arg) = 0;
+  virtual void Walk(MallocSpace::WalkCallback, void* arg) = 0;
   virtual ~LargeObjectSpace() {}
 
   uint64_t GetBytesAllocated() const {
@@ -57,7 +57,7 @@ class LargeObjectSpace : public DiscontinuousSpace, public AllocSpace {
     return total_objects_allocated_;
   }
 
-  size_t FreeList(Thread* self, size_t num_ptrs, mirror::Object** ptrs);
+  virtual size_t FreeList(Thread* self, size_t num_ptrs, mirror::Object** ptrs);
 
  protected:
   explicit LargeObjectSpace(const std::string& name);
@@ -85,7 +85,10 @@ class LargeObjectMapSpace : public LargeObjectSpace {
   size_t AllocationSize(const mirror::Object* obj);
   mirror::Object* Alloc(Thread* self, size_t num_bytes, size_t* bytes_allocated);
   size_t Free(Thread* self, mirror::Object* ptr);
-  void Walk(DlMallocSpace::WalkCallback, void* arg) LOCKS_EXCLUDED(lock_);
+  // Frees the objects under a single acquisition of the lock, the memory is unmapped after the
+  // lock is released.
+  size_t FreeList(Thread* self, size_t num_ptrs, mirror::Object** ptrs) LOCKS_EXCLUDED(lock_);
+  void Walk(MallocSpace::WalkCallback, void* arg) LOCKS_EXCLUDED(lock_);
   // TODO: disabling thread safety analysis as this may be called when we already hold lock_.
   bool Contains(const mirror::Object* obj) const NO_THREAD_SAFETY_ANALYSIS;
 
@@ -110,9 +113,12 @@ class FreeListSpace : public LargeObjectSpace {
 
   size_t AllocationSize(const mirror::Object* obj) EXCLUSIVE_LOCKS_REQUIRED(lock_);
   mirror::Object* Alloc(Thread* self, size_t num_bytes, size_t* bytes_allocated);
-  size_t Free(Thread* self, mirror::Object* obj);
+  size_t Free(Thread* self, mirror::Object* obj) LOCKS_EXCLUDED(lock_);
+  // Frees the objects under a single acquisition of the lock, most of their pages are released
+  // before the lock is taken.
+  size_t FreeList(Thread* self, size_t num_ptrs, mirror::Object** ptrs) LOCKS_EXCLUDED(lock_);
   bool Contains(const mirror::Object* obj) const;
-  void Walk(DlMallocSpace::WalkCallback callback, void* arg) LOCKS_EXCLUDED(lock_);
+  void Walk(MallocSpace::WalkCallback callback, void* arg) LOCKS_EXCLUDED(lock_);
 
   // Address at which the space begins.
   byte* Begin() const {
@@ -212,6 +218,10 @@ class FreeListSpace : public LargeObjectSpace {
 
   // Removes header from the free blocks set by finding the corresponding iterator and erasing it.
   void RemoveFreePrev(AllocationHeader* header) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Releases the pages of a block which is about to be freed, all but its header page.
+  void ReleaseTrailingPages(mirror::Object* obj) LOCKS_EXCLUDED(lock_);
+  // Frees the block of obj, ReleaseTrailingPages must have been called on it.
+  size_t FreeLocked(mirror::Object* obj) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
   // Finds the allocation header corresponding to obj.
   AllocationHeader* GetAllocationHeader(const mirror::Object* obj);
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "large_object_space.h"
+
+#include <vector>
+
+#include "common_test.h"
+#include "UniquePtr.h"
+
+namespace art {
+namespace gc {
+namespace space {
+
+class LargeObjectSpaceTest : public CommonTest {
+ protected:
+  // Allocates objects of assorted sizes, frees every other one with FreeList and checks that the
+  // survivors are untouched and that the freed memory comes back zeroed.
+  void FreeListTest(LargeObjectSpace* space);
+};
+
+static const size_t kNumObjects = 64;
+
+static size_t ObjectSize(size_t i) {
+  // Mix sizes below a page, of exactly one page and spanning several pages.
+  return (i % 5) * kPageSize + (i % 3) * (kPageSize / 3) + sizeof(uint32_t);
+}
+
+static void CheckFilled(const byte* begin, size_t size, byte value) {
+  for (size_t i = 0; i < size; ++i) {
+    if (begin[i] != value) {
+      EXPECT_EQ(value, begin[i]) << "at offset " << i << " of " << size;
+      return;
+    }
+  }
+}
+
+void LargeObjectSpaceTest::FreeListTest(LargeObjectSpace* space) {
+  Thread* self = Thread::Current();
+  std::vector<mirror::Object*> objects;
+  size_t total_bytes = 0;
+  for (size_t i = 0; i < kNumObjects; ++i) {
+    size_t bytes_allocated = 0;
+    mirror::Object* obj = space->Alloc(self, ObjectSize(i), &bytes_allocated);
+    ASSERT_TRUE(obj != NULL);
+    EXPECT_GE(bytes_allocated, ObjectSize(i));
+    memset(obj, static_cast<int>(i + 1), ObjectSize(i));
+    objects.push_back(obj);
+    total_bytes += bytes_allocated;
+  }
+  EXPECT_EQ(kNumObjects, space->GetObjectsAllocated());
+  EXPECT_EQ(total_bytes, space->GetBytesAllocated());
+
+  // Free every other object, the free blocks are not adjacent yet.
+  std::vector<mirror::Object*> garbage;
+  for (size_t i = 0; i < kNumObjects; i += 2) {
+    garbage.push_back(objects[i]);
+  }
+  size_t freed_bytes = space->FreeList(self, garbage.size(), &garbage[0]);
+  EXPECT_EQ(kNumObjects - garbage.size(), space->GetObjectsAllocated());
+  EXPECT_EQ(total_bytes - freed_bytes, space->GetBytesAllocated());
+  for (size_t i = 1; i < kNumObjects; i += 2) {
+    CheckFilled(reinterpret_cast<const byte*>(objects[i]), ObjectSize(i),
+                static_cast<byte>(i + 1));
+  }
+
+  // The freed memory is handed out zeroed again.
+  for (size_t i = 0; i < kNumObjects; i += 2) {
+    size_t bytes_allocated = 0;
+    objects[i] = space->Alloc(self, ObjectSize(i), &bytes_allocated);
+    ASSERT_TRUE(objects[i] != NULL);
+    CheckFilled(reinterpret_cast<const byte*>(objects[i]), ObjectSize(i), 0);
+  }
+
+  // Freeing everything coalesces neighbouring blocks.
+  size_t remaining_bytes = space->GetBytesAllocated();
+  EXPECT_EQ(remaining_bytes, space->FreeList(self, objects.size(), &objects[0]));
+  EXPECT_EQ(0U, space->GetObjectsAllocated());
+  EXPECT_EQ(0U, space->GetBytesAllocated());
+}
+
+TEST_F(LargeObjectSpaceTest, LargeObjectMapSpaceFreeList) {
+  UniquePtr<LargeObjectSpace> space(LargeObjectMapSpace::Create("map space"));
+  ASSERT_TRUE(space.get() != NULL);
+  FreeListTest(space.get());
+}
+
+TEST_F(LargeObjectSpaceTest, FreeListSpaceFreeList) {
+  UniquePtr<LargeObjectSpace> space(FreeListSpace::Create("free list space", NULL, 128 * MB));
+  ASSERT_TRUE(space.get() != NULL);
+  FreeListTest(space.get());
+}
+
+}  // namespace space
+}  // namespace gc
+}  // namespace art
@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rosalloc_space.h"
+#include "rosalloc_space-inl.h"
+#include "gc/accounting/card_table.h"
+#include "gc/heap.h"
+#include "gc/space/space-inl.h"
+#include "mirror/object-inl.h"
+#include "runtime.h"
+#include "thread.h"
+#include "utils.h"
+
+namespace art {
+namespace gc {
+namespace space {
+
+RosAllocSpace::RosAllocSpace(const std::string& name, MemMap* mem_map,
+                             allocator::RosAlloc* rosalloc, byte* begin, byte* end,
+                             size_t growth_limit)
+    : MallocSpace(name, mem_map, begin, end, growth_limit), total_bytes_freed_(0),
+      total_objects_freed_(0), rosalloc_(rosalloc) {
+  CHECK(rosalloc != NULL);
+}
+
+RosAllocSpace* RosAllocSpace::Create(const std::string& name, size_t initial_size,
+                                     size_t growth_limit, size_t capacity,
+                                     byte* requested_begin) {
+  // Memory we promise to rosalloc before it asks for morecore, the rest of the initial size is
+  // obtained through MoreCore on demand just like for dlmalloc.
+  size_t starting_size = kPageSize;
+  uint64_t start_time = 0;
+  if (VLOG_IS_ON(heap) || VLOG_IS_ON(startup)) {
+    start_time = NanoTime();
+    VLOG(startup) << "RosAllocSpace::Create entering " << name
+                  << " initial_size=" << PrettySize(initial_size)
+                  << " growth_limit=" << PrettySize(growth_limit)
+                  << " capacity=" << PrettySize(capacity)
+                  << " requested_begin=" << reinterpret_cast<void*>(requested_begin);
+  }
+
+  UniquePtr<MemMap> mem_map(CreateMemMap(name, starting_size, &initial_size, &growth_limit,
+                                          &capacity, requested_begin));
+  if (mem_map.get() == NULL) {
+    return NULL;
+  }
+
+  allocator::RosAlloc* rosalloc = CreateRosAlloc(mem_map->Begin(), starting_size, initial_size,
+                                                 capacity);
+  if (rosalloc == NULL) {
+    LOG(ERROR) << "Failed to initialize rosalloc for alloc space (" << name << ")";
+    return NULL;
+  }
+
+  // Protect memory beyond the initial size.
+  byte* end = mem_map->Begin() + starting_size;
+  if (capacity - initial_size > 0) {
+    CHECK_MEMORY_CALL(mprotect, (end, capacity - initial_size, PROT_NONE), name);
+  }
+
+  // Everything is set so record in immutable structure and leave
+  MemMap* mem_map_ptr = mem_map.release();
+  RosAllocSpace* space = new RosAllocSpace(name, mem_map_ptr, rosalloc, mem_map_ptr->Begin(), end,
+                                           growth_limit);
+  if (VLOG_IS_ON(heap) || VLOG_IS_ON(startup)) {
+    LOG(INFO) << "RosAllocSpace::Create exiting (" << PrettyDuration(NanoTime() - start_time)
+        << " ) " << *space;
+  }
+  return space;
+}
+
+allocator::RosAlloc* RosAllocSpace::CreateRosAlloc(void* begin, size_t morecore_start,
+                                                   size_t initial_size, size_t maximum_size) {
+  allocator::RosAlloc* rosalloc = new allocator::RosAlloc(begin, morecore_start, maximum_size);
+  // Do not allow morecore requests to succeed beyond the initial size of the heap.
+  rosalloc->SetFootprintLimit(initial_size);
+  return rosalloc;
+}
+
+mirror::Object* RosAllocSpace::Alloc(Thread* self, size_t num_bytes, size_t* bytes_allocated) {
+  return AllocNonvirtual(self, num_bytes, bytes_allocated);
+}
+
+mirror::Object* RosAllocSpace::AllocWithGrowth(Thread* self, size_t num_bytes,
+                                               size_t* bytes_allocated) {
+  mirror::Object* result;
+  {
+    MutexLock mu(self, lock_);
+    // Grow as much as possible within the space.
+    size_t max_allowed = Capacity();
+    rosalloc_->SetFootprintLimit(max_allowed);
+    // Try the allocation.
+    result = AllocCommon(self, num_bytes, bytes_allocated);
+    // Shrink back down as small as possible.
+    size_t footprint = rosalloc_->Footprint();
+    rosalloc_->SetFootprintLimit(footprint);
+  }
+  if (result != NULL) {
+    // Zero freshly allocated memory, done while not holding the space's lock.
+    memset(result, 0, num_bytes);
+  }
+  // Return the new allocation or NULL.
+  CHECK(!kDebugSpaces || result == NULL || Contains(result));
+  return result;
+}
+
+size_t RosAllocSpace::Free(Thread* self, mirror::Object* ptr) {
+  if (kDebugSpaces) {
+    CHECK(ptr != NULL);
+    CHECK(Contains(ptr)) << "Free (" << ptr << ") not in bounds of heap " << *this;
+  }
+  if (kRecentFreeCount > 0) {
+    MutexLock mu(self, lock_);
+    RegisterRecentFree(ptr);
+  }
+  const size_t bytes_freed = rosalloc_->Free(self, ptr);
+  AddToCounter(&total_bytes_freed_, bytes_freed);
+  AddToCounter(&total_objects_freed_, 1);
+  return bytes_freed;
+}
+
+size_t RosAllocSpace::FreeList(Thread* self, size_t num_ptrs, mirror::Object** ptrs) {
+  DCHECK(ptrs != NULL);
+
+  if (kRecentFreeCount > 0) {
+    MutexLock mu(self, lock_);
+    for (size_t i = 0; i < num_ptrs; i++) {
+      RegisterRecentFree(ptrs[i]);
+    }
+  }
+
+  if (kDebugSpaces) {
+    size_t num_broken_ptrs = 0;
+    for (size_t i = 0; i < num_ptrs; i++) {
+      if (!Contains(ptrs[i])) {
+        num_broken_ptrs++;
+        LOG(ERROR) << "FreeList[" << i << "] (" << ptrs[i] << ") not in bounds of heap " << *this;
+      } else {
+        size_t size = rosalloc_->UsableSize(ptrs[i]);
+        memset(ptrs[i], 0xEF, size);
+      }
+    }
+    CHECK_EQ(num_broken_ptrs, 0u);
+  }
+
+  const size_t bytes_freed = rosalloc_->BulkFree(self, reinterpret_cast<void**>(ptrs), num_ptrs);
+  AddToCounter(&total_bytes_freed_, bytes_freed);
+  AddToCounter(&total_objects_freed_, num_ptrs);
+  return bytes_freed;
+}
+
+void RosAllocSpace::AddToCounter(volatile int64_t* counter, int64_t delta) {
+  int64_t old_value;
+  do {
+    old_value = QuasiAtomic::Read64(counter);
+  } while (!QuasiAtomic::Cas64(old_value, old_value + delta, counter));
+}
+
+// Callback from rosalloc when it needs to change the footprint.
+extern "C" void* art_heap_rosalloc_morecore(allocator::RosAlloc* rosalloc, intptr_t increment) {
+  Heap* heap = Runtime::Current()->GetHeap();
+  for (const auto& space : heap->GetContinuousSpaces()) {
+    if (space->IsRosAllocSpace()) {
+      RosAllocSpace* rosalloc_space = space->AsRosAllocSpace();
+      if (rosalloc_space->GetRosAlloc() == rosalloc) {
+        return rosalloc_space->MoreCore(increment);
+      }
+    }
+  }
+  LOG(FATAL) << "Unable to find the space of rosalloc " << rosalloc;
+  return NULL;
+}
+
+size_t RosAllocSpace::AllocationSize(const mirror::Object* obj) {
+  return AllocationSizeNonvirtual(obj);
+}
+
+size_t RosAllocSpace::Trim() {
+  return rosalloc_->Trim();
+}
+
+void RosAllocSpace::Walk(void(*callback)(void *start, void *end, size_t num_bytes, void* callback_arg),
+                         void* arg) {
+  rosalloc_->InspectAll(callback, arg);
+  callback(NULL, NULL, 0, arg);  // Indicate end of a space.
+}
+
+size_t RosAllocSpace::GetFootprint() {
+  return rosalloc_->Footprint();
+}
+
+size_t RosAllocSpace::GetFootprintLimit() {
+  return rosalloc_->FootprintLimit();
+}
+
+void RosAllocSpace::SetFootprintLimit(size_t new_size) {
+  VLOG(heap) << "RosAllocSpace::SetFootprintLimit " << PrettySize(new_size);
+  // RosAlloc itself doesn't let the limit drop below the current footprint.
+  rosalloc_->SetFootprintLimit(RoundUp(new_size, kPageSize));
+}
+
+static void CountBytesAllocatedCallback(void* start, void* end, size_t used_bytes, void* arg) {
+  *reinterpret_cast<uint64_t*>(arg) += used_bytes;
+}
+
+static void CountObjectsAllocatedCallback(void* start, void* end, size_t used_bytes, void* arg) {
+  if (used_bytes > 0) {
+    ++*reinterpret_cast<uint64_t*>(arg);
+  }
+}
+
+uint64_t RosAllocSpace::GetBytesAllocated() const {
+  uint64_t bytes_allocated = 0;
+  rosalloc_->InspectAll(CountBytesAllocatedCallback, &bytes_allocated);
+  return bytes_allocated;
+}
+
+uint64_t RosAllocSpace::GetObjectsAllocated() const {
+  uint64_t objects_allocated = 0;
+  rosalloc_->InspectAll(CountObjectsAllocatedCallback, &objects_allocated);
+  return objects_allocated;
+}
+
+void RosAllocSpace::RevokeThreadLocalBuffers(Thread* thread) {
+  rosalloc_->RevokeThreadLocalRuns(thread);
+}
+
+}  // namespace space
+}  // namespace gc
+}  // namespace art
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_SPACE_ROSALLOC_SPACE_H_
+#define ART_RUNTIME_GC_SPACE_ROSALLOC_SPACE_H_
+
+#include "atomic.h"
+#include "gc/allocator/rosalloc.h"
+#include "malloc_space.h"
+
+namespace art {
+namespace gc {
+namespace space {
+
+// An alloc space backed by a RosAlloc, which serves small objects from per size class runs and
+// lets threads allocate the smallest sizes from thread-local runs without locking.
+class RosAllocSpace : public MallocSpace {
+ public:
+  // Create a RosAllocSpace with the requested sizes. The requested base address is not
+  // guaranteed to be granted, if it is required, the caller should call Begin on the returned
+  // space to confirm the request was granted.
+  static RosAllocSpace* Create(const std::string& name, size_t initial_size, size_t growth_limit,
+                               size_t capacity, byte* requested_begin);
+
+  virtual ~RosAllocSpace() {
+    delete rosalloc_;
+  }
+
+  virtual mirror::Object* AllocWithGrowth(Thread* self, size_t num_bytes,
+                                          size_t* bytes_allocated) LOCKS_EXCLUDED(lock_);
+  virtual mirror::Object* Alloc(Thread* self, size_t num_bytes, size_t* bytes_allocated);
+  virtual size_t AllocationSize(const mirror::Object* obj);
+  virtual size_t Free(Thread* self, mirror::Object* ptr);
+  virtual size_t FreeList(Thread* self, size_t num_ptrs, mirror::Object** ptrs);
+
+  mirror::Object* AllocNonvirtual(Thread* self, size_t num_bytes, size_t* bytes_allocated);
+
+  size_t AllocationSizeNonvirtual(const mirror::Object* obj) {
+    return rosalloc_->UsableSize(const_cast<void*>(reinterpret_cast<const void*>(obj)));
+  }
+
+  allocator::RosAlloc* GetRosAlloc() const {
+    return rosalloc_;
+  }
+
+  virtual size_t Trim();
+  virtual void Walk(WalkCallback callback, void* arg) LOCKS_EXCLUDED(lock_);
+  virtual size_t GetFootprint();
+  virtual size_t GetFootprintLimit();
+  virtual void SetFootprintLimit(size_t limit);
+
+  // The allocation counts are computed by walking the runs, which makes these slower than their
+  // dlmalloc counterparts.
+  uint64_t GetBytesAllocated() const;
+  uint64_t GetObjectsAllocated() const;
+
+  uint64_t GetTotalBytesAllocated() const {
+    return GetBytesAllocated() + static_cast<uint64_t>(QuasiAtomic::Read64(&total_bytes_freed_));
+  }
+
+  uint64_t GetTotalObjectsAllocated() const {
+    return GetObjectsAllocated() +
+        static_cast<uint64_t>(QuasiAtomic::Read64(&total_objects_freed_));
+  }
+
+  // Returns the thread-local runs of thread to the allocator.
+  void RevokeThreadLocalBuffers(Thread* thread);
+
+  virtual bool IsRosAllocSpace() const {
+    return true;
+  }
+
+ protected:
+  RosAllocSpace(const std::string& name, MemMap* mem_map, allocator::RosAlloc* rosalloc,
+                byte* begin, byte* end, size_t growth_limit);
+
+  virtual void* CreateAllocator(void* base, size_t morecore_start, size_t initial_size,
+                                size_t maximum_size) {
+    return CreateRosAlloc(base, morecore_start, initial_size, maximum_size);
+  }
+
+  virtual MallocSpace* CreateInstance(const std::string& name, MemMap* mem_map, void* allocator,
+                                      byte* begin, byte* end, size_t growth_limit) {
+    return new RosAllocSpace(name, mem_map, reinterpret_cast<allocator::RosAlloc*>(allocator),
+                             begin, end, growth_limit);
+  }
+
+ private:
+  mirror::Object* AllocCommon(Thread* self, size_t num_bytes, size_t* bytes_allocated);
+  static allocator::RosAlloc* CreateRosAlloc(void* base, size_t morecore_start,
+                                             size_t initial_size, size_t maximum_size);
+  // Atomically adds delta to the 64-bit counter.
+  static void AddToCounter(volatile int64_t* counter, int64_t delta);
+
+  // Frees happen concurrently from the sweeping GC threads, so these are updated atomically. They
+  // are 64-bit since a long running process frees more than 4GB.
+  volatile int64_t total_bytes_freed_;
+  volatile int64_t total_objects_freed_;
+
+  // Underlying rosalloc.
+  allocator::RosAlloc* const rosalloc_;
+
+  DISALLOW_COPY_AND_ASSIGN(RosAllocSpace);
+};
+
+}  // namespace space
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_SPACE_ROSALLOC_SPACE_H_
@@ -19,8 +19,10 @@
 
 #include "space.h"
 
+#include "bump_pointer_space.h"
 #include "dlmalloc_space.h"
 #include "image_space.h"
+#include "rosalloc_space.h"
 
 namespace art {
 namespace gc {
@@ -31,11 +33,31 @@ inline ImageSpace* Space::AsImageSpace() {
   return down_cast<ImageSpace*>(down_cast<MemMapSpace*>(this));
 }
 
-inline DlMallocSpace* Space::AsDlMallocSpace() {
+inline MallocSpace* Space::AsMallocSpace() {
   DCHECK(GetType() == kSpaceTypeAllocSpace || GetType() == kSpaceTypeZygoteSpace);
+  return down_cast<MallocSpace*>(down_cast<MemMapSpace*>(this));
+}
+
+inline DlMallocSpace* Space::AsDlMallocSpace() {
+  DCHECK(IsDlMallocSpace());
   return down_cast<DlMallocSpace*>(down_cast<MemMapSpace*>(this));
 }
 
+inline RosAllocSpace* Space::AsRosAllocSpace() {
+  DCHECK(IsRosAllocSpace());
+  return down_cast<RosAllocSpace*>(down_cast<MemMapSpace*>(this));
+}
+
+inline BumpPointerSpace* Space::AsBumpPointerSpace() {
+  DCHECK(IsBumpPointerSpace());
+  return down_cast<BumpPointerSpace*>(down_cast<MemMapSpace*>(this));
+}
+
+inline ContinuousMemMapAllocSpace* Space::AsContinuousMemMapAllocSpace() {
+  DCHECK(IsContinuousMemMapAllocSpace());
+  return down_cast<ContinuousMemMapAllocSpace*>(down_cast<MemMapSpace*>(this));
+}
+
 inline LargeObjectSpace* Space::AsLargeObjectSpace() {
   DCHECK_EQ(GetType(), kSpaceTypeLargeObjectSpace);
   return reinterpret_cast<LargeObjectSpace*>(this);
@@ -40,11 +40,19 @@ namespace accounting {
 
 class Heap;
 
+namespace collector {
+  class MarkSweep;
+}  // namespace collector
+
 namespace space {
 
+class BumpPointerSpace;
+class ContinuousMemMapAllocSpace;
 class DlMallocSpace;
 class ImageSpace;
 class LargeObjectSpace;
+class MallocSpace;
+class RosAllocSpace;
 
 static constexpr bool kDebugSpaces = kIsDebugBuild;
 
@@ -65,6 +73,7 @@ enum SpaceType {
   kSpaceTypeAllocSpace,
   kSpaceTypeZygoteSpace,
   kSpaceTypeLargeObjectSpace,
+  kSpaceTypeBumpPointerSpace,
 };
 std::ostream& operator<<(std::ostream& os, const SpaceType& space_type);
 
@@ -92,7 +101,7 @@ class Space {
   // Is the given object contained within this space?
   virtual bool Contains(const mirror::Object* obj) const = 0;
 
-  // The kind of space this: image, alloc, zygote, large object.
+  // The kind of space this: image, alloc, zygote, large object, bump pointer.
   virtual SpaceType GetType() const = 0;
 
   // Is this an image space, ie one backed by a memory mapped image file.
@@ -101,13 +110,39 @@ class Space {
   }
   ImageSpace* AsImageSpace();
 
-  // Is this a dlmalloc backed allocation space?
-  bool IsDlMallocSpace() const {
+  // Is this a malloc backed allocation space?
+  bool IsMallocSpace() const {
     SpaceType type = GetType();
     return type == kSpaceTypeAllocSpace || type == kSpaceTypeZygoteSpace;
   }
+  MallocSpace* AsMallocSpace();
+
+  // Is this a dlmalloc backed allocation space?
+  virtual bool IsDlMallocSpace() const {
+    return false;
+  }
   DlMallocSpace* AsDlMallocSpace();
 
+  // Is this a rosalloc backed allocation space?
+  virtual bool IsRosAllocSpace() const {
+    return false;
+  }
+  RosAllocSpace* AsRosAllocSpace();
+
+  // Is this a space that objects are allocated into by bumping a pointer, used as the destination
+  // of compacting collections?
+  bool IsBumpPointerSpace() const {
+    return GetType() == kSpaceTypeBumpPointerSpace;
+  }
+  BumpPointerSpace* AsBumpPointerSpace();
+
+  // Is this a continuous space that is allocated into and whose objects the GC marks and sweeps,
+  // ie a space that owns its live and mark bitmaps?
+  bool IsContinuousMemMapAllocSpace() const {
+    return IsMallocSpace() || IsBumpPointerSpace();
+  }
+  ContinuousMemMapAllocSpace* AsContinuousMemMapAllocSpace();
+
   // Is this the space allocated into by the Zygote and no-longer in use?
   bool IsZygoteSpace() const {
     return GetType() == kSpaceTypeZygoteSpace;
@@ -289,6 +324,37 @@ class MemMapSpace : public ContinuousSpace {
   DISALLOW_COPY_AND_ASSIGN(MemMapSpace);
 };
 
+// A continuous space that objects are allocated into and garbage collected from. The space owns
+// the live and mark bitmaps covering its capacity.
+class ContinuousMemMapAllocSpace : public MemMapSpace, public AllocSpace {
+ public:
+  accounting::SpaceBitmap* GetLiveBitmap() const {
+    return live_bitmap_.get();
+  }
+
+  accounting::SpaceBitmap* GetMarkBitmap() const {
+    return mark_bitmap_.get();
+  }
+
+  // Swap the live and mark bitmaps of this space. This is used by the GC for concurrent sweeping.
+  void SwapBitmaps();
+
+ protected:
+  ContinuousMemMapAllocSpace(const std::string& name, MemMap* mem_map, size_t initial_size,
+                             GcRetentionPolicy gc_retention_policy)
+      : MemMapSpace(name, mem_map, initial_size, gc_retention_policy) {
+  }
+
+  UniquePtr<accounting::SpaceBitmap> live_bitmap_;
+  UniquePtr<accounting::SpaceBitmap> mark_bitmap_;
+  UniquePtr<accounting::SpaceBitmap> temp_bitmap_;
+
+  friend class collector::MarkSweep;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ContinuousMemMapAllocSpace);
+};
+
 }  // namespace space
 }  // namespace gc
 }  // namespace art
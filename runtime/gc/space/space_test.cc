@@ -14,8 +14,10 @@
  * limitations under the License.
  */
 
+#include "bump_pointer_space.h"
 #include "dlmalloc_space.h"
 #include "large_object_space.h"
+#include "rosalloc_space.h"
 
 #include "common_test.h"
 #include "globals.h"
@@ -303,6 +305,110 @@ TEST_F(SpaceTest, AllocAndFreeList) {
   }
 }
 
+TEST_F(SpaceTest, AllocAndFree_RosAlloc) {
+  size_t dummy = 0;
+  RosAllocSpace* space(RosAllocSpace::Create("test", 4 * MB, 16 * MB, 16 * MB, NULL));
+  ASSERT_TRUE(space != NULL);
+  Thread* self = Thread::Current();
+
+  // Make space findable to the heap, will also delete space when runtime is cleaned up
+  AddContinuousSpace(space);
+
+  // Succeeds, fits without adjusting the footprint limit.
+  mirror::Object* ptr1 = space->Alloc(self, 1 * MB, &dummy);
+  EXPECT_TRUE(ptr1 != NULL);
+
+  // Fails, requires a higher footprint limit.
+  mirror::Object* ptr2 = space->Alloc(self, 8 * MB, &dummy);
+  EXPECT_TRUE(ptr2 == NULL);
+
+  // Succeeds, adjusts the footprint.
+  size_t ptr3_bytes_allocated;
+  mirror::Object* ptr3 = space->AllocWithGrowth(self, 8 * MB, &ptr3_bytes_allocated);
+  EXPECT_TRUE(ptr3 != NULL);
+  EXPECT_LE(8U * MB, ptr3_bytes_allocated);
+
+  // Also fails, requires a higher allowed footprint.
+  mirror::Object* ptr5 = space->AllocWithGrowth(self, 8 * MB, &dummy);
+  EXPECT_TRUE(ptr5 == NULL);
+
+  // Release some memory.
+  size_t free3 = space->AllocationSize(ptr3);
+  EXPECT_EQ(free3, ptr3_bytes_allocated);
+  EXPECT_EQ(free3, space->Free(self, ptr3));
+
+  // Succeeds, now that memory has been freed.
+  void* ptr6 = space->AllocWithGrowth(self, 9 * MB, &dummy);
+  EXPECT_TRUE(ptr6 != NULL);
+
+  // Final clean up.
+  size_t free1 = space->AllocationSize(ptr1);
+  space->Free(self, ptr1);
+  EXPECT_LE(1U * MB, free1);
+}
+
+TEST_F(SpaceTest, AllocAndFreeList_RosAlloc) {
+  RosAllocSpace* space(RosAllocSpace::Create("test", 4 * MB, 16 * MB, 16 * MB, NULL));
+  ASSERT_TRUE(space != NULL);
+
+  // Make space findable to the heap, will also delete space when runtime is cleaned up
+  AddContinuousSpace(space);
+  Thread* self = Thread::Current();
+
+  // Small objects come from the thread-local runs, larger ones from the shared runs.
+  const size_t sizes[] = { 16, 1024 };
+  for (size_t size : sizes) {
+    mirror::Object* lots_of_objects[1024];
+    size_t bytes_allocated = 0;
+    for (size_t i = 0; i < arraysize(lots_of_objects); i++) {
+      size_t allocation_size = 0;
+      lots_of_objects[i] = space->AllocWithGrowth(self, size, &allocation_size);
+      ASSERT_TRUE(lots_of_objects[i] != NULL);
+      EXPECT_EQ(allocation_size, space->AllocationSize(lots_of_objects[i]));
+      EXPECT_LE(size, allocation_size);
+      bytes_allocated += allocation_size;
+    }
+    EXPECT_EQ(bytes_allocated, space->FreeList(self, arraysize(lots_of_objects), lots_of_objects));
+  }
+
+  // Once the thread-local runs are revoked nothing remains allocated.
+  space->RevokeThreadLocalBuffers(self);
+  EXPECT_EQ(0U, space->GetBytesAllocated());
+  EXPECT_EQ(0U, space->GetObjectsAllocated());
+}
+
+TEST_F(SpaceTest, BumpPointerSpace) {
+  UniquePtr<BumpPointerSpace> space(BumpPointerSpace::Create("test", 1 * MB, NULL));
+  ASSERT_TRUE(space.get() != NULL);
+  Thread* self = Thread::Current();
+  EXPECT_EQ(0U, space->Size());
+
+  // Allocations are rounded up to the alignment and handed out in address order.
+  size_t bytes_allocated = 0;
+  mirror::Object* ptr1 = space->Alloc(self, 12, &bytes_allocated);
+  ASSERT_TRUE(ptr1 != NULL);
+  EXPECT_EQ(16U, bytes_allocated);
+  EXPECT_EQ(space->Begin(), reinterpret_cast<byte*>(ptr1));
+  mirror::Object* ptr2 = space->Alloc(self, 64 * KB, &bytes_allocated);
+  ASSERT_TRUE(ptr2 != NULL);
+  EXPECT_EQ(reinterpret_cast<byte*>(ptr1) + 16, reinterpret_cast<byte*>(ptr2));
+  EXPECT_EQ(16U + 64 * KB, space->Size());
+  EXPECT_EQ(2U, space->GetObjectsAllocated());
+
+  // Fails, there is no room left.
+  EXPECT_TRUE(space->Alloc(self, 1 * MB, &bytes_allocated) == NULL);
+
+  // Clearing releases everything, the total counters keep counting.
+  space->Clear();
+  EXPECT_EQ(0U, space->Size());
+  EXPECT_EQ(0U, space->GetObjectsAllocated());
+  EXPECT_EQ(2U, space->GetTotalObjectsAllocated());
+  EXPECT_EQ(16U + 64 * KB, space->GetTotalBytesAllocated());
+  mirror::Object* ptr3 = space->Alloc(self, 1 * MB, &bytes_allocated);
+  ASSERT_TRUE(ptr3 != NULL);
+  EXPECT_EQ(space->Begin(), reinterpret_cast<byte*>(ptr3));
+}
+
 void SpaceTest::SizeFootPrintGrowthLimitAndTrimBody(DlMallocSpace* space, intptr_t object_size,
                                                     int round, size_t growth_limit) {
   if (((object_size > 0 && object_size >= static_cast<intptr_t>(growth_limit))) ||
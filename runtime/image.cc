@@ -24,7 +24,7 @@
 namespace art {
 
 const byte ImageHeader::kImageMagic[] = { 'a', 'r', 't', '\n' };
-const byte ImageHeader::kImageVersion[] = { '0', '0', '5', '\0' };
+const byte ImageHeader::kImageVersion[] = { '0', '0', '6', '\0' };
 
 ImageHeader::ImageHeader(uint32_t image_begin,
                          uint32_t image_size,
@@ -56,6 +56,8 @@ ImageHeader::ImageHeader(uint32_t image_begin,
   CHECK_LE(oat_data_end, oat_file_end);
   memcpy(magic_, kImageMagic, sizeof(kImageMagic));
   memcpy(version_, kImageVersion, sizeof(kImageVersion));
+  memset(bin_begin_, 0, sizeof(bin_begin_));
+  memset(bin_end_, 0, sizeof(bin_end_));
 }
 
 bool ImageHeader::IsValid() const {
@@ -102,6 +102,29 @@ class PACKED(4) ImageHeader {
   mirror::Object* GetImageRoot(ImageRoot image_root) const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // The image writer groups objects by how likely they are to be written at runtime, so that the
+  // pages every process dirties hold as few objects that stay clean as possible. The bins are laid
+  // out in this order and all but the first begin on a page boundary.
+  enum ImageBin {
+    kBinClean,             // Objects that are never written: initialized classes without mutable
+                           // statics, their fields and methods, char arrays.
+    kBinString,            // Strings, with their hash codes already computed.
+    kBinMisc,              // Everything not in another bin.
+    kBinStartup,           // Classes and methods named by the startup profile.
+    kBinClassDirty,        // Classes that still need initializing or have non-final statics.
+    kBinArtMethodDirty,    // Methods whose entrypoints are set at runtime.
+    kBinDexCache,          // DexCaches and their arrays, filled in as things are resolved.
+    kImageBinCount,
+  };
+
+  size_t GetBinBegin(ImageBin bin) const {
+    return bin_begin_[bin];
+  }
+
+  size_t GetBinEnd(ImageBin bin) const {
+    return bin_end_[bin];
+  }
+
  private:
   mirror::ObjectArray<mirror::Object>* GetImageRoots() const;
 
@@ -142,6 +165,10 @@ class PACKED(4) ImageHeader {
   // Absolute address of an Object[] of objects needed to reinitialize from an image.
   uint32_t image_roots_;
 
+  // Image offsets of where the objects of each bin begin and end.
+  uint32_t bin_begin_[kImageBinCount];
+  uint32_t bin_end_[kImageBinCount];
+
   friend class ImageWriter;
   friend class ImageDumper;  // For GetImageRoots()
 };
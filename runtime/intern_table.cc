@@ -24,68 +24,153 @@
 #include "thread.h"
 #include "UniquePtr.h"
 #include "utf.h"
+#include "utils.h"
 
 namespace art {
 
-InternTable::InternTable()
-    : intern_table_lock_("InternTable lock"), is_dirty_(false), allow_new_interns_(true),
-      new_intern_condition_("New intern condition", intern_table_lock_) {
+mirror::String* const InternTable::StringSet::kRemoved = reinterpret_cast<mirror::String*>(1);
+
+InternTable::StringSet::StringSet() : size_(0), used_(0) {
 }
 
-size_t InternTable::Size() const {
-  MutexLock mu(Thread::Current(), intern_table_lock_);
-  return strong_interns_.size() + weak_interns_.size();
+mirror::String* InternTable::StringSet::Lookup(mirror::String* s, uint32_t hash_code) const {
+  if (slots_.empty()) {
+    return NULL;
+  }
+  const size_t mask = slots_.size() - 1;
+  for (size_t i = MixHash(hash_code) & mask; ; i = (i + 1) & mask) {
+    const Slot& slot = slots_[i];
+    if (slot.string == NULL) {
+      return NULL;
+    }
+    if (slot.string != kRemoved && slot.hash_code == hash_code && slot.string->Equals(s)) {
+      return slot.string;
+    }
+  }
 }
 
-void InternTable::DumpForSigQuit(std::ostream& os) const {
-  MutexLock mu(Thread::Current(), intern_table_lock_);
-  os << "Intern table: " << strong_interns_.size() << " strong; "
-     << weak_interns_.size() << " weak\n";
+mirror::String* InternTable::StringSet::Insert(mirror::String* s, uint32_t hash_code) {
+  EnsureRoomForInsert();
+  const size_t mask = slots_.size() - 1;
+  size_t i = MixHash(hash_code) & mask;
+  while (IsLive(slots_[i].string)) {
+    i = (i + 1) & mask;
+  }
+  if (slots_[i].string == NULL) {
+    ++used_;
+  }
+  slots_[i].hash_code = hash_code;
+  slots_[i].string = s;
+  ++size_;
+  return s;
 }
 
-void InternTable::VisitRoots(RootVisitor* visitor, void* arg,
-                             bool only_dirty, bool clean_dirty) {
-  MutexLock mu(Thread::Current(), intern_table_lock_);
-  if (!only_dirty || is_dirty_) {
-    for (const auto& strong_intern : strong_interns_) {
-      visitor(strong_intern.second, arg);
+void InternTable::StringSet::Remove(const mirror::String* s, uint32_t hash_code) {
+  if (slots_.empty()) {
+    return;
+  }
+  const size_t mask = slots_.size() - 1;
+  for (size_t i = MixHash(hash_code) & mask; slots_[i].string != NULL; i = (i + 1) & mask) {
+    if (slots_[i].string == s) {
+      // Keep the slot used so that the probe sequences running through it stay intact.
+      slots_[i].string = kRemoved;
+      --size_;
+      return;
     }
-    if (clean_dirty) {
-      is_dirty_ = false;
+  }
+}
+
+void InternTable::StringSet::EnsureRoomForInsert() {
+  if ((used_ + 1) * 3 <= slots_.size() * 2) {
+    return;
+  }
+  // Removed strings don't survive the rehash, so only the live ones count towards the new size.
+  size_t capacity = kMinimumCapacity;
+  while ((size_ + 1) * 2 > capacity) {
+    capacity *= 2;
+  }
+  std::vector<Slot> old_slots(capacity, Slot());
+  old_slots.swap(slots_);
+  const size_t mask = capacity - 1;
+  for (const Slot& slot : old_slots) {
+    if (IsLive(slot.string)) {
+      size_t i = MixHash(slot.hash_code) & mask;
+      while (slots_[i].string != NULL) {
+        i = (i + 1) & mask;
+      }
+      slots_[i] = slot;
     }
   }
-  // Note: we deliberately don't visit the weak_interns_ table and the immutable
-  // image roots.
+  used_ = size_;
 }
 
-mirror::String* InternTable::Lookup(Table& table, mirror::String* s,
-                                    uint32_t hash_code) {
-  intern_table_lock_.AssertHeld(Thread::Current());
-  for (auto it = table.find(hash_code), end = table.end(); it != end; ++it) {
-    mirror::String* existing_string = it->second;
-    if (existing_string->Equals(s)) {
-      return existing_string;
+void InternTable::StringSet::Sweep(RootVisitor* visitor, void* arg) {
+  for (Slot& slot : slots_) {
+    if (IsLive(slot.string)) {
+      mirror::Object* object = visitor(slot.string, arg);
+      if (object == NULL) {
+        slot.string = kRemoved;
+        --size_;
+      } else {
+        slot.string = down_cast<mirror::String*>(object);
+      }
     }
   }
-  return NULL;
 }
 
-mirror::String* InternTable::Insert(Table& table, mirror::String* s,
-                                    uint32_t hash_code) {
-  intern_table_lock_.AssertHeld(Thread::Current());
-  table.insert(std::make_pair(hash_code, s));
-  return s;
+void InternTable::StringSet::VisitRoots(RootVisitor* visitor, void* arg) {
+  for (Slot& slot : slots_) {
+    if (IsLive(slot.string)) {
+      slot.string = down_cast<mirror::String*>(visitor(slot.string, arg));
+    }
+  }
 }
 
-void InternTable::Remove(Table& table, const mirror::String* s,
-                         uint32_t hash_code) {
-  intern_table_lock_.AssertHeld(Thread::Current());
-  for (auto it = table.find(hash_code), end = table.end(); it != end; ++it) {
-    if (it->second == s) {
-      table.erase(it);
-      return;
+InternTable::Stripe::Stripe()
+    : lock("InternTable lock"), is_dirty(false), allow_new_interns(true),
+      new_intern_condition("New intern condition", lock) {
+}
+
+InternTable::InternTable() {
+  COMPILE_ASSERT(kStripeCount == 1 << kStripeBits, stripe_count_must_match_stripe_bits);
+}
+
+size_t InternTable::Size() const {
+  Thread* self = Thread::Current();
+  size_t size = 0;
+  for (Stripe& stripe : stripes_) {
+    MutexLock mu(self, stripe.lock);
+    size += stripe.strong_interns.Size() + stripe.weak_interns.Size();
+  }
+  return size;
+}
+
+void InternTable::DumpForSigQuit(std::ostream& os) const {
+  Thread* self = Thread::Current();
+  size_t strong = 0;
+  size_t weak = 0;
+  for (Stripe& stripe : stripes_) {
+    MutexLock mu(self, stripe.lock);
+    strong += stripe.strong_interns.Size();
+    weak += stripe.weak_interns.Size();
+  }
+  os << "Intern table: " << strong << " strong; " << weak << " weak\n";
+}
+
+void InternTable::VisitRoots(RootVisitor* visitor, void* arg,
+                             bool only_dirty, bool clean_dirty) {
+  Thread* self = Thread::Current();
+  for (Stripe& stripe : stripes_) {
+    MutexLock mu(self, stripe.lock);
+    if (!only_dirty || stripe.is_dirty) {
+      stripe.strong_interns.VisitRoots(visitor, arg);
+      if (clean_dirty) {
+        stripe.is_dirty = false;
+      }
     }
   }
+  // Note: we deliberately don't visit the weak_interns tables and the immutable
+  // image roots.
 }
 
 static mirror::String* LookupStringFromImage(mirror::String* s)
@@ -115,74 +200,79 @@ static mirror::String* LookupStringFromImage(mirror::String* s)
 
 void InternTable::AllowNewInterns() {
   Thread* self = Thread::Current();
-  MutexLock mu(self, intern_table_lock_);
-  allow_new_interns_ = true;
-  new_intern_condition_.Broadcast(self);
+  for (Stripe& stripe : stripes_) {
+    MutexLock mu(self, stripe.lock);
+    stripe.allow_new_interns = true;
+    stripe.new_intern_condition.Broadcast(self);
+  }
 }
 
 void InternTable::DisallowNewInterns() {
   Thread* self = Thread::Current();
-  MutexLock mu(self, intern_table_lock_);
-  allow_new_interns_ = false;
+  for (Stripe& stripe : stripes_) {
+    MutexLock mu(self, stripe.lock);
+    stripe.allow_new_interns = false;
+  }
 }
 
 mirror::String* InternTable::Insert(mirror::String* s, bool is_strong) {
-  Thread* self = Thread::Current();
-  MutexLock mu(self, intern_table_lock_);
-
   DCHECK(s != NULL);
   uint32_t hash_code = s->GetHashCode();
+  Stripe& stripe = GetStripe(MixHash(hash_code));
+
+  Thread* self = Thread::Current();
+  MutexLock mu(self, stripe.lock);
 
-  while (UNLIKELY(!allow_new_interns_)) {
-    new_intern_condition_.WaitHoldingLocks(self);
+  while (UNLIKELY(!stripe.allow_new_interns)) {
+    stripe.new_intern_condition.WaitHoldingLocks(self);
   }
 
   if (is_strong) {
     // Check the strong table for a match.
-    mirror::String* strong = Lookup(strong_interns_, s, hash_code);
+    mirror::String* strong = stripe.strong_interns.Lookup(s, hash_code);
     if (strong != NULL) {
       return strong;
     }
 
     // Mark as dirty so that we rescan the roots.
-    is_dirty_ = true;
+    stripe.is_dirty = true;
 
     // Check the image for a match.
     mirror::String* image = LookupStringFromImage(s);
     if (image != NULL) {
-      return Insert(strong_interns_, image, hash_code);
+      return stripe.strong_interns.Insert(image, hash_code);
     }
 
     // There is no match in the strong table, check the weak table.
-    mirror::String* weak = Lookup(weak_interns_, s, hash_code);
+    mirror::String* weak = stripe.weak_interns.Lookup(s, hash_code);
     if (weak != NULL) {
       // A match was found in the weak table. Promote to the strong table.
-      Remove(weak_interns_, weak, hash_code);
-      return Insert(strong_interns_, weak, hash_code);
+      stripe.weak_interns.Remove(weak, hash_code);
+      return stripe.strong_interns.Insert(weak, hash_code);
     }
 
     // No match in the strong table or the weak table. Insert into the strong
     // table.
-    return Insert(strong_interns_, s, hash_code);
+    return stripe.strong_interns.Insert(s, hash_code);
   }
 
   // Check the strong table for a match.
-  mirror::String* strong = Lookup(strong_interns_, s, hash_code);
+  mirror::String* strong = stripe.strong_interns.Lookup(s, hash_code);
   if (strong != NULL) {
     return strong;
   }
   // Check the image for a match.
   mirror::String* image = LookupStringFromImage(s);
   if (image != NULL) {
-    return Insert(weak_interns_, image, hash_code);
+    return stripe.weak_interns.Insert(image, hash_code);
   }
   // Check the weak table for a match.
-  mirror::String* weak = Lookup(weak_interns_, s, hash_code);
+  mirror::String* weak = stripe.weak_interns.Lookup(s, hash_code);
   if (weak != NULL) {
     return weak;
   }
   // Insert into the weak table.
-  return Insert(weak_interns_, s, hash_code);
+  return stripe.weak_interns.Insert(s, hash_code);
 }
 
 mirror::String* InternTable::InternStrong(int32_t utf16_length,
@@ -211,22 +301,23 @@ mirror::String* InternTable::InternWeak(mirror::String* s) {
 }
 
 bool InternTable::ContainsWeak(mirror::String* s) {
-  MutexLock mu(Thread::Current(), intern_table_lock_);
-  const mirror::String* found = Lookup(weak_interns_, s, s->GetHashCode());
+  uint32_t hash_code = s->GetHashCode();
+  Stripe& stripe = GetStripe(MixHash(hash_code));
+  MutexLock mu(Thread::Current(), stripe.lock);
+  const mirror::String* found = stripe.weak_interns.Lookup(s, hash_code);
   return found == s;
 }
 
-void InternTable::SweepInternTableWeaks(IsMarkedTester is_marked, void* arg) {
-  MutexLock mu(Thread::Current(), intern_table_lock_);
-  // TODO: std::remove_if + lambda.
-  for (auto it = weak_interns_.begin(), end = weak_interns_.end(); it != end;) {
-    mirror::Object* object = it->second;
-    if (!is_marked(object, arg)) {
-      weak_interns_.erase(it++);
-    } else {
-      ++it;
-    }
+void InternTable::SweepInternTableWeaks(RootVisitor* visitor, void* arg) {
+  for (size_t i = 0; i < kStripeCount; ++i) {
+    SweepInternTableWeaks(visitor, arg, i);
   }
 }
 
+void InternTable::SweepInternTableWeaks(RootVisitor* visitor, void* arg, size_t stripe) {
+  DCHECK_LT(stripe, kStripeCount);
+  MutexLock mu(Thread::Current(), stripes_[stripe].lock);
+  stripes_[stripe].weak_interns.Sweep(visitor, arg);
+}
+
 }  // namespace art
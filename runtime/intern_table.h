@@ -17,10 +17,11 @@
 #ifndef ART_RUNTIME_INTERN_TABLE_H_
 #define ART_RUNTIME_INTERN_TABLE_H_
 
+#include "base/macros.h"
 #include "base/mutex.h"
 #include "root_visitor.h"
 
-#include <map>
+#include <vector>
 
 namespace art {
 namespace mirror {
@@ -36,9 +37,16 @@ class String;
  * String.intern. Some code (XML parsers being a prime example) relies on being able to intern
  * arbitrarily many strings for the duration of a parse without permanently increasing the memory
  * footprint.
+ *
+ * The strings are spread over stripes by hash code, each with its own lock and hash sets, so that
+ * threads interning different strings rarely contend.
  */
 class InternTable {
  public:
+  // The number of independently locked parts of the table. Weak interns can be swept one stripe
+  // at a time, which lets GC threads share the sweeping.
+  static const size_t kStripeCount = 16;
+
   InternTable();
 
   // Interns a potentially new string in the 'strong' table. (See above.)
@@ -55,9 +63,12 @@ class InternTable {
   // Interns a potentially new string in the 'weak' table. (See above.)
   mirror::String* InternWeak(mirror::String* s) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  void SweepInternTableWeaks(IsMarkedTester is_marked, void* arg)
+  void SweepInternTableWeaks(RootVisitor* visitor, void* arg)
       SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
 
+  // Sweeps the weak interns of a single stripe. Different stripes may be swept concurrently.
+  void SweepInternTableWeaks(RootVisitor* visitor, void* arg, size_t stripe);
+
   bool ContainsWeak(mirror::String* s) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   size_t Size() const;
@@ -70,22 +81,76 @@ class InternTable {
   void AllowNewInterns() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
  private:
-  typedef std::multimap<int32_t, mirror::String*> Table;
+  // An open-addressed set of strings with linear probing. The hash code is kept next to each
+  // string so that probing doesn't have to touch the strings.
+  class StringSet {
+   public:
+    StringSet();
+
+    mirror::String* Lookup(mirror::String* s, uint32_t hash_code) const
+        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+    mirror::String* Insert(mirror::String* s, uint32_t hash_code);
+    void Remove(const mirror::String* s, uint32_t hash_code);
+
+    // Replaces each string with the address returned by the visitor, removing the strings for
+    // which it returns NULL.
+    void Sweep(RootVisitor* visitor, void* arg);
+    void VisitRoots(RootVisitor* visitor, void* arg);
+
+    size_t Size() const {
+      return size_;
+    }
+
+   private:
+    struct Slot {
+      uint32_t hash_code;
+      // NULL for a slot which was never used, kRemoved for a string which was removed.
+      mirror::String* string;
+    };
+
+    static const size_t kMinimumCapacity = 64;
+    static mirror::String* const kRemoved;
+
+    static bool IsLive(const mirror::String* s) {
+      return s != NULL && s != kRemoved;
+    }
+
+    // Grows or rehashes the slots when inserting one more string would make them over 2/3 used.
+    void EnsureRoomForInsert();
+
+    std::vector<Slot> slots_;
+    // Number of live strings.
+    size_t size_;
+    // Number of live strings plus the removed ones still occupying slots.
+    size_t used_;
+
+    DISALLOW_COPY_AND_ASSIGN(StringSet);
+  };
+
+  struct Stripe {
+    Stripe();
+
+    Mutex lock;
+    bool is_dirty GUARDED_BY(lock);
+    bool allow_new_interns GUARDED_BY(lock);
+    ConditionVariable new_intern_condition GUARDED_BY(lock);
+    StringSet strong_interns GUARDED_BY(lock);
+    StringSet weak_interns GUARDED_BY(lock);
+
+    DISALLOW_COPY_AND_ASSIGN(Stripe);
+  };
+
+  // The stripe is picked with the high bits of the mixed hash, the sets use the low bits.
+  Stripe& GetStripe(uint32_t hash) {
+    return stripes_[hash >> (32 - kStripeBits)];
+  }
 
   mirror::String* Insert(mirror::String* s, bool is_strong)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  mirror::String* Lookup(Table& table, mirror::String* s, uint32_t hash_code)
-      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-  mirror::String* Insert(Table& table, mirror::String* s, uint32_t hash_code);
-  void Remove(Table& table, const mirror::String* s, uint32_t hash_code);
-
-  mutable Mutex intern_table_lock_;
-  bool is_dirty_ GUARDED_BY(intern_table_lock_);
-  bool allow_new_interns_ GUARDED_BY(intern_table_lock_);
-  ConditionVariable new_intern_condition_ GUARDED_BY(intern_table_lock_);
-  Table strong_interns_ GUARDED_BY(intern_table_lock_);
-  Table weak_interns_ GUARDED_BY(intern_table_lock_);
+  static const size_t kStripeBits = 4;
+
+  mutable Stripe stripes_[kStripeCount];
 };
 
 }  // namespace art
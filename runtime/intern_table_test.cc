@@ -16,6 +16,10 @@
 
 #include "intern_table.h"
 
+#include <string>
+#include <vector>
+
+#include "base/stringprintf.h"
 #include "common_test.h"
 #include "mirror/object.h"
 #include "sirt_ref.h"
@@ -56,7 +60,7 @@ TEST_F(InternTableTest, Size) {
 
 class TestPredicate {
  public:
-  bool IsMarked(const mirror::Object* s) const {
+  mirror::Object* IsMarked(const mirror::Object* s) const {
     bool erased = false;
     for (auto it = expected_.begin(), end = expected_.end(); it != end; ++it) {
       if (*it == s) {
@@ -66,7 +70,7 @@ class TestPredicate {
       }
     }
     EXPECT_TRUE(erased);
-    return false;
+    return NULL;
   }
 
   void Expect(const mirror::String* s) {
@@ -81,7 +85,7 @@ class TestPredicate {
   mutable std::vector<const mirror::String*> expected_;
 };
 
-bool IsMarked(const mirror::Object* object, void* arg) {
+mirror::Object* IsMarked(mirror::Object* object, void* arg) {
   return reinterpret_cast<TestPredicate*>(arg)->IsMarked(object);
 }
 
@@ -117,6 +121,27 @@ TEST_F(InternTableTest, SweepInternTableWeaks) {
   EXPECT_EQ(3U, t.Size());
 }
 
+TEST_F(InternTableTest, ManyInterns) {
+  ScopedObjectAccess soa(Thread::Current());
+  // Use the runtime's table, whose strong interns are roots, so that the strings stay live.
+  InternTable* t = Runtime::Current()->GetInternTable();
+  const size_t initial_size = t->Size();
+  // Enough strings to grow every stripe's sets several times.
+  static const size_t kCount = 10000;
+  std::vector<mirror::String*> strong;
+  for (size_t i = 0; i < kCount; ++i) {
+    std::string s(StringPrintf("InternTableTest %zd", i));
+    strong.push_back(t->InternStrong(s.c_str()));
+    ASSERT_TRUE(strong.back() != NULL);
+  }
+  EXPECT_EQ(initial_size + kCount, t->Size());
+  for (size_t i = 0; i < kCount; ++i) {
+    std::string s(StringPrintf("InternTableTest %zd", i));
+    EXPECT_EQ(strong[i], t->InternStrong(s.c_str()));
+  }
+  EXPECT_EQ(initial_size + kCount, t->Size());
+}
+
 TEST_F(InternTableTest, ContainsWeak) {
   ScopedObjectAccess soa(Thread::Current());
   {
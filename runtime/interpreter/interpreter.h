@@ -33,6 +33,25 @@ class Thread;
 
 namespace interpreter {
 
+// The implementations of the interpreter, which run the same instruction handlers and may be
+// switched at any time.
+enum InterpreterImplKind {
+  kSwitchImpl,  // A switch over the opcode for each instruction.
+  kGotoImpl,    // Threaded code jumping through a table of handler addresses.
+};
+
+// The implementation run unless -XX:InterpreterImpl= picks the other one.
+#if defined(ART_USE_GOTO_INTERPRETER)
+static const InterpreterImplKind kDefaultInterpreterImplKind = kGotoImpl;
+#else
+static const InterpreterImplKind kDefaultInterpreterImplKind = kSwitchImpl;
+#endif
+
+// Selects the implementation running the methods entered from now on, frames being interpreted
+// keep their implementation.
+extern void SetInterpreterImplKind(InterpreterImplKind kind);
+extern InterpreterImplKind GetInterpreterImplKind();
+
 // Called by ArtMethod::Invoke, shadow frames arguments are taken from the args array.
 extern void EnterInterpreterFromInvoke(Thread* self, mirror::ArtMethod* method,
                                        mirror::Object* receiver, uint32_t* args, JValue* result)
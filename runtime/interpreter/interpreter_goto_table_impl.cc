@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "interpreter_common.h"
+
+namespace art {
+namespace interpreter {
+
+// The handlers of ExecuteGotoImpl jump straight to the handler of the next instruction through a
+// table of label addresses, instead of going back to a single switch, so each handler gets its
+// own indirect branch and the per-instruction checks of the switch loop go away.
+
+#define HANDLE_INSTRUCTION_START(opcode) op_##opcode:  // NOLINT(whitespace/labels)
+
+#define HANDLE_INSTRUCTION_END() DISPATCH()
+
+// Picks the handlers reporting the dex pc when the instrumentation has dex pc listeners. These
+// only change while all threads are suspended, so the table is picked again whenever this thread
+// may have been suspended: on entry, after suspend checks and exceptions, and in the handlers of
+// the instructions that may suspend.
+#define UPDATE_HANDLER_TABLE() \
+  current_handlers_table = UNLIKELY(instrumentation->HasDexPcListeners()) ? \
+      instrumentation_handlers_table : handlers_table
+
+#define DISPATCH() \
+  do { \
+    shadow_frame.SetDexPC(inst->GetDexPc(insns)); \
+    goto *current_handlers_table[inst->Opcode()]; \
+  } while (false)
+
+// Only backward branches and caught exceptions can make the code loop, so suspending there is
+// enough to bound the time between suspend checks.
+#define BACKWARD_BRANCH_CHECK_SUSPEND() \
+  do { \
+    if (UNLIKELY(self->TestAllFlags())) { \
+      CheckSuspend(self); \
+      UPDATE_HANDLER_TABLE(); \
+    } \
+  } while (false)
+
+#define BRANCH(offset) \
+  do { \
+    int32_t branch_offset = (offset); \
+    if (branch_offset <= 0) { \
+      BACKWARD_BRANCH_CHECK_SUSPEND(); \
+    } \
+    inst = inst->RelativeAt(branch_offset); \
+  } while (false)
+
+// Throwing allocates the exception, so the thread may have been suspended whether or not a
+// suspend request is still pending.
+#define HANDLE_PENDING_EXCEPTION() \
+  do { \
+    CHECK(self->IsExceptionPending()); \
+    inst = FindNextInstructionFollowingException(self, shadow_frame, inst->GetDexPc(insns), \
+                                                 insns, this_object_ref, instrumentation); \
+    if (inst == NULL) { \
+      return JValue(); /* Handled in caller. */ \
+    } \
+    if (UNLIKELY(self->TestAllFlags())) { \
+      CheckSuspend(self); \
+    } \
+    UPDATE_HANDLER_TABLE(); \
+    DISPATCH(); \
+  } while (false)
+
+#define POSSIBLY_HANDLE_PENDING_EXCEPTION(is_exception_pending, next_function) \
+  if (UNLIKELY(is_exception_pending)) { \
+    HANDLE_PENDING_EXCEPTION(); \
+  } else { \
+    inst = inst->next_function(); \
+  }
+
+template<bool do_access_check>
+JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem* code_item,
+                       ShadowFrame& shadow_frame, JValue result_register) {
+  static const void* const handlers_table[kNumPackedOpcodes] = {
+#define INSTRUCTION_HANDLER(o, code, n, f, r, i, a, v) &&op_##code,
+#include "dex_instruction_list.h"
+    DEX_INSTRUCTION_LIST(INSTRUCTION_HANDLER)
+#undef DEX_INSTRUCTION_LIST
+#undef INSTRUCTION_HANDLER
+  };
+  static const void* const instrumentation_handlers_table[kNumPackedOpcodes] = {
+#define INSTRUCTION_HANDLER(o, code, n, f, r, i, a, v) &&instrumentation_op_##code,
+#include "dex_instruction_list.h"
+    DEX_INSTRUCTION_LIST(INSTRUCTION_HANDLER)
+#undef DEX_INSTRUCTION_LIST
+#undef INSTRUCTION_HANDLER
+  };
+
+  bool do_assignability_check = do_access_check;
+  if (UNLIKELY(!shadow_frame.HasReferenceArray())) {
+    LOG(FATAL) << "Invalid shadow frame for interpreter use";
+    return JValue();
+  }
+  self->VerifyStack();
+  instrumentation::Instrumentation* const instrumentation = Runtime::Current()->GetInstrumentation();
+
+  // As the 'this' object won't change during the execution of current code, we
+  // want to cache it in local variables. Nevertheless, in order to let the
+  // garbage collector access it, we store it into sirt references.
+  SirtRef<Object> this_object_ref(self, shadow_frame.GetThisObject(code_item->ins_size_));
+
+  uint32_t dex_pc = shadow_frame.GetDexPC();
+  if (LIKELY(dex_pc == 0)) {  // We are entering the method as opposed to deoptimizing..
+    if (UNLIKELY(instrumentation->HasMethodEntryListeners())) {
+      instrumentation->MethodEnterEvent(self, this_object_ref.get(),
+                                        shadow_frame.GetMethod(), 0);
+    }
+  }
+  const uint16_t* const insns = code_item->insns_;
+  const Instruction* inst = Instruction::At(insns + dex_pc);
+  if (UNLIKELY(self->TestAllFlags())) {
+    CheckSuspend(self);
+  }
+  const void* const* current_handlers_table;
+  UPDATE_HANDLER_TABLE();
+  DISPATCH();
+
+#include "interpreter_instruction_handlers.h"
+
+  // The instrumented handlers report the dex pc, then run the instruction's handler.
+#define INSTRUMENTATION_INSTRUCTION_HANDLER(o, code, n, f, r, i, a, v) \
+  instrumentation_op_##code: \
+    instrumentation->DexPcMovedEvent(self, this_object_ref.get(), shadow_frame.GetMethod(), \
+                                     shadow_frame.GetDexPC()); \
+    goto op_##code;
+#include "dex_instruction_list.h"
+  DEX_INSTRUCTION_LIST(INSTRUMENTATION_INSTRUCTION_HANDLER)
+#undef DEX_INSTRUCTION_LIST
+#undef INSTRUMENTATION_INSTRUCTION_HANDLER
+}  // NOLINT(readability/fn_size)
+
+#undef POSSIBLY_HANDLE_PENDING_EXCEPTION
+#undef HANDLE_PENDING_EXCEPTION
+#undef BRANCH
+#undef BACKWARD_BRANCH_CHECK_SUSPEND
+#undef DISPATCH
+#undef UPDATE_HANDLER_TABLE
+#undef HANDLE_INSTRUCTION_END
+#undef HANDLE_INSTRUCTION_START
+
+// Explicit definitions of ExecuteGotoImpl.
+template JValue ExecuteGotoImpl<true>(Thread* self, MethodHelper& mh,
+                                      const DexFile::CodeItem* code_item,
+                                      ShadowFrame& shadow_frame, JValue result_register);
+template JValue ExecuteGotoImpl<false>(Thread* self, MethodHelper& mh,
+                                       const DexFile::CodeItem* code_item,
+                                       ShadowFrame& shadow_frame, JValue result_register);
+
+}  // namespace interpreter
+}  // namespace art
@@ -0,0 +1,1854 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_INTERPRETER_INTERPRETER_INSTRUCTION_HANDLERS_H_
+#define ART_RUNTIME_INTERPRETER_INTERPRETER_INSTRUCTION_HANDLERS_H_
+
+// The handler of every dex instruction, included in the dispatch loop of each interpreter
+// implementation so that they all run the same code. The including implementation defines:
+//  - HANDLE_INSTRUCTION_START(opcode), which starts the handler of opcode,
+//  - HANDLE_INSTRUCTION_END(), which leaves the handler and runs the instruction inst points to,
+//  - HANDLE_PENDING_EXCEPTION(), which points inst to the catch handler or returns,
+//  - POSSIBLY_HANDLE_PENDING_EXCEPTION(is_exception_pending, next_function),
+//  - BRANCH(offset) and BACKWARD_BRANCH_CHECK_SUSPEND(), for the branches that may loop,
+//  - UPDATE_HANDLER_TABLE(), run after anything that may suspend the thread (invokes,
+//    allocations, resolution and class initialization, monitor-enter) since instrumentation may
+//    have changed while the thread was suspended.
+
+  HANDLE_INSTRUCTION_START(NOP)
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MOVE)
+    shadow_frame.SetVReg(inst->VRegA_12x(),
+                         shadow_frame.GetVReg(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MOVE_FROM16)
+    shadow_frame.SetVReg(inst->VRegA_22x(),
+                         shadow_frame.GetVReg(inst->VRegB_22x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MOVE_16)
+    shadow_frame.SetVReg(inst->VRegA_32x(),
+                         shadow_frame.GetVReg(inst->VRegB_32x()));
+    inst = inst->Next_3xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MOVE_WIDE)
+    shadow_frame.SetVRegLong(inst->VRegA_12x(),
+                             shadow_frame.GetVRegLong(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MOVE_WIDE_FROM16)
+    shadow_frame.SetVRegLong(inst->VRegA_22x(),
+                             shadow_frame.GetVRegLong(inst->VRegB_22x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MOVE_WIDE_16)
+    shadow_frame.SetVRegLong(inst->VRegA_32x(),
+                             shadow_frame.GetVRegLong(inst->VRegB_32x()));
+    inst = inst->Next_3xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MOVE_OBJECT)
+    shadow_frame.SetVRegReference(inst->VRegA_12x(),
+                                  shadow_frame.GetVRegReference(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MOVE_OBJECT_FROM16)
+    shadow_frame.SetVRegReference(inst->VRegA_22x(),
+                                  shadow_frame.GetVRegReference(inst->VRegB_22x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MOVE_OBJECT_16)
+    shadow_frame.SetVRegReference(inst->VRegA_32x(),
+                                  shadow_frame.GetVRegReference(inst->VRegB_32x()));
+    inst = inst->Next_3xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MOVE_RESULT)
+    shadow_frame.SetVReg(inst->VRegA_11x(), result_register.GetI());
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MOVE_RESULT_WIDE)
+    shadow_frame.SetVRegLong(inst->VRegA_11x(), result_register.GetJ());
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MOVE_RESULT_OBJECT)
+    shadow_frame.SetVRegReference(inst->VRegA_11x(), result_register.GetL());
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MOVE_EXCEPTION) {
+    Throwable* exception = self->GetException(NULL);
+    self->ClearException();
+    shadow_frame.SetVRegReference(inst->VRegA_11x(), exception);
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(RETURN_VOID) {
+    JValue result;
+    if (UNLIKELY(instrumentation->HasMethodExitListeners())) {
+      instrumentation->MethodExitEvent(self, this_object_ref.get(),
+                                       shadow_frame.GetMethod(), inst->GetDexPc(insns),
+                                       result);
+    }
+    return result;
+  }
+  HANDLE_INSTRUCTION_START(RETURN_VOID_BARRIER) {
+    ANDROID_MEMBAR_STORE();
+    JValue result;
+    if (UNLIKELY(instrumentation->HasMethodExitListeners())) {
+      instrumentation->MethodExitEvent(self, this_object_ref.get(),
+                                       shadow_frame.GetMethod(), inst->GetDexPc(insns),
+                                       result);
+    }
+    return result;
+  }
+  HANDLE_INSTRUCTION_START(RETURN) {
+    JValue result;
+    result.SetJ(0);
+    result.SetI(shadow_frame.GetVReg(inst->VRegA_11x()));
+    if (UNLIKELY(instrumentation->HasMethodExitListeners())) {
+      instrumentation->MethodExitEvent(self, this_object_ref.get(),
+                                       shadow_frame.GetMethod(), inst->GetDexPc(insns),
+                                       result);
+    }
+    return result;
+  }
+  HANDLE_INSTRUCTION_START(RETURN_WIDE) {
+    JValue result;
+    result.SetJ(shadow_frame.GetVRegLong(inst->VRegA_11x()));
+    if (UNLIKELY(instrumentation->HasMethodExitListeners())) {
+      instrumentation->MethodExitEvent(self, this_object_ref.get(),
+                                       shadow_frame.GetMethod(), inst->GetDexPc(insns),
+                                       result);
+    }
+    return result;
+  }
+  HANDLE_INSTRUCTION_START(RETURN_OBJECT) {
+    JValue result;
+    Object* obj_result = shadow_frame.GetVRegReference(inst->VRegA_11x());
+    result.SetJ(0);
+    result.SetL(obj_result);
+    if (do_assignability_check && obj_result != NULL) {
+      Class* return_type = MethodHelper(shadow_frame.GetMethod()).GetReturnType();
+      if (return_type == NULL) {
+        // Return the pending exception.
+        HANDLE_PENDING_EXCEPTION();
+      }
+      if (!obj_result->VerifierInstanceOf(return_type)) {
+        // This should never happen.
+        self->ThrowNewExceptionF(self->GetCurrentLocationForThrow(),
+                                 "Ljava/lang/VirtualMachineError;",
+                                 "Returning '%s' that is not instance of return type '%s'",
+                                 ClassHelper(obj_result->GetClass()).GetDescriptor(),
+                                 ClassHelper(return_type).GetDescriptor());
+        HANDLE_PENDING_EXCEPTION();
+      }
+    }
+    if (UNLIKELY(instrumentation->HasMethodExitListeners())) {
+      instrumentation->MethodExitEvent(self, this_object_ref.get(),
+                                       shadow_frame.GetMethod(), inst->GetDexPc(insns),
+                                       result);
+    }
+    return result;
+  }
+  HANDLE_INSTRUCTION_START(CONST_4) {
+    uint4_t dst = inst->VRegA_11n();
+    int4_t val = inst->VRegB_11n();
+    shadow_frame.SetVReg(dst, val);
+    if (val == 0) {
+      shadow_frame.SetVRegReference(dst, NULL);
+    }
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(CONST_16) {
+    uint8_t dst = inst->VRegA_21s();
+    int16_t val = inst->VRegB_21s();
+    shadow_frame.SetVReg(dst, val);
+    if (val == 0) {
+      shadow_frame.SetVRegReference(dst, NULL);
+    }
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(CONST) {
+    uint8_t dst = inst->VRegA_31i();
+    int32_t val = inst->VRegB_31i();
+    shadow_frame.SetVReg(dst, val);
+    if (val == 0) {
+      shadow_frame.SetVRegReference(dst, NULL);
+    }
+    inst = inst->Next_3xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(CONST_HIGH16) {
+    uint8_t dst = inst->VRegA_21h();
+    int32_t val = static_cast<int32_t>(inst->VRegB_21h() << 16);
+    shadow_frame.SetVReg(dst, val);
+    if (val == 0) {
+      shadow_frame.SetVRegReference(dst, NULL);
+    }
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(CONST_WIDE_16)
+    shadow_frame.SetVRegLong(inst->VRegA_21s(), inst->VRegB_21s());
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(CONST_WIDE_32)
+    shadow_frame.SetVRegLong(inst->VRegA_31i(), inst->VRegB_31i());
+    inst = inst->Next_3xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(CONST_WIDE)
+    shadow_frame.SetVRegLong(inst->VRegA_51l(), inst->VRegB_51l());
+    inst = inst->Next_51l();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(CONST_WIDE_HIGH16)
+    shadow_frame.SetVRegLong(inst->VRegA_21h(),
+                             static_cast<uint64_t>(inst->VRegB_21h()) << 48);
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(CONST_STRING) {
+    String* s = ResolveString(self, mh,  inst->VRegB_21c());
+    UPDATE_HANDLER_TABLE();
+    if (UNLIKELY(s == NULL)) {
+      HANDLE_PENDING_EXCEPTION();
+    } else {
+      shadow_frame.SetVRegReference(inst->VRegA_21c(), s);
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(CONST_STRING_JUMBO) {
+    String* s = ResolveString(self, mh,  inst->VRegB_31c());
+    UPDATE_HANDLER_TABLE();
+    if (UNLIKELY(s == NULL)) {
+      HANDLE_PENDING_EXCEPTION();
+    } else {
+      shadow_frame.SetVRegReference(inst->VRegA_31c(), s);
+      inst = inst->Next_3xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(CONST_CLASS) {
+    Class* c = ResolveVerifyAndClinit(inst->VRegB_21c(), shadow_frame.GetMethod(),
+                                      self, false, do_access_check);
+    UPDATE_HANDLER_TABLE();
+    if (UNLIKELY(c == NULL)) {
+      HANDLE_PENDING_EXCEPTION();
+    } else {
+      shadow_frame.SetVRegReference(inst->VRegA_21c(), c);
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(MONITOR_ENTER) {
+    Object* obj = shadow_frame.GetVRegReference(inst->VRegA_11x());
+    if (UNLIKELY(obj == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+    } else {
+      DoMonitorEnter(self, obj);
+      UPDATE_HANDLER_TABLE();
+      POSSIBLY_HANDLE_PENDING_EXCEPTION(self->IsExceptionPending(), Next_1xx);
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(MONITOR_EXIT) {
+    Object* obj = shadow_frame.GetVRegReference(inst->VRegA_11x());
+    if (UNLIKELY(obj == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+    } else {
+      DoMonitorExit(self, obj);
+      POSSIBLY_HANDLE_PENDING_EXCEPTION(self->IsExceptionPending(), Next_1xx);
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(CHECK_CAST) {
+    Class* c = ResolveVerifyAndClinit(inst->VRegB_21c(), shadow_frame.GetMethod(),
+                                      self, false, do_access_check);
+    UPDATE_HANDLER_TABLE();
+    if (UNLIKELY(c == NULL)) {
+      HANDLE_PENDING_EXCEPTION();
+    } else {
+      Object* obj = shadow_frame.GetVRegReference(inst->VRegA_21c());
+      if (UNLIKELY(obj != NULL && !obj->InstanceOf(c))) {
+        ThrowClassCastException(c, obj->GetClass());
+        HANDLE_PENDING_EXCEPTION();
+      } else {
+        inst = inst->Next_2xx();
+      }
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(INSTANCE_OF) {
+    Class* c = ResolveVerifyAndClinit(inst->VRegC_22c(), shadow_frame.GetMethod(),
+                                      self, false, do_access_check);
+    UPDATE_HANDLER_TABLE();
+    if (UNLIKELY(c == NULL)) {
+      HANDLE_PENDING_EXCEPTION();
+    } else {
+      Object* obj = shadow_frame.GetVRegReference(inst->VRegB_22c());
+      shadow_frame.SetVReg(inst->VRegA_22c(), (obj != NULL && obj->InstanceOf(c)) ? 1 : 0);
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(ARRAY_LENGTH) {
+    Object* array = shadow_frame.GetVRegReference(inst->VRegB_12x());
+    if (UNLIKELY(array == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+    } else {
+      shadow_frame.SetVReg(inst->VRegA_12x(), array->AsArray()->GetLength());
+      inst = inst->Next_1xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(NEW_INSTANCE) {
+    Object* obj = AllocObjectFromCode(inst->VRegB_21c(), shadow_frame.GetMethod(),
+                                      self, do_access_check);
+    UPDATE_HANDLER_TABLE();
+    if (UNLIKELY(obj == NULL)) {
+      HANDLE_PENDING_EXCEPTION();
+    } else {
+      shadow_frame.SetVRegReference(inst->VRegA_21c(), obj);
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(NEW_ARRAY) {
+    int32_t length = shadow_frame.GetVReg(inst->VRegB_22c());
+    Object* obj = AllocArrayFromCode(inst->VRegC_22c(), shadow_frame.GetMethod(),
+                                     length, self, do_access_check);
+    UPDATE_HANDLER_TABLE();
+    if (UNLIKELY(obj == NULL)) {
+      HANDLE_PENDING_EXCEPTION();
+    } else {
+      shadow_frame.SetVRegReference(inst->VRegA_22c(), obj);
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(FILLED_NEW_ARRAY) {
+    bool success = DoFilledNewArray<false, do_access_check>(inst, shadow_frame,
+                                                            self, &result_register);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(FILLED_NEW_ARRAY_RANGE) {
+    bool success = DoFilledNewArray<true, do_access_check>(inst, shadow_frame,
+                                                           self, &result_register);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(FILL_ARRAY_DATA) {
+    Object* obj = shadow_frame.GetVRegReference(inst->VRegA_31t());
+    if (UNLIKELY(obj == NULL)) {
+      ThrowNullPointerException(NULL, "null array in FILL_ARRAY_DATA");
+      HANDLE_PENDING_EXCEPTION();
+      HANDLE_INSTRUCTION_END();
+    }
+    Array* array = obj->AsArray();
+    DCHECK(array->IsArrayInstance() && !array->IsObjectArray());
+    const uint16_t* payload_addr = reinterpret_cast<const uint16_t*>(inst) + inst->VRegB_31t();
+    const Instruction::ArrayDataPayload* payload =
+        reinterpret_cast<const Instruction::ArrayDataPayload*>(payload_addr);
+    if (UNLIKELY(static_cast<int32_t>(payload->element_count) > array->GetLength())) {
+      self->ThrowNewExceptionF(shadow_frame.GetCurrentLocationForThrow(),
+                               "Ljava/lang/ArrayIndexOutOfBoundsException;",
+                               "failed FILL_ARRAY_DATA; length=%d, index=%d",
+                               array->GetLength(), payload->element_count);
+      HANDLE_PENDING_EXCEPTION();
+      HANDLE_INSTRUCTION_END();
+    }
+    uint32_t size_in_bytes = payload->element_count * payload->element_width;
+    memcpy(array->GetRawData(payload->element_width), payload->data, size_in_bytes);
+    inst = inst->Next_3xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(THROW) {
+    Object* exception = shadow_frame.GetVRegReference(inst->VRegA_11x());
+    if (UNLIKELY(exception == NULL)) {
+      ThrowNullPointerException(NULL, "throw with null exception");
+    } else if (do_assignability_check && !exception->GetClass()->IsThrowableClass()) {
+      // This should never happen.
+      self->ThrowNewExceptionF(self->GetCurrentLocationForThrow(),
+                               "Ljava/lang/VirtualMachineError;",
+                               "Throwing '%s' that is not instance of Throwable",
+                               ClassHelper(exception->GetClass()).GetDescriptor());
+    } else {
+      self->SetException(shadow_frame.GetCurrentLocationForThrow(), exception->AsThrowable());
+    }
+    HANDLE_PENDING_EXCEPTION();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(GOTO) {
+    BRANCH(inst->VRegA_10t());
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(GOTO_16) {
+    BRANCH(inst->VRegA_20t());
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(GOTO_32) {
+    BRANCH(inst->VRegA_30t());
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(PACKED_SWITCH) {
+    const uint16_t* switch_data = reinterpret_cast<const uint16_t*>(inst) + inst->VRegB_31t();
+    int32_t test_val = shadow_frame.GetVReg(inst->VRegA_31t());
+    DCHECK_EQ(switch_data[0], static_cast<uint16_t>(Instruction::kPackedSwitchSignature));
+    uint16_t size = switch_data[1];
+    DCHECK_GT(size, 0);
+    const int32_t* keys = reinterpret_cast<const int32_t*>(&switch_data[2]);
+    DCHECK(IsAligned<4>(keys));
+    int32_t first_key = keys[0];
+    const int32_t* targets = reinterpret_cast<const int32_t*>(&switch_data[4]);
+    DCHECK(IsAligned<4>(targets));
+    int32_t index = test_val - first_key;
+    if (index >= 0 && index < size) {
+      BRANCH(targets[index]);
+    } else {
+      inst = inst->Next_3xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SPARSE_SWITCH) {
+    const Instruction* next_inst = DoSparseSwitch(inst, shadow_frame);
+    if (next_inst <= inst) {
+      BACKWARD_BRANCH_CHECK_SUSPEND();
+    }
+    inst = next_inst;
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(CMPL_FLOAT) {
+    float val1 = shadow_frame.GetVRegFloat(inst->VRegB_23x());
+    float val2 = shadow_frame.GetVRegFloat(inst->VRegC_23x());
+    int32_t result;
+    if (val1 > val2) {
+      result = 1;
+    } else if (val1 == val2) {
+      result = 0;
+    } else {
+      result = -1;
+    }
+    shadow_frame.SetVReg(inst->VRegA_23x(), result);
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(CMPG_FLOAT) {
+    float val1 = shadow_frame.GetVRegFloat(inst->VRegB_23x());
+    float val2 = shadow_frame.GetVRegFloat(inst->VRegC_23x());
+    int32_t result;
+    if (val1 < val2) {
+      result = -1;
+    } else if (val1 == val2) {
+      result = 0;
+    } else {
+      result = 1;
+    }
+    shadow_frame.SetVReg(inst->VRegA_23x(), result);
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(CMPL_DOUBLE) {
+    double val1 = shadow_frame.GetVRegDouble(inst->VRegB_23x());
+    double val2 = shadow_frame.GetVRegDouble(inst->VRegC_23x());
+    int32_t result;
+    if (val1 > val2) {
+      result = 1;
+    } else if (val1 == val2) {
+      result = 0;
+    } else {
+      result = -1;
+    }
+    shadow_frame.SetVReg(inst->VRegA_23x(), result);
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  }
+
+  HANDLE_INSTRUCTION_START(CMPG_DOUBLE) {
+    double val1 = shadow_frame.GetVRegDouble(inst->VRegB_23x());
+    double val2 = shadow_frame.GetVRegDouble(inst->VRegC_23x());
+    int32_t result;
+    if (val1 < val2) {
+      result = -1;
+    } else if (val1 == val2) {
+      result = 0;
+    } else {
+      result = 1;
+    }
+    shadow_frame.SetVReg(inst->VRegA_23x(), result);
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(CMP_LONG) {
+    int64_t val1 = shadow_frame.GetVRegLong(inst->VRegB_23x());
+    int64_t val2 = shadow_frame.GetVRegLong(inst->VRegC_23x());
+    int32_t result;
+    if (val1 > val2) {
+      result = 1;
+    } else if (val1 == val2) {
+      result = 0;
+    } else {
+      result = -1;
+    }
+    shadow_frame.SetVReg(inst->VRegA_23x(), result);
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IF_EQ) {
+    if (shadow_frame.GetVReg(inst->VRegA_22t()) == shadow_frame.GetVReg(inst->VRegB_22t())) {
+      BRANCH(inst->VRegC_22t());
+    } else {
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IF_NE) {
+    if (shadow_frame.GetVReg(inst->VRegA_22t()) != shadow_frame.GetVReg(inst->VRegB_22t())) {
+      BRANCH(inst->VRegC_22t());
+    } else {
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IF_LT) {
+    if (shadow_frame.GetVReg(inst->VRegA_22t()) < shadow_frame.GetVReg(inst->VRegB_22t())) {
+      BRANCH(inst->VRegC_22t());
+    } else {
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IF_GE) {
+    if (shadow_frame.GetVReg(inst->VRegA_22t()) >= shadow_frame.GetVReg(inst->VRegB_22t())) {
+      BRANCH(inst->VRegC_22t());
+    } else {
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IF_GT) {
+    if (shadow_frame.GetVReg(inst->VRegA_22t()) > shadow_frame.GetVReg(inst->VRegB_22t())) {
+      BRANCH(inst->VRegC_22t());
+    } else {
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IF_LE) {
+    if (shadow_frame.GetVReg(inst->VRegA_22t()) <= shadow_frame.GetVReg(inst->VRegB_22t())) {
+      BRANCH(inst->VRegC_22t());
+    } else {
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IF_EQZ) {
+    if (shadow_frame.GetVReg(inst->VRegA_21t()) == 0) {
+      BRANCH(inst->VRegB_21t());
+    } else {
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IF_NEZ) {
+    if (shadow_frame.GetVReg(inst->VRegA_21t()) != 0) {
+      BRANCH(inst->VRegB_21t());
+    } else {
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IF_LTZ) {
+    if (shadow_frame.GetVReg(inst->VRegA_21t()) < 0) {
+      BRANCH(inst->VRegB_21t());
+    } else {
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IF_GEZ) {
+    if (shadow_frame.GetVReg(inst->VRegA_21t()) >= 0) {
+      BRANCH(inst->VRegB_21t());
+    } else {
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IF_GTZ) {
+    if (shadow_frame.GetVReg(inst->VRegA_21t()) > 0) {
+      BRANCH(inst->VRegB_21t());
+    } else {
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IF_LEZ) {
+    if (shadow_frame.GetVReg(inst->VRegA_21t()) <= 0) {
+      BRANCH(inst->VRegB_21t());
+    } else {
+      inst = inst->Next_2xx();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(AGET_BOOLEAN) {
+    Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
+    if (UNLIKELY(a == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+      HANDLE_INSTRUCTION_END();
+    }
+    int32_t index = shadow_frame.GetVReg(inst->VRegC_23x());
+    BooleanArray* array = a->AsBooleanArray();
+    if (LIKELY(array->IsValidIndex(index))) {
+      shadow_frame.SetVReg(inst->VRegA_23x(), array->GetData()[index]);
+      inst = inst->Next_2xx();
+    } else {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(AGET_BYTE) {
+    Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
+    if (UNLIKELY(a == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+      HANDLE_INSTRUCTION_END();
+    }
+    int32_t index = shadow_frame.GetVReg(inst->VRegC_23x());
+    ByteArray* array = a->AsByteArray();
+    if (LIKELY(array->IsValidIndex(index))) {
+      shadow_frame.SetVReg(inst->VRegA_23x(), array->GetData()[index]);
+      inst = inst->Next_2xx();
+    } else {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(AGET_CHAR) {
+    Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
+    if (UNLIKELY(a == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+      HANDLE_INSTRUCTION_END();
+    }
+    int32_t index = shadow_frame.GetVReg(inst->VRegC_23x());
+    CharArray* array = a->AsCharArray();
+    if (LIKELY(array->IsValidIndex(index))) {
+      shadow_frame.SetVReg(inst->VRegA_23x(), array->GetData()[index]);
+      inst = inst->Next_2xx();
+    } else {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(AGET_SHORT) {
+    Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
+    if (UNLIKELY(a == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+      HANDLE_INSTRUCTION_END();
+    }
+    int32_t index = shadow_frame.GetVReg(inst->VRegC_23x());
+    ShortArray* array = a->AsShortArray();
+    if (LIKELY(array->IsValidIndex(index))) {
+      shadow_frame.SetVReg(inst->VRegA_23x(), array->GetData()[index]);
+      inst = inst->Next_2xx();
+    } else {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(AGET) {
+    Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
+    if (UNLIKELY(a == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+      HANDLE_INSTRUCTION_END();
+    }
+    int32_t index = shadow_frame.GetVReg(inst->VRegC_23x());
+    IntArray* array = a->AsIntArray();
+    if (LIKELY(array->IsValidIndex(index))) {
+      shadow_frame.SetVReg(inst->VRegA_23x(), array->GetData()[index]);
+      inst = inst->Next_2xx();
+    } else {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(AGET_WIDE) {
+    Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
+    if (UNLIKELY(a == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+      HANDLE_INSTRUCTION_END();
+    }
+    int32_t index = shadow_frame.GetVReg(inst->VRegC_23x());
+    LongArray* array = a->AsLongArray();
+    if (LIKELY(array->IsValidIndex(index))) {
+      shadow_frame.SetVRegLong(inst->VRegA_23x(), array->GetData()[index]);
+      inst = inst->Next_2xx();
+    } else {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(AGET_OBJECT) {
+    Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
+    if (UNLIKELY(a == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+      HANDLE_INSTRUCTION_END();
+    }
+    int32_t index = shadow_frame.GetVReg(inst->VRegC_23x());
+    ObjectArray<Object>* array = a->AsObjectArray<Object>();
+    if (LIKELY(array->IsValidIndex(index))) {
+      shadow_frame.SetVRegReference(inst->VRegA_23x(), array->GetWithoutChecks(index));
+      inst = inst->Next_2xx();
+    } else {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(APUT_BOOLEAN) {
+    Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
+    if (UNLIKELY(a == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+      HANDLE_INSTRUCTION_END();
+    }
+    uint8_t val = shadow_frame.GetVReg(inst->VRegA_23x());
+    int32_t index = shadow_frame.GetVReg(inst->VRegC_23x());
+    BooleanArray* array = a->AsBooleanArray();
+    if (LIKELY(array->IsValidIndex(index))) {
+      array->GetData()[index] = val;
+      inst = inst->Next_2xx();
+    } else {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(APUT_BYTE) {
+    Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
+    if (UNLIKELY(a == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+      HANDLE_INSTRUCTION_END();
+    }
+    int8_t val = shadow_frame.GetVReg(inst->VRegA_23x());
+    int32_t index = shadow_frame.GetVReg(inst->VRegC_23x());
+    ByteArray* array = a->AsByteArray();
+    if (LIKELY(array->IsValidIndex(index))) {
+      array->GetData()[index] = val;
+      inst = inst->Next_2xx();
+    } else {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(APUT_CHAR) {
+    Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
+    if (UNLIKELY(a == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+      HANDLE_INSTRUCTION_END();
+    }
+    uint16_t val = shadow_frame.GetVReg(inst->VRegA_23x());
+    int32_t index = shadow_frame.GetVReg(inst->VRegC_23x());
+    CharArray* array = a->AsCharArray();
+    if (LIKELY(array->IsValidIndex(index))) {
+      array->GetData()[index] = val;
+      inst = inst->Next_2xx();
+    } else {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(APUT_SHORT) {
+    Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
+    if (UNLIKELY(a == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+      HANDLE_INSTRUCTION_END();
+    }
+    int16_t val = shadow_frame.GetVReg(inst->VRegA_23x());
+    int32_t index = shadow_frame.GetVReg(inst->VRegC_23x());
+    ShortArray* array = a->AsShortArray();
+    if (LIKELY(array->IsValidIndex(index))) {
+      array->GetData()[index] = val;
+      inst = inst->Next_2xx();
+    } else {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(APUT) {
+    Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
+    if (UNLIKELY(a == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+      HANDLE_INSTRUCTION_END();
+    }
+    int32_t val = shadow_frame.GetVReg(inst->VRegA_23x());
+    int32_t index = shadow_frame.GetVReg(inst->VRegC_23x());
+    IntArray* array = a->AsIntArray();
+    if (LIKELY(array->IsValidIndex(index))) {
+      array->GetData()[index] = val;
+      inst = inst->Next_2xx();
+    } else {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(APUT_WIDE) {
+    Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
+    if (UNLIKELY(a == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+      HANDLE_INSTRUCTION_END();
+    }
+    int64_t val = shadow_frame.GetVRegLong(inst->VRegA_23x());
+    int32_t index = shadow_frame.GetVReg(inst->VRegC_23x());
+    LongArray* array = a->AsLongArray();
+    if (LIKELY(array->IsValidIndex(index))) {
+      array->GetData()[index] = val;
+      inst = inst->Next_2xx();
+    } else {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(APUT_OBJECT) {
+    Object* a = shadow_frame.GetVRegReference(inst->VRegB_23x());
+    if (UNLIKELY(a == NULL)) {
+      ThrowNullPointerExceptionFromDexPC(shadow_frame.GetCurrentLocationForThrow());
+      HANDLE_PENDING_EXCEPTION();
+      HANDLE_INSTRUCTION_END();
+    }
+    int32_t index = shadow_frame.GetVReg(inst->VRegC_23x());
+    Object* val = shadow_frame.GetVRegReference(inst->VRegA_23x());
+    ObjectArray<Object>* array = a->AsObjectArray<Object>();
+    if (LIKELY(array->IsValidIndex(index) && array->CheckAssignable(val))) {
+      array->SetWithoutChecks(index, val);
+      inst = inst->Next_2xx();
+    } else {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IGET_BOOLEAN) {
+    bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimBoolean, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IGET_BYTE) {
+    bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimByte, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IGET_CHAR) {
+    bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimChar, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IGET_SHORT) {
+    bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimShort, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IGET) {
+    bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimInt, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IGET_WIDE) {
+    bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimLong, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IGET_OBJECT) {
+    bool success = DoFieldGet<InstanceObjectRead, Primitive::kPrimNot, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IGET_QUICK) {
+    bool success = DoIGetQuick<Primitive::kPrimInt>(self, shadow_frame, inst);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IGET_WIDE_QUICK) {
+    bool success = DoIGetQuick<Primitive::kPrimLong>(self, shadow_frame, inst);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IGET_OBJECT_QUICK) {
+    bool success = DoIGetQuick<Primitive::kPrimNot>(self, shadow_frame, inst);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SGET_BOOLEAN) {
+    bool success = DoFieldGet<StaticPrimitiveRead, Primitive::kPrimBoolean, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SGET_BYTE) {
+    bool success = DoFieldGet<StaticPrimitiveRead, Primitive::kPrimByte, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SGET_CHAR) {
+    bool success = DoFieldGet<StaticPrimitiveRead, Primitive::kPrimChar, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SGET_SHORT) {
+    bool success = DoFieldGet<StaticPrimitiveRead, Primitive::kPrimShort, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SGET) {
+    bool success = DoFieldGet<StaticPrimitiveRead, Primitive::kPrimInt, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SGET_WIDE) {
+    bool success = DoFieldGet<StaticPrimitiveRead, Primitive::kPrimLong, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SGET_OBJECT) {
+    bool success = DoFieldGet<StaticObjectRead, Primitive::kPrimNot, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IPUT_BOOLEAN) {
+    bool success = DoFieldPut<InstancePrimitiveWrite, Primitive::kPrimBoolean, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IPUT_BYTE) {
+    bool success = DoFieldPut<InstancePrimitiveWrite, Primitive::kPrimByte, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IPUT_CHAR) {
+    bool success = DoFieldPut<InstancePrimitiveWrite, Primitive::kPrimChar, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IPUT_SHORT) {
+    bool success = DoFieldPut<InstancePrimitiveWrite, Primitive::kPrimShort, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IPUT) {
+    bool success = DoFieldPut<InstancePrimitiveWrite, Primitive::kPrimInt, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IPUT_WIDE) {
+    bool success = DoFieldPut<InstancePrimitiveWrite, Primitive::kPrimLong, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IPUT_OBJECT) {
+    bool success = DoFieldPut<InstanceObjectWrite, Primitive::kPrimNot, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IPUT_QUICK) {
+    bool success = DoIPutQuick<Primitive::kPrimInt>(self, shadow_frame, inst);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IPUT_WIDE_QUICK) {
+    bool success = DoIPutQuick<Primitive::kPrimLong>(self, shadow_frame, inst);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(IPUT_OBJECT_QUICK) {
+    bool success = DoIPutQuick<Primitive::kPrimNot>(self, shadow_frame, inst);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SPUT_BOOLEAN) {
+    bool success = DoFieldPut<StaticPrimitiveWrite, Primitive::kPrimBoolean, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SPUT_BYTE) {
+    bool success = DoFieldPut<StaticPrimitiveWrite, Primitive::kPrimByte, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SPUT_CHAR) {
+    bool success = DoFieldPut<StaticPrimitiveWrite, Primitive::kPrimChar, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SPUT_SHORT) {
+    bool success = DoFieldPut<StaticPrimitiveWrite, Primitive::kPrimShort, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SPUT) {
+    bool success = DoFieldPut<StaticPrimitiveWrite, Primitive::kPrimInt, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SPUT_WIDE) {
+    bool success = DoFieldPut<StaticPrimitiveWrite, Primitive::kPrimLong, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SPUT_OBJECT) {
+    bool success = DoFieldPut<StaticObjectWrite, Primitive::kPrimNot, do_access_check>(self, shadow_frame, inst);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(INVOKE_VIRTUAL) {
+    bool success = DoInvoke<kVirtual, false, do_access_check>(self, shadow_frame, inst, &result_register);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(INVOKE_VIRTUAL_RANGE) {
+    bool success = DoInvoke<kVirtual, true, do_access_check>(self, shadow_frame, inst, &result_register);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(INVOKE_SUPER) {
+    bool success = DoInvoke<kSuper, false, do_access_check>(self, shadow_frame, inst, &result_register);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(INVOKE_SUPER_RANGE) {
+    bool success = DoInvoke<kSuper, true, do_access_check>(self, shadow_frame, inst, &result_register);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(INVOKE_DIRECT) {
+    bool success = DoInvoke<kDirect, false, do_access_check>(self, shadow_frame, inst, &result_register);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(INVOKE_DIRECT_RANGE) {
+    bool success = DoInvoke<kDirect, true, do_access_check>(self, shadow_frame, inst, &result_register);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(INVOKE_INTERFACE) {
+    bool success = DoInvoke<kInterface, false, do_access_check>(self, shadow_frame, inst, &result_register);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(INVOKE_INTERFACE_RANGE) {
+    bool success = DoInvoke<kInterface, true, do_access_check>(self, shadow_frame, inst, &result_register);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(INVOKE_STATIC) {
+    bool success = DoInvoke<kStatic, false, do_access_check>(self, shadow_frame, inst, &result_register);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(INVOKE_STATIC_RANGE) {
+    bool success = DoInvoke<kStatic, true, do_access_check>(self, shadow_frame, inst, &result_register);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(INVOKE_VIRTUAL_QUICK) {
+    bool success = DoInvokeVirtualQuick<false>(self, shadow_frame, inst, &result_register);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(INVOKE_VIRTUAL_RANGE_QUICK) {
+    bool success = DoInvokeVirtualQuick<true>(self, shadow_frame, inst, &result_register);
+    UPDATE_HANDLER_TABLE();
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_3xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(NEG_INT)
+    shadow_frame.SetVReg(inst->VRegA_12x(), -shadow_frame.GetVReg(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(NOT_INT)
+    shadow_frame.SetVReg(inst->VRegA_12x(), ~shadow_frame.GetVReg(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(NEG_LONG)
+    shadow_frame.SetVRegLong(inst->VRegA_12x(), -shadow_frame.GetVRegLong(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(NOT_LONG)
+    shadow_frame.SetVRegLong(inst->VRegA_12x(), ~shadow_frame.GetVRegLong(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(NEG_FLOAT)
+    shadow_frame.SetVRegFloat(inst->VRegA_12x(), -shadow_frame.GetVRegFloat(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(NEG_DOUBLE)
+    shadow_frame.SetVRegDouble(inst->VRegA_12x(), -shadow_frame.GetVRegDouble(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(INT_TO_LONG)
+    shadow_frame.SetVRegLong(inst->VRegA_12x(), shadow_frame.GetVReg(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(INT_TO_FLOAT)
+    shadow_frame.SetVRegFloat(inst->VRegA_12x(), shadow_frame.GetVReg(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(INT_TO_DOUBLE)
+    shadow_frame.SetVRegDouble(inst->VRegA_12x(), shadow_frame.GetVReg(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(LONG_TO_INT)
+    shadow_frame.SetVReg(inst->VRegA_12x(), shadow_frame.GetVRegLong(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(LONG_TO_FLOAT)
+    shadow_frame.SetVRegFloat(inst->VRegA_12x(), shadow_frame.GetVRegLong(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(LONG_TO_DOUBLE)
+    shadow_frame.SetVRegDouble(inst->VRegA_12x(), shadow_frame.GetVRegLong(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(FLOAT_TO_INT) {
+    float val = shadow_frame.GetVRegFloat(inst->VRegB_12x());
+    int32_t result;
+    if (val != val) {
+      result = 0;
+    } else if (val > static_cast<float>(kMaxInt)) {
+      result = kMaxInt;
+    } else if (val < static_cast<float>(kMinInt)) {
+      result = kMinInt;
+    } else {
+      result = val;
+    }
+    shadow_frame.SetVReg(inst->VRegA_12x(), result);
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(FLOAT_TO_LONG) {
+    float val = shadow_frame.GetVRegFloat(inst->VRegB_12x());
+    int64_t result;
+    if (val != val) {
+      result = 0;
+    } else if (val > static_cast<float>(kMaxLong)) {
+      result = kMaxLong;
+    } else if (val < static_cast<float>(kMinLong)) {
+      result = kMinLong;
+    } else {
+      result = val;
+    }
+    shadow_frame.SetVRegLong(inst->VRegA_12x(), result);
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(FLOAT_TO_DOUBLE)
+    shadow_frame.SetVRegDouble(inst->VRegA_12x(), shadow_frame.GetVRegFloat(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(DOUBLE_TO_INT) {
+    double val = shadow_frame.GetVRegDouble(inst->VRegB_12x());
+    int32_t result;
+    if (val != val) {
+      result = 0;
+    } else if (val > static_cast<double>(kMaxInt)) {
+      result = kMaxInt;
+    } else if (val < static_cast<double>(kMinInt)) {
+      result = kMinInt;
+    } else {
+      result = val;
+    }
+    shadow_frame.SetVReg(inst->VRegA_12x(), result);
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(DOUBLE_TO_LONG) {
+    double val = shadow_frame.GetVRegDouble(inst->VRegB_12x());
+    int64_t result;
+    if (val != val) {
+      result = 0;
+    } else if (val > static_cast<double>(kMaxLong)) {
+      result = kMaxLong;
+    } else if (val < static_cast<double>(kMinLong)) {
+      result = kMinLong;
+    } else {
+      result = val;
+    }
+    shadow_frame.SetVRegLong(inst->VRegA_12x(), result);
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(DOUBLE_TO_FLOAT)
+    shadow_frame.SetVRegFloat(inst->VRegA_12x(), shadow_frame.GetVRegDouble(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(INT_TO_BYTE)
+    shadow_frame.SetVReg(inst->VRegA_12x(),
+                         static_cast<int8_t>(shadow_frame.GetVReg(inst->VRegB_12x())));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(INT_TO_CHAR)
+    shadow_frame.SetVReg(inst->VRegA_12x(),
+                         static_cast<uint16_t>(shadow_frame.GetVReg(inst->VRegB_12x())));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(INT_TO_SHORT)
+    shadow_frame.SetVReg(inst->VRegA_12x(),
+                         static_cast<int16_t>(shadow_frame.GetVReg(inst->VRegB_12x())));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(ADD_INT)
+    shadow_frame.SetVReg(inst->VRegA_23x(),
+                         shadow_frame.GetVReg(inst->VRegB_23x()) +
+                         shadow_frame.GetVReg(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(SUB_INT)
+    shadow_frame.SetVReg(inst->VRegA_23x(),
+                         shadow_frame.GetVReg(inst->VRegB_23x()) -
+                         shadow_frame.GetVReg(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MUL_INT)
+    shadow_frame.SetVReg(inst->VRegA_23x(),
+                         shadow_frame.GetVReg(inst->VRegB_23x()) *
+                         shadow_frame.GetVReg(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(DIV_INT) {
+    bool success = DoIntDivide(shadow_frame, inst->VRegA_23x(),
+                               shadow_frame.GetVReg(inst->VRegB_23x()),
+                               shadow_frame.GetVReg(inst->VRegC_23x()));
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(REM_INT) {
+    bool success = DoIntRemainder(shadow_frame, inst->VRegA_23x(),
+                                  shadow_frame.GetVReg(inst->VRegB_23x()),
+                                  shadow_frame.GetVReg(inst->VRegC_23x()));
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SHL_INT)
+    shadow_frame.SetVReg(inst->VRegA_23x(),
+                         shadow_frame.GetVReg(inst->VRegB_23x()) <<
+                         (shadow_frame.GetVReg(inst->VRegC_23x()) & 0x1f));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(SHR_INT)
+    shadow_frame.SetVReg(inst->VRegA_23x(),
+                         shadow_frame.GetVReg(inst->VRegB_23x()) >>
+                         (shadow_frame.GetVReg(inst->VRegC_23x()) & 0x1f));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(USHR_INT)
+    shadow_frame.SetVReg(inst->VRegA_23x(),
+                         static_cast<uint32_t>(shadow_frame.GetVReg(inst->VRegB_23x())) >>
+                         (shadow_frame.GetVReg(inst->VRegC_23x()) & 0x1f));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(AND_INT)
+    shadow_frame.SetVReg(inst->VRegA_23x(),
+                         shadow_frame.GetVReg(inst->VRegB_23x()) &
+                         shadow_frame.GetVReg(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(OR_INT)
+    shadow_frame.SetVReg(inst->VRegA_23x(),
+                         shadow_frame.GetVReg(inst->VRegB_23x()) |
+                         shadow_frame.GetVReg(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(XOR_INT)
+    shadow_frame.SetVReg(inst->VRegA_23x(),
+                         shadow_frame.GetVReg(inst->VRegB_23x()) ^
+                         shadow_frame.GetVReg(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(ADD_LONG)
+    shadow_frame.SetVRegLong(inst->VRegA_23x(),
+                             shadow_frame.GetVRegLong(inst->VRegB_23x()) +
+                             shadow_frame.GetVRegLong(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(SUB_LONG)
+    shadow_frame.SetVRegLong(inst->VRegA_23x(),
+                             shadow_frame.GetVRegLong(inst->VRegB_23x()) -
+                             shadow_frame.GetVRegLong(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MUL_LONG)
+    shadow_frame.SetVRegLong(inst->VRegA_23x(),
+                             shadow_frame.GetVRegLong(inst->VRegB_23x()) *
+                             shadow_frame.GetVRegLong(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(DIV_LONG)
+    DoLongDivide(shadow_frame, inst->VRegA_23x(),
+                 shadow_frame.GetVRegLong(inst->VRegB_23x()),
+                shadow_frame.GetVRegLong(inst->VRegC_23x()));
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(self->IsExceptionPending(), Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(REM_LONG)
+    DoLongRemainder(shadow_frame, inst->VRegA_23x(),
+                    shadow_frame.GetVRegLong(inst->VRegB_23x()),
+                    shadow_frame.GetVRegLong(inst->VRegC_23x()));
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(self->IsExceptionPending(), Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(AND_LONG)
+    shadow_frame.SetVRegLong(inst->VRegA_23x(),
+                             shadow_frame.GetVRegLong(inst->VRegB_23x()) &
+                             shadow_frame.GetVRegLong(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(OR_LONG)
+    shadow_frame.SetVRegLong(inst->VRegA_23x(),
+                             shadow_frame.GetVRegLong(inst->VRegB_23x()) |
+                             shadow_frame.GetVRegLong(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(XOR_LONG)
+    shadow_frame.SetVRegLong(inst->VRegA_23x(),
+                             shadow_frame.GetVRegLong(inst->VRegB_23x()) ^
+                             shadow_frame.GetVRegLong(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(SHL_LONG)
+    shadow_frame.SetVRegLong(inst->VRegA_23x(),
+                             shadow_frame.GetVRegLong(inst->VRegB_23x()) <<
+                             (shadow_frame.GetVReg(inst->VRegC_23x()) & 0x3f));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(SHR_LONG)
+    shadow_frame.SetVRegLong(inst->VRegA_23x(),
+                             shadow_frame.GetVRegLong(inst->VRegB_23x()) >>
+                             (shadow_frame.GetVReg(inst->VRegC_23x()) & 0x3f));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(USHR_LONG)
+    shadow_frame.SetVRegLong(inst->VRegA_23x(),
+                             static_cast<uint64_t>(shadow_frame.GetVRegLong(inst->VRegB_23x())) >>
+                             (shadow_frame.GetVReg(inst->VRegC_23x()) & 0x3f));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(ADD_FLOAT)
+    shadow_frame.SetVRegFloat(inst->VRegA_23x(),
+                              shadow_frame.GetVRegFloat(inst->VRegB_23x()) +
+                              shadow_frame.GetVRegFloat(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(SUB_FLOAT)
+    shadow_frame.SetVRegFloat(inst->VRegA_23x(),
+                              shadow_frame.GetVRegFloat(inst->VRegB_23x()) -
+                              shadow_frame.GetVRegFloat(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MUL_FLOAT)
+    shadow_frame.SetVRegFloat(inst->VRegA_23x(),
+                              shadow_frame.GetVRegFloat(inst->VRegB_23x()) *
+                              shadow_frame.GetVRegFloat(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(DIV_FLOAT)
+    shadow_frame.SetVRegFloat(inst->VRegA_23x(),
+                              shadow_frame.GetVRegFloat(inst->VRegB_23x()) /
+                              shadow_frame.GetVRegFloat(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(REM_FLOAT)
+    shadow_frame.SetVRegFloat(inst->VRegA_23x(),
+                              fmodf(shadow_frame.GetVRegFloat(inst->VRegB_23x()),
+                                    shadow_frame.GetVRegFloat(inst->VRegC_23x())));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(ADD_DOUBLE)
+    shadow_frame.SetVRegDouble(inst->VRegA_23x(),
+                               shadow_frame.GetVRegDouble(inst->VRegB_23x()) +
+                               shadow_frame.GetVRegDouble(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(SUB_DOUBLE)
+    shadow_frame.SetVRegDouble(inst->VRegA_23x(),
+                               shadow_frame.GetVRegDouble(inst->VRegB_23x()) -
+                               shadow_frame.GetVRegDouble(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MUL_DOUBLE)
+    shadow_frame.SetVRegDouble(inst->VRegA_23x(),
+                               shadow_frame.GetVRegDouble(inst->VRegB_23x()) *
+                               shadow_frame.GetVRegDouble(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(DIV_DOUBLE)
+    shadow_frame.SetVRegDouble(inst->VRegA_23x(),
+                               shadow_frame.GetVRegDouble(inst->VRegB_23x()) /
+                               shadow_frame.GetVRegDouble(inst->VRegC_23x()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(REM_DOUBLE)
+    shadow_frame.SetVRegDouble(inst->VRegA_23x(),
+                               fmod(shadow_frame.GetVRegDouble(inst->VRegB_23x()),
+                                    shadow_frame.GetVRegDouble(inst->VRegC_23x())));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(ADD_INT_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVReg(vregA,
+                         shadow_frame.GetVReg(vregA) +
+                         shadow_frame.GetVReg(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SUB_INT_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVReg(vregA,
+                         shadow_frame.GetVReg(vregA) -
+                         shadow_frame.GetVReg(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(MUL_INT_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVReg(vregA,
+                         shadow_frame.GetVReg(vregA) *
+                         shadow_frame.GetVReg(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(DIV_INT_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    bool success = DoIntDivide(shadow_frame, vregA, shadow_frame.GetVReg(vregA),
+                               shadow_frame.GetVReg(inst->VRegB_12x()));
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_1xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(REM_INT_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    bool success = DoIntRemainder(shadow_frame, vregA, shadow_frame.GetVReg(vregA),
+                                  shadow_frame.GetVReg(inst->VRegB_12x()));
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_1xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SHL_INT_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVReg(vregA,
+                         shadow_frame.GetVReg(vregA) <<
+                         (shadow_frame.GetVReg(inst->VRegB_12x()) & 0x1f));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SHR_INT_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVReg(vregA,
+                         shadow_frame.GetVReg(vregA) >>
+                         (shadow_frame.GetVReg(inst->VRegB_12x()) & 0x1f));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(USHR_INT_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVReg(vregA,
+                         static_cast<uint32_t>(shadow_frame.GetVReg(vregA)) >>
+                         (shadow_frame.GetVReg(inst->VRegB_12x()) & 0x1f));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(AND_INT_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVReg(vregA,
+                         shadow_frame.GetVReg(vregA) &
+                         shadow_frame.GetVReg(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(OR_INT_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVReg(vregA,
+                         shadow_frame.GetVReg(vregA) |
+                         shadow_frame.GetVReg(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(XOR_INT_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVReg(vregA,
+                         shadow_frame.GetVReg(vregA) ^
+                         shadow_frame.GetVReg(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(ADD_LONG_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegLong(vregA,
+                             shadow_frame.GetVRegLong(vregA) +
+                             shadow_frame.GetVRegLong(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SUB_LONG_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegLong(vregA,
+                             shadow_frame.GetVRegLong(vregA) -
+                             shadow_frame.GetVRegLong(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(MUL_LONG_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegLong(vregA,
+                             shadow_frame.GetVRegLong(vregA) *
+                             shadow_frame.GetVRegLong(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(DIV_LONG_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    DoLongDivide(shadow_frame, vregA, shadow_frame.GetVRegLong(vregA),
+                shadow_frame.GetVRegLong(inst->VRegB_12x()));
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(self->IsExceptionPending(), Next_1xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(REM_LONG_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    DoLongRemainder(shadow_frame, vregA, shadow_frame.GetVRegLong(vregA),
+                    shadow_frame.GetVRegLong(inst->VRegB_12x()));
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(self->IsExceptionPending(), Next_1xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(AND_LONG_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegLong(vregA,
+                             shadow_frame.GetVRegLong(vregA) &
+                             shadow_frame.GetVRegLong(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(OR_LONG_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegLong(vregA,
+                             shadow_frame.GetVRegLong(vregA) |
+                             shadow_frame.GetVRegLong(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(XOR_LONG_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegLong(vregA,
+                             shadow_frame.GetVRegLong(vregA) ^
+                             shadow_frame.GetVRegLong(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SHL_LONG_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegLong(vregA,
+                             shadow_frame.GetVRegLong(vregA) <<
+                             (shadow_frame.GetVReg(inst->VRegB_12x()) & 0x3f));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SHR_LONG_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegLong(vregA,
+                             shadow_frame.GetVRegLong(vregA) >>
+                             (shadow_frame.GetVReg(inst->VRegB_12x()) & 0x3f));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(USHR_LONG_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegLong(vregA,
+                             static_cast<uint64_t>(shadow_frame.GetVRegLong(vregA)) >>
+                             (shadow_frame.GetVReg(inst->VRegB_12x()) & 0x3f));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(ADD_FLOAT_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegFloat(vregA,
+                              shadow_frame.GetVRegFloat(vregA) +
+                              shadow_frame.GetVRegFloat(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SUB_FLOAT_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegFloat(vregA,
+                              shadow_frame.GetVRegFloat(vregA) -
+                              shadow_frame.GetVRegFloat(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(MUL_FLOAT_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegFloat(vregA,
+                              shadow_frame.GetVRegFloat(vregA) *
+                              shadow_frame.GetVRegFloat(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(DIV_FLOAT_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegFloat(vregA,
+                              shadow_frame.GetVRegFloat(vregA) /
+                              shadow_frame.GetVRegFloat(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(REM_FLOAT_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegFloat(vregA,
+                              fmodf(shadow_frame.GetVRegFloat(vregA),
+                                    shadow_frame.GetVRegFloat(inst->VRegB_12x())));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(ADD_DOUBLE_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegDouble(vregA,
+                               shadow_frame.GetVRegDouble(vregA) +
+                               shadow_frame.GetVRegDouble(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(SUB_DOUBLE_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegDouble(vregA,
+                               shadow_frame.GetVRegDouble(vregA) -
+                               shadow_frame.GetVRegDouble(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(MUL_DOUBLE_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegDouble(vregA,
+                               shadow_frame.GetVRegDouble(vregA) *
+                               shadow_frame.GetVRegDouble(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(DIV_DOUBLE_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegDouble(vregA,
+                               shadow_frame.GetVRegDouble(vregA) /
+                               shadow_frame.GetVRegDouble(inst->VRegB_12x()));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(REM_DOUBLE_2ADDR) {
+    uint4_t vregA = inst->VRegA_12x();
+    shadow_frame.SetVRegDouble(vregA,
+                               fmod(shadow_frame.GetVRegDouble(vregA),
+                                    shadow_frame.GetVRegDouble(inst->VRegB_12x())));
+    inst = inst->Next_1xx();
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(ADD_INT_LIT16)
+    shadow_frame.SetVReg(inst->VRegA_22s(),
+                         shadow_frame.GetVReg(inst->VRegB_22s()) +
+                         inst->VRegC_22s());
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(RSUB_INT)
+    shadow_frame.SetVReg(inst->VRegA_22s(),
+                         inst->VRegC_22s() -
+                         shadow_frame.GetVReg(inst->VRegB_22s()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MUL_INT_LIT16)
+    shadow_frame.SetVReg(inst->VRegA_22s(),
+                         shadow_frame.GetVReg(inst->VRegB_22s()) *
+                         inst->VRegC_22s());
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(DIV_INT_LIT16) {
+    bool success = DoIntDivide(shadow_frame, inst->VRegA_22s(),
+                               shadow_frame.GetVReg(inst->VRegB_22s()), inst->VRegC_22s());
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(REM_INT_LIT16) {
+    bool success = DoIntRemainder(shadow_frame, inst->VRegA_22s(),
+                                  shadow_frame.GetVReg(inst->VRegB_22s()), inst->VRegC_22s());
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(AND_INT_LIT16)
+    shadow_frame.SetVReg(inst->VRegA_22s(),
+                         shadow_frame.GetVReg(inst->VRegB_22s()) &
+                         inst->VRegC_22s());
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(OR_INT_LIT16)
+    shadow_frame.SetVReg(inst->VRegA_22s(),
+                         shadow_frame.GetVReg(inst->VRegB_22s()) |
+                         inst->VRegC_22s());
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(XOR_INT_LIT16)
+    shadow_frame.SetVReg(inst->VRegA_22s(),
+                         shadow_frame.GetVReg(inst->VRegB_22s()) ^
+                         inst->VRegC_22s());
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(ADD_INT_LIT8)
+    shadow_frame.SetVReg(inst->VRegA_22b(),
+                         shadow_frame.GetVReg(inst->VRegB_22b()) +
+                         inst->VRegC_22b());
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(RSUB_INT_LIT8)
+    shadow_frame.SetVReg(inst->VRegA_22b(),
+                         inst->VRegC_22b() -
+                         shadow_frame.GetVReg(inst->VRegB_22b()));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(MUL_INT_LIT8)
+    shadow_frame.SetVReg(inst->VRegA_22b(),
+                         shadow_frame.GetVReg(inst->VRegB_22b()) *
+                         inst->VRegC_22b());
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(DIV_INT_LIT8) {
+    bool success = DoIntDivide(shadow_frame, inst->VRegA_22b(),
+                               shadow_frame.GetVReg(inst->VRegB_22b()), inst->VRegC_22b());
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(REM_INT_LIT8) {
+    bool success = DoIntRemainder(shadow_frame, inst->VRegA_22b(),
+                                  shadow_frame.GetVReg(inst->VRegB_22b()), inst->VRegC_22b());
+    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
+    HANDLE_INSTRUCTION_END();
+  }
+  HANDLE_INSTRUCTION_START(AND_INT_LIT8)
+    shadow_frame.SetVReg(inst->VRegA_22b(),
+                         shadow_frame.GetVReg(inst->VRegB_22b()) &
+                         inst->VRegC_22b());
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(OR_INT_LIT8)
+    shadow_frame.SetVReg(inst->VRegA_22b(),
+                         shadow_frame.GetVReg(inst->VRegB_22b()) |
+                         inst->VRegC_22b());
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(XOR_INT_LIT8)
+    shadow_frame.SetVReg(inst->VRegA_22b(),
+                         shadow_frame.GetVReg(inst->VRegB_22b()) ^
+                         inst->VRegC_22b());
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(SHL_INT_LIT8)
+    shadow_frame.SetVReg(inst->VRegA_22b(),
+                         shadow_frame.GetVReg(inst->VRegB_22b()) <<
+                         (inst->VRegC_22b() & 0x1f));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(SHR_INT_LIT8)
+    shadow_frame.SetVReg(inst->VRegA_22b(),
+                         shadow_frame.GetVReg(inst->VRegB_22b()) >>
+                         (inst->VRegC_22b() & 0x1f));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(USHR_INT_LIT8)
+    shadow_frame.SetVReg(inst->VRegA_22b(),
+                         static_cast<uint32_t>(shadow_frame.GetVReg(inst->VRegB_22b())) >>
+                         (inst->VRegC_22b() & 0x1f));
+    inst = inst->Next_2xx();
+    HANDLE_INSTRUCTION_END();
+  HANDLE_INSTRUCTION_START(UNUSED_3E)
+  HANDLE_INSTRUCTION_START(UNUSED_3F)
+  HANDLE_INSTRUCTION_START(UNUSED_40)
+  HANDLE_INSTRUCTION_START(UNUSED_41)
+  HANDLE_INSTRUCTION_START(UNUSED_42)
+  HANDLE_INSTRUCTION_START(UNUSED_43)
+  HANDLE_INSTRUCTION_START(UNUSED_EB)
+  HANDLE_INSTRUCTION_START(UNUSED_EC)
+  HANDLE_INSTRUCTION_START(UNUSED_ED)
+  HANDLE_INSTRUCTION_START(UNUSED_EE)
+  HANDLE_INSTRUCTION_START(UNUSED_EF)
+  HANDLE_INSTRUCTION_START(UNUSED_F0)
+  HANDLE_INSTRUCTION_START(UNUSED_F1)
+  HANDLE_INSTRUCTION_START(UNUSED_F2)
+  HANDLE_INSTRUCTION_START(UNUSED_F3)
+  HANDLE_INSTRUCTION_START(UNUSED_F4)
+  HANDLE_INSTRUCTION_START(UNUSED_F5)
+  HANDLE_INSTRUCTION_START(UNUSED_F6)
+  HANDLE_INSTRUCTION_START(UNUSED_F7)
+  HANDLE_INSTRUCTION_START(UNUSED_F8)
+  HANDLE_INSTRUCTION_START(UNUSED_F9)
+  HANDLE_INSTRUCTION_START(UNUSED_FA)
+  HANDLE_INSTRUCTION_START(UNUSED_FB)
+  HANDLE_INSTRUCTION_START(UNUSED_FC)
+  HANDLE_INSTRUCTION_START(UNUSED_FD)
+  HANDLE_INSTRUCTION_START(UNUSED_FE)
+  HANDLE_INSTRUCTION_START(UNUSED_FF)
+  HANDLE_INSTRUCTION_START(UNUSED_79)
+  HANDLE_INSTRUCTION_START(UNUSED_7A)
+    UnexpectedOpcode(inst, mh);
+
+#endif  // ART_RUNTIME_INTERPRETER_INTERPRETER_INSTRUCTION_HANDLERS_H_
+#undef ART_RUNTIME_INTERPRETER_INTERPRETER_INSTRUCTION_HANDLERS_H_  // the guard in this file is just for cpplint
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "interpreter.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "common_test.h"
+#include "instrumentation.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "scoped_thread_state_change.h"
+#include "sirt_ref.h"
+#include "thread_list.h"
+#include "utils.h"
+
+namespace art {
+namespace interpreter {
+
+// Counts the instructions executed by the interpreter while it is registered for dex pc events.
+class InstructionCounter : public instrumentation::InstrumentationListener {
+ public:
+  InstructionCounter() : count_(0) {}
+
+  virtual void MethodEntered(Thread* thread, mirror::Object* this_object,
+                             const mirror::ArtMethod* method, uint32_t dex_pc) {}
+
+  virtual void MethodExited(Thread* thread, mirror::Object* this_object,
+                            const mirror::ArtMethod* method, uint32_t dex_pc,
+                            const JValue& return_value) {}
+
+  virtual void MethodUnwind(Thread* thread, const mirror::ArtMethod* method, uint32_t dex_pc) {}
+
+  virtual void DexPcMoved(Thread* thread, mirror::Object* this_object,
+                          const mirror::ArtMethod* method, uint32_t new_dex_pc) {
+    ++count_;
+  }
+
+  virtual void ExceptionCaught(Thread* thread, const ThrowLocation& throw_location,
+                               mirror::ArtMethod* catch_method, uint32_t catch_dex_pc,
+                               mirror::Throwable* exception_object) {}
+
+  uint64_t GetCount() const {
+    return count_;
+  }
+
+  void Reset() {
+    count_ = 0;
+  }
+
+ private:
+  uint64_t count_;
+
+  DISALLOW_COPY_AND_ASSIGN(InstructionCounter);
+};
+
+class InterpreterTest : public CommonTest {
+ protected:
+  // Adds or removes the listener for dex pc events, which switches the interpreter to its
+  // instrumented handlers. Must be called while not runnable.
+  void SetDexPcListener(InstructionCounter* counter, bool add) {
+    // Listeners are changed with the mutator lock exclusively held, as when tracing starts.
+    ThreadList* thread_list = runtime_->GetThreadList();
+    thread_list->SuspendAll();
+    if (add) {
+      runtime_->GetInstrumentation()->AddListener(counter,
+                                                  instrumentation::Instrumentation::kDexPcMoved);
+    } else {
+      runtime_->GetInstrumentation()->RemoveListener(counter,
+                                                     instrumentation::Instrumentation::kDexPcMoved);
+    }
+    thread_list->ResumeAll();
+  }
+
+  // Finds the static int method(int) of the given names in InterpreterBenchmark.
+  void FindMethods(const char* const* names, size_t count,
+                   std::vector<mirror::ArtMethod*>* methods) {
+    jobject jclass_loader = LoadDex("InterpreterBenchmark");
+    ScopedObjectAccess soa(Thread::Current());
+    SirtRef<mirror::ClassLoader> class_loader(soa.Self(),
+                                              soa.Decode<mirror::ClassLoader*>(jclass_loader));
+    mirror::Class* klass = class_linker_->FindClass("LInterpreterBenchmark;", class_loader.get());
+    ASSERT_TRUE(klass != NULL);
+    for (size_t i = 0; i < count; ++i) {
+      mirror::ArtMethod* method = klass->FindDirectMethod(names[i], "(I)I");
+      ASSERT_TRUE(method != NULL) << names[i];
+      methods->push_back(method);
+    }
+  }
+
+  // Interprets the static int method(int) with the given argument.
+  int32_t Run(mirror::ArtMethod* method, int32_t iterations) {
+    ScopedObjectAccess soa(Thread::Current());
+    uint32_t args[1] = { static_cast<uint32_t>(iterations) };
+    JValue result;
+    EnterInterpreterFromInvoke(soa.Self(), method, NULL, args, &result);
+    CHECK(!soa.Self()->IsExceptionPending());
+    return result.GetI();
+  }
+};
+
+// Reports the throughput of the interpreter over a few loops in the style of the run-tests. The
+// instructions are counted once with a dex pc listener, which also runs the instrumented handlers,
+// then the loop is timed without it.
+TEST_F(InterpreterTest, Benchmark) {
+  static const char* kMethods[] = {
+    "intMath",
+    "longMath",
+    "floatMath",
+    "switches",
+    "arrays",
+    "fields",
+    "calls",
+  };
+  static const int32_t kIterations = 100000;
+
+  std::vector<mirror::ArtMethod*> methods;
+  FindMethods(kMethods, arraysize(kMethods), &methods);
+  ASSERT_EQ(arraysize(kMethods), methods.size());
+
+  InstructionCounter counter;
+  uint64_t total_instructions = 0;
+  uint64_t total_ns = 0;
+  for (size_t i = 0; i < methods.size(); ++i) {
+    SetDexPcListener(&counter, true);
+    counter.Reset();
+    int32_t instrumented_result = Run(methods[i], kIterations);
+    uint64_t instructions = counter.GetCount();
+    SetDexPcListener(&counter, false);
+    ASSERT_GT(instructions, static_cast<uint64_t>(kIterations));
+
+    uint64_t start_ns = NanoTime();
+    int32_t result = Run(methods[i], kIterations);
+    uint64_t duration_ns = NanoTime() - start_ns;
+    // Both sets of handlers must compute the same thing.
+    EXPECT_EQ(instrumented_result, result) << kMethods[i];
+
+    total_instructions += instructions;
+    total_ns += duration_ns;
+    LOG(INFO) << kMethods[i] << ": " << instructions << " instructions in "
+              << PrettyDuration(duration_ns) << ", "
+              << (instructions * 1000000000 / std::max<uint64_t>(duration_ns, 1))
+              << " instructions/s";
+  }
+  LOG(INFO) << "Total: " << total_instructions << " instructions in " << PrettyDuration(total_ns)
+            << ", " << (total_instructions * 1000000000 / std::max<uint64_t>(total_ns, 1))
+            << " instructions/s";
+}
+
+// Both implementations run the same handlers, so they must compute the same results and report
+// the same instructions to a dex pc listener, including across caught exceptions and monitors.
+TEST_F(InterpreterTest, ImplementationsAgree) {
+  static const char* kMethods[] = {
+    "intMath",
+    "longMath",
+    "floatMath",
+    "switches",
+    "arrays",
+    "fields",
+    "calls",
+    "exceptions",
+  };
+  static const InterpreterImplKind kImplKinds[] = { kSwitchImpl, kGotoImpl };
+  static const int32_t kIterations = 1000;
+
+  std::vector<mirror::ArtMethod*> methods;
+  FindMethods(kMethods, arraysize(kMethods), &methods);
+  ASSERT_EQ(arraysize(kMethods), methods.size());
+
+  const InterpreterImplKind default_impl_kind = GetInterpreterImplKind();
+  InstructionCounter counter;
+  for (size_t i = 0; i < methods.size(); ++i) {
+    int32_t results[arraysize(kImplKinds)];
+    uint64_t instructions[arraysize(kImplKinds)];
+    for (size_t j = 0; j < arraysize(kImplKinds); ++j) {
+      SetInterpreterImplKind(kImplKinds[j]);
+      SetDexPcListener(&counter, true);
+      counter.Reset();
+      int32_t instrumented_result = Run(methods[i], kIterations);
+      instructions[j] = counter.GetCount();
+      SetDexPcListener(&counter, false);
+      results[j] = Run(methods[i], kIterations);
+      EXPECT_EQ(instrumented_result, results[j]) << kMethods[i] << " impl " << kImplKinds[j];
+    }
+    EXPECT_EQ(results[0], results[1]) << kMethods[i];
+    EXPECT_EQ(instructions[0], instructions[1]) << kMethods[i];
+  }
+  SetInterpreterImplKind(default_impl_kind);
+}
+
+}  // namespace interpreter
+}  // namespace art
@@ -1685,6 +1685,8 @@ void JdwpState::ProcessRequest(Request& request, ExpandBuf* pReply) {
    * Do this after anything that can stall indefinitely.
    */
   Thread* self = Thread::Current();
+  // Becoming runnable clears this, the thread is back where it was once the request is handled.
+  bool at_moving_gc_safe_point = self->IsAtMovingGcSafePoint();
   ThreadState old_state = self->TransitionFromSuspendedToRunnable();
 
   expandBufAddSpace(pReply, kJDWPHeaderLen);
@@ -1740,6 +1742,7 @@ void JdwpState::ProcessRequest(Request& request, ExpandBuf* pReply) {
   }
 
   /* tell the VM that GC is okay again */
+  self->SetAtMovingGcSafePoint(at_moving_gc_safe_point);
   self->TransitionFromRunnableToSuspended(old_state);
 }
 
@@ -430,6 +430,9 @@ void JdwpState::Run() {
   /* set the thread state to kWaitingInMainDebuggerLoop so GCs don't wait for us */
   CHECK_EQ(thread_->GetState(), kNative);
   Locks::mutator_lock_->AssertNotHeld(thread_);
+  // Outside of runnable the loop refers to objects by their registry ids only, so objects may
+  // move under it. Becoming runnable to touch them clears this until the thread is back here.
+  thread_->SetAtMovingGcSafePoint(true);
   thread_->SetState(kWaitingInMainDebuggerLoop);
 
   /*
@@ -509,6 +512,7 @@ void JdwpState::Run() {
       /* broadcast the disconnect; must be in RUNNING state */
       thread_->TransitionFromSuspendedToRunnable();
       Dbg::DdmDisconnected();
+      thread_->SetAtMovingGcSafePoint(true);
       thread_->TransitionFromRunnableToSuspended(kWaitingInMainDebuggerLoop);
     }
 
@@ -532,6 +536,7 @@ void JdwpState::Run() {
 
   /* back to native, for thread shutdown */
   CHECK_EQ(thread_->GetState(), kWaitingInMainDebuggerLoop);
+  thread_->SetAtMovingGcSafePoint(false);
   thread_->SetState(kNative);
 
   VLOG(jdwp) << "JDWP: thread detaching and exiting...";
@@ -437,7 +437,10 @@ static jint JII_AttachCurrentThread(JavaVM* vm, JNIEnv** p_env, void* raw_args,
     *p_env = NULL;
     return JNI_ERR;
   } else {
-    *p_env = Thread::Current()->GetJniEnv();
+    Thread* self = Thread::Current();
+    // The attached native code only refers to objects through JNI references.
+    self->SetAtMovingGcSafePoint(true);
+    *p_env = self->GetJniEnv();
     return JNI_OK;
   }
 }
@@ -510,6 +513,12 @@ class SharedLibrary {
     return dlsym(handle_, symbol_name.c_str());
   }
 
+  void VisitRoots(RootVisitor* visitor, void* arg) {
+    if (class_loader_ != NULL) {
+      class_loader_ = visitor(class_loader_, arg);
+    }
+  }
+
  private:
   enum JNI_OnLoadState {
     kPending,
@@ -570,6 +579,14 @@ class Libraries {
     libraries_.Put(path, library);
   }
 
+  // The class loaders of the libraries are compared by address, so they are visited as roots to
+  // be updated when they move.
+  void VisitRoots(RootVisitor* visitor, void* arg) {
+    for (auto& library : libraries_) {
+      library.second->VisitRoots(visitor, arg);
+    }
+  }
+
   // See section 11.3 "Linking Native Methods" of the JNI spec.
   void* FindNativeMethod(const ArtMethod* m, std::string& detail)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
@@ -3084,12 +3101,11 @@ void JavaVMExt::AllowNewWeakGlobals() {
   weak_globals_add_condition_.Broadcast(self);
 }
 
-void JavaVMExt::SweepWeakGlobals(IsMarkedTester is_marked, void* arg) {
+void JavaVMExt::SweepWeakGlobals(RootVisitor* visitor, void* arg) {
   MutexLock mu(Thread::Current(), weak_globals_lock_);
   for (const Object** entry : weak_globals_) {
-    if (!is_marked(*entry, arg)) {
-      *entry = kClearedJniWeakGlobal;
-    }
+    Object* object = visitor(const_cast<Object*>(*entry), arg);
+    *entry = (object != NULL) ? object : kClearedJniWeakGlobal;
   }
 }
 
@@ -3284,6 +3300,10 @@ void JavaVMExt::VisitRoots(RootVisitor* visitor, void* arg) {
     MutexLock mu(self, pins_lock);
     pin_table.VisitRoots(visitor, arg);
   }
+  {
+    MutexLock mu(self, libraries_lock);
+    libraries->VisitRoots(visitor, arg);
+  }
   // The weak_globals table is visited by the GC itself (because it mutates the table).
 }
 
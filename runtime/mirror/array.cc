@@ -32,8 +32,10 @@
 namespace art {
 namespace mirror {
 
-Array* Array::Alloc(Thread* self, Class* array_class, int32_t component_count,
-                    size_t component_size) {
+// Returns the size of the array, or 0 after throwing OutOfMemoryError if the size overflows.
+static size_t ComputeArraySize(Thread* self, Class* array_class, int32_t component_count,
+                               size_t component_size)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   DCHECK(array_class != NULL);
   DCHECK_GE(component_count, 0);
   DCHECK(array_class->IsArrayClass());
@@ -48,9 +50,17 @@ Array* Array::Alloc(Thread* self, Class* array_class, int32_t component_count,
     self->ThrowOutOfMemoryError(StringPrintf("%s of length %d would overflow",
                                              PrettyDescriptor(array_class).c_str(),
                                              component_count).c_str());
-    return NULL;
+    return 0;
   }
+  return size;
+}
 
+Array* Array::Alloc(Thread* self, Class* array_class, int32_t component_count,
+                    size_t component_size) {
+  size_t size = ComputeArraySize(self, array_class, component_count, component_size);
+  if (UNLIKELY(size == 0)) {
+    return NULL;
+  }
   gc::Heap* heap = Runtime::Current()->GetHeap();
   Array* array = down_cast<Array*>(heap->AllocObject(self, array_class, size));
   if (array != NULL) {
@@ -65,6 +75,21 @@ Array* Array::Alloc(Thread* self, Class* array_class, int32_t component_count) {
   return Alloc(self, array_class, component_count, array_class->GetComponentSize());
 }
 
+Array* Array::AllocNonMovable(Thread* self, Class* array_class, int32_t component_count) {
+  size_t size = ComputeArraySize(self, array_class, component_count,
+                                 array_class->GetComponentSize());
+  if (UNLIKELY(size == 0)) {
+    return NULL;
+  }
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  Array* array = down_cast<Array*>(heap->AllocNonMovableObject(self, array_class, size));
+  if (array != NULL) {
+    DCHECK(array->IsArrayInstance());
+    array->SetLength(component_count);
+  }
+  return array;
+}
+
 // Create a multi-dimensional array of Objects or primitive types.
 //
 // We have to generate the names for X[], X[][], X[][][], and so on.  The
@@ -64,11 +64,11 @@ inline void Object::NotifyAll(Thread* self) {
 }
 
 inline void Object::Wait(Thread* self) {
-  Monitor::Wait(self, this, 0, 0, true, kWaiting);
+  Monitor::Wait(self, this, 0, 0, true, kWaiting, true);
 }
 
 inline void Object::Wait(Thread* self, int64_t ms, int32_t ns) {
-  Monitor::Wait(self, this, ms, ns, true, kTimedWaiting);
+  Monitor::Wait(self, this, ms, ns, true, kTimedWaiting, true);
 }
 
 inline bool Object::VerifierInstanceOf(const Class* klass) const {
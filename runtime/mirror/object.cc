@@ -19,6 +19,7 @@
 #include "art_field.h"
 #include "art_field-inl.h"
 #include "array-inl.h"
+#include "array_copy.h"
 #include "class.h"
 #include "class-inl.h"
 #include "class_linker-inl.h"
@@ -37,6 +38,66 @@
 namespace art {
 namespace mirror {
 
+int32_t Object::IdentityHashCode() const {
+  Object* obj = const_cast<Object*>(this);
+  volatile int32_t* lock_word_address = obj->GetRawLockWordAddress();
+  while (true) {
+    uint32_t lock_word = *lock_word_address;
+    switch (LW_HASH_STATE(lock_word)) {
+      case LW_HASH_STATE_HASHED:
+        return reinterpret_cast<int32_t>(this);
+      case LW_HASH_STATE_HASHED_AND_MOVED: {
+        const byte* hash_code_address =
+            reinterpret_cast<const byte*>(this) + RoundUp(SizeOf(), sizeof(int32_t));
+        return *reinterpret_cast<const int32_t*>(hash_code_address);
+      }
+      default:
+        break;
+    }
+    if (!Runtime::Current()->GetHeap()->IsCompactionEnabled()) {
+      // Objects never move, so the address is a stable hash code.
+      return reinterpret_cast<int32_t>(this);
+    }
+    uint32_t hashed_lock_word = lock_word | (LW_HASH_STATE_HASHED << LW_HASH_STATE_SHIFT);
+    if (LW_SHAPE(lock_word) == LW_SHAPE_FAT) {
+      // The monitor of an inflated lock never changes, so only the hash state can race with us.
+      if (android_atomic_cas(lock_word, hashed_lock_word, lock_word_address) == 0) {
+        return reinterpret_cast<int32_t>(this);
+      }
+      continue;
+    }
+    Thread* self = Thread::Current();
+    uint32_t owner = LW_LOCK_OWNER(lock_word);
+    if (owner == self->GetThinLockId()) {
+      // The owner of a thin lock updates the lock word without a CAS, as do we.
+      *lock_word_address = hashed_lock_word;
+      return reinterpret_cast<int32_t>(this);
+    } else if (owner == 0) {
+      if (android_atomic_cas(lock_word, hashed_lock_word, lock_word_address) == 0) {
+        return reinterpret_cast<int32_t>(this);
+      }
+    } else {
+      // Another thread may update the thin lock word without a CAS while it holds the lock, so
+      // acquire the lock before updating the hash state. The object may move while we wait for
+      // the lock, so re-read it afterwards.
+      SirtRef<Object> sirt_obj(self, obj);
+      obj->MonitorEnter(self);
+      int32_t hash_code = sirt_obj->IdentityHashCode();
+      sirt_obj->MonitorExit(self);
+      return hash_code;
+    }
+  }
+}
+
+size_t Object::SizeOfWithHashCode() const {
+  size_t num_bytes = SizeOf();
+  uint32_t lock_word = monitor_;
+  if (LW_HASH_STATE(lock_word) == LW_HASH_STATE_HASHED_AND_MOVED) {
+    num_bytes = RoundUp(num_bytes, sizeof(int32_t)) + sizeof(int32_t);
+  }
+  return num_bytes;
+}
+
 Object* Object::Clone(Thread* self) {
   Class* c = GetClass();
   DCHECK(!c->IsClassClass());
@@ -50,12 +111,23 @@ Object* Object::Clone(Thread* self) {
     return NULL;
   }
 
-  // Copy instance data.  We assume memcpy copies by words.
-  // TODO: expose and use move32.
+  // Copy instance data by words so that fields and references don't tear, the size of byte and
+  // char arrays leaves a char and a byte at the end.
   byte* src_bytes = reinterpret_cast<byte*>(this);
   byte* dst_bytes = reinterpret_cast<byte*>(copy.get());
   size_t offset = sizeof(Object);
-  memcpy(dst_bytes + offset, src_bytes + offset, num_bytes - offset);
+  size_t num_words = (num_bytes - offset) / sizeof(uint32_t);
+  MoveElements32(reinterpret_cast<uint32_t*>(dst_bytes + offset),
+                 reinterpret_cast<const uint32_t*>(src_bytes + offset), num_words);
+  offset += num_words * sizeof(uint32_t);
+  if (num_bytes - offset >= sizeof(uint16_t)) {
+    *reinterpret_cast<uint16_t*>(dst_bytes + offset) =
+        *reinterpret_cast<const uint16_t*>(src_bytes + offset);
+    offset += sizeof(uint16_t);
+  }
+  if (offset != num_bytes) {
+    dst_bytes[offset] = src_bytes[offset];
+  }
 
   // Perform write barriers on copied object references.
   if (c->IsArrayClass()) {
@@ -83,13 +83,14 @@ class MANAGED Object {
 
   Object* Clone(Thread* self) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  int32_t IdentityHashCode() const {
-#ifdef MOVING_GARBAGE_COLLECTOR
-    // TODO: we'll need to use the Object's internal concept of identity
-    UNIMPLEMENTED(FATAL);
-#endif
-    return reinterpret_cast<int32_t>(this);
-  }
+  // The identity hash code is the address of the object when it is first requested. When the heap
+  // may be compacted, requesting it records the hashed state in the lock word so that a moving
+  // collection preserves the original value.
+  int32_t IdentityHashCode() const SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // The storage the object occupies: SizeOf plus, for objects moved after their identity hash
+  // code was requested, the word holding the original hash code.
+  size_t SizeOfWithHashCode() const SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   static MemberOffset MonitorOffset() {
     return OFFSET_OF_OBJECT_MEMBER(Object, monitor_);
@@ -114,6 +115,8 @@ class MANAGED Object {
 
   void NotifyAll(Thread* self) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Object.wait(), the caller must not hold object references it uses once woken since the
+  // object may move while the thread waits.
   void Wait(Thread* self) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   void Wait(Thread* self, int64_t timeout, int32_t nanos) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
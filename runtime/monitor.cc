@@ -16,11 +16,16 @@
 
 #include "monitor.h"
 
+#include <unistd.h>
+
+#include <algorithm>
 #include <vector>
 
+#include "barrier.h"
 #include "base/mutex.h"
 #include "base/stl_util.h"
 #include "class_linker.h"
+#include "closure.h"
 #include "dex_file-inl.h"
 #include "dex_instruction.h"
 #include "mirror/art_method-inl.h"
@@ -56,8 +61,15 @@ namespace art {
  * lock encodes its state.  When cleared, the lock is in the "thin"
  * state and its bits are formatted as follows:
  *
- *    [31 ---- 19] [18 ---- 3] [2 ---- 1] [0]
- *     lock count   thread id  hash state  0
+ *    [31] [30 ---- 19] [18 ---- 3] [2 ---- 1] [0]
+ *    bias  lock count   thread id  hash state  0
+ *
+ * A thin lock biased towards a thread is acquired and released by that
+ * thread with plain stores, the lock count then being the number of
+ * times the lock is held.  Any other thread acquiring it first revokes
+ * the bias, in a checkpoint of the thread it is biased towards, turning
+ * it into the equivalent unbiased thin lock.  Compiled code only handles unbiased thin locks
+ * inline and calls into the runtime for biased ones.
  *
  * When set, the lock is in the "fat" state and its bits are formatted
  * as follows:
@@ -81,10 +93,6 @@ namespace art {
  * TODO: the various members of monitor are not SMP-safe.
  */
 
-// The shape is the bottom bit; either LW_SHAPE_THIN or LW_SHAPE_FAT.
-#define LW_SHAPE_MASK 0x1
-#define LW_SHAPE(x) static_cast<int>((x) & LW_SHAPE_MASK)
-
 /*
  * Monitor accessor.  Extracts a monitor structure pointer from a fat
  * lock.  Performs no error checking.
@@ -96,12 +104,15 @@ namespace art {
  * Lock recursion count field.  Contains a count of the number of times
  * a lock has been recursively acquired.
  */
-#define LW_LOCK_COUNT_MASK 0x1fff
+#define LW_LOCK_COUNT_MASK 0xfff
 #define LW_LOCK_COUNT_SHIFT 19
 #define LW_LOCK_COUNT(x) (((x) >> LW_LOCK_COUNT_SHIFT) & LW_LOCK_COUNT_MASK)
 
 bool (*Monitor::is_sensitive_thread_hook_)() = NULL;
 uint32_t Monitor::lock_profiling_threshold_ = 0;
+bool Monitor::use_biased_locking_ = false;
+bool Monitor::spinning_enabled_ = false;
+volatile int32_t Monitor::spin_limit_ = Monitor::kMinSpinLimit;
 
 bool Monitor::IsSensitiveThread() {
   if (is_sensitive_thread_hook_ != NULL) {
@@ -110,17 +121,82 @@ bool Monitor::IsSensitiveThread() {
   return false;
 }
 
-void Monitor::Init(uint32_t lock_profiling_threshold, bool (*is_sensitive_thread_hook)()) {
+void Monitor::Init(uint32_t lock_profiling_threshold, bool use_biased_locking,
+                   bool (*is_sensitive_thread_hook)()) {
   lock_profiling_threshold_ = lock_profiling_threshold;
+  use_biased_locking_ = use_biased_locking;
   is_sensitive_thread_hook_ = is_sensitive_thread_hook;
+  spinning_enabled_ = sysconf(_SC_NPROCESSORS_CONF) > 1;
+}
+
+// Tells the processor we are in a spin loop, which saves power and lets a hyperthreaded owner run.
+static inline void SpinPause() {
+#if defined(__i386__) || defined(__x86_64__)
+  __asm__ __volatile__("pause" : : : "memory");
+#else
+  __asm__ __volatile__("" : : : "memory");
+#endif
+}
+
+void Monitor::AdaptSpinLimit(bool success) {
+  int32_t limit = spin_limit_;
+  if (success) {
+    limit = (limit < kMaxSpinLimit / 2) ? limit * 2 : kMaxSpinLimit;
+  } else {
+    limit = (limit > kMinSpinLimit * 2) ? limit / 2 : kMinSpinLimit;
+  }
+  spin_limit_ = limit;
+}
+
+bool Monitor::SpinOnThinLock(volatile int32_t* thinp, uint32_t thin) {
+  if (!spinning_enabled_ ||
+      !Runtime::Current()->GetThreadList()->IsRunnable(LW_LOCK_OWNER(thin))) {
+    // A suspended or blocked owner won't release the lock any time soon.
+    return false;
+  }
+  const int32_t limit = spin_limit_;
+  for (int32_t i = 0; i < limit; ++i) {
+    SpinPause();
+    uint32_t new_thin = *thinp;
+    // Recursive acquisitions by the owner don't count as a change.
+    if (LW_SHAPE(new_thin) != LW_SHAPE_THIN || LW_LOCK_OWNER(new_thin) != LW_LOCK_OWNER(thin)) {
+      AdaptSpinLimit(true);
+      return true;
+    }
+  }
+  AdaptSpinLimit(false);
+  return false;
+}
+
+bool Monitor::SpinOnMonitorLock(Thread* self) {
+  if (!spinning_enabled_) {
+    return false;
+  }
+  uint32_t owner_thin_lock_id = owner_thin_lock_id_;
+  if (owner_thin_lock_id != 0 &&
+      !Runtime::Current()->GetThreadList()->IsRunnable(owner_thin_lock_id)) {
+    return false;
+  }
+  const int32_t limit = spin_limit_;
+  for (int32_t i = 0; i < limit; ++i) {
+    SpinPause();
+    if (owner_ == NULL && monitor_lock_.TryLock(self)) {
+      AdaptSpinLimit(true);
+      return true;
+    }
+  }
+  AdaptSpinLimit(false);
+  return false;
 }
 
 Monitor::Monitor(Thread* owner, mirror::Object* obj)
     : monitor_lock_("a monitor lock", kMonitorLock),
       owner_(owner),
+      owner_thin_lock_id_(owner->GetThinLockId()),
       lock_count_(0),
       obj_(obj),
       wait_set_(NULL),
+      num_waiters_(0),
       locking_method_(NULL),
       locking_dex_pc_(0) {
   monitor_lock_.Lock(owner);
@@ -139,7 +215,24 @@ Monitor::Monitor(Thread* owner, mirror::Object* obj)
 
 Monitor::~Monitor() {
   DCHECK(obj_ != NULL);
-  DCHECK_EQ(LW_SHAPE(*obj_->GetRawLockWordAddress()), LW_SHAPE_FAT);
+}
+
+bool Monitor::Deflate(Thread* self, mirror::Object* obj) {
+  DCHECK(self != NULL);
+  DCHECK(obj != NULL);
+  volatile int32_t* thinp = obj->GetRawLockWordAddress();
+  uint32_t lock_word = *thinp;
+  DCHECK_EQ(LW_SHAPE(lock_word), LW_SHAPE_FAT);
+  DCHECK_EQ(LW_MONITOR(lock_word), this);
+  // With every other thread suspended nobody can start using the monitor, the threads which
+  // already use it own it, wait on it or are counted as waiters.
+  if (owner_ != NULL || wait_set_ != NULL || num_waiters_ != 0) {
+    return false;
+  }
+  // An unlocked thin lock keeps nothing but the hash state.
+  *thinp = lock_word & (LW_HASH_STATE_MASK << LW_HASH_STATE_SHIFT);
+  VLOG(monitor) << "monitor: deflated monitor " << this << " for object " << obj;
+  return true;
 }
 
 /*
@@ -194,6 +287,10 @@ mirror::Object* Monitor::GetObject() {
   return obj_;
 }
 
+void Monitor::SetObject(mirror::Object* object) {
+  obj_ = object;
+}
+
 void Monitor::Lock(Thread* self) {
   if (owner_ == self) {
     lock_count_++;
@@ -201,12 +298,18 @@ void Monitor::Lock(Thread* self) {
   }
 
   if (!monitor_lock_.TryLock(self)) {
+    // Keep the monitor from being deflated while we are suspended using it.
+    ++num_waiters_;
+    uint64_t contention_start_ns = NanoTime();
+    bool spun;
     uint64_t waitStart = 0;
     uint64_t waitEnd = 0;
     uint32_t wait_threshold = lock_profiling_threshold_;
     const mirror::ArtMethod* current_locking_method = NULL;
     uint32_t current_locking_dex_pc = 0;
     {
+      // Let the runtime know which object we are waiting to lock, a compacting GC won't move it.
+      self->monitor_enter_object_ = obj_;
       ScopedThreadStateChange tsc(self, kBlocked);
       if (wait_threshold != 0) {
         waitStart = NanoTime() / 1000;
@@ -214,11 +317,19 @@ void Monitor::Lock(Thread* self) {
       current_locking_method = locking_method_;
       current_locking_dex_pc = locking_dex_pc_;
 
-      monitor_lock_.Lock(self);
+      spun = SpinOnMonitorLock(self);
+      if (!spun) {
+        monitor_lock_.Lock(self);
+      }
       if (wait_threshold != 0) {
         waitEnd = NanoTime() / 1000;
       }
     }
+    self->monitor_enter_object_ = NULL;
+    --num_waiters_;
+    Runtime::Current()->GetMonitorList()->RecordContention(
+        spun ? MonitorList::kFatLockSpin : MonitorList::kFatLockBlock,
+        NanoTime() - contention_start_ns);
 
     if (wait_threshold != 0) {
       uint64_t wait_ms = (waitEnd - waitStart) / 1000;
@@ -238,6 +349,7 @@ void Monitor::Lock(Thread* self) {
     }
   }
   owner_ = self;
+  owner_thin_lock_id_ = self->GetThinLockId();
   DCHECK_EQ(lock_count_, 0);
 
   // When debugging, save the current monitor holder for future
@@ -342,6 +454,7 @@ bool Monitor::Unlock(Thread* self, bool for_wait) {
     // We own the monitor, so nobody else can be in here.
     if (lock_count_ == 0) {
       owner_ = NULL;
+      owner_thin_lock_id_ = 0;
       locking_method_ = NULL;
       locking_dex_pc_ = 0;
       monitor_lock_.Unlock(self);
@@ -389,7 +502,7 @@ bool Monitor::Unlock(Thread* self, bool for_wait) {
  * to return at the end of the 32-bit time epoch.
  */
 void Monitor::Wait(Thread* self, int64_t ms, int32_t ns,
-                   bool interruptShouldThrow, ThreadState why) {
+                   bool interruptShouldThrow, ThreadState why, bool at_moving_gc_safe_point) {
   DCHECK(self != NULL);
   DCHECK(why == kTimedWaiting || why == kWaiting || why == kSleeping);
 
@@ -406,11 +519,12 @@ void Monitor::Wait(Thread* self, int64_t ms, int32_t ns,
     why = kWaiting;
   }
 
-  WaitWithLock(self, ms, ns, interruptShouldThrow, why);
+  WaitWithLock(self, ms, ns, interruptShouldThrow, why, at_moving_gc_safe_point);
 }
 
 void Monitor::WaitWithLock(Thread* self, int64_t ms, int32_t ns,
-                           bool interruptShouldThrow, ThreadState why) {
+                           bool interruptShouldThrow, ThreadState why,
+                           bool at_moving_gc_safe_point) {
   // Enforce the timeout range.
   if (ms < 0 || ns < 0 || ns > 999999) {
     ThrowLocation throw_location = self->GetCurrentLocationForThrow();
@@ -430,9 +544,12 @@ void Monitor::WaitWithLock(Thread* self, int64_t ms, int32_t ns,
    * not order sensitive as we hold the pthread mutex.
    */
   AppendToWaitSet(self);
+  // Once notified we are no longer in the wait set but still have to re-acquire the monitor.
+  ++num_waiters_;
   int prev_lock_count = lock_count_;
   lock_count_ = 0;
   owner_ = NULL;
+  owner_thin_lock_id_ = 0;
   const mirror::ArtMethod* saved_method = locking_method_;
   locking_method_ = NULL;
   uintptr_t saved_dex_pc = locking_dex_pc_;
@@ -441,8 +558,10 @@ void Monitor::WaitWithLock(Thread* self, int64_t ms, int32_t ns,
   /*
    * Update thread state. If the GC wakes up, it'll ignore us, knowing
    * that we won't touch any references in this state, and we'll check
-   * our suspend mode before we transition out.
+   * our suspend mode before we transition out. Once woken only the monitor is touched until the
+   * thread is runnable again, the monitor's object is updated if it moves.
    */
+  self->SetAtMovingGcSafePoint(at_moving_gc_safe_point);
   self->TransitionFromRunnableToSuspended(why);
 
   bool was_interrupted = false;
@@ -492,6 +611,7 @@ void Monitor::WaitWithLock(Thread* self, int64_t ms, int32_t ns,
 
   // Re-acquire the monitor lock.
   Lock(self);
+  --num_waiters_;
 
   self->wait_mutex_->AssertNotHeld(self);
 
@@ -502,6 +622,7 @@ void Monitor::WaitWithLock(Thread* self, int64_t ms, int32_t ns,
    * updates is not order sensitive as we hold the pthread mutex.
    */
   owner_ = self;
+  owner_thin_lock_id_ = self->GetThinLockId();
   lock_count_ = prev_lock_count;
   locking_method_ = saved_method;
   locking_dex_pc_ = saved_dex_pc;
@@ -582,6 +703,7 @@ void Monitor::Inflate(Thread* self, mirror::Object* obj) {
   DCHECK(self != NULL);
   DCHECK(obj != NULL);
   DCHECK_EQ(LW_SHAPE(*obj->GetRawLockWordAddress()), LW_SHAPE_THIN);
+  DCHECK_EQ(LW_BIASED(*obj->GetRawLockWordAddress()), 0);
   DCHECK_EQ(LW_LOCK_OWNER(*obj->GetRawLockWordAddress()), static_cast<int32_t>(self->GetThinLockId()));
 
   // Allocate and acquire a new monitor.
@@ -591,6 +713,82 @@ void Monitor::Inflate(Thread* self, mirror::Object* obj) {
   Runtime::Current()->GetMonitorList()->Add(m);
 }
 
+uint32_t Monitor::UnbiasedLockWord(uint32_t lock_word) {
+  DCHECK_EQ(LW_SHAPE(lock_word), LW_SHAPE_THIN);
+  DCHECK_NE(LW_BIASED(lock_word), 0u);
+  uint32_t hash_state = lock_word & (LW_HASH_STATE_MASK << LW_HASH_STATE_SHIFT);
+  uint32_t count = LW_LOCK_COUNT(lock_word);
+  if (count == 0) {
+    // Not held by the thread it is biased towards.
+    return hash_state;
+  }
+  // A thin lock held once has a count of zero.
+  return (LW_LOCK_OWNER(lock_word) << LW_LOCK_OWNER_SHIFT) |
+      ((count - 1) << LW_LOCK_COUNT_SHIFT) | hash_state;
+}
+
+uint32_t Monitor::UnbiasOwnLock(Thread* self, volatile int32_t* thinp) {
+  uint32_t thin = *thinp;
+  if (LW_SHAPE(thin) == LW_SHAPE_THIN && LW_BIASED(thin) != 0 &&
+      LW_LOCK_OWNER(thin) == self->GetThinLockId()) {
+    // Nobody else changes the lock word while we are runnable.
+    thin = UnbiasedLockWord(thin);
+    *thinp = thin;
+  }
+  return thin;
+}
+
+// Revokes the bias of a lock on behalf of the thread it is biased towards, which either runs it
+// itself or is suspended while the revoking thread does.
+class RevokeBiasCheckpoint : public Closure {
+ public:
+  explicit RevokeBiasCheckpoint(mirror::Object* obj) : obj_(obj), barrier_(0) {}
+
+  virtual void Run(Thread* thread) NO_THREAD_SAFETY_ANALYSIS {
+    volatile int32_t* thinp = obj_->GetRawLockWordAddress();
+    uint32_t thin = *thinp;
+    // Another thread may have revoked the bias before us.
+    if (LW_SHAPE(thin) == LW_SHAPE_THIN && LW_BIASED(thin) != 0 &&
+        LW_LOCK_OWNER(thin) == thread->GetThinLockId()) {
+      VLOG(monitor) << StringPrintf("monitor: revoking bias of lock %p towards %d", thinp,
+                                    LW_LOCK_OWNER(thin));
+      // Only the thread the lock is biased towards changes it with plain stores, other threads
+      // acquiring it wait for the bias to be revoked.
+      android_atomic_release_store(Monitor::UnbiasedLockWord(thin), thinp);
+      Runtime::Current()->GetMonitorList()->RecordBiasRevocation(obj_->GetClass());
+    }
+    barrier_.Pass(Thread::Current());
+  }
+
+  void WaitForRevocation(Thread* self) {
+    barrier_.Increment(self, 1);
+  }
+
+ private:
+  mirror::Object* const obj_;
+  Barrier barrier_;
+};
+
+void Monitor::RevokeBias(Thread* self, mirror::Object* obj) {
+  // Let the runtime know which object we are waiting to lock, a compacting GC won't move it.
+  self->monitor_enter_object_ = obj;
+  self->TransitionFromRunnableToSuspended(kBlocked);
+  volatile int32_t* thinp = obj->GetRawLockWordAddress();
+  uint32_t thin = *thinp;
+  if (LW_SHAPE(thin) == LW_SHAPE_THIN && LW_BIASED(thin) != 0) {
+    RevokeBiasCheckpoint checkpoint(obj);
+    if (Runtime::Current()->GetThreadList()->RunCheckpointOnThread(LW_LOCK_OWNER(thin),
+                                                                   &checkpoint)) {
+      checkpoint.WaitForRevocation(self);
+    } else if (android_atomic_cas(thin, UnbiasedLockWord(thin), thinp) == 0) {
+      // The thread the lock was biased towards is gone, nobody stores to the lock word.
+      Runtime::Current()->GetMonitorList()->RecordBiasRevocation(obj->GetClass());
+    }
+  }
+  self->monitor_enter_object_ = NULL;
+  self->TransitionFromSuspendedToRunnable();
+}
+
 void Monitor::MonitorEnter(Thread* self, mirror::Object* obj) {
   volatile int32_t* thinp = obj->GetRawLockWordAddress();
   uint32_t sleepDelayNs;
@@ -603,6 +801,19 @@ void Monitor::MonitorEnter(Thread* self, mirror::Object* obj) {
   uint32_t threadId = self->GetThinLockId();
  retry:
   thin = *thinp;
+  if (LW_SHAPE(thin) == LW_SHAPE_THIN && LW_BIASED(thin) != 0) {
+    if (LW_LOCK_OWNER(thin) != threadId) {
+      RevokeBias(self, obj);
+    } else if (LW_LOCK_COUNT(thin) != LW_LOCK_COUNT_MASK) {
+      // The lock is biased towards us, nobody else changes the lock word while we are runnable.
+      *thinp = thin + (1 << LW_LOCK_COUNT_SHIFT);
+      return;
+    } else {
+      // Too many reacquisitions for the bias, the unbiased lock gets inflated below.
+      UnbiasOwnLock(self, thinp);
+    }
+    goto retry;
+  }
   if (LW_SHAPE(thin) == LW_SHAPE_THIN) {
     /*
      * The lock is a thin lock.  The owner field is used to
@@ -627,6 +838,11 @@ void Monitor::MonitorEnter(Thread* self, mirror::Object* obj) {
       // This is the common case: compiled code will have tried this before calling back into
       // the runtime.
       newThin = thin | (threadId << LW_LOCK_OWNER_SHIFT);
+      if (use_biased_locking_ &&
+          Runtime::Current()->GetMonitorList()->IsBiasable(obj->GetClass())) {
+        // Bias the lock towards us, held once, so that we won't need a CAS to acquire it again.
+        newThin |= (LW_BIASED_MASK << LW_BIASED_SHIFT) | (1 << LW_LOCK_COUNT_SHIFT);
+      }
       if (android_atomic_acquire_cas(thin, newThin, thinp) != 0) {
         // The acquire failed. Try again.
         goto retry;
@@ -637,13 +853,20 @@ void Monitor::MonitorEnter(Thread* self, mirror::Object* obj) {
       // The lock is owned by another thread. Notify the runtime that we are about to wait.
       self->monitor_enter_object_ = obj;
       self->TransitionFromRunnableToSuspended(kBlocked);
+      uint64_t contention_start_ns = NanoTime();
       // Spin until the thin lock is released or inflated.
       sleepDelayNs = 0;
       for (;;) {
         thin = *thinp;
         // Check the shape of the lock word. Another thread
         // may have inflated the lock while we were waiting.
-        if (LW_SHAPE(thin) == LW_SHAPE_THIN) {
+        if (LW_SHAPE(thin) == LW_SHAPE_THIN && LW_BIASED(thin) != 0) {
+          // The lock was released and biased by another thread, which won't change it again
+          // before its bias is revoked.
+          self->monitor_enter_object_ = NULL;
+          self->TransitionFromSuspendedToRunnable();
+          goto retry;
+        } else if (LW_SHAPE(thin) == LW_SHAPE_THIN) {
           if (LW_LOCK_OWNER(thin) == 0) {
             // The lock has been released. Install the thread id of the
             // calling thread into the owner field.
@@ -652,6 +875,8 @@ void Monitor::MonitorEnter(Thread* self, mirror::Object* obj) {
               // The acquire succeed. Break out of the loop and proceed to inflate the lock.
               break;
             }
+          } else if (sleepDelayNs == 0 && SpinOnThinLock(thinp, thin)) {
+            // The owner is running and released or inflated the lock, look at it again.
           } else {
             // The lock has not been released. Yield so the owning thread can run.
             if (sleepDelayNs == 0) {
@@ -677,6 +902,9 @@ void Monitor::MonitorEnter(Thread* self, mirror::Object* obj) {
         }
       }
       VLOG(monitor) << StringPrintf("monitor: thread %d spin on lock %p done", threadId, thinp);
+      Runtime::Current()->GetMonitorList()->RecordContention(
+          sleepDelayNs == 0 ? MonitorList::kThinLockSpin : MonitorList::kThinLockSleep,
+          NanoTime() - contention_start_ns);
       // We have acquired the thin lock. Let the runtime know that we are no longer waiting.
       self->monitor_enter_object_ = NULL;
       self->TransitionFromSuspendedToRunnable();
@@ -706,7 +934,14 @@ bool Monitor::MonitorExit(Thread* self, mirror::Object* obj) {
    * examining its state.
    */
   uint32_t thin = *thinp;
-  if (LW_SHAPE(thin) == LW_SHAPE_THIN) {
+  if (LW_SHAPE(thin) == LW_SHAPE_THIN && LW_BIASED(thin) != 0) {
+    if (LW_LOCK_OWNER(thin) != self->GetThinLockId() || LW_LOCK_COUNT(thin) == 0) {
+      FailedUnlock(obj, self, NULL, NULL);
+      return false;
+    }
+    // The lock is biased towards us, nobody else changes the lock word while we are runnable.
+    *thinp = thin - (1 << LW_LOCK_COUNT_SHIFT);
+  } else if (LW_SHAPE(thin) == LW_SHAPE_THIN) {
     /*
      * The lock is thin.  We must ensure that the lock is owned
      * by the given thread before unlocking it.
@@ -757,11 +992,11 @@ bool Monitor::MonitorExit(Thread* self, mirror::Object* obj) {
  * Object.wait().  Also called for class init.
  */
 void Monitor::Wait(Thread* self, mirror::Object *obj, int64_t ms, int32_t ns,
-                   bool interruptShouldThrow, ThreadState why) {
+                   bool interruptShouldThrow, ThreadState why, bool at_moving_gc_safe_point) {
   volatile int32_t* thinp = obj->GetRawLockWordAddress();
 
   // If the lock is still thin, we need to fatten it.
-  uint32_t thin = *thinp;
+  uint32_t thin = UnbiasOwnLock(self, thinp);
   if (LW_SHAPE(thin) == LW_SHAPE_THIN) {
     // Make sure that 'self' holds the lock.
     if (LW_LOCK_OWNER(thin) != self->GetThinLockId()) {
@@ -777,11 +1012,11 @@ void Monitor::Wait(Thread* self, mirror::Object *obj, int64_t ms, int32_t ns,
     Inflate(self, obj);
     VLOG(monitor) << StringPrintf("monitor: thread %d fattened lock %p by wait()", self->GetThinLockId(), thinp);
   }
-  LW_MONITOR(*thinp)->Wait(self, ms, ns, interruptShouldThrow, why);
+  LW_MONITOR(*thinp)->Wait(self, ms, ns, interruptShouldThrow, why, at_moving_gc_safe_point);
 }
 
 void Monitor::Notify(Thread* self, mirror::Object *obj) {
-  uint32_t thin = *obj->GetRawLockWordAddress();
+  uint32_t thin = UnbiasOwnLock(self, obj->GetRawLockWordAddress());
 
   // If the lock is still thin, there aren't any waiters;
   // waiting on an object forces lock fattening.
@@ -802,7 +1037,7 @@ void Monitor::Notify(Thread* self, mirror::Object *obj) {
 }
 
 void Monitor::NotifyAll(Thread* self, mirror::Object *obj) {
-  uint32_t thin = *obj->GetRawLockWordAddress();
+  uint32_t thin = UnbiasOwnLock(self, obj->GetRawLockWordAddress());
 
   // If the lock is still thin, there aren't any waiters;
   // waiting on an object forces lock fattening.
@@ -824,6 +1059,10 @@ void Monitor::NotifyAll(Thread* self, mirror::Object *obj) {
 
 uint32_t Monitor::GetThinLockId(uint32_t raw_lock_word) {
   if (LW_SHAPE(raw_lock_word) == LW_SHAPE_THIN) {
+    if (LW_BIASED(raw_lock_word) != 0 && LW_LOCK_COUNT(raw_lock_word) == 0) {
+      // Biased towards a thread which doesn't hold it.
+      return 0;
+    }
     return LW_LOCK_OWNER(raw_lock_word);
   } else {
     Thread* owner = LW_MONITOR(raw_lock_word)->owner_;
@@ -991,7 +1230,9 @@ void Monitor::TranslateLocation(const mirror::ArtMethod* method, uint32_t dex_pc
 
 MonitorList::MonitorList()
     : allow_new_monitors_(true), monitor_list_lock_("MonitorList lock"),
-      monitor_add_condition_("MonitorList disallow condition", monitor_list_lock_) {
+      monitor_add_condition_("MonitorList disallow condition", monitor_list_lock_),
+      num_deflated_(0), bias_revocations_lock_("MonitorList bias revocations lock"),
+      num_bias_revocations_(0) {
 }
 
 MonitorList::~MonitorList() {
@@ -1020,27 +1261,119 @@ void MonitorList::Add(Monitor* m) {
   list_.push_front(m);
 }
 
-void MonitorList::SweepMonitorList(IsMarkedTester is_marked, void* arg) {
+void MonitorList::SweepMonitorList(RootVisitor* visitor, void* arg) {
   MutexLock mu(Thread::Current(), monitor_list_lock_);
   for (auto it = list_.begin(); it != list_.end(); ) {
     Monitor* m = *it;
-    if (!is_marked(m->GetObject(), arg)) {
+    mirror::Object* obj = visitor(m->GetObject(), arg);
+    if (obj == NULL) {
       VLOG(monitor) << "freeing monitor " << m << " belonging to unmarked object " << m->GetObject();
+      DCHECK_EQ(LW_SHAPE(*m->GetObject()->GetRawLockWordAddress()), LW_SHAPE_FAT);
       delete m;
       it = list_.erase(it);
     } else {
+      m->SetObject(obj);
       ++it;
     }
   }
 }
 
+void MonitorList::DeflateMonitors() {
+  Thread* self = Thread::Current();
+  Locks::mutator_lock_->AssertExclusiveHeld(self);
+  MutexLock mu(self, monitor_list_lock_);
+  for (auto it = list_.begin(); it != list_.end(); ) {
+    Monitor* m = *it;
+    if (m->Deflate(self, m->GetObject())) {
+      ++num_deflated_;
+      delete m;
+      it = list_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void MonitorList::RecordContention(ContentionKind kind, uint64_t wait_ns) {
+  uint64_t wait_us = wait_ns / 1000;
+  size_t bucket = (wait_us == 0) ? 0 : 64 - __builtin_clzll(wait_us);
+  ++contentions_[kind][std::min(bucket, kContentionBuckets - 1)];
+}
+
+bool MonitorList::IsBiasable(const mirror::Class* klass) {
+  if (LIKELY(num_unbiasable_classes_.load() == 0)) {
+    return true;
+  }
+  ReaderMutexLock mu(Thread::Current(), bias_revocations_lock_);
+  auto it = bias_revocations_.find(klass);
+  return it == bias_revocations_.end() || it->second < kMaxBiasRevocations;
+}
+
+void MonitorList::RecordBiasRevocation(const mirror::Class* klass) {
+  WriterMutexLock mu(Thread::Current(), bias_revocations_lock_);
+  ++num_bias_revocations_;
+  auto it = bias_revocations_.find(klass);
+  if (it == bias_revocations_.end()) {
+    bias_revocations_.Put(klass, 1);
+  } else if (++it->second == kMaxBiasRevocations) {
+    VLOG(monitor) << "monitor: no longer biasing the locks of " << PrettyClass(klass);
+    ++num_unbiasable_classes_;
+  }
+}
+
+void MonitorList::DumpForSigQuit(std::ostream& os) {
+  Thread* self = Thread::Current();
+  {
+    MutexLock mu(self, monitor_list_lock_);
+    os << "Monitors: " << list_.size() << " (" << num_deflated_ << " deflated)\n";
+  }
+  {
+    ReaderMutexLock mu(self, bias_revocations_lock_);
+    os << "Biased lock revocations: " << num_bias_revocations_ << " ("
+       << num_unbiasable_classes_.load() << " classes no longer biased)\n";
+  }
+  static const char* kContentionNames[kContentionKindCount] = {
+    "thin lock spin",
+    "thin lock sleep",
+    "fat lock spin",
+    "fat lock block",
+  };
+  for (size_t kind = 0; kind < kContentionKindCount; ++kind) {
+    // The buckets keep changing while we read them, the dump is only a snapshot.
+    int32_t counts[kContentionBuckets];
+    int32_t total = 0;
+    for (size_t bucket = 0; bucket < kContentionBuckets; ++bucket) {
+      counts[bucket] = contentions_[kind][bucket].load();
+      total += counts[bucket];
+    }
+    if (total == 0) {
+      continue;
+    }
+    os << "Contended monitor enters, " << kContentionNames[kind] << ": " << total
+       << ", wait times:";
+    for (size_t bucket = 0; bucket < kContentionBuckets; ++bucket) {
+      if (counts[bucket] == 0) {
+        continue;
+      }
+      if (bucket == kContentionBuckets - 1) {
+        os << " >=" << PrettyDuration(UINT64_C(1000) << (bucket - 1));
+      } else {
+        os << " <" << PrettyDuration(UINT64_C(1000) << bucket);
+      }
+      os << ":" << counts[bucket];
+    }
+    os << "\n";
+  }
+}
+
 MonitorInfo::MonitorInfo(mirror::Object* o) : owner(NULL), entry_count(0) {
   uint32_t lock_word = *o->GetRawLockWordAddress();
   if (LW_SHAPE(lock_word) == LW_SHAPE_THIN) {
-    uint32_t owner_thin_lock_id = LW_LOCK_OWNER(lock_word);
+    uint32_t owner_thin_lock_id = Monitor::GetThinLockId(lock_word);
     if (owner_thin_lock_id != 0) {
       owner = Runtime::Current()->GetThreadList()->FindThreadByThinLockId(owner_thin_lock_id);
-      entry_count = 1 + LW_LOCK_COUNT(lock_word);
+      // The count of a biased lock is the number of times it is held.
+      entry_count = LW_LOCK_COUNT(lock_word) + (LW_BIASED(lock_word) != 0 ? 0 : 1);
     }
     // Thin locks have no waiters.
   } else {
@@ -24,8 +24,10 @@
 #include <list>
 #include <vector>
 
+#include "atomic_integer.h"
 #include "base/mutex.h"
 #include "root_visitor.h"
+#include "safe_map.h"
 #include "thread_state.h"
 
 namespace art {
@@ -35,6 +37,8 @@ namespace art {
  */
 #define LW_SHAPE_THIN 0
 #define LW_SHAPE_FAT 1
+#define LW_SHAPE_MASK 0x1
+#define LW_SHAPE(x) static_cast<int>((x) & LW_SHAPE_MASK)
 
 /*
  * Hash state field.  Used to signify that an object has had its
@@ -55,8 +59,19 @@ namespace art {
 #define LW_LOCK_OWNER_SHIFT 3
 #define LW_LOCK_OWNER(x) (((x) >> LW_LOCK_OWNER_SHIFT) & LW_LOCK_OWNER_MASK)
 
+/*
+ * Bias field.  When set, the thin lock is biased towards the thread in
+ * the owner field, which acquires and releases it with plain stores.
+ * The lock count field then holds the number of times the lock is held,
+ * zero when the owner doesn't hold it.
+ */
+#define LW_BIASED_MASK 0x1
+#define LW_BIASED_SHIFT 31
+#define LW_BIASED(x) (((x) >> LW_BIASED_SHIFT) & LW_BIASED_MASK)
+
 namespace mirror {
   class ArtMethod;
+  class Class;
   class Object;
 }  // namespace mirror
 class Thread;
@@ -67,7 +82,8 @@ class Monitor {
   ~Monitor();
 
   static bool IsSensitiveThread();
-  static void Init(uint32_t lock_profiling_threshold, bool (*is_sensitive_thread_hook)());
+  static void Init(uint32_t lock_profiling_threshold, bool use_biased_locking,
+                   bool (*is_sensitive_thread_hook)());
 
   static uint32_t GetThinLockId(uint32_t raw_lock_word)
       NO_THREAD_SAFETY_ANALYSIS;  // Reading lock owner without holding lock is racy.
@@ -83,8 +99,10 @@ class Monitor {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   static void NotifyAll(Thread* self, mirror::Object* obj)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Callers that hold no object references other than obj, which they don't use once woken, pass
+  // at_moving_gc_safe_point so that a moving collector may run while they wait.
   static void Wait(Thread* self, mirror::Object* obj, int64_t ms, int32_t ns,
-                   bool interruptShouldThrow, ThreadState why)
+                   bool interruptShouldThrow, ThreadState why, bool at_moving_gc_safe_point)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   static void DescribeWait(std::ostream& os, const Thread* thread)
@@ -104,6 +122,9 @@ class Monitor {
 
   mirror::Object* GetObject();
 
+  // Called when the object owning this monitor has been moved by a compacting collection.
+  void SetObject(mirror::Object* object);
+
  private:
   explicit Monitor(Thread* owner, mirror::Object* obj)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -114,6 +135,34 @@ class Monitor {
   static void Inflate(Thread* self, mirror::Object* obj)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Returns the thin lock word equivalent to a biased one, owned by the same thread if it holds
+  // the lock.
+  static uint32_t UnbiasedLockWord(uint32_t lock_word);
+
+  // Removes the bias of a lock biased towards self, which needs no other thread to be suspended.
+  // Returns the lock word.
+  static uint32_t UnbiasOwnLock(Thread* self, volatile int32_t* thinp);
+
+  // Removes the bias of a lock biased towards another thread. That thread does so at its next
+  // suspend point, or we do it while keeping it suspended, the other threads keep running.
+  static void RevokeBias(Thread* self, mirror::Object* obj)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Turns the lock of obj back into an unlocked thin lock if nobody owns, waits on or is about to
+  // acquire the monitor. Returns true if so, the monitor may then be deleted.
+  bool Deflate(Thread* self, mirror::Object* obj) EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Spins while the thin lock word is unchanged and its owner is running, returns true if it
+  // changed.
+  static bool SpinOnThinLock(volatile int32_t* thinp, uint32_t thin);
+
+  // Spins trying to acquire the monitor lock while its owner is running, returns true if acquired.
+  bool SpinOnMonitorLock(Thread* self) EXCLUSIVE_TRYLOCK_FUNCTION(true, monitor_lock_);
+
+  // Grows the number of spin iterations after a spin which succeeded, shrinks it after one which
+  // didn't.
+  static void AdaptSpinLimit(bool success);
+
   void LogContentionEvent(Thread* self, uint32_t wait_ms, uint32_t sample_percent,
                           const char* owner_filename, uint32_t owner_line_number)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -136,9 +185,11 @@ class Monitor {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
 
-  void Wait(Thread* self, int64_t msec, int32_t nsec, bool interruptShouldThrow, ThreadState why)
+  void Wait(Thread* self, int64_t msec, int32_t nsec, bool interruptShouldThrow, ThreadState why,
+            bool at_moving_gc_safe_point)
       NO_THREAD_SAFETY_ANALYSIS;
-  void WaitWithLock(Thread* self, int64_t ms, int32_t ns, bool interruptShouldThrow, ThreadState why)
+  void WaitWithLock(Thread* self, int64_t ms, int32_t ns, bool interruptShouldThrow, ThreadState why,
+                    bool at_moving_gc_safe_point)
       EXCLUSIVE_LOCKS_REQUIRED(monitor_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -149,21 +200,38 @@ class Monitor {
 
   static bool (*is_sensitive_thread_hook_)();
   static uint32_t lock_profiling_threshold_;
+  static bool use_biased_locking_;
+
+  // Bounds of the number of iterations a contended lock is spun on before yielding or blocking.
+  static const int32_t kMinSpinLimit = 16;
+  static const int32_t kMaxSpinLimit = 16 * KB;
+
+  // Spinning only helps when the owner runs at the same time, so it is off on uniprocessors.
+  static bool spinning_enabled_;
+  // Adapted to how long locks are held, racy updates are fine.
+  static volatile int32_t spin_limit_;
 
   Mutex monitor_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
 
   // Which thread currently owns the lock?
   Thread* volatile owner_;
+  // The thin lock id of owner_, 0 when unowned. Threads spinning on the monitor look the owner up
+  // by id, owner_ may be freed once it released the monitor.
+  volatile uint32_t owner_thin_lock_id_;
 
   // Owner's recursive lock depth.
   int lock_count_ GUARDED_BY(monitor_lock_);
 
   // What object are we part of (for debugging).
-  mirror::Object* const obj_;
+  mirror::Object* obj_;
 
   // Threads currently waiting on this monitor.
   Thread* wait_set_ GUARDED_BY(monitor_lock_);
 
+  // Threads using the monitor while suspended, blocked on the monitor lock or waiting on the
+  // monitor. The monitor can't be deflated while there are any.
+  AtomicInteger num_waiters_;
+
   // Method and dex pc where the lock owner acquired the lock, used when lock
   // sampling is enabled. locking_method_ may be null if the lock is currently
   // unlocked, or if the lock is acquired by the system when the stack is empty.
@@ -172,27 +240,72 @@ class Monitor {
 
   friend class MonitorInfo;
   friend class MonitorList;
+  friend class MonitorTest;
+  friend class RevokeBiasCheckpoint;
   friend class mirror::Object;
   DISALLOW_COPY_AND_ASSIGN(Monitor);
 };
 
 class MonitorList {
  public:
+  // How a contended lock was eventually acquired.
+  enum ContentionKind {
+    kThinLockSpin,   // A thin lock, while spinning.
+    kThinLockSleep,  // A thin lock, after yielding or sleeping. The lock is then inflated.
+    kFatLockSpin,    // A monitor, while spinning.
+    kFatLockBlock,   // A monitor, after blocking on its lock.
+    kContentionKindCount
+  };
+
   MonitorList();
   ~MonitorList();
 
   void Add(Monitor* m);
-  void SweepMonitorList(IsMarkedTester is_marked, void* arg)
+  void SweepMonitorList(RootVisitor* visitor, void* arg)
       SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
+  // Turns the monitors nobody uses back into thin locks and frees them. The mutators must be
+  // suspended so that nobody can start using a monitor.
+  void DeflateMonitors() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
   void DisallowNewMonitors();
   void AllowNewMonitors();
+
+  // Records the time a thread spent acquiring a contended lock. Lock free, as it is called on every
+  // contended enter.
+  void RecordContention(ContentionKind kind, uint64_t wait_ns);
+
+  // Returns false once the locks of objects of klass had their bias revoked too often.
+  bool IsBiasable(const mirror::Class* klass) LOCKS_EXCLUDED(bias_revocations_lock_);
+  void RecordBiasRevocation(const mirror::Class* klass) LOCKS_EXCLUDED(bias_revocations_lock_);
+
+  void DumpForSigQuit(std::ostream& os)
+      LOCKS_EXCLUDED(monitor_list_lock_, bias_revocations_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
  private:
+  // Revocations after which the objects of a class are no longer biased.
+  static const size_t kMaxBiasRevocations = 32;
+
   bool allow_new_monitors_ GUARDED_BY(monitor_list_lock_);
   Mutex monitor_list_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   ConditionVariable monitor_add_condition_ GUARDED_BY(monitor_list_lock_);
   std::list<Monitor*> list_ GUARDED_BY(monitor_list_lock_);
+  // Number of monitors deflated so far.
+  size_t num_deflated_ GUARDED_BY(monitor_list_lock_);
+
+  // Numbers of contended enters by wait time, bucket i counting the waits shorter than 2^i
+  // microseconds which are not in the previous buckets, the last bucket all the longer waits.
+  static const size_t kContentionBuckets = 20;
+  AtomicInteger contentions_[kContentionKindCount][kContentionBuckets];
+
+  // Bias revocations per class. Revocations happen while other threads lock objects, so the lock
+  // paths only look at it once some class is no longer biased.
+  ReaderWriterMutex bias_revocations_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  SafeMap<const mirror::Class*, size_t> bias_revocations_ GUARDED_BY(bias_revocations_lock_);
+  size_t num_bias_revocations_ GUARDED_BY(bias_revocations_lock_);
+  AtomicInteger num_unbiasable_classes_;
 
   friend class Monitor;
+  friend class MonitorTest;
   DISALLOW_COPY_AND_ASSIGN(MonitorList);
 };
 
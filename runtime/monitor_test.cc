@@ -0,0 +1,345 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "monitor.h"
+
+#include "atomic_integer.h"
+#include "common_test.h"
+#include "entrypoints/entrypoint_utils.h"
+#include "gc/heap.h"
+#include "mirror/object-inl.h"
+#include "mirror/string.h"
+#include "scoped_thread_state_change.h"
+#include "sirt_ref.h"
+#include "thread_list.h"
+#include "thread_pool.h"
+#include "UniquePtr.h"
+
+namespace art {
+
+class MonitorTest : public CommonTest {
+ protected:
+  static void Inflate(Thread* self, mirror::Object* obj)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    Monitor::Inflate(self, obj);
+  }
+
+  static bool IsFat(mirror::Object* obj) {
+    return LW_SHAPE(*obj->GetRawLockWordAddress()) == LW_SHAPE_FAT;
+  }
+
+  static size_t NumMonitors() {
+    MonitorList* monitor_list = Runtime::Current()->GetMonitorList();
+    MutexLock mu(Thread::Current(), monitor_list->monitor_list_lock_);
+    return monitor_list->list_.size();
+  }
+
+  static size_t NumDeflated() {
+    MonitorList* monitor_list = Runtime::Current()->GetMonitorList();
+    MutexLock mu(Thread::Current(), monitor_list->monitor_list_lock_);
+    return monitor_list->num_deflated_;
+  }
+
+  static void CollectGarbage(Thread* self) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    ScopedThreadStateChange tsc(self, kNative);
+    Runtime::Current()->GetHeap()->CollectGarbage(false);
+  }
+
+  // Biased locking is off unless -XX:BiasedLocking is given.
+  static void EnableBiasedLocking() {
+    Monitor::use_biased_locking_ = true;
+  }
+
+  // Returns whether the lock of obj is biased towards the thread.
+  static bool IsBiasedTowards(mirror::Object* obj, Thread* thread) {
+    uint32_t lock_word = *obj->GetRawLockWordAddress();
+    return LW_SHAPE(lock_word) == LW_SHAPE_THIN && LW_BIASED(lock_word) != 0 &&
+        LW_LOCK_OWNER(lock_word) == thread->GetThinLockId();
+  }
+
+  // Returns whether the lock of obj is an unbiased thin lock owned by the thread.
+  static bool IsThinLockedBy(mirror::Object* obj, Thread* thread) {
+    uint32_t lock_word = *obj->GetRawLockWordAddress();
+    return LW_SHAPE(lock_word) == LW_SHAPE_THIN && LW_BIASED(lock_word) == 0 &&
+        LW_LOCK_OWNER(lock_word) == thread->GetThinLockId();
+  }
+
+  static bool IsBiasable(mirror::Class* klass) {
+    return Runtime::Current()->GetMonitorList()->IsBiasable(klass);
+  }
+
+  static void RecordBiasRevocation(mirror::Class* klass) {
+    Runtime::Current()->GetMonitorList()->RecordBiasRevocation(klass);
+  }
+
+  static size_t NumBiasRevocations() {
+    MonitorList* monitor_list = Runtime::Current()->GetMonitorList();
+    ReaderMutexLock mu(Thread::Current(), monitor_list->bias_revocations_lock_);
+    return monitor_list->num_bias_revocations_;
+  }
+
+  static size_t MaxBiasRevocations() {
+    return MonitorList::kMaxBiasRevocations;
+  }
+};
+
+// Locks and unlocks an object from a thread pool worker, recording whether the worker then owned
+// the lock.
+class LockTask : public Task {
+ public:
+  LockTask(mirror::Object* obj, AtomicInteger* done) : obj_(obj), done_(done), owned_(false) {}
+
+  void Run(Thread* self) {
+    ScopedObjectAccess soa(self);
+    obj_->MonitorEnter(self);
+    owned_ = Monitor::GetThinLockId(*obj_->GetRawLockWordAddress()) == self->GetThinLockId() ||
+        LW_SHAPE(*obj_->GetRawLockWordAddress()) == LW_SHAPE_FAT;
+    obj_->MonitorExit(self);
+    ++*done_;
+  }
+
+  void Finalize() {}
+
+  bool Owned() const {
+    return owned_;
+  }
+
+ private:
+  mirror::Object* const obj_;
+  AtomicInteger* const done_;
+  bool owned_;
+};
+
+TEST_F(MonitorTest, DeflateIdleMonitorsDuringGc) {
+  ScopedObjectAccess soa(Thread::Current());
+  Thread* self = soa.Self();
+  SirtRef<mirror::String> idle(self, mirror::String::AllocFromModifiedUtf8(self, "idle"));
+  SirtRef<mirror::String> held(self, mirror::String::AllocFromModifiedUtf8(self, "held"));
+  ASSERT_TRUE(idle.get() != NULL);
+  ASSERT_TRUE(held.get() != NULL);
+  // The hash state lives in the lock word, it has to survive inflation and deflation.
+  const int32_t idle_hash = idle->IdentityHashCode();
+
+  idle->MonitorEnter(self);
+  Inflate(self, idle.get());
+  ASSERT_TRUE(IsFat(idle.get()));
+  idle->MonitorExit(self);
+  held->MonitorEnter(self);
+  Inflate(self, held.get());
+  ASSERT_TRUE(IsFat(held.get()));
+
+  const size_t num_monitors = NumMonitors();
+  const size_t num_deflated = NumDeflated();
+  CollectGarbage(self);
+  // Only the monitor nobody uses is turned back into a thin lock.
+  EXPECT_FALSE(IsFat(idle.get()));
+  EXPECT_TRUE(IsFat(held.get()));
+  EXPECT_EQ(idle_hash, idle->IdentityHashCode());
+  EXPECT_LE(num_deflated + 1, NumDeflated());
+  EXPECT_GE(num_monitors - 1, NumMonitors());
+
+  // The deflated lock works as a thin lock and inflates again.
+  idle->MonitorEnter(self);
+  EXPECT_FALSE(IsFat(idle.get()));
+  idle->MonitorEnter(self);
+  idle->MonitorExit(self);
+  Monitor::Wait(self, idle.get(), 1, 0, false, kTimedWaiting, false);
+  EXPECT_TRUE(IsFat(idle.get()));
+  EXPECT_FALSE(self->IsExceptionPending());
+  idle->MonitorExit(self);
+  EXPECT_EQ(idle_hash, idle->IdentityHashCode());
+
+  // The held monitor goes once released.
+  held->MonitorExit(self);
+  CollectGarbage(self);
+  EXPECT_FALSE(IsFat(idle.get()));
+  EXPECT_FALSE(IsFat(held.get()));
+  EXPECT_EQ(idle_hash, idle->IdentityHashCode());
+}
+
+TEST_F(MonitorTest, LockOwnerRunnable) {
+  ScopedObjectAccess soa(Thread::Current());
+  ThreadList* thread_list = Runtime::Current()->GetThreadList();
+  EXPECT_TRUE(thread_list->IsRunnable(soa.Self()->GetThinLockId()));
+  EXPECT_FALSE(thread_list->IsRunnable(ThreadList::kInvalidId));
+  EXPECT_FALSE(thread_list->IsRunnable(ThreadList::kMaxThreadId));
+  {
+    ScopedThreadStateChange tsc(soa.Self(), kNative);
+    EXPECT_FALSE(thread_list->IsRunnable(soa.Self()->GetThinLockId()));
+  }
+}
+
+TEST_F(MonitorTest, RevokeBiasOfRunnableOwner) {
+  EnableBiasedLocking();
+  ScopedObjectAccess soa(Thread::Current());
+  Thread* self = soa.Self();
+  SirtRef<mirror::String> obj(self, mirror::String::AllocFromModifiedUtf8(self, "biased"));
+  ASSERT_TRUE(obj.get() != NULL);
+
+  // Locks biased towards us are acquired and released without changing their owner.
+  obj->MonitorEnter(self);
+  EXPECT_TRUE(IsBiasedTowards(obj.get(), self));
+  obj->MonitorExit(self);
+  EXPECT_TRUE(IsBiasedTowards(obj.get(), self));
+  obj->MonitorEnter(self);
+  EXPECT_TRUE(IsBiasedTowards(obj.get(), self));
+
+  // Another thread locking the object has us revoke the bias at a suspend point, we keep holding
+  // the lock.
+  const size_t num_revocations = NumBiasRevocations();
+  UniquePtr<ThreadPool> thread_pool;
+  {
+    ScopedThreadStateChange tsc(self, kNative);
+    thread_pool.reset(new ThreadPool(1));
+  }
+  AtomicInteger done(0);
+  LockTask task(obj.get(), &done);
+  thread_pool->AddTask(self, &task);
+  thread_pool->StartWorkers(self);
+  while (IsBiasedTowards(obj.get(), self)) {
+    CheckSuspend(self);
+    sched_yield();
+  }
+  EXPECT_TRUE(IsThinLockedBy(obj.get(), self));
+  EXPECT_EQ(num_revocations + 1, NumBiasRevocations());
+  EXPECT_EQ(0, done.load());
+  obj->MonitorExit(self);
+  while (done.load() == 0) {
+    CheckSuspend(self);
+    sched_yield();
+  }
+  EXPECT_TRUE(task.Owned());
+  {
+    ScopedThreadStateChange tsc(self, kNative);
+    thread_pool->Wait(self, false, false);
+    thread_pool.reset();
+  }
+  EXPECT_FALSE(self->IsExceptionPending());
+}
+
+TEST_F(MonitorTest, RevokeBiasOfSuspendedOwner) {
+  EnableBiasedLocking();
+  ScopedObjectAccess soa(Thread::Current());
+  Thread* self = soa.Self();
+  SirtRef<mirror::String> obj(self, mirror::String::AllocFromModifiedUtf8(self, "biased"));
+  ASSERT_TRUE(obj.get() != NULL);
+  obj->MonitorEnter(self);
+  obj->MonitorExit(self);
+  EXPECT_TRUE(IsBiasedTowards(obj.get(), self));
+
+  // We are suspended while waiting for the worker, which revokes the bias for us.
+  const size_t num_revocations = NumBiasRevocations();
+  UniquePtr<ThreadPool> thread_pool;
+  AtomicInteger done(0);
+  LockTask task(obj.get(), &done);
+  {
+    ScopedThreadStateChange tsc(self, kNative);
+    thread_pool.reset(new ThreadPool(1));
+    thread_pool->AddTask(self, &task);
+    thread_pool->StartWorkers(self);
+    thread_pool->Wait(self, false, false);
+  }
+  EXPECT_EQ(1, done.load());
+  EXPECT_TRUE(task.Owned());
+  EXPECT_FALSE(IsBiasedTowards(obj.get(), self));
+  EXPECT_EQ(num_revocations + 1, NumBiasRevocations());
+
+  // The lock may now be biased towards the idle worker, whose bias we revoke in turn.
+  obj->MonitorEnter(self);
+  EXPECT_EQ(static_cast<uint32_t>(self->GetThinLockId()),
+            Monitor::GetThinLockId(*obj->GetRawLockWordAddress()));
+  obj->MonitorExit(self);
+  EXPECT_FALSE(self->IsExceptionPending());
+  {
+    ScopedThreadStateChange tsc(self, kNative);
+    thread_pool.reset();
+  }
+}
+
+TEST_F(MonitorTest, UnbiasOwnLockBeforeWait) {
+  EnableBiasedLocking();
+  ScopedObjectAccess soa(Thread::Current());
+  Thread* self = soa.Self();
+  SirtRef<mirror::String> obj(self, mirror::String::AllocFromModifiedUtf8(self, "biased"));
+  ASSERT_TRUE(obj.get() != NULL);
+  obj->MonitorEnter(self);
+  obj->MonitorEnter(self);
+  EXPECT_TRUE(IsBiasedTowards(obj.get(), self));
+
+  // Waiting inflates the lock, which has to keep the number of times we hold it.
+  const size_t num_revocations = NumBiasRevocations();
+  Monitor::Wait(self, obj.get(), 1, 0, false, kTimedWaiting, false);
+  EXPECT_FALSE(self->IsExceptionPending());
+  EXPECT_TRUE(IsFat(obj.get()));
+  // Removing our own bias is not a revocation.
+  EXPECT_EQ(num_revocations, NumBiasRevocations());
+  EXPECT_TRUE(obj->MonitorExit(self));
+  EXPECT_TRUE(obj->MonitorExit(self));
+  EXPECT_FALSE(self->IsExceptionPending());
+  // We no longer hold it.
+  EXPECT_FALSE(obj->MonitorExit(self));
+  EXPECT_TRUE(self->IsExceptionPending());
+  self->ClearException();
+}
+
+TEST_F(MonitorTest, UnbiasOwnLockOnCountOverflow) {
+  EnableBiasedLocking();
+  ScopedObjectAccess soa(Thread::Current());
+  Thread* self = soa.Self();
+  SirtRef<mirror::String> obj(self, mirror::String::AllocFromModifiedUtf8(self, "biased"));
+  ASSERT_TRUE(obj.get() != NULL);
+
+  // More acquisitions than the count of a thin lock holds, the lock is unbiased then inflated.
+  const size_t kAcquisitions = (1 << 12) + 16;
+  for (size_t i = 0; i < kAcquisitions; ++i) {
+    obj->MonitorEnter(self);
+  }
+  EXPECT_FALSE(IsBiasedTowards(obj.get(), self));
+  EXPECT_TRUE(IsFat(obj.get()));
+  for (size_t i = 0; i < kAcquisitions; ++i) {
+    ASSERT_TRUE(obj->MonitorExit(self)) << i;
+  }
+  EXPECT_FALSE(obj->MonitorExit(self));
+  EXPECT_TRUE(self->IsExceptionPending());
+  self->ClearException();
+}
+
+TEST_F(MonitorTest, StopBiasingAfterRevocations) {
+  EnableBiasedLocking();
+  ScopedObjectAccess soa(Thread::Current());
+  Thread* self = soa.Self();
+  SirtRef<mirror::String> obj(self, mirror::String::AllocFromModifiedUtf8(self, "biased"));
+  ASSERT_TRUE(obj.get() != NULL);
+  mirror::Class* string_class = obj->GetClass();
+  mirror::Class* object_class = class_linker_->FindSystemClass("Ljava/lang/Object;");
+  ASSERT_TRUE(object_class != NULL);
+
+  for (size_t i = 0; i + 1 < MaxBiasRevocations(); ++i) {
+    RecordBiasRevocation(string_class);
+  }
+  EXPECT_TRUE(IsBiasable(string_class));
+  RecordBiasRevocation(string_class);
+  EXPECT_FALSE(IsBiasable(string_class));
+  EXPECT_TRUE(IsBiasable(object_class));
+
+  // The locks of the class get plain thin locks.
+  obj->MonitorEnter(self);
+  EXPECT_TRUE(IsThinLockedBy(obj.get(), self));
+  obj->MonitorExit(self);
+  EXPECT_FALSE(self->IsExceptionPending());
+}
+
+}  // namespace art
@@ -152,7 +152,7 @@ static void Thread_nativeSetPriority(JNIEnv* env, jobject java_thread, jint new_
 static void Thread_sleep(JNIEnv* env, jclass, jobject java_lock, jlong ms, jint ns) {
   ScopedObjectAccess soa(env);
   mirror::Object* lock = soa.Decode<mirror::Object*>(java_lock);
-  Monitor::Wait(Thread::Current(), lock, ms, ns, true, kSleeping);
+  Monitor::Wait(Thread::Current(), lock, ms, ns, true, kSleeping, true);
 }
 
 /*
@@ -22,7 +22,7 @@
 namespace art {
 
 const uint8_t OatHeader::kOatMagic[] = { 'o', 'a', 't', '\n' };
-const uint8_t OatHeader::kOatVersion[] = { '0', '0', '8', '\0' };
+const uint8_t OatHeader::kOatVersion[] = { '0', '0', '9', '\0' };
 
 OatHeader::OatHeader() {
   memset(this, 0, sizeof(*this));
@@ -92,6 +92,11 @@ void OatHeader::UpdateChecksum(const void* data, size_t length) {
   adler32_checksum_ = adler32(adler32_checksum_, bytes, length);
 }
 
+void OatHeader::CombineChecksum(uint32_t adler32_checksum, size_t length) {
+  DCHECK(IsValid());
+  adler32_checksum_ = adler32_combine(adler32_checksum_, adler32_checksum, length);
+}
+
 InstructionSet OatHeader::GetInstructionSet() const {
   CHECK(IsValid());
   return instruction_set_;
@@ -41,6 +41,8 @@ class PACKED(4) OatHeader {
   const char* GetMagic() const;
   uint32_t GetChecksum() const;
   void UpdateChecksum(const void* data, size_t length);
+  // Appends data of the given length that was checksummed on its own, as if by UpdateChecksum.
+  void CombineChecksum(uint32_t adler32_checksum, size_t length);
   uint32_t GetDexFileCount() const {
     DCHECK(IsValid());
     return dex_file_count_;
@@ -47,7 +47,7 @@ class ObjectLock {
   }
 
   void WaitIgnoringInterrupts() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    Monitor::Wait(self_, obj_, 0, 0, false, kWaiting);
+    Monitor::Wait(self_, obj_, 0, 0, false, kWaiting, false);
   }
 
   void Notify() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
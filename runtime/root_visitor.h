@@ -23,10 +23,11 @@ class Object;
 }  // namespace mirror
 class StackVisitor;
 
-typedef void (RootVisitor)(const mirror::Object* root, void* arg);
+// Returns the new address of the root, which differs from root when the object has been moved by
+// a compacting collector. Visitors that sweep weak roots return NULL for objects that are dead.
+typedef mirror::Object* (RootVisitor)(mirror::Object* root, void* arg);
 typedef void (VerifyRootVisitor)(const mirror::Object* root, void* arg, size_t vreg,
                                  const StackVisitor* visitor);
-typedef bool (IsMarkedTester)(const mirror::Object* object, void* arg);
 
 }  // namespace art
 
@@ -34,12 +34,14 @@
 #include "atomic.h"
 #include "class_linker.h"
 #include "debugger.h"
+#include "dex_file.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/heap.h"
 #include "gc/space/space.h"
 #include "image.h"
 #include "instrumentation.h"
 #include "intern_table.h"
+#include "interpreter/interpreter.h"
 #include "invoke_arg_array_builder.h"
 #include "jni_internal.h"
 #include "mirror/art_field-inl.h"
@@ -344,6 +346,13 @@ Runtime::ParsedOptions* Runtime::ParsedOptions::Create(const Options& options, b
   parsed->conc_gc_threads_ = 0;
   parsed->stack_size_ = 0;  // 0 means default.
   parsed->low_memory_mode_ = false;
+  parsed->use_rosalloc_ = false;
+  parsed->background_compaction_ = false;
+  parsed->nursery_collection_ = false;
+  parsed->image_mod_union_table_kind_ = gc::Heap::kDefaultImageModUnionTableKind;
+  parsed->use_biased_locking_ = false;
+  parsed->verify_class_data_lazily_ = false;
+  parsed->interpreter_impl_kind_ = interpreter::kDefaultInterpreterImplKind;
 
   parsed->is_compiler_ = false;
   parsed->is_zygote_ = false;
@@ -513,6 +522,25 @@ Runtime::ParsedOptions* Runtime::ParsedOptions::Create(const Options& options, b
       parsed->ignore_max_footprint_ = true;
     } else if (option == "-XX:LowMemoryMode") {
       parsed->low_memory_mode_ = true;
+    } else if (option == "-XX:UseRosAlloc") {
+      parsed->use_rosalloc_ = true;
+    } else if (option == "-XX:BackgroundCompaction") {
+      parsed->background_compaction_ = true;
+    } else if (option == "-XX:NurseryCollection") {
+      parsed->nursery_collection_ = true;
+    } else if (StartsWith(option, "-XX:ImageModUnionTable=")) {
+      std::string kind(option.substr(strlen("-XX:ImageModUnionTable=")));
+      if (kind == "reference") {
+        parsed->image_mod_union_table_kind_ = gc::kModUnionTableReferenceCache;
+      } else if (kind == "compact") {
+        parsed->image_mod_union_table_kind_ = gc::kModUnionTableCompactReferenceCache;
+      } else if (kind == "card") {
+        parsed->image_mod_union_table_kind_ = gc::kModUnionTableCardCache;
+      } else {
+        LOG(WARNING) << "Ignoring unknown -XX:ImageModUnionTable option: " << kind;
+      }
+    } else if (option == "-XX:BiasedLocking") {
+      parsed->use_biased_locking_ = true;
     } else if (StartsWith(option, "-D")) {
       parsed->properties_.push_back(option.substr(strlen("-D")));
     } else if (StartsWith(option, "-Xjnitrace:")) {
@@ -598,6 +626,14 @@ Runtime::ParsedOptions* Runtime::ParsedOptions::Create(const Options& options, b
       Trace::SetDefaultClockSource(kProfilerClockSourceWall);
     } else if (option == "-Xprofile:dualclock") {
       Trace::SetDefaultClockSource(kProfilerClockSourceDual);
+    } else if (option == "-Xdexverify:lazy") {
+      parsed->verify_class_data_lazily_ = true;
+    } else if (option == "-Xdexverify:eager") {
+      parsed->verify_class_data_lazily_ = false;
+    } else if (option == "-XX:InterpreterImpl=switch") {
+      parsed->interpreter_impl_kind_ = interpreter::kSwitchImpl;
+    } else if (option == "-XX:InterpreterImpl=goto") {
+      parsed->interpreter_impl_kind_ = interpreter::kGotoImpl;
     } else if (option == "-compiler-filter:interpret-only") {
       parsed->compiler_filter_ = kInterpretOnly;
     } else if (option == "-compiler-filter:space") {
@@ -640,6 +676,13 @@ Runtime::ParsedOptions* Runtime::ParsedOptions::Create(const Options& options, b
     parsed->boot_class_path_string_.replace(core_jar_pos, core_jar.size(), "/core-libart.jar");
   }
 
+  // Class data left unchecked is only checked when the class linker defines the class, but the
+  // compiler reads the class data and code of classes it never defines.
+  if (parsed->is_compiler_ && parsed->verify_class_data_lazily_) {
+    LOG(ERROR) << "-Xdexverify:lazy can't be used when compiling";
+    return NULL;
+  }
+
   if (!parsed->is_compiler_ && parsed->image_.empty()) {
     parsed->image_ += GetAndroidRoot();
     parsed->image_ += "/framework/boot.art";
@@ -838,7 +881,10 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
 
   QuasiAtomic::Startup();
 
-  Monitor::Init(options->lock_profiling_threshold_, options->hook_is_sensitive_thread_);
+  Monitor::Init(options->lock_profiling_threshold_, options->use_biased_locking_,
+                options->hook_is_sensitive_thread_);
+  DexFile::SetVerifyClassDataLazily(options->verify_class_data_lazily_);
+  interpreter::SetInterpreterImplKind(options->interpreter_impl_kind_);
 
   host_prefix_ = options->host_prefix_;
   boot_class_path_string_ = options->boot_class_path_string_;
@@ -887,7 +933,11 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
                        options->low_memory_mode_,
                        options->long_pause_log_threshold_,
                        options->long_gc_log_threshold_,
-                       options->ignore_max_footprint_);
+                       options->ignore_max_footprint_,
+                       options->use_rosalloc_,
+                       options->background_compaction_,
+                       options->nursery_collection_,
+                       options->image_mod_union_table_kind_);
 
   BlockSignals();
   InitPlatformSignalHandlers();
@@ -1036,6 +1086,7 @@ void Runtime::DumpForSigQuit(std::ostream& os) {
   GetInternTable()->DumpForSigQuit(os);
   GetJavaVM()->DumpForSigQuit(os);
   GetHeap()->DumpForSigQuit(os);
+  GetMonitorList()->DumpForSigQuit(os);
   os << "\n";
 
   thread_list_->DumpForSigQuit(os);
@@ -1151,11 +1202,12 @@ void Runtime::VisitConcurrentRoots(RootVisitor* visitor, void* arg, bool only_di
 void Runtime::VisitNonThreadRoots(RootVisitor* visitor, void* arg) {
   java_vm_->VisitRoots(visitor, arg);
   if (pre_allocated_OutOfMemoryError_ != NULL) {
-    visitor(pre_allocated_OutOfMemoryError_, arg);
+    pre_allocated_OutOfMemoryError_ = down_cast<mirror::Throwable*>(
+        visitor(pre_allocated_OutOfMemoryError_, arg));
   }
-  visitor(resolution_method_, arg);
+  resolution_method_ = down_cast<mirror::ArtMethod*>(visitor(resolution_method_, arg));
   for (int i = 0; i < Runtime::kLastCalleeSaveType; i++) {
-    visitor(callee_save_methods_[i], arg);
+    callee_save_methods_[i] = down_cast<mirror::ArtMethod*>(visitor(callee_save_methods_[i], arg));
   }
 }
 
@@ -31,6 +31,7 @@
 #include "globals.h"
 #include "instruction_set.h"
 #include "instrumentation.h"
+#include "interpreter/interpreter.h"
 #include "jobject_comparator.h"
 #include "locks.h"
 #include "root_visitor.h"
@@ -113,6 +114,13 @@ class Runtime {
     size_t conc_gc_threads_;
     size_t stack_size_;
     bool low_memory_mode_;
+    bool use_rosalloc_;
+    bool background_compaction_;
+    bool nursery_collection_;
+    gc::ModUnionTableKind image_mod_union_table_kind_;
+    bool use_biased_locking_;
+    bool verify_class_data_lazily_;
+    interpreter::InterpreterImplKind interpreter_impl_kind_;
     size_t lock_profiling_threshold_;
     std::string stack_trace_file_;
     bool method_trace_;
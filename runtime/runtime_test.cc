@@ -50,6 +50,7 @@ TEST_F(RuntimeTest, ParsedOptions) {
   options.push_back(std::make_pair("-Dfoo=bar", null));
   options.push_back(std::make_pair("-Dbaz=qux", null));
   options.push_back(std::make_pair("-verbose:gc,class,jni", null));
+  options.push_back(std::make_pair("-XX:InterpreterImpl=goto", null));
   options.push_back(std::make_pair("host-prefix", "host_prefix"));
   options.push_back(std::make_pair("vfprintf", test_vfprintf));
   options.push_back(std::make_pair("abort", test_abort));
@@ -66,6 +67,9 @@ TEST_F(RuntimeTest, ParsedOptions) {
   EXPECT_EQ(1 * MB, parsed->stack_size_);
   EXPECT_EQ(0.75, parsed->heap_target_utilization_);
   EXPECT_EQ("host_prefix", parsed->host_prefix_);
+  EXPECT_EQ(interpreter::kGotoImpl, parsed->interpreter_impl_kind_);
+  // Only Runtime::Init applies the options.
+  EXPECT_EQ(interpreter::kDefaultInterpreterImplKind, interpreter::GetInterpreterImplKind());
   EXPECT_TRUE(test_vfprintf == parsed->hook_vfprintf_);
   EXPECT_TRUE(test_exit == parsed->hook_exit_);
   EXPECT_TRUE(test_abort == parsed->hook_abort_);
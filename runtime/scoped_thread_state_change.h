@@ -31,7 +31,8 @@ class ScopedThreadStateChange {
  public:
   ScopedThreadStateChange(Thread* self, ThreadState new_thread_state)
       LOCKS_EXCLUDED(Locks::thread_suspend_count_lock_) ALWAYS_INLINE
-      : self_(self), thread_state_(new_thread_state), expected_has_no_thread_(false) {
+      : self_(self), thread_state_(new_thread_state), old_at_moving_gc_safe_point_(false),
+        expected_has_no_thread_(false) {
     if (UNLIKELY(self_ == NULL)) {
       // Value chosen arbitrarily and won't be used in the destructor since thread_ == NULL.
       old_thread_state_ = kTerminated;
@@ -44,6 +45,8 @@ class ScopedThreadStateChange {
       // Read state without locks, ok as state is effectively thread local and we're not interested
       // in the suspend count (this will be handled in the runnable transitions).
       old_thread_state_ = self->GetState();
+      // Becoming runnable clears this, it is restored once the thread is back where it came from.
+      old_at_moving_gc_safe_point_ = self->IsAtMovingGcSafePoint();
       runnable_transition = old_thread_state_ == kRunnable || new_thread_state == kRunnable;
       if (!runnable_transition) {
         // A suspended transition to another effectively suspended transition, ok to use Unsafe.
@@ -74,6 +77,7 @@ class ScopedThreadStateChange {
         if (old_thread_state_ == kRunnable) {
           self_->TransitionFromSuspendedToRunnable();
         } else if (thread_state_ == kRunnable) {
+          self_->SetAtMovingGcSafePoint(old_at_moving_gc_safe_point_);
           self_->TransitionFromRunnableToSuspended(old_thread_state_);
         } else {
           // A suspended transition to another effectively suspended transition, ok to use Unsafe.
@@ -91,13 +95,14 @@ class ScopedThreadStateChange {
   // Constructor used by ScopedJniThreadState for an unattached thread that has access to the VM*.
   ScopedThreadStateChange()
       : self_(NULL), thread_state_(kTerminated), old_thread_state_(kTerminated),
-        expected_has_no_thread_(true) {}
+        old_at_moving_gc_safe_point_(false), expected_has_no_thread_(true) {}
 
   Thread* const self_;
   const ThreadState thread_state_;
 
  private:
   ThreadState old_thread_state_;
+  bool old_at_moving_gc_safe_point_;
   const bool expected_has_no_thread_;
 
   DISALLOW_COPY_AND_ASSIGN(ScopedThreadStateChange);
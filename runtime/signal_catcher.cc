@@ -147,7 +147,6 @@ void SignalCatcher::HandleSigQuit() {
   CHECK_EQ(self->SetStateUnsafe(old_state), kRunnable);
   if (self->ReadFlag(kCheckpointRequest)) {
     self->RunCheckpointFunction();
-    self->AtomicClearFlag(kCheckpointRequest);
   }
   self->EndAssertNoThreadSuspension(old_cause);
   thread_list->ResumeAll();
@@ -161,6 +160,8 @@ void SignalCatcher::HandleSigUsr1() {
 }
 
 int SignalCatcher::WaitForSignal(Thread* self, SignalSet& signals) {
+  // The catcher holds no object pointers while it waits, so objects may move under it.
+  self->SetAtMovingGcSafePoint(true);
   ScopedThreadStateChange tsc(self, kWaitingInMainSignalCatcherLoop);
 
   // Signals for sigwait() must be blocked but not ignored.  We
@@ -168,6 +169,7 @@ int SignalCatcher::WaitForSignal(Thread* self, SignalSet& signals) {
   // is met.  When the signal hits, we wake up, without any signal
   // handlers being invoked.
   int signal_number = signals.Wait();
+  self->SetAtMovingGcSafePoint(false);
   if (!ShouldHalt()) {
     // Let the user know we got the signal, just in case the system's too screwed for us to
     // actually do what they want us to do...
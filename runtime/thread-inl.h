@@ -121,6 +121,8 @@ inline ThreadState Thread::TransitionFromSuspendedToRunnable() {
       Locks::mutator_lock_->SharedUnlock(this);
     }
   } while (UNLIKELY(!done));
+  // Runnable code may hold object references anywhere.
+  at_moving_gc_safe_point_ = false;
   return static_cast<ThreadState>(old_state);
 }
 
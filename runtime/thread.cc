@@ -564,15 +564,35 @@ void Thread::ModifySuspendCount(Thread* self, int delta, bool for_debugger) {
 }
 
 void Thread::RunCheckpointFunction() {
-  CHECK(checkpoint_function_ != NULL);
+  Closure* checkpoints[kMaxCheckpoints];
+  {
+    // Take the functions and clear the flag together, functions requested from now on set the flag
+    // again.
+    MutexLock mu(this, *Locks::thread_suspend_count_lock_);
+    for (size_t i = 0; i < kMaxCheckpoints; ++i) {
+      checkpoints[i] = CheckpointFunctionSlot(i);
+      CheckpointFunctionSlot(i) = NULL;
+    }
+    AtomicClearFlag(kCheckpointRequest);
+  }
   ATRACE_BEGIN("Checkpoint function");
-  checkpoint_function_->Run(this);
+  for (size_t i = 0; i < kMaxCheckpoints; ++i) {
+    if (checkpoints[i] != NULL) {
+      checkpoints[i]->Run(this);
+    }
+  }
   ATRACE_END();
 }
 
 bool Thread::RequestCheckpoint(Closure* function) {
-  CHECK(!ReadFlag(kCheckpointRequest)) << "Already have a pending checkpoint request";
-  checkpoint_function_ = function;
+  size_t slot = 0;
+  while (slot < kMaxCheckpoints && CheckpointFunctionSlot(slot) != NULL) {
+    ++slot;
+  }
+  if (slot == kMaxCheckpoints) {
+    return false;
+  }
+  CheckpointFunctionSlot(slot) = function;
   union StateAndFlags old_state_and_flags = state_and_flags_;
   // We must be runnable to request a checkpoint.
   old_state_and_flags.as_struct.state = kRunnable;
@@ -580,12 +600,17 @@ bool Thread::RequestCheckpoint(Closure* function) {
   new_state_and_flags.as_struct.flags |= kCheckpointRequest;
   int succeeded = android_atomic_cmpxchg(old_state_and_flags.as_int, new_state_and_flags.as_int,
                                          &state_and_flags_.as_int);
+  if (succeeded != 0) {
+    // The thread is not runnable, it won't look at the function.
+    CheckpointFunctionSlot(slot) = NULL;
+  }
   return succeeded == 0;
 }
 
-void Thread::FullSuspendCheck() {
+void Thread::FullSuspendCheck(bool at_moving_gc_safe_point) {
   VLOG(threads) << this << " self-suspending";
   ATRACE_BEGIN("Full suspend check");
+  SetAtMovingGcSafePoint(at_moving_gc_safe_point);
   // Make thread appear suspended to other threads, release mutator_lock_.
   TransitionFromRunnableToSuspended(kSuspended);
   // Transition back to runnable noting requests to suspend, re-acquire share on mutator_lock_.
@@ -986,12 +1011,18 @@ Thread::Thread(bool daemon)
       pthread_self_(0),
       no_thread_suspension_(0),
       last_no_thread_suspension_cause_(NULL),
-      checkpoint_function_(0),
-      thread_exit_check_count_(0) {
+      checkpoint_function_(NULL),
+      thread_exit_check_count_(0),
+      thread_local_alloc_stack_top_(NULL),
+      thread_local_alloc_stack_end_(NULL),
+      at_moving_gc_safe_point_(false) {
   CHECK_EQ((sizeof(Thread) % 4), 0U) << sizeof(Thread);
+  memset(&more_checkpoint_functions_[0], 0, sizeof(more_checkpoint_functions_));
   state_and_flags_.as_struct.flags = 0;
   state_and_flags_.as_struct.state = kNative;
   memset(&held_mutexes_[0], 0, sizeof(held_mutexes_));
+  memset(&thread_local_alloc_cache_[0], 0, sizeof(thread_local_alloc_cache_));
+  memset(&rosalloc_runs_[0], 0, sizeof(rosalloc_runs_));
 }
 
 bool Thread::IsStillStarting() const {
@@ -1012,9 +1043,10 @@ void Thread::AssertNoPendingException() const {
   }
 }
 
-static void MonitorExitVisitor(const mirror::Object* object, void* arg) NO_THREAD_SAFETY_ANALYSIS {
+static mirror::Object* MonitorExitVisitor(mirror::Object* object, void* arg)
+    NO_THREAD_SAFETY_ANALYSIS {
   Thread* self = reinterpret_cast<Thread*>(arg);
-  mirror::Object* entered_monitor = const_cast<mirror::Object*>(object);
+  mirror::Object* entered_monitor = object;
   if (self->HoldsLock(entered_monitor)) {
     LOG(WARNING) << "Calling MonitorExit on object "
                  << object << " (" << PrettyTypeOf(object) << ")"
@@ -1022,6 +1054,7 @@ static void MonitorExitVisitor(const mirror::Object* object, void* arg) NO_THREA
                  << *Thread::Current() << " which is detaching";
     entered_monitor->MonitorExit(self);
   }
+  return object;
 }
 
 void Thread::Destroy() {
@@ -1053,6 +1086,14 @@ void Thread::Destroy() {
   if (jni_env_ != NULL) {
     jni_env_->monitors.VisitRoots(MonitorExitVisitor, self);
   }
+
+  // Give any cached allocations back to the heap. We need to be runnable so that a GC can't
+  // revoke them from under us.
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  if (heap != NULL) {
+    ScopedObjectAccess soa(self);
+    heap->RevokeThreadLocalBuffers(self);
+  }
 }
 
 Thread::~Thread() {
@@ -1152,7 +1193,10 @@ void Thread::SirtVisitRoots(RootVisitor* visitor, void* arg) {
     for (size_t j = 0; j < num_refs; j++) {
       mirror::Object* object = cur->GetReference(j);
       if (object != NULL) {
-        visitor(object, arg);
+        mirror::Object* new_object = visitor(object, arg);
+        if (new_object != object) {
+          cur->SetReference(j, new_object);
+        }
       }
     }
   }
@@ -1682,6 +1726,7 @@ static const EntryPointInfo gThreadEntryPointInfo[] = {
   QUICK_ENTRY_POINT_INFO(pMemcmp16),
   QUICK_ENTRY_POINT_INFO(pStringCompareTo),
   QUICK_ENTRY_POINT_INFO(pMemcpy),
+  QUICK_ENTRY_POINT_INFO(pArrayCopy),
   QUICK_ENTRY_POINT_INFO(pQuickResolutionTrampoline),
   QUICK_ENTRY_POINT_INFO(pQuickToInterpreterBridge),
   QUICK_ENTRY_POINT_INFO(pInvokeDirectTrampolineWithAccessCheck),
@@ -2003,7 +2048,8 @@ bool Thread::HoldsLock(mirror::Object* object) {
   return object->GetThinLockId() == thin_lock_id_;
 }
 
-// RootVisitor parameters are: (const Object* obj, size_t vreg, const StackVisitor* visitor).
+// RootVisitor parameters are: (Object* obj, size_t vreg, const StackVisitor* visitor). The visitor
+// returns the new address of obj, which is written back into the frame if the object was moved.
 template <typename RootVisitor>
 class ReferenceMapVisitor : public StackVisitor {
  public:
@@ -2025,7 +2071,10 @@ class ReferenceMapVisitor : public StackVisitor {
         for (size_t reg = 0; reg < num_regs; ++reg) {
           mirror::Object* ref = shadow_frame->GetVRegReference(reg);
           if (ref != NULL) {
-            visitor_(ref, reg, this);
+            mirror::Object* new_ref = visitor_(ref, reg, this);
+            if (new_ref != ref) {
+              shadow_frame->SetVRegReference(reg, new_ref);
+            }
           }
         }
       } else {
@@ -2046,7 +2095,10 @@ class ReferenceMapVisitor : public StackVisitor {
           if (TestBitmap(reg, reg_bitmap)) {
             mirror::Object* ref = shadow_frame->GetVRegReference(reg);
             if (ref != NULL) {
-              visitor_(ref, reg, this);
+              mirror::Object* new_ref = visitor_(ref, reg, this);
+              if (new_ref != ref) {
+                shadow_frame->SetVRegReference(reg, new_ref);
+              }
             }
           }
         }
@@ -2078,7 +2130,8 @@ class ReferenceMapVisitor : public StackVisitor {
             if (TestBitmap(reg, reg_bitmap)) {
               uint32_t vmap_offset;
               mirror::Object* ref;
-              if (vmap_table.IsInContext(reg, kReferenceVReg, &vmap_offset)) {
+              bool in_context = vmap_table.IsInContext(reg, kReferenceVReg, &vmap_offset);
+              if (in_context) {
                 uintptr_t val = GetGPR(vmap_table.ComputeRegister(core_spills, vmap_offset,
                                                                   kReferenceVReg));
                 ref = reinterpret_cast<mirror::Object*>(val);
@@ -2089,7 +2142,18 @@ class ReferenceMapVisitor : public StackVisitor {
               }
 
               if (ref != NULL) {
-                visitor_(ref, reg, this);
+                mirror::Object* new_ref = visitor_(ref, reg, this);
+                if (new_ref != ref) {
+                  uintptr_t new_val = reinterpret_cast<uintptr_t>(new_ref);
+                  if (in_context) {
+                    SetGPR(vmap_table.ComputeRegister(core_spills, vmap_offset, kReferenceVReg),
+                           new_val);
+                  } else {
+                    int offset = GetVRegOffset(code_item, core_spills, fp_spills, frame_size, reg);
+                    byte* vreg_addr = reinterpret_cast<byte*>(cur_quick_frame) + offset;
+                    *reinterpret_cast<uint32_t*>(vreg_addr) = new_val;
+                  }
+                }
               }
             }
           }
@@ -2115,8 +2179,8 @@ class RootCallbackVisitor {
  public:
   RootCallbackVisitor(RootVisitor* visitor, void* arg) : visitor_(visitor), arg_(arg) {}
 
-  void operator()(const mirror::Object* obj, size_t, const StackVisitor*) const {
-    visitor_(obj, arg_);
+  mirror::Object* operator()(mirror::Object* obj, size_t, const StackVisitor*) const {
+    return visitor_(obj, arg_);
   }
 
  private:
@@ -2131,8 +2195,9 @@ class VerifyCallbackVisitor {
         arg_(arg) {
   }
 
-  void operator()(const mirror::Object* obj, size_t vreg, const StackVisitor* visitor) const {
+  mirror::Object* operator()(mirror::Object* obj, size_t vreg, const StackVisitor* visitor) const {
     visitor_(obj, arg_, vreg, visitor);
+    return obj;
   }
 
  private:
@@ -2145,9 +2210,10 @@ struct VerifyRootWrapperArg {
   void* arg;
 };
 
-static void VerifyRootWrapperCallback(const mirror::Object* root, void* arg) {
+static mirror::Object* VerifyRootWrapperCallback(mirror::Object* root, void* arg) {
   VerifyRootWrapperArg* wrapperArg = reinterpret_cast<VerifyRootWrapperArg*>(arg);
   wrapperArg->visitor(root, wrapperArg->arg, 0, NULL);
+  return root;
 }
 
 void Thread::VerifyRoots(VerifyRootVisitor* visitor, void* arg) {
@@ -2193,14 +2259,15 @@ void Thread::VerifyRoots(VerifyRootVisitor* visitor, void* arg) {
 
 void Thread::VisitRoots(RootVisitor* visitor, void* arg) {
   if (opeer_ != NULL) {
-    visitor(opeer_, arg);
+    opeer_ = visitor(opeer_, arg);
   }
   if (exception_ != NULL) {
-    visitor(exception_, arg);
+    exception_ = down_cast<mirror::Throwable*>(visitor(exception_, arg));
   }
   throw_location_.VisitRoots(visitor, arg);
   if (class_loader_override_ != NULL) {
-    visitor(class_loader_override_, arg);
+    class_loader_override_ = down_cast<mirror::ClassLoader*>(
+        visitor(class_loader_override_, arg));
   }
   jni_env_->locals.VisitRoots(visitor, arg);
   jni_env_->monitors.VisitRoots(visitor, arg);
@@ -2214,19 +2281,18 @@ void Thread::VisitRoots(RootVisitor* visitor, void* arg) {
   mapper.WalkStack();
   ReleaseLongJumpContext(context);
 
-  for (const instrumentation::InstrumentationStackFrame& frame : *GetInstrumentationStack()) {
-    mirror::Object* this_object = frame.this_object_;
-    if (this_object != NULL) {
-      visitor(this_object, arg);
+  for (instrumentation::InstrumentationStackFrame& frame : *GetInstrumentationStack()) {
+    if (frame.this_object_ != NULL) {
+      frame.this_object_ = visitor(frame.this_object_, arg);
     }
-    mirror::ArtMethod* method = frame.method_;
-    visitor(method, arg);
+    frame.method_ = down_cast<mirror::ArtMethod*>(visitor(frame.method_, arg));
   }
 }
 
-static void VerifyObject(const mirror::Object* root, void* arg) {
+static mirror::Object* VerifyObject(mirror::Object* root, void* arg) {
   gc::Heap* heap = reinterpret_cast<gc::Heap*>(arg);
   heap->VerifyObject(root);
+  return root;
 }
 
 void Thread::VerifyStackImpl() {
@@ -148,6 +148,22 @@ class PACKED(4) Thread {
 
   ThreadState SetState(ThreadState new_state);
 
+  // The object the thread is blocked trying to lock, or NULL.
+  mirror::Object* GetMonitorEnterObject() const {
+    return monitor_enter_object_;
+  }
+
+  // Whether the thread, while not runnable, only refers to objects through roots that a moving
+  // collector visits and updates, so that objects may move under it. Set just before the thread
+  // leaves runnable at such a point, and cleared whenever it becomes runnable again.
+  bool IsAtMovingGcSafePoint() const {
+    return at_moving_gc_safe_point_;
+  }
+
+  void SetAtMovingGcSafePoint(bool at_safe_point) {
+    at_moving_gc_safe_point_ = at_safe_point;
+  }
+
   int GetSuspendCount() const EXCLUSIVE_LOCKS_REQUIRED(Locks::thread_suspend_count_lock_) {
     return suspend_count_;
   }
@@ -165,11 +181,16 @@ class PACKED(4) Thread {
   void ModifySuspendCount(Thread* self, int delta, bool for_debugger)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::thread_suspend_count_lock_);
 
-  bool RequestCheckpoint(Closure* function);
+  // Has the thread run the function at its next suspend point. Fails if the thread is not runnable
+  // or already has kMaxCheckpoints pending functions.
+  bool RequestCheckpoint(Closure* function)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::thread_suspend_count_lock_);
 
   // Called when thread detected that the thread_suspend_count_ was non-zero. Gives up share of
-  // mutator_lock_ and waits until it is resumed and thread_suspend_count_ is zero.
-  void FullSuspendCheck()
+  // mutator_lock_ and waits until it is resumed and thread_suspend_count_ is zero. Callers which
+  // hold no object references of their own pass at_moving_gc_safe_point so that a moving
+  // collector may run while the thread is suspended.
+  void FullSuspendCheck(bool at_moving_gc_safe_point = false)
       LOCKS_EXCLUDED(Locks::thread_suspend_count_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -283,6 +304,68 @@ class PACKED(4) Thread {
     return &stats_;
   }
 
+  // Number of size brackets in the thread-local allocation cache, see Heap::AllocObject.
+  static const size_t kNumThreadLocalAllocBrackets = 16;
+
+  // Pops a cached chunk of the given size bracket, or returns NULL if the bracket is empty.
+  mirror::Object* PopThreadLocalAlloc(size_t bracket) {
+    DCHECK_LT(bracket, kNumThreadLocalAllocBrackets);
+    mirror::Object* chunk = thread_local_alloc_cache_[bracket];
+    if (LIKELY(chunk != NULL)) {
+      // Free chunks are linked through their first word.
+      thread_local_alloc_cache_[bracket] = *reinterpret_cast<mirror::Object**>(chunk);
+    }
+    return chunk;
+  }
+
+  void PushThreadLocalAlloc(size_t bracket, mirror::Object* chunk) {
+    DCHECK_LT(bracket, kNumThreadLocalAllocBrackets);
+    *reinterpret_cast<mirror::Object**>(chunk) = thread_local_alloc_cache_[bracket];
+    thread_local_alloc_cache_[bracket] = chunk;
+  }
+
+  // Removes and returns the whole list of cached chunks for the given size bracket.
+  mirror::Object* TakeThreadLocalAllocs(size_t bracket) {
+    DCHECK_LT(bracket, kNumThreadLocalAllocBrackets);
+    mirror::Object* chunks = thread_local_alloc_cache_[bracket];
+    thread_local_alloc_cache_[bracket] = NULL;
+    return chunks;
+  }
+
+  // Records obj in the allocation stack slots reserved by this thread. Returns false if there are
+  // no reserved slots left.
+  bool PushOnThreadLocalAllocationStack(mirror::Object* obj) {
+    if (UNLIKELY(thread_local_alloc_stack_top_ >= thread_local_alloc_stack_end_)) {
+      return false;
+    }
+    *thread_local_alloc_stack_top_ = obj;
+    ++thread_local_alloc_stack_top_;
+    return true;
+  }
+
+  bool HasThreadLocalAllocationStackSlots() const {
+    return thread_local_alloc_stack_top_ < thread_local_alloc_stack_end_;
+  }
+
+  void SetThreadLocalAllocationStack(mirror::Object** start, mirror::Object** end) {
+    thread_local_alloc_stack_top_ = start;
+    thread_local_alloc_stack_end_ = end;
+  }
+
+  // Number of RosAlloc size brackets served from thread-local runs. Sync with
+  // RosAlloc::kNumThreadLocalSizeBrackets.
+  static const size_t kRosAllocNumThreadLocalSizeBrackets = 11;
+
+  void* GetRosAllocRun(size_t index) const {
+    DCHECK_LT(index, kRosAllocNumThreadLocalSizeBrackets);
+    return rosalloc_runs_[index];
+  }
+
+  void SetRosAllocRun(size_t index, void* run) {
+    DCHECK_LT(index, kRosAllocNumThreadLocalSizeBrackets);
+    rosalloc_runs_[index] = run;
+  }
+
   bool IsStillStarting() const;
 
   bool IsExceptionPending() const {
@@ -576,7 +659,14 @@ class PACKED(4) Thread {
     held_mutexes_[level] = mutex;
   }
 
-  void RunCheckpointFunction();
+  // Runs and clears the pending checkpoint functions.
+  void RunCheckpointFunction() LOCKS_EXCLUDED(Locks::thread_suspend_count_lock_);
+
+  // Returns the i-th of the kMaxCheckpoints pending checkpoint function slots.
+  Closure*& CheckpointFunctionSlot(size_t i)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::thread_suspend_count_lock_) {
+    return (i == 0) ? checkpoint_function_ : more_checkpoint_functions_[i - 1];
+  }
 
   bool ReadFlag(ThreadFlag flag) const {
     return (state_and_flags_.as_struct.flags & flag) != 0;
@@ -797,8 +887,8 @@ class PACKED(4) Thread {
   // Cause for last suspension.
   const char* last_no_thread_suspension_cause_;
 
-  // Pending checkpoint functions.
-  Closure* checkpoint_function_;
+  // Pending checkpoint function, the first of the kMaxCheckpoints slots.
+  Closure* checkpoint_function_ GUARDED_BY(Locks::thread_suspend_count_lock_);
 
  public:
   // Entrypoint function pointers
@@ -812,6 +902,29 @@ class PACKED(4) Thread {
   // How many times has our pthread key's destructor been called?
   uint32_t thread_exit_check_count_;
 
+  // Compiled code doesn't read the fields below. They follow the entrypoints so that adding them
+  // doesn't move the entrypoint offsets compiled into oat files.
+
+  // The other pending checkpoint functions, so that a thread can be asked to run a checkpoint on
+  // its own while another one, such as a GC's, is pending.
+  static const size_t kMaxCheckpoints = 3;
+  Closure* more_checkpoint_functions_[kMaxCheckpoints - 1]
+      GUARDED_BY(Locks::thread_suspend_count_lock_);
+
+  // Free alloc space chunks cached by this thread, one list per size bracket. Owned by the heap,
+  // which refills and revokes them.
+  mirror::Object* thread_local_alloc_cache_[kNumThreadLocalAllocBrackets];
+
+  // Allocation stack slots reserved by this thread and filled in as cached chunks are handed out.
+  mirror::Object** thread_local_alloc_stack_top_;
+  mirror::Object** thread_local_alloc_stack_end_;
+
+  // The thread-local runs of the RosAlloc allocator, owned by the RosAllocSpace.
+  void* rosalloc_runs_[kRosAllocNumThreadLocalSizeBrackets];
+
+  // See IsAtMovingGcSafePoint.
+  bool32_t at_moving_gc_safe_point_;
+
   friend class ScopedThreadStateChange;
 
   DISALLOW_COPY_AND_ASSIGN(Thread);
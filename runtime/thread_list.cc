@@ -17,6 +17,8 @@
 #include "thread_list.h"
 
 #include <dirent.h>
+#include <sched.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -30,8 +32,15 @@ namespace art {
 
 ThreadList::ThreadList()
     : allocated_ids_lock_("allocated thread ids lock"),
+      threads_by_thin_lock_id_map_(MemMap::MapAnonymous("threads by thin lock id", NULL,
+                                                        kMaxThreadId * sizeof(Thread*),
+                                                        PROT_READ | PROT_WRITE)),
       suspend_all_count_(0), debug_suspend_all_count_(0),
       thread_exit_cond_("thread exit condition variable", *Locks::thread_list_lock_) {
+  CHECK(threads_by_thin_lock_id_map_.get() != NULL) << "couldn't allocate thread table";
+  // Anonymous mmaps are initialized to zero, that is to no threads.
+  threads_by_thin_lock_id_ = reinterpret_cast<Thread* volatile*>(
+      threads_by_thin_lock_id_map_->Begin());
 }
 
 ThreadList::~ThreadList() {
@@ -144,6 +153,25 @@ static void UnsafeLogFatalForThreadSuspendAllTimeout(Thread* self) NO_THREAD_SAF
 }
 #endif
 
+// Waits for a thread whose suspend count we raised to suspend.
+static void WaitForSuspension(Thread* thread) {
+  if (!thread->IsSuspended()) {
+    // Wait until the thread is suspended.
+    uint64_t start = NanoTime();
+    do {
+      // Sleep for 100us.
+      usleep(100);
+    } while (!thread->IsSuspended());
+    uint64_t end = NanoTime();
+    // Shouldn't need to wait for longer than 1 millisecond.
+    const uint64_t threshold = 1;
+    if (NsToMs(end - start) > threshold) {
+      LOG(INFO) << "Warning: waited longer than " << threshold
+                << " ms for thread suspend\n";
+    }
+  }
+}
+
 size_t ThreadList::RunCheckpoint(Closure* checkpoint_function) {
   Thread* self = Thread::Current();
   if (kIsDebugBuild) {
@@ -159,24 +187,17 @@ size_t ThreadList::RunCheckpoint(Closure* checkpoint_function) {
     // Call a checkpoint function for each thread, threads which are suspend get their checkpoint
     // manually called.
     MutexLock mu(self, *Locks::thread_list_lock_);
+    MutexLock mu2(self, *Locks::thread_suspend_count_lock_);
     for (const auto& thread : list_) {
       if (thread != self) {
-        for (;;) {
-          if (thread->RequestCheckpoint(checkpoint_function)) {
-            // This thread will run it's checkpoint some time in the near future.
-            count++;
-            break;
-          } else {
-            // We are probably suspended, try to make sure that we stay suspended.
-            MutexLock mu2(self, *Locks::thread_suspend_count_lock_);
-            // The thread switched back to runnable.
-            if (thread->GetState() == kRunnable) {
-              continue;
-            }
-            thread->ModifySuspendCount(self, +1, false);
-            suspended_count_modified_threads.push_back(thread);
-            break;
-          }
+        if (thread->RequestCheckpoint(checkpoint_function)) {
+          // This thread will run it's checkpoint some time in the near future.
+          count++;
+        } else {
+          // We are probably suspended, try to make sure that we stay suspended. A runnable thread
+          // with no free checkpoint slot gets suspended at its next suspend point.
+          thread->ModifySuspendCount(self, +1, false);
+          suspended_count_modified_threads.push_back(thread);
         }
       }
     }
@@ -187,23 +208,9 @@ size_t ThreadList::RunCheckpoint(Closure* checkpoint_function) {
 
   // Run the checkpoint on the suspended threads.
   for (const auto& thread : suspended_count_modified_threads) {
-    if (!thread->IsSuspended()) {
-      // Wait until the thread is suspended.
-      uint64_t start = NanoTime();
-      do {
-        // Sleep for 100us.
-        usleep(100);
-      } while (!thread->IsSuspended());
-      uint64_t end = NanoTime();
-      // Shouldn't need to wait for longer than 1 millisecond.
-      const uint64_t threshold = 1;
-      if (NsToMs(end - start) > threshold) {
-        LOG(INFO) << "Warning: waited longer than " << threshold
-                  << " ms for thread suspend\n";
-      }
-    }
+    WaitForSuspension(thread);
     // We know for sure that the thread is suspended at this point.
-    thread->RunCheckpointFunction();
+    checkpoint_function->Run(thread);
     {
       MutexLock mu2(self, *Locks::thread_suspend_count_lock_);
       thread->ModifySuspendCount(self, -1, false);
@@ -221,6 +228,44 @@ size_t ThreadList::RunCheckpoint(Closure* checkpoint_function) {
   return count + suspended_count_modified_threads.size() + 1;
 }
 
+bool ThreadList::RunCheckpointOnThread(uint32_t thin_lock_id, Closure* checkpoint_function) {
+  Thread* self = Thread::Current();
+  if (kIsDebugBuild) {
+    Locks::mutator_lock_->AssertNotExclusiveHeld(self);
+    Locks::thread_list_lock_->AssertNotHeld(self);
+    Locks::thread_suspend_count_lock_->AssertNotHeld(self);
+    CHECK_NE(self->GetState(), kRunnable);
+  }
+  if (thin_lock_id == kInvalidId || thin_lock_id > kMaxThreadId) {
+    return false;
+  }
+
+  Thread* thread;
+  {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    MutexLock mu2(self, *Locks::thread_suspend_count_lock_);
+    // Entries are cleared before their thread leaves the list, which it can't do while we hold the
+    // thread_list_lock_. They are set before the thread joins the list though.
+    thread = threads_by_thin_lock_id_[thin_lock_id - 1];
+    if (thread == NULL || !Contains(thread)) {
+      return false;
+    }
+    DCHECK_NE(thread, self);
+    if (thread->RequestCheckpoint(checkpoint_function)) {
+      return true;
+    }
+    // We are probably suspended, try to make sure that we stay suspended.
+    thread->ModifySuspendCount(self, +1, false);
+  }
+
+  WaitForSuspension(thread);
+  checkpoint_function->Run(thread);
+  MutexLock mu2(self, *Locks::thread_suspend_count_lock_);
+  thread->ModifySuspendCount(self, -1, false);
+  Thread::resume_cond_->Broadcast(self);
+  return true;
+}
+
 void ThreadList::SuspendAll() {
   Thread* self = Thread::Current();
 
@@ -580,6 +625,7 @@ uint32_t ThreadList::AllocThreadId(Thread* self) {
   for (size_t i = 0; i < allocated_ids_.size(); ++i) {
     if (!allocated_ids_[i]) {
       allocated_ids_.set(i);
+      threads_by_thin_lock_id_[i] = self;
       return i + 1;  // Zero is reserved to mean "invalid".
     }
   }
@@ -588,8 +634,16 @@ uint32_t ThreadList::AllocThreadId(Thread* self) {
 }
 
 void ThreadList::ReleaseThreadId(Thread* self, uint32_t id) {
-  MutexLock mu(self, allocated_ids_lock_);
   --id;  // Zero is reserved to mean "invalid".
+  // Once our entry is cleared, wait for the threads which may have read it before, the thread is
+  // freed right after.
+  DCHECK_EQ(threads_by_thin_lock_id_[id], self);
+  threads_by_thin_lock_id_[id] = NULL;
+  ANDROID_MEMBAR_FULL();
+  while (thin_lock_id_readers_.load() != 0) {
+    sched_yield();
+  }
+  MutexLock mu(self, allocated_ids_lock_);
   DCHECK(allocated_ids_[id]) << id;
   allocated_ids_.reset(id);
 }
@@ -604,4 +658,17 @@ Thread* ThreadList::FindThreadByThinLockId(uint32_t thin_lock_id) {
   return NULL;
 }
 
+bool ThreadList::IsRunnable(uint32_t thin_lock_id) {
+  if (thin_lock_id == kInvalidId || thin_lock_id > kMaxThreadId) {
+    return false;
+  }
+  // The increment is a full barrier, an exiting thread either sees us reading or we see its entry
+  // cleared.
+  ++thin_lock_id_readers_;
+  Thread* thread = threads_by_thin_lock_id_[thin_lock_id - 1];
+  bool runnable = thread != NULL && thread->GetState() == kRunnable;
+  --thin_lock_id_readers_;
+  return runnable;
+}
+
 }  // namespace art
@@ -17,8 +17,11 @@
 #ifndef ART_RUNTIME_THREAD_LIST_H_
 #define ART_RUNTIME_THREAD_LIST_H_
 
+#include "atomic_integer.h"
 #include "base/mutex.h"
+#include "mem_map.h"
 #include "root_visitor.h"
+#include "UniquePtr.h"
 
 #include <bitset>
 #include <list>
@@ -65,6 +68,13 @@ class ThreadList {
       LOCKS_EXCLUDED(Locks::thread_list_lock_,
                      Locks::thread_suspend_count_lock_);
 
+  // Run a checkpoint on the thread with the thin lock id only, the other threads keep running. A
+  // runnable thread runs it inside of its next suspend check, so it may not have run yet when this
+  // returns. Returns false if there is no such thread.
+  bool RunCheckpointOnThread(uint32_t thin_lock_id, Closure* checkpoint_function)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_,
+                     Locks::thread_suspend_count_lock_);
+
   // Suspends all threads
   void SuspendAllForDebugger()
       LOCKS_EXCLUDED(Locks::mutator_lock_,
@@ -101,6 +111,10 @@ class ThreadList {
 
   Thread* FindThreadByThinLockId(uint32_t thin_lock_id);
 
+  // Returns true if the thread with the thin lock id is alive and runnable, that is likely to be
+  // running managed code. Lock free, as threads call it when spinning on a lock.
+  bool IsRunnable(uint32_t thin_lock_id);
+
  private:
   uint32_t AllocThreadId(Thread* self);
   void ReleaseThreadId(Thread* self, uint32_t id) LOCKS_EXCLUDED(allocated_ids_lock_);
@@ -125,6 +139,14 @@ class ThreadList {
   mutable Mutex allocated_ids_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   std::bitset<kMaxThreadId> allocated_ids_ GUARDED_BY(allocated_ids_lock_);
 
+  // The threads by thin lock id minus one, set while the id is allocated. Mapped, so that only the
+  // pages of the ids in use get backed.
+  UniquePtr<MemMap> threads_by_thin_lock_id_map_;
+  Thread* volatile* threads_by_thin_lock_id_;
+  // Number of threads reading threads_by_thin_lock_id_. A thread clearing its entry waits for it
+  // to drop to zero, after which nobody can still be reading the thread.
+  AtomicInteger thin_lock_id_readers_;
+
   // The actual list of all threads.
   std::list<Thread*> list_ GUARDED_BY(Locks::thread_list_lock_);
 
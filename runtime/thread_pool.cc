@@ -56,6 +56,8 @@ void* ThreadPoolWorker::Callback(void* arg) {
   ThreadPoolWorker* worker = reinterpret_cast<ThreadPoolWorker*>(arg);
   Runtime* runtime = Runtime::Current();
   CHECK(runtime->AttachCurrentThread(worker->name_.c_str(), true, NULL, false));
+  // Between tasks the worker refers to no objects, tasks which do become runnable first.
+  Thread::Current()->SetAtMovingGcSafePoint(true);
   // Do work until its time to shut down.
   worker->Run();
   runtime->DetachCurrentThread();
@@ -35,10 +35,10 @@ std::string ThrowLocation::Dump() const {
 
 void ThrowLocation::VisitRoots(RootVisitor* visitor, void* arg) {
   if (this_object_ != NULL) {
-    visitor(this_object_, arg);
+    this_object_ = visitor(this_object_, arg);
   }
   if (method_ != NULL) {
-    visitor(method_, arg);
+    method_ = down_cast<mirror::ArtMethod*>(visitor(method_, arg));
   }
 }
 
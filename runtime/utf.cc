@@ -84,6 +84,14 @@ int32_t ComputeUtf16Hash(const uint16_t* chars, size_t char_count) {
   return hash;
 }
 
+size_t ComputeModifiedUtf8Hash(const char* chars) {
+  size_t hash = 0;
+  for (; *chars != '\0'; ++chars) {
+    hash = hash * 31 + *chars;
+  }
+  return hash;
+}
+
 
 uint16_t GetUtf16FromUtf8(const char** utf8_data_in) {
   uint8_t one = *(*utf8_data_in)++;
@@ -76,6 +76,12 @@ int32_t ComputeUtf16Hash(const mirror::CharArray* chars, int32_t offset, size_t
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 int32_t ComputeUtf16Hash(const uint16_t* chars, size_t char_count);
 
+/*
+ * The same algorithm applied to the bytes of a Modified UTF-8 string, used to hash class
+ * descriptors. This is for convenience, not interoperability with java.lang.String.
+ */
+size_t ComputeModifiedUtf8Hash(const char* chars);
+
 /*
  * Retrieve the next UTF-16 character from a UTF-8 string.
  *
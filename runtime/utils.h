@@ -153,6 +153,16 @@ static inline int CountOneBits(uint32_t x) {
   return static_cast<int>(x & 0x0000003F);
 }
 
+// Mixes a hash code which is poorly distributed in its low bits, such as a string hash code, for
+// use as the index of a power of two sized table. This is the 32-bit finalizer of MurmurHash3
+// without its last multiplication.
+static inline uint32_t MixHash(uint32_t hash) {
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6b;
+  hash ^= hash >> 13;
+  return hash;
+}
+
 #define CLZ(x) __builtin_clz(x)
 #define CTZ(x) __builtin_ctz(x)
 
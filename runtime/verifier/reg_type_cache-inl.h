@@ -36,8 +36,13 @@ Type* RegTypeCache::CreatePrimitiveTypeInstance(const std::string& descriptor) {
 }
 
 inline const art::verifier::RegType& RegTypeCache::GetFromId(uint16_t id) const {
-  DCHECK_LT(id, entries_.size());
-  RegType* result = entries_[id];
+  RegType* result;
+  if (id >= kSharedIdBase) {
+    result = shared_entries_[id - kSharedIdBase];
+  } else {
+    DCHECK_LT(id, entries_.size());
+    result = entries_[id];
+  }
   DCHECK(result != NULL);
   return *result;
 }
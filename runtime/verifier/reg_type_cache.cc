@@ -21,6 +21,7 @@
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
 #include "object_utils.h"
+#include "utils.h"
 
 namespace art {
 namespace verifier {
@@ -28,8 +29,13 @@ namespace verifier {
 bool RegTypeCache::primitive_initialized_ = false;
 uint16_t RegTypeCache::primitive_start_ = 0;
 uint16_t RegTypeCache::primitive_count_ = 0;
+ReaderWriterMutex* RegTypeCache::shared_lock_ = NULL;
+RegType** RegTypeCache::shared_entries_ = NULL;
+size_t RegTypeCache::shared_count_ = 0;
+RegTypeCache::SharedClassMap* RegTypeCache::shared_by_class_[2] = { NULL, NULL };
+RegTypeCache::SharedDescriptorMap* RegTypeCache::shared_by_descriptor_[2] = { NULL, NULL };
 
-static bool MatchingPrecisionForClass(RegType* entry, bool precise)
+static bool MatchingPrecisionForClass(const RegType* entry, bool precise)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   if (entry->IsPreciseReference() == precise) {
     // We were or weren't looking for a precise reference and we found what we need.
@@ -157,14 +163,152 @@ void RegTypeCache::ClearException() {
   }
 }
 
+void* RegTypeCache::AllocateEntry(size_t size) {
+  size = RoundUp(size, 8);
+  if (static_cast<size_t>(arena_end_ - arena_pos_) < size) {
+    size_t block_size = kArenaBlockSize;
+    if (size > block_size) {
+      block_size = size;
+    }
+    arena_pos_ = new uint8_t[block_size];
+    arena_end_ = arena_pos_ + block_size;
+    arena_blocks_.push_back(arena_pos_);
+  }
+  void* result = arena_pos_;
+  arena_pos_ += size;
+  return result;
+}
+
+void RegTypeCache::AddEntry(RegType* entry) {
+  DCHECK_EQ(entry->GetId(), entries_.size());
+  CHECK(entries_.size() < kSharedIdBase) << "Too many types in the verifier's cache";
+  entries_.push_back(entry);
+}
+
+void RegTypeCache::CreateSharedTypes() {
+  shared_lock_ = new ReaderWriterMutex("verifier shared types lock");
+  shared_entries_ = new RegType*[kMaxSharedTypes];
+  shared_count_ = 0;
+  for (size_t i = 0; i < 2; ++i) {
+    shared_by_class_[i] = new SharedClassMap;
+    shared_by_descriptor_[i] = new SharedDescriptorMap;
+  }
+}
+
+const RegType* RegTypeCache::FindSharedByClass(mirror::Class* klass, bool precise) {
+  SharedClassMap::const_iterator it = shared_by_class_[precise]->find(klass);
+  if (it != shared_by_class_[precise]->end()) {
+    return shared_entries_[it->second - kSharedIdBase];
+  }
+  // Like MatchingPrecisionForClass, a precise type also answers for an imprecise one when the
+  // class has no other instances.
+  if (!precise && klass->CannotBeAssignedFromOtherTypes()) {
+    it = shared_by_class_[true]->find(klass);
+    if (it != shared_by_class_[true]->end()) {
+      return shared_entries_[it->second - kSharedIdBase];
+    }
+  }
+  return NULL;
+}
+
+const RegType* RegTypeCache::FindSharedByDescriptor(const char* descriptor, bool precise) {
+  ReaderMutexLock mu(Thread::Current(), *shared_lock_);
+  SharedDescriptorMap::const_iterator it = shared_by_descriptor_[precise]->find(descriptor);
+  if (it != shared_by_descriptor_[precise]->end()) {
+    return shared_entries_[it->second - kSharedIdBase];
+  }
+  if (!precise) {
+    it = shared_by_descriptor_[true]->find(descriptor);
+    if (it != shared_by_descriptor_[true]->end()) {
+      RegType* entry = shared_entries_[it->second - kSharedIdBase];
+      if (entry->GetClass()->CannotBeAssignedFromOtherTypes()) {
+        return entry;
+      }
+    }
+  }
+  return NULL;
+}
+
+const RegType& RegTypeCache::SharedReference(mirror::Class* klass, const std::string& descriptor,
+                                             bool precise) {
+  DCHECK(klass->GetClassLoader() == NULL);
+  Thread* self = Thread::Current();
+  bool full;
+  {
+    ReaderMutexLock mu(self, *shared_lock_);
+    const RegType* entry = FindSharedByClass(klass, precise);
+    if (entry != NULL) {
+      return *entry;
+    }
+    // Types are never removed, a full table stays full.
+    full = shared_count_ == kMaxSharedTypes;
+  }
+  if (!full) {
+    WriterMutexLock mu(self, *shared_lock_);
+    // Another verifier may have created the type since we looked.
+    const RegType* existing = FindSharedByClass(klass, precise);
+    if (existing != NULL) {
+      return *existing;
+    }
+    if (shared_count_ < kMaxSharedTypes) {
+      uint16_t id = kSharedIdBase + shared_count_;
+      RegType* entry;
+      if (precise) {
+        entry = new PreciseReferenceType(klass, descriptor, id);
+      } else {
+        entry = new ReferenceType(klass, descriptor, id);
+      }
+      shared_entries_[shared_count_] = entry;
+      shared_count_++;
+      shared_by_class_[precise]->Put(klass, id);
+      // The key points into the type's own copy of the descriptor, which lives as long as the
+      // map.
+      shared_by_descriptor_[precise]->insert(std::make_pair(StringPiece(entry->descriptor_), id));
+      return *entry;
+    }
+  }
+  // Nowhere left to put it, keep the type to this cache instead, made once like the types of app
+  // classes.
+  for (size_t i = primitive_count_; i < entries_.size(); i++) {
+    RegType* cur_entry = entries_[i];
+    if ((cur_entry->IsReference() || cur_entry->IsPreciseReference()) &&
+        cur_entry->GetClass() == klass && MatchingPrecisionForClass(cur_entry, precise)) {
+      return *cur_entry;
+    }
+  }
+  RegType* entry;
+  if (precise) {
+    entry = new (AllocateEntry(sizeof(PreciseReferenceType)))
+        PreciseReferenceType(klass, descriptor, entries_.size());
+  } else {
+    entry = new (AllocateEntry(sizeof(ReferenceType)))
+        ReferenceType(klass, descriptor, entries_.size());
+  }
+  AddEntry(entry);
+  return *entry;
+}
+
 const RegType& RegTypeCache::From(mirror::ClassLoader* loader, const char* descriptor,
                                   bool precise) {
+  // Boot classes are shared by all caches, look there first.
+  if (loader == NULL) {
+    const RegType* shared = FindSharedByDescriptor(descriptor, precise);
+    if (shared != NULL) {
+      return *shared;
+    }
+  }
   // Try looking up the class in the cache first.
   for (size_t i = primitive_count_; i < entries_.size(); i++) {
     if (MatchDescriptor(i, descriptor, precise)) {
       return *(entries_[i]);
     }
   }
+  for (size_t i = 0; i < boot_types_seen_.size(); i++) {
+    const RegType* entry = boot_types_seen_[i];
+    if (entry->descriptor_ == descriptor && MatchingPrecisionForClass(entry, precise)) {
+      return *entry;
+    }
+  }
   // Class not found in the cache, will create a new type for that.
   // Try resolving class.
   mirror::Class* klass = ResolveClass(descriptor, loader);
@@ -179,22 +323,35 @@ const RegType& RegTypeCache::From(mirror::ClassLoader* loader, const char* descr
     // 2- Precise Flag passed as true.
     RegType* entry;
     // Create an imprecise type if we can't tell for a fact that it is precise.
-    if (klass->CannotBeAssignedFromOtherTypes() || precise) {
+    bool precise_type = klass->CannotBeAssignedFromOtherTypes() || precise;
+    if (precise_type) {
       DCHECK(!(klass->IsAbstract()) || klass->IsArrayClass());
       DCHECK(!klass->IsInterface());
-      entry = new PreciseReferenceType(klass, descriptor, entries_.size());
+    }
+    if (klass->GetClassLoader() == NULL) {
+      const RegType& shared = SharedReference(klass, descriptor, precise_type);
+      if (loader != NULL) {
+        boot_types_seen_.push_back(&shared);
+      }
+      return shared;
+    }
+    if (precise_type) {
+      entry = new (AllocateEntry(sizeof(PreciseReferenceType)))
+          PreciseReferenceType(klass, descriptor, entries_.size());
     } else {
-      entry = new ReferenceType(klass, descriptor, entries_.size());
+      entry = new (AllocateEntry(sizeof(ReferenceType)))
+          ReferenceType(klass, descriptor, entries_.size());
     }
-    entries_.push_back(entry);
+    AddEntry(entry);
     return *entry;
   } else {  // Class not resolved.
     // We tried loading the class and failed, this might get an exception raised
     // so we want to clear it before we go on.
     ClearException();
     if (IsValidDescriptor(descriptor)) {
-      RegType* entry = new UnresolvedReferenceType(descriptor, entries_.size());
-      entries_.push_back(entry);
+      RegType* entry = new (AllocateEntry(sizeof(UnresolvedReferenceType)))
+          UnresolvedReferenceType(descriptor, entries_.size());
+      AddEntry(entry);
       return *entry;
     } else {
       // The descriptor is broken return the unknown type as there's nothing sensible that
@@ -209,6 +366,8 @@ const RegType& RegTypeCache::FromClass(const char* descriptor, mirror::Class* kl
     // Note: precise isn't used for primitive classes. A char is assignable to an int. All
     // primitive classes are final.
     return RegTypeFromPrimitiveType(klass->GetPrimitiveType());
+  } else if (klass->GetClassLoader() == NULL) {
+    return SharedReference(klass, descriptor, precise);
   } else {
     // Look for the reference in the list of entries to have.
     for (size_t i = primitive_count_; i < entries_.size(); i++) {
@@ -220,25 +379,26 @@ const RegType& RegTypeCache::FromClass(const char* descriptor, mirror::Class* kl
     // No reference to the class was found, create new reference.
     RegType* entry;
     if (precise) {
-      entry = new PreciseReferenceType(klass, descriptor, entries_.size());
+      entry = new (AllocateEntry(sizeof(PreciseReferenceType)))
+          PreciseReferenceType(klass, descriptor, entries_.size());
     } else {
-      entry = new ReferenceType(klass, descriptor, entries_.size());
+      entry = new (AllocateEntry(sizeof(ReferenceType)))
+          ReferenceType(klass, descriptor, entries_.size());
     }
-    entries_.push_back(entry);
+    AddEntry(entry);
     return *entry;
   }
 }
 
 RegTypeCache::~RegTypeCache() {
   CHECK_LE(primitive_count_, entries_.size());
-  // Delete only the non primitive types.
-  if (entries_.size() == kNumPrimitives) {
-    // All entries are primitive, nothing to delete.
-    return;
-  }
-  std::vector<RegType*>::iterator non_primitive_begin = entries_.begin();
-  std::advance(non_primitive_begin, kNumPrimitives);
-  STLDeleteContainerPointers(non_primitive_begin, entries_.end());
+  // Destroy only the non primitive types, their memory goes with the arena.
+  for (size_t i = kNumPrimitives; i < entries_.size(); i++) {
+    entries_[i]->~RegType();
+  }
+  for (size_t i = 0; i < arena_blocks_.size(); i++) {
+    delete[] arena_blocks_[i];
+  }
 }
 
 void RegTypeCache::ShutDown() {
@@ -255,6 +415,20 @@ void RegTypeCache::ShutDown() {
     FloatType::Destroy();
     DoubleLoType::Destroy();
     DoubleHiType::Destroy();
+    for (size_t i = 0; i < 2; ++i) {
+      delete shared_by_class_[i];
+      shared_by_class_[i] = NULL;
+      delete shared_by_descriptor_[i];
+      shared_by_descriptor_[i] = NULL;
+    }
+    for (size_t i = 0; i < shared_count_; ++i) {
+      delete shared_entries_[i];
+    }
+    delete[] shared_entries_;
+    shared_entries_ = NULL;
+    shared_count_ = 0;
+    delete shared_lock_;
+    shared_lock_ = NULL;
     RegTypeCache::primitive_initialized_ = false;
     RegTypeCache::primitive_count_ = 0;
   }
@@ -302,8 +476,9 @@ const RegType& RegTypeCache::FromUnresolvedMerge(const RegType& left, const RegT
     }
   }
   // Create entry.
-  RegType* entry = new UnresolvedMergedType(left.GetId(), right.GetId(), this, entries_.size());
-  entries_.push_back(entry);
+  RegType* entry = new (AllocateEntry(sizeof(UnresolvedMergedType)))
+      UnresolvedMergedType(left.GetId(), right.GetId(), this, entries_.size());
+  AddEntry(entry);
   if (kIsDebugBuild) {
     UnresolvedMergedType* tmp_entry = down_cast<UnresolvedMergedType*>(entry);
     std::set<uint16_t> check_types = tmp_entry->GetMergedTypes();
@@ -326,8 +501,9 @@ const RegType& RegTypeCache::FromUnresolvedSuperClass(const RegType& child) {
       }
     }
   }
-  RegType* entry = new UnresolvedSuperClass(child.GetId(), this, entries_.size());
-  entries_.push_back(entry);
+  RegType* entry = new (AllocateEntry(sizeof(UnresolvedSuperClass)))
+      UnresolvedSuperClass(child.GetId(), this, entries_.size());
+  AddEntry(entry);
   return *entry;
 }
 
@@ -344,7 +520,8 @@ const RegType& RegTypeCache::Uninitialized(const RegType& type, uint32_t allocat
         return *cur_entry;
       }
     }
-    entry = new UnresolvedUninitializedRefType(descriptor, allocation_pc, entries_.size());
+    entry = new (AllocateEntry(sizeof(UnresolvedUninitializedRefType)))
+        UnresolvedUninitializedRefType(descriptor, allocation_pc, entries_.size());
   } else {
     mirror::Class* klass = type.GetClass();
     for (size_t i = primitive_count_; i < entries_.size(); i++) {
@@ -356,9 +533,10 @@ const RegType& RegTypeCache::Uninitialized(const RegType& type, uint32_t allocat
         return *cur_entry;
       }
     }
-    entry = new UninitializedReferenceType(klass, descriptor, allocation_pc, entries_.size());
+    entry = new (AllocateEntry(sizeof(UninitializedReferenceType)))
+        UninitializedReferenceType(klass, descriptor, allocation_pc, entries_.size());
   }
-  entries_.push_back(entry);
+  AddEntry(entry);
   return *entry;
 }
 
@@ -374,33 +552,41 @@ const RegType& RegTypeCache::FromUninitialized(const RegType& uninit_type) {
         return *cur_entry;
       }
     }
-    entry = new UnresolvedReferenceType(descriptor.c_str(), entries_.size());
+    entry = new (AllocateEntry(sizeof(UnresolvedReferenceType)))
+        UnresolvedReferenceType(descriptor.c_str(), entries_.size());
   } else {
     mirror::Class* klass = uninit_type.GetClass();
     if (uninit_type.IsUninitializedThisReference() && !klass->IsFinal()) {
       // For uninitialized "this reference" look for reference types that are not precise.
+      if (klass->GetClassLoader() == NULL) {
+        return SharedReference(klass, uninit_type.GetDescriptor(), false);
+      }
       for (size_t i = primitive_count_; i < entries_.size(); i++) {
         RegType* cur_entry = entries_[i];
         if (cur_entry->IsReference() && cur_entry->GetClass() == klass) {
           return *cur_entry;
         }
       }
-      entry = new ReferenceType(klass, "", entries_.size());
+      entry = new (AllocateEntry(sizeof(ReferenceType))) ReferenceType(klass, "", entries_.size());
     } else if (klass->IsInstantiable()) {
       // We're uninitialized because of allocation, look or create a precise type as allocations
       // may only create objects of that type.
+      if (klass->GetClassLoader() == NULL) {
+        return SharedReference(klass, uninit_type.GetDescriptor(), true);
+      }
       for (size_t i = primitive_count_; i < entries_.size(); i++) {
         RegType* cur_entry = entries_[i];
         if (cur_entry->IsPreciseReference() && cur_entry->GetClass() == klass) {
           return *cur_entry;
         }
       }
-      entry = new PreciseReferenceType(klass, uninit_type.GetDescriptor(), entries_.size());
+      entry = new (AllocateEntry(sizeof(PreciseReferenceType)))
+          PreciseReferenceType(klass, uninit_type.GetDescriptor(), entries_.size());
     } else {
       return Conflict();
     }
   }
-  entries_.push_back(entry);
+  AddEntry(entry);
   return *entry;
 }
 
@@ -427,7 +613,8 @@ const RegType& RegTypeCache::UninitializedThisArgument(const RegType& type) {
         return *cur_entry;
       }
     }
-    entry = new UnresolvedUninitializedThisRefType(descriptor, entries_.size());
+    entry = new (AllocateEntry(sizeof(UnresolvedUninitializedThisRefType)))
+        UnresolvedUninitializedThisRefType(descriptor, entries_.size());
   } else {
     mirror::Class* klass = type.GetClass();
     for (size_t i = primitive_count_; i < entries_.size(); i++) {
@@ -436,9 +623,10 @@ const RegType& RegTypeCache::UninitializedThisArgument(const RegType& type) {
         return *cur_entry;
       }
     }
-    entry = new UninitializedThisReferenceType(klass, descriptor, entries_.size());
+    entry = new (AllocateEntry(sizeof(UninitializedThisReferenceType)))
+        UninitializedThisReferenceType(klass, descriptor, entries_.size());
   }
-  entries_.push_back(entry);
+  AddEntry(entry);
   return *entry;
 }
 
@@ -453,11 +641,12 @@ const RegType& RegTypeCache::FromCat1Const(int32_t value, bool precise) {
   }
   RegType* entry;
   if (precise) {
-    entry = new PreciseConstType(value, entries_.size());
+    entry = new (AllocateEntry(sizeof(PreciseConstType))) PreciseConstType(value, entries_.size());
   } else {
-    entry = new ImpreciseConstType(value, entries_.size());
+    entry = new (AllocateEntry(sizeof(ImpreciseConstType)))
+        ImpreciseConstType(value, entries_.size());
   }
-  entries_.push_back(entry);
+  AddEntry(entry);
   return *entry;
 }
 
@@ -471,11 +660,13 @@ const RegType& RegTypeCache::FromCat2ConstLo(int32_t value, bool precise) {
   }
   RegType* entry;
   if (precise) {
-    entry = new PreciseConstLoType(value, entries_.size());
+    entry = new (AllocateEntry(sizeof(PreciseConstLoType)))
+        PreciseConstLoType(value, entries_.size());
   } else {
-    entry = new ImpreciseConstLoType(value, entries_.size());
+    entry = new (AllocateEntry(sizeof(ImpreciseConstLoType)))
+        ImpreciseConstLoType(value, entries_.size());
   }
-  entries_.push_back(entry);
+  AddEntry(entry);
   return *entry;
 }
 
@@ -489,11 +680,13 @@ const RegType& RegTypeCache::FromCat2ConstHi(int32_t value, bool precise) {
   }
   RegType* entry;
   if (precise) {
-    entry = new PreciseConstHiType(value, entries_.size());
+    entry = new (AllocateEntry(sizeof(PreciseConstHiType)))
+        PreciseConstHiType(value, entries_.size());
   } else {
-    entry = new ImpreciseConstHiType(value, entries_.size());
+    entry = new (AllocateEntry(sizeof(ImpreciseConstHiType)))
+        ImpreciseConstHiType(value, entries_.size());
   }
-  entries_.push_back(entry);
+  AddEntry(entry);
   return *entry;
 }
 
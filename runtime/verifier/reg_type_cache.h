@@ -19,11 +19,15 @@
 
 #include "base/casts.h"
 #include "base/macros.h"
+#include "base/mutex.h"
 #include "base/stl_util.h"
+#include "base/stringpiece.h"
 #include "reg_type.h"
 #include "runtime.h"
+#include "safe_map.h"
 
 #include <stdint.h>
+#include <map>
 #include <vector>
 
 namespace art {
@@ -36,9 +40,16 @@ namespace verifier {
 class RegType;
 
 const size_t kNumPrimitives = 12;
+
+// The types a method verifier works with. Primitive types and the reference types of classes in
+// the boot class path are created once and shared by every cache, on every thread; a cache only
+// creates the types that are particular to its method, such as constants, uninitialized and
+// unresolved types, and references to classes from other class loaders. Those come from an arena
+// owned by the cache.
 class RegTypeCache {
  public:
-  explicit RegTypeCache(bool can_load_classes) : can_load_classes_(can_load_classes) {
+  explicit RegTypeCache(bool can_load_classes)
+      : can_load_classes_(can_load_classes), arena_pos_(NULL), arena_end_(NULL) {
     entries_.reserve(64);
     FillPrimitiveTypes();
   }
@@ -48,6 +59,7 @@ class RegTypeCache {
       CHECK_EQ(RegTypeCache::primitive_count_, 0);
       CreatePrimitiveTypes();
       CHECK_EQ(RegTypeCache::primitive_count_, kNumPrimitives);
+      CreateSharedTypes();
       RegTypeCache::primitive_initialized_ = true;
     }
   }
@@ -145,13 +157,53 @@ class RegTypeCache {
   const RegType& RegTypeFromPrimitiveType(Primitive::Type) const;
 
  private:
+  // The ids of shared types start here, the types local to a cache are numbered below it.
+  static const uint16_t kSharedIdBase = 0x8000;
+  static const size_t kMaxSharedTypes = 0x8000;
+  static const size_t kArenaBlockSize = 4 * KB;
+
   std::vector<RegType*> entries_;
   static bool primitive_initialized_;
   static uint16_t primitive_start_;
   static uint16_t primitive_count_;
   static void CreatePrimitiveTypes() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // The shared reference types of boot classes. Entries are only ever added, and a type is only
+  // handed out after it was published under shared_lock_, so GetFromId reads them without it.
+  static ReaderWriterMutex* shared_lock_;
+  static RegType** shared_entries_;
+  static size_t shared_count_ GUARDED_BY(shared_lock_);
+  // The shared types by class and by descriptor, indexed by whether the type is precise.
+  typedef SafeMap<const mirror::Class*, uint16_t> SharedClassMap;
+  typedef std::map<StringPiece, uint16_t> SharedDescriptorMap;
+  static SharedClassMap* shared_by_class_[2] GUARDED_BY(shared_lock_);
+  static SharedDescriptorMap* shared_by_descriptor_[2] GUARDED_BY(shared_lock_);
+  static void CreateSharedTypes();
+  static const RegType* FindSharedByClass(mirror::Class* klass, bool precise)
+      SHARED_LOCKS_REQUIRED(shared_lock_, Locks::mutator_lock_);
+  static const RegType* FindSharedByDescriptor(const char* descriptor, bool precise)
+      LOCKS_EXCLUDED(shared_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Returns the shared reference type of a boot class, creating it if it doesn't exist yet.
+  const RegType& SharedReference(mirror::Class* klass, const std::string& descriptor,
+                                 bool precise)
+      LOCKS_EXCLUDED(shared_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Shared types this cache resolved through a class loader, so that looking them up again by
+  // descriptor doesn't go back to the class linker.
+  std::vector<const RegType*> boot_types_seen_;
+
   // Whether or not we're allowed to load classes.
   const bool can_load_classes_;
+
+  // Memory for the types local to this cache, which are destroyed along with it.
+  void* AllocateEntry(size_t size);
+  void AddEntry(RegType* entry);
+  std::vector<uint8_t*> arena_blocks_;
+  uint8_t* arena_pos_;
+  uint8_t* arena_end_;
+
   mirror::Class* ResolveClass(const char* descriptor, mirror::ClassLoader* loader)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void ClearException();
@@ -448,6 +448,28 @@ TEST_F(RegTypeReferenceTest, JavalangObject) {
   EXPECT_TRUE(ref_type_3.Equals(ref_type_2));
   EXPECT_EQ(ref_type.GetId(), ref_type_3.GetId());
 }
+TEST_F(RegTypeReferenceTest, SharedBootTypes) {
+  // Types of boot classes are shared by all caches, other types belong to the cache that made
+  // them.
+  ScopedObjectAccess soa(Thread::Current());
+  RegTypeCache cache_1(true);
+  RegTypeCache cache_2(true);
+  const RegType& string_1 = cache_1.JavaLangString();
+  const RegType& string_2 = cache_2.FromDescriptor(NULL, "Ljava/lang/String;", false);
+  EXPECT_EQ(&string_1, &string_2);
+  EXPECT_TRUE(string_2.IsPreciseReference());
+  const RegType& object_1 = cache_1.JavaLangObject(false);
+  const RegType& object_2 = cache_2.FromClass("Ljava/lang/Object;", object_1.GetClass(), false);
+  EXPECT_EQ(&object_1, &object_2);
+  EXPECT_TRUE(object_1.Equals(cache_2.GetFromId(object_2.GetId())));
+  EXPECT_FALSE(object_1.Equals(cache_2.JavaLangObject(true)));
+
+  const RegType& unresolved_1 = cache_1.FromDescriptor(NULL, "Ljava/lang/DoesNotExist;", true);
+  const RegType& unresolved_2 = cache_2.FromDescriptor(NULL, "Ljava/lang/DoesNotExist;", true);
+  EXPECT_NE(&unresolved_1, &unresolved_2);
+  EXPECT_EQ(cache_1.GetCacheSize(), cache_2.GetCacheSize());
+}
+
 TEST_F(RegTypeReferenceTest, Merging) {
   // Tests merging logic
   // String and object , LUB is object.
@@ -24,6 +24,7 @@
 #include <unistd.h>
 
 #include "base/unix_file/fd_file.h"
+#include "utils.h"
 #include "UniquePtr.h"
 
 namespace art {
@@ -129,17 +130,14 @@ off64_t ZipEntry::GetDataOffset() {
 
 static bool CopyFdToMemory(uint8_t* begin, size_t size, int in, size_t count) {
   uint8_t* dst = begin;
-  std::vector<uint8_t> buf(kBufSize);
   while (count != 0) {
-    size_t bytes_to_read = (count > kBufSize) ? kBufSize : count;
-    ssize_t actual = TEMP_FAILURE_RETRY(read(in, &buf[0], bytes_to_read));
-    if (actual != static_cast<ssize_t>(bytes_to_read)) {
+    ssize_t actual = TEMP_FAILURE_RETRY(read(in, dst, count));
+    if (actual <= 0) {
       PLOG(WARNING) << "Zip: short read";
       return false;
     }
-    memcpy(dst, &buf[0], bytes_to_read);
-    dst += bytes_to_read;
-    count -= bytes_to_read;
+    dst += actual;
+    count -= actual;
   }
   DCHECK_EQ(dst, begin + size);
   return true;
@@ -171,17 +169,16 @@ class ZStream {
   z_stream zstream_;
 };
 
+// Inflates straight into the destination, only the compressed data goes through a buffer.
 static bool InflateToMemory(uint8_t* begin, size_t size,
                             int in, size_t uncompressed_length, size_t compressed_length) {
-  uint8_t* dst = begin;
   UniquePtr<uint8_t[]> read_buf(new uint8_t[kBufSize]);
-  UniquePtr<uint8_t[]> write_buf(new uint8_t[kBufSize]);
-  if (read_buf.get() == NULL || write_buf.get() == NULL) {
+  if (read_buf.get() == NULL) {
     LOG(WARNING) << "Zip: failed to allocate buffer to inflate";
     return false;
   }
 
-  UniquePtr<ZStream> zstream(new ZStream(write_buf.get(), kBufSize));
+  UniquePtr<ZStream> zstream(new ZStream(begin, size));
 
   // Use the undocumented "negative window bits" feature to tell zlib
   // that there's no zlib header waiting for it.
@@ -201,17 +198,17 @@ static bool InflateToMemory(uint8_t* begin, size_t size,
     if (zstream->Get().avail_in == 0) {
       size_t bytes_to_read = (remaining > kBufSize) ? kBufSize : remaining;
 
-        ssize_t actual = TEMP_FAILURE_RETRY(read(in, read_buf.get(), bytes_to_read));
-        if (actual != static_cast<ssize_t>(bytes_to_read)) {
-          LOG(WARNING) << "Zip: inflate read failed (" << actual << " vs " << bytes_to_read << ")";
-          return false;
-        }
-        remaining -= bytes_to_read;
-        zstream->Get().next_in = read_buf.get();
-        zstream->Get().avail_in = bytes_to_read;
+      ssize_t actual = TEMP_FAILURE_RETRY(read(in, read_buf.get(), bytes_to_read));
+      if (actual != static_cast<ssize_t>(bytes_to_read)) {
+        LOG(WARNING) << "Zip: inflate read failed (" << actual << " vs " << bytes_to_read << ")";
+        return false;
+      }
+      remaining -= bytes_to_read;
+      zstream->Get().next_in = read_buf.get();
+      zstream->Get().avail_in = bytes_to_read;
     }
 
-    // uncompress the data
+    // uncompress the data, running out of room in the destination is an error
     zerr = inflate(&zstream->Get(), Z_NO_FLUSH);
     if (zerr != Z_OK && zerr != Z_STREAM_END) {
       LOG(WARNING) << "Zip: inflate zerr=" << zerr
@@ -222,16 +219,6 @@ static bool InflateToMemory(uint8_t* begin, size_t size,
                    << ")";
       return false;
     }
-
-    // write when we're full or when we're done
-    if (zstream->Get().avail_out == 0 ||
-        (zerr == Z_STREAM_END && zstream->Get().avail_out != kBufSize)) {
-      size_t bytes_to_write = zstream->Get().next_out - write_buf.get();
-      memcpy(dst, write_buf.get(), bytes_to_write);
-      dst += bytes_to_write;
-      zstream->Get().next_out = write_buf.get();
-      zstream->Get().avail_out = kBufSize;
-    }
   } while (zerr == Z_OK);
 
   DCHECK_EQ(zerr, Z_STREAM_END);  // other errors should've been caught
@@ -243,7 +230,7 @@ static bool InflateToMemory(uint8_t* begin, size_t size,
     return false;
   }
 
-  DCHECK_EQ(dst, begin + size);
+  DCHECK_EQ(zstream->Get().next_out, begin + size);
   return true;
 }
 
@@ -315,6 +302,30 @@ MemMap* ZipEntry::ExtractToMemMap(const char* entry_filename) {
   return map.release();
 }
 
+MemMap* ZipEntry::MapDirectlyFromFile(const char* entry_filename) {
+  uint32_t length = GetUncompressedLength();
+  if (GetCompressionMethod() != kCompressStored || length == 0) {
+    return NULL;
+  }
+  off64_t data_offset = GetDataOffset();
+  if (data_offset == -1) {
+    LOG(WARNING) << "Zip: data_offset=" << data_offset;
+    return NULL;
+  }
+  // The mapping starts at the same offset within a page as the data does in the file.
+  if (!IsAligned<4>(data_offset)) {
+    VLOG(startup) << "Zip: '" << entry_filename << "' is stored at unaligned offset "
+                  << data_offset << ", extracting it instead";
+    return NULL;
+  }
+  MemMap* map = MemMap::MapFile(length, PROT_READ, MAP_PRIVATE, zip_archive_->fd_, data_offset);
+  if (map == NULL) {
+    LOG(WARNING) << "Zip: failed to map '" << entry_filename << "' from the archive";
+    return NULL;
+  }
+  return map;
+}
+
 static void SetCloseOnExec(int fd) {
   // This dance is more portable than Linux's O_CLOEXEC open(2) flag.
   int flags = fcntl(fd, F_GETFD);
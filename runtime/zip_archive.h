@@ -39,6 +39,10 @@ class ZipEntry {
   bool ExtractToFile(File& file);
   bool ExtractToMemory(uint8_t* begin, size_t size);
   MemMap* ExtractToMemMap(const char* entry_filename);
+  // Maps a stored entry read-only straight from the archive, so that it shares the page cache
+  // with the file instead of taking a private copy. Returns NULL if the entry is compressed or
+  // its data isn't word aligned in the file, callers then fall back to ExtractToMemMap.
+  MemMap* MapDirectlyFromFile(const char* entry_filename);
 
   uint32_t GetUncompressedLength();
   uint32_t GetCrc32();
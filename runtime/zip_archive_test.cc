@@ -20,6 +20,9 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <string>
+#include <vector>
+
 #include "UniquePtr.h"
 #include "common_test.h"
 #include "os.h"
@@ -57,4 +60,120 @@ TEST_F(ZipArchiveTest, FindAndExtract) {
   EXPECT_EQ(zip_entry->GetCrc32(), computed_crc);
 }
 
+static void PutLe16(std::vector<uint8_t>* out, uint16_t value) {
+  out->push_back(value & 0xff);
+  out->push_back(value >> 8);
+}
+
+static void PutLe32(std::vector<uint8_t>* out, uint32_t value) {
+  PutLe16(out, value & 0xffff);
+  PutLe16(out, value >> 16);
+}
+
+// Writes an archive with the single stored entry name, whose data starts padding bytes later than
+// it would without an extra field.
+static void WriteStoredZip(int fd, const std::string& name, const std::vector<uint8_t>& data,
+                           uint16_t padding) {
+  uint32_t crc = crc32(crc32(0L, Z_NULL, 0), &data[0], data.size());
+  std::vector<uint8_t> zip;
+  PutLe32(&zip, ZipArchive::kLFHSignature);
+  PutLe16(&zip, 10);  // version needed
+  PutLe16(&zip, 0);  // flags
+  PutLe16(&zip, 0);  // stored
+  PutLe32(&zip, 0);  // modification time and date
+  PutLe32(&zip, crc);
+  PutLe32(&zip, data.size());
+  PutLe32(&zip, data.size());
+  PutLe16(&zip, name.size());
+  PutLe16(&zip, padding);
+  zip.insert(zip.end(), name.begin(), name.end());
+  zip.insert(zip.end(), padding, 0);
+  zip.insert(zip.end(), data.begin(), data.end());
+
+  uint32_t dir_offset = zip.size();
+  PutLe32(&zip, ZipArchive::kCDESignature);
+  PutLe16(&zip, 10);  // version made by
+  PutLe16(&zip, 10);  // version needed
+  PutLe16(&zip, 0);  // flags
+  PutLe16(&zip, 0);  // stored
+  PutLe32(&zip, 0);  // modification time and date
+  PutLe32(&zip, crc);
+  PutLe32(&zip, data.size());
+  PutLe32(&zip, data.size());
+  PutLe16(&zip, name.size());
+  PutLe16(&zip, 0);  // extra length
+  PutLe16(&zip, 0);  // comment length
+  PutLe16(&zip, 0);  // disk number
+  PutLe16(&zip, 0);  // internal attributes
+  PutLe32(&zip, 0);  // external attributes
+  PutLe32(&zip, 0);  // local header offset
+  zip.insert(zip.end(), name.begin(), name.end());
+
+  uint32_t dir_size = zip.size() - dir_offset;
+  PutLe32(&zip, ZipArchive::kEOCDSignature);
+  PutLe16(&zip, 0);  // disk number
+  PutLe16(&zip, 0);  // disk with the central directory
+  PutLe16(&zip, 1);  // entries on this disk
+  PutLe16(&zip, 1);  // total entries
+  PutLe32(&zip, dir_size);
+  PutLe32(&zip, dir_offset);
+  PutLe16(&zip, 0);  // comment length
+  ASSERT_EQ(static_cast<ssize_t>(zip.size()),
+            TEMP_FAILURE_RETRY(write(fd, &zip[0], zip.size())));
+}
+
+TEST_F(ZipArchiveTest, MapDirectlyFromFile) {
+  std::vector<uint8_t> data(3 * kPageSize + 5);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = i * 7;
+  }
+  std::string name("classes.dex");
+  // The local header is 30 bytes, so with this name the data is word aligned after 3 bytes of
+  // padding and unaligned without.
+  for (uint16_t padding = 0; padding <= 3; padding += 3) {
+    ScratchFile tmp;
+    WriteStoredZip(tmp.GetFd(), name, data, padding);
+    UniquePtr<ZipArchive> zip_archive(ZipArchive::Open(tmp.GetFilename()));
+    ASSERT_TRUE(zip_archive.get() != NULL);
+    UniquePtr<ZipEntry> zip_entry(zip_archive->Find(name.c_str()));
+    ASSERT_TRUE(zip_entry.get() != NULL);
+
+    UniquePtr<MemMap> extracted(zip_entry->ExtractToMemMap(name.c_str()));
+    ASSERT_TRUE(extracted.get() != NULL);
+    ASSERT_EQ(data.size(), extracted->Size());
+    EXPECT_EQ(0, memcmp(&data[0], extracted->Begin(), data.size()));
+
+    UniquePtr<MemMap> mapped(zip_entry->MapDirectlyFromFile(name.c_str()));
+    if (padding == 0) {
+      EXPECT_TRUE(mapped.get() == NULL);
+      continue;
+    }
+    ASSERT_TRUE(mapped.get() != NULL);
+    ASSERT_EQ(data.size(), mapped->Size());
+    EXPECT_TRUE(IsAligned<4>(mapped->Begin()));
+    EXPECT_EQ(PROT_READ, mapped->GetProtect());
+    EXPECT_EQ(0, memcmp(&data[0], mapped->Begin(), data.size()));
+  }
+}
+
+TEST_F(ZipArchiveTest, MapDirectlyFromFileDeclinesCompressedEntries) {
+  UniquePtr<ZipArchive> zip_archive(ZipArchive::Open(GetLibCoreDexFileName()));
+  ASSERT_TRUE(zip_archive.get() != NULL);
+  UniquePtr<ZipEntry> zip_entry(zip_archive->Find("classes.dex"));
+  ASSERT_TRUE(zip_entry.get() != NULL);
+
+  UniquePtr<MemMap> extracted(zip_entry->ExtractToMemMap("classes.dex"));
+  ASSERT_TRUE(extracted.get() != NULL);
+  ASSERT_EQ(zip_entry->GetUncompressedLength(), extracted->Size());
+  EXPECT_EQ(zip_entry->GetCrc32(), crc32(crc32(0L, Z_NULL, 0), extracted->Begin(),
+                                         extracted->Size()));
+
+  // Whether core.jar is stored or not, a mapping has to match the extracted data.
+  UniquePtr<MemMap> mapped(zip_entry->MapDirectlyFromFile("classes.dex"));
+  if (mapped.get() != NULL) {
+    ASSERT_EQ(extracted->Size(), mapped->Size());
+    EXPECT_EQ(0, memcmp(extracted->Begin(), mapped->Begin(), mapped->Size()));
+  }
+}
+
 }  // namespace art
@@ -23,8 +23,11 @@ include art/build/Android.common.mk
 TEST_DEX_DIRECTORIES := \
 	AbstractMethod \
 	AllFields \
+	CompilationCache \
+	CompilationCache2 \
 	CreateMethodSignature \
 	ExceptionHandle \
+	InterpreterBenchmark \
 	Interfaces \
 	Main \
 	MyClass \
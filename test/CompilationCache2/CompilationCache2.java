@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The classes of CompilationCache, except that Data.wide is static, which moves Data.value, and
+// Sub extends Base2 instead of Base1.
+class CompilationCache {
+    static int readData(Data d) { return d.value; }
+    static int readSub(Sub s) { return s.sub; }
+    static int readSame(Same s) { return s.same; }
+}
+
+class Data {
+    int value;
+    static long wide;
+}
+
+class Base1 {
+    int base1;
+}
+
+class Base2 {
+    long base2;
+}
+
+class Sub extends Base2 {
+    int sub;
+}
+
+class Same {
+    int same;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Loops in the style of the run-tests (003-omnibus-opcodes, 015-switch, 017-float, ...) used to
+// measure the interpreter's dispatch. Each method takes an iteration count and returns a value
+// depending on all of its work.
+class InterpreterBenchmark {
+    static int counter;
+    int field;
+
+    static int intMath(int n) {
+        int x = 0;
+        for (int i = 0; i < n; i++) {
+            x += i * 3;
+            x ^= i >>> 2;
+            x -= i / 7;
+            x |= i & 0x10;
+            x = (x << 1) + (i % 5);
+        }
+        return x;
+    }
+
+    static int longMath(int n) {
+        long x = 1;
+        for (int i = 0; i < n; i++) {
+            x = x * 31 + i;
+            x ^= x >>> 17;
+        }
+        return (int) (x ^ (x >>> 32));
+    }
+
+    static int floatMath(int n) {
+        float f = 1.0f;
+        double d = 0.5;
+        for (int i = 0; i < n; i++) {
+            f = f * 1.0001f + i;
+            d = d / 1.5 + f;
+        }
+        return (int) f + (int) d;
+    }
+
+    static int switches(int n) {
+        int x = 0;
+        for (int i = 0; i < n; i++) {
+            switch (i & 7) {
+                case 0: x += 1; break;
+                case 1: x += 3; break;
+                case 2: x -= 2; break;
+                case 3: x ^= 5; break;
+                default: x++; break;
+            }
+            switch (i) {
+                case -100: x--; break;
+                case 10: x += 10; break;
+                case 1000: x += 1000; break;
+                case 100000: x += 100000; break;
+                default: break;
+            }
+        }
+        return x;
+    }
+
+    static int arrays(int n) {
+        int[] ints = new int[64];
+        char[] chars = new char[64];
+        for (int i = 0; i < n; i++) {
+            int j = i & 63;
+            ints[j] += i;
+            chars[j] = (char) (chars[j] + ints[(j + 1) & 63]);
+        }
+        int x = 0;
+        for (int i = 0; i < ints.length; i++) {
+            x += ints[i] + chars[i];
+        }
+        return x;
+    }
+
+    static int fields(int n) {
+        counter = 0;
+        InterpreterBenchmark b = new InterpreterBenchmark();
+        for (int i = 0; i < n; i++) {
+            b.field += i;
+            counter += b.field & 0xff;
+        }
+        return counter + b.field;
+    }
+
+    static int add(int a, int b) {
+        return a + b;
+    }
+
+    int addField(int a) {
+        return field + a;
+    }
+
+    static int calls(int n) {
+        InterpreterBenchmark b = new InterpreterBenchmark();
+        b.field = 7;
+        int x = 0;
+        for (int i = 0; i < n; i++) {
+            x = add(x, i);
+            x = b.addField(x);
+        }
+        return x;
+    }
+
+    static int exceptions(int n) {
+        Object lock = new Object();
+        int x = 0;
+        for (int i = 0; i < n; i++) {
+            synchronized (lock) {
+                try {
+                    x += 100 / (i & 3);
+                } catch (ArithmeticException e) {
+                    x++;
+                }
+            }
+        }
+        return x;
+    }
+}